@@ -412,6 +412,38 @@ def record_2871():
         return r
 
 
+# -----------------------------------------------------------------------------
+#
+# @context stub - serves a small @context per name, with an ETag
+#
+# GET   /jsonld/<name>  - {"@context": {"P": "urn:ngsi-ld:<name>:P:v<version>"}}, or 304 if If-None-Match matches
+# PATCH /jsonld/<name>  - new version of the context (the ETag changes)
+#
+# The GETs are recorded, so /dump shows the (conditional) requests of the broker
+#
+contexts = {}
+
+
+@app.route('/jsonld/<name>', methods=['GET'])
+def context_get(name):
+    record_request(request)
+
+    version = contexts.setdefault(name, 1)
+    etag = '"' + name + '-v' + str(version) + '"'
+
+    if request.headers.get('If-None-Match') == etag:
+        return Response(status=304, headers={'ETag': etag})
+
+    body = json.dumps({'@context': {'P': 'urn:ngsi-ld:' + name + ':P:v' + str(version)}})
+    return Response(body, status=200, headers={'ETag': etag, 'Content-Type': 'application/ld+json'})
+
+
+@app.route('/jsonld/<name>', methods=['PATCH'])
+def context_new_version(name):
+    contexts[name] = contexts.get(name, 1) + 1
+    return Response(status=204)
+
+
 @app.route('/dump', methods=['GET'])
 def dump():
     return ac
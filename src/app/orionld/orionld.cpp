@@ -106,8 +106,9 @@ extern "C"
 #include "orionld/mongoc/mongocInit.h"                        // mongocInit
 #include "orionld/mongoc/mongocServerVersionGet.h"            // mongocServerVersionGet
 #include "orionld/context/orionldCoreContext.h"               // ORIONLD_CORE_CONTEXT_URL_*
-#include "orionld/context/orionldContextFromUrl.h"            // contextDownloadListInit, contextDownloadListRelease
+#include "orionld/context/orionldContextLoader.h"             // orionldContextLoaderStart, orionldContextLoaderRelease
 #include "orionld/contextCache/orionldContextCacheRelease.h"  // orionldContextCacheRelease
+#include "orionld/contextCache/orionldContextCacheSnapshot.h" // orionldContextCacheSnapshotWrite, orionldContextCacheSnapshotStart
 #include "orionld/service/orionldServiceInit.h"               // orionldServiceInit
 #include "orionld/entityMaps/entityMapsRelease.h"             // entityMapsRelease
 #include "orionld/db/dbInit.h"                                // dbInit
@@ -118,13 +119,16 @@ extern "C"
 #include "orionld/pernot/pernotSubCacheInit.h"                // pernotSubCacheInit
 #include "orionld/pernot/pernotLoop.h"                        // pernotLoopStart
 #include "orionld/pernot/pernotRelease.h"                     // pernotRelease
+#include "orionld/notifications/notificationWorkers.h"        // notificationWorkersStart, notificationWorkersStop
+#include "orionld/mhd/mhdRequestExecutors.h"                  // requestExecutorsStart, requestExecutorsStop
+#include "orionld/notifications/httpConnectionPool.h"         // httpConnectionPoolRelease
+#include "orionld/notifications/notificationRetry.h"          // notificationRetryStart, notificationRetryStop
 
 #include "orionld/version.h"
 #include "orionld/orionRestServices.h"
 #include "orionld/orionldRestServices.h"
 
 #include "orionld/mongoc/mongocServerVersionGet.h"            // mongocServerVersionGet
-#include "orionld/context/orionldContextFromUrl.h"            // contextDownloadListInit, contextDownloadListRelease
 #include "orionld/socketService/socketServiceInit.h"          // socketServiceInit
 #include "orionld/socketService/socketServiceRun.h"           // socketServiceRun
 
@@ -132,6 +136,8 @@ extern "C"
 #include "orionld/troe/pgVersionGet.h"                        // pgVersionGet
 #include "orionld/troe/pgConnectionPoolsFree.h"               // pgConnectionPoolsFree
 #include "orionld/troe/pgConnectionPoolsPresent.h"            // pgConnectionPoolsPresent
+#include "orionld/troe/troeWriter.h"                          // troeWriterStart, troeWriterStop
+#include "orionld/troe/pgPoolMonitor.h"                       // pgPoolMonitorStop
 #include "orionld/distOp/distOpInit.h"                        // distOpInit
 
 #include "orionld/version.h"
@@ -201,9 +207,13 @@ bool            noCache;
 unsigned int    connectionMemory;
 unsigned int    maxConnections;
 unsigned int    reqPoolSize;
+int             reqExecutors;
 
 unsigned long long  inReqPayloadMaxSize;
 unsigned long long  outReqMsgMaxSize;
+int                 chunkedResponseSize;
+int                 compressLevel;
+int                 compressMin;
 
 bool            simulatedNotification;
 bool            statCounters;
@@ -221,6 +231,11 @@ bool            insecureNotif;
 bool            ngsiv1Autocast;
 int             contextDownloadAttempts;
 int             contextDownloadTimeout;
+int             contextExpandMemo;
+int             contextRevalidation;
+char            contextWarmupFile[256];
+char            contextSnapshotFile[256];
+int             contextSnapshotInterval;
 bool            troe;
 bool            pernot;
 bool            disableFileLog;
@@ -230,6 +245,11 @@ unsigned short  troePort;
 char            troeUser[256];
 char            troePwd[256];
 int             troePoolSize;
+int             troeFlushInterval;
+int             troeFlushRows;
+int             troeQueueMem;
+bool            troeCopy;
+int             troePoolIdleTime;
 bool            socketService;
 unsigned short  socketServicePort;
 bool            distributed;
@@ -242,6 +262,16 @@ bool            experimental = false;
 bool            mongocOnly   = false;
 bool            debugCurl    = false;
 uint32_t        cSubCounters;
+int             notifConnMax;
+int             notifConnIdle;
+bool            subCacheIncremental = false;
+int             notifTimeout;
+int             notifRetries;
+int             notifRetryDelay;
+int             notifRetryQueue;
+int             notifRetryMem;
+int             notifRetryThreads;
+char            notifRetrySpill[256];
 char            coreContextVersion[64];
 bool            triggerOperation = false;
 bool            noprom           = false;
@@ -260,6 +290,11 @@ bool            noArrayReduction = false;
 
 #define CTX_TMO_DESC           "Timeout in milliseconds for downloading of contexts"
 #define CTX_ATT_DESC           "Number of attempts for downloading of contexts"
+#define CTX_REVALIDATE_DESC    "interval (in seconds) for revalidation of downloaded contexts, using ETag/Last-Modified (0: no revalidation)"
+#define CTX_WARMUP_DESC        "file with URLs of contexts to be downloaded at startup, one per line"
+#define CTX_SNAPSHOT_DESC      "file for a snapshot of the context cache - written at shutdown, used at startup if the contexts in the database haven't changed"
+#define CTX_SNAPSHOT_INT_DESC  "interval (in seconds) for the periodic writing of the context cache snapshot (0: only at shutdown)"
+#define CTX_MEMO_DESC          "max memory (in kilobytes) per context for memoized @vocab and prefix expansions (0: off)"
 #define FG_DESC                "don't start as daemon"
 #define LOCALIP_DESC           "IP to receive new connections"
 #define PORT_DESC              "port to receive new connections"
@@ -292,8 +327,12 @@ bool            noArrayReduction = false;
 #define CONN_MEMORY_DESC       "maximum memory size per connection (in kilobytes)"
 #define MAX_CONN_DESC          "maximum number of simultaneous connections"
 #define REQ_POOL_SIZE          "size of thread pool for incoming connections"
+#define REQ_EXECUTORS_DESC     "number of request executor threads - the threads of -reqPoolSize then only read requests and send responses (0: no executors)"
 #define IN_REQ_PAYLOAD_MAX_SIZE_DESC   "maximum size (in bytes) of the payload of incoming requests"
 #define OUT_REQ_MSG_MAX_SIZE_DESC      "maximum size (in bytes) of outgoing forward and notification request messages"
+#define CHUNKED_RESPONSE_DESC          "size (in kilobytes) from which array responses are streamed in chunked transfer encoding (0: never)"
+#define COMPRESS_DESC                  "compression level (1-9) of responses to requests that accept gzip or deflate encoding (0: no compression)"
+#define COMPRESS_MIN_DESC              "minimum size (in bytes) of a response or notification payload body to be compressed"
 #define SIMULATED_NOTIF_DESC   "simulate notifications instead of actual sending them (only for testing)"
 #define STAT_COUNTERS          "enable request/notification counters statistics"
 #define STAT_SEM_WAIT          "enable semaphore waiting time statistics"
@@ -318,6 +357,11 @@ bool            noArrayReduction = false;
 #define TROE_HOST_USER         "username for troe database db server"
 #define TROE_HOST_PWD          "password for troe database db server"
 #define TROE_POOL_DESC         "size of the connection pool for TRoE Postgres database connections"
+#define TROE_FLUSH_INTERVAL_DESC  "max milliseconds a TRoE record waits for its group commit (0: no group commit - each request commits its own records)"
+#define TROE_FLUSH_ROWS_DESC   "max number of TRoE SQL commands per group commit"
+#define TROE_QUEUE_MEM_DESC    "max memory (in megabytes) for TRoE records awaiting their group commit - requests wait when full"
+#define TROE_COPY_DESC         "use COPY (FORMAT binary) instead of INSERT for the TRoE records"
+#define TROE_POOL_IDLE_DESC    "seconds a pooled TRoE postgres connection may stay unused before it is closed (0: never)"
 #define SOCKET_SERVICE_DESC    "enable the socket service - accept connections via a normal TCP socket"
 #define SOCKET_SERVICE_PORT_DESC  "port to receive new socket service connections"
 #define DISTRIBUTED_DESC       "turn on distributed operation"
@@ -340,6 +384,16 @@ bool            noArrayReduction = false;
 #define CORE_CONTEXT_DESC      "core context version (v1.0|v1.3|v1.4|v1.5|v1.6|v1.7) - v1.6 is default"
 #define NO_PROM_DESC           "run without Prometheus metrics"
 #define NO_ARR_REDUCT_DESC     "skip JSON-LD Array Reduction"
+#define NOTIF_CONN_MAX_DESC    "max number of keep-alive connections per HTTP notification endpoint (0: no keep-alive)"
+#define NOTIF_CONN_IDLE_DESC   "seconds before an idle keep-alive notification connection is closed"
+#define SUBCACHE_INCR_DESC     "refresh the sub-cache with the subscription changes only (MongoDB change streams) - needs -experimental"
+#define NOTIF_TIMEOUT_DESC     "timeout in milliseconds awaiting the response to a notification"
+#define NOTIF_RETRIES_DESC     "number of retries of a failed HTTP notification (0: no retries)"
+#define NOTIF_RETRY_DELAY_DESC "milliseconds before the first retry of a failed notification (doubled for each failed retry)"
+#define NOTIF_RETRY_QUEUE_DESC "max number of failed notifications kept in memory, per subscription"
+#define NOTIF_RETRY_MEM_DESC   "max memory (in megabytes) for failed notifications"
+#define NOTIF_RETRY_THREADS_DESC "number of threads retrying failed notifications (one retry in flight per subscription)"
+#define NOTIF_RETRY_SPILL_DESC "path to the spill file for failed notifications that don't fit in memory"
 
 
 
@@ -399,9 +453,13 @@ PaArgument paArgs[] =
   { "-connectionMemory",      &connectionMemory,        "CONN_MEMORY",               PaUInt,    PaOpt,  64,              0,      1024,             CONN_MEMORY_DESC         },
   { "-maxConnections",        &maxConnections,          "MAX_CONN",                  PaUInt,    PaOpt,  1020,            1,      PaNL,             MAX_CONN_DESC            },
   { "-reqPoolSize",           &reqPoolSize,             "TRQ_POOL_SIZE",             PaUInt,    PaOpt,  0,               0,      1024,             REQ_POOL_SIZE            },
+  { "-reqExecutors",          &reqExecutors,            "REQ_EXECUTORS",             PaInt,     PaOpt,  0,               0,      64,               REQ_EXECUTORS_DESC       },
 
   { "-inReqPayloadMaxSize",   &inReqPayloadMaxSize,     "IN_REQ_PAYLOAD_MAX_SIZE",   PaULong,   PaOpt,  MB(1),           0,      PaNL,             IN_REQ_PAYLOAD_MAX_SIZE_DESC },
   { "-outReqMsgMaxSize",      &outReqMsgMaxSize,        "OUT_REQ_MSG_MAX_SIZE",      PaULong,   PaOpt,  MB(8),           0,      PaNL,             OUT_REQ_MSG_MAX_SIZE_DESC    },
+  { "-chunkedResponse",       &chunkedResponseSize,     "CHUNKED_RESPONSE",          PaInt,     PaOpt,  1024,            0,      1048576,          CHUNKED_RESPONSE_DESC        },
+  { "-compress",              &compressLevel,           "COMPRESS",                  PaInt,     PaOpt,  0,               0,      9,                COMPRESS_DESC                },
+  { "-compressMin",           &compressMin,             "COMPRESS_MIN",              PaInt,     PaOpt,  1024,            0,      PaNL,             COMPRESS_MIN_DESC            },
   { "-notificationMode",      &notificationMode,        "NOTIF_MODE",                PaString,  PaOpt,  _i "transient",  PaNL,   PaNL,             NOTIFICATION_MODE_DESC   },
   { "-simulatedNotification", &simulatedNotification,   "DROP_NOTIF",                PaBool,    PaOpt,  false,           false,  true,             SIMULATED_NOTIF_DESC     },
   { "-statCounters",          &statCounters,            "STAT_COUNTERS",             PaBool,    PaOpt,  false,           false,  true,             STAT_COUNTERS            },
@@ -419,6 +477,11 @@ PaArgument paArgs[] =
   { "-ngsiv1Autocast",        &ngsiv1Autocast,          "NGSIV1_AUTOCAST",           PaBool,    PaOpt,  false,           false,  true,             NGSIV1_AUTOCAST          },
   { "-ctxTimeout",            &contextDownloadTimeout,  "CONTEXT_DOWNLOAD_TIMEOUT",  PaInt,     PaOpt,  5000,            0,      20000,            CTX_TMO_DESC             },
   { "-ctxAttempts",           &contextDownloadAttempts, "CONTEXT_DOWNLOAD_ATTEMPTS", PaInt,     PaOpt,  3,               0,      100,              CTX_ATT_DESC             },
+  { "-ctxRevalidate",         &contextRevalidation,     "CONTEXT_REVALIDATE",        PaInt,     PaOpt,  0,               0,      86400,            CTX_REVALIDATE_DESC      },
+  { "-ctxWarmup",             contextWarmupFile,        "CONTEXT_WARMUP",            PaString,  PaOpt,  _i "",           PaNL,   PaNL,             CTX_WARMUP_DESC          },
+  { "-ctxSnapshot",           contextSnapshotFile,      "CONTEXT_SNAPSHOT",          PaString,  PaOpt,  _i "",           PaNL,   PaNL,             CTX_SNAPSHOT_DESC        },
+  { "-ctxSnapshotInterval",   &contextSnapshotInterval, "CONTEXT_SNAPSHOT_INTERVAL", PaInt,     PaOpt,  0,               0,      86400,            CTX_SNAPSHOT_INT_DESC    },
+  { "-ctxMemo",               &contextExpandMemo,       "CONTEXT_EXPAND_MEMO",       PaInt,     PaOpt,  0,               0,      65536,            CTX_MEMO_DESC            },
   { "-pernot",                &pernot,                  "PERNOT",                    PaBool,    PaOpt,  false,           false,  true,             PERNOT_DESC              },
   { "-troe",                  &troe,                    "TROE",                      PaBool,    PaOpt,  false,           false,  true,             TROE_DESC                },
   { "-troeHost",              troeHost,                 "TROE_HOST",                 PaString,  PaOpt,  _i "localhost",  PaNL,   PaNL,             TROE_HOST_DESC           },
@@ -426,12 +489,27 @@ PaArgument paArgs[] =
   { "-troeUser",              troeUser,                 "TROE_USER",                 PaString,  PaOpt,  _i "postgres",   PaNL,   PaNL,             TROE_HOST_USER           },
   { "-troePwd",               troePwd,                  "TROE_PWD",                  PaString,  PaOpt,  _i "password",   PaNL,   PaNL,             TROE_HOST_PWD            },
   { "-troePoolSize",          &troePoolSize,            "TROE_POOL_SIZE",            PaInt,     PaOpt,  10,              0,      1000,             TROE_POOL_DESC           },
+  { "-troeFlushInterval",     &troeFlushInterval,       "TROE_FLUSH_INTERVAL",       PaInt,     PaOpt,  0,               0,      60000,            TROE_FLUSH_INTERVAL_DESC },
+  { "-troeFlushRows",         &troeFlushRows,           "TROE_FLUSH_ROWS",           PaInt,     PaOpt,  1000,            1,      100000,           TROE_FLUSH_ROWS_DESC     },
+  { "-troeQueueMem",          &troeQueueMem,            "TROE_QUEUE_MEM",            PaInt,     PaOpt,  64,              1,      65536,            TROE_QUEUE_MEM_DESC      },
+  { "-troeCopy",              &troeCopy,                "TROE_COPY",                 PaBool,    PaOpt,  false,           false,  true,             TROE_COPY_DESC           },
+  { "-troePoolIdleTime",      &troePoolIdleTime,        "TROE_POOL_IDLE_TIME",       PaInt,     PaOpt,  60,              0,      86400,            TROE_POOL_IDLE_DESC      },
   { "-noNotifyFalseUpdate",   &noNotifyFalseUpdate,     "NO_NOTIFY_FALSE_UPDATE",    PaBool,    PaOpt,  false,           false,  true,             NO_NOTIFY_FALSE_UPDATE_DESC  },
   { "-experimental",          &experimental,            "EXPERIMENTAL",              PaBool,    PaOpt,  false,           false,  true,             EXPERIMENTAL_DESC        },
   { "-mongocOnly",            &mongocOnly,              "MONGOCONLY",                PaBool,    PaOpt,  false,           false,  true,             MONGOCONLY_DESC          },
   { "-cSubCounters",          &cSubCounters,            "CSUB_COUNTERS",             PaInt,     PaOpt,  20,              0,      PaNL,             CSUBCOUNTERS_DESC        },
   { "-distributed",           &distributed,             "DISTRIBUTED",               PaBool,    PaOpt,  false,           false,  true,             DISTRIBUTED_DESC         },
   { "-brokerId",              &brokerId,                "BROKER_ID",                 PaStr,     PaOpt,  _i "",           PaNL,   PaNL,             BROKER_ID_DESC           },
+  { "-notifConnMax",          &notifConnMax,            "NOTIF_CONN_MAX",            PaInt,     PaOpt,  0,               0,      1000,             NOTIF_CONN_MAX_DESC      },
+  { "-notifConnIdle",         &notifConnIdle,           "NOTIF_CONN_IDLE",           PaInt,     PaOpt,  30,              1,      3600,             NOTIF_CONN_IDLE_DESC     },
+  { "-subCacheIncremental",   &subCacheIncremental,     "SUBCACHE_INCREMENTAL",      PaBool,    PaOpt,  false,           false,  true,             SUBCACHE_INCR_DESC       },
+  { "-notifTimeout",          &notifTimeout,            "NOTIF_TIMEOUT",             PaInt,     PaOpt,  5000,            1,      600000,           NOTIF_TIMEOUT_DESC       },
+  { "-notifRetries",          &notifRetries,            "NOTIF_RETRIES",             PaInt,     PaOpt,  0,               0,      100,              NOTIF_RETRIES_DESC       },
+  { "-notifRetryDelay",       &notifRetryDelay,         "NOTIF_RETRY_DELAY",         PaInt,     PaOpt,  1000,            1,      60000,            NOTIF_RETRY_DELAY_DESC   },
+  { "-notifRetryQueue",       &notifRetryQueue,         "NOTIF_RETRY_QUEUE",         PaInt,     PaOpt,  100,             1,      100000,           NOTIF_RETRY_QUEUE_DESC   },
+  { "-notifRetryMem",         &notifRetryMem,           "NOTIF_RETRY_MEM",           PaInt,     PaOpt,  64,              1,      65536,            NOTIF_RETRY_MEM_DESC     },
+  { "-notifRetryThreads",     &notifRetryThreads,       "NOTIF_RETRY_THREADS",       PaInt,     PaOpt,  4,               1,      100,              NOTIF_RETRY_THREADS_DESC },
+  { "-notifRetrySpill",       notifRetrySpill,          "NOTIF_RETRY_SPILL",         PaString,  PaOpt,  _i "",           PaNL,   PaNL,             NOTIF_RETRY_SPILL_DESC   },
   { "-wip",                   wip,                      "WIP",                       PaStr,     PaHid,  _i "",           PaNL,   PaNL,             WIP_DESC                 },
   { "-triggerOperation",      &triggerOperation,        "TRIGGER_OPERATION",         PaBool,    PaHid,  false,           false,  true,             TRIGGER_OPERATION_DESC   },
   { "-forwarding",            &distributed,             "FORWARDING",                PaBool,    PaHid,  false,           false,  true,             FORWARDING_DESC          },
@@ -589,8 +667,12 @@ void exitFunc(void)
   // Or, is freeing up the global KAlloc instance sufficient ... ?
   //
 
-  // Free up the context download list, if needed
-  contextDownloadListRelease();
+  // Free up the list of downloaded contexts (for revalidation), if needed
+  orionldContextLoaderRelease();
+
+  // Snapshot of the context cache, for a fast startup (-ctxSnapshot)
+  if (contextSnapshotFile[0] != 0)
+    orionldContextCacheSnapshotWrite(contextSnapshotFile);
 
   //
   // Contexts that have been cloned must be freed
@@ -621,6 +703,10 @@ void exitFunc(void)
   //
   if (troe)
   {
+    // Commit what's left in the queue of the TRoE writer (-troeFlushInterval)
+    troeWriterStop();
+    pgPoolMonitorStop();
+
     pgConnectionPoolsPresent();
     pgConnectionPoolsFree();
   }
@@ -633,6 +719,18 @@ void exitFunc(void)
   if (pernot == true)
     pernotRelease();
 
+  // Stop the request executors (-reqExecutors)
+  requestExecutorsStop();
+
+  // Stop the notification workers (-notificationMode threadpool)
+  notificationWorkersStop();
+
+  // Stop the retries of failed notifications - whatever is left is spilled (-notifRetries, -notifRetrySpill)
+  notificationRetryStop();
+
+  // Close all kept-alive notification connections (-notifConnMax)
+  httpConnectionPoolRelease();
+
   kaBufferReset(&kalloc, KFALSE);
 }
 
@@ -1176,11 +1274,11 @@ int main(int argC, char* argV[])
       LM_X(1, ("Database Error (unable to initialize the layer for Temporal Representation of Entities)"));
   }
 
-
   //
-  // Initialize the 'context download list' - to avoid multiple downloads of the same contexts
+  // Group commit of the TRoE records (-troeFlushInterval)
   //
-  contextDownloadListInit();
+  if (troeWriterStart() == false)
+    LM_X(1, ("Unable to start the TRoE writer"));
 
 
   //
@@ -1286,9 +1384,49 @@ int main(int argC, char* argV[])
   //
   contextBrokerInit(dbName, multitenancy);
 
+  //
+  // NGSI-LD notifications use their own queue and workers, same queue size and number of threads as NGSIv2 (-notificationMode threadpool:q:n)
+  // Created before curl_global_init() for the same reason as the NGSIv2 ones
+  //
+  if (strcmp(notificationMode, "threadpool") == 0)
+  {
+    if (notificationWorkersStart(notificationQueueSize, notificationThreadNum) == false)
+      LM_X(1, ("Unable to start the notification workers"));
+  }
+
+  //
+  // Retries of failed notifications (-notifRetries)
+  //
+  if (notificationRetryStart() == false)
+    LM_X(1, ("Unable to start the retries of failed notifications"));
+
+  //
+  // Context loader - downloads of @contexts, warm-up (-ctxWarmup) and revalidation (-ctxRevalidate)
+  //
+  if (orionldContextLoaderStart() == false)
+    LM_X(1, ("Unable to start the context loader"));
+
+  //
+  // Periodic snapshot of the context cache (-ctxSnapshotInterval)
+  //
+  if (orionldContextCacheSnapshotStart() == false)
+    LM_X(1, ("Unable to start the context cache snapshot thread"));
+
   if (distributed)
     distOpInit();
 
+  //
+  // Request executors (-reqExecutors) - the threads of the pool of MHD (-reqPoolSize) are then I/O threads only
+  //
+  if (reqExecutors > 0)
+  {
+    if (reqPoolSize == 0)
+      LM_X(1, ("Fatal Error (-reqExecutors needs -reqPoolSize, the number of I/O threads)"));
+
+    if (requestExecutorsStart(reqExecutors) == false)
+      LM_X(1, ("Unable to start the request executors"));
+  }
+
   if (https)
   {
     char* httpsPrivateServerKey = loadFile(httpsKeyFile);
@@ -1364,6 +1502,8 @@ int main(int argC, char* argV[])
   LM_K(("  Health Check:              %s", (socketService      == true)? "Enabled" : "Disabled"));
   LM_K(("  Entity Maps:               %s", (entityMapsEnabled  == true)? "Enabled" : "Disabled"));
   LM_K(("  Distributed Subscriptions: %s", (distSubsEnabled    == true)? "Enabled" : "Disabled"));
+  LM_K(("  Notification Workers:      %d", notificationWorkers));
+  LM_K(("  Notification Keep-Alive:   %d connections per endpoint", notifConnMax));
 
   if (troe)
     LM_K(("  Postgres Server Version:   %s", postgresServerVersion));
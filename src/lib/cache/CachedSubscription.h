@@ -26,6 +26,7 @@
 * Author: Ken Zangelin
 */
 #include <regex.h>
+#include <string.h>
 #include <string>
 #include <vector>
 
@@ -34,6 +35,8 @@
 #include "apiTypesV2/SubscriptionExpression.h"
 
 #include "orionld/types/QNode.h"                             // QNode
+#include "orionld/types/QCompiled.h"                         // QCompiled
+#include "orionld/types/GeoCompiled.h"                       // GeoCompiled
 #include "orionld/types/Protocol.h"                          // Protocol
 #include "orionld/types/OrionldAlteration.h"                 // OrionldAlterationTypes
 #include "orionld/types/OrionldTenant.h"                     // OrionldTenant
@@ -42,6 +45,14 @@
 
 
 
+// -----------------------------------------------------------------------------
+//
+// SubCacheIndexNode - opaque, defined in subCacheIndex.cpp
+//
+struct SubCacheIndexNode;
+
+
+
 /* ****************************************************************************
 *
 * EntityInfo -
@@ -76,6 +87,40 @@ struct EntityInfo
 
 
 
+// -----------------------------------------------------------------------------
+//
+// subCacheStatusIntern - the one and only (never freed) copy of a subscription status string
+//
+extern const char* subCacheStatusIntern(const char* status);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// CachedSubscriptionStatus - the status of a cached subscription ("active", "paused", "expired", ...)
+//
+// Cached subscriptions are read without the cache semaphore (alteration matching), while their status may change
+// (a failing notification pauses the subscription, rendering it may find it expired).
+// The status is a pointer to an interned string, loaded and stored atomically - a reader never sees a half-written string.
+//
+class CachedSubscriptionStatus
+{
+ public:
+  CachedSubscriptionStatus() : statusP("") {}
+
+  const char*                c_str(void) const                          { return __atomic_load_n(&statusP, __ATOMIC_ACQUIRE);                                  }
+  CachedSubscriptionStatus&  operator=(const char* status)              { __atomic_store_n(&statusP, subCacheStatusIntern(status), __ATOMIC_RELEASE); return *this; }
+  CachedSubscriptionStatus&  operator=(const std::string& status)       { return operator=(status.c_str());                                                    }
+  bool                       operator==(const char* status) const       { return strcmp(c_str(), status) == 0;                                                 }
+  bool                       operator==(const std::string& status) const { return strcmp(c_str(), status.c_str()) == 0;                                        }
+  bool                       operator!=(const char* status) const       { return strcmp(c_str(), status) != 0;                                                 }
+
+ private:
+  const char*  statusP;
+};
+
+
+
 /* ****************************************************************************
 *
 * CachedSubscription -
@@ -111,13 +156,15 @@ struct CachedSubscription
   bool                        blacklist;
   ngsiv2::HttpInfo            httpInfo;
   QNode*                      qP;
+  QCompiled*                  qcP;    // The compiled form of qP - used for notification matching
   char*                       qText;  // Note that NGSIv2/mongoBackend q/mq are inside SubscriptionExpression
   KjNode*                     geoCoordinatesP;
+  GeoCompiled*                geoCompiledP;  // The compiled geoQ - used for notification matching
   bool                        showChanges;
   bool                        sysAttrs;
 
   bool                        isActive;
-  std::string                 status;
+  CachedSubscriptionStatus    status;
   int64_t                     count;                 // delta count - since last sub cache refresh
   int64_t                     dbCount;               // count taken from the database
   int64_t                     failures;
@@ -136,7 +183,10 @@ struct CachedSubscription
   SubordinateSubscription*    subordinateP;          // Linked list of subordinate subscriptions
 
   struct CachedSubscription*  next;
+  struct CachedSubscription*  replacedBy;            // The new version, once replaced (subCacheItemReplace) - late counters are moved to it
   bool                        inDB;                  // Used by mongocSubCachePopulateByTenant to find subs that have been removed
+  int64_t                     cacheSeq;              // Position in the sub-cache list (insertion order)
+  std::vector<SubCacheIndexNode*> indexNodes;        // Nodes of the sub-cache index where the subscription is found (subCacheIndex.cpp)
 };
 
 #endif  // SRC_LIB_CACHE_CACHEDSUBSCRIPTION_H_
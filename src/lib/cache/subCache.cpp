@@ -25,6 +25,8 @@
 #include <sys/types.h>
 #include <regex.h>
 #include <string.h>
+#include <stdlib.h>                                          // realloc, free
+#include <pthread.h>                                         // pthread_mutex_t
 
 #include <string>
 #include <vector>
@@ -56,10 +58,15 @@ extern "C"
 #include "orionld/common/urlParse.h"                        // urlParse
 #include "orionld/q/qBuild.h"                               // qBuild
 #include "orionld/q/qRelease.h"                             // qRelease
+#include "orionld/q/qCompiledRelease.h"                     // qCompiledRelease
+#include "orionld/geo/geoCompiledRelease.h"                 // geoCompiledRelease
 #include "orionld/mongoc/mongocSubCachePopulateByTenant.h"  // mongocSubCachePopulateByTenant
+#include "orionld/mongoc/mongocSubCacheSyncByTenant.h"      // mongocSubCacheSyncByTenant
 #include "orionld/mongoc/mongocSubCountersUpdate.h"         // mongocSubCountersUpdate
 #include "orionld/context/orionldContextFromUrl.h"          // orionldContextFromUrl
 
+#include "cache/subCacheIndex.h"                          // subCacheIndexInsert, subCacheIndexRemove, subCacheIndexReset, subCacheIndexLookup
+#include "epoch/epoch.h"                                    // epochRetire, epochReclaim, epochEnter, ...
 #include "cache/subCache.h"
 
 using std::map;
@@ -251,6 +258,7 @@ typedef struct SubCache
 * subCache -
 */
 static SubCache  subCache            = { NULL, NULL, 0, 0, 0, 0 };
+static int64_t   subCacheSeq         = 0;  // Insertion counter - gives the order of the items in the list
 bool             subCacheActive      = false;
 bool             subCacheMultitenant = false;
 
@@ -575,6 +583,9 @@ int subCacheMatch
 //
 void subCacheItemStrip(CachedSubscription* cSubP)
 {
+  // The index keys are taken from entityIdInfos and tenant - the subscription must leave the index before they're freed
+  subCacheIndexRemove(cSubP);
+
   if (cSubP->subscriptionId != NULL)
   {
     free(cSubP->subscriptionId);
@@ -651,12 +662,24 @@ void subCacheItemStrip(CachedSubscription* cSubP)
     cSubP->qP = NULL;
   }
 
+  if (cSubP->qcP != NULL)
+  {
+    qCompiledRelease(cSubP->qcP);
+    cSubP->qcP = NULL;
+  }
+
   if (cSubP->geoCoordinatesP != NULL)
   {
     kjFree(cSubP->geoCoordinatesP);
     cSubP->geoCoordinatesP = NULL;
   }
 
+  if (cSubP->geoCompiledP != NULL)
+  {
+    geoCompiledRelease(cSubP->geoCompiledP);
+    cSubP->geoCompiledP = NULL;
+  }
+
   for (int ix = 0; ix < (int) cSubP->httpInfo.notifierInfo.size(); ++ix)
   {
     if (cSubP->httpInfo.notifierInfo[ix] != NULL)
@@ -701,31 +724,138 @@ void subCacheItemDestroy(CachedSubscription* cSubP)
 
 
 
+// -----------------------------------------------------------------------------
+//
+// subCacheItemRelease - free a retired cached subscription (called by the epoch module)
+//
+static void subCacheItemRelease(void* vP)
+{
+  CachedSubscription* cSubP = (CachedSubscription*) vP;
+
+  subCacheItemDestroy(cSubP);
+  delete cSubP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// countersMove - move the notification counters of a cached subscription to another one (its new version)
+//
+static void countersMove(CachedSubscription* fromP, CachedSubscription* toP)
+{
+  __atomic_fetch_add(&toP->count,             __atomic_exchange_n(&fromP->count,             0, __ATOMIC_ACQ_REL), __ATOMIC_RELAXED);
+  __atomic_fetch_add(&toP->failures,          __atomic_exchange_n(&fromP->failures,          0, __ATOMIC_ACQ_REL), __ATOMIC_RELAXED);
+  __atomic_fetch_add(&toP->dirty,             __atomic_exchange_n(&fromP->dirty,             0, __ATOMIC_ACQ_REL), __ATOMIC_RELAXED);
+  __atomic_fetch_add(&toP->consecutiveErrors, __atomic_exchange_n(&fromP->consecutiveErrors, 0, __ATOMIC_ACQ_REL), __ATOMIC_RELAXED);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheItemReplacedRelease - free a retired, replaced, cached subscription
+//
+// Notification threads that picked up the old version before the replacement may have kept counting on it.
+// Now that no reader holds it anymore, its final counters are moved to the new version.
+// The new version was retired after the old one (if at all), so it is still alive - items are freed in retirement order.
+//
+static void subCacheItemReplacedRelease(void* vP)
+{
+  CachedSubscription* cSubP = (CachedSubscription*) vP;
+
+  countersMove(cSubP, cSubP->replacedBy);
+  subCacheItemRelease(vP);
+}
+
+
+
 /* ****************************************************************************
 *
 * subCacheDestroy -
+*
+* Alteration matching reads the sub-cache without the cache semaphore, so the cached subscriptions
+* can't be freed right away. The list and the index are emptied first (no new reader can reach the items),
+* and then each item is retired - freed once all current readers have finished.
 */
 void subCacheDestroy(void)
 {
-  CachedSubscription* cSubP  = subCache.head;
+  CachedSubscription* cSubP = subCache.head;
 
-  if (subCache.head == NULL)
+  if (cSubP == NULL)
     return;
 
-  while (cSubP->next)
+  __atomic_store_n(&subCache.head, (CachedSubscription*) NULL, __ATOMIC_RELEASE);
+  subCache.tail = NULL;
+
+  subCacheIndexReset();
+
+  while (cSubP != NULL)
   {
-    CachedSubscription* prev = cSubP;
+    CachedSubscription* next = cSubP->next;  // 'next' is left untouched - a reader standing on the item can continue its walk
 
-    cSubP = cSubP->next;
-    subCacheItemDestroy(prev);
-    delete prev;
+    epochRetire(cSubP, subCacheItemRelease);
+    cSubP = next;
   }
 
-  subCacheItemDestroy(cSubP);
-  delete cSubP;
+  epochReclaim();
+}
+
+
 
-  subCache.head  = NULL;
-  subCache.tail  = NULL;
+// -----------------------------------------------------------------------------
+//
+// subCacheStatusIntern -
+//
+// The well-known statuses are string literals, anything else (found in the database) is copied once and kept
+// for the lifetime of the broker - there are only a handful of different statuses.
+//
+const char* subCacheStatusIntern(const char* status)
+{
+  static const char*      knownV[]        = { "", "active", "paused", "expired", "inactive", "failed", "oneshot" };
+  static pthread_mutex_t  internMutex     = PTHREAD_MUTEX_INITIALIZER;
+  static const char**     internedV       = NULL;
+  static int              interned        = 0;
+
+  if (status == NULL)
+    return "";
+
+  for (unsigned int ix = 0; ix < sizeof(knownV) / sizeof(knownV[0]); ++ix)
+  {
+    if (strcmp(status, knownV[ix]) == 0)
+      return knownV[ix];
+  }
+
+  pthread_mutex_lock(&internMutex);
+
+  for (int ix = 0; ix < interned; ++ix)
+  {
+    if (strcmp(status, internedV[ix]) == 0)
+    {
+      pthread_mutex_unlock(&internMutex);
+      return internedV[ix];
+    }
+  }
+
+  const char** newV = (const char**) realloc(internedV, (interned + 1) * sizeof(char*));
+  char*        copy = strdup(status);
+
+  if ((newV == NULL) || (copy == NULL))
+  {
+    pthread_mutex_unlock(&internMutex);
+    free(copy);
+    if (newV != NULL)
+      internedV = newV;
+    LM_E(("Out of memory (interning the subscription status '%s')", status));
+    return "";
+  }
+
+  internedV             = newV;
+  internedV[interned++] = copy;
+
+  pthread_mutex_unlock(&internMutex);
+
+  return copy;
 }
 
 
@@ -751,27 +881,12 @@ bool tenantMatch(const char* tenant1, const char* tenant2)
 *
 * subCacheItemLookup -
 *
-* FIXME P7: lookups would be A LOT faster if the subCache used a hash-table instead of
-*           just a single linked link for the subscriptions.
-*           The hash could be adding each char in 'tenant' and 'subscriptionId' to a 8-bit
-*           integer and then we'd have a vector of 256 linked lists.
-*
-*           However, for matching against chang3ed entities, which is 99% of the usage of the cache,
-*           nothing would be gained so ... let's not do this.
+* Every cached subscription is in the sub-cache index also by tenant + subscription id, so, this is a hash
+* lookup and not a walk of the list - it's done for every notification that is sent (the accounting of its result).
 */
 CachedSubscription* subCacheItemLookup(const char* tenant, const char* subscriptionId)
 {
-  CachedSubscription* cSubP = subCache.head;
-
-  while (cSubP != NULL)
-  {
-    if ((tenantMatch(tenant, cSubP->tenant)) && (strcmp(subscriptionId, cSubP->subscriptionId) == 0))
-      return cSubP;
-
-    cSubP = cSubP->next;
-  }
-
-  return NULL;
+  return subCacheIndexLookup(tenant, subscriptionId);
 }
 
 
@@ -822,6 +937,12 @@ void subCacheItemInsert(CachedSubscription* cSubP)
     cSubP->triggers[ix] = true;
   }
 
+  //
+  // Index Insertion Part - the index replaces the linear scan of the list when matching alterations
+  //
+  cSubP->cacheSeq = ++subCacheSeq;
+  subCacheIndexInsert(cSubP);
+
   //
   // List Insertion Part
   //
@@ -830,15 +951,16 @@ void subCacheItemInsert(CachedSubscription* cSubP)
   ++subCache.noOfInserts;
 
   // First insertion?
+  // Readers walk the list without the cache semaphore - the item must be complete before it is linked in (release store)
   if ((subCache.head == NULL) && (subCache.tail == NULL))
   {
-    subCache.head   = cSubP;
+    __atomic_store_n(&subCache.head, cSubP, __ATOMIC_RELEASE);
     subCache.tail   = cSubP;
 
     return;
   }
 
-  subCache.tail->next  = cSubP;
+  __atomic_store_n(&subCache.tail->next, cSubP, __ATOMIC_RELEASE);
   subCache.tail        = cSubP;
 }
 
@@ -966,6 +1088,9 @@ bool subCacheItemInsert
   //
   cSubP->qText      = NULL;
   cSubP->qP         = NULL;
+  cSubP->qcP        = NULL;  // Compiled from qP, on demand (subCacheAlterationMatch)
+
+  cSubP->geoCompiledP = NULL;  // Compiled from 'expression', on demand (subCacheAlterationMatch)
 
   bool validForV2 = true;
   bool isMq       = false;
@@ -1189,7 +1314,7 @@ int subCacheItemRemove(CachedSubscription* cSubP)
       // Removing first item ?
       if (cSubP == subCache.head)
       {
-        subCache.head = cSubP->next;
+        __atomic_store_n(&subCache.head, cSubP->next, __ATOMIC_RELEASE);
       }
 
       // Removing last item?
@@ -1201,13 +1326,19 @@ int subCacheItemRemove(CachedSubscription* cSubP)
       // Removing middle item?
       if (prev != NULL)
       {
-        prev->next = cSubP->next;
+        __atomic_store_n(&prev->next, cSubP->next, __ATOMIC_RELEASE);
       }
 
       ++subCache.noOfRemoves;
 
-      subCacheItemDestroy(cSubP);
-      delete cSubP;
+      //
+      // The item may still be in use by alteration matching (or by notifications that are being sent)
+      // Its 'next' pointer is left untouched, so that a reader standing on it can continue its walk.
+      // It is freed once all current readers have finished.
+      //
+      subCacheIndexRemove(cSubP);
+      epochRetire(cSubP, subCacheItemRelease);
+      epochReclaim();
 
       return 0;
     }
@@ -1221,6 +1352,73 @@ int subCacheItemRemove(CachedSubscription* cSubP)
 }
 
 
+
+// -----------------------------------------------------------------------------
+//
+// subCacheItemReplace - put a new version of a cached subscription in the place of the old one
+//
+// The new version must be complete and not yet in the sub-cache.
+// It takes over the position of the old version (list and cacheSeq) and, once published, the notification counters
+// that haven't been flushed to the database yet.
+// The old version is retired - freed once no reader holds it anymore.
+//
+int subCacheItemReplace(CachedSubscription* oldP, CachedSubscription* newP)
+{
+  CachedSubscription* current = subCache.head;
+  CachedSubscription* prev    = NULL;
+
+  while ((current != NULL) && (current != oldP))
+  {
+    prev    = current;
+    current = current->next;
+  }
+
+  if (current == NULL)
+    LM_RE(-1, ("Runtime Error (item to replace in sub-cache not found)"));
+
+  int triggerArraySize = sizeof(newP->triggers) / sizeof(newP->triggers[0]);
+  for (int ix = 0; ix < triggerArraySize; ++ix)
+  {
+    newP->triggers[ix] = true;
+  }
+
+  newP->cacheSeq          = oldP->cacheSeq;
+  newP->inDB              = __atomic_load_n(&oldP->inDB, __ATOMIC_RELAXED);
+  newP->count             = 0;  // The counters of the old version are moved over once the new version is published
+  newP->failures          = 0;
+  newP->dirty             = 0;
+  newP->consecutiveErrors = 0;
+  strncpy(newP->lastErrorReason, oldP->lastErrorReason, sizeof(newP->lastErrorReason) - 1);
+
+  newP->next = oldP->next;
+
+  subCacheIndexInsert(newP);
+
+  if (prev == NULL)
+    __atomic_store_n(&subCache.head, newP, __ATOMIC_RELEASE);
+  else
+    __atomic_store_n(&prev->next, newP, __ATOMIC_RELEASE);
+
+  if (subCache.tail == oldP)
+    subCache.tail = newP;
+
+  subCacheIndexRemove(oldP);
+
+  //
+  // Only now that the new version is published, the counters are moved over.
+  // Notification threads already holding the old version may still count on it - what they add after this
+  // point is moved when the old version is released (subCacheItemReplacedRelease)
+  //
+  oldP->replacedBy = newP;
+  countersMove(oldP, newP);
+
+  epochRetire(oldP, subCacheItemReplacedRelease);
+  epochReclaim();
+
+  return 0;
+}
+
+
 #if 0
 // -----------------------------------------------------------------------------
 //
@@ -1262,8 +1460,13 @@ void subCacheRefresh(bool refresh)
 
   LM_T(LmtSubCache, ("Refreshing sub-cache"));
 
+  // Only the subscription changes since the last refresh are applied (experimental only)
+  bool incremental = (experimental == true) && (subCacheIncremental == true) && (refresh == true);
+
   // Recreate the subCache for the default tenant
-  if (experimental)
+  if (incremental)
+    mongocSubCacheSyncByTenant(&tenant0);
+  else if (experimental)
     mongocSubCachePopulateByTenant(&tenant0, refresh);
   else
   {
@@ -1276,7 +1479,9 @@ void subCacheRefresh(bool refresh)
   OrionldTenant* tenantP = tenantList;
   while (tenantP != NULL)
   {
-    if (experimental)
+    if (incremental)
+      mongocSubCacheSyncByTenant(tenantP);
+    else if (experimental)
       mongocSubCachePopulateByTenant(tenantP, refresh);
     else
       mongoSubCacheRefresh(tenantP->mongoDbName);
@@ -1341,6 +1546,12 @@ void subCacheSync(void)
   cacheSemTake(__FUNCTION__, "Synchronizing subscription cache");
   subCacheState = ScsSynchronizing;
 
+  //
+  // NGSI-LD subscriptions are removed without taking the cache semaphore - the removed items must stay
+  // alive until the walks over the list are finished
+  //
+  epochEnter();
+
 
   //
   // 1. Save subscriptionId, lastNotificationTime, count, lastFailure, and lastSuccess for all items in cache
@@ -1362,8 +1573,8 @@ void subCacheSync(void)
     CachedSubSaved* cssP       = new CachedSubSaved();
 
     cssP->lastNotificationTime = cSubP->lastNotificationTime;
-    cssP->count                = cSubP->count;       // This count is later pushed ($inc) to DB - needs to go to cache as well
-    cssP->failures             = cSubP->failures;
+    cssP->count                = __atomic_load_n(&cSubP->count, __ATOMIC_RELAXED);  // This count is later pushed ($inc) to DB - needs to go to cache as well
+    cssP->failures             = __atomic_load_n(&cSubP->failures, __ATOMIC_RELAXED);
     cssP->lastFailure          = cSubP->lastFailure;
     cssP->lastSuccess          = cSubP->lastSuccess;
     cssP->ngsild               = (cSubP->ldContext != "")? true : false;
@@ -1455,10 +1666,11 @@ void subCacheSync(void)
       if (cssP->lastNotificationTime != 0) cSubP->lastNotificationTime  = cssP->lastNotificationTime;
 
       // Here the delta (just $inc'ed to DB) is also inc'ed to subCache
-      cSubP->dbCount    += cssP->count;
-      cSubP->count       = 0;
-      cSubP->dbFailures += cssP->failures;
-      cSubP->failures    = 0;
+      // Notifications are accounted without the cache semaphore - what has been counted since step 1 is kept
+      __atomic_fetch_add(&cSubP->dbCount,    cssP->count,    __ATOMIC_RELAXED);
+      __atomic_fetch_add(&cSubP->dbFailures, cssP->failures, __ATOMIC_RELAXED);
+      __atomic_fetch_sub(&cSubP->count,    cssP->count,    __ATOMIC_RELAXED);
+      __atomic_fetch_sub(&cSubP->failures, cssP->failures, __ATOMIC_RELAXED);
     }
 
     cSubP = cSubP->next;
@@ -1475,6 +1687,8 @@ void subCacheSync(void)
   savedSubV.clear();
 
 
+  epochLeave();
+
   subCacheState = ScsIdle;
   cacheSemGive(__FUNCTION__, "Synchronizing subscription cache");
 }
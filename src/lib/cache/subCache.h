@@ -195,6 +195,14 @@ extern int subCacheItemRemove(CachedSubscription* cSubP);
 
 
 
+// -----------------------------------------------------------------------------
+//
+// subCacheItemReplace - replace a cached subscription with a new version of it (copy-on-write update)
+//
+extern int subCacheItemReplace(CachedSubscription* oldP, CachedSubscription* newP);
+
+
+
 /* ****************************************************************************
 *
 * subCacheRefresh -
@@ -0,0 +1,411 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                          // strcmp
+#include <pthread.h>                                         // pthread_mutex_t
+#include <string>                                            // std::string
+#include <vector>                                            // std::vector
+#include <algorithm>                                         // std::sort, std::unique
+#include <functional>                                        // std::hash
+
+#include "logMsg/logMsg.h"                                   // LM_*
+
+#include "cache/CachedSubscription.h"                        // CachedSubscription, EntityInfo
+#include "epoch/epoch.h"                                     // epochRetire, epochReclaim
+#include "orionld/common/orionldState.h"                     // multitenancy
+#include "cache/subCacheIndex.h"                             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SubCacheIndexNode - one (key, subscription) pair of the hash table
+//
+// Each slot of the hash table is a doubly linked list of nodes. Readers follow 'next' only, without any lock,
+// while 'prev' is for the writers (serialized by the index mutex), to unlink a node in O(1).
+// A new node is published at the head of its slot. An unlinked node keeps its 'next' pointer, so that a reader
+// standing on it can continue its walk, and it's freed once no reader can see it anymore (epochRetire).
+//
+struct SubCacheIndexNode
+{
+  std::string          key;
+  CachedSubscription*  subP;
+  SubCacheIndexNode*   next;
+  SubCacheIndexNode*   prev;
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Index key prefixes - one per family of buckets, plus the subscription id (for subCacheIndexLookup)
+//
+#define SCI_ID            'I'
+#define SCI_TYPE          'T'
+#define SCI_WILDCARD      'W'
+#define SCI_SUBSCRIPTION  'S'
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SCI_SLOTS - number of slots in the hash table (must be a power of two)
+//
+#define SCI_SLOTS  4096
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndex - all three families share the same hash table, the key prefix tells them apart
+//
+// Writers are serialized by the index mutex, as not all sub-cache insertions/removals are done with the cache
+// semaphore taken. When both are needed, the cache semaphore is taken first.
+// Readers take no lock at all, but must be inside a sub-cache read section (epochEnter).
+//
+static SubCacheIndexNode*  subCacheIndex[SCI_SLOTS];
+static pthread_mutex_t     subCacheIndexMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// indexKey -
+//
+// If the broker doesn't run in multitenancy mode, the tenant isn't part of the key
+//
+static std::string indexKey(char family, const char* tenant, const char* value)
+{
+  std::string key(1, family);
+
+  if ((multitenancy == true) && (tenant != NULL))
+    key += tenant;
+
+  key += '\n';  // Can't be part of a tenant name
+
+  if (value != NULL)
+    key += value;
+
+  return key;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subscriptionKey -
+//
+// Unlike indexKey, the tenant is always part of the key - subCacheItemLookup has always compared tenants
+//
+static std::string subscriptionKey(const char* tenant, const char* subscriptionId)
+{
+  std::string key(1, SCI_SUBSCRIPTION);
+
+  if (tenant != NULL)
+    key += tenant;
+
+  key += '\n';
+  key += subscriptionId;
+
+  return key;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// slotIndex -
+//
+static inline unsigned int slotIndex(const std::string& key)
+{
+  return std::hash<std::string>()(key) & (SCI_SLOTS - 1);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nodeRelease - called by the epoch module once no reader can see the node anymore
+//
+static void nodeRelease(void* vP)
+{
+  delete (SubCacheIndexNode*) vP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// bucketAdd -
+//
+// O(1) - a subscription is added to the head of the slot, no matter how many subscriptions share its key
+//
+static void bucketAdd(CachedSubscription* cSubP, const std::string& key)
+{
+  // Several entity selectors with the same id/type - the subscription is added only once per bucket
+  for (unsigned int ix = 0; ix < cSubP->indexNodes.size(); ++ix)
+  {
+    if (cSubP->indexNodes[ix]->key == key)
+      return;
+  }
+
+  unsigned int        slot  = slotIndex(key);
+  SubCacheIndexNode*  nodeP = new SubCacheIndexNode();
+  SubCacheIndexNode*  headP = subCacheIndex[slot];
+
+  nodeP->key  = key;
+  nodeP->subP = cSubP;
+  nodeP->next = headP;
+  nodeP->prev = NULL;
+
+  if (headP != NULL)
+    headP->prev = nodeP;
+
+  __atomic_store_n(&subCacheIndex[slot], nodeP, __ATOMIC_RELEASE);  // The node is complete before readers can reach it
+
+  cSubP->indexNodes.push_back(nodeP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nodeUnlink - unlink a node from its slot and retire it
+//
+static void nodeUnlink(SubCacheIndexNode* nodeP)
+{
+  if (nodeP->prev != NULL)
+    __atomic_store_n(&nodeP->prev->next, nodeP->next, __ATOMIC_RELEASE);
+  else
+    __atomic_store_n(&subCacheIndex[slotIndex(nodeP->key)], nodeP->next, __ATOMIC_RELEASE);
+
+  if (nodeP->next != NULL)
+    nodeP->next->prev = nodeP->prev;
+
+  epochRetire(nodeP, nodeRelease);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexInsert -
+//
+void subCacheIndexInsert(CachedSubscription* cSubP)
+{
+  int   eItems      = cSubP->entityIdInfos.size();
+  bool  allExactIds = (eItems > 0);
+  bool  allTypes    = (eItems > 0);
+
+  for (int ix = 0; ix < eItems; ++ix)
+  {
+    EntityInfo* eiP   = cSubP->entityIdInfos[ix];
+    const char* eType = eiP->entityType.c_str();
+
+    if ((eiP->isPattern == true) || (eiP->entityId == ""))
+      allExactIds = false;
+
+    if ((eType[0] == '*') && (eType[1] == 0))
+      allTypes = false;
+  }
+
+  pthread_mutex_lock(&subCacheIndexMutex);
+
+  if (cSubP->indexNodes.size() != 0)
+    LM_E(("Internal Error (subscription '%s' is already in the sub-cache index)", cSubP->subscriptionId));
+  else
+  {
+    if (allExactIds == true)
+    {
+      for (int ix = 0; ix < eItems; ++ix)
+        bucketAdd(cSubP, indexKey(SCI_ID, cSubP->tenant, cSubP->entityIdInfos[ix]->entityId.c_str()));
+    }
+    else if (allTypes == true)
+    {
+      for (int ix = 0; ix < eItems; ++ix)
+        bucketAdd(cSubP, indexKey(SCI_TYPE, cSubP->tenant, cSubP->entityIdInfos[ix]->entityType.c_str()));
+    }
+    else
+      bucketAdd(cSubP, indexKey(SCI_WILDCARD, cSubP->tenant, NULL));
+
+    if (cSubP->subscriptionId != NULL)
+      bucketAdd(cSubP, subscriptionKey(cSubP->tenant, cSubP->subscriptionId));
+  }
+
+  pthread_mutex_unlock(&subCacheIndexMutex);
+
+  epochReclaim();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexRemove -
+//
+void subCacheIndexRemove(CachedSubscription* cSubP)
+{
+  if (cSubP->indexNodes.size() == 0)  // Not in the index (e.g. stripped twice, or the index has been reset)
+    return;
+
+  pthread_mutex_lock(&subCacheIndexMutex);
+
+  for (unsigned int ix = 0; ix < cSubP->indexNodes.size(); ++ix)
+    nodeUnlink(cSubP->indexNodes[ix]);
+
+  cSubP->indexNodes.clear();
+
+  pthread_mutex_unlock(&subCacheIndexMutex);
+
+  epochReclaim();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// bucketCopy -
+//
+static void bucketCopy(const std::string& key, std::vector<CachedSubscription*>* candidatesP)
+{
+  SubCacheIndexNode* nodeP = __atomic_load_n(&subCacheIndex[slotIndex(key)], __ATOMIC_ACQUIRE);
+
+  while (nodeP != NULL)
+  {
+    if (nodeP->key == key)
+      candidatesP->push_back(nodeP->subP);
+
+    nodeP = __atomic_load_n(&nodeP->next, __ATOMIC_ACQUIRE);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// cacheOrder -
+//
+static bool cacheOrder(CachedSubscription* sub1P, CachedSubscription* sub2P)
+{
+  return sub1P->cacheSeq < sub2P->cacheSeq;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// sameSubscription -
+//
+static bool sameSubscription(CachedSubscription* sub1P, CachedSubscription* sub2P)
+{
+  return sub1P->cacheSeq == sub2P->cacheSeq;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexCandidates -
+//
+// A subscription is in one family only and an entity has one single id and type, so,
+// no subscription can appear more than once among the candidates.
+//
+void subCacheIndexCandidates
+(
+  const char*                         tenant,
+  const char*                         entityId,
+  const char*                         entityType,
+  std::vector<CachedSubscription*>*   candidatesP
+)
+{
+  bucketCopy(indexKey(SCI_ID,       tenant, entityId),   candidatesP);
+  bucketCopy(indexKey(SCI_TYPE,     tenant, entityType), candidatesP);
+  bucketCopy(indexKey(SCI_WILDCARD, tenant, NULL),       candidatesP);
+
+  // Same order as the sub-cache itself, so that notifications go out in the same order as without the index
+  std::sort(candidatesP->begin(), candidatesP->end(), cacheOrder);
+
+  //
+  // While a subscription is being replaced (subCacheItemReplace), both versions are in the index for a short moment.
+  // They have the same cacheSeq - only one of them is kept
+  //
+  candidatesP->erase(std::unique(candidatesP->begin(), candidatesP->end(), sameSubscription), candidatesP->end());
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexLookup -
+//
+// While a subscription is being replaced (subCacheItemReplace), both versions are in the index for a short moment.
+// The new version was added last, at the head of the slot, so it's the one that is found.
+//
+CachedSubscription* subCacheIndexLookup(const char* tenant, const char* subscriptionId)
+{
+  std::string        key   = subscriptionKey(tenant, subscriptionId);
+  SubCacheIndexNode* nodeP = __atomic_load_n(&subCacheIndex[slotIndex(key)], __ATOMIC_ACQUIRE);
+
+  while (nodeP != NULL)
+  {
+    if (nodeP->key == key)
+      return nodeP->subP;
+
+    nodeP = __atomic_load_n(&nodeP->next, __ATOMIC_ACQUIRE);
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexReset -
+//
+// The subscriptions are still alive (they're retired after the reset), and they forget their nodes,
+// so that a later subCacheIndexRemove (when they're stripped) finds nothing to unlink.
+//
+void subCacheIndexReset(void)
+{
+  pthread_mutex_lock(&subCacheIndexMutex);
+
+  for (unsigned int slot = 0; slot < SCI_SLOTS; ++slot)
+  {
+    SubCacheIndexNode* nodeP = __atomic_exchange_n(&subCacheIndex[slot], (SubCacheIndexNode*) NULL, __ATOMIC_ACQ_REL);
+
+    while (nodeP != NULL)
+    {
+      SubCacheIndexNode* next = nodeP->next;  // Left untouched - a reader standing on the node can continue its walk
+
+      nodeP->subP->indexNodes.clear();
+      epochRetire(nodeP, nodeRelease);
+      nodeP = next;
+    }
+  }
+
+  pthread_mutex_unlock(&subCacheIndexMutex);
+
+  epochReclaim();
+}
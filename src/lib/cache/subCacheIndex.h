@@ -0,0 +1,99 @@
+#ifndef SRC_LIB_CACHE_SUBCACHEINDEX_H_
+#define SRC_LIB_CACHE_SUBCACHEINDEX_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <vector>                                            // std::vector
+
+#include "cache/CachedSubscription.h"                        // CachedSubscription
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexInsert - add a subscription to the sub-cache index
+//
+// The index is built from the "entities" of the subscription (entityIdInfos) and its tenant.
+// Each subscription ends up in one of three "families" of buckets:
+//   - exact entity id:  all entity selectors have an 'id' (no idPattern) -  key: tenant + entity id
+//   - entity type:      all entity selectors have a type that isn't '*'   -  key: tenant + entity type
+//   - wildcard:         the rest (no entities, or '*' as type with idPattern/no id) - key: tenant
+// On top of that, every subscription is found by tenant + subscription id (subCacheIndexLookup).
+//
+// A subscription must be removed from the index (subCacheIndexRemove) before its entityIdInfos are modified,
+// and inserted again afterwards.
+//
+extern void subCacheIndexInsert(CachedSubscription* cSubP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexRemove - remove a subscription from the sub-cache index (no-op if not in the index)
+//
+extern void subCacheIndexRemove(CachedSubscription* cSubP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexCandidates - the subscriptions that might match an altered entity
+//
+// The candidates are returned in sub-cache order.
+// They still need to be checked in detail (entity id, type, status, q, ...), the index only excludes
+// subscriptions that cannot possibly match.
+//
+// No lock is taken - the caller must be inside a sub-cache read section (epochEnter) for as long
+// as it uses the index and the candidates.
+//
+extern void subCacheIndexCandidates
+(
+  const char*                         tenant,
+  const char*                         entityId,
+  const char*                         entityType,
+  std::vector<CachedSubscription*>*   candidatesP
+);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexLookup - the subscription with the id 'subscriptionId' of tenant 'tenant' (NULL if not found)
+//
+// Same rules as for subCacheIndexCandidates - no lock, the caller must be inside a sub-cache read section.
+//
+extern CachedSubscription* subCacheIndexLookup(const char* tenant, const char* subscriptionId);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheIndexReset - empty the sub-cache index
+//
+// All subscriptions are taken out of the index - a later subCacheIndexRemove is a no-op for them.
+//
+extern void subCacheIndexReset(void);
+
+#endif  // SRC_LIB_CACHE_SUBCACHEINDEX_H_
@@ -0,0 +1,275 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                          // uint64_t
+#include <stdlib.h>                                          // calloc
+#include <pthread.h>                                         // pthread_mutex_t, pthread_key_t
+#include <vector>                                            // std::vector
+
+#include "logMsg/logMsg.h"                                   // LM_*
+
+#include "epoch/epoch.h"                                     // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// EpochSlot - the read section state of one thread
+//
+// 'epoch' is zero while the thread is outside any read section.
+// Slots are never freed, when a thread exits its slot is marked as unused and is taken by the next new thread.
+//
+typedef struct EpochSlot
+{
+  uint64_t           epoch;
+  int                depth;
+  bool               inUse;
+  struct EpochSlot*  next;
+} EpochSlot;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// RetiredItem -
+//
+typedef struct RetiredItem
+{
+  void*                    itemP;
+  EpochReleaseFunction  releaseF;
+  uint64_t                 epoch;        // Global epoch at the moment of the retirement
+} RetiredItem;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Epoch state
+//
+// The global epoch starts at 1, as 0 means "not in a read section"
+//
+static uint64_t                  globalEpoch   = 1;
+static EpochSlot*                slotList      = NULL;
+static pthread_mutex_t           slotMutex     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t             slotKey;
+static pthread_once_t            slotKeyOnce   = PTHREAD_ONCE_INIT;
+static std::vector<RetiredItem>  retiredV;
+static int                       retiredItems  = 0;     // retiredV.size(), readable without the mutex
+static pthread_mutex_t           retiredMutex  = PTHREAD_MUTEX_INITIALIZER;
+static __thread EpochSlot*       mySlotP       = NULL;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// slotRelease - thread exit: the slot goes back to the pool
+//
+static void slotRelease(void* vP)
+{
+  EpochSlot* slotP = (EpochSlot*) vP;
+
+  __atomic_store_n(&slotP->epoch, 0, __ATOMIC_RELEASE);
+  slotP->depth = 0;
+  __atomic_store_n(&slotP->inUse, false, __ATOMIC_RELEASE);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// slotKeyCreate -
+//
+static void slotKeyCreate(void)
+{
+  if (pthread_key_create(&slotKey, slotRelease) != 0)
+    LM_E(("Internal Error (unable to create the thread key for the epoch slots)"));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// slotGet - the slot of the calling thread, assigned on first use
+//
+static EpochSlot* slotGet(void)
+{
+  if (mySlotP != NULL)
+    return mySlotP;
+
+  pthread_once(&slotKeyOnce, slotKeyCreate);
+  pthread_mutex_lock(&slotMutex);
+
+  EpochSlot* slotP;
+  for (slotP = slotList; slotP != NULL; slotP = slotP->next)
+  {
+    if (slotP->inUse == false)
+      break;
+  }
+
+  if (slotP == NULL)
+  {
+    slotP = (EpochSlot*) calloc(1, sizeof(EpochSlot));
+    if (slotP == NULL)
+      LM_X(1, ("Out of memory allocating an epoch slot"));
+
+    slotP->next = slotList;
+    __atomic_store_n(&slotList, slotP, __ATOMIC_RELEASE);  // Reclaimers walk the list without the mutex
+  }
+
+  slotP->inUse = true;
+  pthread_mutex_unlock(&slotMutex);
+
+  pthread_setspecific(slotKey, slotP);
+  mySlotP = slotP;
+
+  return slotP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// epochEnter -
+//
+// The epoch is read again after having been published, to close the window where a reclaimer might have
+// advanced the global epoch and scanned the slots between our read and our store.
+//
+void epochEnter(void)
+{
+  EpochSlot* slotP = slotGet();
+
+  if (slotP->depth++ > 0)
+    return;
+
+  uint64_t epoch = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST);
+
+  while (1)
+  {
+    __atomic_store_n(&slotP->epoch, epoch, __ATOMIC_SEQ_CST);
+
+    uint64_t now = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST);
+    if (now == epoch)
+      break;
+
+    epoch = now;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// epochLeave -
+//
+void epochLeave(void)
+{
+  EpochSlot* slotP = mySlotP;
+
+  if ((slotP == NULL) || (slotP->depth == 0))
+  {
+    LM_E(("Internal Error (leaving a read section that was never entered)"));
+    return;
+  }
+
+  if (--slotP->depth > 0)
+    return;
+
+  __atomic_store_n(&slotP->epoch, 0, __ATOMIC_RELEASE);
+
+  if (__atomic_load_n(&retiredItems, __ATOMIC_RELAXED) > 0)
+    epochReclaim();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// epochRetire -
+//
+// The item is tagged with the epoch BEFORE advancing it - readers that entered with that epoch (or earlier)
+// may still hold a pointer to it, readers entering later can't, as the item was unlinked before the advance.
+//
+void epochRetire(void* itemP, EpochReleaseFunction releaseF)
+{
+  RetiredItem retired;
+
+  retired.itemP    = itemP;
+  retired.releaseF = releaseF;
+  retired.epoch    = __atomic_fetch_add(&globalEpoch, 1, __ATOMIC_SEQ_CST);
+
+  pthread_mutex_lock(&retiredMutex);
+  retiredV.push_back(retired);
+  __atomic_store_n(&retiredItems, (int) retiredV.size(), __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&retiredMutex);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// epochReclaim -
+//
+void epochReclaim(void)
+{
+  std::vector<RetiredItem> freeV;
+
+  pthread_mutex_lock(&retiredMutex);
+
+  if (retiredV.size() == 0)
+  {
+    pthread_mutex_unlock(&retiredMutex);
+    return;
+  }
+
+  //
+  // The oldest epoch still being read
+  //
+  uint64_t oldest = UINT64_MAX;
+
+  for (EpochSlot* slotP = __atomic_load_n(&slotList, __ATOMIC_ACQUIRE); slotP != NULL; slotP = slotP->next)
+  {
+    uint64_t epoch = __atomic_load_n(&slotP->epoch, __ATOMIC_SEQ_CST);
+
+    if ((epoch != 0) && (epoch < oldest))
+      oldest = epoch;
+  }
+
+  unsigned int keep = 0;
+  for (unsigned int ix = 0; ix < retiredV.size(); ++ix)
+  {
+    if (retiredV[ix].epoch < oldest)
+      freeV.push_back(retiredV[ix]);
+    else
+      retiredV[keep++] = retiredV[ix];
+  }
+
+  retiredV.resize(keep);
+  __atomic_store_n(&retiredItems, (int) keep, __ATOMIC_RELAXED);
+
+  pthread_mutex_unlock(&retiredMutex);
+
+  // The release functions are called without the mutex - they may very well retire other items
+  for (unsigned int ix = 0; ix < freeV.size(); ++ix)
+    freeV[ix].releaseF(freeV[ix].itemP);
+}
@@ -0,0 +1,101 @@
+#ifndef SRC_LIB_EPOCH_EPOCH_H_
+#define SRC_LIB_EPOCH_EPOCH_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Epoch based reclamation for the lock-free caches
+//
+// Alteration matching reads the sub-cache (its index and the cached subscriptions) and request treatment
+// reads the context cache, without taking the cache semaphores. Instead, the reader announces that it is
+// inside a "read section":
+//
+//   epochEnter();
+//   ... look up, use what was found ...
+//   epochLeave();
+//
+// A writer that unlinks something a reader might still be looking at doesn't free it, it hands it over
+// to epochRetire(). The item is freed once every thread that was inside a read section at the
+// moment of the retirement has left it.
+//
+// There is a single epoch for all the caches - an item retired by one cache waits also for the readers of the others.
+//
+// Read sections nest (an inner Enter/Leave pair is a no-op) and must not block for long, as nothing
+// retired meanwhile can be freed.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// EpochReleaseFunction - frees a retired item
+//
+typedef void (*EpochReleaseFunction)(void* itemP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// epochEnter - start a read section
+//
+extern void epochEnter(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// epochLeave - end a read section
+//
+// If items are waiting to be freed, an attempt to reclaim them is made when the outermost section ends.
+//
+extern void epochLeave(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// epochRetire - free 'itemP' (by calling 'releaseF') once no reader can reach it anymore
+//
+// 'itemP' must already be unreachable for new readers (unlinked from whatever list/index it was found in).
+// Nothing is freed by this call, as the caller may hold locks that the release functions need.
+// The retired items are freed by the next epochReclaim, or when the last reader leaves its read section.
+//
+extern void epochRetire(void* itemP, EpochReleaseFunction releaseF);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// epochReclaim - free all retired items that no reader can see anymore
+//
+// Must not be called holding a lock that any of the release functions take (e.g. the sub-cache index mutex).
+//
+extern void epochReclaim(void);
+
+#endif  // SRC_LIB_EPOCH_EPOCH_H_
@@ -42,6 +42,7 @@ typedef enum TraceLevels
   LmtHeaders,                          // HTTP Headers
   LmtUriParams,                        // HTTP URI Parameters
   LmtUriParamOptions,                  // HTTP URI Parameter 'options'
+  LmtRequestExecutor,                  // Request executors (-reqExecutors)
 
   //
   // Alterations and Notifications
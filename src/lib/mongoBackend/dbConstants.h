@@ -104,6 +104,7 @@
 #define CSUB_EXPR_GEOM               "geometry"
 #define CSUB_EXPR_COORDS             "coords"
 #define CSUB_EXPR_GEOREL             "georel"
+#define CSUB_EXPR_GEOPROPERTY        "geoproperty"
 
 #define CSUB_THROTTLING              "throttling"
 #define CSUB_ENTITIES                "entities"
@@ -242,6 +242,9 @@ int mongoSubCacheItemInsert(const char* tenant, const BSONObj& sub)
 
       if (expression.hasField(CSUB_EXPR_GEOREL))
         cSubP->expression.georel = getStringFieldF(&expression, CSUB_EXPR_GEOREL);
+
+      if (expression.hasField(CSUB_EXPR_GEOPROPERTY))
+        cSubP->expression.geoproperty = getStringFieldF(&expression, CSUB_EXPR_GEOPROPERTY);
     }
   }
 
@@ -329,7 +332,9 @@ int mongoSubCacheItemInsert(const char* tenant, const BSONObj& sub)
   // and the new "native NGSI-LD" notifications provokes a notification.
   // THEN it is built and stored in the sub-cache.
   //
-  cSubP->qP = NULL;  // Will be build on demand
+  cSubP->qP           = NULL;  // Will be build on demand
+  cSubP->qcP          = NULL;  // Compiled from qP, on demand
+  cSubP->geoCompiledP = NULL;  // Compiled from 'expression', on demand
 
   subCacheItemInsert(cSubP);
 
@@ -0,0 +1,246 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc, calloc, free
+#include <string.h>                                              // bzero
+#include <pthread.h>                                             // pthread_key_t, pthread_once, ...
+#include <time.h>                                                // clock_gettime, CLOCK_THREAD_CPUTIME_ID
+#include <zlib.h>                                                // z_stream, deflate*
+
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                       // KAlloc
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/ContentEncoding.h"                       // ContentEncoding
+#include "orionld/common/orionldState.h"                         // compressLevel, promCompression*
+#include "orionld/prometheus/promCounterAdd.h"                   // promCounterAdd
+#include "orionld/common/compress.h"                             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// CompressContext - the compressors of a thread
+//
+// A deflate stream allocates some 256 KB of state - it is created the first time a thread compresses,
+// reused (deflateReset) for every payload body after that, and freed when the thread exits.
+//
+typedef struct CompressContext
+{
+  z_stream  gzip;
+  bool      gzipInitialized;
+  z_stream  deflate;
+  bool      deflateInitialized;
+} CompressContext;
+
+static pthread_key_t   compressContextKey;
+static pthread_once_t  compressContextKeyOnce = PTHREAD_ONCE_INIT;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressContextFree - thread-exit destructor of the thread's CompressContext
+//
+static void compressContextFree(void* ptr)
+{
+  CompressContext* ccP = (CompressContext*) ptr;
+
+  if (ccP->gzipInitialized == true)
+    deflateEnd(&ccP->gzip);
+  if (ccP->deflateInitialized == true)
+    deflateEnd(&ccP->deflate);
+
+  free(ccP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressContextKeyCreate -
+//
+static void compressContextKeyCreate(void)
+{
+  pthread_key_create(&compressContextKey, compressContextFree);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressStreamInit - initialize a compressor for an encoding, at the level of -compress
+//
+// "gzip" is the gzip format (RFC 1952) and "deflate" is the zlib format (RFC 1950), as HTTP has it.
+// The compression level is -compress, Z_DEFAULT_COMPRESSION if -compress is 0 (only subscriptions with Content-Encoding compress).
+//
+bool compressStreamInit(z_stream* zP, ContentEncoding encoding)
+{
+  int level      = (compressLevel != 0)? compressLevel : Z_DEFAULT_COMPRESSION;
+  int windowBits = (encoding == CE_GZIP)? 15 + 16 : 15;  // +16: gzip header and trailer instead of zlib's
+
+  bzero(zP, sizeof(z_stream));
+
+  if (deflateInit2(zP, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+  {
+    LM_E(("Internal Error (deflateInit2 failed: %s)", (zP->msg != NULL)? zP->msg : "no error message"));
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressStreamGet - the compressor of the calling thread, for an encoding, reset and ready to be used
+//
+z_stream* compressStreamGet(ContentEncoding encoding)
+{
+  pthread_once(&compressContextKeyOnce, compressContextKeyCreate);
+
+  CompressContext* ccP = (CompressContext*) pthread_getspecific(compressContextKey);
+
+  if (ccP == NULL)
+  {
+    ccP = (CompressContext*) calloc(1, sizeof(CompressContext));
+    if (ccP == NULL)
+    {
+      LM_E(("Out of memory allocating a compression context"));
+      return NULL;
+    }
+
+    pthread_setspecific(compressContextKey, ccP);
+  }
+
+  z_stream*  zP           = (encoding == CE_GZIP)? &ccP->gzip            : &ccP->deflate;
+  bool*      initializedP = (encoding == CE_GZIP)? &ccP->gzipInitialized : &ccP->deflateInitialized;
+
+  if (*initializedP == true)
+  {
+    deflateReset(zP);
+    return zP;
+  }
+
+  if (compressStreamInit(zP, encoding) == false)
+    return NULL;
+
+  *initializedP = true;
+  return zP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressBuffer - compress a payload body that comes in one or more parts
+//
+// The output buffer is allocated from 'kaP', or with malloc if 'kaP' is NULL (to be freed by the caller).
+// It is allocated to the upper bound of deflate, so the whole body is compressed in one go, and it's zero-terminated.
+//
+// Returns NULL on error - the body is then sent uncompressed.
+//
+char* compressBuffer(ContentEncoding encoding, KAlloc* kaP, int parts, const char** partV, const int* partLenV, int* outLenP)
+{
+  double     startTime = compressCpuTime();
+  z_stream*  zP        = compressStreamGet(encoding);
+
+  if (zP == NULL)
+    return NULL;
+
+  unsigned long inLen = 0;
+  for (int ix = 0; ix < parts; ix++)
+    inLen += partLenV[ix];
+
+  unsigned long outSize = deflateBound(zP, inLen) + 32;  // +32: room for the gzip header and trailer
+  char*         out     = (kaP != NULL)? kaAlloc(kaP, outSize + 1) : (char*) malloc(outSize + 1);
+
+  if (out == NULL)
+  {
+    LM_E(("Out of memory allocating %lu bytes for a compressed payload body", outSize));
+    return NULL;
+  }
+
+  zP->next_out  = (Bytef*) out;
+  zP->avail_out = outSize;
+
+  int rc = Z_OK;
+  for (int ix = 0; ix < parts; ix++)
+  {
+    zP->next_in  = (Bytef*) partV[ix];
+    zP->avail_in = partLenV[ix];
+
+    rc = deflate(zP, (ix == parts - 1)? Z_FINISH : Z_NO_FLUSH);
+    if ((rc != Z_OK) && (rc != Z_STREAM_END))
+      break;
+  }
+
+  if (rc != Z_STREAM_END)
+  {
+    LM_E(("Internal Error (deflate failed: %d)", rc));
+    if (kaP == NULL)
+      free(out);
+    return NULL;
+  }
+
+  out[zP->total_out] = 0;  // Not a string, but traces print it as one
+  *outLenP = zP->total_out;
+  compressMetricsAdd(inLen, zP->total_out, compressCpuTime() - startTime);
+
+  return out;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressCpuTime - CPU time of the calling thread, in seconds
+//
+double compressCpuTime(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ((double) ts.tv_nsec) / 1000000000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressMetricsAdd - account for a compressed payload body (Prometheus metrics)
+//
+// The compression ratio is compressionBytesOut / compressionBytesIn.
+//
+void compressMetricsAdd(unsigned long bytesIn, unsigned long bytesOut, double cpuTime)
+{
+  promCounterAdd(promCompressionBytesIn,  bytesIn);
+  promCounterAdd(promCompressionBytesOut, bytesOut);
+  promCounterAdd(promCompressionCpuTime,  cpuTime);
+}
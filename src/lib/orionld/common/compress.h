@@ -0,0 +1,77 @@
+#ifndef SRC_LIB_ORIONLD_COMMON_COMPRESS_H_
+#define SRC_LIB_ORIONLD_COMMON_COMPRESS_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <zlib.h>                                                // z_stream
+
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                       // KAlloc
+}
+
+#include "orionld/types/ContentEncoding.h"                       // ContentEncoding
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressStreamInit - initialize a compressor for an encoding, at the level of -compress
+//
+extern bool compressStreamInit(z_stream* zP, ContentEncoding encoding);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressStreamGet - the compressor of the calling thread, for an encoding, reset and ready to be used
+//
+extern z_stream* compressStreamGet(ContentEncoding encoding);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressBuffer - compress a payload body that comes in one or more parts
+//
+extern char* compressBuffer(ContentEncoding encoding, KAlloc* kaP, int parts, const char** partV, const int* partLenV, int* outLenP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressCpuTime - CPU time of the calling thread, in seconds
+//
+extern double compressCpuTime(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// compressMetricsAdd - account for a compressed payload body (Prometheus metrics)
+//
+extern void compressMetricsAdd(unsigned long bytesIn, unsigned long bytesOut, double cpuTime);
+
+#endif  // SRC_LIB_ORIONLD_COMMON_COMPRESS_H_
@@ -49,12 +49,14 @@ extern "C"
 #include "orionld/types/OrionldTenant.h"                         // OrionldTenant
 #include "orionld/types/OrionldHeader.h"                         // OrionldHeaderSet
 #include "orionld/types/OrionldAlteration.h"                     // OrionldAlteration
+#include "orionld/types/NotificationRender.h"                    // NotificationRender
 #include "orionld/types/StringArray.h"                           // StringArray
 #include "orionld/types/EntityMap.h"                             // EntityMap
 #include "orionld/types/PernotSubCache.h"                        // PernotSubCache
 #include "orionld/types/OrionldContext.h"                        // OrionldContext
 #include "orionld/types/DistOp.h"                                // DistOp
 #include "orionld/types/TroeMode.h"                              // TroeMode
+#include "orionld/types/ContentEncoding.h"                       // ContentEncoding
 #include "orionld/types/Verb.h"                                  // Verb
 #include "orionld/types/OrionldRenderFormat.h"                   // OrionldRenderFormat
 #include "orionld/types/OrionldMimeType.h"                       // MimeType
@@ -110,6 +112,8 @@ typedef struct OrionldUriParamOptions
   bool dateModified;   // Only NGSIv2
   bool noAttrDetail;   // Only NGSIv2
   bool upsert;         // Only NGSIv2
+  bool temporalValues;    // Only temporal
+  bool aggregatedValues;  // Only temporal
 } OrionldUriParamOptions;
 
 
@@ -169,6 +173,9 @@ typedef struct OrionldUriParams
   bool      onlyIds;
   bool      entityMap;
   char*     format;
+  int       lastN;
+  char*     aggrMethods;
+  char*     aggrPeriodDuration;
 
   OrionldContextKind kind;
 
@@ -251,6 +258,7 @@ typedef struct OrionldStateIn
   bool      performance;
   bool      aerOS;           // Special treatment for aerOS specific features
   char*     wip;
+  ContentEncoding acceptEncoding;  // Preferred encoding (from Accept-Encoding) of the response body
 
   // Incoming payload
   char*     payload;
@@ -337,6 +345,7 @@ typedef struct OrionldConnectionState
   KjNode*                 responseTree;
   char*                   responsePayload;
   bool                    responsePayloadAllocated;
+  bool                    responseStreamed;          // Array response streamed by mhdReply - orionldStateRelease delayed until requestCompleted
   char*                   tenantName;
   OrionldTenant*          tenantP;
   bool                    linkHttpHeaderPresent;
@@ -408,6 +417,7 @@ typedef struct OrionldConnectionState
   //
   OrionldAlteration*      alterations;
   OrionldAlteration*      alterationsTail;
+  NotificationRender*     notificationRenderList;  // Notification bodies already rendered, for subscriptions with the same shape
 
   //
   // CURL Handles + Headers Lists
@@ -581,6 +591,11 @@ extern char              dbURI[];                  // From orionld.cpp
 extern bool              multitenancy;             // From orionld.cpp
 extern int               contextDownloadAttempts;  // From orionld.cpp
 extern int               contextDownloadTimeout;   // From orionld.cpp
+extern int               contextExpandMemo;        // From orionld.cpp - KB per context, 0: no expansion memo
+extern int               contextRevalidation;      // From orionld.cpp - seconds, 0: no revalidation
+extern char              contextWarmupFile[256];   // From orionld.cpp
+extern char              contextSnapshotFile[256]; // From orionld.cpp
+extern int               contextSnapshotInterval;  // From orionld.cpp - seconds, 0: snapshot only at shutdown
 extern int               subCacheInterval;         // From orionld.cpp
 extern int               subCacheFlushInterval;    // From orionld.cpp
 extern bool              troe;                     // From orionld.cpp
@@ -589,6 +604,11 @@ extern unsigned short    troePort;                 // From orionld.cpp
 extern char              troeUser[256];            // From orionld.cpp
 extern char              troePwd[256];             // From orionld.cpp
 extern int               troePoolSize;             // From orionld.cpp
+extern int               troeFlushInterval;        // Max milliseconds a TRoE command waits for its group commit (0: no group commit)
+extern int               troeFlushRows;            // Max number of TRoE commands per group commit
+extern int               troeQueueMem;             // Max memory (MB) for TRoE commands awaiting their group commit
+extern bool              troeCopy;                 // COPY (FORMAT binary) instead of INSERT for the TRoE records
+extern int               troePoolIdleTime;         // Seconds a pooled postgres connection may be unused before it is closed (0: never)
 extern char              pgPortString[16];
 extern bool              distributed;              // From orionld.cpp
 extern char              brokerId[136];            // From orionld.cpp
@@ -610,6 +630,16 @@ extern char              userAgentHeaderNoLF[64];  // move to orionld.cpp?
 extern bool              debugCurl;                // From orionld.cpp
 extern bool              noCache;                  // From orionld.cpp
 extern uint32_t          cSubCounters;             // Number of subscription counter updates before flush from sub-cache to DB
+extern int               notifConnMax;             // Max number of keep-alive connections per notification endpoint (0: no keep-alive)
+extern int               notifConnIdle;            // Seconds before an idle keep-alive notification connection is closed
+extern bool              subCacheIncremental;      // Refresh the sub-cache with the subscription changes only
+extern int               notifTimeout;             // Milliseconds to await the response to a notification
+extern int               notifRetries;             // Retries of a failed notification (0: no retries)
+extern int               notifRetryDelay;          // Milliseconds before the first retry - doubled for every failed retry
+extern int               notifRetryQueue;          // Max number of failed notifications in memory, per subscription
+extern int               notifRetryMem;            // Max memory (MB) for failed notifications
+extern int               notifRetryThreads;        // Number of threads retrying failed notifications
+extern char              notifRetrySpill[256];     // Path to the spill file for failed notifications
 extern PernotSubCache    pernotSubCache;
 extern EntityMap*        entityMaps;               // Used by GET /entities in the distributed case, for pagination
 extern bool              entityMapsEnabled;        // Enable Entity Maps
@@ -619,6 +649,10 @@ extern bool              noArrayReduction;         // Used by arrayReduce in pCh
 extern char                localIpAndPort[135];    // Local address for X-Forwarded-For (from orionld.cpp)
 extern unsigned long long  inReqPayloadMaxSize;
 extern unsigned long long  outReqMsgMaxSize;
+extern int                 chunkedResponseSize;    // From orionld.cpp - KB, arrays bigger than this are streamed (0: never)
+extern unsigned int        reqPoolSize;            // From orionld.cpp
+extern int                 compressLevel;          // From orionld.cpp - 1-9 (0: responses are not compressed)
+extern int                 compressMin;            // From orionld.cpp - bytes, smaller payload bodies are not compressed
 
 
 
@@ -630,6 +664,34 @@ extern prom_counter_t*     promNgsildRequests;
 extern prom_counter_t*     promNgsildRequestsFailed;
 extern prom_counter_t*     promNotifications;
 extern prom_counter_t*     promNotificationsFailed;
+extern prom_counter_t*     promNotificationsQueued;
+extern prom_counter_t*     promNotificationsDropped;
+extern prom_gauge_t*       promNotificationQueueDepth;
+extern prom_counter_t*     promNotificationConnectionsOpened;
+extern prom_counter_t*     promNotificationConnectionsReused;
+extern prom_counter_t*     promNotificationRenderHits;
+extern prom_counter_t*     promNotificationRenderMisses;
+extern prom_gauge_t*       promNotificationRetryQueued;
+extern prom_gauge_t*       promNotificationRetrySpilled;
+extern prom_counter_t*     promNotificationRetries;
+extern prom_counter_t*     promNotificationsRedelivered;
+extern prom_counter_t*     promNotificationRetryDropped;
+extern prom_histogram_t*   promNotificationRedeliveryLatency;
+extern prom_counter_t*     promCompressionBytesIn;
+extern prom_counter_t*     promCompressionBytesOut;
+extern prom_counter_t*     promCompressionCpuTime;
+extern prom_histogram_t*   promTroeBatchSize;
+extern prom_histogram_t*   promTroeWriteLag;
+extern prom_gauge_t*       promTroeQueueDepth;
+extern prom_counter_t*     promTroeBackpressure;
+extern prom_counter_t*     promTroeCommandsFailed;
+extern prom_histogram_t*   promPgPoolWaitTime;
+extern prom_counter_t*     promPgPoolSaturated;
+extern prom_counter_t*     promPgPoolReconnects;
+extern prom_gauge_t*       promPgPoolConnections;
+extern prom_histogram_t*   promRequestExecutorWait;
+extern prom_histogram_t*   promRequestExecutorResponseTime;
+extern prom_histogram_t*   promRequestExecutorPostResponseTime;
 
 
 
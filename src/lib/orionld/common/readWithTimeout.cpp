@@ -0,0 +1,71 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <errno.h>                                               // errno, EINTR
+#include <string.h>                                              // strerror
+#include <unistd.h>                                              // read
+#include <sys/select.h>                                          // select, fd_set, FD_*
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/common/readWithTimeout.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// readWithTimeout -
+//
+int readWithTimeout(int fd, char* buf, int bufLen, int tmoSecs, int tmoMicroSecs)
+{
+  while (1)  // "try-again" if EINTR, otherwise, either return error or finish
+  {
+    int            fds;
+    fd_set         rFds;
+    struct timeval tv    = { tmoSecs, tmoMicroSecs };
+    int            fdMax = fd;
+
+    FD_ZERO(&rFds);
+    FD_SET(fd, &rFds);
+
+    fds = select(fdMax + 1, &rFds, NULL, NULL, &tv);
+    if (fds == -1)
+    {
+      if (errno == EINTR)
+        continue;
+
+      LM_E(("select error: %s", strerror(errno)));
+      return -1;
+    }
+    else if (fds == 0)
+      return 0;
+
+    if (!FD_ISSET(fd, &rFds))
+      return -1;  // This can't happen ...
+
+    break;
+  }
+
+  return read(fd, buf, bufLen);
+}
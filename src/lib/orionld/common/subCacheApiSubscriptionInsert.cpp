@@ -39,7 +39,7 @@ extern "C"
 #include "logMsg/logMsg.h"                                       // LM_*
 
 #include "cache/CachedSubscription.h"                            // CachedSubscription
-#include "cache/subCache.h"                                      // subCacheItemInsert
+#include "cache/subCache.h"                                      // subCacheItemInsert, subCacheItemReplace, subCacheItemDestroy
 
 #include "orionld/types/QNode.h"                                 // QNode
 #include "orionld/types/OrionldContext.h"                        // OrionldContext
@@ -50,6 +50,8 @@ extern "C"
 #include "orionld/common/urlParse.h"                             // urlParse
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/dateTime.h"                             // dateTimeFromString
+#include "orionld/q/qCompile.h"                                  // qCompile
+#include "orionld/geo/geoCompile.h"                               // geoCompile
 #include "orionld/common/subCacheApiSubscriptionInsert.h"        // Own interface
 
 
@@ -76,9 +78,11 @@ static void subCacheItemFill
   cSubP->tenant              = (tenant == NULL || *tenant == 0)? NULL : strdup(tenant);
   cSubP->servicePath         = strdup("/#");
   cSubP->qP                  = qTree;
+  cSubP->qcP                 = (qTree != NULL)? qCompile(qTree) : NULL;
   cSubP->contextP            = contextP;        // Right now, this is orionldState.contextP, i.e., the @context used when creating, except if "refresh"!
   cSubP->ldContext           = (contextP != NULL)? contextP->url : "";
   cSubP->geoCoordinatesP     = NULL;
+  cSubP->geoCompiledP        = NULL;
   cSubP->showChanges         = (showChangesP != NULL)? showChangesP->value.b : false;
   cSubP->sysAttrs            = (sysAttrsP != NULL)? sysAttrsP->value.b : false;
   cSubP->renderFormat        = rFormat;
@@ -411,6 +415,18 @@ static void subCacheItemFill
 
   if (geoCoordinatesP != NULL)
     cSubP->geoCoordinatesP = kjClone(NULL, geoCoordinatesP);
+
+  //
+  // The geoQ is compiled for the notification matching - no database query needed
+  // If it doesn't compile, the subscription matches no entity at all (see subCacheAlterationMatch)
+  //
+  if ((geoqP != NULL) && (cSubP->geoCoordinatesP != NULL))
+  {
+    cSubP->geoCompiledP = geoCompile(cSubP->expression.geometry.c_str(),
+                                     cSubP->expression.georel.c_str(),
+                                     cSubP->expression.geoproperty.c_str(),
+                                     cSubP->geoCoordinatesP);
+  }
 }
 
 
@@ -440,6 +456,42 @@ static CachedSubscription* subCacheApiSubscriptionCreate
 
 
 
+// -----------------------------------------------------------------------------
+//
+// subCacheApiSubscriptionReplace -
+//
+// Alteration matching reads the cached subscriptions without the cache semaphore, so, a cached subscription
+// is never modified in place. A new version is created and it replaces the old one.
+//
+CachedSubscription* subCacheApiSubscriptionReplace
+(
+  CachedSubscription*  cSubP,
+  KjNode*              apiSubscriptionP,
+  QNode*               qTree,
+  KjNode*              geoCoordinatesP,
+  OrionldContext*      contextP,
+  const char*          tenant,
+  KjNode*              showChangesP,
+  KjNode*              sysAttrsP,
+  OrionldRenderFormat  renderFormat
+)
+{
+  CachedSubscription* newP = new CachedSubscription();
+
+  subCacheItemFill(newP, apiSubscriptionP, qTree, geoCoordinatesP, contextP, tenant, showChangesP, sysAttrsP, renderFormat);
+
+  if (subCacheItemReplace(cSubP, newP) != 0)
+  {
+    subCacheItemDestroy(newP);
+    delete newP;
+    return cSubP;
+  }
+
+  return newP;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // subCacheApiSubscriptionUpdate -
@@ -463,12 +515,7 @@ static CachedSubscription* subCacheApiSubscriptionUpdate
 
   KjNode* modifiedAtNode = kjLookup(apiSubscriptionP, "modifiedAt");
   if (modifiedAtNode == NULL)
-  {
-    struct timespec now;
-    kTimeGet(&now);
-    cSubP->modifiedAt = now.tv_sec + now.tv_nsec / 1000000000.0;
     LM_W(("Invalid subscription id DB - no 'modifiedAt' field"));
-  }
   else
   {
     LM_T(LmtSubCacheSync, ("%s: modifiedAt in cache: %f", cSubP->subscriptionId, cSubP->modifiedAt));
@@ -479,17 +526,18 @@ static CachedSubscription* subCacheApiSubscriptionUpdate
       LM_T(LmtSubCacheSync, ("%s: incoming is not newer - no change", cSubP->subscriptionId));
       return cSubP;
     }
-
-    cSubP->modifiedAt = modifiedAtNode->value.f;  // The new value is in the DB
   }
 
-  cSubP->count    = 0;
-  cSubP->failures = 0;
+  CachedSubscription* newP = subCacheApiSubscriptionReplace(cSubP, apiSubscriptionP, qTree, geoCoordinatesP, contextP, tenant, showChangesP, sysAttrsP, renderFormat);
 
-  subCacheItemStrip(cSubP);
-  subCacheItemFill(cSubP, apiSubscriptionP, qTree, geoCoordinatesP, contextP, tenant, showChangesP, sysAttrsP, renderFormat);
+  if ((modifiedAtNode == NULL) && (newP != cSubP))
+  {
+    struct timespec now;
+    kTimeGet(&now);
+    newP->modifiedAt = now.tv_sec + now.tv_nsec / 1000000000.0;
+  }
 
-  return cSubP;
+  return newP;
 }
 
 
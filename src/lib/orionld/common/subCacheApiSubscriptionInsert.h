@@ -54,4 +54,27 @@ extern CachedSubscription* subCacheApiSubscriptionInsert
   OrionldRenderFormat    renderFormat
 );
 
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheApiSubscriptionReplace - replace a cached subscription with a new version, created from an API Subscription
+//
+// The cached subscription isn't modified - it is retired and freed once no alteration matching holds it anymore.
+// Returns the new version (or the old one, if the replacement failed).
+//
+extern CachedSubscription* subCacheApiSubscriptionReplace
+(
+  CachedSubscription*    cSubP,
+  KjNode*                apiSubscriptionP,
+  QNode*                 qTree,
+  KjNode*                geoCoordinatesP,
+  OrionldContext*        contextP,
+  const char*            tenant,
+  KjNode*                showChangesP,
+  KjNode*                sysAttrsP,
+  OrionldRenderFormat    renderFormat
+);
+
 #endif  // SRC_LIB_ORIONLD_COMMON_SUBCACHEAPISUBSCRIPTIONINSERT_H_
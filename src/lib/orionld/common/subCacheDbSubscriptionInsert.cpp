@@ -0,0 +1,86 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "cache/CachedSubscription.h"                            // CachedSubscription
+
+#include "orionld/types/OrionldTenant.h"                         // OrionldTenant
+#include "orionld/types/QNode.h"                                 // QNode
+#include "orionld/types/OrionldRenderFormat.h"                   // OrionldRenderFormat
+#include "orionld/common/subCacheApiSubscriptionInsert.h"        // subCacheApiSubscriptionInsert
+#include "orionld/pernot/pernotSubCacheAdd.h"                    // pernotSubCacheAdd
+#include "orionld/dbModel/dbModelToApiSubscription.h"            // dbModelToApiSubscription
+#include "orionld/context/orionldContextFromUrl.h"               // orionldContextFromUrl
+#include "orionld/kjTree/kjTreeLog.h"                             // kjTreeLog
+#include "orionld/common/subCacheDbSubscriptionInsert.h"         // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subCacheDbSubscriptionInsert -
+//
+CachedSubscription* subCacheDbSubscriptionInsert(OrionldTenant* tenantP, KjNode* dbSubP)
+{
+  QNode*              qTree         = NULL;
+  KjNode*             contextNodeP  = NULL;
+  KjNode*             coordinatesP  = NULL;
+  KjNode*             showChangesP  = NULL;
+  KjNode*             sysAttrsP     = NULL;
+  OrionldRenderFormat renderFormat  = RF_NORMALIZED;
+  double              timeInterval  = 0;
+
+  kjTreeLog(dbSubP, "dbSubP", LmtPernot);
+  KjNode*      apiSubP       = dbModelToApiSubscription(dbSubP,
+                                                        tenantP->tenant,
+                                                        true,
+                                                        &qTree,
+                                                        &coordinatesP,
+                                                        &contextNodeP,
+                                                        &showChangesP,
+                                                        &sysAttrsP,
+                                                        &renderFormat,
+                                                        &timeInterval);
+
+  if (apiSubP == NULL)
+    return NULL;
+
+  kjTreeLog(apiSubP, "apiSubP", LmtPernot);
+
+  OrionldContext* contextP = NULL;
+  if (contextNodeP != NULL)
+    contextP = orionldContextFromUrl(contextNodeP->value.s, NULL);
+
+  if (timeInterval == 0)
+    return subCacheApiSubscriptionInsert(apiSubP, qTree, coordinatesP, contextP, tenantP->tenant, showChangesP, sysAttrsP, renderFormat);
+
+  pernotSubCacheAdd(NULL, apiSubP, NULL, qTree, coordinatesP, contextP, tenantP, showChangesP, sysAttrsP, renderFormat, timeInterval);
+  return NULL;
+}
@@ -0,0 +1,186 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+#include <unistd.h>                                              // NULL
+
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                       // KAlloc
+#include "khash/khash.h"                                         // KHashTable, KHashListItem, khashTableCreate, ...
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+#include "orionld/types/OrionldContextItem.h"                    // OrionldContextItem
+#include "orionld/contextCache/orionldContextCache.h"            // ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE
+#include "orionld/context/orionldContextFromObject.h"            // hashCode
+#include "orionld/context/orionldContextArrayMerge.h"            // Own interface
+
+
+
+// ----------------------------------------------------------------------------
+//
+// nameCompareFunction -
+//
+static int nameCompareFunction(const char* name, void* itemP)
+{
+  OrionldContextItem* cItemP = (OrionldContextItem*) itemP;
+
+  return strcmp(name, cItemP->name);
+}
+
+
+
+// ----------------------------------------------------------------------------
+//
+// valueCompareFunction -
+//
+static int valueCompareFunction(const char* longname, void* itemP)
+{
+  OrionldContextItem* cItemP = (OrionldContextItem*) itemP;
+
+  return strcmp(longname, cItemP->id);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// namesFromTable - add the terms of a hash table that aren't already defined
+//
+static void namesFromTable(KHashTable* nameTableP, KHashTable* fromP)
+{
+  for (int slot = 0; slot < ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE; ++slot)
+  {
+    for (KHashListItem* listItemP = fromP->array[slot]; listItemP != NULL; listItemP = listItemP->next)
+    {
+      OrionldContextItem* itemP = (OrionldContextItem*) listItemP->data;
+
+      if (khashItemLookup(nameTableP, itemP->name) == NULL)
+        khashItemAdd(nameTableP, itemP->name, itemP);
+    }
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// namesMerge - add the terms of a context that aren't already defined
+//
+// The array is walked backwards, so that the first definition found (and kept) is the last one in the array.
+//
+static void namesMerge(KHashTable* nameTableP, OrionldContext* contextP)
+{
+  if (contextP == NULL)
+    return;
+
+  if (contextP->keyValues == true)
+    namesFromTable(nameTableP, contextP->context.hash.nameHashTable);
+  else if (contextP->context.array.nameHashTable != NULL)
+    namesFromTable(nameTableP, contextP->context.array.nameHashTable);
+  else
+  {
+    for (int ix = contextP->context.array.items - 1; ix >= 0; --ix)
+      namesMerge(nameTableP, contextP->context.array.vector[ix]);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// valuesFromTable - add the IRIs of a hash table whose terms haven't been overridden and that aren't already there
+//
+static void valuesFromTable(KHashTable* valueTableP, KHashTable* nameTableP, KHashTable* fromP)
+{
+  for (int slot = 0; slot < ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE; ++slot)
+  {
+    for (KHashListItem* listItemP = fromP->array[slot]; listItemP != NULL; listItemP = listItemP->next)
+    {
+      OrionldContextItem* itemP = (OrionldContextItem*) listItemP->data;
+
+      if (khashItemLookup(nameTableP, itemP->name) != itemP)
+        continue;  // Overridden by a later context of the array
+
+      if (khashItemLookup(valueTableP, itemP->id) == NULL)
+        khashItemAdd(valueTableP, itemP->id, itemP);
+    }
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// valuesMerge -
+//
+// Also backwards - for an IRI that more than one (winning) term maps to, the term of the last context is kept.
+//
+static void valuesMerge(KHashTable* valueTableP, KHashTable* nameTableP, OrionldContext* contextP)
+{
+  if (contextP == NULL)
+    return;
+
+  if (contextP->keyValues == true)
+    valuesFromTable(valueTableP, nameTableP, contextP->context.hash.valueHashTable);
+  else if (contextP->context.array.valueHashTable != NULL)
+    valuesFromTable(valueTableP, nameTableP, contextP->context.array.valueHashTable);
+  else
+  {
+    for (int ix = contextP->context.array.items - 1; ix >= 0; --ix)
+      valuesMerge(valueTableP, nameTableP, contextP->context.array.vector[ix]);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextArrayMerge -
+//
+bool orionldContextArrayMerge(OrionldContext* contextP, KAlloc* kallocP)
+{
+  KHashTable* nameTableP  = khashTableCreate(kallocP, hashCode, nameCompareFunction,  ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
+  KHashTable* valueTableP = khashTableCreate(kallocP, hashCode, valueCompareFunction, ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
+
+  if ((nameTableP == NULL) || (valueTableP == NULL))
+  {
+    LM_E(("khashTableCreate failed"));
+    return false;
+  }
+
+  for (int ix = contextP->context.array.items - 1; ix >= 0; --ix)
+    namesMerge(nameTableP, contextP->context.array.vector[ix]);
+
+  for (int ix = contextP->context.array.items - 1; ix >= 0; --ix)
+    valuesMerge(valueTableP, nameTableP, contextP->context.array.vector[ix]);
+
+  contextP->context.array.nameHashTable  = nameTableP;
+  contextP->context.array.valueHashTable = valueTableP;
+
+  return true;
+}
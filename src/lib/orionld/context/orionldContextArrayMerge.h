@@ -0,0 +1,51 @@
+#ifndef SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTARRAYMERGE_H_
+#define SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTARRAYMERGE_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                       // KAlloc
+}
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextArrayMerge - merge the terms of all contexts of an array context into one name and one value table
+//
+// Term expansion and compaction with an array context is then a single hash probe, instead of a recursive lookup
+// in each and every context of the array.
+// JSON-LD override order is honoured: if more than one context of the array defines a term, the last definition wins.
+// An IRI compacts to the term of the last context of the array that maps to it, among the winning definitions
+// (the same as orionldContextItemValueLookup does without the merged tables).
+//
+// The tables are allocated using 'kallocP', and the items they point to are those of the contexts of the array.
+//
+extern bool orionldContextArrayMerge(OrionldContext* contextP, KAlloc* kallocP);
+
+#endif  // SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTARRAYMERGE_H_
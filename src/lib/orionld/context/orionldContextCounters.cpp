@@ -0,0 +1,216 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t
+#include <stdlib.h>                                              // calloc
+#include <pthread.h>                                             // pthread_mutex_t, pthread_key_t
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+#include "orionld/context/orionldContextCounters.h"              // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// COUNTER_CHUNK_SIZE - number of contexts per chunk of counters
+// COUNTER_CHUNKS     - max number of chunks per thread (contexts beyond 256k aren't counted)
+//
+#define COUNTER_CHUNK_SIZE  256
+#define COUNTER_CHUNKS      1024
+
+
+
+// -----------------------------------------------------------------------------
+//
+// CounterChunk -
+//
+typedef struct CounterChunk
+{
+  uint64_t  counter[COUNTER_CHUNK_SIZE][OrionldContextCounters];
+} CounterChunk;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// CounterBlock - the counters of one thread
+//
+// Chunks are allocated when first needed, so that the counters never move while being read.
+// When a thread exits, its block stays (with its values) and is taken by the next new thread.
+//
+typedef struct CounterBlock
+{
+  CounterChunk*         chunk[COUNTER_CHUNKS];
+  bool                  inUse;
+  struct CounterBlock*  next;
+} CounterBlock;
+
+
+
+static int                    counterIxLast  = 0;
+static CounterBlock*          blockList      = NULL;
+static pthread_mutex_t        blockMutex     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t          blockKey;
+static pthread_once_t         blockKeyOnce   = PTHREAD_ONCE_INIT;
+static __thread CounterBlock* myBlockP       = NULL;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// blockRelease - thread exit: the block goes back to the pool
+//
+static void blockRelease(void* vP)
+{
+  CounterBlock* blockP = (CounterBlock*) vP;
+
+  __atomic_store_n(&blockP->inUse, false, __ATOMIC_RELEASE);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// blockKeyCreate -
+//
+static void blockKeyCreate(void)
+{
+  if (pthread_key_create(&blockKey, blockRelease) != 0)
+    LM_E(("Internal Error (unable to create the thread key for the context counters)"));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// blockGet - the counter block of the calling thread, assigned on first use
+//
+static CounterBlock* blockGet(void)
+{
+  pthread_once(&blockKeyOnce, blockKeyCreate);
+  pthread_mutex_lock(&blockMutex);
+
+  CounterBlock* blockP;
+  for (blockP = blockList; blockP != NULL; blockP = blockP->next)
+  {
+    if (__atomic_load_n(&blockP->inUse, __ATOMIC_ACQUIRE) == false)
+      break;
+  }
+
+  if (blockP == NULL)
+  {
+    blockP = (CounterBlock*) calloc(1, sizeof(CounterBlock));
+    if (blockP == NULL)
+      LM_X(1, ("Out of memory allocating the context counters of a thread"));
+
+    blockP->next = blockList;
+    __atomic_store_n(&blockList, blockP, __ATOMIC_RELEASE);  // Readers walk the list without the mutex
+  }
+
+  blockP->inUse = true;
+  pthread_mutex_unlock(&blockMutex);
+
+  pthread_setspecific(blockKey, blockP);
+  myBlockP = blockP;
+
+  return blockP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCounterIxAssign -
+//
+int orionldContextCounterIxAssign(void)
+{
+  return __atomic_add_fetch(&counterIxLast, 1, __ATOMIC_RELAXED);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCounterIncrease -
+//
+// Only the owner thread writes its counters, the relaxed atomic load+store is there for the readers not to see
+// torn values - it compiles to plain moves, no locked instruction.
+//
+void orionldContextCounterIncrease(OrionldContext* contextP, OrionldContextCounter counter)
+{
+  if (contextP->counterIx <= 0)
+    return;
+
+  int ix      = contextP->counterIx - 1;
+  int chunkIx = ix / COUNTER_CHUNK_SIZE;
+
+  if (chunkIx >= COUNTER_CHUNKS)
+    return;
+
+  CounterBlock* blockP = (myBlockP != NULL)? myBlockP : blockGet();
+  CounterChunk* chunkP = blockP->chunk[chunkIx];
+
+  if (chunkP == NULL)
+  {
+    chunkP = (CounterChunk*) calloc(1, sizeof(CounterChunk));
+    if (chunkP == NULL)
+      return;
+
+    __atomic_store_n(&blockP->chunk[chunkIx], chunkP, __ATOMIC_RELEASE);
+  }
+
+  uint64_t* valueP = &chunkP->counter[ix % COUNTER_CHUNK_SIZE][counter];
+  __atomic_store_n(valueP, __atomic_load_n(valueP, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCounterGet -
+//
+uint64_t orionldContextCounterGet(OrionldContext* contextP, OrionldContextCounter counter)
+{
+  if (contextP->counterIx <= 0)
+    return 0;
+
+  int       ix      = contextP->counterIx - 1;
+  int       chunkIx = ix / COUNTER_CHUNK_SIZE;
+  uint64_t  sum     = 0;
+
+  if (chunkIx >= COUNTER_CHUNKS)
+    return 0;
+
+  for (CounterBlock* blockP = __atomic_load_n(&blockList, __ATOMIC_ACQUIRE); blockP != NULL; blockP = blockP->next)
+  {
+    CounterChunk* chunkP = __atomic_load_n(&blockP->chunk[chunkIx], __ATOMIC_ACQUIRE);
+
+    if (chunkP != NULL)
+      sum += __atomic_load_n(&chunkP->counter[ix % COUNTER_CHUNK_SIZE][counter], __ATOMIC_RELAXED);
+  }
+
+  return sum;
+}
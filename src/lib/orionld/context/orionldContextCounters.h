@@ -0,0 +1,74 @@
+#ifndef SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTCOUNTERS_H_
+#define SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTCOUNTERS_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldContextCounter - usage statistics of a cached context
+//
+typedef enum OrionldContextCounter
+{
+  OrionldContextLookups,       // Number of NGSI-LD requests done using this @context
+  OrionldContextExpansions,    // Number of expansions done with this @context
+  OrionldContextCompactions,   // Number of compactions done with this @context
+  OrionldContextCounters
+} OrionldContextCounter;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCounterIxAssign - give a context a set of counters
+//
+// The counters are per thread - increasing one is a plain (non-atomic) increment of a thread-local value,
+// no cache line is shared between threads. The values are summed up when read (GET /ngsi-ld/v1/jsonldContexts).
+// Only contexts that may be cached get counters (counterIx > 0), counters are never reused.
+//
+extern int orionldContextCounterIxAssign(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCounterIncrease -
+//
+extern void orionldContextCounterIncrease(OrionldContext* contextP, OrionldContextCounter counter);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCounterGet - the sum over all threads
+//
+extern uint64_t orionldContextCounterGet(OrionldContext* contextP, OrionldContextCounter counter);
+
+#endif  // SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTCOUNTERS_H_
@@ -34,6 +34,7 @@ extern "C"
 
 #include "orionld/types/OrionldContext.h"                        // OrionldContext
 #include "orionld/common/orionldState.h"                         // orionldState, kalloc
+#include "orionld/context/orionldContextCounters.h"              // orionldContextCounterIxAssign, orionldContextCounterIncrease
 
 
 
@@ -57,6 +58,7 @@ OrionldContext* orionldContextCreate(const char* url, OrionldContextOrigin origi
   contextP->parent    = NULL;
   contextP->createdAt = orionldState.requestTime;
   contextP->usedAt    = orionldState.requestTime;
+  contextP->expandMemoP = NULL;  // Created on first use (if the context is cached)
 
   // NULL URL means NOT to be saved - will live just inside the request-thread
   if (url != NULL)
@@ -70,16 +72,20 @@ OrionldContext* orionldContextCreate(const char* url, OrionldContextOrigin origi
     if (tree->type != KjString)
       ++cloned;
     contextP->tree = (tree->type != KjString)? kjClone(NULL, tree) : tree;
+
+    contextP->counterIx = orionldContextCounterIxAssign();
+    orionldContextCounterIncrease(contextP, OrionldContextLookups);
   }
   else
   {
     contextP->tree = tree;
     contextP->url  = NULL;
     contextP->id   = NULL;
+
+    contextP->counterIx = 0;  // Not cached - no statistics
   }
 
   contextP->keyValues = keyValues;
-  contextP->lookups   = 1;
 
   return contextP;
 }
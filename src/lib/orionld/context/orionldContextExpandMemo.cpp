@@ -0,0 +1,401 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint32_t, uint64_t
+#include <stdlib.h>                                              // malloc, calloc, free
+#include <string.h>                                              // strlen, strcmp, memcpy
+#include <pthread.h>                                             // pthread_mutex_*
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+#include "orionld/common/orionldState.h"                         // orionldState, contextExpandMemo
+#include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
+#include "orionld/context/orionldContextExpandMemo.h"            // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// MemoEntry -
+//
+// The short name and the long name are stored right after the struct, in the same allocation
+//
+typedef struct MemoEntry
+{
+  struct MemoEntry*  next;       // Next in bucket
+  struct MemoEntry*  newer;      // LRU list
+  struct MemoEntry*  older;      // LRU list
+  uint32_t           hash;
+  int                size;       // Bytes of the allocation
+  int                longNameLen;
+  char*              longName;
+  char               shortName[1];
+} MemoEntry;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// MemoShard -
+//
+typedef struct MemoShard
+{
+  pthread_mutex_t  mutex;
+  OrionldContext*  coreContextP;  // The Core Context the expansions were made with - reload of the Core Context invalidates them
+  MemoEntry*       bucketV[ORIONLD_EXPAND_MEMO_BUCKETS];
+  MemoEntry*       newest;
+  MemoEntry*       oldest;
+  int              entries;
+  int              bytes;
+  uint64_t         hits;
+  uint64_t         misses;
+  uint64_t         evictions;
+} MemoShard;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldContextExpandMemo -
+//
+typedef struct OrionldContextExpandMemo
+{
+  MemoShard  shardV[ORIONLD_EXPAND_MEMO_SHARDS];
+} OrionldContextExpandMemo;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// memoHash - FNV-1a
+//
+static inline uint32_t memoHash(const char* name)
+{
+  uint32_t hash = 2166136261U;
+
+  while (*name != 0)
+  {
+    hash ^= (unsigned char) *name;
+    hash *= 16777619U;
+    ++name;
+  }
+
+  return hash;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// memoShard -
+//
+static inline MemoShard* memoShard(OrionldContextExpandMemo* memoP, uint32_t hash)
+{
+  return &memoP->shardV[hash % ORIONLD_EXPAND_MEMO_SHARDS];
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// memoBucket -
+//
+static inline MemoEntry** memoBucket(MemoShard* shardP, uint32_t hash)
+{
+  return &shardP->bucketV[(hash / ORIONLD_EXPAND_MEMO_SHARDS) % ORIONLD_EXPAND_MEMO_BUCKETS];
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// memoGet - the memo of a context, created if 'create' is set
+//
+// Two threads may create the memo at the same time - the one that loses the compare-and-swap throws its memo away
+//
+static OrionldContextExpandMemo* memoGet(OrionldContext* contextP, bool create)
+{
+  if ((contextExpandMemo <= 0) || (contextP == NULL) || (contextP->counterIx == 0))
+    return NULL;
+
+  OrionldContextExpandMemo* memoP = __atomic_load_n(&contextP->expandMemoP, __ATOMIC_ACQUIRE);
+
+  if ((memoP != NULL) || (create == false))
+    return memoP;
+
+  OrionldContextExpandMemo* newP = (OrionldContextExpandMemo*) calloc(1, sizeof(OrionldContextExpandMemo));
+
+  if (newP == NULL)
+  {
+    LM_E(("Out of memory allocating the expansion memo of context '%s'", contextP->url));
+    return NULL;
+  }
+
+  for (int ix = 0; ix < ORIONLD_EXPAND_MEMO_SHARDS; ix++)
+    pthread_mutex_init(&newP->shardV[ix].mutex, NULL);
+
+  OrionldContextExpandMemo* expected = NULL;
+
+  if (__atomic_compare_exchange_n(&contextP->expandMemoP, &expected, newP, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) == false)
+  {
+    for (int ix = 0; ix < ORIONLD_EXPAND_MEMO_SHARDS; ix++)
+      pthread_mutex_destroy(&newP->shardV[ix].mutex);
+
+    free(newP);
+    return expected;
+  }
+
+  LM_T(LmtContextCacheStats, ("Created the expansion memo of context '%s'", contextP->url));
+  return newP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entryEvict - unlink and free an entry - the mutex of the shard must be taken
+//
+static void entryEvict(MemoShard* shardP, MemoEntry* entryP)
+{
+  MemoEntry** linkP = memoBucket(shardP, entryP->hash);
+
+  while (*linkP != entryP)
+    linkP = &(*linkP)->next;
+  *linkP = entryP->next;
+
+  if (entryP->newer != NULL) entryP->newer->older = entryP->older; else shardP->newest = entryP->older;
+  if (entryP->older != NULL) entryP->older->newer = entryP->newer; else shardP->oldest = entryP->newer;
+
+  shardP->entries -= 1;
+  shardP->bytes   -= entryP->size;
+
+  free(entryP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// shardValidate - if the Core Context has changed since the entries were made, they're all thrown away
+//
+// The mutex of the shard must be taken
+//
+static void shardValidate(MemoShard* shardP)
+{
+  if (shardP->coreContextP == orionldCoreContextP)
+    return;
+
+  while (shardP->oldest != NULL)
+    entryEvict(shardP, shardP->oldest);
+
+  shardP->coreContextP = orionldCoreContextP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entryLookup - the mutex of the shard must be taken
+//
+static MemoEntry* entryLookup(MemoShard* shardP, uint32_t hash, const char* shortName)
+{
+  for (MemoEntry* entryP = *memoBucket(shardP, hash); entryP != NULL; entryP = entryP->next)
+  {
+    if ((entryP->hash == hash) && (strcmp(entryP->shortName, shortName) == 0))
+      return entryP;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextExpandMemoLookup -
+//
+char* orionldContextExpandMemoLookup(OrionldContext* contextP, const char* shortName)
+{
+  OrionldContextExpandMemo* memoP = memoGet(contextP, false);
+
+  if (memoP == NULL)
+    return NULL;
+
+  uint32_t    hash     = memoHash(shortName);
+  MemoShard*  shardP   = memoShard(memoP, hash);
+  char*       longName = NULL;
+
+  pthread_mutex_lock(&shardP->mutex);
+
+  shardValidate(shardP);
+
+  MemoEntry* entryP = entryLookup(shardP, hash, shortName);
+
+  if (entryP != NULL)
+  {
+    // Move to the head of the LRU list
+    if (entryP != shardP->newest)
+    {
+      if (entryP->older != NULL) entryP->older->newer = entryP->newer; else shardP->oldest = entryP->newer;
+      entryP->newer->older = entryP->older;
+
+      entryP->older         = shardP->newest;
+      entryP->newer         = NULL;
+      shardP->newest->newer = entryP;
+      shardP->newest        = entryP;
+    }
+
+    longName = (char*) kaAlloc(&orionldState.kalloc, entryP->longNameLen + 1);
+    if (longName != NULL)
+      memcpy(longName, entryP->longName, entryP->longNameLen + 1);
+
+    shardP->hits += 1;
+  }
+  else
+    shardP->misses += 1;
+
+  pthread_mutex_unlock(&shardP->mutex);
+
+  return longName;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextExpandMemoInsert -
+//
+// Least recently used entries of the shard are evicted until the new entry fits
+//
+void orionldContextExpandMemoInsert(OrionldContext* contextP, const char* shortName, const char* longName)
+{
+  int shortNameLen = strlen(shortName);
+  int longNameLen  = strlen(longName);
+  int size         = sizeof(MemoEntry) + shortNameLen + longNameLen + 1;  // shortName[1] gives room for one of the two zeroes
+  int maxBytes     = (contextExpandMemo * 1024) / ORIONLD_EXPAND_MEMO_SHARDS;
+
+  if (size > maxBytes)
+    return;
+
+  OrionldContextExpandMemo* memoP = memoGet(contextP, true);
+
+  if (memoP == NULL)
+    return;
+
+  uint32_t    hash   = memoHash(shortName);
+  MemoShard*  shardP = memoShard(memoP, hash);
+
+  pthread_mutex_lock(&shardP->mutex);
+
+  shardValidate(shardP);
+
+  // Another thread may have been faster
+  if (entryLookup(shardP, hash, shortName) != NULL)
+  {
+    pthread_mutex_unlock(&shardP->mutex);
+    return;
+  }
+
+  while (shardP->bytes + size > maxBytes)
+  {
+    entryEvict(shardP, shardP->oldest);
+    shardP->evictions += 1;
+  }
+
+  MemoEntry* entryP = (MemoEntry*) malloc(size);
+
+  if (entryP != NULL)
+  {
+    entryP->hash        = hash;
+    entryP->size        = size;
+    entryP->longNameLen = longNameLen;
+    entryP->longName    = &entryP->shortName[shortNameLen + 1];
+
+    memcpy(entryP->shortName, shortName, shortNameLen + 1);
+    memcpy(entryP->longName,  longName,  longNameLen + 1);
+
+    MemoEntry** bucketP = memoBucket(shardP, hash);
+
+    entryP->next   = *bucketP;
+    *bucketP       = entryP;
+
+    entryP->newer  = NULL;
+    entryP->older  = shardP->newest;
+
+    if (shardP->newest != NULL)
+      shardP->newest->newer = entryP;
+    else
+      shardP->oldest = entryP;
+    shardP->newest = entryP;
+
+    shardP->entries += 1;
+    shardP->bytes   += size;
+  }
+
+  pthread_mutex_unlock(&shardP->mutex);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextExpandMemoStats -
+//
+// The memory of a memo is its entries plus the fixed part (shards with their buckets)
+//
+bool orionldContextExpandMemoStats(OrionldContext* contextP, OrionldContextExpandMemoStats* statsP)
+{
+  OrionldContextExpandMemo* memoP = memoGet(contextP, false);
+
+  if (memoP == NULL)
+    return false;
+
+  statsP->hits      = 0;
+  statsP->misses    = 0;
+  statsP->evictions = 0;
+  statsP->entries   = 0;
+  statsP->bytes     = sizeof(OrionldContextExpandMemo);
+
+  for (int ix = 0; ix < ORIONLD_EXPAND_MEMO_SHARDS; ix++)
+  {
+    MemoShard* shardP = &memoP->shardV[ix];
+
+    pthread_mutex_lock(&shardP->mutex);
+    statsP->hits      += shardP->hits;
+    statsP->misses    += shardP->misses;
+    statsP->evictions += shardP->evictions;
+    statsP->entries   += shardP->entries;
+    statsP->bytes     += shardP->bytes;
+    pthread_mutex_unlock(&shardP->mutex);
+  }
+
+  return true;
+}
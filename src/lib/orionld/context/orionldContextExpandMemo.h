@@ -0,0 +1,93 @@
+#ifndef SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTEXPANDMEMO_H_
+#define SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTEXPANDMEMO_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Expansion memo
+//
+// Names that are not terms of a context are expanded using the default URL (@vocab of the Core Context),
+// and prefixed names (prefix:rest) are expanded by concatenation. Both used to be formatted into the
+// request allocator every single time they were seen.
+//
+// The memo of a cached context keeps the result of these expansions, shared by all requests.
+// It is split in shards, each with its own mutex, bucket array and LRU list, and each shard may use
+// at most 1/ORIONLD_EXPAND_MEMO_SHARDS of the memory given by the CLI option -ctxMemo (kilobytes per context).
+//
+// A hit is copied into the request allocator (orionldState.kalloc), so, an entry can be evicted at any time
+// without anybody holding on to it.
+//
+// Contexts that are not cached (no URL - they live only inside the request) have no memo.
+//
+#define ORIONLD_EXPAND_MEMO_SHARDS   16
+#define ORIONLD_EXPAND_MEMO_BUCKETS  64  // Per shard
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldContextExpandMemoStats -
+//
+typedef struct OrionldContextExpandMemoStats
+{
+  uint64_t  hits;
+  uint64_t  misses;
+  uint64_t  evictions;
+  int       entries;
+  int       bytes;
+} OrionldContextExpandMemoStats;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextExpandMemoLookup - returns a copy (in orionldState.kalloc) of the expansion of 'shortName', or NULL
+//
+extern char* orionldContextExpandMemoLookup(OrionldContext* contextP, const char* shortName);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextExpandMemoInsert -
+//
+extern void orionldContextExpandMemoInsert(OrionldContext* contextP, const char* shortName, const char* longName);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextExpandMemoStats - false if the context has no memo
+//
+extern bool orionldContextExpandMemoStats(OrionldContext* contextP, OrionldContextExpandMemoStats* statsP);
+
+#endif  // SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTEXPANDMEMO_H_
@@ -34,6 +34,14 @@ extern "C"
 
 
 
+// -----------------------------------------------------------------------------
+//
+// hashCode - hash function of the name and value hash tables of a context
+//
+extern unsigned int hashCode(const char* name);
+
+
+
 // -----------------------------------------------------------------------------
 //
 // orionldContextFromObject -
@@ -41,6 +41,7 @@ extern "C"
 #include "orionld/context/orionldContextFromUrl.h"               // orionldContextFromUrl
 #include "orionld/context/orionldContextFromObject.h"            // orionldContextFromObject
 #include "orionld/context/orionldContextCreate.h"                // orionldContextCreate
+#include "orionld/context/orionldContextArrayMerge.h"            // orionldContextArrayMerge
 #include "orionld/contextCache/orionldContextCacheLookup.h"      // orionldContextCacheLookup
 #include "orionld/contextCache/orionldContextCacheInsert.h"      // orionldContextCacheInsert
 #include "orionld/context/orionldContextFromTree.h"              // Own interface
@@ -88,8 +89,10 @@ OrionldContext* orionldContextFromTree(char* url, OrionldContextOrigin origin, c
     }
 
 
-    contextP->context.array.items     = itemsInArray;
-    contextP->context.array.vector    = (OrionldContext**) kaAlloc(&kalloc, itemsInArray * sizeof(OrionldContext*));
+    contextP->context.array.items          = itemsInArray;
+    contextP->context.array.vector         = (OrionldContext**) kaAlloc(&kalloc, itemsInArray * sizeof(OrionldContext*));
+    contextP->context.array.nameHashTable  = NULL;
+    contextP->context.array.valueHashTable = NULL;
 
     int ix = 0;
     for (KjNode* ctxItemP = contextTreeP->value.firstChildP; ctxItemP != NULL; ctxItemP = ctxItemP->next)
@@ -134,8 +137,15 @@ OrionldContext* orionldContextFromTree(char* url, OrionldContextOrigin origin, c
       ++ix;
     }
 
+    //
+    // Arrays that go to the cache get their terms merged, for single-probe lookups.
+    // Not worth it for an inline array of a single request, where the lookups simply go through the contexts of the array
+    //
     if (arrayToCache == true)
+    {
+      orionldContextArrayMerge(contextP, &kalloc);
       orionldContextCacheInsert(contextP);
+    }
 
     return contextP;
   }
@@ -149,9 +159,11 @@ OrionldContext* orionldContextFromTree(char* url, OrionldContextOrigin origin, c
       {
         contextP = orionldContextCreate(url, origin, id, contextTreeP, false);
 
-        contextP->context.array.items     = 1;
-        contextP->context.array.vector    = (OrionldContext**) kaAlloc(&kalloc, 1 * sizeof(OrionldContext*));
-        contextP->context.array.vector[0] = orionldContextFromUrl(contextTreeP->value.s, NULL);
+        contextP->context.array.items          = 1;
+        contextP->context.array.vector         = (OrionldContext**) kaAlloc(&kalloc, 1 * sizeof(OrionldContext*));
+        contextP->context.array.vector[0]      = orionldContextFromUrl(contextTreeP->value.s, NULL);
+        contextP->context.array.nameHashTable  = NULL;
+        contextP->context.array.valueHashTable = NULL;
 
         if (contextP->context.array.vector[0] == NULL)
           LM_RE(NULL, ("Context Error from orionldContextFromUrl"));
@@ -31,6 +31,7 @@
 #include "orionld/types/OrionldContextItem.h"                    // OrionldContextItem
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP, orionldDefaultUrl, orionldDefaultUrlLen
 #include "orionld/context/orionldContextItemValueLookup.h"       // orionldContextItemValueLookup
+#include "orionld/context/orionldContextCounters.h"              // orionldContextCounterIncrease
 #include "orionld/context/orionldContextItemAliasLookup.h"       // Own Interface
 
 
@@ -65,7 +66,7 @@ char* orionldContextItemAliasLookup
   // 1. Is it the default URL?
   if (strncmp(longName, orionldDefaultUrl, orionldDefaultUrlLen) == 0)
   {
-    orionldCoreContextP->compactions += 1;
+    orionldContextCounterIncrease(orionldCoreContextP, OrionldContextCompactions);
     return (char*) &longName[orionldDefaultUrlLen];
   }
 
@@ -96,6 +97,6 @@ char* orionldContextItemAliasLookup
     *contextItemPP = contextItemP;
 
   // Return the short name
-  contextP->compactions += 1;
+  orionldContextCounterIncrease(contextP, OrionldContextCompactions);
   return contextItemP->name;
 }
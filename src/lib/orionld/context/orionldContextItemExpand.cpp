@@ -33,6 +33,8 @@
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
 #include "orionld/context/orionldContextPrefixExpand.h"          // orionldContextPrefixExpand
 #include "orionld/context/orionldContextItemLookup.h"            // orionldContextItemLookup
+#include "orionld/context/orionldContextCounters.h"              // orionldContextCounterIncrease
+#include "orionld/context/orionldContextExpandMemo.h"            // orionldContextExpandMemoLookup, orionldContextExpandMemoInsert
 #include "orionld/context/orionldContextItemExpand.h"            // Own interface
 
 
@@ -53,6 +55,7 @@
 //   If no expansion is found, and the default URL has been used, then room is allocated using
 //   kaAlloc, allocating on orionldState.kalloc, the connection buffer that lives only during
 //   the current request. It is liberated "automatically" when the thread exits.
+//   The expansion memo of the context (orionldContextExpandMemo.h) saves the formatting of the long name.
 //
 //   If the expansion IS found, then a pointer to the longname (that is part of the context where it was found)
 //   is returned and we save some time by not copying anything.
@@ -87,16 +90,23 @@ char* orionldContextItemExpand
   {
     if (useDefaultUrlIfNotFound == true)
     {
-      int   shortNameLen = strlen(shortName);
-      int   longNameLen  = orionldDefaultUrlLen + shortNameLen + 1;
-      char* longName     = (char*) kaAlloc(&orionldState.kalloc, longNameLen);
+      char* longName = orionldContextExpandMemoLookup(contextP, shortName);
 
-      snprintf(longName, longNameLen, "%s%s", orionldDefaultUrl, shortName);
+      if (longName == NULL)
+      {
+        int   shortNameLen = strlen(shortName);
+        int   longNameLen  = orionldDefaultUrlLen + shortNameLen + 1;
+
+        longName = (char*) kaAlloc(&orionldState.kalloc, longNameLen);
+        snprintf(longName, longNameLen, "%s%s", orionldDefaultUrl, shortName);
+
+        orionldContextExpandMemoInsert(contextP, shortName, longName);
+      }
 
       if (contextItemPP != NULL)
         *contextItemPP = NULL;
 
-      orionldCoreContextP->expansions += 1;  // Really, @vocab expansions of the core context
+      orionldContextCounterIncrease(orionldCoreContextP, OrionldContextExpansions);  // Really, @vocab expansions of the core context
 
       return longName;
     }
@@ -108,7 +118,7 @@ char* orionldContextItemExpand
   if (contextItemPP != NULL)
     *contextItemPP = contextItemP;
 
-  contextP->expansions += 1;  // Really, @vocab expansions of the core context
+  orionldContextCounterIncrease(contextP, OrionldContextExpansions);  // Really, @vocab expansions of the core context
 
   return contextItemP->id;
 }
@@ -36,6 +36,8 @@ extern "C"
 #include "orionld/types/OrionldContextItem.h"                    // OrionldContextItem
 #include "orionld/types/OrionldContext.h"                        // OrionldContext
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
+#include "orionld/context/orionldCoreContextHash.h"              // orionldCoreContextHashP, orionldCoreContextNameLookup
+#include "orionld/context/orionldContextCounters.h"              // orionldContextCounterIncrease
 #include "orionld/context/orionldContextItemLookup.h"            // Own interface
 
 
@@ -51,11 +53,16 @@ OrionldContextItem* orionldContextItemLookup(OrionldContext* contextP, const cha
   if (contextP == NULL)
     contextP = orionldCoreContextP;
 
-  if (contextP->keyValues == true)
+  if (contextP == orionldCoreContextHashP)
+    itemP = orionldCoreContextNameLookup(name);  // Perfect hash
+  else if (contextP->keyValues == true)
     itemP = (OrionldContextItem*) khashItemLookup(contextP->context.hash.nameHashTable, name);
+  else if (contextP->context.array.nameHashTable != NULL)
+    itemP = (OrionldContextItem*) khashItemLookup(contextP->context.array.nameHashTable, name);  // Merged - see orionldContextArrayMerge
   else
   {
-    for (int ix = 0; ix < contextP->context.array.items; ++ix)
+    // From the last context of the array to the first - the last definition wins (JSON-LD), just like in the merged tables
+    for (int ix = contextP->context.array.items - 1; ix >= 0; --ix)
     {
       if ((itemP = orionldContextItemLookup(contextP->context.array.vector[ix], name, valueMayBeCompactedP)) != NULL)
         break;
@@ -64,7 +71,7 @@ OrionldContextItem* orionldContextItemLookup(OrionldContext* contextP, const cha
 
   if (itemP != NULL)
   {
-    contextP->expansions += 1;
+    orionldContextCounterIncrease(contextP, OrionldContextExpansions);
 
     if (valueMayBeCompactedP != NULL)
     {
@@ -29,6 +29,7 @@
 
 #include "orionld/types/OrionldContext.h"                        // OrionldContext
 #include "orionld/types/OrionldContextItem.h"                    // OrionldContextItem
+#include "orionld/context/orionldCoreContextHash.h"              // orionldCoreContextHashP, orionldCoreContextValueLookup
 
 
 
@@ -42,11 +43,16 @@ OrionldContextItem* orionldContextItemValueLookup(OrionldContext* contextP, cons
 
   if (contextP == NULL)
     return NULL;
+  else if (contextP == orionldCoreContextHashP)
+    itemP = orionldCoreContextValueLookup(longname);  // Perfect hash
   else if (contextP->keyValues == true)
     itemP = (OrionldContextItem*) khashItemLookup(contextP->context.hash.valueHashTable, longname);
+  else if (contextP->context.array.valueHashTable != NULL)
+    itemP = (OrionldContextItem*) khashItemLookup(contextP->context.array.valueHashTable, longname);  // Merged - see orionldContextArrayMerge
   else
   {
-    for (int ix = 0; ix < contextP->context.array.items; ++ix)
+    // From the last context of the array to the first - the last definition wins (JSON-LD), just like in the merged tables
+    for (int ix = contextP->context.array.items - 1; ix >= 0; --ix)
     {
       if ((itemP = orionldContextItemValueLookup(contextP->context.array.vector[ix], longname)) != NULL)
         break;
@@ -0,0 +1,976 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // FILE, fopen, fgets, fclose
+#include <stdlib.h>                                              // malloc, realloc, calloc, free
+#include <string.h>                                              // strdup, strcmp, strncpy, strlen
+#include <strings.h>                                             // strncasecmp
+#include <errno.h>                                               // ETIMEDOUT
+#include <unistd.h>                                              // sleep
+#include <time.h>                                                // clock_gettime
+#include <pthread.h>                                             // pthread_*
+#include <curl/curl.h>                                           // curl_easy_*
+
+extern "C"
+{
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kalloc/kaBufferReset.h"                                // kaBufferReset
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+#include "orionld/types/OrionldResponseErrorType.h"              // OrionldResponseErrorType
+#include "orionld/common/orionldState.h"                         // orionldState, contextDownloadAttempts, contextDownloadTimeout, ...
+#include "orionld/common/orionldError.h"                         // orionldError
+#include "orionld/common/urlParse.h"                             // urlParse
+#include "orionld/mongoc/mongocConnectionRelease.h"              // mongocConnectionRelease
+#include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
+#include "orionld/context/orionldContextFromBuffer.h"            // orionldContextFromBuffer
+#include "orionld/contextCache/orionldContextCacheLookup.h"      // orionldContextCacheLookup
+#include "orionld/contextCache/orionldContextCacheInsert.h"      // orionldContextCacheInsert
+#include "orionld/contextCache/orionldContextCacheRemove.h"      // orionldContextCacheRemove
+#include "orionld/contextCache/orionldContextCacheDelete.h"      // orionldContextCacheRetire
+#include "orionld/contextCache/orionldContextCachePersist.h"     // orionldContextCachePersist
+#include "orionld/context/orionldContextLoader.h"                // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// CONTEXT_LOADER_THREADS -
+//
+#define CONTEXT_LOADER_THREADS  4
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ContextLoadType -
+//
+typedef enum ContextLoadType
+{
+  ContextLoadDownload,
+  ContextLoadRevalidate
+} ContextLoadType;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ContextLoad - a download in flight
+//
+// The job is in the in-flight list until it's done, so that anybody needing the same URL waits for it
+// instead of starting a download of its own.
+// It is freed by the last one out - the executor or the last of the waiters.
+//
+typedef struct ContextLoad
+{
+  char*                     url;
+  char*                     id;
+  ContextLoadType           type;
+  bool                      started;
+  bool                      done;
+  int                       refs;         // The executor plus the waiters
+  OrionldContext*           contextP;     // The result
+  OrionldResponseErrorType  errorType;
+  char                      errorTitle[128];
+  char                      errorDetail[512];
+  int                       errorStatus;
+  struct ContextLoad*       next;         // In-flight list
+  struct ContextLoad*       queueNext;    // Queue of the loader threads
+} ContextLoad;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ContextSource - a downloaded context and its validators, for revalidation
+//
+typedef struct ContextSource
+{
+  char*                  url;
+  char                   etag[256];
+  char                   lastModified[64];
+  struct ContextSource*  next;
+} ContextSource;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ContextResponse -
+//
+typedef struct ContextResponse
+{
+  char*  buf;
+  int    size;
+  int    used;
+  char   etag[256];
+  char   lastModified[64];
+} ContextResponse;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Loader state - all protected by loaderMutex
+//
+static pthread_mutex_t  loaderMutex     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   loaderQueueCond = PTHREAD_COND_INITIALIZER;   // Signalled when a job is queued
+static pthread_cond_t   loaderDoneCond  = PTHREAD_COND_INITIALIZER;   // Broadcast when a job is done
+static ContextLoad*     inFlightList    = NULL;
+static ContextLoad*     queueFirst      = NULL;
+static ContextLoad*     queueLast       = NULL;
+static ContextSource*   sourceList      = NULL;
+static int              loaderThreads   = 0;
+static __thread bool    loaderThread    = false;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// bodyWrite - curl write callback
+//
+static size_t bodyWrite(char* data, size_t size, size_t nmemb, void* userP)
+{
+  ContextResponse* rP    = (ContextResponse*) userP;
+  int              bytes = size * nmemb;
+
+  if (rP->used + bytes + 1 > rP->size)
+  {
+    int   newSize = (rP->size == 0)? 4096 : rP->size * 2;
+    char* newBuf;
+
+    while (rP->used + bytes + 1 > newSize)
+      newSize *= 2;
+
+    if ((newBuf = (char*) realloc(rP->buf, newSize)) == NULL)
+      return 0;  // Makes curl fail the transfer
+
+    rP->buf  = newBuf;
+    rP->size = newSize;
+  }
+
+  memcpy(&rP->buf[rP->used], data, bytes);
+  rP->used += bytes;
+  rP->buf[rP->used] = 0;
+
+  return bytes;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// headerValueCopy - copy the value of a header line, without leading spaces and trailing CR/LF
+//
+static void headerValueCopy(char* to, int toSize, const char* value, int valueLen)
+{
+  while ((valueLen > 0) && (*value == ' '))
+  {
+    ++value;
+    --valueLen;
+  }
+
+  while ((valueLen > 0) && ((value[valueLen - 1] == '\r') || (value[valueLen - 1] == '\n') || (value[valueLen - 1] == ' ')))
+    --valueLen;
+
+  if (valueLen >= toSize)  // Too long - useless as validator
+    valueLen = 0;
+
+  memcpy(to, value, valueLen);
+  to[valueLen] = 0;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// headerRead - curl header callback - picks up the validators of the response
+//
+static size_t headerRead(char* data, size_t size, size_t nmemb, void* userP)
+{
+  ContextResponse* rP    = (ContextResponse*) userP;
+  int              bytes = size * nmemb;
+
+  if ((bytes > 5) && (strncasecmp(data, "ETag:", 5) == 0))
+    headerValueCopy(rP->etag, sizeof(rP->etag), &data[5], bytes - 5);
+  else if ((bytes > 14) && (strncasecmp(data, "Last-Modified:", 14) == 0))
+    headerValueCopy(rP->lastModified, sizeof(rP->lastModified), &data[14], bytes - 14);
+
+  return bytes;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextGet - GET a context, conditionally if validators are given
+//
+// Transport errors and 5xx responses are retried, -ctxAttempts times in total.
+// Returns the HTTP status code, or 0 if no response was obtained.
+//
+static long contextGet(const char* url, const char* etag, const char* lastModified, ContextResponse* rP)
+{
+  for (int tries = 0; tries < contextDownloadAttempts; tries++)
+  {
+    CURL* curlP = curl_easy_init();
+
+    if (curlP == NULL)
+    {
+      LM_E(("Internal Error (Unable to obtain CURL context)"));
+      return 0;
+    }
+
+    struct curl_slist* headers = NULL;
+    char               header[300];
+
+    headers = curl_slist_append(headers, "Accept: application/ld+json");
+
+    if ((etag != NULL) && (etag[0] != 0))
+    {
+      snprintf(header, sizeof(header), "If-None-Match: %s", etag);
+      headers = curl_slist_append(headers, header);
+    }
+
+    if ((lastModified != NULL) && (lastModified[0] != 0))
+    {
+      snprintf(header, sizeof(header), "If-Modified-Since: %s", lastModified);
+      headers = curl_slist_append(headers, header);
+    }
+
+    rP->used            = 0;
+    rP->etag[0]         = 0;
+    rP->lastModified[0] = 0;
+
+    curl_easy_setopt(curlP, CURLOPT_URL,            url);
+    curl_easy_setopt(curlP, CURLOPT_HTTPGET,        1L);
+    curl_easy_setopt(curlP, CURLOPT_HTTPHEADER,     headers);
+    curl_easy_setopt(curlP, CURLOPT_WRITEFUNCTION,  bodyWrite);
+    curl_easy_setopt(curlP, CURLOPT_WRITEDATA,      rP);
+    curl_easy_setopt(curlP, CURLOPT_HEADERFUNCTION, headerRead);
+    curl_easy_setopt(curlP, CURLOPT_HEADERDATA,     rP);
+    curl_easy_setopt(curlP, CURLOPT_TIMEOUT_MS,     (long) contextDownloadTimeout);
+    curl_easy_setopt(curlP, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curlP, CURLOPT_NOSIGNAL,       1L);
+
+    long     status = 0;
+    CURLcode cCode  = curl_easy_perform(curlP);
+
+    if (cCode == CURLE_OK)
+      curl_easy_getinfo(curlP, CURLINFO_RESPONSE_CODE, &status);
+
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curlP);
+
+    if ((cCode == CURLE_OK) && (status < 500))
+      return status;
+
+    LM_E(("Download of @context '%s' failed (try number %d out of %d. Timeout is: %dms): %s (HTTP status %ld)",
+          url, tries + 1, contextDownloadAttempts, contextDownloadTimeout, curl_easy_strerror(cCode), status));
+  }
+
+  return 0;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// sourceLookup - loaderMutex must be taken
+//
+static ContextSource* sourceLookup(const char* url)
+{
+  for (ContextSource* sourceP = sourceList; sourceP != NULL; sourceP = sourceP->next)
+  {
+    if (strcmp(sourceP->url, url) == 0)
+      return sourceP;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// sourceSet - remember the validators of a downloaded context
+//
+static void sourceSet(const char* url, ContextResponse* rP)
+{
+  pthread_mutex_lock(&loaderMutex);
+
+  ContextSource* sourceP = sourceLookup(url);
+
+  if (sourceP == NULL)
+  {
+    if ((sourceP = (ContextSource*) calloc(1, sizeof(ContextSource))) != NULL)
+    {
+      sourceP->url  = strdup(url);
+      sourceP->next = sourceList;
+      sourceList    = sourceP;
+    }
+  }
+
+  if (sourceP != NULL)
+  {
+    strncpy(sourceP->etag,         rP->etag,         sizeof(sourceP->etag) - 1);
+    strncpy(sourceP->lastModified, rP->lastModified, sizeof(sourceP->lastModified) - 1);
+  }
+
+  pthread_mutex_unlock(&loaderMutex);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// sourceRemove - the context is no longer cached, or its server can't tell whether it has changed
+//
+static void sourceRemove(const char* url)
+{
+  pthread_mutex_lock(&loaderMutex);
+
+  ContextSource** linkP = &sourceList;
+
+  while (*linkP != NULL)
+  {
+    ContextSource* sourceP = *linkP;
+
+    if (strcmp(sourceP->url, url) == 0)
+    {
+      *linkP = sourceP->next;
+      free(sourceP->url);
+      free(sourceP);
+      break;
+    }
+
+    linkP = &sourceP->next;
+  }
+
+  pthread_mutex_unlock(&loaderMutex);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextDownload - download, parse, cache and persist a context
+//
+static OrionldContext* contextDownload(const char* url, const char* id)
+{
+  char        protocol[16];
+  char        ip[256];
+  uint16_t    port    = 0;
+  char*       urlPath = NULL;
+
+  if ((url == NULL || *url == 0))
+  {
+    orionldState.pd.type   = OrionldBadRequestData;
+    orionldState.pd.title  = (char*) "Invalid @context";
+    orionldState.pd.detail = (char*) ((url == NULL)? "Null @context" : "Empty @context");
+    orionldState.pd.status = 400;
+
+    return NULL;
+  }
+
+  if (urlParse(url, protocol, sizeof(protocol), ip, sizeof(ip), &port, &urlPath, &orionldState.pd.detail) == false)
+  {
+    // orionldState.pd.detail set by urlParse
+    orionldState.pd.type   = OrionldBadRequestData;
+    orionldState.pd.title  = (char*) "Invalid @context";
+    orionldState.pd.status = 400;
+
+    return NULL;
+  }
+
+  LM_T(LmtContextDownload, ("Downloading the context '%s' and adding it to the context cache", url));
+
+  ContextResponse  response = { NULL, 0, 0, { 0 }, { 0 } };
+  long             status   = contextGet(url, NULL, NULL, &response);
+
+  if ((status < 200) || (status >= 300) || (response.buf == NULL))
+  {
+    free(response.buf);
+
+    orionldState.pd.type   = OrionldLdContextNotAvailable;
+    orionldState.pd.title  = (char*) "Unable to download context";
+    orionldState.pd.detail = kaStrdup(&orionldState.kalloc, url);
+    orionldState.pd.status = 503;
+
+    LM_E(("Context Error (%s: %s)", orionldState.pd.title, orionldState.pd.detail));
+    return NULL;
+  }
+
+  OrionldContext* contextP = orionldContextFromBuffer((char*) url, OrionldContextDownloaded, (char*) id, response.buf);
+  free(response.buf);
+
+  if (contextP == NULL)
+  {
+    LM_E(("Context Error (%s: %s)", orionldState.pd.title, orionldState.pd.detail));
+    return NULL;
+  }
+
+  contextP->origin = OrionldContextDownloaded;
+  contextP->usedAt = orionldState.requestTime;
+
+  orionldContextCachePersist(contextP);
+
+  if ((response.etag[0] != 0) || (response.lastModified[0] != 0))
+    sourceSet(url, &response);
+
+  return contextP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextRevalidate - conditional GET of a cached context, replacing it in the cache if it has changed
+//
+// Just like a reload (DELETE /jsonldContexts/{id}?reload=true), contexts of which the revalidated context
+// is part (arrays) keep pointing to the old version.
+// The new version isn't persisted - the old one still is, and it is revalidated after a restart.
+//
+static OrionldContext* contextRevalidate(const char* url)
+{
+  OrionldContext* oldContextP = orionldContextCacheLookup(url);
+  char            etag[256];
+  char            lastModified[64];
+
+  if ((oldContextP == NULL) || (oldContextP == orionldCoreContextP))
+  {
+    sourceRemove(url);
+    return oldContextP;
+  }
+
+  pthread_mutex_lock(&loaderMutex);
+  ContextSource* sourceP = sourceLookup(url);
+  if (sourceP != NULL)
+  {
+    strncpy(etag,         sourceP->etag,         sizeof(etag));
+    strncpy(lastModified, sourceP->lastModified, sizeof(lastModified));
+  }
+  pthread_mutex_unlock(&loaderMutex);
+
+  if (sourceP == NULL)
+    return oldContextP;
+
+  ContextResponse  response = { NULL, 0, 0, { 0 }, { 0 } };
+  long             status   = contextGet(url, etag, lastModified, &response);
+
+  if (status == 304)
+  {
+    LM_T(LmtContextDownload, ("The context '%s' has not changed", url));
+    free(response.buf);
+    return oldContextP;
+  }
+
+  if ((status < 200) || (status >= 300) || (response.buf == NULL))
+  {
+    LM_W(("Unable to revalidate the context '%s' (HTTP status %ld) - the cached copy is kept", url, status));
+    free(response.buf);
+    return oldContextP;
+  }
+
+  LM_T(LmtContextDownload, ("The context '%s' has changed - replacing it in the context cache", url));
+
+  if (orionldContextCacheRemove(oldContextP) == false)  // Deleted meanwhile
+  {
+    free(response.buf);
+    sourceRemove(url);
+    return NULL;
+  }
+
+  OrionldContext* contextP = orionldContextFromBuffer((char*) url, OrionldContextDownloaded, oldContextP->id, response.buf);
+  free(response.buf);
+
+  if (contextP == NULL)
+  {
+    LM_W(("Invalid new version of the context '%s' (%s: %s) - the cached copy is kept", url, orionldState.pd.title, orionldState.pd.detail));
+    orionldContextCacheInsert(oldContextP);
+    return oldContextP;
+  }
+
+  contextP->origin    = OrionldContextDownloaded;
+  contextP->kind      = oldContextP->kind;
+  contextP->createdAt = oldContextP->createdAt;
+  contextP->usedAt    = oldContextP->usedAt;
+
+  if ((response.etag[0] != 0) || (response.lastModified[0] != 0))
+    sourceSet(url, &response);
+  else
+    sourceRemove(url);
+
+  // Free the kj tree of the now obsolete old context (once no lookup can be looking at it)
+  orionldContextCacheRetire(oldContextP);
+
+  return contextP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// jobCreate - loaderMutex must be taken
+//
+static ContextLoad* jobCreate(const char* url, const char* id, ContextLoadType type)
+{
+  ContextLoad* jobP = (ContextLoad*) calloc(1, sizeof(ContextLoad));
+
+  if (jobP == NULL)
+    LM_X(1, ("Out of memory allocating a context download job"));
+
+  jobP->url  = strdup(url);
+  jobP->id   = (id != NULL)? strdup(id) : NULL;
+  jobP->type = type;
+  jobP->refs = 1;  // The executor
+
+  jobP->next   = inFlightList;
+  inFlightList = jobP;
+
+  return jobP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// jobEnqueue - loaderMutex must be taken
+//
+static void jobEnqueue(ContextLoad* jobP)
+{
+  jobP->queueNext = NULL;
+
+  if (queueLast == NULL)
+    queueFirst = jobP;
+  else
+    queueLast->queueNext = jobP;
+
+  queueLast = jobP;
+
+  pthread_cond_signal(&loaderQueueCond);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// jobDequeue - take a job that hasn't started out of the queue - loaderMutex must be taken
+//
+static void jobDequeue(ContextLoad* jobP)
+{
+  ContextLoad* prevP = NULL;
+
+  for (ContextLoad* iterP = queueFirst; iterP != NULL; iterP = iterP->queueNext)
+  {
+    if (iterP == jobP)
+    {
+      if (prevP == NULL)
+        queueFirst = jobP->queueNext;
+      else
+        prevP->queueNext = jobP->queueNext;
+
+      if (queueLast == jobP)
+        queueLast = prevP;
+
+      return;
+    }
+
+    prevP = iterP;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// inFlightLookup - loaderMutex must be taken
+//
+static ContextLoad* inFlightLookup(const char* url)
+{
+  for (ContextLoad* jobP = inFlightList; jobP != NULL; jobP = jobP->next)
+  {
+    if (strcmp(jobP->url, url) == 0)
+      return jobP;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// jobRelease - loaderMutex must be taken
+//
+static void jobRelease(ContextLoad* jobP)
+{
+  jobP->refs -= 1;
+
+  if (jobP->refs > 0)
+    return;
+
+  free(jobP->url);
+  free(jobP->id);
+  free(jobP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// jobExecute - run a job in the calling thread and hand the result to the waiters
+//
+static OrionldContext* jobExecute(ContextLoad* jobP)
+{
+  OrionldContext* contextP;
+
+  if (jobP->type == ContextLoadDownload)
+    contextP = contextDownload(jobP->url, jobP->id);
+  else
+    contextP = contextRevalidate(jobP->url);
+
+  pthread_mutex_lock(&loaderMutex);
+
+  jobP->contextP = contextP;
+  if (contextP == NULL)
+  {
+    jobP->errorType   = orionldState.pd.type;
+    jobP->errorStatus = orionldState.pd.status;
+    strncpy(jobP->errorTitle,  (orionldState.pd.title  != NULL)? orionldState.pd.title  : "Unable to download context", sizeof(jobP->errorTitle) - 1);
+    strncpy(jobP->errorDetail, (orionldState.pd.detail != NULL)? orionldState.pd.detail : jobP->url,                    sizeof(jobP->errorDetail) - 1);
+  }
+
+  // Out of the in-flight list
+  ContextLoad** linkP = &inFlightList;
+  while (*linkP != jobP)
+    linkP = &(*linkP)->next;
+  *linkP = jobP->next;
+
+  jobP->done = true;
+  pthread_cond_broadcast(&loaderDoneCond);
+  jobRelease(jobP);
+
+  pthread_mutex_unlock(&loaderMutex);
+
+  return contextP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// jobCleanup - free what a job has allocated in the thread's state (kalloc, mongo connection)
+//
+static void jobCleanup(void)
+{
+  if (orionldState.mongoc.contextsP != NULL)
+  {
+    mongoc_collection_destroy(orionldState.mongoc.contextsP);
+    orionldState.mongoc.contextsP = NULL;
+  }
+
+  mongocConnectionRelease();
+
+  kaBufferReset(&orionldState.kalloc, true);
+  orionldStateRelease();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextLoaderThread -
+//
+static void* contextLoaderThread(void* vP)
+{
+  loaderThread = true;
+
+  while (1)
+  {
+    pthread_mutex_lock(&loaderMutex);
+
+    while (queueFirst == NULL)
+      pthread_cond_wait(&loaderQueueCond, &loaderMutex);
+
+    ContextLoad* jobP = queueFirst;
+
+    queueFirst = jobP->queueNext;
+    if (queueFirst == NULL)
+      queueLast = NULL;
+
+    jobP->started = true;
+    pthread_mutex_unlock(&loaderMutex);
+
+    orionldStateInit(NULL);
+    jobExecute(jobP);
+    jobCleanup();
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextRevalidateThread - every -ctxRevalidate seconds, queue a revalidation of all downloaded contexts
+//
+static void* contextRevalidateThread(void* vP)
+{
+  while (1)
+  {
+    sleep(contextRevalidation);
+
+    pthread_mutex_lock(&loaderMutex);
+
+    int jobs = 0;
+    for (ContextSource* sourceP = sourceList; sourceP != NULL; sourceP = sourceP->next)
+    {
+      if (inFlightLookup(sourceP->url) != NULL)
+        continue;
+
+      jobEnqueue(jobCreate(sourceP->url, NULL, ContextLoadRevalidate));
+      ++jobs;
+    }
+
+    pthread_mutex_unlock(&loaderMutex);
+
+    LM_T(LmtContextDownload, ("Queued %d @context revalidations", jobs));
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextWarmup - queue a download of each URL in the warm-up file (one URL per line, # for comments)
+//
+static void contextWarmup(const char* path)
+{
+  FILE* fP = fopen(path, "r");
+
+  if (fP == NULL)
+  {
+    LM_W(("Unable to open the @context warm-up file '%s'", path));
+    return;
+  }
+
+  char line[1024];
+  int  jobs = 0;
+
+  while (fgets(line, sizeof(line), fP) != NULL)
+  {
+    char* url = line;
+    int   len;
+
+    while ((*url == ' ') || (*url == '\t'))
+      ++url;
+
+    len = strlen(url);
+    while ((len > 0) && ((url[len - 1] == '\n') || (url[len - 1] == '\r') || (url[len - 1] == ' ') || (url[len - 1] == '\t')))
+      url[--len] = 0;
+
+    if ((len == 0) || (*url == '#'))
+      continue;
+
+    pthread_mutex_lock(&loaderMutex);
+
+    if ((orionldContextCacheLookup(url) == NULL) && (inFlightLookup(url) == NULL))
+    {
+      jobEnqueue(jobCreate(url, NULL, ContextLoadDownload));
+      ++jobs;
+    }
+
+    pthread_mutex_unlock(&loaderMutex);
+  }
+
+  fclose(fP);
+  LM_T(LmtContextDownload, ("Queued %d @context downloads from the warm-up file '%s'", jobs, path));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextLoaderStart -
+//
+bool orionldContextLoaderStart(void)
+{
+  pthread_t tid;
+
+  for (int ix = 0; ix < CONTEXT_LOADER_THREADS; ix++)
+  {
+    if (pthread_create(&tid, NULL, contextLoaderThread, NULL) != 0)
+    {
+      LM_E(("Internal Error (unable to create a context loader thread)"));
+      return false;
+    }
+
+    pthread_detach(tid);
+  }
+
+  pthread_mutex_lock(&loaderMutex);
+  loaderThreads = CONTEXT_LOADER_THREADS;
+  pthread_mutex_unlock(&loaderMutex);
+
+  if (contextWarmupFile[0] != 0)
+    contextWarmup(contextWarmupFile);
+
+  if (contextRevalidation > 0)
+  {
+    if (pthread_create(&tid, NULL, contextRevalidateThread, NULL) != 0)
+    {
+      LM_E(("Internal Error (unable to create the context revalidation thread)"));
+      return false;
+    }
+
+    pthread_detach(tid);
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextLoaderLoad -
+//
+OrionldContext* orionldContextLoaderLoad(const char* url, const char* id)
+{
+  OrionldContext* contextP;
+
+  pthread_mutex_lock(&loaderMutex);
+
+  ContextLoad* jobP = inFlightLookup(url);
+
+  if (jobP == NULL)
+  {
+    // The download may have finished after the caller looked the context up in the cache
+    if ((contextP = orionldContextCacheLookup(url)) != NULL)
+    {
+      pthread_mutex_unlock(&loaderMutex);
+      return contextP;
+    }
+
+    jobP = jobCreate(url, id, ContextLoadDownload);
+
+    if ((loaderThreads == 0) || (loaderThread == true))
+    {
+      // No loader threads yet (broker startup) or a context inside a context that is being loaded - done right here
+      LM_T(LmtContextDownload, ("The context '%s' is downloaded by the calling thread", url));
+      jobP->started = true;
+      pthread_mutex_unlock(&loaderMutex);
+
+      return jobExecute(jobP);  // orionldState.pd is filled in by the download itself
+    }
+
+    jobEnqueue(jobP);
+  }
+  else if ((loaderThread == true) && (jobP->started == false))
+  {
+    // A loader thread must not wait for a job that is still queued - all loader threads could end up waiting
+    LM_T(LmtContextDownload, ("The context '%s' is queued - downloaded right here instead", url));
+    jobDequeue(jobP);
+    jobP->started = true;
+    pthread_mutex_unlock(&loaderMutex);
+
+    return jobExecute(jobP);
+  }
+
+  //
+  // Wait for the job to finish - for as long as all attempts of a download can take, plus three seconds
+  //
+  struct timespec  deadline;
+  long long        waitMs = (long long) contextDownloadTimeout * ((contextDownloadAttempts > 0)? contextDownloadAttempts : 1) + 3000;
+
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec  += waitMs / 1000;
+  deadline.tv_nsec += (waitMs % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000)
+  {
+    deadline.tv_sec  += 1;
+    deadline.tv_nsec -= 1000000000;
+  }
+
+  LM_T(LmtContextDownload, ("The context '%s' is being downloaded - awaiting the result", url));
+  jobP->refs += 1;
+
+  while (jobP->done == false)
+  {
+    if (pthread_cond_timedwait(&loaderDoneCond, &loaderMutex, &deadline) == ETIMEDOUT)
+      break;
+  }
+
+  bool done = jobP->done;
+
+  contextP = jobP->contextP;
+  if ((done == true) && (contextP == NULL))
+  {
+    orionldState.pd.type   = jobP->errorType;
+    orionldState.pd.title  = kaStrdup(&orionldState.kalloc, jobP->errorTitle);
+    orionldState.pd.detail = kaStrdup(&orionldState.kalloc, jobP->errorDetail);
+    orionldState.pd.status = jobP->errorStatus;
+  }
+
+  jobRelease(jobP);
+  pthread_mutex_unlock(&loaderMutex);
+
+  if (done == false)
+  {
+    LM_T(LmtContextDownload, ("Timeout during download of an @context (%s)", url));
+    orionldError(OrionldInternalError, "Timeout during download of an @context", url, 504);
+    return NULL;
+  }
+
+  return contextP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextLoaderRelease -
+//
+void orionldContextLoaderRelease(void)
+{
+  pthread_mutex_lock(&loaderMutex);
+
+  while (sourceList != NULL)
+  {
+    ContextSource* sourceP = sourceList;
+
+    sourceList = sourceP->next;
+    free(sourceP->url);
+    free(sourceP);
+  }
+
+  pthread_mutex_unlock(&loaderMutex);
+}
@@ -0,0 +1,74 @@
+#ifndef SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTLOADER_H_
+#define SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTLOADER_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Context Loader
+//
+// Downloads of @contexts are done by a small pool of loader threads:
+//
+//   * Single-flight: all requests that need the same (not yet cached) URL wait for one and the same download.
+//     A request that gives up waiting (timeout) doesn't stop the download - the context still ends up in the cache.
+//   * Warm-up: the URLs in the file given by the CLI option -ctxWarmup are downloaded in the background at startup.
+//   * Revalidation: every -ctxRevalidate seconds, the downloaded contexts are revalidated using conditional requests
+//     (If-None-Match / If-Modified-Since). A context that has changed is replaced in the context cache.
+//
+// Before the loader has been started (broker startup), and for contexts referenced by a context that is being
+// loaded, the download is done by the calling thread.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextLoaderStart - start the loader threads, the warm-up and the revalidation
+//
+extern bool orionldContextLoaderStart(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextLoaderLoad - download a context that isn't in the context cache, and await the result
+//
+// On error, NULL is returned and orionldState.pd is filled in.
+//
+extern OrionldContext* orionldContextLoaderLoad(const char* url, const char* id);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextLoaderRelease - free the list of downloaded contexts (for valgrind)
+//
+extern void orionldContextLoaderRelease(void);
+
+#endif  // SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTLOADER_H_
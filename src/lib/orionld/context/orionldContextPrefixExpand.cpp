@@ -34,6 +34,7 @@ extern "C"
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/SCOMPARE.h"                             // SCOMPAREx
 #include "orionld/context/orionldContextItemExpand.h"            // orionldContextItemExpand
+#include "orionld/context/orionldContextExpandMemo.h"            // orionldContextExpandMemoLookup, orionldContextExpandMemoInsert
 #include "orionld/context/orionldContextPrefixExpand.h"          // Own interface
 
 
@@ -92,6 +93,8 @@ static void prefixCacheInsert(const char* prefix, const char* expansion)
 //   * Normally, just a few prefixes are used, so a "prefix cache" of 10 values is maintained.
 //     This cache is local to the thread, so no semaphores are needed
 //
+//   * The complete expansion (prefix:rest) is kept in the expansion memo of the context, shared by all threads
+//
 char* orionldContextPrefixExpand(OrionldContext* contextP, const char* str, char* colonP)
 {
   char* prefix;
@@ -109,6 +112,10 @@ char* orionldContextPrefixExpand(OrionldContext* contextP, const char* str, char
       return (char*) str;
   }
 
+  char* expanded = orionldContextExpandMemoLookup(contextP, str);
+  if (expanded != NULL)
+    return expanded;
+
   //
   // "Valid" colon found - need to replace a prefix
   //
@@ -151,6 +158,8 @@ char* orionldContextPrefixExpand(OrionldContext* contextP, const char* str, char
   //
   *colonP = ':';
 
+  orionldContextExpandMemoInsert(contextP, str, expandedString);
+
   return expandedString;
 }
 
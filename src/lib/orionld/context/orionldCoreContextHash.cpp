@@ -0,0 +1,352 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint32_t
+#include <stdlib.h>                                              // calloc, free
+#include <string.h>                                              // strcmp
+
+extern "C"
+{
+#include "khash/khash.h"                                         // KHashTable, KHashListItem, khashItemLookup
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+#include "orionld/types/OrionldContextItem.h"                    // OrionldContextItem
+#include "orionld/contextCache/orionldContextCache.h"            // ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE
+#include "orionld/context/orionldCoreContextHash.h"              // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PerfectHash - hash and displace
+//
+// The key is hashed once (FNV-1a). The hash selects a bucket, and the seed of the bucket, mixed with the hash,
+// selects the slot. The seeds are chosen, bucket by bucket, so that no two keys end up in the same slot.
+//
+typedef struct PerfectHash
+{
+  uint32_t              buckets;
+  uint32_t              slotMask;   // Number of slots - 1 (power of two)
+  uint32_t*             seedV;      // One per bucket
+  OrionldContextItem**  itemV;      // One per slot, NULL if empty
+  bool                  byValue;    // Key is the IRI (item->id), not the term (item->name)
+} PerfectHash;
+
+
+
+OrionldContext*     orionldCoreContextHashP = NULL;
+static PerfectHash  nameHash;
+static PerfectHash  valueHash;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// keyHash - FNV-1a
+//
+static inline uint32_t keyHash(const char* key)
+{
+  uint32_t hash = 2166136261U;
+
+  while (*key != 0)
+  {
+    hash ^= (unsigned char) *key;
+    hash *= 16777619U;
+    ++key;
+  }
+
+  return hash;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// slotGet - the slot of a key, from its hash and the seed of its bucket (murmur3 finalizer)
+//
+static inline uint32_t slotGet(uint32_t hash, uint32_t seed, uint32_t slotMask)
+{
+  uint32_t h = hash ^ seed;
+
+  h ^= h >> 16;
+  h *= 0x85EBCA6BU;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35U;
+  h ^= h >> 16;
+
+  return h & slotMask;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// itemKey -
+//
+static inline const char* itemKey(PerfectHash* phP, OrionldContextItem* itemP)
+{
+  return (phP->byValue == true)? itemP->id : itemP->name;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// perfectHashLookup -
+//
+static inline OrionldContextItem* perfectHashLookup(PerfectHash* phP, const char* key)
+{
+  uint32_t             hash  = keyHash(key);
+  uint32_t             slot  = slotGet(hash, phP->seedV[hash % phP->buckets], phP->slotMask);
+  OrionldContextItem*  itemP = phP->itemV[slot];
+
+  if ((itemP != NULL) && (strcmp(itemKey(phP, itemP), key) == 0))
+    return itemP;
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// perfectHashRelease -
+//
+static void perfectHashRelease(PerfectHash* phP)
+{
+  free(phP->seedV);
+  free(phP->itemV);
+
+  phP->seedV = NULL;
+  phP->itemV = NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// perfectHashBuild - find a seed for each bucket, biggest buckets first
+//
+static bool perfectHashBuild(PerfectHash* phP, OrionldContextItem** itemV, int items, bool byValue)
+{
+  uint32_t slots = 16;
+
+  while (slots < (uint32_t) items * 2)  // Load factor of at most 0.5 - seeds are found fast
+    slots *= 2;
+
+  phP->byValue  = byValue;
+  phP->buckets  = (items > 0)? items : 1;
+  phP->slotMask = slots - 1;
+  phP->seedV    = (uint32_t*) calloc(phP->buckets, sizeof(uint32_t));
+  phP->itemV    = (OrionldContextItem**) calloc(slots, sizeof(OrionldContextItem*));
+
+  uint32_t* hashV   = (uint32_t*) calloc(items + 1, sizeof(uint32_t));
+  int*      bucketV = (int*) calloc(items + 1, sizeof(int));     // Bucket of each item
+  int*      sizeV   = (int*) calloc(phP->buckets, sizeof(int));  // Items per bucket
+  uint32_t* slotV   = (uint32_t*) calloc(items + 1, sizeof(uint32_t));
+  bool      ok      = true;
+
+  if ((phP->seedV == NULL) || (phP->itemV == NULL) || (hashV == NULL) || (bucketV == NULL) || (sizeV == NULL) || (slotV == NULL))
+    ok = false;
+
+  for (int ix = 0; (ok == true) && (ix < items); ix++)
+  {
+    hashV[ix]   = keyHash(itemKey(phP, itemV[ix]));
+    bucketV[ix] = hashV[ix] % phP->buckets;
+    sizeV[bucketV[ix]] += 1;
+  }
+
+  for (int size = items; (ok == true) && (size > 0); size--)
+  {
+    for (uint32_t bucket = 0; (ok == true) && (bucket < phP->buckets); bucket++)
+    {
+      if (sizeV[bucket] != size)
+        continue;
+
+      uint32_t seed;
+      for (seed = 1; seed < 1000000; seed++)
+      {
+        int placed = 0;
+
+        for (int ix = 0; ix < items; ix++)
+        {
+          if (bucketV[ix] != (int) bucket)
+            continue;
+
+          uint32_t slot = slotGet(hashV[ix], seed, phP->slotMask);
+
+          // Free slot, and not taken by another key of the same bucket?
+          bool taken = (phP->itemV[slot] != NULL);
+          for (int pIx = 0; (taken == false) && (pIx < placed); pIx++)
+            taken = (slotV[pIx] == slot);
+
+          if (taken == true)
+            break;
+
+          slotV[placed++] = slot;
+        }
+
+        if (placed == size)
+          break;
+      }
+
+      if (seed == 1000000)
+      {
+        LM_W(("No perfect hash found for the Core Context (bucket with %d keys)", size));
+        ok = false;
+        break;
+      }
+
+      phP->seedV[bucket] = seed;
+
+      int placed = 0;
+      for (int ix = 0; ix < items; ix++)
+      {
+        if (bucketV[ix] == (int) bucket)
+          phP->itemV[slotV[placed++]] = itemV[ix];
+      }
+    }
+  }
+
+  free(hashV);
+  free(bucketV);
+  free(sizeV);
+  free(slotV);
+
+  if (ok == false)
+    perfectHashRelease(phP);
+
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldCoreContextHashBuild -
+//
+bool orionldCoreContextHashBuild(OrionldContext* coreContextP)
+{
+  orionldCoreContextHashP = NULL;
+
+  if ((coreContextP == NULL) || (coreContextP->keyValues == false))
+    return false;
+
+  KHashTable* nameTableP  = coreContextP->context.hash.nameHashTable;
+  KHashTable* valueTableP = coreContextP->context.hash.valueHashTable;
+
+  //
+  // All terms of the context, and, for the IRIs, the item the value hash table gives for each IRI
+  // (an IRI may have more than one term)
+  //
+  int items = 0;
+  for (int slot = 0; slot < ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE; ++slot)
+  {
+    for (KHashListItem* listItemP = nameTableP->array[slot]; listItemP != NULL; listItemP = listItemP->next)
+      ++items;
+  }
+
+  OrionldContextItem** nameItemV  = (OrionldContextItem**) calloc(items + 1, sizeof(OrionldContextItem*));
+  OrionldContextItem** valueItemV = (OrionldContextItem**) calloc(items + 1, sizeof(OrionldContextItem*));
+  int                  values     = 0;
+
+  if ((nameItemV == NULL) || (valueItemV == NULL))
+  {
+    free(nameItemV);
+    free(valueItemV);
+    return false;
+  }
+
+  items = 0;
+  for (int slot = 0; slot < ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE; ++slot)
+  {
+    for (KHashListItem* listItemP = nameTableP->array[slot]; listItemP != NULL; listItemP = listItemP->next)
+    {
+      OrionldContextItem* itemP  = (OrionldContextItem*) listItemP->data;
+      OrionldContextItem* valueP = (OrionldContextItem*) khashItemLookup(valueTableP, itemP->id);
+
+      nameItemV[items++] = itemP;
+
+      if (valueP == itemP)
+        valueItemV[values++] = itemP;
+    }
+  }
+
+  bool ok = perfectHashBuild(&nameHash, nameItemV, items, false) && perfectHashBuild(&valueHash, valueItemV, values, true);
+
+  //
+  // Verify - the perfect hash tables must give the very same answers as the hash tables of the context
+  //
+  for (int ix = 0; (ok == true) && (ix < items); ix++)
+  {
+    OrionldContextItem* itemP = nameItemV[ix];
+
+    if (perfectHashLookup(&nameHash, itemP->name) != itemP)
+      ok = false;
+    else if (perfectHashLookup(&valueHash, itemP->id) != khashItemLookup(valueTableP, itemP->id))
+      ok = false;
+  }
+
+  free(nameItemV);
+  free(valueItemV);
+
+  if (ok == false)
+  {
+    LM_W(("Perfect hash for the Core Context not used - the Core Context keeps its hash tables"));
+    perfectHashRelease(&nameHash);
+    perfectHashRelease(&valueHash);
+    return false;
+  }
+
+  LM_T(LmtCoreContext, ("Perfect hash for the Core Context: %d terms in %d slots, %d IRIs in %d slots", items, nameHash.slotMask + 1, values, valueHash.slotMask + 1));
+  orionldCoreContextHashP = coreContextP;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldCoreContextNameLookup -
+//
+OrionldContextItem* orionldCoreContextNameLookup(const char* name)
+{
+  return perfectHashLookup(&nameHash, name);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldCoreContextValueLookup -
+//
+OrionldContextItem* orionldCoreContextValueLookup(const char* longName)
+{
+  return perfectHashLookup(&valueHash, longName);
+}
@@ -0,0 +1,69 @@
+#ifndef SRC_LIB_ORIONLD_CONTEXT_ORIONLDCORECONTEXTHASH_H_
+#define SRC_LIB_ORIONLD_CONTEXT_ORIONLDCORECONTEXTHASH_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+#include "orionld/types/OrionldContextItem.h"                    // OrionldContextItem
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldCoreContextHashP - the context the perfect hash tables were built for - NULL if not built
+//
+extern OrionldContext* orionldCoreContextHashP;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldCoreContextHashBuild - build perfect hash tables (term->item and IRI->item) for the Core Context
+//
+// The Core Context is fixed for the life of the broker, so, it's worth finding a hash function without
+// collisions for its terms and IRIs, once, at startup. A lookup is then one hash of the key, one probe
+// and one strcmp - no bucket lists.
+// The tables are verified against the hash tables of the context, for each and every term. If anything
+// differs, the tables aren't used, and the Core Context lookups stay with its hash tables.
+//
+extern bool orionldCoreContextHashBuild(OrionldContext* coreContextP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldCoreContextNameLookup - the Core Context item for a term
+//
+extern OrionldContextItem* orionldCoreContextNameLookup(const char* name);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldCoreContextValueLookup - the Core Context item for an IRI
+//
+extern OrionldContextItem* orionldCoreContextValueLookup(const char* longName);
+
+#endif  // SRC_LIB_ORIONLD_CONTEXT_ORIONLDCORECONTEXTHASH_H_
@@ -32,21 +32,53 @@ extern "C"
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
+#include "epoch/epoch.h"                                         // epochRetire
 #include "orionld/types/OrionldContext.h"                        // OrionldContext
 #include "orionld/mongoc/mongocContextCacheDelete.h"             // mongocContextCacheDelete
 #include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // orionldContextCacheIndexRemove
+#include "orionld/contextCache/orionldContextCacheSnapshot.h"    // orionldContextCacheSnapshotDeleted
 #include "orionld/contextCache/orionldContextCacheDelete.h"      // Own interface
 
 
 
+// -----------------------------------------------------------------------------
+//
+// contextTreeRelease -
+//
+static void contextTreeRelease(void* treeP)
+{
+  kjFree((KjNode*) treeP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheRetire -
+//
+// The tree is unlinked from the context before it's retired - a reader that loads contextP->tree later (inside a
+// read section) finds NULL, just like a lookup that no longer finds the context.
+//
+void orionldContextCacheRetire(OrionldContext* contextP)
+{
+  KjNode* treeP = __atomic_exchange_n(&contextP->tree, (KjNode*) NULL, __ATOMIC_ACQ_REL);
+
+  if (treeP != NULL)
+    epochRetire(treeP, contextTreeRelease);
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // contextCacheReleaseOne -
 //
 static void contextCacheReleaseOne(OrionldContext* contextP)
 {
-  if (contextP->tree != NULL)
-    kjFree(contextP->tree);
+  orionldContextCacheSnapshotDeleted(contextP);  // Removed from the database by the caller
+  orionldContextCacheIndexRemove(contextP);
+  orionldContextCacheRetire(contextP);
 }
 
 
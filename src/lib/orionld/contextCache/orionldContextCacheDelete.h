@@ -25,6 +25,19 @@
 *
 * Author: Ken Zangelin
 */
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheRetire - free the tree of a context that is no longer in the cache
+//
+// contextP->tree is set to NULL.
+// The tree is freed once every read section that might have found the context (epoch/epoch.h) has ended.
+// The OrionldContext itself is never freed.
+//
+extern void orionldContextCacheRetire(OrionldContext* contextP);
 
 
 
@@ -37,6 +37,8 @@ extern "C"
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/numberToDate.h"                         // numberToDate
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
+#include "orionld/context/orionldContextCounters.h"              // orionldContextCounterGet
+#include "orionld/context/orionldContextExpandMemo.h"            // orionldContextExpandMemoStats
 #include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
 #include "orionld/contextCache/orionldContextCacheGet.h"         // Own interface
 
@@ -74,8 +76,8 @@ KjNode* orionldContextWithDetails(OrionldContext* contextP)
   KjNode*          extraInfoP       = kjObject(orionldState.kjsonP,  "extraInfo");
   KjNode*          typeStringP      = kjString(orionldState.kjsonP,  "type",         (contextP->keyValues == true)? "hash-table" : "array");
   KjNode*          originP          = kjString(orionldState.kjsonP,  "origin",       orionldOriginToString(contextP->origin));
-  KjNode*          compactionsP     = kjInteger(orionldState.kjsonP, "compactions",  contextP->compactions);
-  KjNode*          expansionsP      = kjInteger(orionldState.kjsonP, "expansions",   contextP->expansions);
+  KjNode*          compactionsP     = kjInteger(orionldState.kjsonP, "compactions",  orionldContextCounterGet(contextP, OrionldContextCompactions));
+  KjNode*          expansionsP      = kjInteger(orionldState.kjsonP, "expansions",   orionldContextCounterGet(contextP, OrionldContextExpansions));
 
   kjChildAdd(contextObjP, urlStringP);
   kjChildAdd(contextObjP, idStringP);
@@ -87,7 +89,7 @@ KjNode* orionldContextWithDetails(OrionldContext* contextP)
   if (contextP != orionldCoreContextP)
   {
     KjNode*          usedAtP          = kjString(orionldState.kjsonP,  "lastUsage",    lastUseString);
-    KjNode*          lookupsP         = kjInteger(orionldState.kjsonP, "numberOfHits", contextP->lookups);
+    KjNode*          lookupsP         = kjInteger(orionldState.kjsonP, "numberOfHits", orionldContextCounterGet(contextP, OrionldContextLookups));
     kjChildAdd(contextObjP, usedAtP);
     kjChildAdd(contextObjP, lookupsP);
   }
@@ -97,6 +99,23 @@ KjNode* orionldContextWithDetails(OrionldContext* contextP)
   kjChildAdd(extraInfoP,  compactionsP);
   kjChildAdd(extraInfoP,  expansionsP);
 
+  // Expansion memo - only if the broker runs with -ctxMemo and the memo of the context has been used
+  OrionldContextExpandMemoStats memoStats;
+  if (orionldContextExpandMemoStats(contextP, &memoStats) == true)
+  {
+    uint64_t lookups = memoStats.hits + memoStats.misses;
+    double   hitRate = (lookups == 0)? 0 : (double) memoStats.hits / lookups;
+    KjNode*  memoP   = kjObject(orionldState.kjsonP, "expansionMemo");
+
+    kjChildAdd(memoP, kjInteger(orionldState.kjsonP, "hits",      memoStats.hits));
+    kjChildAdd(memoP, kjInteger(orionldState.kjsonP, "misses",    memoStats.misses));
+    kjChildAdd(memoP, kjFloat(orionldState.kjsonP,   "hitRate",   hitRate));
+    kjChildAdd(memoP, kjInteger(orionldState.kjsonP, "entries",   memoStats.entries));
+    kjChildAdd(memoP, kjInteger(orionldState.kjsonP, "evictions", memoStats.evictions));
+    kjChildAdd(memoP, kjInteger(orionldState.kjsonP, "bytes",     memoStats.bytes));
+    kjChildAdd(extraInfoP, memoP);
+  }
+
   if (contextP->parent != NULL)
   {
     KjNode* parentP = kjString(orionldState.kjsonP, "parent", contextP->parent);
@@ -163,7 +182,7 @@ KjNode* orionldContextCacheGet(KjNode* arrayP, bool details, OrionldContextKind
 {
   for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
   {
-    OrionldContext*  contextP = orionldContextCacheArray[ix];
+    OrionldContext*  contextP = orionldContextCache[ix];
 
     if (contextP == NULL)
       continue;
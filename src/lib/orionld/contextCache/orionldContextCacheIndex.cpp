@@ -0,0 +1,147 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc, free
+#include <string.h>                                              // strcmp
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "epoch/epoch.h"                                         // epochRetire
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndex -
+//
+ContextCacheIndexItem* orionldContextCacheIndex[ORIONLD_CONTEXT_CACHE_INDEX_SIZE];
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexBucket - FNV-1a
+//
+// URLs of the same server differ only in their last few characters, a plain sum of the characters would put
+// them all in a handful of buckets.
+//
+unsigned int orionldContextCacheIndexBucket(const char* key)
+{
+  unsigned int hash = 2166136261U;
+
+  while (*key != 0)
+  {
+    hash ^= (unsigned char) *key;
+    hash *= 16777619U;
+    ++key;
+  }
+
+  return hash % ORIONLD_CONTEXT_CACHE_INDEX_SIZE;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// indexKeyAdd -
+//
+static void indexKeyAdd(const char* key, OrionldContext* contextP)
+{
+  ContextCacheIndexItem* itemP = (ContextCacheIndexItem*) malloc(sizeof(ContextCacheIndexItem));
+
+  if (itemP == NULL)
+    LM_X(1, ("Out of memory allocating a context cache index item"));
+
+  itemP->key      = key;
+  itemP->contextP = contextP;
+  itemP->next     = NULL;
+
+  //
+  // The item is complete before it's linked in - a reader sees it whole, or not at all
+  //
+  ContextCacheIndexItem** linkP = &orionldContextCacheIndex[orionldContextCacheIndexBucket(key)];
+
+  while (*linkP != NULL)
+    linkP = &(*linkP)->next;
+
+  __atomic_store_n(linkP, itemP, __ATOMIC_RELEASE);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// indexKeyRemove -
+//
+static void indexKeyRemove(const char* key, OrionldContext* contextP)
+{
+  ContextCacheIndexItem** linkP = &orionldContextCacheIndex[orionldContextCacheIndexBucket(key)];
+
+  while (*linkP != NULL)
+  {
+    ContextCacheIndexItem* itemP = *linkP;
+
+    if ((itemP->contextP == contextP) && (strcmp(itemP->key, key) == 0))
+    {
+      // A reader standing on the item still gets to its successors
+      __atomic_store_n(linkP, itemP->next, __ATOMIC_RELEASE);
+      epochRetire(itemP, free);
+      return;
+    }
+
+    linkP = &itemP->next;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexAdd -
+//
+void orionldContextCacheIndexAdd(OrionldContext* contextP)
+{
+  if (contextP->url != NULL)
+    indexKeyAdd(contextP->url, contextP);
+
+  if ((contextP->id != NULL) && ((contextP->url == NULL) || (strcmp(contextP->id, contextP->url) != 0)))
+    indexKeyAdd(contextP->id, contextP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexRemove -
+//
+void orionldContextCacheIndexRemove(OrionldContext* contextP)
+{
+  if (contextP->url != NULL)
+    indexKeyRemove(contextP->url, contextP);
+
+  if ((contextP->id != NULL) && ((contextP->url == NULL) || (strcmp(contextP->id, contextP->url) != 0)))
+    indexKeyRemove(contextP->id, contextP);
+}
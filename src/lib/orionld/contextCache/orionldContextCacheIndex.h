@@ -0,0 +1,95 @@
+#ifndef SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHEINDEX_H_
+#define SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHEINDEX_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ORIONLD_CONTEXT_CACHE_INDEX_SIZE - number of buckets of the context cache index
+//
+#define ORIONLD_CONTEXT_CACHE_INDEX_SIZE   4096
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ContextCacheIndexItem - one key (URL or id) of a cached context
+//
+// The key points to the url/id of the context itself - cached contexts are never freed.
+//
+typedef struct ContextCacheIndexItem
+{
+  const char*                    key;
+  OrionldContext*                contextP;
+  struct ContextCacheIndexItem*  next;
+} ContextCacheIndexItem;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndex - the context cache, indexed by URL and by id
+//
+// Readers (orionldContextCacheLookup) take no lock. They walk a bucket inside a read section of the same
+// epoch based reclamation as the sub-cache (epoch/epoch.h).
+// Writers, serialized by orionldContextCacheSem, publish a new item with an atomic store of the pointer that
+// links it in (items are appended, so the first context cached with a key is found first - like the old linear scan).
+// Unlinked items are retired, not freed, as a reader might still be looking at them.
+//
+extern ContextCacheIndexItem* orionldContextCacheIndex[ORIONLD_CONTEXT_CACHE_INDEX_SIZE];
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexBucket - the bucket of a key (URL or id)
+//
+extern unsigned int orionldContextCacheIndexBucket(const char* key);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexAdd - add the URL and the id of a context to the index
+//
+// Must be called with orionldContextCacheSem taken.
+//
+extern void orionldContextCacheIndexAdd(OrionldContext* contextP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheIndexRemove - remove the URL and the id of a context from the index
+//
+// Must be called with orionldContextCacheSem taken.
+//
+extern void orionldContextCacheIndexRemove(OrionldContext* contextP);
+
+#endif  // SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHEINDEX_H_
@@ -34,14 +34,17 @@ extern "C"
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
-#include "orionld/common/orionldState.h"                         // dbHost, coreContextUrl, builtinCoreContext
+#include "orionld/common/orionldState.h"                         // dbHost, coreContextUrl, builtinCoreContext, contextSnapshotFile
 #include "orionld/mongoc/mongocContextCacheGet.h"                // mongocContextCacheGet
+#include "orionld/mongoc/mongocContextCacheSummaryGet.h"         // mongocContextCacheSummaryGet
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP, builtinCoreContextUrl, builtinCoreContext
 #include "orionld/context/orionldContextFromUrl.h"               // orionldContextFromUrl
 #include "orionld/context/orionldContextFromTree.h"              // orionldContextFromTree
 #include "orionld/context/orionldContextFromBuffer.h"            // orionldContextFromBuffer
+#include "orionld/context/orionldCoreContextHash.h"              // orionldCoreContextHashBuild
 #include "orionld/contextCache/orionldContextCache.h"            // orionldContextCacheArray, orionldContextCacheSem
 #include "orionld/contextCache/orionldContextCachePersist.h"     // orionldContextCachePersist
+#include "orionld/contextCache/orionldContextCacheSnapshot.h"    // orionldContextCacheSnapshotDbChecksum, orionldContextCacheSnapshotLoad
 #include "orionld/contextCache/orionldContextCacheInit.h"        // Own interface
 
 
@@ -98,6 +101,19 @@ void orionldContextCacheInit(void)
   if (sem_init(&orionldContextCacheSem, 0, 1) == -1)
     LM_X(1, ("Runtime Error (error initializing semaphore for orionld context list; %s)", strerror(errno)));
 
+  //
+  // If the contexts in the database are the same as when the snapshot was written (-ctxSnapshot),
+  // the cache is loaded directly from the snapshot - no parsing, no prefix expansion, no downloads.
+  // The checksum needs only the _id, url and createdAt of the contexts, not their values.
+  //
+  orionldContextCacheSnapshotDbChecksum(mongocContextCacheSummaryGet());
+
+  if ((contextSnapshotFile[0] != 0) && (orionldContextCacheSnapshotLoad(contextSnapshotFile) == true))
+  {
+    orionldCoreContextHashBuild(orionldCoreContextP);
+    return;
+  }
+
   //
   // Retrieve the context cache from the database and populate the context cache in RAM
   //
@@ -185,6 +201,9 @@ void orionldContextCacheInit(void)
     LM_W(("Falling back to Built-in Core Context (hard-coded copy of %s)", builtinCoreContextUrl));
   }
 
+  // The Core Context is now fixed - perfect hash tables for its terms and IRIs
+  orionldCoreContextHashBuild(orionldCoreContextP);
+
   if (contextArray == NULL)
     return;
 
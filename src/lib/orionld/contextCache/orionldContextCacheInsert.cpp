@@ -35,6 +35,7 @@
 #include "orionld/serviceRoutines/orionldPostSubscriptions.h"    // orionldPostSubscriptions
 #include "orionld/serviceRoutines/orionldPostRegistrations.h"    // orionldPostRegistrations
 #include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // orionldContextCacheIndexAdd
 #include "orionld/contextCache/orionldContextCacheInsert.h"      // Own interface
 
 
@@ -107,5 +108,6 @@ void orionldContextCacheInsert(OrionldContext* contextP)
   }
 
   orionldContextCache[slotNo] = contextP;
+  orionldContextCacheIndexAdd(contextP);
   sem_post(&orionldContextCacheSem);
 }
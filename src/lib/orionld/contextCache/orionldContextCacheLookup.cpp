@@ -27,34 +27,42 @@
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
+#include "epoch/epoch.h"                                         // epochEnter, epochLeave
 #include "orionld/types/OrionldContext.h"                        // OrionldContext
-#include "orionld/common/orionldState.h"                         // orionldState
-#include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
+#include "orionld/contextCache/orionldContextCacheIndex.h"       // orionldContextCacheIndex, orionldContextCacheIndexBucket
 #include "orionld/contextCache/orionldContextCacheLookup.h"      // Own interface
 
 
 
 // -----------------------------------------------------------------------------
 //
-// orionldContextCacheLookup -
+// orionldContextCacheLookup - find a cached context by its URL or by its id
+//
+// No lock is taken - see orionldContextCacheIndex.h.
+// The OrionldContext itself stays valid after the lookup, as contexts are never freed, but its tree is retired when
+// the context leaves the cache (DELETE, reload, revalidation). A caller that uses contextP->tree must be inside a
+// read section (epochEnter) from before the lookup until it's done with the tree.
 //
 OrionldContext* orionldContextCacheLookup(const char* url)
 {
-  OrionldContext* contextP = NULL;
+  OrionldContext*         contextP = NULL;
+  ContextCacheIndexItem*  itemP;
 
-  for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
-  {
-    if (orionldContextCache[ix] == NULL)
-      continue;
+  epochEnter();
 
-    if (strcmp(url, orionldContextCache[ix]->url) == 0)
-      contextP = orionldContextCache[ix];
-    else if ((orionldContextCache[ix]->id != NULL) && (strcmp(url, orionldContextCache[ix]->id) == 0))
-      contextP = orionldContextCache[ix];
+  itemP = __atomic_load_n(&orionldContextCacheIndex[orionldContextCacheIndexBucket(url)], __ATOMIC_ACQUIRE);
+  while (itemP != NULL)
+  {
+    if (strcmp(url, itemP->key) == 0)
+    {
+      contextP = itemP->contextP;
+      break;
+    }
 
-    if (contextP != NULL)
-      return contextP;
+    itemP = __atomic_load_n(&itemP->next, __ATOMIC_ACQUIRE);
   }
 
-  return NULL;
+  epochLeave();
+
+  return contextP;
 }
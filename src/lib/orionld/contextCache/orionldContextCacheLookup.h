@@ -33,6 +33,9 @@
 //
 // orionldContextCacheLookup -
 //
+// The tree of the returned context may only be used inside a read section (epoch/epoch.h) that was entered
+// before the lookup.
+//
 extern OrionldContext* orionldContextCacheLookup(const char* url);
 
 #endif  // SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHELOOKUP_H_
@@ -26,16 +26,19 @@ extern "C"
 {
 #include "kjson/KjNode.h"                                        // KjNode
 #include "kjson/kjBuilder.h"                                     // kjObject, kjString, kjFloat, kjChildAdd, ...
+#include "kjson/kjClone.h"                                       // kjClone
 }
 
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
+#include "epoch/epoch.h"                                         // epochEnter, epochLeave
 #include "orionld/types/OrionldContext.h"                        // OrionldContext, orionldOriginToString, orionldKindToString
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/uuidGenerate.h"                         // uuidGenerate
 #include "orionld/context/orionldContextUrlGenerate.h"           // orionldContextUrlGenerate
 #include "orionld/mongoc/mongocContextCachePersist.h"            // mongocContextCachePersist - FIXME: Use dbContextCachePersist
+#include "orionld/contextCache/orionldContextCacheSnapshot.h"    // orionldContextCacheSnapshotPersisted
 #include "orionld/contextCache/orionldContextCachePersist.h"     // Own interface
 
 
@@ -54,19 +57,32 @@ extern "C"
 //   "value":     JSON Array|Object representation of the VALUE of the @context (i.e. NOT containing the @context member)
 // }
 //
+// The tree of the context is cloned inside a read section, as the context may be deleted (its tree retired) meanwhile.
+//
 void orionldContextCachePersist(OrionldContext* contextP)
 {
+  epochEnter();
+
+  KjNode* valueP = __atomic_load_n(&contextP->tree, __ATOMIC_ACQUIRE);
+
+  if (valueP != NULL)
+    valueP = kjClone(orionldState.kjsonP, valueP);  // The cached tree is shared - not to be modified
+
+  epochLeave();
+
+  if (valueP == NULL)
+  {
+    LM_W(("The context '%s' was deleted before it could be persisted", contextP->url));
+    return;
+  }
+
   KjNode*  contextObjP  = kjObject(orionldState.kjsonP, NULL);
   KjNode*  idP;
   KjNode*  urlP         = kjString(orionldState.kjsonP, "url",       contextP->url);
   KjNode*  parentP;
   KjNode*  originP      = kjString(orionldState.kjsonP, "origin",    orionldOriginToString(contextP->origin));
   KjNode*  kindP        = kjString(orionldState.kjsonP, "kind",      orionldKindToString(contextP->kind));
-  KjNode*  createdAtP   = kjFloat(orionldState.kjsonP,  "createdAt", orionldState.requestTime);  // FIXME: make sure it's not overwritten if already exists
-  KjNode*  valueP       = contextP->tree;
-
-  if (contextP->tree == NULL)
-    LM_X(1, ("FATAL ERROR: the context '%s' has no tree!", contextP->url));
+  KjNode*  createdAtP   = kjFloat(orionldState.kjsonP,  "createdAt", contextP->createdAt);  // Part of the snapshot checksum - see orionldContextCacheSnapshotPersisted
 
   // Field: "_id"
   if (contextP->id == NULL)
@@ -98,5 +114,6 @@ void orionldContextCachePersist(OrionldContext* contextP)
   valueP->name = (char*) "value";
   kjChildAdd(contextObjP, valueP);
 
-  mongocContextCachePersist(contextObjP);
+  if (mongocContextCachePersist(contextObjP) == true)
+    orionldContextCacheSnapshotPersisted(contextP);
 }
@@ -0,0 +1,976 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // snprintf, rename
+#include <stdlib.h>                                              // malloc, realloc, free
+#include <string.h>                                              // strcmp, strlen, memcpy, memcmp, strerror
+#include <strings.h>                                             // bzero
+#include <errno.h>                                               // errno
+#include <unistd.h>                                              // write, close, fsync, unlink, sleep
+#include <fcntl.h>                                               // open, O_*
+#include <pthread.h>                                             // pthread_*
+#include <semaphore.h>                                           // sem_wait, sem_post
+#include <sys/mman.h>                                            // mmap, munmap
+#include <sys/stat.h>                                            // fstat
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "khash/khash.h"                                         // KHashTable, KHashListItem, khashTableCreate, khashItemAdd
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjLookup.h"                                      // kjLookup
+#include "kjson/kjBuilder.h"                                     // kjString
+#include "kjson/kjParse.h"                                       // kjParse
+#include "kjson/kjRender.h"                                      // kjFastRender
+#include "kjson/kjRenderSize.h"                                  // kjFastRenderSize
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "epoch/epoch.h"                                         // epochEnter, epochLeave
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+#include "orionld/types/OrionldContextItem.h"                    // OrionldContextItem
+#include "orionld/common/orionldState.h"                         // orionldState, kalloc, coreContextUrl, contextSnapshotFile, contextSnapshotInterval
+#include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
+#include "orionld/context/orionldContextCreate.h"                // orionldContextCreate
+#include "orionld/context/orionldContextFromObject.h"            // hashCode
+#include "orionld/context/orionldContextArrayMerge.h"            // orionldContextArrayMerge
+#include "orionld/contextCache/orionldContextCache.h"            // orionldContextCache, orionldContextCacheSem, ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE
+#include "orionld/contextCache/orionldContextCacheLookup.h"      // orionldContextCacheLookup
+#include "orionld/contextCache/orionldContextCacheInsert.h"      // orionldContextCacheInsert
+#include "orionld/contextCache/orionldContextCacheSnapshot.h"    // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Layout of the snapshot file
+//
+//   SnapshotHeader
+//   SnapshotContext[contexts]  - array members always come before the array
+//   uint32_t[words]            - terms of key-value contexts (name, IRI, @type) and members of array contexts
+//   char[poolSize]             - all strings, zero-terminated, referenced by their offset in the pool
+//
+// Nothing in the file is a pointer, so the file is mapped as is and its strings are used in place,
+// by the term tables of the contexts - the mapping is never undone.
+// The terms of a context are saved in the order of its name hash table, so the tables are rebuilt exactly as they were.
+//
+#define SNAPSHOT_MAGIC             "OLDCTXS"
+#define SNAPSHOT_VERSION           1
+#define SNAPSHOT_NONE              0xFFFFFFFF
+
+#define SNAPSHOT_CACHED            (1 << 0)  // In the context cache (not just a member of an array)
+#define SNAPSHOT_KEY_VALUES        (1 << 1)
+#define SNAPSHOT_CORE_CONTEXT      (1 << 2)
+#define SNAPSHOT_MERGED            (1 << 3)  // Array context with merged term tables - see orionldContextArrayMerge
+#define SNAPSHOT_TREE_STRING       (1 << 4)  // 'tree' is the string itself, not JSON text
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SnapshotHeader -
+//
+typedef struct SnapshotHeader
+{
+  char      magic[8];
+  uint32_t  version;
+  uint32_t  contexts;      // Number of SnapshotContext
+  uint32_t  words;         // Size of the word area, in uint32_t
+  uint32_t  poolSize;      // Size of the string pool, in bytes
+  uint32_t  coreContext;   // URL of the Core Context (offset in the string pool)
+  uint32_t  hashSize;      // ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE - the order of the terms depends on it
+  uint64_t  dbChecksum;    // Contexts in the database when the snapshot was written
+  uint64_t  bodyChecksum;  // FNV-1a of everything after the header
+} SnapshotHeader;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SnapshotContext -
+//
+typedef struct SnapshotContext
+{
+  double    createdAt;
+  uint32_t  url;           // Offset in the string pool - SNAPSHOT_NONE for NULL
+  uint32_t  id;            // Offset in the string pool - SNAPSHOT_NONE for NULL
+  uint32_t  parent;        // Offset in the string pool - SNAPSHOT_NONE for NULL
+  uint32_t  tree;          // Offset in the string pool - SNAPSHOT_NONE for no tree
+  uint32_t  flags;         // SNAPSHOT_CACHED | SNAPSHOT_KEY_VALUES | ...
+  uint32_t  origin;        // OrionldContextOrigin
+  uint32_t  kind;          // OrionldContextKind
+  uint32_t  items;         // Number of terms (key-values) or members (array)
+  uint32_t  firstWord;     // Index of the first term/member in the word area
+  uint32_t  reserved;
+} SnapshotContext;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SnapshotBuffer - growing buffer for each of the three parts of the body
+//
+typedef struct SnapshotBuffer
+{
+  char*     buf;
+  uint32_t  size;
+  uint32_t  used;
+} SnapshotBuffer;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SnapshotWriter -
+//
+typedef struct SnapshotWriter
+{
+  SnapshotBuffer    records;
+  SnapshotBuffer    words;
+  SnapshotBuffer    pool;
+  OrionldContext**  contextV;  // The contexts already written, in record order
+  uint32_t          contexts;
+  uint32_t          contextSlots;
+} SnapshotWriter;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// dbChecksum - contexts in the database, kept up to date as contexts are persisted/deleted
+//
+static uint64_t         dbChecksum   = 0;
+static pthread_mutex_t  writeMutex   = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// fnv1a -
+//
+static uint64_t fnv1a(uint64_t hash, const void* data, uint64_t len)
+{
+  const unsigned char* p = (const unsigned char*) data;
+
+  for (uint64_t ix = 0; ix < len; ix++)
+  {
+    hash ^= p[ix];
+    hash *= 0x100000001B3ULL;
+  }
+
+  return hash;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// dbContextChecksum - checksum of one context in the database
+//
+// A context in the database is never modified by the broker, only inserted and removed, and "createdAt" is the time
+// it was written - the url, the _id and the write time identify the content of the context.
+// The checksum of the entire database is the sum of the checksums of its contexts, so, it doesn't depend on the order.
+//
+static uint64_t dbContextChecksum(const char* url, const char* id, double createdAt)
+{
+  uint64_t hash = 0xCBF29CE484222325ULL;
+
+  hash = fnv1a(hash, url,        strlen(url) + 1);
+  hash = fnv1a(hash, id,         strlen(id) + 1);
+  hash = fnv1a(hash, &createdAt, sizeof(createdAt));
+
+  return hash;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotDbChecksum -
+//
+uint64_t orionldContextCacheSnapshotDbChecksum(KjNode* contextArray)
+{
+  uint64_t checksum = 0;
+
+  if (contextArray != NULL)
+  {
+    for (KjNode* contextNodeP = contextArray->value.firstChildP; contextNodeP != NULL; contextNodeP = contextNodeP->next)
+    {
+      KjNode* idNodeP        = kjLookup(contextNodeP, "_id");
+      KjNode* urlNodeP       = kjLookup(contextNodeP, "url");
+      KjNode* createdAtNodeP = kjLookup(contextNodeP, "createdAt");
+      double  createdAt      = 0;
+
+      if ((idNodeP == NULL) || (idNodeP->type != KjString) || (urlNodeP == NULL) || (urlNodeP->type != KjString))
+        continue;
+
+      if ((createdAtNodeP != NULL) && (createdAtNodeP->type == KjFloat))
+        createdAt = createdAtNodeP->value.f;
+      else if ((createdAtNodeP != NULL) && (createdAtNodeP->type == KjInt))
+        createdAt = createdAtNodeP->value.i;
+
+      checksum += dbContextChecksum(urlNodeP->value.s, idNodeP->value.s, createdAt);
+    }
+  }
+
+  __atomic_store_n(&dbChecksum, checksum, __ATOMIC_RELEASE);
+
+  return checksum;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotPersisted -
+//
+void orionldContextCacheSnapshotPersisted(OrionldContext* contextP)
+{
+  if ((contextP->url == NULL) || (contextP->id == NULL))
+    return;
+
+  __atomic_add_fetch(&dbChecksum, dbContextChecksum(contextP->url, contextP->id, contextP->createdAt), __ATOMIC_ACQ_REL);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotDeleted -
+//
+void orionldContextCacheSnapshotDeleted(OrionldContext* contextP)
+{
+  if ((contextP->url == NULL) || (contextP->id == NULL))
+    return;
+
+  __atomic_sub_fetch(&dbChecksum, dbContextChecksum(contextP->url, contextP->id, contextP->createdAt), __ATOMIC_ACQ_REL);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// bufferAppend - returns the offset of the data in the buffer
+//
+static uint32_t bufferAppend(SnapshotBuffer* bP, const void* data, uint32_t len)
+{
+  if (bP->used + len > bP->size)
+  {
+    uint32_t newSize = (bP->size == 0)? 4096 : bP->size;
+
+    while (bP->used + len > newSize)
+      newSize *= 2;
+
+    bP->buf = (char*) realloc(bP->buf, newSize);
+    if (bP->buf == NULL)
+      LM_X(1, ("Out of memory (allocating %u bytes for the context cache snapshot)", newSize));
+
+    bP->size = newSize;
+  }
+
+  uint32_t offset = bP->used;
+
+  memcpy(&bP->buf[offset], data, len);
+  bP->used += len;
+
+  return offset;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// stringAdd -
+//
+static uint32_t stringAdd(SnapshotWriter* wP, const char* s)
+{
+  if (s == NULL)
+    return SNAPSHOT_NONE;
+
+  return bufferAppend(&wP->pool, s, strlen(s) + 1);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// wordAdd -
+//
+static void wordAdd(SnapshotWriter* wP, uint32_t word)
+{
+  bufferAppend(&wP->words, &word, sizeof(word));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// treeAdd - the tree of a cached context, for GET /jsonldContexts/{id} and for the database
+//
+static uint32_t treeAdd(SnapshotWriter* wP, KjNode* treeP, uint32_t* flagsP)
+{
+  if (treeP == NULL)
+    return SNAPSHOT_NONE;
+
+  if (treeP->type == KjString)
+  {
+    *flagsP |= SNAPSHOT_TREE_STRING;
+    return stringAdd(wP, treeP->value.s);
+  }
+
+  int   size = kjFastRenderSize(treeP);
+  char* buf  = (char*) malloc(size + 1);
+
+  if (buf == NULL)
+    LM_X(1, ("Out of memory (allocating %d bytes for the context cache snapshot)", size + 1));
+
+  kjFastRender(treeP, buf);
+
+  uint32_t offset = stringAdd(wP, buf);
+  free(buf);
+
+  return offset;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextSerialize - returns the record index of the context
+//
+// Members of an array context are serialized before the array itself, so that, when loading,
+// an array only refers to contexts that have already been created.
+//
+static uint32_t contextSerialize(SnapshotWriter* wP, OrionldContext* contextP)
+{
+  for (uint32_t ix = 0; ix < wP->contexts; ix++)
+  {
+    if (wP->contextV[ix] == contextP)
+      return ix;
+  }
+
+  SnapshotContext  record;
+  uint32_t*        memberV = NULL;
+
+  bzero(&record, sizeof(record));
+
+  if (contextP->keyValues == false)
+  {
+    memberV = (uint32_t*) malloc((contextP->context.array.items + 1) * sizeof(uint32_t));
+    if (memberV == NULL)
+      LM_X(1, ("Out of memory (context cache snapshot)"));
+
+    for (int ix = 0; ix < contextP->context.array.items; ix++)
+    {
+      OrionldContext* memberP = contextP->context.array.vector[ix];
+      memberV[ix] = (memberP != NULL)? contextSerialize(wP, memberP) : SNAPSHOT_NONE;
+    }
+  }
+
+  record.createdAt = contextP->createdAt;
+  record.url       = stringAdd(wP, contextP->url);
+  record.id        = stringAdd(wP, contextP->id);
+  record.parent    = stringAdd(wP, contextP->parent);
+  record.origin    = contextP->origin;
+  record.kind      = contextP->kind;
+  record.tree      = SNAPSHOT_NONE;
+  record.firstWord = wP->words.used / sizeof(uint32_t);
+
+  if (contextP->coreContext == true)
+    record.flags |= SNAPSHOT_CORE_CONTEXT;
+
+  //
+  // A context that has been replaced in the cache (revalidation) may still be a member of an array.
+  // It's saved as a member but it doesn't go to the cache
+  //
+  if ((contextP->url != NULL) && (orionldContextCacheLookup(contextP->url) == contextP))
+  {
+    record.flags |= SNAPSHOT_CACHED;
+    record.tree   = treeAdd(wP, __atomic_load_n(&contextP->tree, __ATOMIC_ACQUIRE), &record.flags);
+  }
+
+  if (contextP->keyValues == true)
+  {
+    KHashTable* nameTableP = contextP->context.hash.nameHashTable;
+
+    record.flags |= SNAPSHOT_KEY_VALUES;
+
+    for (int slot = 0; slot < ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE; ++slot)
+    {
+      for (KHashListItem* listItemP = nameTableP->array[slot]; listItemP != NULL; listItemP = listItemP->next)
+      {
+        OrionldContextItem* itemP = (OrionldContextItem*) listItemP->data;
+
+        wordAdd(wP, stringAdd(wP, itemP->name));
+        wordAdd(wP, stringAdd(wP, itemP->id));
+        wordAdd(wP, stringAdd(wP, itemP->type));
+        ++record.items;
+      }
+    }
+  }
+  else
+  {
+    if (contextP->context.array.nameHashTable != NULL)
+      record.flags |= SNAPSHOT_MERGED;
+
+    for (int ix = 0; ix < contextP->context.array.items; ix++)
+      wordAdd(wP, memberV[ix]);
+
+    record.items = contextP->context.array.items;
+    free(memberV);
+  }
+
+  bufferAppend(&wP->records, &record, sizeof(record));
+
+  if (wP->contexts >= wP->contextSlots)
+  {
+    wP->contextSlots = (wP->contextSlots == 0)? 128 : wP->contextSlots * 2;
+    wP->contextV     = (OrionldContext**) realloc(wP->contextV, wP->contextSlots * sizeof(OrionldContext*));
+
+    if (wP->contextV == NULL)
+      LM_X(1, ("Out of memory (context cache snapshot)"));
+  }
+
+  wP->contextV[wP->contexts] = contextP;
+
+  return wP->contexts++;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// fileWrite -
+//
+static bool fileWrite(int fd, const char* buf, uint32_t len)
+{
+  while (len > 0)
+  {
+    ssize_t nb = write(fd, buf, len);
+
+    if (nb == -1)
+    {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+
+    buf += nb;
+    len -= nb;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotWrite -
+//
+// The snapshot is written to a temporary file that is then renamed, so that a reader (or a broker that
+// has the previous snapshot mapped) never sees a half-written file.
+//
+bool orionldContextCacheSnapshotWrite(const char* path)
+{
+  SnapshotWriter  writer;
+  SnapshotHeader  header;
+
+  if (orionldCoreContextP == NULL)  // The context cache was never initialized
+    return false;
+
+  bzero(&writer, sizeof(writer));
+  bzero(&header, sizeof(header));
+
+  bufferAppend(&writer.pool, "", 1);  // So that no string is at offset 0 - easier to debug
+
+  pthread_mutex_lock(&writeMutex);
+
+  //
+  // The database checksum is taken before the cache is walked.
+  // A context persisted/deleted in between makes the checksum not match the database at startup, and the snapshot is ignored.
+  // Contexts leave the cache only with the semaphore taken, but their trees are retired after that (reload, revalidation),
+  // so the cache is walked inside a read section
+  //
+  sem_wait(&orionldContextCacheSem);
+  epochEnter();
+
+  header.dbChecksum = __atomic_load_n(&dbChecksum, __ATOMIC_ACQUIRE);
+
+  for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
+  {
+    if (orionldContextCache[ix] != NULL)
+      contextSerialize(&writer, orionldContextCache[ix]);
+  }
+
+  epochLeave();
+  sem_post(&orionldContextCacheSem);
+
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.version      = SNAPSHOT_VERSION;
+  header.contexts     = writer.contexts;
+  header.words        = writer.words.used / sizeof(uint32_t);
+  header.coreContext  = stringAdd(&writer, coreContextUrl);
+  header.poolSize     = writer.pool.used;
+  header.hashSize     = ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE;
+
+  header.bodyChecksum = 0xCBF29CE484222325ULL;
+  header.bodyChecksum = fnv1a(header.bodyChecksum, writer.records.buf, writer.records.used);
+  header.bodyChecksum = fnv1a(header.bodyChecksum, writer.words.buf,   writer.words.used);
+  header.bodyChecksum = fnv1a(header.bodyChecksum, writer.pool.buf,    writer.pool.used);
+
+  char tmpPath[512];
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+  bool ok = false;
+  int  fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if (fd == -1)
+    LM_E(("Internal Error (unable to open '%s' for the context cache snapshot: %s)", tmpPath, strerror(errno)));
+  else
+  {
+    ok = fileWrite(fd, (const char*) &header, sizeof(header))         &&
+         fileWrite(fd, writer.records.buf, writer.records.used)       &&
+         fileWrite(fd, writer.words.buf,   writer.words.used)         &&
+         fileWrite(fd, writer.pool.buf,    writer.pool.used)          &&
+         (fsync(fd) == 0);
+
+    close(fd);
+
+    if (ok == false)
+    {
+      LM_E(("Internal Error (unable to write the context cache snapshot '%s': %s)", tmpPath, strerror(errno)));
+      unlink(tmpPath);
+    }
+    else if (rename(tmpPath, path) == -1)
+    {
+      LM_E(("Internal Error (unable to rename '%s' to '%s': %s)", tmpPath, path, strerror(errno)));
+      unlink(tmpPath);
+      ok = false;
+    }
+  }
+
+  pthread_mutex_unlock(&writeMutex);
+
+  if (ok == true)
+    LM_T(LmtContextCache, ("Context cache snapshot '%s': %u contexts, %u bytes", path, writer.contexts, (uint32_t) sizeof(header) + writer.records.used + writer.words.used + writer.pool.used));
+
+  free(writer.records.buf);
+  free(writer.words.buf);
+  free(writer.pool.buf);
+  free(writer.contextV);
+
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// zeroHash - for khashPrepends
+//
+static unsigned int zeroHash(const char* name)
+{
+  return 0;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nameCompareFunction -
+//
+static int nameCompareFunction(const char* name, void* itemP)
+{
+  OrionldContextItem* cItemP = (OrionldContextItem*) itemP;
+
+  return strcmp(name, cItemP->name);
+}
+
+
+
+// ----------------------------------------------------------------------------
+//
+// valueCompareFunction -
+//
+static int valueCompareFunction(const char* longname, void* itemP)
+{
+  OrionldContextItem* cItemP = (OrionldContextItem*) itemP;
+
+  return strcmp(longname, cItemP->id);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// khashPrepends - does khashItemAdd put a new item first in its slot?
+//
+// The terms are saved in the order of the lists of the name hash table.
+// To get the very same lists back, they're added in reverse if khashItemAdd prepends.
+//
+static bool khashPrepends(void)
+{
+  static OrionldContextItem a = { (char*) "a", NULL, NULL };
+  static OrionldContextItem b = { (char*) "b", NULL, NULL };
+  KHashTable*               tableP = khashTableCreate(&kalloc, zeroHash, nameCompareFunction, 1);
+
+  khashItemAdd(tableP, a.name, &a);
+  khashItemAdd(tableP, b.name, &b);
+
+  return (tableP->array[0]->data == &b);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// termTablesLoad - the name and value hash tables of a key-value context, pointing into the mapped string pool
+//
+static void termTablesLoad(OrionldContext* contextP, uint32_t* termV, uint32_t terms, char* pool, bool prepends)
+{
+  KHashTable*          nameTableP  = khashTableCreate(&kalloc, hashCode, nameCompareFunction,  ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
+  KHashTable*          valueTableP = khashTableCreate(&kalloc, hashCode, valueCompareFunction, ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
+  OrionldContextItem*  itemV       = (OrionldContextItem*) kaAlloc(&kalloc, (terms + 1) * sizeof(OrionldContextItem));
+
+  if ((nameTableP == NULL) || (valueTableP == NULL) || (itemV == NULL))
+    LM_X(1, ("Out of memory (loading the context cache snapshot)"));
+
+  for (uint32_t ix = 0; ix < terms; ix++)
+  {
+    uint32_t* termP = &termV[ix * 3];
+
+    itemV[ix].name = &pool[termP[0]];
+    itemV[ix].id   = &pool[termP[1]];
+    itemV[ix].type = (termP[2] != SNAPSHOT_NONE)? &pool[termP[2]] : NULL;
+  }
+
+  for (uint32_t ix = 0; ix < terms; ix++)
+  {
+    OrionldContextItem* itemP = (prepends == true)? &itemV[terms - 1 - ix] : &itemV[ix];
+    khashItemAdd(nameTableP, itemP->name, itemP);
+  }
+
+  // The value table is built exactly as orionldContextHashTablesFill does it
+  for (int slot = 0; slot < ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE; ++slot)
+  {
+    for (KHashListItem* listItemP = nameTableP->array[slot]; listItemP != NULL; listItemP = listItemP->next)
+    {
+      OrionldContextItem* itemP = (OrionldContextItem*) listItemP->data;
+      khashItemAdd(valueTableP, itemP->id, itemP);
+    }
+  }
+
+  contextP->context.hash.nameHashTable  = nameTableP;
+  contextP->context.hash.valueHashTable = valueTableP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// stringOk -
+//
+static inline bool stringOk(uint32_t offset, uint32_t poolSize, bool nullable)
+{
+  if (offset == SNAPSHOT_NONE)
+    return nullable;
+
+  return offset < poolSize;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// snapshotValidate - returns NULL if the snapshot is fine, otherwise the reason why it isn't
+//
+static const char* snapshotValidate(char* base, uint64_t size, KjNode** treeV)
+{
+  SnapshotHeader*   headerP  = (SnapshotHeader*) base;
+  SnapshotContext*  recordV  = (SnapshotContext*) &base[sizeof(SnapshotHeader)];
+  uint32_t*         wordV    = (uint32_t*) &recordV[headerP->contexts];
+  char*             pool     = (char*) &wordV[headerP->words];
+  uint32_t          poolSize = headerP->poolSize;
+  bool              core     = false;
+
+  for (uint32_t ix = 0; ix < headerP->contexts; ix++)
+  {
+    SnapshotContext* recP  = &recordV[ix];
+    bool             kv    = (recP->flags & SNAPSHOT_KEY_VALUES) != 0;
+    uint64_t         words = (uint64_t) recP->items * ((kv == true)? 3 : 1);
+
+    if (!stringOk(recP->url, poolSize, true) || !stringOk(recP->id, poolSize, true) || !stringOk(recP->parent, poolSize, true) || !stringOk(recP->tree, poolSize, true))
+      return "invalid string offset";
+
+    if ((uint64_t) recP->firstWord + words > headerP->words)
+      return "invalid word offset";
+
+    if (kv == true)
+    {
+      for (uint32_t tIx = 0; tIx < recP->items; tIx++)
+      {
+        uint32_t* termP = &wordV[recP->firstWord + tIx * 3];
+
+        if (!stringOk(termP[0], poolSize, false) || !stringOk(termP[1], poolSize, false) || !stringOk(termP[2], poolSize, true))
+          return "invalid term";
+      }
+    }
+    else
+    {
+      for (uint32_t mIx = 0; mIx < recP->items; mIx++)
+      {
+        uint32_t member = wordV[recP->firstWord + mIx];
+
+        if ((member != SNAPSHOT_NONE) && (member >= ix))
+          return "invalid array member";
+      }
+    }
+
+    if ((recP->flags & SNAPSHOT_CACHED) != 0)
+    {
+      if ((recP->url == SNAPSHOT_NONE) || (recP->tree == SNAPSHOT_NONE))
+        return "cached context without url or tree";
+
+      if ((recP->flags & SNAPSHOT_CORE_CONTEXT) != 0)
+        core = true;
+
+      //
+      // The trees are parsed here, before anything is created, so that a bad tree leaves the cache untouched.
+      // kjParse works in place - the mapping is private, the file isn't modified
+      //
+      if ((recP->flags & SNAPSHOT_TREE_STRING) == 0)
+      {
+        treeV[ix] = kjParse(orionldState.kjsonP, &pool[recP->tree]);
+        if (treeV[ix] == NULL)
+          return "invalid tree";
+      }
+    }
+  }
+
+  if (core == false)
+    return "no core context";
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotLoad -
+//
+bool orionldContextCacheSnapshotLoad(const char* path)
+{
+  int fd = open(path, O_RDONLY);
+
+  if (fd == -1)
+  {
+    if (errno == ENOENT)
+      LM_I(("No context cache snapshot (%s) - the context cache is built from the database", path));
+    else
+      LM_W(("Unable to open the context cache snapshot '%s' (%s) - the context cache is built from the database", path, strerror(errno)));
+    return false;
+  }
+
+  struct stat statBuf;
+  if ((fstat(fd, &statBuf) == -1) || ((uint64_t) statBuf.st_size < sizeof(SnapshotHeader)))
+  {
+    close(fd);
+    LM_W(("Context cache snapshot '%s' discarded (too small) - the context cache is built from the database", path));
+    return false;
+  }
+
+  uint64_t  size = statBuf.st_size;
+  char*     base = (char*) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+  close(fd);
+
+  if (base == MAP_FAILED)
+  {
+    LM_W(("Unable to map the context cache snapshot '%s' (%s) - the context cache is built from the database", path, strerror(errno)));
+    return false;
+  }
+
+  SnapshotHeader*  headerP = (SnapshotHeader*) base;
+  const char*      reason  = NULL;
+  KjNode**         treeV   = NULL;
+
+  if (memcmp(headerP->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+    reason = "not a context cache snapshot";
+  else if (headerP->version != SNAPSHOT_VERSION)
+    reason = "unsupported version";
+  else if (headerP->hashSize != ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE)
+    reason = "different hash table size";
+  else if (sizeof(SnapshotHeader) + (uint64_t) headerP->contexts * sizeof(SnapshotContext) + (uint64_t) headerP->words * sizeof(uint32_t) + headerP->poolSize != size)
+    reason = "invalid size";
+  else if ((headerP->poolSize == 0) || (base[size - 1] != 0))
+    reason = "invalid string pool";
+  else if (fnv1a(0xCBF29CE484222325ULL, &base[sizeof(SnapshotHeader)], size - sizeof(SnapshotHeader)) != headerP->bodyChecksum)
+    reason = "corrupt";
+  else if (headerP->dbChecksum != __atomic_load_n(&dbChecksum, __ATOMIC_ACQUIRE))
+    reason = "the contexts in the database have changed";
+  else if ((headerP->coreContext >= headerP->poolSize) || (strcmp(&base[size - headerP->poolSize + headerP->coreContext], coreContextUrl) != 0))
+    reason = "different core context";
+  else
+  {
+    treeV = (KjNode**) calloc(headerP->contexts + 1, sizeof(KjNode*));
+    if (treeV == NULL)
+      LM_X(1, ("Out of memory (loading the context cache snapshot)"));
+
+    reason = snapshotValidate(base, size, treeV);
+  }
+
+  if (reason != NULL)
+  {
+    LM_W(("Context cache snapshot '%s' discarded (%s) - the context cache is built from the database", path, reason));
+    free(treeV);
+    munmap(base, size);
+    return false;
+  }
+
+  //
+  // All good - create the contexts
+  //
+  SnapshotContext*  recordV   = (SnapshotContext*) &base[sizeof(SnapshotHeader)];
+  uint32_t*         wordV     = (uint32_t*) &recordV[headerP->contexts];
+  char*             pool      = (char*) &wordV[headerP->words];
+  OrionldContext**  contextV  = (OrionldContext**) calloc(headerP->contexts + 1, sizeof(OrionldContext*));
+  bool              prepends  = khashPrepends();
+  uint32_t          cached    = 0;
+
+  if (contextV == NULL)
+    LM_X(1, ("Out of memory (loading the context cache snapshot)"));
+
+  for (uint32_t ix = 0; ix < headerP->contexts; ix++)
+  {
+    SnapshotContext*      recP      = &recordV[ix];
+    bool                  kv        = (recP->flags & SNAPSHOT_KEY_VALUES) != 0;
+    OrionldContextOrigin  origin    = (OrionldContextOrigin) recP->origin;
+    char*                 url       = (recP->url    != SNAPSHOT_NONE)? &pool[recP->url]    : NULL;
+    char*                 id        = (recP->id     != SNAPSHOT_NONE)? &pool[recP->id]     : NULL;
+    OrionldContext*       contextP;
+
+    if ((recP->flags & SNAPSHOT_CACHED) != 0)
+    {
+      KjNode* treeP = treeV[ix];
+
+      if ((recP->flags & SNAPSHOT_TREE_STRING) != 0)
+        treeP = kjString(orionldState.kjsonP, NULL, &pool[recP->tree]);
+
+      contextP = orionldContextCreate(url, origin, id, treeP, kv);
+    }
+    else
+    {
+      contextP      = orionldContextCreate(NULL, origin, NULL, NULL, kv);
+      contextP->url = url;
+      contextP->id  = id;
+    }
+
+    contextP->parent      = (recP->parent != SNAPSHOT_NONE)? &pool[recP->parent] : NULL;
+    contextP->kind        = (OrionldContextKind) recP->kind;
+    contextP->createdAt   = recP->createdAt;
+    contextP->usedAt      = 0;
+    contextP->coreContext = ((recP->flags & SNAPSHOT_CORE_CONTEXT) != 0);
+
+    if (kv == true)
+      termTablesLoad(contextP, &wordV[recP->firstWord], recP->items, pool, prepends);
+    else
+    {
+      contextP->context.array.items          = recP->items;
+      contextP->context.array.vector         = (OrionldContext**) kaAlloc(&kalloc, (recP->items + 1) * sizeof(OrionldContext*));
+      contextP->context.array.nameHashTable  = NULL;
+      contextP->context.array.valueHashTable = NULL;
+
+      for (uint32_t mIx = 0; mIx < recP->items; mIx++)
+      {
+        uint32_t member = wordV[recP->firstWord + mIx];
+        contextP->context.array.vector[mIx] = (member != SNAPSHOT_NONE)? contextV[member] : NULL;
+      }
+
+      if ((recP->flags & SNAPSHOT_MERGED) != 0)
+        orionldContextArrayMerge(contextP, &kalloc);
+    }
+
+    if ((recP->flags & SNAPSHOT_CACHED) != 0)
+    {
+      if (contextP->coreContext == true)
+        orionldCoreContextP = contextP;
+
+      orionldContextCacheInsert(contextP);
+      ++cached;
+    }
+
+    contextV[ix] = contextP;
+  }
+
+  free(contextV);
+  free(treeV);
+
+  LM_I(("Context cache loaded from snapshot '%s' (%u contexts)", path, cached));
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextSnapshotThread -
+//
+static void* contextSnapshotThread(void* vP)
+{
+  while (1)
+  {
+    sleep(contextSnapshotInterval);
+    orionldContextCacheSnapshotWrite(contextSnapshotFile);
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotStart -
+//
+bool orionldContextCacheSnapshotStart(void)
+{
+  if ((contextSnapshotFile[0] == 0) || (contextSnapshotInterval == 0))
+    return true;
+
+  pthread_t tid;
+  if (pthread_create(&tid, NULL, contextSnapshotThread, NULL) != 0)
+  {
+    LM_E(("Internal Error (unable to create the context cache snapshot thread)"));
+    return false;
+  }
+
+  pthread_detach(tid);
+
+  return true;
+}
@@ -0,0 +1,92 @@
+#ifndef SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHESNAPSHOT_H_
+#define SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHESNAPSHOT_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotDbChecksum - checksum of the contexts in the database (mongocContextCacheSummaryGet)
+//
+// Each context contributes its url, _id and createdAt (the time the context was written to the database).
+// The checksum is kept up to date as contexts are persisted and deleted, and it's saved in the snapshot.
+// A snapshot is only used at startup if its checksum is the same as the one of the contexts found in the database.
+//
+extern uint64_t orionldContextCacheSnapshotDbChecksum(KjNode* contextArray);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotPersisted - a context has been inserted in the database
+//
+extern void orionldContextCacheSnapshotPersisted(OrionldContext* contextP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotDeleted - a context has been removed from the database
+//
+extern void orionldContextCacheSnapshotDeleted(OrionldContext* contextP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotLoad - populate the context cache from a snapshot file
+//
+// Returns false (and nothing is touched) if the snapshot is missing, corrupt or stale -
+// the context cache is then to be built from the database, as usual.
+//
+extern bool orionldContextCacheSnapshotLoad(const char* path);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotWrite - save the context cache, term tables included, in a snapshot file
+//
+extern bool orionldContextCacheSnapshotWrite(const char* path);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldContextCacheSnapshotStart - start the thread that writes the snapshot every -ctxSnapshotInterval seconds
+//
+extern bool orionldContextCacheSnapshotStart(void);
+
+#endif  // SRC_LIB_ORIONLD_CONTEXTCACHE_ORIONLDCONTEXTCACHESNAPSHOT_H_
@@ -0,0 +1,212 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // calloc, atoi
+#include <string.h>                                              // strdup, strncpy, strchr, strncmp
+#include <math.h>                                                // cos, M_PI
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/OrionldGeometry.h"                       // OrionldGeometry, orionldGeometryFromString
+#include "orionld/types/OrionldGeorel.h"                         // OrionldGeorel, orionldGeorelFromString
+#include "orionld/types/GeoCompiled.h"                           // GeoCompiled
+#include "orionld/common/eqForDot.h"                             // eqForDot
+#include "orionld/geo/geoShapeBuild.h"                           // geoShapeBuild
+#include "orionld/geo/geoCompiledRelease.h"                      // geoCompiledRelease
+#include "orionld/geo/geoCompile.h"                              // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// METERS_PER_DEGREE - length of one degree of latitude (and of longitude at the equator), in meters
+//
+#define METERS_PER_DEGREE  111320.0
+
+
+
+// -----------------------------------------------------------------------------
+//
+// georelParse - "near;maxDistance==1000", "within", ...
+//
+static bool georelParse(GeoCompiled* gcP, const char* georel)
+{
+  char  grel[128];
+  char* extra;
+
+  strncpy(grel, georel, sizeof(grel) - 1);
+  grel[sizeof(grel) - 1] = 0;
+
+  if ((extra = strchr(grel, ';')) != NULL)
+  {
+    *extra = 0;
+    ++extra;
+  }
+
+  gcP->georel = orionldGeorelFromString(grel);
+  if (gcP->georel == GeorelNone)
+    return false;
+
+  while (extra != NULL)
+  {
+    char* next = strchr(extra, ';');
+
+    if (next != NULL)
+      *next++ = 0;
+
+    if (strncmp(extra, "maxDistance==", 13) == 0)
+      gcP->maxDistance = atoi(&extra[13]);
+    else if (strncmp(extra, "minDistance==", 13) == 0)
+      gcP->minDistance = atoi(&extra[13]);
+    else
+      return false;
+
+    extra = next;
+  }
+
+  if ((gcP->georel == GeorelNear) && (gcP->maxDistance <= 0) && (gcP->minDistance <= 0))
+    return false;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nearBox - the box of all points at a distance of at most 'maxDistance' meters from the point
+//
+// Slightly too big, which is what we want, as the box is only used to reject entities.
+//
+static void nearBox(GeoCompiled* gcP)
+{
+  double lon    = gcP->shape.pathV[0].coordV[0];
+  double lat    = gcP->shape.pathV[0].coordV[1];
+  double dLat   = (gcP->maxDistance / METERS_PER_DEGREE) * 1.01;
+  double cosLat = cos(lat * M_PI / 180.0);
+
+  gcP->box.minLat = lat - dLat;
+  gcP->box.maxLat = lat + dLat;
+
+  //
+  // Close to the poles, or if the box would cross the antimeridian, the entire range of longitudes is used
+  //
+  double dLon = (cosLat > 0.01)? dLat / cosLat : 360;
+
+  if ((gcP->box.minLat < -90) || (gcP->box.maxLat > 90) || (lon - dLon < -180) || (lon + dLon > 180))
+  {
+    gcP->box.minLon = -180;
+    gcP->box.maxLon =  180;
+  }
+  else
+  {
+    gcP->box.minLon = lon - dLon;
+    gcP->box.maxLon = lon + dLon;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoCompile -
+//
+GeoCompiled* geoCompile(const char* geometry, const char* georel, const char* geoProperty, KjNode* coordinatesP)
+{
+  if ((geometry == NULL) || (georel == NULL) || (coordinatesP == NULL))
+    return NULL;
+
+  GeoCompiled* gcP = (GeoCompiled*) calloc(1, sizeof(GeoCompiled));
+
+  if (gcP == NULL)
+  {
+    LM_E(("Out of memory allocating a compiled geoQ"));
+    return NULL;
+  }
+
+  if ((geoProperty == NULL) || (*geoProperty == 0))
+    gcP->geoProperty = strdup("location");
+  else
+  {
+    gcP->geoProperty = strdup(geoProperty);
+    eqForDot(gcP->geoProperty);
+  }
+
+  OrionldGeometry geometryType = orionldGeometryFromString(geometry);
+
+  if (geometryType == GeoNoGeometry)
+  {
+    LM_W(("Invalid geoQ geometry: '%s'", geometry));
+    geoCompiledRelease(gcP);
+    return NULL;
+  }
+
+  if (georelParse(gcP, georel) == false)
+  {
+    LM_W(("Invalid geoQ georel: '%s'", georel));
+    geoCompiledRelease(gcP);
+    return NULL;
+  }
+
+  if (geoShapeBuild(&gcP->shape, geometryType, coordinatesP, NULL) == false)
+  {
+    LM_W(("Invalid geoQ coordinates for geometry '%s'", geometry));
+    geoCompiledRelease(gcP);
+    return NULL;
+  }
+
+  if ((gcP->georel == GeorelNear) && (geometryType != GeoPoint))
+  {
+    LM_W(("Invalid geoQ - georel 'near' needs a Point, not a '%s'", geometry));
+    geoCompiledRelease(gcP);
+    return NULL;
+  }
+
+  //
+  // The rejection box
+  // - near;maxDistance:                 the point, grown by maxDistance in all directions
+  // - disjoint, near;minDistance:       no rejection possible - far away entities DO match
+  // - within/intersects/overlaps/...:   the box of the geometry itself
+  //
+  if (gcP->georel == GeorelNear)
+  {
+    gcP->boxReject = (gcP->maxDistance > 0);
+    if (gcP->boxReject == true)
+      nearBox(gcP);
+  }
+  else if (gcP->georel == GeorelDisjoint)
+    gcP->boxReject = false;
+  else
+  {
+    gcP->box       = gcP->shape.box;
+    gcP->boxReject = true;
+  }
+
+  return gcP;
+}
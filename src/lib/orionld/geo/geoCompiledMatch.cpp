@@ -0,0 +1,135 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjLookup.h"                                      // kjLookup
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                   // LmtSubCacheMatch
+
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/types/OrionldGeometry.h"                       // orionldGeometryFromString
+#include "orionld/types/GeoCompiled.h"                           // GeoCompiled, GcShape
+#include "orionld/geo/geoShapeBuild.h"                           // geoShapeBuild
+#include "orionld/geo/geoBoxIntersects.h"                        // geoBoxIntersects
+#include "orionld/geo/geoShapeDistance.h"                        // geoShapeDistance
+#include "orionld/geo/geoShapeIntersects.h"                      // geoShapeIntersects
+#include "orionld/geo/geoShapeWithin.h"                          // geoShapeWithin
+#include "orionld/geo/geoShapeEquals.h"                          // geoShapeEquals
+#include "orionld/geo/geoCompiledMatch.h"                        // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoInstanceMatch - match one instance of the geo-property
+//
+static bool geoInstanceMatch(GeoCompiled* gcP, KjNode* instanceP)
+{
+  if (instanceP->type != KjObject)
+    return false;
+
+  KjNode* valueP = kjLookup(instanceP, "value");
+
+  if ((valueP == NULL) || (valueP->type != KjObject))
+    return false;
+
+  KjNode* typeP        = kjLookup(valueP, "type");
+  KjNode* coordinatesP = kjLookup(valueP, "coordinates");
+
+  if ((typeP == NULL) || (typeP->type != KjString) || (coordinatesP == NULL))
+    return false;
+
+  GcShape shape;
+
+  if (geoShapeBuild(&shape, orionldGeometryFromString(typeP->value.s), coordinatesP, &orionldState.kalloc) == false)
+  {
+    LM_T(LmtSubCacheMatch, ("Invalid GeoJSON geometry '%s' for the geo-property '%s'", typeP->value.s, gcP->geoProperty));
+    return false;
+  }
+
+  if ((gcP->boxReject == true) && (geoBoxIntersects(&shape.box, &gcP->box) == false))
+    return false;
+
+  switch (gcP->georel)
+  {
+  case GeorelNear:
+    {
+      double distance = geoShapeDistance(gcP->shape.pathV[0].coordV[0], gcP->shape.pathV[0].coordV[1], &shape);
+
+      if ((gcP->maxDistance > 0) && (distance > gcP->maxDistance))
+        return false;
+      if ((gcP->minDistance > 0) && (distance < gcP->minDistance))
+        return false;
+
+      return true;
+    }
+
+  case GeorelWithin:      return geoShapeWithin(&shape, &gcP->shape);
+  case GeorelContains:    return geoShapeWithin(&gcP->shape, &shape);
+  case GeorelIntersects:  return geoShapeIntersects(&shape, &gcP->shape);
+  case GeorelOverlaps:    return geoShapeIntersects(&shape, &gcP->shape);  // Same as for entity queries ($geoIntersects)
+  case GeorelDisjoint:    return (geoShapeIntersects(&shape, &gcP->shape) == false);
+  case GeorelEquals:      return geoShapeEquals(&shape, &gcP->shape);
+  case GeorelNone:        break;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoCompiledMatch -
+//
+bool geoCompiledMatch(GeoCompiled* gcP, KjNode* entityP)
+{
+  if (entityP == NULL)
+    return false;
+
+  KjNode* attrP = kjLookup(entityP, gcP->geoProperty);
+
+  if (attrP == NULL)
+    return false;
+
+  if (attrP->type != KjArray)
+    return geoInstanceMatch(gcP, attrP);
+
+  //
+  // Multi-attribute - it's enough that one of the instances matches
+  //
+  for (KjNode* instanceP = attrP->value.firstChildP; instanceP != NULL; instanceP = instanceP->next)
+  {
+    if (geoInstanceMatch(gcP, instanceP) == true)
+      return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,56 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <math.h>                                                // sin, cos, asin, sqrt, M_PI
+
+#include "orionld/geo/geoDistance.h"                             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// EARTH_RADIUS - radius of the Earth, in meters - the same value that mongodb uses for $nearSphere
+//
+#define EARTH_RADIUS  6378100.0
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoDistance -
+//
+double geoDistance(double lon1, double lat1, double lon2, double lat2)
+{
+  double toRad = M_PI / 180.0;
+  double dLat  = (lat2 - lat1) * toRad;
+  double dLon  = (lon2 - lon1) * toRad;
+  double sLat  = sin(dLat / 2);
+  double sLon  = sin(dLon / 2);
+  double a     = sLat * sLat + cos(lat1 * toRad) * cos(lat2 * toRad) * sLon * sLon;
+
+  if (a > 1)
+    a = 1;
+
+  return 2 * EARTH_RADIUS * asin(sqrt(a));
+}
@@ -0,0 +1,90 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/GeoCompiled.h"                           // GcShape, GcPolygon, GcPath
+#include "orionld/geo/geoSegmentsIntersect.h"                    // geoSegmentsIntersect
+#include "orionld/geo/geoPointInPolygon.h"                       // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ringContains - ray casting, returns 1 if inside, 0 if outside and -1 if on the boundary of the ring
+//
+// The ring needs not be closed (first position == last position), it is closed implicitly.
+//
+static int ringContains(const GcPath* ringP, double lon, double lat)
+{
+  const double* coordV = ringP->coordV;
+  int           points = ringP->points;
+  bool          inside = false;
+  double        point[2] = { lon, lat };
+
+  for (int ix = 0, prev = points - 1; ix < points; prev = ix++)
+  {
+    const double* aP = &coordV[prev * 2];
+    const double* bP = &coordV[ix * 2];
+
+    if (geoSegmentsIntersect(aP, bP, point, point) == true)
+      return -1;
+
+    if ((bP[1] > lat) != (aP[1] > lat))
+    {
+      double crossLon = (aP[0] - bP[0]) * (lat - bP[1]) / (aP[1] - bP[1]) + bP[0];
+
+      if (lon < crossLon)
+        inside = !inside;
+    }
+  }
+
+  return (inside == true)? 1 : 0;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoPointInPolygon -
+//
+bool geoPointInPolygon(const GcShape* shapeP, const GcPolygon* polygonP, double lon, double lat)
+{
+  if ((lon < polygonP->box.minLon) || (lon > polygonP->box.maxLon) || (lat < polygonP->box.minLat) || (lat > polygonP->box.maxLat))
+    return false;
+
+  int inExterior = ringContains(&shapeP->pathV[polygonP->firstPath], lon, lat);
+
+  if (inExterior == 0)
+    return false;
+  if (inExterior == -1)
+    return true;
+
+  for (int ix = 1; ix < polygonP->rings; ix++)
+  {
+    // Inside a hole means outside the polygon - on the edge of the hole is still the boundary of the polygon
+    if (ringContains(&shapeP->pathV[polygonP->firstPath + ix], lon, lat) == 1)
+      return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,84 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/geo/geoSegmentsIntersect.h"                    // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orientation - sign of the cross product (q - p) x (r - p): 1 (counter-clockwise), -1 (clockwise) or 0 (collinear)
+//
+static int orientation(const double* p, const double* q, const double* r)
+{
+  double cross = (q[0] - p[0]) * (r[1] - p[1]) - (q[1] - p[1]) * (r[0] - p[0]);
+
+  if (cross > 0) return 1;
+  if (cross < 0) return -1;
+
+  return 0;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// onSegment - given that p, q and r are collinear - is q on the segment p-r?
+//
+static bool onSegment(const double* p, const double* q, const double* r)
+{
+  double minX = (p[0] < r[0])? p[0] : r[0];
+  double maxX = (p[0] < r[0])? r[0] : p[0];
+  double minY = (p[1] < r[1])? p[1] : r[1];
+  double maxY = (p[1] < r[1])? r[1] : p[1];
+
+  return ((q[0] >= minX) && (q[0] <= maxX) && (q[1] >= minY) && (q[1] <= maxY));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoSegmentsIntersect -
+//
+// Planar, on lon/lat - just like mongodb does for 2d indexes (for 2dsphere indexes, mongodb uses geodesic edges,
+// which makes a difference only for very long edges).
+//
+bool geoSegmentsIntersect(const double* p1, const double* q1, const double* p2, const double* q2)
+{
+  int o1 = orientation(p1, q1, p2);
+  int o2 = orientation(p1, q1, q2);
+  int o3 = orientation(p2, q2, p1);
+  int o4 = orientation(p2, q2, q1);
+
+  if ((o1 != o2) && (o3 != o4))
+    return true;
+
+  if ((o1 == 0) && onSegment(p1, p2, q1)) return true;
+  if ((o2 == 0) && onSegment(p1, q2, q1)) return true;
+  if ((o3 == 0) && onSegment(p2, p1, q2)) return true;
+  if ((o4 == 0) && onSegment(p2, q1, q2)) return true;
+
+  return false;
+}
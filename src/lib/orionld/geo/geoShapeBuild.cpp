@@ -0,0 +1,328 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc
+
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                       // KAlloc
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+#include "orionld/types/OrionldGeometry.h"                       // OrionldGeometry
+#include "orionld/types/GeoCompiled.h"                           // GcShape, GcPath, GcPolygon, GcBox
+#include "orionld/geo/geoShapeBuild.h"                           // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoAlloc -
+//
+static void* geoAlloc(KAlloc* kallocP, int size)
+{
+  return (kallocP != NULL)? kaAlloc(kallocP, size) : malloc(size);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// arrayItems -
+//
+static int arrayItems(KjNode* arrayP)
+{
+  if (arrayP->type != KjArray)
+    return -1;
+
+  int items = 0;
+  for (KjNode* itemP = arrayP->value.firstChildP; itemP != NULL; itemP = itemP->next)
+  {
+    ++items;
+  }
+
+  return items;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// boxExtend -
+//
+static void boxExtend(GcBox* boxP, double lon, double lat)
+{
+  if (lon < boxP->minLon) boxP->minLon = lon;
+  if (lon > boxP->maxLon) boxP->maxLon = lon;
+  if (lat < boxP->minLat) boxP->minLat = lat;
+  if (lat > boxP->maxLat) boxP->maxLat = lat;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// numberGet -
+//
+static bool numberGet(KjNode* nodeP, double* valueP)
+{
+  if (nodeP == NULL)
+    return false;
+
+  if (nodeP->type == KjFloat)
+    *valueP = nodeP->value.f;
+  else if (nodeP->type == KjInt)
+    *valueP = (double) nodeP->value.i;
+  else
+    return false;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// positionGet - [ lon, lat ] or [ lon, lat, altitude ]
+//
+static bool positionGet(KjNode* positionP, double* coordP)
+{
+  if (positionP->type != KjArray)
+    return false;
+
+  KjNode* lonP = positionP->value.firstChildP;
+  KjNode* latP = (lonP != NULL)? lonP->next : NULL;
+
+  if ((numberGet(lonP, &coordP[0]) == false) || (numberGet(latP, &coordP[1]) == false))
+    return false;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pathFill - one single position (pointP != NULL) or an array of positions
+//
+static bool pathFill(GcShape* shapeP, GcPath* pathP, KjNode* pointP, KjNode* positionsP, KAlloc* kallocP)
+{
+  int points = (pointP != NULL)? 1 : arrayItems(positionsP);
+
+  if (points <= 0)
+    return false;
+
+  pathP->coordV = (double*) geoAlloc(kallocP, points * 2 * sizeof(double));
+  pathP->points = points;
+  pathP->ring   = false;
+
+  if (pathP->coordV == NULL)
+    return false;
+
+  if (pointP != NULL)
+  {
+    if (positionGet(pointP, pathP->coordV) == false)
+      return false;
+  }
+  else
+  {
+    double* coordP = pathP->coordV;
+
+    for (KjNode* positionP = positionsP->value.firstChildP; positionP != NULL; positionP = positionP->next)
+    {
+      if (positionGet(positionP, coordP) == false)
+        return false;
+      coordP += 2;
+    }
+  }
+
+  for (int ix = 0; ix < points; ix++)
+  {
+    boxExtend(&shapeP->box, pathP->coordV[ix * 2], pathP->coordV[ix * 2 + 1]);
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// polygonFill - an array of rings
+//
+static bool polygonFill(GcShape* shapeP, GcPolygon* polygonP, KjNode* ringsP, KAlloc* kallocP)
+{
+  polygonP->firstPath = shapeP->paths;
+  polygonP->rings     = 0;
+
+  for (KjNode* ringP = ringsP->value.firstChildP; ringP != NULL; ringP = ringP->next)
+  {
+    GcPath* pathP = &shapeP->pathV[shapeP->paths++];
+
+    if (pathFill(shapeP, pathP, NULL, ringP, kallocP) == false)
+      return false;
+
+    pathP->ring = true;
+    ++polygonP->rings;
+  }
+
+  //
+  // The box of the polygon is the box of its exterior ring
+  //
+  GcPath* exteriorP = &shapeP->pathV[polygonP->firstPath];
+
+  polygonP->box.minLon = polygonP->box.maxLon = exteriorP->coordV[0];
+  polygonP->box.minLat = polygonP->box.maxLat = exteriorP->coordV[1];
+
+  for (int ix = 1; ix < exteriorP->points; ix++)
+  {
+    boxExtend(&polygonP->box, exteriorP->coordV[ix * 2], exteriorP->coordV[ix * 2 + 1]);
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pathsCount - the number of paths needed for the geometry, -1 if the coordinates are invalid
+//
+static int pathsCount(OrionldGeometry geometry, KjNode* coordinatesP, int* polygonsP)
+{
+  int paths = 0;
+
+  *polygonsP = 0;
+
+  switch (geometry)
+  {
+  case GeoPoint:
+  case GeoLineString:
+    return 1;
+
+  case GeoMultiPoint:
+  case GeoMultiLineString:
+    return arrayItems(coordinatesP);
+
+  case GeoPolygon:
+    *polygonsP = 1;
+    return arrayItems(coordinatesP);
+
+  case GeoMultiPolygon:
+    for (KjNode* polygonP = coordinatesP->value.firstChildP; polygonP != NULL; polygonP = polygonP->next)
+    {
+      int rings = arrayItems(polygonP);
+
+      if (rings <= 0)
+        return -1;
+
+      paths      += rings;
+      *polygonsP += 1;
+    }
+    return paths;
+
+  case GeoNoGeometry:
+    break;
+  }
+
+  return -1;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoShapeBuild -
+//
+bool geoShapeBuild(GcShape* shapeP, OrionldGeometry geometry, KjNode* coordinatesP, KAlloc* kallocP)
+{
+  int polygons;
+
+  shapeP->geometry = geometry;
+  shapeP->pathV    = NULL;
+  shapeP->paths    = 0;
+  shapeP->polygonV = NULL;
+  shapeP->polygons = 0;
+
+  shapeP->box.minLon =  180;
+  shapeP->box.minLat =   90;
+  shapeP->box.maxLon = -180;
+  shapeP->box.maxLat =  -90;
+
+  if ((coordinatesP == NULL) || (coordinatesP->type != KjArray))
+    return false;
+
+  int paths = pathsCount(geometry, coordinatesP, &polygons);
+
+  if (paths <= 0)
+    return false;
+
+  shapeP->pathV = (GcPath*) geoAlloc(kallocP, paths * sizeof(GcPath));
+  if (shapeP->pathV == NULL)
+    return false;
+
+  //
+  // Zeroing the paths, for geoShapeRelease to be able to free a half-built shape
+  //
+  for (int ix = 0; ix < paths; ix++)
+  {
+    shapeP->pathV[ix].coordV = NULL;
+    shapeP->pathV[ix].points = 0;
+    shapeP->pathV[ix].ring   = false;
+  }
+
+  if (polygons > 0)
+  {
+    shapeP->polygonV = (GcPolygon*) geoAlloc(kallocP, polygons * sizeof(GcPolygon));
+    if (shapeP->polygonV == NULL)
+      return false;
+  }
+
+  if (geometry == GeoPoint)
+    return pathFill(shapeP, &shapeP->pathV[shapeP->paths++], coordinatesP, NULL, kallocP);
+
+  if (geometry == GeoLineString)
+    return pathFill(shapeP, &shapeP->pathV[shapeP->paths++], NULL, coordinatesP, kallocP);
+
+  if (geometry == GeoPolygon)
+    return polygonFill(shapeP, &shapeP->polygonV[shapeP->polygons++], coordinatesP, kallocP);
+
+  for (KjNode* itemP = coordinatesP->value.firstChildP; itemP != NULL; itemP = itemP->next)
+  {
+    bool ok;
+
+    if (geometry == GeoMultiPoint)
+      ok = pathFill(shapeP, &shapeP->pathV[shapeP->paths++], itemP, NULL, kallocP);
+    else if (geometry == GeoMultiLineString)
+      ok = pathFill(shapeP, &shapeP->pathV[shapeP->paths++], NULL, itemP, kallocP);
+    else
+      ok = polygonFill(shapeP, &shapeP->polygonV[shapeP->polygons++], itemP, kallocP);
+
+    if (ok == false)
+      return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,99 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <math.h>                                                // cos, M_PI
+
+#include "orionld/types/GeoCompiled.h"                           // GcShape, GcPath
+#include "orionld/geo/geoDistance.h"                             // geoDistance
+#include "orionld/geo/geoPointInPolygon.h"                       // geoPointInPolygon
+#include "orionld/geo/geoShapeDistance.h"                        // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// segmentDistance - distance from a position to the closest point of the segment a-b
+//
+// The closest point is found in a local equirectangular projection, centered at the position,
+// and its distance is then measured along the great circle.
+//
+static double segmentDistance(double lon, double lat, const double* aP, const double* bP)
+{
+  double kx = cos(lat * M_PI / 180.0);
+  double ax = (aP[0] - lon) * kx;
+  double ay = aP[1] - lat;
+  double dx = (bP[0] - aP[0]) * kx;
+  double dy = bP[1] - aP[1];
+  double d2 = dx * dx + dy * dy;
+  double t  = (d2 > 0)? -(ax * dx + ay * dy) / d2 : 0;
+
+  if (t < 0) t = 0;
+  if (t > 1) t = 1;
+
+  return geoDistance(lon, lat, aP[0] + t * (bP[0] - aP[0]), aP[1] + t * (bP[1] - aP[1]));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoShapeDistance -
+//
+double geoShapeDistance(double lon, double lat, const GcShape* shapeP)
+{
+  for (int ix = 0; ix < shapeP->polygons; ix++)
+  {
+    if (geoPointInPolygon(shapeP, &shapeP->polygonV[ix], lon, lat) == true)
+      return 0;
+  }
+
+  double minDistance = -1;
+
+  for (int pIx = 0; pIx < shapeP->paths; pIx++)
+  {
+    const GcPath*  pathP    = &shapeP->pathV[pIx];
+    int            segments = (pathP->ring == true)? pathP->points : pathP->points - 1;
+    double         distance;
+
+    if (pathP->points == 1)
+    {
+      distance = geoDistance(lon, lat, pathP->coordV[0], pathP->coordV[1]);
+
+      if ((minDistance < 0) || (distance < minDistance))
+        minDistance = distance;
+
+      continue;
+    }
+
+    for (int ix = 0; ix < segments; ix++)
+    {
+      distance = segmentDistance(lon, lat, &pathP->coordV[ix * 2], &pathP->coordV[((ix + 1) % pathP->points) * 2]);
+
+      if ((minDistance < 0) || (distance < minDistance))
+        minDistance = distance;
+    }
+  }
+
+  return minDistance;
+}
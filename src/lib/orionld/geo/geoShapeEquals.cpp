@@ -0,0 +1,71 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <math.h>                                                // fabs
+
+#include "orionld/types/GeoCompiled.h"                           // GcShape, GcPath
+#include "orionld/geo/geoShapeEquals.h"                          // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// GEO_EPSILON - positions closer than this (in degrees, about 0.1 mm) are considered equal
+//
+#define GEO_EPSILON  1e-9
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoShapeEquals -
+//
+bool geoShapeEquals(const GcShape* aP, const GcShape* bP)
+{
+  if ((aP->geometry != bP->geometry) || (aP->paths != bP->paths) || (aP->polygons != bP->polygons))
+    return false;
+
+  for (int pIx = 0; pIx < aP->paths; pIx++)
+  {
+    const GcPath* aPathP = &aP->pathV[pIx];
+    const GcPath* bPathP = &bP->pathV[pIx];
+
+    if (aPathP->points != bPathP->points)
+      return false;
+
+    for (int ix = 0; ix < aPathP->points * 2; ix++)
+    {
+      if (fabs(aPathP->coordV[ix] - bPathP->coordV[ix]) > GEO_EPSILON)
+        return false;
+    }
+  }
+
+  for (int ix = 0; ix < aP->polygons; ix++)
+  {
+    if (aP->polygonV[ix].rings != bP->polygonV[ix].rings)
+      return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,128 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/GeoCompiled.h"                           // GcShape, GcPath, GcPolygon
+#include "orionld/geo/geoBoxIntersects.h"                        // geoBoxIntersects
+#include "orionld/geo/geoSegmentsIntersect.h"                    // geoSegmentsIntersect
+#include "orionld/geo/geoPointInPolygon.h"                       // geoPointInPolygon
+#include "orionld/geo/geoShapeIntersects.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pathSegments - a single point is one (degenerate) segment, a ring has its closing segment
+//
+static inline int pathSegments(const GcPath* pathP)
+{
+  if (pathP->points == 1)
+    return 1;
+
+  return (pathP->ring == true)? pathP->points : pathP->points - 1;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pathsIntersect - do any two segments of the paths touch or cross?
+//
+static bool pathsIntersect(const GcPath* aP, const GcPath* bP)
+{
+  int aSegments = pathSegments(aP);
+  int bSegments = pathSegments(bP);
+
+  for (int aIx = 0; aIx < aSegments; aIx++)
+  {
+    const double* a1 = &aP->coordV[aIx * 2];
+    const double* a2 = &aP->coordV[((aIx + 1) % aP->points) * 2];
+
+    for (int bIx = 0; bIx < bSegments; bIx++)
+    {
+      const double* b1 = &bP->coordV[bIx * 2];
+      const double* b2 = &bP->coordV[((bIx + 1) % bP->points) * 2];
+
+      if (geoSegmentsIntersect(a1, a2, b1, b2) == true)
+        return true;
+    }
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pathInsideAnyPolygon - is the first position of the path inside any of the polygons of the shape?
+//
+static bool pathInsideAnyPolygon(const GcPath* pathP, const GcShape* shapeP)
+{
+  for (int ix = 0; ix < shapeP->polygons; ix++)
+  {
+    if (geoPointInPolygon(shapeP, &shapeP->polygonV[ix], pathP->coordV[0], pathP->coordV[1]) == true)
+      return true;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoShapeIntersects -
+//
+// If no edge of A touches or crosses any edge of B, then every path of A is either completely inside or completely
+// outside each polygon of B (and vice versa). So, after the edges have been checked, it's enough to check one single
+// position per path for containment.
+//
+bool geoShapeIntersects(const GcShape* aP, const GcShape* bP)
+{
+  if (geoBoxIntersects(&aP->box, &bP->box) == false)
+    return false;
+
+  for (int aIx = 0; aIx < aP->paths; aIx++)
+  {
+    for (int bIx = 0; bIx < bP->paths; bIx++)
+    {
+      if (pathsIntersect(&aP->pathV[aIx], &bP->pathV[bIx]) == true)
+        return true;
+    }
+  }
+
+  for (int aIx = 0; aIx < aP->paths; aIx++)
+  {
+    if (pathInsideAnyPolygon(&aP->pathV[aIx], bP) == true)
+      return true;
+  }
+
+  for (int bIx = 0; bIx < bP->paths; bIx++)
+  {
+    if (pathInsideAnyPolygon(&bP->pathV[bIx], aP) == true)
+      return true;
+  }
+
+  return false;
+}
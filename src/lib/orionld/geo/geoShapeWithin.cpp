@@ -0,0 +1,192 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <vector>                                                // std::vector
+#include <algorithm>                                             // std::sort
+
+#include "orionld/types/GeoCompiled.h"                           // GcShape, GcPath, GcPolygon
+#include "orionld/geo/geoSegmentsIntersect.h"                    // geoSegmentsIntersect
+#include "orionld/geo/geoPointInPolygon.h"                       // geoPointInPolygon
+#include "orionld/geo/geoShapeWithin.h"                          // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// positionInside - is the position inside any of the polygons of the shape?
+//
+static bool positionInside(const double* coordP, const GcShape* shapeP)
+{
+  for (int ix = 0; ix < shapeP->polygons; ix++)
+  {
+    if (geoPointInPolygon(shapeP, &shapeP->polygonV[ix], coordP[0], coordP[1]) == true)
+      return true;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// segmentWithin - is the segment a-b completely inside the polygons of the shape?
+//
+// The segment is cut at every point where it meets the boundary of the polygons, and the midpoint of each piece is
+// checked. Any piece that leaves the polygons has its midpoint outside (the endpoints are checked by the caller).
+//
+static bool segmentWithin(const double* aP, const double* bP, const GcShape* shapeP)
+{
+  std::vector<double> tV;
+  double              rx = bP[0] - aP[0];
+  double              ry = bP[1] - aP[1];
+  double              rr = rx * rx + ry * ry;
+
+  if (rr == 0)
+    return true;
+
+  tV.push_back(0);
+  tV.push_back(1);
+
+  for (int pIx = 0; pIx < shapeP->paths; pIx++)
+  {
+    const GcPath* ringP = &shapeP->pathV[pIx];
+
+    for (int ix = 0; ix < ringP->points; ix++)
+    {
+      const double* cP = &ringP->coordV[ix * 2];
+      const double* dP = &ringP->coordV[((ix + 1) % ringP->points) * 2];
+
+      if (geoSegmentsIntersect(aP, bP, cP, dP) == false)
+        continue;
+
+      double sx    = dP[0] - cP[0];
+      double sy    = dP[1] - cP[1];
+      double denom = rx * sy - ry * sx;
+
+      if (denom != 0)
+        tV.push_back(((cP[0] - aP[0]) * sy - (cP[1] - aP[1]) * sx) / denom);
+      else
+      {
+        // Collinear - the ends of the common part
+        tV.push_back(((cP[0] - aP[0]) * rx + (cP[1] - aP[1]) * ry) / rr);
+        tV.push_back(((dP[0] - aP[0]) * rx + (dP[1] - aP[1]) * ry) / rr);
+      }
+    }
+  }
+
+  std::sort(tV.begin(), tV.end());
+
+  for (unsigned int ix = 1; ix < tV.size(); ix++)
+  {
+    double t0 = (tV[ix - 1] < 0)? 0 : tV[ix - 1];
+    double t1 = (tV[ix]     > 1)? 1 : tV[ix];
+
+    if (t1 - t0 < 1e-12)
+      continue;
+
+    double mid      = (t0 + t1) / 2;
+    double point[2] = { aP[0] + mid * rx, aP[1] + mid * ry };
+
+    if (positionInside(point, shapeP) == false)
+      return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// holeCovered - are all the positions of the hole inside the polygon?
+//
+static bool holeCovered(const GcPath* holeP, const GcShape* shapeP, const GcPolygon* polygonP)
+{
+  for (int ix = 0; ix < holeP->points; ix++)
+  {
+    if (geoPointInPolygon(shapeP, polygonP, holeP->coordV[ix * 2], holeP->coordV[ix * 2 + 1]) == false)
+      return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// geoShapeWithin -
+//
+// A geometry is within a (Multi)Polygon if:
+//   - all its positions are inside (or on the boundary of) the polygons
+//   - none of its edges leaves the polygons (not even through a vertex of the polygons)
+//   - none of its own polygons covers a hole of the polygons
+//
+bool geoShapeWithin(const GcShape* innerP, const GcShape* outerP)
+{
+  if (outerP->polygons == 0)
+    return false;
+
+  if ((innerP->box.minLon < outerP->box.minLon) || (innerP->box.maxLon > outerP->box.maxLon) ||
+      (innerP->box.minLat < outerP->box.minLat) || (innerP->box.maxLat > outerP->box.maxLat))
+    return false;
+
+  for (int pIx = 0; pIx < innerP->paths; pIx++)
+  {
+    const GcPath* pathP = &innerP->pathV[pIx];
+
+    for (int ix = 0; ix < pathP->points; ix++)
+    {
+      if (positionInside(&pathP->coordV[ix * 2], outerP) == false)
+        return false;
+    }
+
+    int segments = (pathP->points == 1)? 0 : ((pathP->ring == true)? pathP->points : pathP->points - 1);
+
+    for (int ix = 0; ix < segments; ix++)
+    {
+      if (segmentWithin(&pathP->coordV[ix * 2], &pathP->coordV[((ix + 1) % pathP->points) * 2], outerP) == false)
+        return false;
+    }
+  }
+
+  for (int oIx = 0; oIx < outerP->polygons; oIx++)
+  {
+    const GcPolygon* outerPolygonP = &outerP->polygonV[oIx];
+
+    for (int hIx = 1; hIx < outerPolygonP->rings; hIx++)
+    {
+      const GcPath* holeP = &outerP->pathV[outerPolygonP->firstPath + hIx];
+
+      for (int iIx = 0; iIx < innerP->polygons; iIx++)
+      {
+        if (holeCovered(holeP, innerP, &innerP->polygonV[iIx]) == true)
+          return false;
+      }
+    }
+  }
+
+  return true;
+}
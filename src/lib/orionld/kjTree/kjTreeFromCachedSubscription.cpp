@@ -256,8 +256,9 @@ KjNode* kjTreeFromCachedSubscription(CachedSubscription* cSubP, bool sysAttrs, b
   //
   if ((cSubP->expirationTime > 0) && (cSubP->expirationTime < orionldState.requestTime))
   {
-    cSubP->isActive = false;
-    cSubP->status   = "expired";
+    // The cached subscription is shared - isActive and status are stored atomically (see CachedSubscriptionStatus)
+    __atomic_store_n(&cSubP->isActive, false, __ATOMIC_RELEASE);  // Matching checks isActive before it looks at status
+    cSubP->status = "expired";
   }
   nodeP = kjBoolean(orionldState.kjsonP, "isActive", cSubP->isActive);
   NULL_CHECK(nodeP);
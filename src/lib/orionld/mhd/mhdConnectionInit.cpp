@@ -39,7 +39,8 @@ extern "C"
 #include "orionld/types/OrionLdRestService.h"                    // ORIONLD_URIPARAM_LIMIT, ...
 #include "orionld/types/OrionldMimeType.h"                       // mimeTypeFromString
 #include "orionld/types/Verb.h"                                  // Verb
-#include "orionld/common/orionldState.h"                         // orionldState, orionldStateInit
+#include "orionld/types/ContentEncoding.h"                       // ContentEncoding, contentEncodingFromString
+#include "orionld/common/orionldState.h"                         // orionldState, orionldStateInit, compressLevel
 #include "orionld/common/orionldError.h"                         // orionldError
 #include "orionld/common/performance.h"                          // REQUEST_PERFORMANCE
 #include "orionld/common/tenantList.h"                           // tenant0
@@ -53,6 +54,7 @@ extern "C"
 #include "orionld/payloadCheck/pCheckUri.h"                      // pCheckUri
 #include "orionld/entityMaps/entityMapLookup.h"                  // entityMapLookup
 #include "orionld/service/orionldServiceLookup.h"                // orionldServiceLookup
+#include "orionld/mhd/mhdRequestExecutors.h"                     // requestExecutors
 #include "orionld/mhd/mhdConnectionInit.h"                       // Own interface
 
 
@@ -200,6 +202,8 @@ void optionsParse(const char* options)
       else if (strcmp(optionStart, "dateModified")  == 0)  orionldState.uriParamOptions.dateModified  = true;  // NGSIv2 compatibility
       else if (strcmp(optionStart, "noAttrDetail")  == 0)  orionldState.uriParamOptions.noAttrDetail  = true;  // NGSIv2 compatibility
       else if (strcmp(optionStart, "upsert")        == 0)  orionldState.uriParamOptions.upsert        = true;  // NGSIv2 compatibility
+      else if (strcmp(optionStart, "temporalValues")   == 0)  orionldState.uriParamOptions.temporalValues   = true;  // Temporal
+      else if (strcmp(optionStart, "aggregatedValues") == 0)  orionldState.uriParamOptions.aggregatedValues = true;  // Temporal
       else
       {
         LM_W(("Invalid 'options' value: %s", optionStart));
@@ -378,6 +382,73 @@ MimeType acceptHeaderParse(char* accept, bool textOk)
 
 
 
+// -----------------------------------------------------------------------------
+//
+// acceptEncodingParse -
+//
+// Only gzip and deflate are supported - if both are acceptable, the highest weight wins, and on equal weight, gzip wins.
+// '*' is taken as gzip, and q=0 means "not acceptable".
+//
+// Example:
+//   Accept-Encoding: deflate, gzip;q=1.0, *;q=0.5
+//
+// The header value is not modified - it is also part of orionldState.in.httpHeaders.
+//
+static ContentEncoding acceptEncodingParse(const char* value)
+{
+  ContentEncoding winner        = CE_IDENTITY;
+  float           winningWeight = 0;
+
+  while (*value != 0)
+  {
+    // Step over WS and commas
+    while ((*value == ' ') || (*value == ','))
+      ++value;
+
+    if (*value == 0)
+      break;
+
+    // The encoding name
+    char encoding[16];
+    int  len = 0;
+
+    while ((*value != 0) && (*value != ',') && (*value != ';') && (*value != ' '))
+    {
+      if (len < (int) sizeof(encoding) - 1)
+        encoding[len++] = *value;
+      ++value;
+    }
+    encoding[len] = 0;
+
+    // Weight and any other parameter, up to the next comma
+    float weight = 1;
+    while ((*value != 0) && (*value != ','))
+    {
+      if ((value[0] == 'q') && (value[1] == '='))
+        weight = atof(&value[2]);
+      ++value;
+    }
+
+    ContentEncoding ce = (strcmp(encoding, "*") == 0)? CE_GZIP : contentEncodingFromString(encoding);
+
+    if ((ce != CE_GZIP) && (ce != CE_DEFLATE))
+      continue;
+
+    if (weight <= 0)  // q=0: not acceptable
+      continue;
+
+    if ((weight > winningWeight) || ((weight == winningWeight) && (ce == CE_GZIP)))
+    {
+      winner        = ce;
+      winningWeight = weight;
+    }
+  }
+
+  return winner;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // pCheckTenantName -
@@ -411,6 +482,12 @@ static MHD_Result orionldHttpHeaderReceive(void* cbDataP, MHD_ValueKind kind, co
 {
   LM_T(LmtHeaders, ("Got an HTTP Header: '%s': '%s'", key, value));
 
+  if (requestExecutors > 0)  // See mhdConnectionInit
+  {
+    key   = kaStrdup(&orionldState.kalloc, key);
+    value = (value != NULL)? kaStrdup(&orionldState.kalloc, value) : NULL;
+  }
+
   //
   // Need to keep track of ALL incoming headers, in case they're asked for in forwarded requests
   // This is copying information, but as it is not a default behaviour, that's OK.
@@ -467,6 +544,11 @@ static MHD_Result orionldHttpHeaderReceive(void* cbDataP, MHD_ValueKind kind, co
       orionldError(OrionldBadRequestData, "Invalid Accept mime-type", details, 406);
     }
   }
+  else if (strcasecmp(key, "Accept-Encoding") == 0)
+  {
+    if (compressLevel != 0)
+      orionldState.in.acceptEncoding = acceptEncodingParse(value);
+  }
   else if (strcasecmp(key, "Ngsiv2-AttrsFormat") == 0) orionldState.attrsFormat         = (char*) value;
   else if (strcasecmp(key, "X-Auth-Token")       == 0) orionldState.in.xAuthToken       = (char*) value;
   else if (strcasecmp(key, "Authorization")      == 0) orionldState.in.authorization    = (char*) value;
@@ -587,6 +669,9 @@ MHD_Result orionldUriArgumentGet(void* cbDataP, MHD_ValueKind kind, const char*
 {
   LM_T(LmtUriParams, ("Got a URI param '%s': '%s'", key, value));
 
+  if ((requestExecutors > 0) && (value != NULL))  // See mhdConnectionInit
+    value = kaStrdup(&orionldState.kalloc, value);
+
   // NULL/empty URI param value
   if ((value == NULL) || (*value == 0))
   {
@@ -812,6 +897,27 @@ MHD_Result orionldUriArgumentGet(void* cbDataP, MHD_ValueKind kind, const char*
     orionldState.uriParams.endTimeAt = (char*) value;
     orionldState.uriParams.mask |= ORIONLD_URIPARAM_ENDTIMEAT;
   }
+  else if (strcmp(key, "lastN") == 0)
+  {
+    if ((value[0] == 0) || (strspn(value, "0123456789") != strlen(value)) || (atoi(value) < 1))
+    {
+      orionldError(OrionldBadRequestData, "Invalid value for URI parameter /lastN/", "must be an integer value >= 1", 400);
+      return MHD_YES;
+    }
+
+    orionldState.uriParams.lastN = atoi(value);
+    orionldState.uriParams.mask |= ORIONLD_URIPARAM_LASTN;
+  }
+  else if (strcmp(key, "aggrMethods") == 0)
+  {
+    orionldState.uriParams.aggrMethods = (char*) value;
+    orionldState.uriParams.mask |= ORIONLD_URIPARAM_AGGRMETHODS;
+  }
+  else if (strcmp(key, "aggrPeriodDuration") == 0)
+  {
+    orionldState.uriParams.aggrPeriodDuration = (char*) value;
+    orionldState.uriParams.mask |= ORIONLD_URIPARAM_AGGRPERIODDURATION;
+  }
   else if (strcmp(key, "details") == 0)
   {
     if (strcmp(value, "true") == 0)
@@ -1124,6 +1230,20 @@ MHD_Result mhdConnectionInit
   // 2. Prepare orionldState
   //
   orionldStateInit(connection);
+
+  //
+  // A request executor resumes the connection before the post-response work (notifications, ...), and after that,
+  // MHD may complete the request and reuse the memory of the connection at any moment.
+  // So, the URL, and the values of HTTP headers and URI parameters (see the two MHD_get_connection_values callbacks),
+  // are copied to the kalloc buffer of the executor, that lasts until requestCompletedTreat
+  //
+  if (requestExecutors > 0)
+  {
+    url     = kaStrdup(&orionldState.kalloc, url);
+    method  = kaStrdup(&orionldState.kalloc, method);
+    version = kaStrdup(&orionldState.kalloc, version);
+  }
+
   orionldState.apiVersion  = API_VERSION_NGSILD_V1;
   orionldState.httpVersion = (char*) version;
 
@@ -1389,8 +1389,10 @@ MHD_Result mhdConnectionTreat(void)
 
   //
   // Cleanup
+  // If the response is streamed, the response tree must stay intact until it's been sent - requestCompleted releases the state
   //
-  orionldStateRelease();
+  if (orionldState.responseStreamed == false)
+    orionldStateRelease();
 
   PERFORMANCE(requestPartEnd);
 
@@ -22,10 +22,12 @@
 *
 * Author: Ken Zangelin
 */
+#include <strings.h>                                           // bzero
 #include <microhttpd.h>                                        // MHD
 
 extern "C"
 {
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
 #include "kjson/KjNode.h"                                        // KjNode
 #include "kjson/kjRender.h"                                      // kjRender, kjFastRender
 #include "kjson/kjRenderSize.h"                                  // kjRenderSize, kjFastRenderSize
@@ -33,60 +35,187 @@ extern "C"
 
 #include "logMsg/logMsg.h"
 
-#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/types/ContentEncoding.h"                     // ContentEncoding, contentEncodingToString
+#include "orionld/common/orionldState.h"                       // orionldState, chunkedResponseSize, reqPoolSize, compress*
 #include "orionld/common/performance.h"                        // PERFORMANCE
+#include "orionld/common/compress.h"                           // compressBuffer
+#include "orionld/mhd/mhdResponseStream.h"                     // mhdResponseStream
 #include "orionld/mhd/mhdReply.h"                              // Own interface
 
 
 
+// -----------------------------------------------------------------------------
+//
+// streamedSizeEstimate - estimated size of the rendered array - the number of items times the size of the first item
+//
+// The items of the arrays that may be streamed (e.g. the entities of a page of GET /entities) are alike, and the
+// estimate only decides whether to stream, so the size of the entire array isn't computed - if the array is streamed,
+// its size is never needed.
+//
+static unsigned int streamedSizeEstimate(KjNode* arrayP)
+{
+  KjNode*       firstP = arrayP->value.firstChildP;
+  KjNode*       nextP  = firstP->next;
+  unsigned int  items  = 0;
+  KjNode        wrapper;
+
+  for (KjNode* itemP = firstP; itemP != NULL; itemP = itemP->next)
+  {
+    ++items;
+  }
+
+  bzero(&wrapper, sizeof(wrapper));
+  wrapper.type              = KjArray;
+  wrapper.value.firstChildP = firstP;
+  wrapper.lastChild         = firstP;
+  firstP->next              = NULL;
+
+  unsigned int itemSize = kjFastRenderSize(&wrapper);
+
+  firstP->next = nextP;
+
+  return items * itemSize;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // mhdReply -
 //
+// The response body is rendered once and handed over to MHD without copying it:
+//   - if it fits in the kalloc buffer of the connection thread, it's rendered there, and MHD sends it from there
+//     (MHD_RESPMEM_PERSISTENT) - the kalloc buffer is reset in requestCompleted, after the response has been sent.
+//     With a thread pool (-reqPoolSize), a thread serves more than one connection, and the kalloc buffer may be
+//     reused before the response has been sent - MHD must copy it.
+//   - if not, it's rendered in an allocated buffer, that MHD frees once the response has been sent (MHD_RESPMEM_MUST_FREE)
+//
+// Arrays bigger than -chunkedResponse kilobytes (e.g. big pages of GET /entities) aren't rendered at all here, they are
+// streamed (chunked transfer encoding), item by item, straight into the send buffer of MHD (see mhdResponseStream).
+// Whether an array is that big is estimated from its number of items and the size of its first item (streamedSizeEstimate).
+// As the tree must then stay intact until the response has been sent, the release of orionldState (that frees
+// the buffers in the delayed-free list) is postponed to requestCompleted (orionldState.responseStreamed).
+//
+// With -compress, the body is compressed if the client accepts gzip or deflate (Accept-Encoding) and the body is
+// at least -compressMin bytes. A compressed body is always an allocated buffer, and it is only used if it's smaller.
+//
 void mhdReply(KjNode* body)
 {
-  unsigned int responsePayloadSize = 0;
+  MHD_Response*    response           = NULL;
+  int              responsePayloadLen = 0;
+  int              bodyLen            = 0;  // Differs from responsePayloadLen if the body is compressed
+  bool             allocated          = false;
+  bool             persistent         = (reqPoolSize == 0);
+  ContentEncoding  encoding           = CE_IDENTITY;
+
+  if ((compressLevel != 0) && (orionldState.in.acceptEncoding != CE_IDENTITY))
+    encoding = orionldState.in.acceptEncoding;
 
   if (body != NULL)
   {
     PERFORMANCE(renderStart);
-    responsePayloadSize = (orionldState.uriParams.prettyPrint == false)? kjFastRenderSize(body) : kjRenderSize(orionldState.kjsonP, body);
 
-    if (responsePayloadSize < orionldState.kalloc.bytesLeft + 8)
-      orionldState.responsePayload = kaAlloc(&orionldState.kalloc, responsePayloadSize);
-    else
+    if ((body->type                         == KjArray)  &&
+        (body->value.firstChildP            != NULL)     &&
+        (orionldState.uriParams.prettyPrint == false)    &&
+        (chunkedResponseSize                != 0)        &&
+        (persistent                         == true))
     {
-      orionldState.responsePayload = (char*) malloc(responsePayloadSize);
-
-      if (orionldState.responsePayload == NULL)
-        LM_X(1, ("Out of memory"));
+      unsigned int estimate = streamedSizeEstimate(body);
 
-      orionldStateDelayedFreeEnqueue(orionldState.responsePayload);
+      if (estimate > (unsigned int) chunkedResponseSize * 1024)
+      {
+        response = mhdResponseStream(body, encoding);
+        if (response != NULL)
+        {
+          orionldState.responseStreamed = true;
+          responsePayloadLen            = estimate;  // Not exact, only used for the Content-Type
+          LM_T(LmtResponse, ("Response Body: streamed (chunked transfer encoding), some %d bytes", estimate));
+        }
+      }
     }
 
-    if (orionldState.uriParams.prettyPrint == false)
-      kjFastRender(body, orionldState.responsePayload);
-    else
-      kjRender(orionldState.kjsonP, body, orionldState.responsePayload, responsePayloadSize);
+    if (orionldState.responseStreamed == false)
+    {
+      unsigned int responsePayloadSize = (orionldState.uriParams.prettyPrint == false)? kjFastRenderSize(body) : kjRenderSize(orionldState.kjsonP, body);
+
+      if (responsePayloadSize < orionldState.kalloc.bytesLeft + 8)
+        orionldState.responsePayload = kaAlloc(&orionldState.kalloc, responsePayloadSize);
+      else
+      {
+        orionldState.responsePayload = (char*) malloc(responsePayloadSize);
+
+        if (orionldState.responsePayload == NULL)
+          LM_X(1, ("Out of memory"));
+
+        allocated = true;
+      }
+
+      if (orionldState.uriParams.prettyPrint == false)
+        kjFastRender(body, orionldState.responsePayload);
+      else
+        kjRender(orionldState.kjsonP, body, orionldState.responsePayload, responsePayloadSize);
+
+      LM_T(LmtResponse, ("Response Body: '%s'", orionldState.responsePayload));
+      responsePayloadLen = strlen(orionldState.responsePayload);
+      bodyLen            = responsePayloadLen;
+
+      if ((encoding != CE_IDENTITY) && (responsePayloadLen >= compressMin))
+      {
+        const char* partV[1]    = { orionldState.responsePayload };
+        int         partLenV[1] = { responsePayloadLen };
+        int         compressedLen;
+        char*       compressed  = compressBuffer(encoding, NULL, 1, partV, partLenV, &compressedLen);
+
+        if ((compressed != NULL) && (compressedLen < responsePayloadLen))
+        {
+          LM_T(LmtResponse, ("Response Body: %s compressed from %d to %d bytes", contentEncodingToString(encoding), responsePayloadLen, compressedLen));
+
+          if (allocated == true)
+            free(orionldState.responsePayload);
+
+          orionldState.responsePayload = compressed;
+          bodyLen                      = compressedLen;
+          allocated                    = true;
+        }
+        else
+        {
+          free(compressed);
+          encoding = CE_IDENTITY;
+        }
+      }
+      else
+        encoding = CE_IDENTITY;
+    }
 
     PERFORMANCE(renderEnd);
   }
+  else
+    LM_T(LmtResponse, ("Response Body: None"));
 
   PERFORMANCE(mhdReplyStart);
 
-  LM_T(LmtResponse, ("Response Body: '%s'", (body != NULL)? orionldState.responsePayload : "None"));
   LM_T(LmtResponse, ("Response Code:  %d", orionldState.httpStatusCode));
 
   //
   // Enqueue response
   //
-  int           responsePayloadLen = (body != NULL)? strlen(orionldState.responsePayload) : 0;
-  MHD_Response* response           = MHD_create_response_from_buffer(responsePayloadLen, orionldState.responsePayload, MHD_RESPMEM_MUST_COPY);
+  if (orionldState.responseStreamed == false)
+  {
+    MHD_ResponseMemoryMode mode = MHD_RESPMEM_PERSISTENT;
+
+    if (allocated == true)
+      mode = MHD_RESPMEM_MUST_FREE;
+    else if (persistent == false)
+      mode = MHD_RESPMEM_MUST_COPY;
+
+    response = MHD_create_response_from_buffer(bodyLen, orionldState.responsePayload, mode);
+  }
 
   if (!response)
   {
     LM_E(("Runtime Error (MHD_create_response_from_buffer FAILED)"));
-    if (orionldState.responsePayloadAllocated == true)
+    if (allocated == true)
     {
       free(orionldState.responsePayload);
       orionldState.responsePayload = NULL;
@@ -95,6 +224,9 @@ void mhdReply(KjNode* body)
     return;
   }
 
+  if (allocated == true)
+    orionldState.responsePayload = NULL;  // Owned by MHD from now on
+
   //
   // Get the HTTP headers from orionldState.out.headers
   //
@@ -114,6 +246,11 @@ void mhdReply(KjNode* body)
     else if (orionldState.out.contentType == MT_GEOJSON) contentType = (char*) "application/geo+json";
 
     MHD_add_response_header(response, "Content-Type", contentType);
+
+    if (compressLevel != 0)
+      MHD_add_response_header(response, "Vary", "Accept-Encoding");
+    if (encoding != CE_IDENTITY)
+      MHD_add_response_header(response, "Content-Encoding", contentEncodingToString(encoding));
   }
 
   MHD_queue_response(orionldState.mhdConnection, orionldState.httpStatusCode, response);
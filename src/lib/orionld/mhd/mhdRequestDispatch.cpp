@@ -0,0 +1,166 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // calloc, realloc, free
+#include <string.h>                                              // memcpy
+#include <microhttpd.h>                                          // MHD_*
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/RequestJob.h"                            // RequestJob, REQUEST_JOB_MAGIC
+#include "orionld/common/orionldState.h"                         // inReqPayloadMaxSize
+#include "orionld/mhd/mhdRequestExecutors.h"                     // requestExecutorsEnqueue
+#include "orionld/mhd/mhdRequestDispatch.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestJobPayloadAdd -
+//
+// Payload bodies bigger than -inReqPayloadMaxSize are silently "eaten", just like mhdConnectionPayloadRead does,
+// and the executor responds with an error, as the Content-Length is too big.
+//
+static bool requestJobPayloadAdd(RequestJob* jobP, const char* data, size_t dataLen)
+{
+  size_t size = jobP->payloadSize + dataLen;
+
+  if (size > inReqPayloadMaxSize)
+    return true;
+
+  if (size + 1 > jobP->payloadAllocated)
+  {
+    size_t allocated = (jobP->payloadAllocated == 0)? 4 * 1024 : jobP->payloadAllocated * 2;
+
+    while (allocated < size + 1)
+    {
+      allocated *= 2;
+    }
+
+    char* payload = (char*) realloc(jobP->payload, allocated);
+    if (payload == NULL)
+    {
+      LM_E(("Out of memory (%d bytes for the payload body of a request)", (int) allocated));
+      return false;
+    }
+
+    jobP->payload          = payload;
+    jobP->payloadAllocated = allocated;
+  }
+
+  memcpy(&jobP->payload[jobP->payloadSize], data, dataLen);
+  jobP->payloadSize   = size;
+  jobP->payload[size] = 0;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mhdRequestDispatch - read an NGSI-LD request and hand it over to the request executors (-reqExecutors)
+//
+// The three calls of MHD for a request (see connectionTreat in rest.cpp):
+//   Call 1: *con_cls == NULL                               - a RequestJob is created
+//   Call 2: *con_cls != NULL  AND  *upload_data_size != 0  - the payload body is added to the job
+//   Call 3: *con_cls != NULL  AND  *upload_data_size == 0  - the connection is suspended and the job is enqueued
+//
+// The executor queues the response and resumes the connection.
+// MHD calls once more only if no response was queued - the connection is then closed.
+//
+MHD_Result mhdRequestDispatch
+(
+  MHD_Connection*  connection,
+  const char*      url,
+  const char*      method,
+  const char*      version,
+  const char*      upload_data,
+  size_t*          upload_data_size,
+  void**           con_cls
+)
+{
+  RequestJob* jobP = (RequestJob*) *con_cls;
+
+  if (jobP == NULL)
+  {
+    jobP = (RequestJob*) calloc(1, sizeof(RequestJob));
+    if (jobP == NULL)
+    {
+      LM_E(("Out of memory allocating a request job"));
+      return MHD_NO;
+    }
+
+    jobP->magic      = REQUEST_JOB_MAGIC;
+    jobP->connection = connection;
+    jobP->url        = url;
+    jobP->method     = method;
+    jobP->version    = version;
+
+    *con_cls = jobP;
+    return MHD_YES;
+  }
+
+  if (*upload_data_size != 0)
+  {
+    bool ok = requestJobPayloadAdd(jobP, upload_data, *upload_data_size);
+
+    *upload_data_size = 0;
+    return (ok == true)? MHD_YES : MHD_NO;
+  }
+
+  if (jobP->executed == true)
+  {
+    LM_W(("No response for %s %s - closing the connection", method, url));
+    return MHD_NO;
+  }
+
+  MHD_suspend_connection(connection);
+  requestExecutorsEnqueue(jobP);
+
+  return MHD_YES;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mhdRequestJobRelease - free the RequestJob of a completed request - false if 'conCls' is no RequestJob
+//
+// The executor is done with the job once it has resumed the connection, and, requests that never made it to
+// the executors (the client closed the connection while sending the request) are freed here as well.
+//
+bool mhdRequestJobRelease(void* conCls)
+{
+  RequestJob* jobP = (RequestJob*) conCls;
+
+  if ((jobP == NULL) || (jobP->magic != REQUEST_JOB_MAGIC))
+    return false;
+
+  jobP->magic = 0;
+  free(jobP->payload);
+  free(jobP);
+
+  return true;
+}
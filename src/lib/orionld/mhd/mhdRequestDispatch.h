@@ -0,0 +1,56 @@
+#ifndef SRC_LIB_ORIONLD_MHD_MHDREQUESTDISPATCH_H_
+#define SRC_LIB_ORIONLD_MHD_MHDREQUESTDISPATCH_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stddef.h>                                              // size_t
+#include <microhttpd.h>                                          // MHD_Connection, MHD_Result
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mhdRequestDispatch - read an NGSI-LD request and hand it over to the request executors (-reqExecutors)
+//
+extern MHD_Result mhdRequestDispatch
+(
+  MHD_Connection*  connection,
+  const char*      url,
+  const char*      method,
+  const char*      version,
+  const char*      upload_data,
+  size_t*          upload_data_size,
+  void**           con_cls
+);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mhdRequestJobRelease - free the RequestJob of a completed request - false if 'conCls' is no RequestJob
+//
+extern bool mhdRequestJobRelease(void* conCls);
+
+#endif  // SRC_LIB_ORIONLD_MHD_MHDREQUESTDISPATCH_H_
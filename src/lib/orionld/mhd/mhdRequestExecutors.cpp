@@ -0,0 +1,342 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <errno.h>                                               // errno, EINTR
+#include <string.h>                                              // strerror
+#include <stdlib.h>                                              // calloc, free
+#include <stdint.h>                                              // uint64_t
+#include <pthread.h>                                             // pthread_*
+#include <time.h>                                                // clock_gettime
+#include <semaphore.h>                                           // sem_*
+#include <microhttpd.h>                                          // MHD_resume_connection
+#include <mongoc/mongoc.h>                                       // mongoc_client_t, mongoc_client_pool_push
+#include <atomic>                                                // std::atomic
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "rest/rest.h"                                           // requestCompletedTreat
+
+#include "orionld/types/RequestJob.h"                            // RequestJob
+#include "orionld/common/orionldState.h"                         // orionldState, mongocPool, promRequestExecutor*
+#include "orionld/prometheus/promHistogramObserve.h"             // promHistogramObserve
+#include "orionld/mhd/mhdConnectionInit.h"                       // mhdConnectionInit
+#include "orionld/mhd/mhdConnectionPayloadRead.h"                // mhdConnectionPayloadRead
+#include "orionld/mhd/mhdConnectionTreat.h"                      // mhdConnectionTreat
+#include "orionld/mhd/mhdRequestExecutors.h"                     // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ExecutorQueue - the queue of one executor
+//
+// The I/O threads spread the jobs over the queues of the executors (round robin), and an executor that finds its
+// own queue empty steals the oldest job of the queue of another executor.
+// One single semaphore, posted once per job, puts idle executors to sleep - an executor that gets past the semaphore
+// is guaranteed to find a job, in its own queue or in the queue of another executor.
+//
+typedef struct ExecutorQueue
+{
+  pthread_mutex_t  mutex;
+  RequestJob*      first;
+  RequestJob*      last;
+} ExecutorQueue;
+
+
+
+int                           requestExecutors = 0;
+static pthread_t*             executorV        = NULL;
+static ExecutorQueue*         queueV           = NULL;
+static sem_t                  executorSem;
+static volatile bool          executorsStop    = false;
+static std::atomic<uint64_t>  jobsIn(0);
+static std::atomic<uint64_t>  jobsStolen(0);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timeNow -
+//
+static double timeNow(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + ((double) now.tv_nsec) / 1000000000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// queuePop -
+//
+static RequestJob* queuePop(ExecutorQueue* queueP)
+{
+  pthread_mutex_lock(&queueP->mutex);
+
+  RequestJob* jobP = queueP->first;
+
+  if (jobP != NULL)
+  {
+    queueP->first = jobP->next;
+    if (queueP->first == NULL)
+      queueP->last = NULL;
+    jobP->next = NULL;
+  }
+
+  pthread_mutex_unlock(&queueP->mutex);
+
+  return jobP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestJobGet - the next job of an executor, from its own queue if possible, if not, stolen from another executor
+//
+static RequestJob* requestJobGet(int executorIx)
+{
+  RequestJob* jobP = queuePop(&queueV[executorIx]);
+
+  if (jobP != NULL)
+    return jobP;
+
+  for (int ix = 1; ix < requestExecutors; ix++)
+  {
+    jobP = queuePop(&queueV[(executorIx + ix) % requestExecutors]);
+
+    if (jobP != NULL)
+    {
+      jobsStolen.fetch_add(1, std::memory_order_relaxed);
+      return jobP;
+    }
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestJobExecute -
+//
+// Exactly what the thread of a connection does for an NGSI-LD request (connectionTreat + requestCompleted in rest.cpp),
+// only, the connection is suspended, so it's all done in one go.
+// The connection is resumed as soon as the response has been queued, for MHD to send the response while the executor
+// does what's left after the response (requestCompletedTreat - notifications, releasing the mongo collections, ...).
+// The connection (and the url, method and version of the job) must not be touched after MHD_resume_connection, and
+// neither must the job - MHD may complete the request (requestCompleted frees the job) at any moment after that.
+// Everything orionldState needs from the request has been copied to the kalloc buffer of the executor by mhdConnectionInit.
+//
+// The executor keeps its mongo client (popped from the pool for the first request) for all requests it executes.
+//
+// Metrics (Prometheus): the time the job waited for an executor, the time until the response was queued, and the time
+// spent after the response - the part of the request that the client no longer waits for.
+//
+static void requestJobExecute(RequestJob* jobP, mongoc_client_t** mongocClientPP)
+{
+  MHD_Connection*  connection = jobP->connection;
+  void*            conCls     = NULL;
+  double           enqueued   = jobP->enqueued;
+  double           start      = timeNow();
+
+  promHistogramObserve(promRequestExecutorWait, start - enqueued);
+
+  mhdConnectionInit(connection, jobP->url, jobP->method, jobP->version, &conCls);
+  orionldState.mongoc.client = *mongocClientPP;
+
+  if (jobP->payloadSize != 0)
+  {
+    size_t payloadSize = jobP->payloadSize;
+    mhdConnectionPayloadRead(&payloadSize, jobP->payload);
+  }
+
+  mhdConnectionTreat();
+
+  jobP->executed = true;
+  MHD_resume_connection(connection);
+
+  double responded = timeNow();
+  promHistogramObserve(promRequestExecutorResponseTime, responded - enqueued);
+
+  // Keep the mongo client - requestCompletedTreat would give it back to the pool
+  *mongocClientPP            = orionldState.mongoc.client;
+  orionldState.mongoc.client = NULL;
+
+  requestCompletedTreat(NULL);
+
+  promHistogramObserve(promRequestExecutorPostResponseTime, timeNow() - responded);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestExecutor -
+//
+static void* requestExecutor(void* vP)
+{
+  int               executorIx   = (int) (long) vP;
+  mongoc_client_t*  mongocClient = NULL;
+
+  LM_T(LmtRequestExecutor, ("Request executor %d is running", executorIx));
+
+  while (executorsStop == false)
+  {
+    while (sem_wait(&executorSem) == -1)
+    {
+      if (errno != EINTR)
+        LM_X(1, ("sem_wait: %s", strerror(errno)));
+    }
+
+    RequestJob* jobP = requestJobGet(executorIx);
+
+    if (jobP != NULL)
+      requestJobExecute(jobP, &mongocClient);
+  }
+
+  if (mongocClient != NULL)
+    mongoc_client_pool_push(mongocPool, mongocClient);
+
+  LM_T(LmtRequestExecutor, ("Request executor %d is exiting", executorIx));
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestExecutorsStart - create the queues and start the executor threads
+//
+bool requestExecutorsStart(int executors)
+{
+  if (sem_init(&executorSem, 0, 0) == -1)
+  {
+    LM_E(("sem_init: %s", strerror(errno)));
+    return false;
+  }
+
+  queueV    = (ExecutorQueue*) calloc(executors, sizeof(ExecutorQueue));
+  executorV = (pthread_t*)     calloc(executors, sizeof(pthread_t));
+
+  if ((queueV == NULL) || (executorV == NULL))
+  {
+    LM_E(("Out of memory allocating %d request executors", executors));
+    return false;
+  }
+
+  for (int ix = 0; ix < executors; ix++)
+  {
+    pthread_mutex_init(&queueV[ix].mutex, NULL);
+  }
+
+  requestExecutors = executors;  // Before the threads are started - they steal from all queues
+
+  for (long ix = 0; ix < executors; ix++)
+  {
+    int s = pthread_create(&executorV[ix], NULL, requestExecutor, (void*) ix);
+
+    if (s != 0)
+    {
+      LM_E(("Runtime Error (error creating request executor thread: %d)", s));
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestExecutorsEnqueue - hand a request over to the executors
+//
+void requestExecutorsEnqueue(RequestJob* jobP)
+{
+  ExecutorQueue* queueP = &queueV[jobsIn.fetch_add(1, std::memory_order_relaxed) % requestExecutors];
+
+  jobP->next     = NULL;
+  jobP->enqueued = timeNow();
+
+  pthread_mutex_lock(&queueP->mutex);
+
+  if (queueP->last == NULL)
+    queueP->first = jobP;
+  else
+    queueP->last->next = jobP;
+
+  queueP->last = jobP;
+
+  pthread_mutex_unlock(&queueP->mutex);
+
+  sem_post(&executorSem);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestExecutorsStop - stop all executor threads
+//
+// The executors finish the request they are executing - requests still in the queues are never executed
+// (the connections stay suspended and are closed by MHD at shutdown).
+//
+void requestExecutorsStop(void)
+{
+  if (executorV == NULL)
+    return;
+
+  executorsStop = true;
+
+  for (int ix = 0; ix < requestExecutors; ix++)
+  {
+    sem_post(&executorSem);
+  }
+
+  for (int ix = 0; ix < requestExecutors; ix++)
+  {
+    pthread_join(executorV[ix], NULL);
+  }
+
+  LM_T(LmtRequestExecutor, ("Request executors: %d requests, %d stolen", (int) jobsIn.load(), (int) jobsStolen.load()));
+
+  for (int ix = 0; ix < requestExecutors; ix++)
+  {
+    pthread_mutex_destroy(&queueV[ix].mutex);
+  }
+
+  requestExecutors = 0;
+  free(queueV);
+  free(executorV);
+  queueV    = NULL;
+  executorV = NULL;
+
+  sem_destroy(&executorSem);
+}
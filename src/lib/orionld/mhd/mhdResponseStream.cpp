@@ -0,0 +1,435 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc, realloc, free
+#include <string.h>                                              // memcpy, strlen, bzero
+#include <microhttpd.h>                                          // MHD_*
+#include <zlib.h>                                                // z_stream, deflate, deflateEnd
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjRender.h"                                      // kjFastRender
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/ContentEncoding.h"                       // ContentEncoding
+#include "orionld/common/compress.h"                             // compressStreamInit, compressCpuTime, compressMetricsAdd
+#include "orionld/mhd/mhdResponseStream.h"                       // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// MHD_RESPONSE_STREAM_BLOCK_SIZE - the size of the buffer MHD hands over to mhdResponseStreamRead
+//
+#define MHD_RESPONSE_STREAM_BLOCK_SIZE  (32 * 1024)
+
+
+
+// -----------------------------------------------------------------------------
+//
+// MhdResponseStream - state of a streamed array response
+//
+typedef struct MhdResponseStream
+{
+  KjNode*  itemP;        // The next item of the array to render
+  bool     first;        // No item has been rendered yet
+  char*    buf;          // Rendered bytes that didn't fit in MHD's buffer
+  int      bufSize;      // Size of 'buf'
+  int      pendingLen;   // Number of bytes in 'buf'
+  int      pendingIx;    // Bytes of 'buf' already handed over to MHD
+  char*    leafBuf;      // Render buffer for a single leaf of an item
+  int      leafBufSize;  // Size of 'leafBuf'
+
+  // Compressed response (Content-Encoding)
+  bool           compressed;
+  bool           compressionDone;   // Z_STREAM_END has been reached
+  z_stream       z;
+  unsigned long  bytesIn;
+  double         cpuTime;
+} MhdResponseStream;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// LEAF_VALUE_MAX - upper limit of the rendered length of a leaf that isn't a string (the longest is a float)
+//
+#define LEAF_VALUE_MAX  400
+
+
+
+// -----------------------------------------------------------------------------
+//
+// RenderSink - where the rendered bytes of an item go
+//
+// Into MHD's buffer for as long as there is room, and the rest into the buffer of the stream, to be handed over
+// to MHD in the following calls to mhdResponseStreamRead.
+//
+typedef struct RenderSink
+{
+  MhdResponseStream*  streamP;
+  char*               out;
+  int                 outSize;
+  int                 outLen;
+} RenderSink;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// bufferGrow -
+//
+static char* bufferGrow(char* buf, int* sizeP, int size)
+{
+  if (size <= *sizeP)
+    return buf;
+
+  if (size < 2 * *sizeP)
+    size = 2 * *sizeP;
+
+  char* newBuf = (char*) realloc(buf, size);
+
+  if (newBuf == NULL)
+    LM_X(1, ("Out of memory (%d bytes for the rendering of an array item)", size));
+
+  *sizeP = size;
+  return newBuf;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// sinkWrite -
+//
+static void sinkWrite(RenderSink* sinkP, const char* bytes, int len)
+{
+  int room = sinkP->outSize - sinkP->outLen;
+
+  if (room > 0)
+  {
+    int n = (len < room)? len : room;
+
+    memcpy(&sinkP->out[sinkP->outLen], bytes, n);
+    sinkP->outLen += n;
+    bytes         += n;
+    len           -= n;
+  }
+
+  if (len > 0)
+  {
+    MhdResponseStream* streamP = sinkP->streamP;
+
+    streamP->buf = bufferGrow(streamP->buf, &streamP->bufSize, streamP->pendingLen + len);
+    memcpy(&streamP->buf[streamP->pendingLen], bytes, len);
+    streamP->pendingLen += len;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// leafRender - render a leaf (and its name, if it's a member of an object) with kjFastRender
+//
+// The leaf is rendered as the only child of an object ({"name":value}) or an array ([value]) - exactly as kjFastRender
+// renders it inside the item - and the brackets are stripped.
+// No size pass is needed for the leaf buffer, an upper limit is enough: every character of a string may need
+// an escape sequence of (at most) six characters, and no other value is longer than LEAF_VALUE_MAX characters.
+//
+// Returns the length of what is in the leaf buffer, the brackets not included (they're at leafBuf[0] and leafBuf[len + 1]).
+//
+static int leafRender(MhdResponseStream* streamP, KjNode* nodeP, bool member)
+{
+  int size = LEAF_VALUE_MAX + 4;  // 4: the brackets, the zero-termination and one spare byte
+
+  if (member == true)
+    size += 6 * strlen(nodeP->name) + 3;
+  if (nodeP->type == KjString)
+    size += 6 * strlen(nodeP->value.s) + 2;
+
+  streamP->leafBuf = bufferGrow(streamP->leafBuf, &streamP->leafBufSize, size);
+
+  KjNode*  nextP = nodeP->next;
+  KjNode   wrapper;
+
+  bzero(&wrapper, sizeof(wrapper));
+  wrapper.type              = (member == true)? KjObject : KjArray;
+  wrapper.value.firstChildP = nodeP;
+  wrapper.lastChild         = nodeP;
+  nodeP->next               = NULL;
+
+  kjFastRender(&wrapper, streamP->leafBuf);
+  nodeP->next = nextP;
+
+  return strlen(streamP->leafBuf) - 2;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nodeRender - render a node, straight into the sink
+//
+// kjFastRender renders the leaves, the containers are taken care of here, so that no size pass over the item is needed.
+// 'member' tells whether the node is a member of an object (rendered with its name) or an item of an array.
+//
+static void nodeRender(RenderSink* sinkP, KjNode* nodeP, bool member)
+{
+  if ((nodeP->type != KjObject) && (nodeP->type != KjArray))
+  {
+    int len = leafRender(sinkP->streamP, nodeP, member);
+
+    sinkWrite(sinkP, &sinkP->streamP->leafBuf[1], len);
+    return;
+  }
+
+  if (member == true)
+  {
+    // The name is rendered as the name of a null leaf ("name":null), and the value ("null") is dropped
+    KjNode nameNode;
+
+    bzero(&nameNode, sizeof(nameNode));
+    nameNode.type = KjNull;
+    nameNode.name = nodeP->name;
+
+    int len = leafRender(sinkP->streamP, &nameNode, true);
+
+    sinkWrite(sinkP, &sinkP->streamP->leafBuf[1], len - 4);
+  }
+
+  sinkWrite(sinkP, (nodeP->type == KjObject)? "{" : "[", 1);
+
+  for (KjNode* childP = nodeP->value.firstChildP; childP != NULL; childP = childP->next)
+  {
+    if (childP != nodeP->value.firstChildP)
+      sinkWrite(sinkP, ",", 1);
+
+    nodeRender(sinkP, childP, nodeP->type == KjObject);
+  }
+
+  sinkWrite(sinkP, (nodeP->type == KjObject)? "}" : "]", 1);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// itemRender - render one item of the array, exactly as it is rendered inside the array
+//
+// The item is preceded by '[' if it's the first item of the array, by ',' if not, and the last item is followed by ']'.
+//
+// The item is rendered in one single pass, straight into what is left of MHD's buffer, and whatever doesn't fit
+// goes to the buffer of the stream, to be handed over to MHD over the following calls to mhdResponseStreamRead.
+//
+// Returns the number of bytes rendered in 'out'.
+//
+static int itemRender(MhdResponseStream* streamP, char* out, int outSize)
+{
+  RenderSink  sink    = { streamP, out, outSize, 0 };
+  KjNode*     itemP   = streamP->itemP;
+
+  streamP->pendingLen = 0;
+  streamP->pendingIx  = 0;
+
+  sinkWrite(&sink, (streamP->first == true)? "[" : ",", 1);
+  nodeRender(&sink, itemP, false);
+
+  if (itemP->next == NULL)
+    sinkWrite(&sink, "]", 1);
+
+  streamP->first = false;
+  streamP->itemP = itemP->next;
+
+  return sink.outLen;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mhdResponseStreamRead - MHD content reader callback
+//
+// Fills MHD's buffer with as many rendered items as fit, leftovers of the previous call first.
+//
+static ssize_t mhdResponseStreamRead(void* cls, uint64_t pos, char* out, size_t max)
+{
+  MhdResponseStream* streamP = (MhdResponseStream*) cls;
+  int                outLen  = 0;
+  int                outSize = (int) max;
+
+  while (outLen < outSize)
+  {
+    if (streamP->pendingIx < streamP->pendingLen)
+    {
+      int bytes = streamP->pendingLen - streamP->pendingIx;
+
+      if (bytes > outSize - outLen)
+        bytes = outSize - outLen;
+
+      memcpy(&out[outLen], &streamP->buf[streamP->pendingIx], bytes);
+      streamP->pendingIx += bytes;
+      outLen             += bytes;
+      continue;
+    }
+
+    if (streamP->itemP == NULL)
+      break;
+
+    outLen += itemRender(streamP, &out[outLen], outSize - outLen);
+  }
+
+  if (outLen == 0)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+
+  return outLen;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mhdResponseStreamDeflate - MHD content reader callback for compressed responses
+//
+// The items are rendered in the buffer of the stream, one by one, and compressed straight into MHD's buffer.
+// The compressor keeps whatever doesn't fit in MHD's buffer, for the next call.
+//
+static ssize_t mhdResponseStreamDeflate(void* cls, uint64_t pos, char* out, size_t max)
+{
+  MhdResponseStream* streamP = (MhdResponseStream*) cls;
+  z_stream*          zP      = &streamP->z;
+
+  zP->next_out  = (Bytef*) out;
+  zP->avail_out = max;
+
+  while ((zP->avail_out > 0) && (streamP->compressionDone == false))
+  {
+    if ((zP->avail_in == 0) && (streamP->itemP != NULL))
+    {
+      itemRender(streamP, NULL, 0);  // No room given - the item goes to the buffer of the stream
+
+      zP->next_in       = (Bytef*) streamP->buf;
+      zP->avail_in      = streamP->pendingLen;
+      streamP->bytesIn += streamP->pendingLen;
+    }
+
+    double startTime = compressCpuTime();
+    int    rc        = deflate(zP, (streamP->itemP == NULL)? Z_FINISH : Z_NO_FLUSH);
+
+    streamP->cpuTime += compressCpuTime() - startTime;
+
+    if (rc == Z_STREAM_END)
+      streamP->compressionDone = true;
+    else if ((rc != Z_OK) && (rc != Z_BUF_ERROR))
+    {
+      LM_E(("Internal Error (deflate failed: %d)", rc));
+      return MHD_CONTENT_READER_END_WITH_ERROR;
+    }
+  }
+
+  ssize_t outLen = max - zP->avail_out;
+
+  if ((outLen == 0) && (streamP->compressionDone == true))
+    return MHD_CONTENT_READER_END_OF_STREAM;
+
+  return outLen;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mhdResponseStreamFree - MHD callback to free the stream, once MHD is done with the response
+//
+static void mhdResponseStreamFree(void* cls)
+{
+  MhdResponseStream* streamP = (MhdResponseStream*) cls;
+
+  if (streamP->compressed == true)
+  {
+    compressMetricsAdd(streamP->bytesIn, streamP->z.total_out, streamP->cpuTime);
+    deflateEnd(&streamP->z);
+  }
+
+  free(streamP->buf);
+  free(streamP->leafBuf);
+  free(streamP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mhdResponseStream - create a response that streams a JSON array, item by item, in chunked transfer encoding
+//
+// The items are rendered as MHD requests more data to send, straight into MHD's send buffer, without any size pass,
+// so, there's never more than (part of) one item rendered in memory, no matter how big the array is.
+//
+// The array must stay intact until MHD is done with the response. The tree lives in the kalloc buffer of the
+// connection thread, that is reset in requestCompleted (rest.cpp), i.e. after the response has been sent.
+// This requires a thread per connection (no -reqPoolSize) - it's up to the caller to make sure of that.
+//
+// With an 'encoding' (gzip or deflate), the rendered items go through a compressor of its own, that lives as long as the stream.
+//
+MHD_Response* mhdResponseStream(KjNode* arrayP, ContentEncoding encoding)
+{
+  MhdResponseStream* streamP = (MhdResponseStream*) calloc(1, sizeof(MhdResponseStream));
+
+  if (streamP == NULL)
+  {
+    LM_E(("Out of memory (allocating a response stream)"));
+    return NULL;
+  }
+
+  streamP->itemP = arrayP->value.firstChildP;
+  streamP->first = true;
+
+  if ((encoding == CE_GZIP) || (encoding == CE_DEFLATE))
+  {
+    if (compressStreamInit(&streamP->z, encoding) == false)
+    {
+      free(streamP);
+      return NULL;
+    }
+
+    streamP->compressed = true;
+  }
+
+  MHD_Response* response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN,
+                                                             MHD_RESPONSE_STREAM_BLOCK_SIZE,
+                                                             (streamP->compressed == true)? mhdResponseStreamDeflate : mhdResponseStreamRead,
+                                                             streamP,
+                                                             mhdResponseStreamFree);
+  if (response == NULL)
+  {
+    if (streamP->compressed == true)
+      deflateEnd(&streamP->z);
+    free(streamP);
+  }
+
+  return response;
+}
@@ -43,7 +43,7 @@ extern "C"
 //
 // mongocContextCachePersist -
 //
-void mongocContextCachePersist(KjNode* contextObject)
+bool mongocContextCachePersist(KjNode* contextObject)
 {
   bson_t bson;
 
@@ -64,4 +64,6 @@ void mongocContextCachePersist(KjNode* contextObject)
   bson_destroy(&bson);
 
   // mongocConnectionRelease(); - done at the end of the request
+
+  return r;
 }
@@ -35,8 +35,8 @@ extern "C"
 
 // -----------------------------------------------------------------------------
 //
-// mongocContextCachePersist -
+// mongocContextCachePersist - returns false if the context couldn't be inserted
 //
-extern void mongocContextCachePersist(KjNode* contextObject);
+extern bool mongocContextCachePersist(KjNode* contextObject);
 
 #endif  // SRC_LIB_ORIONLD_MONGOC_MONGOCCONTEXTCACHEPERSIST_H_
@@ -22,6 +22,8 @@
 *
 * Author: Ken Zangelin
 */
+#include <set>                                                   // std::set
+
 #include <mongoc/mongoc.h>                                       // MongoDB C Client Driver
 
 extern "C"
@@ -32,13 +34,11 @@ extern "C"
 
 #include "logMsg/logMsg.h"                                       // LM_*
 
+#include "cache/subCache.h"                                      // subCacheHeadGet, tenantMatch, subCacheItemRemove
+
 #include "orionld/types/OrionldTenant.h"                         // OrionldTenant
-#include "orionld/types/QNode.h"                                 // QNode
 #include "orionld/common/orionldState.h"                         // mongocPool
-#include "orionld/common/subCacheApiSubscriptionInsert.h"        // subCacheApiSubscriptionInsert
-#include "orionld/pernot/pernotSubCacheAdd.h"                    // pernotSubCacheAdd
-#include "orionld/dbModel/dbModelToApiSubscription.h"            // dbModelToApiSubscription
-#include "orionld/context/orionldContextFromUrl.h"               // orionldContextFromUrl
+#include "orionld/common/subCacheDbSubscriptionInsert.h"         // subCacheDbSubscriptionInsert
 #include "orionld/mongoc/mongocWriteLog.h"                       // MONGOC_RLOG
 #include "orionld/mongoc/mongocKjTreeFromBson.h"                 // mongocKjTreeFromBson
 #include "orionld/mongoc/mongocSubCachePopulateByTenant.h"       // Own interface
@@ -93,24 +93,15 @@ bool mongocSubCachePopulateByTenant(OrionldTenant* tenantP, bool refresh)
     LM_RE(false, ("Internal Error (mongoc_collection_find_with_opts ERROR)"));
   }
 
-  if (refresh == true)
-  {
-    //
-    // Algorithm for "Delete subs that are no longer in DB":
-    //        1. Before the loop: Mark all subs in cache as "not in DB"
-    //        2. Inside the loop: When a sub is found in DB, mark it as "in DB"
-    //        3. After the loop:  Lookup all cached subs and remove thos "not in DB"
-    //
-
-    // Loop over the entire sub-cache and mark all subscriptions with inDB == false
-    char* tenantName = (tenantP != NULL)? tenantP->tenant : NULL;
-    for (CachedSubscription* cSubP = subCacheHeadGet(); cSubP != NULL; cSubP = cSubP->next)
-    {
-      LM_T(LmtSubCacheSync, ("tenantName: '%s' (cSubP->tenant: '%s')", tenantName, cSubP->tenant));
-      if (tenantMatch(tenantName, cSubP->tenant) == true)
-        cSubP->inDB = false;
-    }
-  }
+  //
+  // Algorithm for "Delete subs that are no longer in DB" (refresh only):
+  //        1. Inside the loop: When a sub is found in DB, remember it as "in DB"
+  //        2. After the loop:  Lookup all cached subs and remove those "not in DB"
+  //
+  // The cached subscriptions are read lock-free by alteration matching - the "in DB" marks are kept in a local set,
+  // not in the shared items
+  //
+  std::set<CachedSubscription*> inDbSet;
 
   while (mongoc_cursor_next(mongoCursorP, &mongoDocP))
   {
@@ -122,47 +113,15 @@ bool mongocSubCachePopulateByTenant(OrionldTenant* tenantP, bool refresh)
       continue;
     }
 
-    QNode*              qTree         = NULL;
-    KjNode*             contextNodeP  = NULL;
-    KjNode*             coordinatesP  = NULL;
-    KjNode*             showChangesP  = NULL;
-    KjNode*             sysAttrsP     = NULL;
-    OrionldRenderFormat renderFormat  = RF_NORMALIZED;
-    double              timeInterval  = 0;
-
-    kjTreeLog(dbSubP, "dbSubP", LmtPernot);
-    KjNode*      apiSubP       = dbModelToApiSubscription(dbSubP,
-                                                          tenantP->tenant,
-                                                          true,
-                                                          &qTree,
-                                                          &coordinatesP,
-                                                          &contextNodeP,
-                                                          &showChangesP,
-                                                          &sysAttrsP,
-                                                          &renderFormat,
-                                                          &timeInterval);
-
-    if (apiSubP == NULL)
-      continue;
-
-    kjTreeLog(apiSubP, "apiSubP", LmtPernot);
-
-    OrionldContext* contextP = NULL;
-    if (contextNodeP != NULL)
-      contextP = orionldContextFromUrl(contextNodeP->value.s, NULL);
+    CachedSubscription* cSubP = subCacheDbSubscriptionInsert(tenantP, dbSubP);
 
-    if (timeInterval == 0)
-    {
-      CachedSubscription* cSubP = subCacheApiSubscriptionInsert(apiSubP, qTree, coordinatesP, contextP, tenantP->tenant, showChangesP, sysAttrsP, renderFormat);
-      cSubP->inDB = true;
-    }
-    else
-      pernotSubCacheAdd(NULL, apiSubP, NULL, qTree, coordinatesP, contextP, tenantP, showChangesP, sysAttrsP, renderFormat, timeInterval);
+    if (cSubP != NULL)
+      inDbSet.insert(cSubP);
   }
 
   if (refresh == true)
   {
-    // Now loop over the entire sub-cache and remove those subscriptions with inDB == false;
+    // Now loop over the entire sub-cache and remove those subscriptions that weren't found in the DB
     CachedSubscription* cSubP = subCacheHeadGet();
     CachedSubscription* next;
 
@@ -171,7 +130,7 @@ bool mongocSubCachePopulateByTenant(OrionldTenant* tenantP, bool refresh)
     {
       next = cSubP->next;
 
-      if ((cSubP->inDB == false) && (tenantMatch(tenantName, cSubP->tenant) == true))
+      if ((inDbSet.count(cSubP) == 0) && (tenantMatch(tenantName, cSubP->tenant) == true))
       {
         subCacheItemRemove(cSubP);
       }
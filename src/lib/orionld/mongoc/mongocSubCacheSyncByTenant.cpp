@@ -0,0 +1,513 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+#include <string>                                                // std::string
+#include <map>                                                   // std::map
+#include <set>                                                   // std::set
+#include <mongoc/mongoc.h>                                       // MongoDB C Client Driver
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjLookup.h"                                      // kjLookup
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "cache/subCache.h"                                      // subCacheHeadGet, subCacheItemLookup, subCacheItemRemove, tenantMatch
+
+#include "orionld/types/OrionldTenant.h"                         // OrionldTenant
+#include "orionld/common/orionldState.h"                         // mongocPool
+#include "orionld/common/subCacheDbSubscriptionInsert.h"         // subCacheDbSubscriptionInsert
+#include "orionld/mongoc/mongocWriteLog.h"                       // MONGOC_RLOG
+#include "orionld/mongoc/mongocKjTreeFromBson.h"                 // mongocKjTreeFromBson
+#include "orionld/mongoc/mongocSubCachePopulateByTenant.h"       // mongocSubCachePopulateByTenant
+#include "orionld/mongoc/mongocSubCacheSyncByTenant.h"           // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SubCacheSyncState - where the last sync of a tenant ended
+//
+// Change streams need a replica set. With a standalone mongod, the subscriptions modified since the
+// last sync are found by their 'modifiedAt' (the watermark), and removed subscriptions by comparing the
+// subscription ids in the database with those in the sub-cache.
+//
+typedef struct SubCacheSyncState
+{
+  bool     changeStream;   // true: change stream, false: modifiedAt watermark
+  bson_t*  resumeTokenP;   // Change stream: where to resume
+  double   watermark;      // The newest 'modifiedAt' seen
+} SubCacheSyncState;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// syncStateMap - one item per tenant (key: mongoDbName)
+//
+// Only used by the sub-cache refresh, that runs with the cache semaphore taken - no lock needed
+//
+static std::map<std::string, SubCacheSyncState> syncStateMap;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// WATERMARK_OVERLAP - seconds to go back from the watermark when looking for modified subscriptions
+//
+// 'modifiedAt' is set by the broker that modified the subscription, with its own clock.
+// Looking back a little makes up for small clock differences between brokers - a subscription that has
+// already been seen isn't updated again in the sub-cache, as its 'modifiedAt' isn't newer.
+//
+#define WATERMARK_OVERLAP  2.0
+
+
+
+// -----------------------------------------------------------------------------
+//
+// CHANGE_STREAM_AWAIT_MS - how long to wait for more changes before the sync of a tenant is considered done
+//
+#define CHANGE_STREAM_AWAIT_MS  20
+
+
+
+// -----------------------------------------------------------------------------
+//
+// syncStateRelease -
+//
+static void syncStateRelease(const char* mongoDbName)
+{
+  std::map<std::string, SubCacheSyncState>::iterator it = syncStateMap.find(mongoDbName);
+
+  if (it == syncStateMap.end())
+    return;
+
+  if (it->second.resumeTokenP != NULL)
+    bson_destroy(it->second.resumeTokenP);
+
+  syncStateMap.erase(it);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// tenantWatermark - the newest 'modifiedAt' among the cached subscriptions of a tenant
+//
+static double tenantWatermark(OrionldTenant* tenantP)
+{
+  double watermark = 0;
+
+  for (CachedSubscription* cSubP = subCacheHeadGet(); cSubP != NULL; cSubP = cSubP->next)
+  {
+    if ((tenantMatch(tenantP->tenant, cSubP->tenant) == true) && (cSubP->modifiedAt > watermark))
+      watermark = cSubP->modifiedAt;
+  }
+
+  return watermark;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subscriptionIdGet - the _id of a subscription, as a string (NGSIv2 subscriptions have an ObjectId)
+//
+static const char* subscriptionIdGet(KjNode* idNodeP)
+{
+  if (idNodeP == NULL)
+    return NULL;
+
+  if (idNodeP->type == KjString)
+    return idNodeP->value.s;
+
+  if ((idNodeP->type == KjObject) && (idNodeP->value.firstChildP != NULL) && (idNodeP->value.firstChildP->type == KjString))
+    return idNodeP->value.firstChildP->value.s;  // { "$oid": "..." }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subscriptionRemove -
+//
+static void subscriptionRemove(OrionldTenant* tenantP, const char* subscriptionId)
+{
+  CachedSubscription* cSubP = subCacheItemLookup(tenantP->tenant, subscriptionId);
+
+  if (cSubP == NULL)
+    return;
+
+  LM_T(LmtSubCacheSync, ("%s: removed from the database - removing it from the sub-cache", subscriptionId));
+  subCacheItemRemove(cSubP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// changeStreamOpen -
+//
+// Updates that don't touch 'modifiedAt' are only notification counters ($inc, $max) - they're filtered out
+//
+static mongoc_change_stream_t* changeStreamOpen(mongoc_collection_t* subscriptionsP, const bson_t* resumeTokenP)
+{
+  bson_t* pipeline = BCON_NEW("pipeline", "[",
+                                "{", "$match", "{", "$or", "[",
+                                  "{", "operationType", "{", "$ne", BCON_UTF8("update"), "}", "}",
+                                  "{", "updateDescription.updatedFields.modifiedAt", "{", "$exists", BCON_BOOL(true), "}", "}",
+                                "]", "}", "}",
+                              "]");
+  bson_t* opts     = BCON_NEW("fullDocument",   BCON_UTF8("updateLookup"),
+                              "maxAwaitTimeMS", BCON_INT64(CHANGE_STREAM_AWAIT_MS));
+
+  if (resumeTokenP != NULL)
+    BSON_APPEND_DOCUMENT(opts, "resumeAfter", resumeTokenP);
+
+  mongoc_change_stream_t* streamP = mongoc_collection_watch(subscriptionsP, pipeline, opts);
+
+  bson_destroy(pipeline);
+  bson_destroy(opts);
+
+  return streamP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// changeStreamError - check (and log) the error state of a change stream
+//
+static bool changeStreamError(mongoc_change_stream_t* streamP, OrionldTenant* tenantP, bool silent)
+{
+  bson_error_t   error;
+  const bson_t*  errorDocP;
+
+  if (mongoc_change_stream_error_document(streamP, &error, &errorDocP) == false)
+    return false;
+
+  if (silent == false)
+    LM_W(("Database Error (change stream on subscriptions of tenant '%s': %s)", tenantP->mongoDbName, error.message));
+  else
+    LM_T(LmtSubCacheSync, ("No change stream for tenant '%s': %s", tenantP->mongoDbName, error.message));
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// changeStreamStart - open a change stream just to get a resume token for "now"
+//
+// Returns false if change streams aren't supported (mongod isn't part of a replica set)
+//
+static bool changeStreamStart(mongoc_collection_t* subscriptionsP, OrionldTenant* tenantP, SubCacheSyncState* stateP)
+{
+  mongoc_change_stream_t*  streamP = changeStreamOpen(subscriptionsP, NULL);
+  const bson_t*            eventP;
+
+  // Changes before the full populate that follows are of no interest
+  while (mongoc_change_stream_next(streamP, &eventP) == true)
+  {
+  }
+
+  bool           ok     = (changeStreamError(streamP, tenantP, true) == false);
+  const bson_t*  tokenP = (ok == true)? mongoc_change_stream_get_resume_token(streamP) : NULL;
+
+  if (tokenP != NULL)
+    stateP->resumeTokenP = bson_copy(tokenP);
+  else
+    ok = false;
+
+  mongoc_change_stream_destroy(streamP);
+
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// changeApply - apply one change stream event to the sub-cache
+//
+// Returns false if the change stream can't continue (collection dropped/renamed, ...)
+//
+static bool changeApply(OrionldTenant* tenantP, const bson_t* eventBsonP)
+{
+  char*    title;
+  char*    details;
+  KjNode*  eventP = mongocKjTreeFromBson(eventBsonP, &title, &details);
+
+  if (eventP == NULL)
+  {
+    LM_E(("Database Error (unable to create tree of a change stream event for tenant '%s': %s: %s)", tenantP->tenant, title, details));
+    return false;
+  }
+
+  KjNode* operationTypeP = kjLookup(eventP, "operationType");
+  KjNode* documentKeyP   = kjLookup(eventP, "documentKey");
+  KjNode* fullDocumentP  = kjLookup(eventP, "fullDocument");
+
+  if ((operationTypeP == NULL) || (operationTypeP->type != KjString))
+    return false;
+
+  const char* operationType = operationTypeP->value.s;
+
+  LM_T(LmtSubCacheSync, ("Change stream event '%s' for tenant '%s'", operationType, tenantP->mongoDbName));
+
+  if ((strcmp(operationType, "insert") == 0) || (strcmp(operationType, "update") == 0) || (strcmp(operationType, "replace") == 0))
+  {
+    // fullDocument is null if the subscription has been deleted after the change - a later 'delete' event takes care of it
+    if ((fullDocumentP != NULL) && (fullDocumentP->type == KjObject))
+      subCacheDbSubscriptionInsert(tenantP, fullDocumentP);
+  }
+  else if (strcmp(operationType, "delete") == 0)
+  {
+    const char* subscriptionId = subscriptionIdGet((documentKeyP != NULL)? kjLookup(documentKeyP, "_id") : NULL);
+
+    if (subscriptionId != NULL)
+      subscriptionRemove(tenantP, subscriptionId);
+  }
+  else  // drop, rename, dropDatabase, invalidate
+  {
+    LM_T(LmtSubCacheSync, ("Change stream for tenant '%s' invalidated by '%s'", tenantP->mongoDbName, operationType));
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// changeStreamSync - apply all changes since the resume token to the sub-cache
+//
+static bool changeStreamSync(mongoc_collection_t* subscriptionsP, OrionldTenant* tenantP, SubCacheSyncState* stateP)
+{
+  mongoc_change_stream_t*  streamP = changeStreamOpen(subscriptionsP, stateP->resumeTokenP);
+  const bson_t*            eventP;
+  bool                     ok      = true;
+  int                      changes = 0;
+
+  while (mongoc_change_stream_next(streamP, &eventP) == true)
+  {
+    ++changes;
+
+    if (changeApply(tenantP, eventP) == false)
+    {
+      ok = false;
+      break;
+    }
+  }
+
+  if ((ok == true) && (changeStreamError(streamP, tenantP, false) == true))
+    ok = false;
+
+  if (ok == true)
+  {
+    const bson_t* tokenP = mongoc_change_stream_get_resume_token(streamP);
+
+    if (tokenP != NULL)
+    {
+      bson_destroy(stateP->resumeTokenP);
+      stateP->resumeTokenP = bson_copy(tokenP);
+    }
+  }
+
+  mongoc_change_stream_destroy(streamP);
+
+  LM_T(LmtSubCacheSync, ("%d subscription changes for tenant '%s' (change stream)", changes, tenantP->mongoDbName));
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// watermarkSync - apply the subscriptions modified since the watermark, and remove the deleted ones
+//
+static bool watermarkSync(mongoc_collection_t* subscriptionsP, OrionldTenant* tenantP, SubCacheSyncState* stateP)
+{
+  mongoc_cursor_t*  cursorP;
+  const bson_t*     docP;
+  bson_error_t      error;
+  char*             title;
+  char*             details;
+  int               changes = 0;
+
+  //
+  // 1. Inserted or modified
+  //
+  bson_t* filterP = BCON_NEW("modifiedAt", "{", "$gt", BCON_DOUBLE(stateP->watermark - WATERMARK_OVERLAP), "}");
+
+  MONGOC_RLOG("Modified subscriptions for sub-cache", tenantP->mongoDbName, "csubs", filterP, NULL, LmtMongoc);
+  cursorP = mongoc_collection_find_with_opts(subscriptionsP, filterP, NULL, NULL);
+  bson_destroy(filterP);
+
+  while (mongoc_cursor_next(cursorP, &docP))
+  {
+    KjNode* dbSubP = mongocKjTreeFromBson(docP, &title, &details);
+
+    if (dbSubP == NULL)
+      continue;
+
+    KjNode* modifiedAtP = kjLookup(dbSubP, "modifiedAt");
+
+    if ((modifiedAtP != NULL) && (modifiedAtP->type == KjFloat) && (modifiedAtP->value.f > stateP->watermark))
+      stateP->watermark = modifiedAtP->value.f;
+
+    subCacheDbSubscriptionInsert(tenantP, dbSubP);
+    ++changes;
+  }
+
+  bool ok = (mongoc_cursor_error(cursorP, &error) == false);
+  mongoc_cursor_destroy(cursorP);
+
+  if (ok == false)
+    LM_RE(false, ("Database Error (looking up modified subscriptions for tenant '%s': %s)", tenantP->mongoDbName, error.message));
+
+  //
+  // 2. Removed - only the ids are extracted from the database
+  //
+  bson_t  filter;
+  bson_t* optsP = BCON_NEW("projection", "{", "_id", BCON_INT32(1), "}");
+
+  bson_init(&filter);
+  cursorP = mongoc_collection_find_with_opts(subscriptionsP, &filter, optsP, NULL);
+  bson_destroy(optsP);
+  bson_destroy(&filter);
+
+  //
+  // The cached subscriptions are read lock-free by alteration matching - the mark-and-sweep state is kept
+  // in a local set, not in the shared items
+  //
+  std::set<CachedSubscription*> inDbSet;
+
+  while (mongoc_cursor_next(cursorP, &docP))
+  {
+    bson_iter_t iter;
+
+    if ((bson_iter_init_find(&iter, docP, "_id") == false) || (BSON_ITER_HOLDS_UTF8(&iter) == false))
+      continue;  // NGSIv2 subscriptions (ObjectId) aren't handled by NGSI-LD
+
+    CachedSubscription* cSubP = subCacheItemLookup(tenantP->tenant, bson_iter_utf8(&iter, NULL));
+
+    if (cSubP != NULL)
+      inDbSet.insert(cSubP);
+  }
+
+  ok = (mongoc_cursor_error(cursorP, &error) == false);
+  mongoc_cursor_destroy(cursorP);
+
+  if (ok == false)
+    LM_RE(false, ("Database Error (looking up subscription ids for tenant '%s': %s)", tenantP->mongoDbName, error.message));
+
+  CachedSubscription* next;
+  for (CachedSubscription* cSubP = subCacheHeadGet(); cSubP != NULL; cSubP = next)
+  {
+    next = cSubP->next;
+
+    if ((inDbSet.count(cSubP) == 0) && (tenantMatch(tenantP->tenant, cSubP->tenant) == true))
+    {
+      LM_T(LmtSubCacheSync, ("%s: not in the database anymore - removing it from the sub-cache", cSubP->subscriptionId));
+      subCacheItemRemove(cSubP);
+      ++changes;
+    }
+  }
+
+  LM_T(LmtSubCacheSync, ("%d subscription changes for tenant '%s' (watermark %f)", changes, tenantP->mongoDbName, stateP->watermark));
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mongocSubCacheSyncByTenant -
+//
+// The first sync of a tenant:
+//   1. Gets a resume token for a change stream on the csubs collection of the tenant (if the DB is a replica set)
+//   2. Populates the sub-cache with all subscriptions of the tenant (a full refresh)
+//   3. Sets the watermark to the newest 'modifiedAt' of the subscriptions in the cache
+// Every following sync only applies the changes since the previous sync (change stream or watermark).
+// If the change stream fails (e.g. the resume token is too old), the state is thrown away and the next sync is a first sync.
+//
+// IMPORTANT NOTE:
+//   As this function is called outside of the "Request Threads", orionldState cannot be used!
+//
+bool mongocSubCacheSyncByTenant(OrionldTenant* tenantP)
+{
+  mongoc_client_t*      connectionP    = mongoc_client_pool_pop(mongocPool);
+  mongoc_collection_t*  subscriptionsP = mongoc_client_get_collection(connectionP, tenantP->mongoDbName, "csubs");
+  bool                  ok             = true;
+
+  std::map<std::string, SubCacheSyncState>::iterator it = syncStateMap.find(tenantP->mongoDbName);
+
+  if (it == syncStateMap.end())
+  {
+    SubCacheSyncState state = { false, NULL, 0 };
+
+    state.changeStream = changeStreamStart(subscriptionsP, tenantP, &state);
+
+    mongoc_collection_destroy(subscriptionsP);
+    mongoc_client_pool_push(mongocPool, connectionP);
+
+    LM_T(LmtSubCacheSync, ("First sync for tenant '%s' - full populate (then %s)", tenantP->mongoDbName, (state.changeStream == true)? "change stream" : "watermark"));
+
+    ok              = mongocSubCachePopulateByTenant(tenantP, true);
+    state.watermark = tenantWatermark(tenantP);
+
+    if (ok == true)
+      syncStateMap[tenantP->mongoDbName] = state;
+    else if (state.resumeTokenP != NULL)
+      bson_destroy(state.resumeTokenP);
+
+    return ok;
+  }
+
+  SubCacheSyncState* stateP = &it->second;
+
+  if (stateP->changeStream == true)
+    ok = changeStreamSync(subscriptionsP, tenantP, stateP);
+  else
+    ok = watermarkSync(subscriptionsP, tenantP, stateP);
+
+  mongoc_collection_destroy(subscriptionsP);
+  mongoc_client_pool_push(mongocPool, connectionP);
+
+  if (ok == false)
+  {
+    LM_W(("Incremental sub-cache sync failed for tenant '%s' - the next sync will be a full refresh", tenantP->mongoDbName));
+    syncStateRelease(tenantP->mongoDbName);
+  }
+
+  return ok;
+}
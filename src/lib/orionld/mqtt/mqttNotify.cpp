@@ -126,7 +126,18 @@ static KjNode* headersParse(struct iovec* ioVec, int ioVecSize, CachedSubscripti
 //
 // mqttNotify -
 //
-int mqttNotify(CachedSubscription* cSubP, struct iovec* ioVec, int ioVecSize, double notificationTime)
+// If 'mqttTokenP' is given, the completion of the publication is not awaited - the connection and the delivery token are
+// returned instead, and -4 ("completion pending") is returned - see notificationResponsesAwait.
+//
+int mqttNotify
+(
+  CachedSubscription*        cSubP,
+  struct iovec*              ioVec,
+  int                        ioVecSize,
+  double                     notificationTime,
+  MqttConnection**           mqttConnectionPP,
+  MQTTClient_deliveryToken*  mqttTokenP
+)
 {
   //
   // The headers and the body comes already rendered inside ioVec
@@ -196,6 +207,13 @@ int mqttNotify(CachedSubscription* cSubP, struct iovec* ioVec, int ioVecSize, do
     return -1;
   }
 
+  if (mqttTokenP != NULL)
+  {
+    *mqttConnectionPP = mqttConnectionP;
+    *mqttTokenP       = mqttToken;
+    return -4;
+  }
+
   extern int  mqttTimeout;  // From mqttNotification.cpp - should be a CLI
   int rc = MQTTClient_waitForCompletion(mqttConnectionP->client, mqttToken, mqttTimeout);
   if (rc != 0)
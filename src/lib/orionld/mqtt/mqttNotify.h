@@ -26,15 +26,25 @@
 * Author: Ken Zangelin
 */
 #include <sys/uio.h>                                           // struct iovec
+#include <MQTTClient.h>                                        // MQTTClient_deliveryToken
 
 #include "cache/subCache.h"                                    // CachedSubscription
+#include "orionld/types/MqttConnection.h"                      // MqttConnection
 
 
 
 // -----------------------------------------------------------------------------
 //
-// mqttNotify -
+// mqttNotify - publish a notification - await its completion unless 'mqttTokenP' is given
 //
-extern int mqttNotify(CachedSubscription* cSubP, struct iovec* ioVec, int ioVecSize, double timestamp);
+extern int mqttNotify
+(
+  CachedSubscription*        cSubP,
+  struct iovec*              ioVec,
+  int                        ioVecSize,
+  double                     timestamp,
+  MqttConnection**           mqttConnectionPP,
+  MQTTClient_deliveryToken*  mqttTokenP
+);
 
 #endif  // SRC_LIB_ORIONLD_MQTT_MQTTNOTIFY_H_
@@ -0,0 +1,421 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <errno.h>                                               // errno, EINTR
+#include <string.h>                                              // strcmp, strdup, strerror, bzero
+#include <stdlib.h>                                              // malloc, free
+#include <unistd.h>                                              // close
+#include <poll.h>                                                // poll
+#include <time.h>                                                // clock_gettime
+#include <pthread.h>                                             // pthread_mutex_t, pthread_cond_t
+#include <sys/socket.h>                                          // sendmsg, MSG_NOSIGNAL
+#include <sys/uio.h>                                             // iovec
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/NotificationConnection.h"                        // NotificationConnection
+#include "orionld/common/orionldState.h"                         // notifConnMax, notifConnIdle, promNotificationConnections*
+#include "orionld/common/orionldServerConnect.h"                 // orionldServerConnect
+#include "orionld/prometheus/promCounterIncrease.h"              // promCounterIncrease
+#include "orionld/notifications/httpConnectionPool.h"            // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// NotificationConnectionHost - the pool of connections to one host:port
+//
+// The number of different notification endpoints is normally small, so a linked list of hosts is good enough.
+// All hosts share one mutex - it is held only to pick/return a connection, never during connect/send/receive.
+//
+typedef struct NotificationConnectionHost
+{
+  char*                               ip;
+  unsigned short                      port;
+  NotificationConnection*             idleList;   // Most recently used first
+  int                                 idle;       // Number of connections in idleList
+  int                                 inUse;      // Number of pooled connections currently in use
+  struct NotificationConnectionHost*  next;
+} NotificationConnectionHost;
+
+
+
+static pthread_mutex_t      poolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t       poolCond  = PTHREAD_COND_INITIALIZER;
+static NotificationConnectionHost*  hostList  = NULL;
+static time_t               lastEvict = 0;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionDestroy -
+//
+static void httpConnectionDestroy(NotificationConnection* connP)
+{
+  if (connP->fd != -1)
+    close(connP->fd);
+
+  if (connP->pending != NULL)
+    free(connP->pending);
+
+  free(connP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionCreate -
+//
+static NotificationConnection* httpConnectionCreate(const char* ip, unsigned short port, NotificationConnectionHost* hostP)
+{
+  int fd = orionldServerConnect(ip, port);
+
+  if (fd == -1)
+    return NULL;
+
+  NotificationConnection* connP = (NotificationConnection*) calloc(1, sizeof(NotificationConnection));
+  if (connP == NULL)
+  {
+    LM_E(("Out of memory allocating an NotificationConnection"));
+    close(fd);
+    return NULL;
+  }
+
+  connP->fd    = fd;
+  connP->hostP = hostP;
+
+  promCounterIncrease(promNotificationConnectionsOpened);
+
+  return connP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionHealthy - an idle keep-alive connection must have nothing to read
+//
+// If the peer has closed the connection, the socket is readable (EOF) or has POLLHUP/POLLERR set.
+// Any other unexpected data also means the connection is out of sync and can't be used.
+//
+static bool httpConnectionHealthy(NotificationConnection* connP)
+{
+  struct pollfd pollFd = { connP->fd, POLLIN, 0 };
+
+  if (connP->pending != NULL)
+    return false;
+
+  int fds = poll(&pollFd, 1, 0);
+
+  if (fds == 0)
+    return true;
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// hostLookup - must be called with poolMutex taken
+//
+static NotificationConnectionHost* hostLookup(const char* ip, unsigned short port)
+{
+  for (NotificationConnectionHost* hostP = hostList; hostP != NULL; hostP = hostP->next)
+  {
+    if ((hostP->port == port) && (strcmp(hostP->ip, ip) == 0))
+      return hostP;
+  }
+
+  NotificationConnectionHost* hostP = (NotificationConnectionHost*) calloc(1, sizeof(NotificationConnectionHost));
+  if (hostP == NULL)
+    return NULL;
+
+  hostP->ip   = strdup(ip);
+  hostP->port = port;
+  hostP->next = hostList;
+  hostList    = hostP;
+
+  return hostP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// idleConnectionsEvict - close all idle connections that have been unused for more than -notifConnIdle seconds
+//
+// Must be called with poolMutex taken
+//
+static void idleConnectionsEvict(time_t now)
+{
+  for (NotificationConnectionHost* hostP = hostList; hostP != NULL; hostP = hostP->next)
+  {
+    NotificationConnection* prev  = NULL;
+    NotificationConnection* connP = hostP->idleList;
+
+    while (connP != NULL)
+    {
+      NotificationConnection* next = connP->next;
+
+      if (now - connP->lastUsed > notifConnIdle)
+      {
+        LM_T(LmtNotificationSend, ("Closing idle connection to %s:%d (fd %d)", hostP->ip, hostP->port, connP->fd));
+
+        if (prev == NULL)
+          hostP->idleList = next;
+        else
+          prev->next = next;
+
+        --hostP->idle;
+        httpConnectionDestroy(connP);
+      }
+      else
+        prev = connP;
+
+      connP = next;
+    }
+  }
+
+  lastEvict = now;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionGet -
+//
+NotificationConnection* httpConnectionGet(const char* ip, unsigned short port, bool wait)
+{
+  if (notifConnMax == 0)
+    return httpConnectionCreate(ip, port, NULL);
+
+  time_t now = time(NULL);
+
+  pthread_mutex_lock(&poolMutex);
+
+  if (now != lastEvict)
+    idleConnectionsEvict(now);
+
+  NotificationConnectionHost* hostP = hostLookup(ip, port);
+  if (hostP == NULL)
+  {
+    pthread_mutex_unlock(&poolMutex);
+    LM_E(("Out of memory allocating a connection pool for %s:%d", ip, port));
+    return httpConnectionCreate(ip, port, NULL);
+  }
+
+  while (1)
+  {
+    while (hostP->idleList != NULL)
+    {
+      NotificationConnection* connP = hostP->idleList;
+
+      hostP->idleList = connP->next;
+      --hostP->idle;
+
+      if (httpConnectionHealthy(connP) == false)
+      {
+        LM_T(LmtNotificationSend, ("Idle connection to %s:%d (fd %d) has been closed by the peer", ip, port, connP->fd));
+        httpConnectionDestroy(connP);
+        continue;
+      }
+
+      ++hostP->inUse;
+      pthread_mutex_unlock(&poolMutex);
+
+      connP->next        = NULL;
+      connP->reused      = true;
+      connP->keepAlive   = false;
+      connP->gotResponse = false;
+
+      LM_T(LmtNotificationSend, ("Reusing connection to %s:%d (fd %d)", ip, port, connP->fd));
+      promCounterIncrease(promNotificationConnectionsReused);
+      return connP;
+    }
+
+    if (hostP->inUse + hostP->idle < notifConnMax)
+      break;
+
+    if (wait == false)
+    {
+      pthread_mutex_unlock(&poolMutex);
+      LM_T(LmtNotificationSend, ("All %d connections to %s:%d are busy - using a one-shot connection", notifConnMax, ip, port));
+      return httpConnectionCreate(ip, port, NULL);
+    }
+
+    //
+    // All connections to this host are busy - wait (max one second) for one of them to be released.
+    // If none is released in time, a one-shot connection is used.
+    //
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 1;
+
+    if (pthread_cond_timedwait(&poolCond, &poolMutex, &deadline) != 0)
+    {
+      pthread_mutex_unlock(&poolMutex);
+      LM_T(LmtNotificationSend, ("All %d connections to %s:%d are busy - using a one-shot connection", notifConnMax, ip, port));
+      return httpConnectionCreate(ip, port, NULL);
+    }
+  }
+
+  ++hostP->inUse;
+  pthread_mutex_unlock(&poolMutex);
+
+  NotificationConnection* connP = httpConnectionCreate(ip, port, hostP);
+
+  if (connP == NULL)
+  {
+    pthread_mutex_lock(&poolMutex);
+    --hostP->inUse;
+    pthread_cond_signal(&poolCond);
+    pthread_mutex_unlock(&poolMutex);
+  }
+
+  return connP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionSend -
+//
+bool httpConnectionSend(NotificationConnection* connP, struct iovec* ioVec, int ioVecLen)
+{
+  struct msghdr msg;
+
+  bzero(&msg, sizeof(msg));
+  msg.msg_iov    = ioVec;
+  msg.msg_iovlen = ioVecLen;
+
+  while (msg.msg_iovlen > 0)
+  {
+    ssize_t nb = sendmsg(connP->fd, &msg, MSG_NOSIGNAL);
+
+    if (nb == -1)
+    {
+      if (errno == EINTR)
+        continue;
+
+      LM_T(LmtNotificationSend, ("sendmsg(fd %d): %s", connP->fd, strerror(errno)));
+      connP->keepAlive = false;
+      return false;
+    }
+
+    // Step over what's been written - partial writes are possible for big payloads
+    while ((msg.msg_iovlen > 0) && ((size_t) nb >= msg.msg_iov->iov_len))
+    {
+      nb -= msg.msg_iov->iov_len;
+      ++msg.msg_iov;
+      --msg.msg_iovlen;
+    }
+
+    if (msg.msg_iovlen > 0)
+    {
+      msg.msg_iov->iov_base  = (char*) msg.msg_iov->iov_base + nb;
+      msg.msg_iov->iov_len  -= nb;
+    }
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionRelease -
+//
+void httpConnectionRelease(NotificationConnection* connP)
+{
+  NotificationConnectionHost* hostP = connP->hostP;
+
+  if (hostP == NULL)
+  {
+    httpConnectionDestroy(connP);
+    return;
+  }
+
+  //
+  // Bytes beyond the end of the response can only be a protocol error, as only one request at a time is sent over a pooled connection
+  //
+  bool reuse = (connP->keepAlive == true) && (connP->pending == NULL);
+
+  pthread_mutex_lock(&poolMutex);
+
+  --hostP->inUse;
+
+  if ((reuse == true) && (hostP->idle < notifConnMax))
+  {
+    connP->lastUsed = time(NULL);
+    connP->next     = hostP->idleList;
+    hostP->idleList = connP;
+    ++hostP->idle;
+    connP = NULL;
+  }
+
+  pthread_cond_signal(&poolCond);
+  pthread_mutex_unlock(&poolMutex);
+
+  if (connP != NULL)
+    httpConnectionDestroy(connP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionPoolRelease -
+//
+void httpConnectionPoolRelease(void)
+{
+  pthread_mutex_lock(&poolMutex);
+
+  NotificationConnectionHost* hostP = hostList;
+  while (hostP != NULL)
+  {
+    NotificationConnectionHost* next = hostP->next;
+
+    while (hostP->idleList != NULL)
+    {
+      NotificationConnection* connP = hostP->idleList;
+
+      hostP->idleList = connP->next;
+      httpConnectionDestroy(connP);
+    }
+
+    free(hostP->ip);
+    free(hostP);
+    hostP = next;
+  }
+
+  hostList = NULL;
+  pthread_mutex_unlock(&poolMutex);
+}
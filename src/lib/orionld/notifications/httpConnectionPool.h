@@ -0,0 +1,71 @@
+#ifndef SRC_LIB_ORIONLD_NOTIFICATIONS_HTTPCONNECTIONPOOL_H_
+#define SRC_LIB_ORIONLD_NOTIFICATIONS_HTTPCONNECTIONPOOL_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <sys/uio.h>                                             // iovec
+
+#include "orionld/types/NotificationConnection.h"                        // NotificationConnection
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionGet - get a connection to ip:port, an idle keep-alive connection if there is one
+//
+// If -notifConnMax is zero, no connections are kept alive and a new connection is created every time.
+// If all -notifConnMax connections to the host are busy, 'wait' decides what happens:
+//   true:  wait (max one second) for a connection to be released (notification worker threads)
+//   false: use a one-shot connection right away - the inline path (request thread), whose busy connections
+//          are its own and are not released until the responses are read
+// Returns NULL if the connection can't be established.
+//
+extern NotificationConnection* httpConnectionGet(const char* ip, unsigned short port, bool wait);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionSend - write an entire HTTP request to the connection (no SIGPIPE if the peer has closed)
+//
+extern bool httpConnectionSend(NotificationConnection* connP, struct iovec* ioVec, int ioVecLen);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionRelease - give the connection back to the pool, or close it if it can't be reused
+//
+extern void httpConnectionRelease(NotificationConnection* connP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpConnectionPoolRelease - close all idle connections and free the pool
+//
+extern void httpConnectionPoolRelease(void);
+
+#endif  // SRC_LIB_ORIONLD_NOTIFICATIONS_HTTPCONNECTIONPOOL_H_
@@ -22,34 +22,135 @@
 *
 * Author: Ken Zangelin
 */
+#include <string.h>                                              // strerror, memcpy
 #include <unistd.h>                                              // close
 #include <sys/uio.h>                                             // iovec, writev
 
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+}
+
 #include "logMsg/logMsg.h"                                       // LM
 
+#include "orionld/types/NotificationConnection.h"                        // NotificationConnection
+#include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/orionldServerConnect.h"                 // orionldServerConnect
+#include "orionld/notifications/httpConnectionPool.h"            // httpConnectionGet, httpConnectionSend, httpConnectionRelease
 #include "orionld/notifications/notificationFailure.h"           // notificationFailure
 #include "cache/CachedSubscription.h"                            // CachedSubscription
 
 
 
+// -----------------------------------------------------------------------------
+//
+// requestTrace -
+//
+static void requestTrace(const char* subscriptionId, struct iovec* ioVec, int ioVecLen)
+{
+  if (lmTraceIsSet(LmtNotificationHeaders) == true)
+  {
+    for (int ix = 0; ix < ioVecLen - 1; ix++)
+    {
+      LM_T(LmtNotificationHeaders, ("%s: Notification Request Header: '%s'", subscriptionId, ioVec[ix].iov_base));
+    }
+  }
+
+  LM_T(LmtNotificationBody, ("%s: Notification Request Body: %s", subscriptionId, ioVec[ioVecLen - 1].iov_base));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpNotifyPooled - send a notification over a keep-alive connection
+//
+// sendmsg() moves the iovec pointers on partial writes, so a copy of the iovec array is used - a failed send over
+// a reused connection (closed by the peer while idle) is retried once over a new connection.
+//
+static int httpNotifyPooled
+(
+  CachedSubscription*       cSubP,
+  PernotSubscription*       pSubP,
+  const char*               subscriptionId,
+  const char*               ip,
+  unsigned short            port,
+  struct iovec*             ioVec,
+  int                       ioVecLen,
+  double                    notificationTime,
+  NotificationConnection**  connPP
+)
+{
+  struct iovec* ioVecCopy = (struct iovec*) kaAlloc(&orionldState.kalloc, ioVecLen * sizeof(struct iovec));
+
+  if (ioVecCopy == NULL)
+  {
+    notificationFailure(cSubP, pSubP, "Out of memory", notificationTime);
+    return -1;
+  }
+
+  requestTrace(subscriptionId, ioVec, ioVecLen);
+
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    NotificationConnection* connP = httpConnectionGet(ip, port, false);
+
+    if (connP == NULL)
+    {
+      LM_E(("Internal Error (unable to connect to server for notification for subscription '%s': %s)", subscriptionId, strerror(errno)));
+      notificationFailure(cSubP, pSubP, "Unable to connect to notification endpoint", notificationTime);
+      return -1;
+    }
+
+    memcpy(ioVecCopy, ioVec, ioVecLen * sizeof(struct iovec));
+
+    if (httpConnectionSend(connP, ioVecCopy, ioVecLen) == true)
+    {
+      LM_T(LmtNotificationSend, ("%s: Notification sent over fd %d to %s:%d (%s connection)", subscriptionId, connP->fd, ip, port, (connP->reused == true)? "reused" : "new"));
+      *connPP = connP;
+      return connP->fd;
+    }
+
+    bool reused = connP->reused;
+
+    httpConnectionRelease(connP);
+
+    if (reused == false)
+      break;
+  }
+
+  LM_E(("Internal Error (unable to send to server for notification for subscription '%s': %s", subscriptionId, strerror(errno)));
+  notificationFailure(cSubP, pSubP, "Unable to write to notification endpoint", notificationTime);
+  return -1;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // httpNotify - send a notification over http
 //
+// If connPP is non-NULL, the connection is taken from the keep-alive connection pool (-notifConnMax) and
+// it is returned in *connPP. The caller reads the response and gives the connection back with httpConnectionRelease().
+// If connPP is NULL, a new connection is created and its file descriptor is returned (the caller closes it).
+//
 int httpNotify
 (
-  CachedSubscription*  cSubP,
-  PernotSubscription*  pSubP,
-  const char*          subscriptionId,
-  const char*          ip,
-  unsigned short       port,
-  const char*          path,
-  struct iovec*        ioVec,
-  int                  ioVecLen,
-  double               notificationTime
+  CachedSubscription*       cSubP,
+  PernotSubscription*       pSubP,
+  const char*               subscriptionId,
+  const char*               ip,
+  unsigned short            port,
+  const char*               path,
+  struct iovec*             ioVec,
+  int                       ioVecLen,
+  double                    notificationTime,
+  NotificationConnection**  connPP
 )
 {
+  if (connPP != NULL)
+    return httpNotifyPooled(cSubP, pSubP, subscriptionId, ip, port, ioVec, ioVecLen, notificationTime, connPP);
+
   // Connect
   LM_T(LmtNotificationSend, ("%s: Connecting to notification '%s:%d' receptor for HTTP notification", subscriptionId, ip, port));
   int fd = orionldServerConnect(ip, port);
@@ -63,15 +164,7 @@ int httpNotify
 
   LM_T(LmtNotificationSend, ("%s: Connected to notification receptor '%s:%d' on fd %d", subscriptionId, ip, port, fd));
 
-  if (lmTraceIsSet(LmtNotificationHeaders) == true)
-  {
-    for (int ix = 0; ix < ioVecLen - 1; ix++)
-    {
-      LM_T(LmtNotificationHeaders, ("%s: Notification Request Header: '%s'", subscriptionId, ioVec[ix].iov_base));
-    }
-  }
-
-  LM_T(LmtNotificationBody, ("%s: Notification Request Body: %s", subscriptionId, ioVec[ioVecLen - 1].iov_base));
+  requestTrace(subscriptionId, ioVec, ioVecLen);
 
   // Send
   int nb;
@@ -30,6 +30,7 @@
 #include "cache/CachedSubscription.h"                            // CachedSubscription
 
 #include "orionld/types/PernotSubscription.h"                    // PernotSubscription
+#include "orionld/types/NotificationConnection.h"                        // NotificationConnection
 
 
 
@@ -39,15 +40,16 @@
 //
 extern int httpNotify
 (
-  CachedSubscription*  cSubP,
-  PernotSubscription*  pSubP,
-  const char*          subscriptionId,
-  const char*          ip,
-  unsigned short       port,
-  const char*          path,
-  struct iovec*        ioVec,
-  int                  ioVecLen,
-  double               notificationTime
+  CachedSubscription*       cSubP,
+  PernotSubscription*       pSubP,
+  const char*               subscriptionId,
+  const char*               ip,
+  unsigned short            port,
+  const char*               path,
+  struct iovec*             ioVec,
+  int                       ioVecLen,
+  double                    notificationTime,
+  NotificationConnection**  connPP
 );
 
 #endif  // SRC_LIB_ORIONLD_NOTIFICATIONS_HTTPNOTIFY_H_
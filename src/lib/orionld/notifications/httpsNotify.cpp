@@ -25,10 +25,15 @@
 #include <sys/uio.h>                                             // iovec
 #include <curl/curl.h>                                           // curl
 
+extern "C"
+{
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+}
+
 #include "logMsg/logMsg.h"                                       // LM*
 #include "cache/CachedSubscription.h"                            // CachedSubscription
 #include "orionld/types/OrionldAlteration.h"                     // OrionldAlterationMatch
-#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/orionldState.h"                         // orionldState, notifTimeout
 
 
 
@@ -163,7 +168,7 @@ int httpsNotify(CachedSubscription* cSubP, struct iovec* ioVec, int ioVecLen, do
   LM_T(LmtNotificationSend, ("%s: URL: %s", cSubP->subscriptionId, url));
   curl_easy_setopt(curlHandleP, CURLOPT_URL, url);
   curl_easy_setopt(curlHandleP, CURLOPT_CUSTOMREQUEST, "POST");
-  curl_easy_setopt(curlHandleP, CURLOPT_TIMEOUT_MS, 5000);                     // Timeout - hard-coded to 5 seconds for now ...
+  curl_easy_setopt(curlHandleP, CURLOPT_TIMEOUT_MS, (long) notifTimeout);      // Timeout - -notifTimeout (default: 5 seconds)
   curl_easy_setopt(curlHandleP, CURLOPT_FOLLOWLOCATION, 1L);                   // Follow redirections
 
   // SSL options
@@ -196,7 +201,8 @@ int httpsNotify(CachedSubscription* cSubP, struct iovec* ioVec, int ioVecLen, do
   // Payload Body
   //
   LM_T(LmtNotificationBody, ("%s: Notification Request Body: %s", cSubP->subscriptionId, ioVec[ioVecLen - 1].iov_base));
-  curl_easy_setopt(curlHandleP, CURLOPT_POSTFIELDS, (u_int8_t*) ioVec[ioVecLen - 1].iov_base);
+  curl_easy_setopt(curlHandleP, CURLOPT_POSTFIELDS,    (u_int8_t*) ioVec[ioVecLen - 1].iov_base);
+  curl_easy_setopt(curlHandleP, CURLOPT_POSTFIELDSIZE, (long) ioVec[ioVecLen - 1].iov_len);  // The body may be compressed - binary
 
   //
   // Is curl to be debugged (CLI parameter)?
@@ -210,7 +216,7 @@ int httpsNotify(CachedSubscription* cSubP, struct iovec* ioVec, int ioVecLen, do
   // Debug Incoming HTTP Headers?
   if (lmTraceIsSet(LmtNotificationHeaders) == true)
   {
-    curl_easy_setopt(curlHandleP, CURLOPT_HEADERDATA,     cSubP->subscriptionId);
+    curl_easy_setopt(curlHandleP, CURLOPT_HEADERDATA,     kaStrdup(&orionldState.kalloc, cSubP->subscriptionId));  // The transfer outlives the read section
     curl_easy_setopt(curlHandleP, CURLOPT_HEADERFUNCTION, responseHeaderDebug);   // Callback for received headers
   }
 
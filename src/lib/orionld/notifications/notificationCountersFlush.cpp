@@ -0,0 +1,74 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                                 // int64_t
+
+#include "logMsg/logMsg.h"                                          // LM_*
+#include "logMsg/traceLevels.h"                                     // LmtNotificationStats
+
+#include "cache/CachedSubscription.h"                               // CachedSubscription
+
+#include "orionld/mongoc/mongocSubCountersUpdate.h"                 // mongocSubCountersUpdate
+#include "orionld/notifications/notificationCountersFlush.h"        // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationCountersFlush - push the notification counters of a cached subscription to the database
+//
+// Only one of the threads that find the subscription 'dirty' gets to flush - the one that resets 'dirty'.
+// The counters are moved from the cache to the database atomically, so no notification is counted twice or lost.
+//
+void notificationCountersFlush(CachedSubscription* subP, bool forcedToPause)
+{
+  if ((__atomic_exchange_n(&subP->dirty, 0, __ATOMIC_ACQ_REL) == 0) && (forcedToPause == false))
+    return;  // Another thread was faster
+
+  int64_t count    = __atomic_exchange_n(&subP->count,    0, __ATOMIC_ACQ_REL);
+  int64_t failures = __atomic_exchange_n(&subP->failures, 0, __ATOMIC_ACQ_REL);
+  double  lastNotificationTime;
+  double  lastSuccess;
+  double  lastFailure;
+
+  __atomic_load(&subP->lastNotificationTime, &lastNotificationTime, __ATOMIC_RELAXED);
+  __atomic_load(&subP->lastSuccess,          &lastSuccess,          __ATOMIC_RELAXED);
+  __atomic_load(&subP->lastFailure,          &lastFailure,          __ATOMIC_RELAXED);
+
+  LM_T(LmtNotificationStats, ("%s: Calling mongocSubCountersUpdate", subP->subscriptionId));
+
+  mongocSubCountersUpdate(subP->tenantP,
+                          subP->subscriptionId,
+                          (subP->ldContext != ""),
+                          count,
+                          failures,
+                          0,
+                          lastNotificationTime,
+                          lastSuccess,
+                          lastFailure,
+                          forcedToPause);
+
+  __atomic_fetch_add(&subP->dbCount,    count,    __ATOMIC_RELAXED);
+  __atomic_fetch_add(&subP->dbFailures, failures, __ATOMIC_RELAXED);
+}
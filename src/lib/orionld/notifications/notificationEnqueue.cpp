@@ -0,0 +1,66 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // free
+#include <sys/uio.h>                                             // iovec
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "cache/CachedSubscription.h"                            // CachedSubscription
+
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+#include "orionld/notifications/notificationJobCreate.h"         // notificationJobCreate
+#include "orionld/notifications/notificationFailure.h"           // notificationFailure
+#include "orionld/notifications/notificationQueue.h"             // notificationQueuePush
+#include "orionld/notifications/notificationEnqueue.h"           // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationEnqueue -
+//
+int notificationEnqueue(CachedSubscription* subP, struct iovec* ioVec, int ioVecLen, double notificationTime)
+{
+  NotificationJob* jobP = notificationJobCreate(subP, ioVec, ioVecLen, notificationTime);
+
+  if (jobP == NULL)
+  {
+    LM_E(("Out of memory (allocating a notification job for subscription '%s')", subP->subscriptionId));
+    notificationFailure(subP, "Out of memory", notificationTime);
+    return -1;
+  }
+
+  if (notificationQueuePush(jobP) == false)
+  {
+    free(jobP);
+
+    LM_W(("%s: the notification queue is full - notification dropped", subP->subscriptionId));
+    notificationFailure(subP, "Notification queue is full", notificationTime);
+    return -1;
+  }
+
+  LM_T(LmtNotificationSend, ("%s: notification queued", subP->subscriptionId));
+  return -3;
+}
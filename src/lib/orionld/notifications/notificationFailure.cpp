@@ -22,6 +22,7 @@
 *
 * Author: Ken Zangelin
 */
+#include <stdint.h>                                                 // uint32_t
 #include <string.h>                                                 // strncpy
 
 #include "logMsg/logMsg.h"                                          // LM_*
@@ -31,6 +32,7 @@
 #include "orionld/common/orionldState.h"                            // promNotifications, promNotificationsFailed
 #include "orionld/prometheus/promCounterIncrease.h"                 // promCounterIncrease
 #include "orionld/mongoc/mongocSubCountersUpdate.h"                 // mongocSubCountersUpdate
+#include "orionld/notifications/notificationCountersFlush.h"        // notificationCountersFlush
 #include "orionld/notifications/notificationFailure.h"              // Own interface
 
 
@@ -44,20 +46,26 @@ void notificationFailure(CachedSubscription* subP, const char* errorReason, doub
   LM_T(LmtNotificationStats, ("%s: notification failure (timestamp: %f)", subP->subscriptionId, notificationTime));
   bool forcedToPause = false;
 
-  subP->lastNotificationTime  = notificationTime;
-  subP->lastFailure           = notificationTime;
-  subP->consecutiveErrors    += 1;
-  subP->count                += 1;
-  subP->failures             += 1;
-  subP->dirty                += 1;
+  // No lock - see notificationSuccess
+  __atomic_store(&subP->lastNotificationTime, &notificationTime, __ATOMIC_RELAXED);
+  __atomic_store(&subP->lastFailure,          &notificationTime, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&subP->count,    1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&subP->failures, 1, __ATOMIC_RELAXED);
 
+  int      consecutiveErrors = __atomic_add_fetch(&subP->consecutiveErrors, 1, __ATOMIC_RELAXED);
+  uint32_t dirty             = __atomic_add_fetch(&subP->dirty, 1, __ATOMIC_RELAXED);
+
+  // The last error reason is informative only - a concurrent failure may overwrite it half-way
   strncpy(subP->lastErrorReason, errorReason, sizeof(subP->lastErrorReason) - 1);
 
+  //
   // Force the subscription into "paused" due to too many consecutive errors
-  if (subP->consecutiveErrors >= 3)
+  // Only the thread that reaches the limit does it (and flushes to DB)
+  //
+  if (consecutiveErrors == 3)
   {
     LM_T(LmtNotificationStats, ("%s: force the subscription into PAUSE due to 3 consecutive errors", subP->subscriptionId));
-    subP->isActive = false;
+    __atomic_store_n(&subP->isActive, false, __ATOMIC_RELEASE);  // Matching checks isActive before it looks at status
     subP->status   = "paused";
     forcedToPause  = true;
   }
@@ -65,7 +73,7 @@ void notificationFailure(CachedSubscription* subP, const char* errorReason, doub
   promCounterIncrease(promNotifications);
   promCounterIncrease(promNotificationsFailed);
 
-  LM_T(LmtNotificationStats, ("%s: dirty: %d, cSubCounters: %d", subP->subscriptionId, subP->dirty, cSubCounters));
+  LM_T(LmtNotificationStats, ("%s: dirty: %d, cSubCounters: %d", subP->subscriptionId, dirty, cSubCounters));
 
   //
   // Flush to DB?
@@ -73,24 +81,8 @@ void notificationFailure(CachedSubscription* subP, const char* errorReason, doub
   // - If subP->dirty (number of counter updates since last flush) >= cSubCounters
   //   - AND cSubCounters != 0
   //
-  if (((cSubCounters != 0) && (subP->dirty >= cSubCounters)) || (forcedToPause == true))
-  {
-    mongocSubCountersUpdate(subP->tenantP,
-                            subP->subscriptionId,
-                            (subP->ldContext != ""),
-                            subP->count,
-                            subP->failures,
-                            0,
-                            subP->lastNotificationTime,
-                            subP->lastSuccess,
-                            subP->lastFailure,
-                            forcedToPause);
-    subP->dirty       = 0;
-    subP->dbCount    += subP->count;
-    subP->count       = 0;
-    subP->dbFailures += subP->failures;
-    subP->failures    = 0;
-  }
+  if (((cSubCounters != 0) && (dirty >= (uint32_t) cSubCounters)) || (forcedToPause == true))
+    notificationCountersFlush(subP, forcedToPause);
 }
 
 
@@ -0,0 +1,145 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc
+#include <string.h>                                              // strlen, memcpy
+#include <sys/uio.h>                                             // iovec
+
+#include "cache/CachedSubscription.h"                            // CachedSubscription
+
+#include "orionld/types/Protocol.h"                              // Protocol
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+#include "orionld/notifications/notificationJobCreate.h"         // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// stringCopy - copy a string into the memory chunk of a NotificationJob and advance the "next free byte" pointer
+//
+static char* stringCopy(char** nextPP, const char* s)
+{
+  char* copy = *nextPP;
+
+  if (s == NULL)
+    return NULL;
+
+  int len = strlen(s) + 1;
+
+  memcpy(copy, s, len);
+  *nextPP += len;
+
+  return copy;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationJobBuild -
+//
+// The job, its iovec array and all strings are allocated in one single chunk.
+// Each iovec buffer is zero-terminated (not included in iov_len), as the traces and
+// the HTTPS headers treat them as strings.
+//
+NotificationJob* notificationJobBuild
+(
+  const char*     tenant,
+  const char*     subscriptionId,
+  const char*     protocolString,
+  Protocol        protocol,
+  const char*     ip,
+  unsigned short  port,
+  const char*     rest,
+  struct iovec*   ioVec,
+  int             ioVecLen,
+  double          notificationTime
+)
+{
+  size_t size = sizeof(NotificationJob) + ioVecLen * sizeof(struct iovec);
+
+  for (int ix = 0; ix < ioVecLen; ix++)
+  {
+    size += ioVec[ix].iov_len + 1;
+  }
+
+  size += (tenant         != NULL)? strlen(tenant)         + 1 : 0;
+  size += (protocolString != NULL)? strlen(protocolString) + 1 : 0;
+  size += (rest           != NULL)? strlen(rest)           + 1 : 0;
+  size += strlen(subscriptionId) + 1;
+  size += strlen(ip) + 1;
+
+  NotificationJob* jobP = (NotificationJob*) malloc(size);
+  if (jobP == NULL)
+    return NULL;
+
+  char* nextP = (char*) &jobP[1];
+
+  jobP->ioVec    = (struct iovec*) nextP;
+  jobP->ioVecLen = ioVecLen;
+  nextP         += ioVecLen * sizeof(struct iovec);
+
+  for (int ix = 0; ix < ioVecLen; ix++)
+  {
+    memcpy(nextP, ioVec[ix].iov_base, ioVec[ix].iov_len);
+    nextP[ioVec[ix].iov_len] = 0;
+
+    jobP->ioVec[ix].iov_base = nextP;
+    jobP->ioVec[ix].iov_len  = ioVec[ix].iov_len;
+
+    nextP += ioVec[ix].iov_len + 1;
+  }
+
+  jobP->tenant           = stringCopy(&nextP, tenant);
+  jobP->subscriptionId   = stringCopy(&nextP, subscriptionId);
+  jobP->protocolString   = stringCopy(&nextP, protocolString);
+  jobP->ip               = stringCopy(&nextP, ip);
+  jobP->rest             = stringCopy(&nextP, rest);
+  jobP->protocol         = protocol;
+  jobP->port             = port;
+  jobP->notificationTime = notificationTime;
+  jobP->size             = size;
+
+  return jobP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationJobCreate -
+//
+NotificationJob* notificationJobCreate(CachedSubscription* subP, struct iovec* ioVec, int ioVecLen, double notificationTime)
+{
+  return notificationJobBuild(subP->tenant,
+                              subP->subscriptionId,
+                              subP->protocolString,
+                              subP->protocol,
+                              subP->ip,
+                              subP->port,
+                              subP->rest,
+                              ioVec,
+                              ioVecLen,
+                              notificationTime);
+}
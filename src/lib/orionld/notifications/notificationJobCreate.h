@@ -0,0 +1,63 @@
+#ifndef SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONJOBCREATE_H_
+#define SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONJOBCREATE_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <sys/uio.h>                                             // iovec
+
+#include "cache/CachedSubscription.h"                            // CachedSubscription
+
+#include "orionld/types/Protocol.h"                              // Protocol
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationJobBuild - copy a rendered notification into a NotificationJob (one single malloc'd chunk)
+//
+extern NotificationJob* notificationJobBuild
+(
+  const char*     tenant,
+  const char*     subscriptionId,
+  const char*     protocolString,
+  Protocol        protocol,
+  const char*     ip,
+  unsigned short  port,
+  const char*     rest,
+  struct iovec*   ioVec,
+  int             ioVecLen,
+  double          notificationTime
+);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationJobCreate - copy a rendered notification for the subscription 'subP' into a NotificationJob
+//
+extern NotificationJob* notificationJobCreate(CachedSubscription* subP, struct iovec* ioVec, int ioVecLen, double notificationTime);
+
+#endif  // SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONJOBCREATE_H_
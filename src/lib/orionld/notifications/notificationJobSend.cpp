@@ -0,0 +1,316 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <errno.h>                                               // errno, EINTR
+#include <stdio.h>                                               // snprintf
+#include <string.h>                                              // strerror, memcpy
+#include <poll.h>                                                // poll
+#include <sys/uio.h>                                             // iovec
+#include <curl/curl.h>                                           // curl
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "cache/CachedSubscription.h"                            // CachedSubscription
+#include "cache/subCache.h"                                      // subCacheItemLookup
+#include "epoch/epoch.h"                                         // epochEnter, epochLeave
+
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+#include "orionld/types/NotificationConnection.h"                // NotificationConnection
+#include "orionld/common/orionldState.h"                         // orionldState, debugCurl, notifTimeout
+#include "orionld/notifications/httpConnectionPool.h"            // httpConnectionGet, httpConnectionSend, httpConnectionRelease
+#include "orionld/notifications/notificationResponseTreat.h"     // notificationResponseTreat
+#include "orionld/notifications/notificationSuccess.h"           // notificationSuccess
+#include "orionld/notifications/notificationFailure.h"           // notificationFailure
+#include "orionld/notifications/notificationJobSend.h"           // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// curlDebug - from orionld/common/orionldRequestSend.cpp
+//
+extern int curlDebug(CURL* handle, curl_infotype type, char* data, size_t size, void* userptr);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// responseAwait - wait for the notification endpoint to respond - same timeout as orionldAlterationsTreat uses (-notifTimeout)
+//
+static bool responseAwait(int fd, int timeoutInMilliseconds)
+{
+  struct pollfd pollFd = { fd, POLLIN, 0 };
+
+  while (1)
+  {
+    int fds = poll(&pollFd, 1, timeoutInMilliseconds);
+
+    if (fds == 1)
+      return true;
+    else if (fds == 0)
+      return false;
+    else if (errno != EINTR)
+    {
+      LM_E(("poll error: %s", strerror(errno)));
+      return false;
+    }
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationJobHttpSend -
+//
+// The connection comes from the keep-alive connection pool (-notifConnMax).
+// A connection that was idle in the pool may have been closed by the notification endpoint in the meantime.
+// If so, nothing at all comes back (the send fails or the connection is closed without a response), and the
+// notification is sent once more, over a new connection.
+//
+static bool notificationJobHttpSend(NotificationJob* jobP, char* errorString, int errorStringLen)
+{
+  const char*   subId     = jobP->subscriptionId;
+  struct iovec* ioVecCopy = (struct iovec*) kaAlloc(&orionldState.kalloc, jobP->ioVecLen * sizeof(struct iovec));
+
+  if (ioVecCopy == NULL)
+  {
+    snprintf(errorString, errorStringLen, "Out of memory");
+    return false;
+  }
+
+  if (lmTraceIsSet(LmtNotificationHeaders) == true)
+  {
+    for (int ix = 0; ix < jobP->ioVecLen - 1; ix++)
+    {
+      LM_T(LmtNotificationHeaders, ("%s: Notification Request Header: '%s'", subId, jobP->ioVec[ix].iov_base));
+    }
+  }
+
+  LM_T(LmtNotificationBody, ("%s: Notification Request Body: %s", subId, jobP->ioVec[jobP->ioVecLen - 1].iov_base));
+
+  bool ok = false;
+
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    LM_T(LmtNotificationSend, ("%s: Connecting to notification '%s:%d' receptor for HTTP notification", subId, jobP->ip, jobP->port));
+    NotificationConnection* connP = httpConnectionGet(jobP->ip, jobP->port, true);
+
+    if (connP == NULL)
+    {
+      LM_E(("Internal Error (unable to connect to server for notification for subscription '%s': %s)", subId, strerror(errno)));
+      snprintf(errorString, errorStringLen, "Unable to connect to notification endpoint");
+      return false;
+    }
+
+    bool timeout = false;
+
+    memcpy(ioVecCopy, jobP->ioVec, jobP->ioVecLen * sizeof(struct iovec));
+
+    if (httpConnectionSend(connP, ioVecCopy, jobP->ioVecLen) == false)
+    {
+      LM_E(("Internal Error (unable to send to server for notification for subscription '%s' (fd: %d): %s", subId, connP->fd, strerror(errno)));
+      snprintf(errorString, errorStringLen, "Unable to write to notification endpoint");
+      ok = false;
+    }
+    else if (responseAwait(connP->fd, notifTimeout) == false)
+    {
+      snprintf(errorString, errorStringLen, "Timeout awaiting response from notification endpoint");
+      connP->keepAlive = false;
+      timeout          = true;
+      ok               = false;
+    }
+    else
+      ok = notificationResponseTreat(connP, subId, errorString, errorStringLen);
+
+    bool retry = (ok == false) && (timeout == false) && (connP->reused == true) && (connP->gotResponse == false);
+
+    httpConnectionRelease(connP);
+
+    if (retry == false)
+      break;
+
+    LM_T(LmtNotificationSend, ("%s: reused connection to %s:%d was stale (%s) - retrying over a new connection", subId, jobP->ip, jobP->port, errorString));
+  }
+
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationResponseDiscard - the response body of an HTTPS notification is not used
+//
+static size_t notificationResponseDiscard(void* chunk, size_t size, size_t members, void* userP)
+{
+  LM_T(LmtNotificationBody, ("%s: Got a chunk of notification response (%d bytes): %s", (char*) userP, (int) (size * members), (char*) chunk));
+  return size * members;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationJobHttpsSend -
+//
+// The worker has nothing else to do while awaiting the response, so, curl_easy_perform is used
+// instead of the multi handle that the request thread uses
+//
+static bool notificationJobHttpsSend(NotificationJob* jobP, char* errorString, int errorStringLen)
+{
+  char        url[512];
+  const char* subId = jobP->subscriptionId;
+  char*       rest  = jobP->rest;
+
+  if      (rest    == NULL)  rest = (char*) "";
+  else if (rest[0] == '/')   rest = &rest[1];
+
+  if (jobP->port > 0)
+    snprintf(url, sizeof(url), "%s://%s:%d/%s", jobP->protocolString, jobP->ip, jobP->port, rest);
+  else
+    snprintf(url, sizeof(url), "%s://%s/%s", jobP->protocolString, jobP->ip, rest);
+
+  CURL* curlHandleP = curl_easy_init();
+  if (curlHandleP == NULL)
+  {
+    LM_E(("%s: Internal Error: curl_easy_init failed", subId));
+    snprintf(errorString, errorStringLen, "Internal Error: curl_easy_init failed");
+    return false;
+  }
+
+  LM_T(LmtNotificationSend, ("%s: URL: %s", subId, url));
+  curl_easy_setopt(curlHandleP, CURLOPT_URL, url);
+  curl_easy_setopt(curlHandleP, CURLOPT_CUSTOMREQUEST, "POST");
+  curl_easy_setopt(curlHandleP, CURLOPT_TIMEOUT_MS, (long) notifTimeout);      // Timeout - -notifTimeout, as in httpsNotify
+  curl_easy_setopt(curlHandleP, CURLOPT_FOLLOWLOCATION, 1L);                   // Follow redirections
+  curl_easy_setopt(curlHandleP, CURLOPT_NOSIGNAL, 1L);                         // Multi-threaded - no signals
+  curl_easy_setopt(curlHandleP, CURLOPT_SSL_VERIFYPEER, 0L);                   // ignore self-signed certificates for SSL end-points
+  curl_easy_setopt(curlHandleP, CURLOPT_SSL_VERIFYHOST, 0L);                   // DO NOT verify the certificate's name against host
+
+  //
+  // HTTP Headers - skipping the Start-Line, the empty line and the body
+  // The headers must not be CRLF-terminated
+  //
+  struct curl_slist* headers = NULL;
+  for (int ix = 1; ix < jobP->ioVecLen - 2; ix++)
+  {
+    char* headerP = (char*) jobP->ioVec[ix].iov_base;
+    int   len     = jobP->ioVec[ix].iov_len;
+
+    if ((len >= 2) && (headerP[len - 2] == '\r'))
+      headerP[len - 2] = 0;
+
+    LM_T(LmtNotificationHeaders, ("%s: Notification Request Header: '%s'", subId, headerP));
+    headers = curl_slist_append(headers, headerP);
+  }
+  curl_easy_setopt(curlHandleP, CURLOPT_HTTPHEADER, headers);
+
+  struct iovec* bodyP = &jobP->ioVec[jobP->ioVecLen - 1];
+  LM_T(LmtNotificationBody, ("%s: Notification Request Body: %s", subId, bodyP->iov_base));
+  curl_easy_setopt(curlHandleP, CURLOPT_POSTFIELDS,    bodyP->iov_base);
+  curl_easy_setopt(curlHandleP, CURLOPT_POSTFIELDSIZE, (long) bodyP->iov_len);
+  curl_easy_setopt(curlHandleP, CURLOPT_WRITEFUNCTION, notificationResponseDiscard);
+  curl_easy_setopt(curlHandleP, CURLOPT_WRITEDATA,     subId);
+
+  if (debugCurl == true)
+  {
+    curl_easy_setopt(curlHandleP, CURLOPT_VERBOSE,       1L);
+    curl_easy_setopt(curlHandleP, CURLOPT_DEBUGFUNCTION, curlDebug);
+  }
+
+  bool      ok = true;
+  CURLcode  cc = curl_easy_perform(curlHandleP);
+
+  if (cc != CURLE_OK)
+  {
+    snprintf(errorString, errorStringLen, "CURL Error %d: %s", cc, curl_easy_strerror(cc));
+    ok = false;
+  }
+  else
+  {
+    long httpResponseCode = 500;
+
+    curl_easy_getinfo(curlHandleP, CURLINFO_RESPONSE_CODE, &httpResponseCode);
+    LM_T(LmtNotificationSend, ("%s: Notification Response HTTP Status: %d", subId, (int) httpResponseCode));
+
+    if ((httpResponseCode < 200) || (httpResponseCode >= 300))
+    {
+      snprintf(errorString, errorStringLen, "Got an HTTP Status %d", (int) httpResponseCode);
+      ok = false;
+    }
+  }
+
+  curl_slist_free_all(headers);
+  curl_easy_cleanup(curlHandleP);
+
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationJobAccount - update the counters of the subscription
+//
+// The subscription is looked up again, as the sub-cache may have been refreshed after the job was queued.
+// The counters are updated atomically, so, no lock is needed - only a sub-cache read section, so that the
+// subscription isn't freed under our feet.
+//
+void notificationJobAccount(NotificationJob* jobP, bool ok, const char* errorString)
+{
+  epochEnter();
+
+  CachedSubscription* subP = subCacheItemLookup(jobP->tenant, jobP->subscriptionId);
+
+  if (subP == NULL)
+    LM_W(("%s: subscription not in sub-cache - notification counters lost", jobP->subscriptionId));
+  else if (ok == true)
+    notificationSuccess(subP, jobP->notificationTime);
+  else
+    notificationFailure(subP, errorString, jobP->notificationTime);
+
+  epochLeave();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationJobSend -
+//
+bool notificationJobSend(NotificationJob* jobP, char* errorString, int errorStringLen)
+{
+  if (jobP->protocol == HTTPS)
+    return notificationJobHttpsSend(jobP, errorString, errorStringLen);
+
+  return notificationJobHttpSend(jobP, errorString, errorStringLen);
+}
@@ -0,0 +1,263 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <errno.h>                                               // errno, EINTR
+#include <string.h>                                              // strerror
+#include <stdlib.h>                                              // free
+#include <stdint.h>                                              // uint64_t, int64_t
+#include <semaphore.h>                                           // sem_t, sem_init, sem_wait, sem_post
+#include <atomic>                                                // std::atomic
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+#include "orionld/common/orionldState.h"                         // promNotificationsQueued, ...
+#include "orionld/prometheus/promCounterIncrease.h"              // promCounterIncrease
+#include "orionld/prometheus/promGaugeAdd.h"                     // promGaugeAdd
+#include "orionld/notifications/notificationQueue.h"             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// QueueCell -
+//
+// The queue is a bounded multi-producer/multi-consumer ring buffer (D. Vyukov's algorithm).
+// Each cell carries a sequence number that tells producers and consumers whether the cell is
+// free to be written to or ready to be read from, so, no locks are needed, only one CAS on
+// enqueuePos (producers) or dequeuePos (consumers).
+//
+// The semaphore is used only to put idle workers to sleep, not to protect the ring buffer.
+//
+typedef struct QueueCell
+{
+  std::atomic<uint64_t>  sequence;
+  NotificationJob*       jobP;
+} QueueCell;
+
+
+
+static QueueCell*             cellV    = NULL;
+static uint64_t               cellMask = 0;
+static std::atomic<uint64_t>  enqueuePos(0);
+static std::atomic<uint64_t>  dequeuePos(0);
+static std::atomic<uint64_t>  queueIn(0);
+static std::atomic<uint64_t>  queueOut(0);
+static std::atomic<uint64_t>  queueDrops(0);
+static sem_t                  queueSem;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueInit -
+//
+bool notificationQueueInit(int size)
+{
+  uint64_t cells = 2;
+
+  while (cells < (uint64_t) size)
+  {
+    cells <<= 1;
+  }
+
+  cellV = new QueueCell[cells];
+
+  for (uint64_t ix = 0; ix < cells; ix++)
+  {
+    cellV[ix].sequence.store(ix, std::memory_order_relaxed);
+    cellV[ix].jobP = NULL;
+  }
+
+  cellMask = cells - 1;
+  enqueuePos.store(0, std::memory_order_relaxed);
+  dequeuePos.store(0, std::memory_order_relaxed);
+
+  if (sem_init(&queueSem, 0, 0) == -1)
+  {
+    LM_E(("sem_init: %s", strerror(errno)));
+    return false;
+  }
+
+  LM_T(LmtNotificationSend, ("Notification queue of %d cells is ready", (int) cells));
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueuePush -
+//
+bool notificationQueuePush(NotificationJob* jobP)
+{
+  QueueCell*  cellP;
+  uint64_t    pos = enqueuePos.load(std::memory_order_relaxed);
+
+  while (1)
+  {
+    cellP = &cellV[pos & cellMask];
+
+    uint64_t  sequence = cellP->sequence.load(std::memory_order_acquire);
+    int64_t   diff     = (int64_t) sequence - (int64_t) pos;
+
+    if (diff == 0)
+    {
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      // Queue is full
+      queueDrops.fetch_add(1, std::memory_order_relaxed);
+      promCounterIncrease(promNotificationsDropped);
+      return false;
+    }
+    else
+      pos = enqueuePos.load(std::memory_order_relaxed);
+  }
+
+  cellP->jobP = jobP;
+  cellP->sequence.store(pos + 1, std::memory_order_release);
+
+  queueIn.fetch_add(1, std::memory_order_relaxed);
+  promCounterIncrease(promNotificationsQueued);
+  promGaugeAdd(promNotificationQueueDepth, 1, NULL);
+
+  sem_post(&queueSem);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueuePop -
+//
+NotificationJob* notificationQueuePop(void)
+{
+  QueueCell*  cellP;
+  uint64_t    pos = dequeuePos.load(std::memory_order_relaxed);
+
+  while (1)
+  {
+    cellP = &cellV[pos & cellMask];
+
+    uint64_t  sequence = cellP->sequence.load(std::memory_order_acquire);
+    int64_t   diff     = (int64_t) sequence - (int64_t) (pos + 1);
+
+    if (diff == 0)
+    {
+      if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+      return NULL;  // Queue is empty
+    else
+      pos = dequeuePos.load(std::memory_order_relaxed);
+  }
+
+  NotificationJob* jobP = cellP->jobP;
+
+  cellP->jobP = NULL;
+  cellP->sequence.store(pos + cellMask + 1, std::memory_order_release);
+
+  queueOut.fetch_add(1, std::memory_order_relaxed);
+  promGaugeAdd(promNotificationQueueDepth, -1, NULL);
+
+  return jobP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueWait -
+//
+void notificationQueueWait(void)
+{
+  while (sem_wait(&queueSem) == -1)
+  {
+    if (errno != EINTR)
+    {
+      LM_E(("sem_wait: %s", strerror(errno)));
+      break;
+    }
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueWakeup -
+//
+void notificationQueueWakeup(void)
+{
+  sem_post(&queueSem);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueStatsGet -
+//
+void notificationQueueStatsGet(NotificationQueueStats* statsP)
+{
+  statsP->in    = queueIn.load(std::memory_order_relaxed);
+  statsP->out   = queueOut.load(std::memory_order_relaxed);
+  statsP->drops = queueDrops.load(std::memory_order_relaxed);
+  statsP->depth = (int) (statsP->in - statsP->out);
+  statsP->size  = (cellV != NULL)? (int) (cellMask + 1) : 0;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueRelease -
+//
+// To be called when all notification workers have been stopped.
+// Jobs still in the queue are freed and never sent.
+//
+void notificationQueueRelease(void)
+{
+  NotificationJob* jobP;
+
+  if (cellV == NULL)
+    return;
+
+  while ((jobP = notificationQueuePop()) != NULL)
+  {
+    LM_W(("%s: notification lost at shutdown", jobP->subscriptionId));
+    free(jobP);
+  }
+
+  delete[] cellV;
+  cellV = NULL;
+
+  sem_destroy(&queueSem);
+}
@@ -0,0 +1,103 @@
+#ifndef SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONQUEUE_H_
+#define SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONQUEUE_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t
+
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+
+
+
+// -----------------------------------------------------------------------------
+//
+// NotificationQueueStats -
+//
+typedef struct NotificationQueueStats
+{
+  uint64_t  in;       // Jobs successfully enqueued
+  uint64_t  out;      // Jobs taken by a notification worker
+  uint64_t  drops;    // Jobs rejected as the queue was full (overflow)
+  int       depth;    // Jobs currently in the queue
+  int       size;     // Capacity of the queue
+} NotificationQueueStats;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueInit - allocate the ring buffer, 'size' is rounded up to the next power of two
+//
+extern bool notificationQueueInit(int size);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueuePush - enqueue a job, without blocking - false if the queue is full
+//
+extern bool notificationQueuePush(NotificationJob* jobP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueuePop - dequeue a job, without blocking - NULL if the queue is empty
+//
+extern NotificationJob* notificationQueuePop(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueWait - block until there is (probably) something in the queue
+//
+extern void notificationQueueWait(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueWakeup - wake up one thread blocked in notificationQueueWait
+//
+extern void notificationQueueWakeup(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueStatsGet -
+//
+extern void notificationQueueStatsGet(NotificationQueueStats* statsP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationQueueRelease -
+//
+extern void notificationQueueRelease(void);
+
+#endif  // SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONQUEUE_H_
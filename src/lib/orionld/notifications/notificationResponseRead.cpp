@@ -0,0 +1,509 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <errno.h>                                               // errno
+#include <stdio.h>                                               // snprintf
+#include <stdlib.h>                                              // atoi, strtol, malloc, free
+#include <string.h>                                              // strchr, strncasecmp, strerror, memcpy, memmove
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/NotificationConnection.h"                        // NotificationConnection
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/readWithTimeout.h"                      // readWithTimeout
+#include "orionld/notifications/notificationResponseRead.h"      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ResponseBuffer - the buffer the response is read into, it starts as the buffer of the caller and grows (kaAlloc) if needed
+//
+// All positions inside the buffer are kept as offsets, as the buffer may be reallocated
+//
+typedef struct ResponseBuffer
+{
+  char*  data;
+  int    size;
+  int    len;
+} ResponseBuffer;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// responseBufferRead - read more bytes from the connection, into the response buffer
+//
+// Returns the number of bytes read. 0 means EOF or timeout, -1 means error
+//
+static int responseBufferRead(NotificationConnection* connP, ResponseBuffer* rbP, int needed, char* errorString, int errorStringLen)
+{
+  // Room for at least 'needed' bytes plus the zero-termination
+  if (rbP->len + needed + 1 > rbP->size)
+  {
+    int   newSize = rbP->size * 2;
+
+    if (newSize < rbP->len + needed + 1)
+      newSize = rbP->len + needed + 1;
+
+    char* newData = kaAlloc(&orionldState.kalloc, newSize);
+    if (newData == NULL)
+    {
+      LM_E(("Unable to allocate %d bytes for notification response", newSize));
+      snprintf(errorString, errorStringLen, "Unable to allocate buffer for notification response");
+      return -1;
+    }
+
+    memcpy(newData, rbP->data, rbP->len);
+    rbP->data = newData;
+    rbP->size = newSize;
+  }
+
+  int nb = readWithTimeout(connP->fd, &rbP->data[rbP->len], rbP->size - rbP->len - 1, 0, 100000);  // 100 millisecond timeout
+
+  if (nb == -1)
+  {
+    snprintf(errorString, errorStringLen, "error reading notification response: %s", strerror(errno));
+    return -1;
+  }
+
+  if (nb > 0)
+  {
+    connP->gotResponse  = true;
+    rbP->len           += nb;
+  }
+
+  return nb;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// lineEndFind - offset of the next '\n', starting at 'from', -1 if not found
+//
+static int lineEndFind(ResponseBuffer* rbP, int from)
+{
+  for (int ix = from; ix < rbP->len; ix++)
+  {
+    if (rbP->data[ix] == '\n')
+      return ix;
+  }
+
+  return -1;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// headersEndFind - find the empty line that ends the HTTP headers
+//
+// Returns the offset of the first byte of the body and the offset of the end of the headers in *headersEndP
+//
+static int headersEndFind(ResponseBuffer* rbP, int* headersEndP)
+{
+  int lineStart = 0;
+  int eol;
+
+  while ((eol = lineEndFind(rbP, lineStart)) != -1)
+  {
+    int lineLen = eol - lineStart;
+
+    if ((lineStart != 0) && ((lineLen == 0) || ((lineLen == 1) && (rbP->data[lineStart] == '\r'))))
+    {
+      *headersEndP = (lineStart >= 2 && rbP->data[lineStart - 2] == '\r')? lineStart - 2 : lineStart - 1;
+      return eol + 1;
+    }
+
+    lineStart = eol + 1;
+  }
+
+  return -1;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// headerValue - if the header line 'line' is 'name', return a pointer to its value
+//
+static char* headerValue(char* line, const char* name, int nameLen)
+{
+  if (strncasecmp(line, name, nameLen) != 0)
+    return NULL;
+
+  if (line[nameLen] != ':')
+    return NULL;
+
+  char* valueP = &line[nameLen + 1];
+  while ((*valueP == ' ') || (*valueP == '\t'))
+    ++valueP;
+
+  return valueP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// chunkedBodyDecode - decode a "Transfer-Encoding: chunked" body, in place
+//
+// The decoded body starts at 'bodyStart' and its length is returned.
+// The offset of the first byte after the entire message is returned in *messageEndP.
+//
+static int chunkedBodyDecode
+(
+  NotificationConnection*  connP,
+  ResponseBuffer*          rbP,
+  int                      bodyStart,
+  int*                     messageEndP,
+  char*                    errorString,
+  int                      errorStringLen
+)
+{
+  int inIx  = bodyStart;  // Next chunk-size line
+  int outIx = bodyStart;  // End of the decoded body
+
+  while (1)
+  {
+    int eol;
+
+    while ((eol = lineEndFind(rbP, inIx)) == -1)
+    {
+      if (responseBufferRead(connP, rbP, 512, errorString, errorStringLen) <= 0)
+      {
+        if (errorString[0] == 0)
+          snprintf(errorString, errorStringLen, "incomplete chunked notification response");
+        return -1;
+      }
+    }
+
+    char* endP;
+    long  chunkSize = strtol(&rbP->data[inIx], &endP, 16);  // chunk-extensions (";...") are ignored
+
+    if ((endP == &rbP->data[inIx]) || (chunkSize < 0))
+    {
+      snprintf(errorString, errorStringLen, "invalid chunk size in notification response");
+      return -1;
+    }
+
+    int chunkStart = eol + 1;
+
+    if (chunkSize == 0)
+    {
+      //
+      // Last chunk - step over the trailer headers, until the empty line
+      //
+      int lineStart = chunkStart;
+
+      while (1)
+      {
+        while ((eol = lineEndFind(rbP, lineStart)) == -1)
+        {
+          if (responseBufferRead(connP, rbP, 512, errorString, errorStringLen) <= 0)
+          {
+            if (errorString[0] == 0)
+              snprintf(errorString, errorStringLen, "incomplete chunked notification response");
+            return -1;
+          }
+        }
+
+        int lineLen = eol - lineStart;
+
+        lineStart = eol + 1;
+        if ((lineLen == 0) || ((lineLen == 1) && (rbP->data[eol - 1] == '\r')))
+          break;
+      }
+
+      *messageEndP = lineStart;
+      return outIx - bodyStart;
+    }
+
+    // The chunk data is followed by CRLF
+    while (rbP->len < chunkStart + chunkSize + 2)
+    {
+      int needed = chunkStart + chunkSize + 2 - rbP->len;
+
+      if (responseBufferRead(connP, rbP, needed, errorString, errorStringLen) <= 0)
+      {
+        if (errorString[0] == 0)
+          snprintf(errorString, errorStringLen, "incomplete chunked notification response");
+        return -1;
+      }
+    }
+
+    memmove(&rbP->data[outIx], &rbP->data[chunkStart], chunkSize);
+    outIx += chunkSize;
+    inIx   = chunkStart + chunkSize;
+
+    // Step over the CRLF (or a lonely LF)
+    if (rbP->data[inIx] == '\r')
+      ++inIx;
+    if (rbP->data[inIx] == '\n')
+      ++inIx;
+  }
+
+  return -1;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationResponseRead -
+//
+// Reads one entire HTTP response from the connection. The body is delimited by (in order of precedence):
+// - the status code (1xx, 204 and 304 have no body)
+// - Transfer-Encoding: chunked
+// - Content-Length
+// - the peer closing the connection
+//
+// Any bytes read beyond the end of the response (pipelined responses) are saved in connP->pending and will be
+// the beginning of the next response read from the connection.
+// connP->keepAlive is set to true only if the entire response was read and the connection can be reused.
+//
+// If false is returned, the reason is found in errorString
+//
+bool notificationResponseRead
+(
+  NotificationConnection*  connP,
+  const char*              subscriptionId,
+  char*                    buf,
+  int                      bufLen,
+  int*                     httpStatusCodeP,
+  int*                     contentLengthP,
+  char**                   headersP,
+  char**                   bodyP,
+  char*                    errorString,
+  int                      errorStringLen
+)
+{
+  ResponseBuffer  rb          = { buf, bufLen, 0 };
+  int             bodyStart   = -1;
+  int             headersEnd  = -1;
+  int             contentLen  = -1;
+  int             messageEnd  = -1;
+  int             httpStatus  = -1;
+  bool            chunked     = false;
+  bool            keepAlive   = true;
+
+  errorString[0]   = 0;
+  connP->keepAlive = false;
+
+  //
+  // Bytes left over from the previous response on the same connection come first
+  //
+  if (connP->pending != NULL)
+  {
+    if (connP->pendingLen >= rb.size)
+    {
+      rb.size = connP->pendingLen + 1024;
+      rb.data = kaAlloc(&orionldState.kalloc, rb.size);
+
+      if (rb.data == NULL)
+      {
+        snprintf(errorString, errorStringLen, "Unable to allocate buffer for notification response");
+        return false;
+      }
+    }
+
+    memcpy(rb.data, connP->pending, connP->pendingLen);
+    rb.len = connP->pendingLen;
+
+    free(connP->pending);
+    connP->pending    = NULL;
+    connP->pendingLen = 0;
+  }
+
+  //
+  // Read until the end of the HTTP headers
+  //
+  while ((bodyStart = headersEndFind(&rb, &headersEnd)) == -1)
+  {
+    int nb = responseBufferRead(connP, &rb, 1024, errorString, errorStringLen);
+
+    if (nb == -1)
+    {
+      LM_E(("%s: %s", subscriptionId, errorString));
+      return false;
+    }
+    else if (nb == 0)
+    {
+      if (rb.len == 0)
+      {
+        snprintf(errorString, errorStringLen, "Unable to read from notification endpoint");
+        LM_E(("Internal Error (%s: unable to read response for notification on fd %d)", subscriptionId, connP->fd));
+      }
+      else
+      {
+        LM_W(("%s: Can't find the Headers/Body delimiter", subscriptionId));
+        snprintf(errorString, errorStringLen, "Can't find the Headers/Body delimiter");
+      }
+
+      return false;
+    }
+  }
+
+  //
+  // The Start-Line: HTTP-Version SP Status-Code SP Reason-Phrase
+  //
+  int startLineEnd = lineEndFind(&rb, 0);
+  int headersStart = startLineEnd + 1;
+
+  if ((startLineEnd > 0) && (rb.data[startLineEnd - 1] == '\r'))
+    --startLineEnd;
+  rb.data[startLineEnd] = 0;
+
+  if (strncmp(rb.data, "HTTP/1.0", 8) == 0)
+    keepAlive = false;
+
+  char* space = strchr(rb.data, ' ');
+  if (space != NULL)
+    httpStatus = atoi(&space[1]);
+
+  LM_T(LmtNotificationMsg, ("%s: notification response Start-Line:   '%s'", subscriptionId, rb.data));
+
+  //
+  // The HTTP headers that affect the framing of the body and the reuse of the connection
+  //
+  int lineStart = headersStart;
+  while (lineStart < headersEnd)
+  {
+    int   eol   = lineEndFind(&rb, lineStart);
+    char* line  = &rb.data[lineStart];
+    char* value;
+
+    if ((value = headerValue(line, "Content-Length", 14)) != NULL)
+      contentLen = atoi(value);
+    else if ((value = headerValue(line, "Transfer-Encoding", 17)) != NULL)
+      chunked = (strncasecmp(value, "chunked", 7) == 0);
+    else if ((value = headerValue(line, "Connection", 10)) != NULL)
+    {
+      if (strncasecmp(value, "close", 5) == 0)
+        keepAlive = false;
+      else if (strncasecmp(value, "keep-alive", 10) == 0)
+        keepAlive = true;
+    }
+
+    lineStart = eol + 1;
+  }
+
+  if (headersStart > headersEnd)  // No headers at all
+    headersStart = headersEnd;
+
+  rb.data[headersEnd] = 0;
+  LM_T(LmtNotificationMsg, ("%s: notification response HTTP Headers: '%s'", subscriptionId, &rb.data[headersStart]));
+
+  //
+  // The body
+  //
+  if (((httpStatus >= 100) && (httpStatus < 200)) || (httpStatus == 204) || (httpStatus == 304))
+  {
+    contentLen = 0;
+    messageEnd = bodyStart;
+  }
+  else if (chunked == true)
+  {
+    contentLen = chunkedBodyDecode(connP, &rb, bodyStart, &messageEnd, errorString, errorStringLen);
+
+    if (contentLen == -1)
+    {
+      LM_W(("%s: %s", subscriptionId, errorString));
+      return false;
+    }
+  }
+  else if (contentLen >= 0)
+  {
+    while (rb.len < bodyStart + contentLen)
+    {
+      int nb = responseBufferRead(connP, &rb, bodyStart + contentLen - rb.len, errorString, errorStringLen);
+
+      if (nb <= 0)
+      {
+        if (nb == 0)
+          snprintf(errorString, errorStringLen, "timeout while reading notification response");
+
+        LM_W(("%s: %s (%d of %d bytes of body read)", subscriptionId, errorString, rb.len - bodyStart, contentLen));
+        return false;
+      }
+    }
+
+    messageEnd = bodyStart + contentLen;
+  }
+  else
+  {
+    //
+    // No Content-Length and not chunked - the body ends when the peer closes the connection
+    //
+    int nb;
+
+    while ((nb = responseBufferRead(connP, &rb, 1024, errorString, errorStringLen)) > 0)
+      ;
+
+    if (nb == -1)
+    {
+      LM_W(("%s: %s", subscriptionId, errorString));
+      return false;
+    }
+
+    contentLen = rb.len - bodyStart;
+    messageEnd = rb.len;
+    keepAlive  = false;
+  }
+
+  //
+  // Save whatever was read beyond the end of this response - it belongs to the next response
+  //
+  if (rb.len > messageEnd)
+  {
+    connP->pendingLen = rb.len - messageEnd;
+    connP->pending    = (char*) malloc(connP->pendingLen);
+
+    if (connP->pending == NULL)
+    {
+      connP->pendingLen = 0;
+      keepAlive         = false;
+    }
+    else
+      memcpy(connP->pending, &rb.data[messageEnd], connP->pendingLen);
+  }
+
+  rb.data[bodyStart + contentLen] = 0;
+  LM_T(LmtNotificationMsg, ("%s: entire message read (Content-Length: %d)", subscriptionId, contentLen));
+
+  connP->keepAlive = keepAlive;
+
+  *headersP        = &rb.data[headersStart];
+  *bodyP           = &rb.data[bodyStart];
+  *httpStatusCodeP = httpStatus;
+  *contentLengthP  = contentLen;
+
+  return true;
+}
@@ -0,0 +1,87 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // snprintf
+#include <string.h>                                              // strstr, bzero
+
+#include "logMsg/logMsg.h"                                       // LM_*, lmTraceIsSet
+
+#include "orionld/types/NotificationConnection.h"                        // NotificationConnection
+#include "orionld/notifications/notificationResponseRead.h"      // notificationResponseRead
+#include "orionld/notifications/notificationResponseTreat.h"     // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationResponseTreat -
+//
+bool notificationResponseTreat(NotificationConnection* connP, const char* subscriptionId, char* errorString, int errorStringLen)
+{
+  char        buf[2048];  // should be enough for the HTTP headers ...
+  int         contentLength  = -1;
+  int         httpStatusCode = -1;
+  char*       body           = NULL;
+  char*       headers        = NULL;
+  const char* subId          = subscriptionId;
+
+  bzero(buf, sizeof(buf));
+
+  if (notificationResponseRead(connP, subId, buf, sizeof(buf), &httpStatusCode, &contentLength, &headers, &body, errorString, errorStringLen) == false)
+    return false;
+
+  if (lmTraceIsSet(LmtNotificationHeaders) == true)
+  {
+    char* headerP = headers;
+    char* eol;
+    while ((eol = strstr(headerP, "\n")) != NULL)
+    {
+      *eol = 0;
+      LM_T(LmtNotificationHeaders, ("%s: Notification Response HTTP Header: '%s'", subId, headerP));
+      headerP = &eol[1];
+    }
+
+    LM_T(LmtNotificationHeaders, ("%s: Notification Response HTTP Header: '%s'", subId, headerP));
+  }
+
+  LM_T(LmtNotificationBody, ("%s: Notification Response Body: '%s'", subId, body));
+
+  //
+  // Any 2xx response is considered OK
+  //
+  if (httpStatusCode == -1)
+  {
+    snprintf(errorString, errorStringLen, "HTTP Start-Line of notification response not found");
+    LM_E(("Internal Error (%s:  HTTP Start-Line of notification response not found)", subId));
+    return false;
+  }
+  else if ((httpStatusCode < 200) || (httpStatusCode >= 300))
+  {
+    snprintf(errorString, errorStringLen, "non 2xx response to notification");
+    LM_E(("Internal Error (%s: non 2xx response (%d) to notification on fd %d)", subId, httpStatusCode, connP->fd));
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,536 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t
+#include <errno.h>                                               // errno
+#include <stdlib.h>                                              // free
+#include <string.h>                                              // strerror
+#include <stdio.h>                                               // snprintf
+#include <sys/epoll.h>                                           // epoll_create1, epoll_ctl, epoll_wait
+#include <curl/curl.h>                                           // curl_multi_socket_action, ...
+#include <MQTTClient.h>                                          // MQTTClient_waitForCompletion
+
+extern "C"
+{
+#include "kbase/kTime.h"                                         // kTimeGet
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "cache/CachedSubscription.h"                            // CachedSubscription
+#include "cache/subCache.h"                                      // subCacheItemLookup
+#include "epoch/epoch.h"                                         // epochEnter, epochLeave
+
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/types/NotificationPending.h"                   // NotificationPending
+#include "orionld/notifications/notificationSuccess.h"           // notificationSuccess
+#include "orionld/notifications/notificationFailure.h"           // notificationFailure
+#include "orionld/notifications/notificationResponseTreat.h"     // notificationResponseTreat
+#include "orionld/notifications/httpConnectionPool.h"            // httpConnectionRelease
+#include "orionld/notifications/notificationRetry.h"             // notificationRetryEnqueue
+#include "orionld/notifications/notificationResponsesAwait.h"    // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// CURL_SOCKET_TAG - marks the epoll events of libcurl's sockets
+//
+// The epoll data of an HTTP notification is the pointer to its NotificationPending, while the epoll data of
+// a socket of libcurl is the socket itself, with the highest bit set (never set in a user space pointer).
+//
+#define CURL_SOCKET_TAG  (1ULL << 63)
+
+
+
+// -----------------------------------------------------------------------------
+//
+// EPOLL_EVENTS_MAX -
+//
+#define EPOLL_EVENTS_MAX  64
+
+
+
+// -----------------------------------------------------------------------------
+//
+// epollFd - one epoll instance per thread, created the first time it is needed
+//
+static __thread int epollFd = -1;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timeNow -
+//
+static double timeNow(void)
+{
+  struct timespec now;
+
+  kTimeGet(&now);
+  return now.tv_sec + ((double) now.tv_nsec) / 1000000000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationAccount - update the counters of the subscription of a notification
+//
+// The responses are awaited outside the sub-cache read section, so the subscription is looked up again,
+// in a short read section of its own - it may have been removed or replaced meanwhile.
+//
+static void notificationAccount(NotificationPending* npP, bool ok, const char* errorString, double notificationTime)
+{
+  epochEnter();
+
+  CachedSubscription* subP = subCacheItemLookup(npP->tenant, npP->subscriptionId);
+
+  if (subP == NULL)
+    LM_W(("%s: subscription not in sub-cache - notification counters lost", npP->subscriptionId));
+  else if (ok == true)
+    notificationSuccess(subP, notificationTime);
+  else
+    notificationFailure(subP, errorString, notificationTime);
+
+  epochLeave();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// curlSocketCallback - libcurl tells what sockets to watch (CURLMOPT_SOCKETFUNCTION)
+//
+static int curlSocketCallback(CURL* easyP, curl_socket_t fd, int what, void* userP, void* socketP)
+{
+  if (what == CURL_POLL_REMOVE)
+  {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    return 0;
+  }
+
+  struct epoll_event event;
+
+  event.events   = ((what & CURL_POLL_IN)? EPOLLIN : 0) | ((what & CURL_POLL_OUT)? EPOLLOUT : 0);
+  event.data.u64 = CURL_SOCKET_TAG | (uint64_t) fd;
+
+  //
+  // A socket that libcurl already watches is modified, not added.
+  // EEXIST is also what a socket that has been reused by libcurl gives
+  //
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1)
+  {
+    if ((errno != EEXIST) || (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == -1))
+      LM_E(("Internal Error (epoll_ctl for a curl socket (fd %d): %s)", fd, strerror(errno)));
+  }
+
+  return 0;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// curlTimerCallback - libcurl wants to be called (CURL_SOCKET_TIMEOUT) in 'timeoutMs' milliseconds (CURLMOPT_TIMERFUNCTION)
+//
+// -1 means "no timer"
+//
+static int curlTimerCallback(CURLM* multiP, long timeoutMs, void* userP)
+{
+  double* curlTimerP = (double*) userP;
+
+  *curlTimerP = (timeoutMs < 0)? -1 : timeNow() + ((double) timeoutMs) / 1000;
+
+  return 0;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// curlTransfersDone - take care of the HTTPS notifications whose transfers have finished
+//
+static void curlTransfersDone(CURLM* multiP, double notificationTime)
+{
+  CURLMsg* msgP;
+  int      msgsLeft;
+
+  while ((msgP = curl_multi_info_read(multiP, &msgsLeft)) != NULL)
+  {
+    if (msgP->msg != CURLMSG_DONE)
+      continue;
+
+    char* privateP = NULL;
+    curl_easy_getinfo(msgP->easy_handle, CURLINFO_PRIVATE, &privateP);
+
+    NotificationPending* npP = (NotificationPending*) privateP;
+    if ((npP == NULL) || (npP->used == true))
+    {
+      LM_W(("No 'Pending Notification' found for a curl easy handle"));
+      continue;
+    }
+
+    LM_T(LmtNotificationSend, ("%s: Notification Result: CURLcode %d (%s)", npP->subscriptionId, msgP->data.result, curl_easy_strerror(msgP->data.result)));
+
+    if (msgP->data.result == 0)
+    {
+      long httpResponseCode = 500;
+      curl_easy_getinfo(npP->curlHandleP, CURLINFO_RESPONSE_CODE, &httpResponseCode);
+
+      LM_T(LmtNotificationSend, ("%s: Notification Response HTTP Status: %d", npP->subscriptionId, (int) httpResponseCode));
+
+      if ((httpResponseCode >= 200) && (httpResponseCode < 300))
+      {
+        notificationAccount(npP, true, NULL, notificationTime);
+        npP->ok = true;
+      }
+      else
+      {
+        char errorString[256];
+
+        snprintf(errorString, sizeof(errorString), "Got an HTTP Status %d", (int) httpResponseCode);
+        notificationAccount(npP, false, errorString, notificationTime);
+      }
+    }
+    else
+    {
+      char errorString[512];
+
+      snprintf(errorString, sizeof(errorString), "CURL Error %d: %s", msgP->data.result, curl_easy_strerror(msgP->data.result));
+      notificationAccount(npP, false, errorString, notificationTime);
+    }
+
+    npP->used = true;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpResponseTreat - read the response of an HTTP notification and give back its connection
+//
+static void httpResponseTreat(NotificationPending* npP, double notificationTime)
+{
+  char errorString[256];
+
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, npP->fd, NULL);
+
+  if (notificationResponseTreat(npP->connP, npP->subscriptionId, errorString, sizeof(errorString)) == true)
+  {
+    notificationAccount(npP, true, NULL, notificationTime);
+    npP->ok = true;
+  }
+  else
+    notificationAccount(npP, false, errorString, notificationTime);
+
+  httpConnectionRelease(npP->connP);  // Back to the pool if keep-alive, otherwise closed
+
+  npP->fd    = -1;
+  npP->connP = NULL;
+  npP->used  = true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// httpResponseTimeout - no response from the notification endpoint before the deadline
+//
+static void httpResponseTimeout(NotificationPending* npP, const char* reason, double notificationTime)
+{
+  notificationAccount(npP, false, reason, notificationTime);
+
+  LM_T(LmtNotificationSend, ("Closing fd %d after timeout", npP->fd));
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, npP->fd, NULL);
+
+  npP->connP->keepAlive = false;  // A late response would be taken for the response to the next notification
+  httpConnectionRelease(npP->connP);
+
+  npP->fd    = -1;
+  npP->connP = NULL;
+  npP->used  = true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// awaitInsert - insert an HTTP notification in the list of awaited responses, ordered by deadline
+//
+// The notifications are sent one after the other, with the same timeout, so the new item is almost always
+// the last item of the list - the search starts from the end.
+//
+static void awaitInsert(NotificationPending** headP, NotificationPending** tailP, NotificationPending* npP)
+{
+  NotificationPending* prev = *tailP;
+
+  while ((prev != NULL) && (prev->deadline > npP->deadline))
+    prev = prev->awaitPrev;
+
+  npP->awaitPrev = prev;
+  npP->awaitNext = (prev != NULL)? prev->awaitNext : *headP;
+
+  if (npP->awaitNext != NULL)  npP->awaitNext->awaitPrev = npP;
+  else                         *tailP = npP;
+
+  if (prev != NULL)            prev->awaitNext = npP;
+  else                         *headP = npP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// awaitRemove -
+//
+static void awaitRemove(NotificationPending** headP, NotificationPending** tailP, NotificationPending* npP)
+{
+  if (npP->awaitPrev != NULL)  npP->awaitPrev->awaitNext = npP->awaitNext;
+  else                         *headP = npP->awaitNext;
+
+  if (npP->awaitNext != NULL)  npP->awaitNext->awaitPrev = npP->awaitPrev;
+  else                         *tailP = npP->awaitPrev;
+
+  npP->awaitPrev = NULL;
+  npP->awaitNext = NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// mqttCompletionsAwait -
+//
+// The MQTT client library has no file descriptor to add to the epoll loop.
+// The publications have been started by mqttNotify, without awaiting their completion, and as the loop for
+// HTTP/HTTPS is over by now, the completions are collected here, each one until its own deadline.
+//
+static void mqttCompletionsAwait(NotificationPending* notificationList, double notificationTime)
+{
+  for (NotificationPending* npP = notificationList; npP != NULL; npP = npP->next)
+  {
+    if ((npP->used == true) || (npP->mqttConnectionP == NULL))
+      continue;
+
+    double         remaining = npP->deadline - timeNow();
+    unsigned long  timeoutMs = (remaining > 0)? (unsigned long) (remaining * 1000) + 1 : 1;
+    int            rc        = MQTTClient_waitForCompletion(npP->mqttConnectionP->client, npP->mqttToken, timeoutMs);
+
+    if (rc != MQTTCLIENT_SUCCESS)
+    {
+      LM_E(("Internal Error (MQTT waitForCompletion error %d)", rc));
+      notificationAccount(npP, false, "MQTT waitForCompletion error", notificationTime);
+    }
+    else
+      notificationAccount(npP, true, NULL, notificationTime);
+
+    npP->used = true;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationResponsesAwait -
+//
+// All file descriptors go to one epoll instance:
+//   - HTTP:  the connection of each notification, the epoll data pointing to its NotificationPending
+//   - HTTPS: the sockets libcurl asks for (curl_multi_socket_action), the easy handle pointing to its NotificationPending (CURLOPT_PRIVATE)
+//
+// Each notification has its own deadline (the time it was sent plus -notifTimeout), and epoll_wait sleeps
+// until the earliest deadline or libcurl's next timer, whatever comes first.
+//
+void notificationResponsesAwait(NotificationPending* notificationList, double notificationTime)
+{
+  NotificationPending* awaitHead   = NULL;
+  NotificationPending* awaitTail   = NULL;
+  CURLM*               multiP      = orionldState.multiP;
+  int                  curlRunning = 0;
+  double               curlTimer   = -1;
+
+  if (epollFd == -1)
+  {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1)
+      LM_E(("Internal Error (epoll_create1: %s)", strerror(errno)));
+  }
+
+  //
+  // HTTP responses
+  //
+  for (NotificationPending* npP = notificationList; npP != NULL; npP = npP->next)
+  {
+    if (npP->fd < 0)
+      continue;
+
+    struct epoll_event event;
+
+    event.events   = EPOLLIN;
+    event.data.ptr = npP;
+
+    if ((epollFd == -1) || (epoll_ctl(epollFd, EPOLL_CTL_ADD, npP->fd, &event) == -1))
+    {
+      LM_E(("Internal Error (unable to await the response of a notification (fd %d): %s)", npP->fd, strerror(errno)));
+      httpResponseTimeout(npP, "Internal Error (unable to await the response)", notificationTime);
+      continue;
+    }
+
+    awaitInsert(&awaitHead, &awaitTail, npP);
+  }
+
+  //
+  // HTTPS notifications - started here, by the first call to curl_multi_socket_action
+  //
+  if ((multiP != NULL) && (epollFd != -1))
+  {
+    CURLMcode cm;
+
+    curl_multi_setopt(multiP, CURLMOPT_SOCKETFUNCTION, curlSocketCallback);
+    curl_multi_setopt(multiP, CURLMOPT_TIMERFUNCTION,  curlTimerCallback);
+    curl_multi_setopt(multiP, CURLMOPT_TIMERDATA,      &curlTimer);
+
+    LM_T(LmtNotificationSend, ("Starting HTTPS notifications"));
+    cm = curl_multi_socket_action(multiP, CURL_SOCKET_TIMEOUT, 0, &curlRunning);
+    if (cm != CURLM_OK)
+    {
+      LM_E(("Error starting HTTPS notifications: curl_multi_socket_action: error %d", cm));
+      curlRunning = 0;
+    }
+
+    curlTransfersDone(multiP, notificationTime);
+  }
+  else
+    LM_T(LmtNotificationSend, ("No HTTPS notifications"));
+
+  //
+  // The event loop
+  //
+  while ((awaitHead != NULL) || (curlRunning > 0))
+  {
+    double now = timeNow();
+
+    while ((awaitHead != NULL) && (awaitHead->deadline <= now))
+    {
+      NotificationPending* npP = awaitHead;
+
+      awaitRemove(&awaitHead, &awaitTail, npP);
+      httpResponseTimeout(npP, "Timeout awaiting response from notification endpoint", notificationTime);
+    }
+
+    if ((awaitHead == NULL) && (curlRunning == 0))
+      break;
+
+    //
+    // Sleep until the earliest deadline or libcurl's timer - never more than a second, in case libcurl has no timer
+    //
+    double wakeup = now + 1;
+
+    if ((awaitHead != NULL) && (awaitHead->deadline < wakeup))
+      wakeup = awaitHead->deadline;
+    if ((curlRunning > 0) && (curlTimer >= 0) && (curlTimer < wakeup))
+      wakeup = curlTimer;
+
+    int                 timeoutMs = (wakeup > now)? (int) ((wakeup - now) * 1000) + 1 : 0;
+    struct epoll_event  eventV[EPOLL_EVENTS_MAX];
+    int                 fds       = epoll_wait(epollFd, eventV, EPOLL_EVENTS_MAX, timeoutMs);
+
+    if (fds == -1)
+    {
+      if (errno == EINTR)
+        continue;
+
+      LM_E(("Internal Error (epoll_wait: %s)", strerror(errno)));
+      break;
+    }
+
+    for (int ix = 0; ix < fds; ix++)
+    {
+      if ((eventV[ix].data.u64 & CURL_SOCKET_TAG) != 0)
+      {
+        if (multiP == NULL)
+          continue;
+
+        curl_socket_t fd    = (curl_socket_t) (eventV[ix].data.u64 & ~CURL_SOCKET_TAG);
+        int           flags = 0;
+
+        if (eventV[ix].events & EPOLLIN)                flags |= CURL_CSELECT_IN;
+        if (eventV[ix].events & EPOLLOUT)               flags |= CURL_CSELECT_OUT;
+        if (eventV[ix].events & (EPOLLERR | EPOLLHUP))  flags |= CURL_CSELECT_ERR;
+
+        curl_multi_socket_action(multiP, fd, flags, &curlRunning);
+      }
+      else
+      {
+        NotificationPending* npP = (NotificationPending*) eventV[ix].data.ptr;
+
+        awaitRemove(&awaitHead, &awaitTail, npP);
+        httpResponseTreat(npP, notificationTime);
+      }
+    }
+
+    if (multiP != NULL)
+    {
+      if ((curlTimer >= 0) && (curlTimer <= timeNow()))
+      {
+        curlTimer = -1;
+        curl_multi_socket_action(multiP, CURL_SOCKET_TIMEOUT, 0, &curlRunning);
+      }
+
+      curlTransfersDone(multiP, notificationTime);
+    }
+  }
+
+  //
+  // Whatever HTTP response is still awaited (epoll_wait error) is a timeout
+  //
+  while (awaitHead != NULL)
+  {
+    NotificationPending* npP = awaitHead;
+
+    awaitRemove(&awaitHead, &awaitTail, npP);
+    httpResponseTimeout(npP, "Timeout awaiting response from notification endpoint", notificationTime);
+  }
+
+  mqttCompletionsAwait(notificationList, notificationTime);
+
+  for (NotificationPending* npP = notificationList; npP != NULL; npP = npP->next)
+  {
+    if (npP->used == false)
+      notificationAccount(npP, false, "Notification never reached its destination", notificationTime);
+
+    //
+    // Failed notifications are handed over to the retry queue (-notifRetries)
+    //
+    if (npP->retryJobP != NULL)
+    {
+      if ((npP->ok == true) || (notificationRetryEnqueue(npP->retryJobP) == false))
+        free(npP->retryJobP);
+
+      npP->retryJobP = NULL;
+    }
+  }
+}
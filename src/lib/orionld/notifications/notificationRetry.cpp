@@ -0,0 +1,653 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc, free, rand_r
+#include <string.h>                                              // strcmp, strdup
+#include <time.h>                                                // clock_gettime, time
+#include <unistd.h>                                              // getpid
+#include <pthread.h>                                             // pthread_*
+
+extern "C"
+{
+#include "kalloc/kaBufferReset.h"                                // kaBufferReset
+#include "kjson/kjBufferCreate.h"                                // kjBufferCreate
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "cache/CachedSubscription.h"                            // CachedSubscription
+#include "cache/subCache.h"                                      // subCacheItemLookup
+#include "epoch/epoch.h"                                         // epochEnter, epochLeave
+
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+#include "orionld/common/orionldState.h"                         // orionldState, notifRetry*, promNotificationRetr*
+#include "orionld/prometheus/promCounterIncrease.h"              // promCounterIncrease
+#include "orionld/prometheus/promGaugeAdd.h"                     // promGaugeAdd
+#include "orionld/prometheus/promHistogramObserve.h"             // promHistogramObserve
+#include "orionld/notifications/notificationJobSend.h"           // notificationJobSend, notificationJobAccount
+#include "orionld/notifications/notificationSpill.h"             // notificationSpill*
+#include "orionld/notifications/notificationRetry.h"             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// RETRY_DELAY_MAX - the exponential backoff stops growing at one minute
+//
+#define RETRY_DELAY_MAX  60.0
+
+
+
+// -----------------------------------------------------------------------------
+//
+// RetryItem - a failed notification, awaiting its next attempt
+//
+typedef struct RetryItem
+{
+  NotificationJob*   jobP;
+  int                attempts;       // Retries already made
+  double             firstFailure;   // For the redelivery latency
+  struct RetryItem*  next;
+} RetryItem;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// RetryQueue - the failed notifications of one subscription, oldest first
+//
+// The notifications of a subscription are retried in order, one at a time, and the backoff is per subscription:
+// it's the notification endpoint that is down, not a specific notification.
+// The retry threads (-notifRetryThreads) take the subscriptions whose next attempt is due - a subscription
+// whose retry is in flight is skipped by the other threads, so, a slow endpoint only holds up its own retries.
+// Once a subscription has notifications in the spill file, its newer notifications go to the spill file as well,
+// so that the order is kept when they are replayed.
+//
+// The number of subscriptions with failed notifications is normally small, so a linked list of queues is good enough.
+//
+typedef struct RetryQueue
+{
+  char*               tenant;          // NULL for the default tenant
+  char*               subscriptionId;
+  RetryItem*          head;
+  RetryItem*          tail;
+  int                 items;           // In memory
+  int                 spilled;         // In the spill file
+  int                 failures;        // Consecutive failed attempts - decides the backoff
+  double              nextAttempt;
+  bool                inFlight;        // A retry thread is sending its oldest notification
+  struct RetryQueue*  next;
+} RetryQueue;
+
+
+
+static pthread_mutex_t  retryMutex    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   retryCond     = PTHREAD_COND_INITIALIZER;
+static RetryQueue*      queueList     = NULL;
+static size_t           memUsed       = 0;       // Bytes of the notification jobs in memory
+static bool             spillOn       = false;
+static bool             retryRunning  = false;
+static volatile bool    retryStop     = false;
+static pthread_t*       retryThreadV  = NULL;
+static int              retryThreads  = 0;
+static unsigned int     jitterSeed;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timeNow -
+//
+static double timeNow(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  return now.tv_sec + ((double) now.tv_nsec) / 1000000000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// retryBackoff - exponential backoff, with jitter, after 'failures' consecutive failures
+//
+// Half of the delay is fixed and half of it is random ("equal jitter"), so that the retries of many subscriptions
+// to the same notification endpoint are spread out when the endpoint comes back.
+//
+static double retryBackoff(int failures)
+{
+  double delay = ((double) notifRetryDelay) / 1000;
+
+  for (int ix = 1; (ix < failures) && (delay < RETRY_DELAY_MAX); ix++)
+  {
+    delay *= 2;
+  }
+
+  if (delay > RETRY_DELAY_MAX)
+    delay = RETRY_DELAY_MAX;
+
+  return delay / 2 + (delay / 2) * ((double) rand_r(&jitterSeed) / RAND_MAX);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// retryQueueGet - find the retry queue of a subscription, creating it if not found
+//
+static RetryQueue* retryQueueGet(const char* tenant, const char* subscriptionId)
+{
+  for (RetryQueue* qP = queueList; qP != NULL; qP = qP->next)
+  {
+    if (strcmp(qP->subscriptionId, subscriptionId) != 0)
+      continue;
+
+    if ((qP->tenant == NULL) && (tenant == NULL))
+      return qP;
+
+    if ((qP->tenant != NULL) && (tenant != NULL) && (strcmp(qP->tenant, tenant) == 0))
+      return qP;
+  }
+
+  RetryQueue* qP = (RetryQueue*) calloc(1, sizeof(RetryQueue));
+  if (qP == NULL)
+    return NULL;
+
+  qP->tenant         = (tenant != NULL)? strdup(tenant) : NULL;
+  qP->subscriptionId = strdup(subscriptionId);
+  qP->next           = queueList;
+  queueList          = qP;
+
+  return qP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// retryQueueRelease - remove an empty retry queue from the list, and free it
+//
+static void retryQueueRelease(RetryQueue* qP)
+{
+  RetryQueue* prev = NULL;
+
+  for (RetryQueue* q2P = queueList; q2P != NULL; q2P = q2P->next)
+  {
+    if (q2P == qP)
+    {
+      if (prev == NULL)
+        queueList = qP->next;
+      else
+        prev->next = qP->next;
+      break;
+    }
+
+    prev = q2P;
+  }
+
+  free(qP->tenant);
+  free(qP->subscriptionId);
+  free(qP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// retryItemPush - add a failed notification to the retry queue, first or last
+//
+static void retryItemPush(RetryQueue* qP, RetryItem* itemP, bool first)
+{
+  if (first == true)
+  {
+    itemP->next = qP->head;
+    qP->head    = itemP;
+
+    if (qP->tail == NULL)
+      qP->tail = itemP;
+  }
+  else
+  {
+    itemP->next = NULL;
+
+    if (qP->tail == NULL)
+      qP->head = itemP;
+    else
+      qP->tail->next = itemP;
+
+    qP->tail = itemP;
+  }
+
+  qP->items += 1;
+  memUsed   += itemP->jobP->size;
+  promGaugeAdd(promNotificationRetryQueued, 1, NULL);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// retryItemPop -
+//
+static RetryItem* retryItemPop(RetryQueue* qP)
+{
+  RetryItem* itemP = qP->head;
+
+  qP->head = itemP->next;
+  if (qP->head == NULL)
+    qP->tail = NULL;
+
+  qP->items -= 1;
+  memUsed   -= itemP->jobP->size;
+  promGaugeAdd(promNotificationRetryQueued, -1, NULL);
+
+  return itemP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// retryJobAdd - keep a failed notification in memory, if there's room for it, otherwise, spill it
+//
+static void retryJobAdd(RetryQueue* qP, NotificationJob* jobP, double firstFailure)
+{
+  if ((qP->spilled == 0) && (qP->items < notifRetryQueue) && (memUsed + jobP->size <= (size_t) notifRetryMem * 1024 * 1024))
+  {
+    RetryItem* itemP = (RetryItem*) malloc(sizeof(RetryItem));
+
+    if (itemP != NULL)
+    {
+      itemP->jobP         = jobP;
+      itemP->attempts     = 0;
+      itemP->firstFailure = firstFailure;
+
+      retryItemPush(qP, itemP, false);
+      return;
+    }
+  }
+
+  if ((spillOn == true) && (notificationSpillAppend(jobP, firstFailure) == true))
+  {
+    qP->spilled += 1;
+    promGaugeAdd(promNotificationRetrySpilled, 1, NULL);
+  }
+  else
+  {
+    LM_W(("%s: the retry queue is full - notification dropped", jobP->subscriptionId));
+    promCounterIncrease(promNotificationRetryDropped);
+  }
+
+  free(jobP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spillReplay - bring notifications back from the spill file, as long as their retry queues have room for them
+//
+// The spill file is read in order, so, a subscription whose retry queue is full holds back the replay of the
+// notifications of other subscriptions that come after it in the file.
+//
+static void spillReplay(void)
+{
+  char* tenant;
+  char* subscriptionId;
+
+  while (notificationSpillPeek(&tenant, &subscriptionId) == true)
+  {
+    RetryQueue* qP = retryQueueGet(tenant, subscriptionId);
+
+    if (qP == NULL)
+      break;
+
+    if ((qP->items >= notifRetryQueue) || (memUsed >= (size_t) notifRetryMem * 1024 * 1024))
+      break;
+
+    double            firstFailure;
+    NotificationJob*  jobP  = notificationSpillPop(&firstFailure);
+    RetryItem*        itemP = (jobP != NULL)? (RetryItem*) malloc(sizeof(RetryItem)) : NULL;
+
+    if (qP->spilled > 0)
+      qP->spilled -= 1;
+    promGaugeAdd(promNotificationRetrySpilled, -1, NULL);
+
+    if (itemP == NULL)
+    {
+      free(jobP);
+      promCounterIncrease(promNotificationRetryDropped);
+      continue;
+    }
+
+    itemP->jobP         = jobP;
+    itemP->attempts     = 0;
+    itemP->firstFailure = firstFailure;
+
+    retryItemPush(qP, itemP, false);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subscriptionExists - no retries for a subscription that has been deleted
+//
+static bool subscriptionExists(NotificationJob* jobP)
+{
+  epochEnter();
+  bool exists = (subCacheItemLookup(jobP->tenant, jobP->subscriptionId) != NULL);
+  epochLeave();
+
+  return exists;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// retryWorker - a retry thread
+//
+static void* retryWorker(void* vP)
+{
+  orionldStateInit(NULL);  // The allocations of the retries are done with the thread-local orionldState.kalloc
+
+  pthread_mutex_lock(&retryMutex);
+
+  while (retryStop == false)
+  {
+    spillReplay();
+
+    //
+    // Find a subscription whose next attempt is due - or, if none, the time of the earliest next attempt
+    //
+    double      now    = timeNow();
+    double      wakeup = now + 1;
+    RetryQueue* qP     = NULL;
+
+    for (RetryQueue* q2P = queueList; q2P != NULL; q2P = q2P->next)
+    {
+      if ((q2P->head == NULL) || (q2P->inFlight == true))
+        continue;
+
+      if (q2P->nextAttempt <= now)
+      {
+        qP = q2P;
+        break;
+      }
+
+      if (q2P->nextAttempt < wakeup)
+        wakeup = q2P->nextAttempt;
+    }
+
+    if (qP == NULL)
+    {
+      struct timespec until;
+
+      until.tv_sec  = (time_t) wakeup;
+      until.tv_nsec = (long) ((wakeup - until.tv_sec) * 1000000000);
+
+      pthread_cond_timedwait(&retryCond, &retryMutex, &until);
+      continue;
+    }
+
+    //
+    // Retry the oldest notification of the subscription - without holding the mutex
+    //
+    RetryItem*  itemP  = retryItemPop(qP);
+    bool        ok     = false;
+    bool        exists;
+    char        errorString[256];
+
+    qP->inFlight = true;
+    pthread_mutex_unlock(&retryMutex);
+
+    exists = subscriptionExists(itemP->jobP);
+    if (exists == true)
+    {
+      errorString[0] = 0;
+      promCounterIncrease(promNotificationRetries);
+
+      ok = notificationJobSend(itemP->jobP, errorString, sizeof(errorString));
+      if (ok == true)
+      {
+        notificationJobAccount(itemP->jobP, true, NULL);
+        promCounterIncrease(promNotificationsRedelivered);
+        promHistogramObserve(promNotificationRedeliveryLatency, timeNow() - itemP->firstFailure);
+      }
+      else
+        LM_T(LmtNotificationSend, ("%s: retry %d failed: %s", itemP->jobP->subscriptionId, itemP->attempts + 1, errorString));
+    }
+    else
+      LM_T(LmtNotificationSend, ("%s: subscription not found - failed notification dropped", itemP->jobP->subscriptionId));
+
+    kaBufferReset(&orionldState.kalloc, true);
+    orionldState.kjsonP = kjBufferCreate(&orionldState.kjson, &orionldState.kalloc);
+
+    pthread_mutex_lock(&retryMutex);
+
+    qP->inFlight = false;
+
+    if ((ok == true) || (exists == false))
+    {
+      free(itemP->jobP);
+      free(itemP);
+
+      qP->failures    = 0;
+      qP->nextAttempt = timeNow();  // The notification endpoint is back - the next notification goes right away
+    }
+    else
+    {
+      itemP->attempts += 1;
+      qP->failures    += 1;
+      qP->nextAttempt  = timeNow() + retryBackoff(qP->failures);
+
+      if (itemP->attempts >= notifRetries)
+      {
+        LM_W(("%s: notification dropped after %d retries (%s)", itemP->jobP->subscriptionId, itemP->attempts, errorString));
+        promCounterIncrease(promNotificationRetryDropped);
+
+        free(itemP->jobP);
+        free(itemP);
+      }
+      else
+        retryItemPush(qP, itemP, true);
+    }
+
+    if ((qP->head == NULL) && (qP->spilled == 0))
+      retryQueueRelease(qP);
+  }
+
+  pthread_mutex_unlock(&retryMutex);
+  orionldStateRelease();
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spilledCount - a notification of the previous run, still in the spill file
+//
+static void spilledCount(const char* tenant, const char* subscriptionId)
+{
+  RetryQueue* qP = retryQueueGet(tenant, subscriptionId);
+
+  if (qP != NULL)
+    qP->spilled += 1;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationRetryStart -
+//
+bool notificationRetryStart(void)
+{
+  if (notifRetries == 0)
+    return true;
+
+  jitterSeed = time(NULL) ^ getpid();
+
+  if (notifRetrySpill[0] != 0)
+  {
+    if (notificationSpillOpen(notifRetrySpill) == false)
+      return false;
+
+    spillOn = true;
+
+    int spilled = notificationSpillForEach(spilledCount);
+    if (spilled > 0)
+    {
+      LM_I(("%d failed notifications in the spill file '%s' - to be retried", spilled, notifRetrySpill));
+      promGaugeAdd(promNotificationRetrySpilled, spilled, NULL);
+    }
+  }
+
+  retryThreadV = (pthread_t*) calloc(notifRetryThreads, sizeof(pthread_t));
+  if (retryThreadV == NULL)
+  {
+    LM_E(("Out of memory (allocating %d notification retry threads)", notifRetryThreads));
+    return false;
+  }
+
+  for (retryThreads = 0; retryThreads < notifRetryThreads; retryThreads++)
+  {
+    int s = pthread_create(&retryThreadV[retryThreads], NULL, retryWorker, NULL);
+    if (s != 0)
+    {
+      LM_E(("Runtime Error (error creating notification retry thread %d: %d)", retryThreads, s));
+      break;
+    }
+  }
+
+  if (retryThreads == 0)
+  {
+    free(retryThreadV);
+    retryThreadV = NULL;
+    return false;
+  }
+
+  retryRunning = true;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationRetryEnqueue -
+//
+bool notificationRetryEnqueue(NotificationJob* jobP)
+{
+  if (retryRunning == false)
+    return false;
+
+  double now = timeNow();
+
+  pthread_mutex_lock(&retryMutex);
+
+  RetryQueue* qP = retryQueueGet(jobP->tenant, jobP->subscriptionId);
+
+  if (qP == NULL)
+  {
+    pthread_mutex_unlock(&retryMutex);
+
+    LM_E(("Out of memory (allocating a retry queue for subscription '%s')", jobP->subscriptionId));
+    free(jobP);
+    return true;
+  }
+
+  if ((qP->head == NULL) && (qP->spilled == 0) && (qP->inFlight == false))
+  {
+    qP->failures    = 1;
+    qP->nextAttempt = now + retryBackoff(1);
+  }
+
+  retryJobAdd(qP, jobP, now);
+
+  pthread_cond_signal(&retryCond);
+  pthread_mutex_unlock(&retryMutex);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationRetryStop -
+//
+// The notifications still in memory are spilled (if -notifRetrySpill), to be retried after a restart.
+// A subscription that already had notifications in the spill file gets its in-memory notifications after those.
+//
+void notificationRetryStop(void)
+{
+  if (retryRunning == false)
+    return;
+
+  pthread_mutex_lock(&retryMutex);
+  retryStop = true;
+  pthread_cond_broadcast(&retryCond);
+  pthread_mutex_unlock(&retryMutex);
+
+  for (int ix = 0; ix < retryThreads; ix++)
+  {
+    pthread_join(retryThreadV[ix], NULL);
+  }
+
+  free(retryThreadV);
+  retryThreadV = NULL;
+  retryThreads = 0;
+  retryRunning = false;
+
+  while (queueList != NULL)
+  {
+    RetryQueue* qP = queueList;
+
+    while (qP->head != NULL)
+    {
+      RetryItem* itemP = retryItemPop(qP);
+
+      if ((spillOn == false) || (notificationSpillAppend(itemP->jobP, itemP->firstFailure) == false))
+        LM_W(("%s: failed notification lost at shutdown", itemP->jobP->subscriptionId));
+
+      free(itemP->jobP);
+      free(itemP);
+    }
+
+    queueList = qP->next;
+    free(qP->tenant);
+    free(qP->subscriptionId);
+    free(qP);
+  }
+
+  if (spillOn == true)
+    notificationSpillClose();
+}
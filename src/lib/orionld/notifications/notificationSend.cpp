@@ -22,7 +22,8 @@
 *
 * Author: Ken Zangelin
 */
-#include <string.h>                                              // strlen
+#include <string.h>                                              // strlen, memcpy
+#include <stdint.h>                                              // uint64_t, uintptr_t
 #include <sys/uio.h>                                             // writev, iovec
 #include <sys/select.h>                                          // select
 #include <curl/curl.h>                                           // curl
@@ -46,7 +47,11 @@ extern "C"
 
 #include "orionld/types/OrionldAlteration.h"                     // OrionldAlterationMatch, OrionldAlteration, orionldAlterationType
 #include "orionld/types/OrionLdRestService.h"                    // OrionLdRestService
-#include "orionld/common/orionldState.h"                         // orionldState, coreContextUrl, userAgentHeader
+#include "orionld/types/NotificationPending.h"                   // NotificationPending
+#include "orionld/types/NotificationRender.h"                    // NotificationRender
+#include "orionld/types/ContentEncoding.h"                       // ContentEncoding, contentEncodingFromString, contentEncodingToString
+#include "orionld/common/orionldState.h"                         // orionldState, coreContextUrl, userAgentHeader, promNotificationRender*, compressMin
+#include "orionld/common/compress.h"                             // compressBuffer
 #include "orionld/common/numberToDate.h"                         // numberToDate
 #include "orionld/common/uuidGenerate.h"                         // uuidGenerate
 #include "orionld/common/eqForDot.h"                             // eqForDot
@@ -56,9 +61,13 @@ extern "C"
 #include "orionld/context/orionldContextItemAliasLookup.h"       // orionldContextItemAliasLookup
 #include "orionld/context/orionldContextItemExpand.h"            // orionldContextItemExpand
 #include "orionld/mqtt/mqttNotify.h"                             // mqttNotify
+#include "orionld/prometheus/promCounterIncrease.h"              // promCounterIncrease
 #include "orionld/notifications/httpNotify.h"                    // httpNotify
 #include "orionld/notifications/httpsNotify.h"                   // httpsNotify
 #include "orionld/notifications/notificationDataToGeoJson.h"     // notificationDataToGeoJson
+#include "orionld/notifications/notificationEnqueue.h"           // notificationEnqueue
+#include "orionld/notifications/notificationJobCreate.h"         // notificationJobCreate
+#include "orionld/notifications/notificationWorkers.h"           // notificationWorkers
 #include "orionld/notifications/previousValueAdd.h"              // previousValueAdd
 #include "orionld/notifications/notificationSend.h"              // Own interface
 
@@ -544,23 +553,32 @@ static KjNode* notificationTreeForNgsiV2(OrionldAlterationMatch* matchP)
 //
 // notificationTree -
 //
-static KjNode* notificationTree(OrionldAlterationMatch* matchList)
+// If 'shared' is set, the per-subscription fields (id, type, subscriptionId) are left out, for the tree to be
+// rendered once and shared by all subscriptions with the same notification shape - see notificationBodyShared.
+//
+static KjNode* notificationTree(OrionldAlterationMatch* matchList, bool shared)
 {
   CachedSubscription* subP          = matchList->subP;
   KjNode*             notificationP = kjObject(orionldState.kjsonP, NULL);
-  char                notificationId[80];
 
-  uuidGenerate(notificationId, sizeof(notificationId), "urn:ngsi-ld:Notification:");  // notificationId could be a thread variable ...
+  if (shared == false)
+  {
+    char notificationId[80];
+
+    uuidGenerate(notificationId, sizeof(notificationId), "urn:ngsi-ld:Notification:");  // notificationId could be a thread variable ...
+
+    KjNode* idNodeP              = kjString(orionldState.kjsonP, "id", notificationId);
+    KjNode* typeNodeP            = kjString(orionldState.kjsonP, "type", "Notification");
+    KjNode* subscriptionIdNodeP  = kjString(orionldState.kjsonP, "subscriptionId", subP->subscriptionId);
+
+    kjChildAdd(notificationP, idNodeP);
+    kjChildAdd(notificationP, typeNodeP);
+    kjChildAdd(notificationP, subscriptionIdNodeP);
+  }
 
-  KjNode* idNodeP              = kjString(orionldState.kjsonP, "id", notificationId);
-  KjNode* typeNodeP            = kjString(orionldState.kjsonP, "type", "Notification");
-  KjNode* subscriptionIdNodeP  = kjString(orionldState.kjsonP, "subscriptionId", subP->subscriptionId);
   KjNode* notifiedAtNodeP      = kjString(orionldState.kjsonP, "notifiedAt", orionldState.requestTimeString);
   KjNode* dataNodeP            = kjArray(orionldState.kjsonP,  "data");
 
-  kjChildAdd(notificationP, idNodeP);
-  kjChildAdd(notificationP, typeNodeP);
-  kjChildAdd(notificationP, subscriptionIdNodeP);
   kjChildAdd(notificationP, notifiedAtNodeP);
   kjChildAdd(notificationP, dataNodeP);
 
@@ -615,6 +633,114 @@ static KjNode* notificationTree(OrionldAlterationMatch* matchList)
 
 
 
+// -----------------------------------------------------------------------------
+//
+// notificationShapeHash - hash of what decides the body of a notification, except for its per-subscription fields
+//
+static uint64_t notificationShapeHash(OrionldAlterationMatch* matchList)
+{
+  CachedSubscription* subP = matchList->subP;
+  uint64_t            hash = 14695981039346656037ULL;  // FNV-1a
+
+#define SHAPE_HASH(value)  hash = (hash ^ ((uint64_t) (value))) * 1099511628211ULL
+
+  for (OrionldAlterationMatch* matchP = matchList; matchP != NULL; matchP = matchP->next)
+  {
+    SHAPE_HASH((uintptr_t) matchP->altP);
+  }
+
+  SHAPE_HASH(subP->renderFormat);
+  SHAPE_HASH(subP->httpInfo.mimeType);
+  SHAPE_HASH(subP->sysAttrs);
+  SHAPE_HASH(subP->showChanges);
+  SHAPE_HASH((uintptr_t) subP->contextP);
+  SHAPE_HASH(subP->attributes.size());
+
+  for (const char* cP = subP->lang.c_str(); *cP != 0; ++cP)
+  {
+    SHAPE_HASH(*cP);
+  }
+
+#undef SHAPE_HASH
+
+  return hash;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationShapeEquals -
+//
+static bool notificationShapeEquals(OrionldAlterationMatch* matchList1, OrionldAlterationMatch* matchList2)
+{
+  CachedSubscription* sub1P = matchList1->subP;
+  CachedSubscription* sub2P = matchList2->subP;
+
+  if (sub1P->renderFormat      != sub2P->renderFormat)       return false;
+  if (sub1P->httpInfo.mimeType != sub2P->httpInfo.mimeType)  return false;
+  if (sub1P->sysAttrs          != sub2P->sysAttrs)           return false;
+  if (sub1P->showChanges       != sub2P->showChanges)        return false;
+  if (sub1P->contextP          != sub2P->contextP)           return false;
+  if (sub1P->lang              != sub2P->lang)               return false;
+  if (sub1P->attributes        != sub2P->attributes)         return false;
+
+  while ((matchList1 != NULL) && (matchList2 != NULL))
+  {
+    if (matchList1->altP != matchList2->altP)
+      return false;
+
+    matchList1 = matchList1->next;
+    matchList2 = matchList2->next;
+  }
+
+  return (matchList1 == NULL) && (matchList2 == NULL);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationBodyShared - the part of the body that is common to all subscriptions with the same notification shape
+//
+// Looked up in the render cache of the request (orionldState.notificationRenderList) and rendered only if not found.
+// What's returned is the body without its initial '{' and without the per-subscription fields (id, type, subscriptionId).
+//
+static NotificationRender* notificationBodyShared(OrionldAlterationMatch* matchList)
+{
+  uint64_t shapeHash = notificationShapeHash(matchList);
+
+  for (NotificationRender* renderP = orionldState.notificationRenderList; renderP != NULL; renderP = renderP->next)
+  {
+    if ((renderP->shapeHash == shapeHash) && (notificationShapeEquals(renderP->matchList, matchList) == true))
+    {
+      LM_T(LmtNotificationBody, ("%s: reusing the notification body of %s", matchList->subP->subscriptionId, renderP->matchList->subP->subscriptionId));
+      promCounterIncrease(promNotificationRenderHits);
+      return renderP;
+    }
+  }
+
+  KjNode*             notificationP   = notificationTree(matchList, true);
+  long unsigned int   payloadBodySize = kjFastRenderSize(notificationP);
+  char*               payloadBody     = kaAlloc(&orionldState.kalloc, payloadBodySize + 512);
+  NotificationRender* renderP         = (NotificationRender*) kaAlloc(&orionldState.kalloc, sizeof(NotificationRender));
+
+  kjFastRender(notificationP, payloadBody);
+
+  renderP->shapeHash   = shapeHash;
+  renderP->matchList   = matchList;
+  renderP->body        = &payloadBody[1];  // Skipping the initial '{' - it comes with the per-subscription fields
+  renderP->bodyLen     = strlen(renderP->body);
+  renderP->next        = orionldState.notificationRenderList;
+
+  orionldState.notificationRenderList = renderP;
+  promCounterIncrease(promNotificationRenderMisses);
+
+  return renderP;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // notificationSend -
@@ -644,7 +770,7 @@ static KjNode* notificationTree(OrionldAlterationMatch* matchList)
 // - mAltP->subP->rest
 //
 //
-int notificationSend(OrionldAlterationMatch* mAltP, double timestamp, CURL** curlHandlePP)
+int notificationSend(OrionldAlterationMatch* mAltP, double timestamp, NotificationPending* npP)
 {
   bool ngsiv2 = (mAltP->subP->renderFormat >= RF_CROSS_APIS_NORMALIZED);
 
@@ -666,34 +792,111 @@ int notificationSend(OrionldAlterationMatch* mAltP, double timestamp, CURL** cur
   //
   // Outgoing Payload Body
   //
-  KjNode* notificationP = (ngsiv2 == false)? notificationTree(mAltP) : notificationTreeForNgsiV2(mAltP);
-  char*   preferHeader  = NULL;
+  // NGSI-LD notifications (not GeoJSON) are rendered once per notification shape and shared by all
+  // subscriptions with that same shape - only the per-subscription fields (id, type, subscriptionId) are rendered here
+  //
+  char*               preferHeader   = NULL;
+  char*               payloadBody    = NULL;
+  long unsigned int   contentLength  = 0;
+  char*               bodyHead       = NULL;
+  int                 bodyHeadLen    = 0;
+  NotificationRender* renderP        = NULL;
+
+  if ((ngsiv2 == false) && (mAltP->subP->httpInfo.mimeType != MT_GEOJSON))
+  {
+    char notificationId[80];
+    int  bodyHeadSize = strlen(mAltP->subP->subscriptionId) + 160;
+
+    uuidGenerate(notificationId, sizeof(notificationId), "urn:ngsi-ld:Notification:");
 
-  if ((ngsiv2 == false) && (mAltP->subP->httpInfo.mimeType == MT_GEOJSON))
+    renderP       = notificationBodyShared(mAltP);
+    bodyHead      = kaAlloc(&orionldState.kalloc, bodyHeadSize);
+    bodyHeadLen   = snprintf(bodyHead, bodyHeadSize, "{\"id\":\"%s\",\"type\":\"Notification\",\"subscriptionId\":\"%s\",", notificationId, mAltP->subP->subscriptionId);
+    contentLength = bodyHeadLen + renderP->bodyLen;
+  }
+  else
   {
-    char*       geometryProperty = (char*) mAltP->subP->expression.geoproperty.c_str();
-    char*       attrs            = NULL;
-    bool        concise          = mAltP->subP->renderFormat == RF_CONCISE;
-    const char* context          = mAltP->subP->ldContext.c_str();
+    KjNode* notificationP = (ngsiv2 == false)? notificationTree(mAltP, false) : notificationTreeForNgsiV2(mAltP);
+
+    if (ngsiv2 == false)  // MT_GEOJSON
+    {
+      char*       geometryProperty = (char*) mAltP->subP->expression.geoproperty.c_str();
+      char*       attrs            = NULL;
+      bool        concise          = mAltP->subP->renderFormat == RF_CONCISE;
+      const char* context          = mAltP->subP->ldContext.c_str();
+
+      if (geometryProperty[0] == 0)
+        geometryProperty = (char*) "location";
+
+      // Extract attrs from (mAltP->subP->attributes
+      for (unsigned int ix = 0; ix < mAltP->subP->httpInfo.notifierInfo.size(); ix++)
+      {
+        KeyValue* kvP = mAltP->subP->httpInfo.notifierInfo[ix];
+        if (strcmp(kvP->key, "Prefer") == 0)
+          preferHeader = kvP->value;
+      }
+
+      notificationDataToGeoJson(notificationP, attrs, geometryProperty, preferHeader, concise, context);
+    }
+
+    long unsigned int  payloadBodySize  = kjFastRenderSize(notificationP);
+
+    payloadBody = kaAlloc(&orionldState.kalloc, payloadBodySize + 512);
+    kjFastRender(notificationP, payloadBody);
+    contentLength = strlen(payloadBody);  // FIXME: kjFastRender should return the size
+  }
 
-    if (geometryProperty[0] == 0)
-      geometryProperty = (char*) "location";
 
-    // Extract attrs from (mAltP->subP->attributes
+  //
+  // Content-Encoding - subscriptions can ask for compressed notifications (notifierInfo "Content-Encoding": "gzip" | "deflate")
+  // A compressed body is always in one single buffer (payloadBody), no matter whether the body is shared or not
+  //
+  ContentEncoding encoding = CE_IDENTITY;
+
+  if ((mAltP->subP->protocol == HTTP) || (mAltP->subP->protocol == HTTPS))
+  {
     for (unsigned int ix = 0; ix < mAltP->subP->httpInfo.notifierInfo.size(); ix++)
     {
       KeyValue* kvP = mAltP->subP->httpInfo.notifierInfo[ix];
-      if (strcmp(kvP->key, "Prefer") == 0)
-        preferHeader = kvP->value;
+      if (strcmp(kvP->key, "Content-Encoding") == 0)
+        encoding = contentEncodingFromString(kvP->value);
     }
-
-    notificationDataToGeoJson(notificationP, attrs, geometryProperty, preferHeader, concise, context);
   }
 
-  long unsigned int  payloadBodySize  = kjFastRenderSize(notificationP);
-  char*              payloadBody      = kaAlloc(&orionldState.kalloc, payloadBodySize + 512);
+  if (((encoding == CE_GZIP) || (encoding == CE_DEFLATE)) && (contentLength >= (long unsigned int) compressMin))
+  {
+    const char* partV[2];
+    int         partLenV[2];
+    int         parts = 1;
+    int         compressedLen;
 
-  kjFastRender(notificationP, payloadBody);
+    if (renderP != NULL)
+    {
+      partV[0]    = bodyHead;
+      partLenV[0] = bodyHeadLen;
+      partV[1]    = renderP->body;
+      partLenV[1] = renderP->bodyLen;
+      parts       = 2;
+    }
+    else
+    {
+      partV[0]    = payloadBody;
+      partLenV[0] = contentLength;
+    }
+
+    char* compressed = compressBuffer(encoding, &orionldState.kalloc, parts, partV, partLenV, &compressedLen);
+
+    if (compressed != NULL)
+    {
+      payloadBody   = compressed;
+      contentLength = compressedLen;
+      renderP       = NULL;  // The body is now in payloadBody
+    }
+    else
+      encoding = CE_IDENTITY;
+  }
+  else
+    encoding = CE_IDENTITY;
 
 
   //
@@ -726,7 +929,6 @@ int notificationSend(OrionldAlterationMatch* mAltP, double timestamp, CURL** cur
   char              contentLenHeader[32];
   char*             lenP           = &contentLenHeader[16];
   int               sizeLeftForLen = 16;                   // 16: sizeof(contentLenHeader) - 16
-  long unsigned int contentLength  = strlen(payloadBody);  // FIXME: kjFastRender should return the size
 
   strcpy(contentLenHeader, "Content-Length: 0");  // Can't modify inside static strings, so need a char-vec on the stack for contentLenHeader
   snprintf(lenP, sizeLeftForLen, "%d\r\n", (int) contentLength);  // Adding Content-Length inside contentLenHeader
@@ -742,6 +944,13 @@ int notificationSend(OrionldAlterationMatch* mAltP, double timestamp, CURL** cur
   if (orionldState.in.authorization != NULL)    ++headers;
 
 
+  //
+  // Content-Encoding of a compressed payload body
+  //
+  if (encoding != CE_IDENTITY)
+    ++headers;
+
+
   //
   // Headers from Subscription::notification::endpoint::receiverInfo+headers (or custom notification in NGSIv2 ...)
   //
@@ -759,7 +968,7 @@ int notificationSend(OrionldAlterationMatch* mAltP, double timestamp, CURL** cur
 
   int           ioVecLen   = headers + 3;  // Request line + X headers + empty line + payload body
   int           headerIx   = 7;
-  struct iovec  ioVec[53]  = {
+  struct iovec  ioVec[54]  = {  // 50 headers + request line + empty line + payload body (in two parts if shared)
     { requestHeader,                 requestHeaderLen },
     { contentLenHeader,              strlen(contentLenHeader) },
     { (void*) contentTypeHeaderJson, 32 },  // Index 2
@@ -871,6 +1080,20 @@ int notificationSend(OrionldAlterationMatch* mAltP, double timestamp, CURL** cur
     ++headerIx;
   }
 
+
+  //
+  // Content-Encoding
+  //
+  if (encoding != CE_IDENTITY)
+  {
+    int   len = 32;  // Content-Encoding: deflate\r\n0
+    char* buf = kaAlloc(&orionldState.kalloc, len);
+
+    ioVec[headerIx].iov_len  = snprintf(buf, len, "Content-Encoding: %s\r\n", contentEncodingToString(encoding));
+    ioVec[headerIx].iov_base = buf;
+    ++headerIx;
+  }
+
   //
   // FIXME: Store headers in a better way - see issue #1095
   //
@@ -908,14 +1131,51 @@ int notificationSend(OrionldAlterationMatch* mAltP, double timestamp, CURL** cur
 
 
   // Payload Body
-  ioVec[headerIx].iov_base = payloadBody;
-  ioVec[headerIx].iov_len  = contentLength;
+  if (renderP == NULL)
+  {
+    ioVec[headerIx].iov_base = payloadBody;
+    ioVec[headerIx].iov_len  = contentLength;
+  }
+  else if ((mAltP->subP->protocol == HTTP) && (notificationWorkers == 0))
+  {
+    // writev straight from the shared body - no copy
+    ioVec[headerIx].iov_base = bodyHead;
+    ioVec[headerIx].iov_len  = bodyHeadLen;
+    ++headerIx;
+
+    ioVec[headerIx].iov_base = renderP->body;
+    ioVec[headerIx].iov_len  = renderP->bodyLen;
+  }
+  else
+  {
+    // HTTPS, MQTT and the notification queue need the body in one single buffer
+    payloadBody = kaAlloc(&orionldState.kalloc, contentLength + 1);
+
+    memcpy(payloadBody, bodyHead, bodyHeadLen);
+    memcpy(&payloadBody[bodyHeadLen], renderP->body, renderP->bodyLen + 1);
+
+    ioVec[headerIx].iov_base = payloadBody;
+    ioVec[headerIx].iov_len  = contentLength;
+  }
 
   ioVecLen = headerIx + 1;
 
   //
   // The message is ready - just need to be sent
   //
+  // If notification workers are running (-notificationMode threadpool), HTTP and HTTPS notifications
+  // are queued and sent by the workers, so that the request thread doesn't need to await the responses.
+  //
+  if ((notificationWorkers > 0) && ((mAltP->subP->protocol == HTTP) || (mAltP->subP->protocol == HTTPS)))
+    return notificationEnqueue(mAltP->subP, ioVec, ioVecLen, timestamp);
+
+  //
+  // With retries (-notifRetries), a copy of HTTP and HTTPS notifications is kept until the response is in -
+  // if the notification fails, the copy goes to the retry queue
+  //
+  if ((notifRetries > 0) && ((mAltP->subP->protocol == HTTP) || (mAltP->subP->protocol == HTTPS)))
+    npP->retryJobP = notificationJobCreate(mAltP->subP, ioVec, ioVecLen, timestamp);
+
   if (mAltP->subP->protocol == HTTP)
     return httpNotify(mAltP->subP,
                       NULL,
@@ -925,9 +1185,10 @@ int notificationSend(OrionldAlterationMatch* mAltP, double timestamp, CURL** cur
                       mAltP->subP->rest,
                       ioVec,
                       ioVecLen,
-                      timestamp);
-  else if (mAltP->subP->protocol == HTTPS)   return httpsNotify(mAltP->subP, ioVec, ioVecLen, timestamp, curlHandlePP);
-  else if (mAltP->subP->protocol == MQTT)    return mqttNotify(mAltP->subP,  ioVec, ioVecLen, timestamp);
+                      timestamp,
+                      &npP->connP);
+  else if (mAltP->subP->protocol == HTTPS)   return httpsNotify(mAltP->subP, ioVec, ioVecLen, timestamp, &npP->curlHandleP);
+  else if (mAltP->subP->protocol == MQTT)    return mqttNotify(mAltP->subP,  ioVec, ioVecLen, timestamp, &npP->mqttConnectionP, &npP->mqttToken);
 
   LM_W(("%s: Unsupported protocol for notifications: '%s'", mAltP->subP->subscriptionId, mAltP->subP->protocol));
   return -1;
@@ -25,9 +25,8 @@
 *
 * Author: Ken Zangelin
 */
-#include <curl/curl.h>                                           // curl
-
 #include "orionld/types/OrionldAlteration.h"                     // OrionldAlterationMatch, OrionldAlteration
+#include "orionld/types/NotificationPending.h"                   // NotificationPending
 
 
 
@@ -35,6 +34,10 @@
 //
 // notificationSend -
 //
-extern int notificationSend(OrionldAlterationMatch* altP, double timestamp, CURL** curlHandlePP);
+// What is needed to await the response (connection, curl handle, MQTT delivery token) is stored in 'npP'.
+// Returns -1 on error, -2 for HTTPS (libcurl awaits the response), -3 if handed over to the notification workers,
+// -4 for MQTT with the completion pending, and, for HTTP, the file descriptor to read the response from.
+//
+extern int notificationSend(OrionldAlterationMatch* altP, double timestamp, NotificationPending* npP);
 
 #endif  // SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONSEND_H_
@@ -0,0 +1,636 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint32_t, uint64_t
+#include <string.h>                                              // strlen, strerror, memcpy, memcmp
+#include <errno.h>                                               // errno
+#include <fcntl.h>                                               // open, O_*, fallocate, FALLOC_FL_*
+#include <unistd.h>                                              // ftruncate, close, sysconf
+#include <sys/mman.h>                                            // mmap, mremap, munmap, msync
+#include <sys/stat.h>                                            // fstat
+#include <sys/uio.h>                                             // iovec
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/Protocol.h"                              // Protocol
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+#include "orionld/notifications/notificationJobCreate.h"         // notificationJobBuild
+#include "orionld/notifications/notificationSpill.h"             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// The spill file is a log of notifications, mapped into memory:
+//
+//   [ SpillFileHeader | ... | SpillRecord | SpillRecord | ... ]
+//   0                 4096  readOffset                  writeOffset
+//
+// It grows in segments of SPILL_SEGMENT_SIZE, up to SPILL_SIZE_MAX, and starts over (shrinks to one segment)
+// as soon as all its notifications have been replayed.
+//
+// If the log never gets empty (notifications are spilled as fast as they're replayed), it would reach SPILL_SIZE_MAX
+// with most of it already replayed. So, once the end of the file is reached, the log wraps around and continues at
+// the start of the data, in front of readOffset, for as long as there is room:
+//
+//   [ SpillFileHeader | SpillRecord | ... | (free) | SpillRecord | ... | (free) ]
+//   0                 4096                writeOffset readOffset        wrapOffset
+//
+// The disk space of the replayed part is given back as readOffset advances (holes are punched in the file).
+// The offsets live in the header of the file, so, whatever was not replayed is found again after a restart.
+//
+#define SPILL_FILE_MAGIC       "orionld-spill-2"
+#define SPILL_RECORD_MAGIC     0x4E4F5446
+#define SPILL_DATA_START       4096
+#define SPILL_SEGMENT_SIZE     (16 * 1024 * 1024)
+#define SPILL_SIZE_MAX         (1024LL * 1024 * 1024)
+#define SPILL_IOVECS_MAX       64
+#define SPILL_PUNCH_SIZE       (1024 * 1024)
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SpillFileHeader -
+//
+typedef struct SpillFileHeader
+{
+  char      magic[16];
+  uint64_t  readOffset;    // The oldest notification that has not been replayed
+  uint64_t  writeOffset;   // The end of the log
+  uint64_t  wrapOffset;    // The end of the part that starts at readOffset, if the log has wrapped around - 0 if not
+} SpillFileHeader;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// SpillRecord - a notification job in the spill file
+//
+// The record is followed by the five strings (zero-terminated) and by the iovecs (a uint32_t length + the bytes).
+//
+typedef struct SpillRecord
+{
+  uint32_t  magic;
+  uint32_t  size;              // Of the entire record, this header included - a multiple of 8
+  double    firstFailure;
+  double    notificationTime;
+  uint32_t  protocol;
+  uint32_t  port;
+  uint32_t  ioVecLen;
+  uint32_t  stringLen[5];      // tenant, subscriptionId, protocolString, ip, rest - zero-terminator included, 0 for NULL
+} SpillRecord;
+
+
+
+static int      spillFd     = -1;
+static char*    spillMap    = NULL;
+static size_t   spillSize   = 0;
+static uint64_t spillPunched = SPILL_DATA_START;  // Holes have been punched up to here (not in the header - a restart starts over)
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spillHeader -
+//
+static inline SpillFileHeader* spillHeader(void)
+{
+  return (SpillFileHeader*) spillMap;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spillResize - change the size of the spill file and of its mapping
+//
+// When shrinking, the mapping is shrunk before the file, not to have any mapped page beyond the end of the file.
+//
+static bool spillResize(size_t size)
+{
+  if ((size > spillSize) && (ftruncate(spillFd, size) == -1))
+  {
+    LM_E(("Internal Error (unable to grow the notification spill file to %d bytes: %s)", (int) size, strerror(errno)));
+    return false;
+  }
+
+  void* mapP = (spillMap == NULL)? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, spillFd, 0) : mremap(spillMap, spillSize, size, MREMAP_MAYMOVE);
+
+  if (mapP == MAP_FAILED)
+  {
+    LM_E(("Internal Error (unable to map the notification spill file (%d bytes): %s)", (int) size, strerror(errno)));
+    return false;
+  }
+
+  spillMap = (char*) mapP;
+
+  if ((size < spillSize) && (ftruncate(spillFd, size) == -1))
+    LM_W(("Unable to shrink the notification spill file: %s", strerror(errno)));
+
+  spillSize = size;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spillRewind - all notifications have been replayed - start the log over
+//
+static void spillRewind(void)
+{
+  spillHeader()->readOffset  = SPILL_DATA_START;
+  spillHeader()->writeOffset = SPILL_DATA_START;
+  spillHeader()->wrapOffset  = 0;
+  spillPunched               = SPILL_DATA_START;
+
+  if (spillSize > SPILL_SEGMENT_SIZE)
+    spillResize(SPILL_SEGMENT_SIZE);  // Giving the disk space back
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spillPunch - give back the disk space of the replayed part of the log, below 'offset'
+//
+// Done in steps of (at least) SPILL_PUNCH_SIZE, not to make a system call for each replayed notification.
+// The page that 'offset' is in is kept - it's (also) part of the next record.
+// If the log has wrapped around, the start of the data is in use again, up to writeOffset, and is kept as well.
+//
+static void spillPunch(uint64_t offset, bool force)
+{
+  static long pageSize = sysconf(_SC_PAGESIZE);
+  uint64_t    pageMask = (uint64_t) pageSize - 1;
+  uint64_t    end      = offset & ~pageMask;
+
+  if (spillHeader()->wrapOffset != 0)
+  {
+    uint64_t writeEnd = (spillHeader()->writeOffset + pageMask) & ~pageMask;
+
+    if (writeEnd > spillPunched)
+      spillPunched = writeEnd;
+  }
+
+  if ((end <= spillPunched) || ((force == false) && (end - spillPunched < SPILL_PUNCH_SIZE)))
+    return;
+
+  if (fallocate(spillFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, spillPunched, end - spillPunched) == -1)
+    LM_T(LmtNotificationSend, ("Unable to punch a hole in the notification spill file: %s", strerror(errno)));
+
+  spillPunched = end;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spillEnd - the end of the part of the log that 'offset' is in
+//
+static inline uint64_t spillEnd(uint64_t offset)
+{
+  SpillFileHeader* headerP = spillHeader();
+
+  if ((headerP->wrapOffset != 0) && (offset >= headerP->readOffset))
+    return headerP->wrapOffset;
+
+  return headerP->writeOffset;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spillEmpty -
+//
+static inline bool spillEmpty(void)
+{
+  return (spillHeader()->wrapOffset == 0) && (spillHeader()->readOffset == spillHeader()->writeOffset);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spillRecordParse - find the strings and the iovecs of a record, checking that they don't go beyond the record
+//
+static bool spillRecordParse(uint64_t offset, SpillRecord** recordPP, char** stringV, struct iovec* ioVec)
+{
+  SpillRecord* recordP = (SpillRecord*) &spillMap[offset];
+  uint64_t     end     = spillEnd(offset);
+
+  if ((offset + sizeof(SpillRecord) > end) || (recordP->magic != SPILL_RECORD_MAGIC))
+    return false;
+
+  if ((recordP->size < sizeof(SpillRecord)) || (offset + recordP->size > end) || (recordP->ioVecLen > SPILL_IOVECS_MAX))
+    return false;
+
+  char* nextP = (char*) &recordP[1];
+  char* endP  = &spillMap[offset + recordP->size];
+
+  for (int ix = 0; ix < 5; ix++)
+  {
+    uint32_t len = recordP->stringLen[ix];
+
+    if ((nextP + len > endP) || ((len != 0) && (nextP[len - 1] != 0)))
+      return false;
+
+    stringV[ix] = (len != 0)? nextP : NULL;
+    nextP      += len;
+  }
+
+  if (stringV[1] == NULL)  // subscriptionId
+    return false;
+
+  for (uint32_t ix = 0; ix < recordP->ioVecLen; ix++)
+  {
+    uint32_t len;
+
+    if (nextP + sizeof(len) > endP)
+      return false;
+
+    memcpy(&len, nextP, sizeof(len));
+    nextP += sizeof(len);
+
+    if (nextP + len > endP)
+      return false;
+
+    ioVec[ix].iov_base = nextP;
+    ioVec[ix].iov_len  = len;
+    nextP             += len;
+  }
+
+  *recordPP = recordP;
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// spillCorrupt - a record that doesn't make sense - the rest of the log is lost
+//
+static void spillCorrupt(uint64_t offset)
+{
+  SpillFileHeader* headerP = spillHeader();
+
+  LM_E(("Internal Error (corrupt notification spill file at offset %d - the spilled notifications from there on are discarded)", (int) offset));
+
+  // Whatever comes after the corrupt record is lost - if it's in front of the wrap, so is the part after the wrap
+  headerP->writeOffset = offset;
+  if ((headerP->wrapOffset != 0) && (offset >= headerP->readOffset))
+    headerP->wrapOffset = 0;
+
+  if (spillEmpty() == true)
+    spillRewind();
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillOpen -
+//
+bool notificationSpillOpen(const char* path)
+{
+  spillFd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (spillFd == -1)
+  {
+    LM_E(("Unable to open the notification spill file '%s': %s", path, strerror(errno)));
+    return false;
+  }
+
+  struct stat statBuf;
+  if (fstat(spillFd, &statBuf) == -1)
+  {
+    LM_E(("Unable to stat the notification spill file '%s': %s", path, strerror(errno)));
+    return false;
+  }
+
+  size_t size = ((statBuf.st_size + SPILL_SEGMENT_SIZE - 1) / SPILL_SEGMENT_SIZE) * SPILL_SEGMENT_SIZE;
+
+  if (size == 0)
+    size = SPILL_SEGMENT_SIZE;
+
+  if (spillResize(size) == false)
+    return false;
+
+  SpillFileHeader* headerP = spillHeader();
+
+  //
+  // The header fields are updated one by one - a crash in between a wrap-around (or its end) leaves one of them behind
+  //
+  if ((headerP->wrapOffset != 0) && (headerP->writeOffset == headerP->wrapOffset))    // Wrapped, the new end not set
+    headerP->writeOffset = SPILL_DATA_START;                                          // The one record written after the wrap is lost
+  if ((headerP->wrapOffset != 0) && (headerP->readOffset == headerP->wrapOffset))    // At the end of the wrapped part, not unwrapped
+    headerP->readOffset = SPILL_DATA_START;
+  if ((headerP->wrapOffset != 0) && (headerP->readOffset == SPILL_DATA_START))        // Unwrapped, wrapOffset not reset
+    headerP->wrapOffset = 0;
+
+  bool wrapped = (headerP->wrapOffset != 0);
+
+  if ((memcmp(headerP->magic, SPILL_FILE_MAGIC, sizeof(SPILL_FILE_MAGIC)) != 0)       ||
+      (headerP->readOffset  < SPILL_DATA_START)                                       ||
+      (headerP->writeOffset < SPILL_DATA_START)                                       ||
+      ((wrapped == false) && (headerP->readOffset  > headerP->writeOffset))           ||
+      ((wrapped == false) && (headerP->writeOffset > spillSize))                      ||
+      ((wrapped == true)  && (headerP->writeOffset > headerP->readOffset))            ||
+      ((wrapped == true)  && (headerP->readOffset  > headerP->wrapOffset))            ||
+      ((wrapped == true)  && (headerP->wrapOffset  > spillSize)))
+  {
+    if (statBuf.st_size != 0)
+      LM_W(("The notification spill file '%s' is not valid - starting it over", path));
+
+    memcpy(headerP->magic, SPILL_FILE_MAGIC, sizeof(SPILL_FILE_MAGIC));
+    spillRewind();
+  }
+
+  LM_T(LmtNotificationSend, ("Notification spill file '%s': spilled notifications from offset %d", path, (int) spillHeader()->readOffset));
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillAppend -
+//
+bool notificationSpillAppend(NotificationJob* jobP, double firstFailure)
+{
+  if (spillMap == NULL)
+    return false;
+
+  const char*  stringV[5] = { jobP->tenant, jobP->subscriptionId, jobP->protocolString, jobP->ip, jobP->rest };
+  SpillRecord  record;
+  uint64_t     size       = sizeof(SpillRecord);
+
+  for (int ix = 0; ix < 5; ix++)
+  {
+    record.stringLen[ix] = (stringV[ix] != NULL)? strlen(stringV[ix]) + 1 : 0;
+    size += record.stringLen[ix];
+  }
+
+  for (int ix = 0; ix < jobP->ioVecLen; ix++)
+  {
+    size += sizeof(uint32_t) + jobP->ioVec[ix].iov_len;
+  }
+
+  size = (size + 7) & ~7ULL;
+
+  SpillFileHeader* headerP = spillHeader();
+  uint64_t         offset  = headerP->writeOffset;
+  bool             wrap    = false;
+
+  if (headerP->wrapOffset != 0)
+  {
+    if (offset + size > headerP->readOffset)  // Wrapped - the room is what's in front of readOffset
+    {
+      LM_W(("%s: the notification spill file is full - notification dropped", jobP->subscriptionId));
+      return false;
+    }
+  }
+  else if (offset + size > spillSize)
+  {
+    uint64_t newSize = ((offset + size + SPILL_SEGMENT_SIZE - 1) / SPILL_SEGMENT_SIZE) * SPILL_SEGMENT_SIZE;
+
+    if (newSize <= SPILL_SIZE_MAX)
+    {
+      if (spillResize(newSize) == false)
+        return false;
+
+      headerP = spillHeader();  // The file may have been mapped elsewhere
+    }
+    else if (SPILL_DATA_START + size <= headerP->readOffset)  // Wrapping around, in front of the replayed part
+    {
+      offset = SPILL_DATA_START;
+      wrap   = true;
+    }
+    else
+    {
+      LM_W(("%s: the notification spill file is full - notification dropped", jobP->subscriptionId));
+      return false;
+    }
+  }
+
+  record.magic            = SPILL_RECORD_MAGIC;
+  record.size             = size;
+  record.firstFailure     = firstFailure;
+  record.notificationTime = jobP->notificationTime;
+  record.protocol         = jobP->protocol;
+  record.port             = jobP->port;
+  record.ioVecLen         = jobP->ioVecLen;
+
+  char* recordP = &spillMap[offset];
+  char* nextP   = &recordP[sizeof(SpillRecord)];
+
+  memcpy(recordP, &record, sizeof(SpillRecord));
+
+  for (int ix = 0; ix < 5; ix++)
+  {
+    memcpy(nextP, stringV[ix], record.stringLen[ix]);
+    nextP += record.stringLen[ix];
+  }
+
+  for (int ix = 0; ix < jobP->ioVecLen; ix++)
+  {
+    uint32_t len = jobP->ioVec[ix].iov_len;
+
+    memcpy(nextP, &len, sizeof(len));
+    nextP += sizeof(len);
+    memcpy(nextP, jobP->ioVec[ix].iov_base, len);
+    nextP += len;
+  }
+
+  if (wrap == true)
+    headerP->wrapOffset = headerP->writeOffset;  // The record is complete before it's reachable
+  headerP->writeOffset = offset + size;
+
+  //
+  // Scheduling the write-back of the record and of the header
+  //
+  static long pageSize = sysconf(_SC_PAGESIZE);
+  uint64_t    start    = offset & ~((uint64_t) pageSize - 1);
+
+  msync(&spillMap[start], offset + size - start, MS_ASYNC);
+  msync(spillMap, sizeof(SpillFileHeader), MS_ASYNC);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillPeek -
+//
+bool notificationSpillPeek(char** tenantP, char** subscriptionIdP)
+{
+  if ((spillMap == NULL) || (spillEmpty() == true))
+    return false;
+
+  uint64_t      offset = spillHeader()->readOffset;
+  SpillRecord*  recordP;
+  char*         stringV[5];
+  struct iovec  ioVec[SPILL_IOVECS_MAX];
+
+  if (spillRecordParse(offset, &recordP, stringV, ioVec) == false)
+  {
+    spillCorrupt(offset);
+    return false;
+  }
+
+  *tenantP         = stringV[0];
+  *subscriptionIdP = stringV[1];
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillPop -
+//
+NotificationJob* notificationSpillPop(double* firstFailureP)
+{
+  if ((spillMap == NULL) || (spillEmpty() == true))
+    return NULL;
+
+  uint64_t      offset = spillHeader()->readOffset;
+  SpillRecord*  recordP;
+  char*         stringV[5];
+  struct iovec  ioVec[SPILL_IOVECS_MAX];
+
+  if (spillRecordParse(offset, &recordP, stringV, ioVec) == false)
+  {
+    spillCorrupt(offset);
+    return NULL;
+  }
+
+  NotificationJob* jobP = notificationJobBuild(stringV[0],
+                                               stringV[1],
+                                               stringV[2],
+                                               (Protocol) recordP->protocol,
+                                               stringV[3],
+                                               recordP->port,
+                                               stringV[4],
+                                               ioVec,
+                                               recordP->ioVecLen,
+                                               recordP->notificationTime);
+
+  if (jobP == NULL)
+    LM_E(("Out of memory (replaying a spilled notification for subscription '%s')", stringV[1]));
+
+  *firstFailureP = recordP->firstFailure;
+
+  SpillFileHeader* headerP = spillHeader();
+
+  headerP->readOffset = offset + recordP->size;
+
+  if ((headerP->wrapOffset != 0) && (headerP->readOffset == headerP->wrapOffset))
+  {
+    // The end of the wrapped part - the rest of the log is at the start of the data
+    spillPunch(headerP->wrapOffset, true);
+    headerP->readOffset = SPILL_DATA_START;
+    headerP->wrapOffset = 0;
+    spillPunched        = SPILL_DATA_START;
+  }
+
+  if (spillEmpty() == true)
+    spillRewind();
+  else
+    spillPunch(headerP->readOffset, false);
+
+  return jobP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillForEach -
+//
+int notificationSpillForEach(void (*callback)(const char* tenant, const char* subscriptionId))
+{
+  if (spillMap == NULL)
+    return 0;
+
+  uint64_t offset  = spillHeader()->readOffset;
+  bool     wrapped = (spillHeader()->wrapOffset != 0);  // Two parts: [readOffset, wrapOffset) and then [SPILL_DATA_START, writeOffset)
+  int      records = 0;
+
+  while (true)
+  {
+    if ((wrapped == true) && (offset == spillHeader()->wrapOffset))
+    {
+      offset  = SPILL_DATA_START;
+      wrapped = false;
+    }
+
+    if ((wrapped == false) && (offset >= spillHeader()->writeOffset))
+      break;
+
+    SpillRecord*  recordP;
+    char*         stringV[5];
+    struct iovec  ioVec[SPILL_IOVECS_MAX];
+
+    if (spillRecordParse(offset, &recordP, stringV, ioVec) == false)
+    {
+      spillCorrupt(offset);
+      break;
+    }
+
+    callback(stringV[0], stringV[1]);
+
+    offset += recordP->size;
+    ++records;
+  }
+
+  return records;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillClose -
+//
+void notificationSpillClose(void)
+{
+  if (spillMap != NULL)
+  {
+    msync(spillMap, spillSize, MS_SYNC);
+    munmap(spillMap, spillSize);
+  }
+
+  if (spillFd != -1)
+    close(spillFd);
+
+  spillMap  = NULL;
+  spillSize = 0;
+  spillFd   = -1;
+}
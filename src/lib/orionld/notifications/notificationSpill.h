@@ -0,0 +1,83 @@
+#ifndef SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONSPILL_H_
+#define SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONSPILL_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillOpen - open (or create) the spill file of the retry queue and map it into memory
+//
+extern bool notificationSpillOpen(const char* path);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillAppend - append a notification job at the end of the spill file
+//
+extern bool notificationSpillAppend(NotificationJob* jobP, double firstFailure);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillPeek - tenant and subscription id of the oldest notification in the spill file
+//
+// The strings point into the mapped file and are valid until the next call to notificationSpillAppend.
+// Returns false if the spill file is empty.
+//
+extern bool notificationSpillPeek(char** tenantP, char** subscriptionIdP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillPop - remove the oldest notification from the spill file, as a new (malloc'd) NotificationJob
+//
+extern NotificationJob* notificationSpillPop(double* firstFailureP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillForEach - call 'callback' for each notification in the spill file, oldest first
+//
+// Returns the number of notifications in the spill file.
+//
+extern int notificationSpillForEach(void (*callback)(const char* tenant, const char* subscriptionId));
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationSpillClose -
+//
+extern void notificationSpillClose(void);
+
+#endif  // SRC_LIB_ORIONLD_NOTIFICATIONS_NOTIFICATIONSPILL_H_
@@ -22,6 +22,8 @@
 *
 * Author: Ken Zangelin
 */
+#include <stdint.h>                                                 // uint32_t
+
 #include "logMsg/logMsg.h"                                          // LM_*
 #include "logMsg/traceLevels.h"                                     // LmtNotificationStats
 
@@ -29,7 +31,7 @@
 
 #include "orionld/common/orionldState.h"                            // promNotifications
 #include "orionld/prometheus/promCounterIncrease.h"                 // promCounterIncrease
-#include "orionld/mongoc/mongocSubCountersUpdate.h"                 // mongocSubCountersUpdate
+#include "orionld/notifications/notificationCountersFlush.h"        // notificationCountersFlush
 #include "orionld/notifications/notificationSuccess.h"              // Own interface
 
 
@@ -42,11 +44,16 @@ void notificationSuccess(CachedSubscription* subP, const double timestamp)
 {
   LM_T(LmtNotificationStats, ("%s: notification success (sub at %p)", subP->subscriptionId, subP));
 
-  subP->lastSuccess           = timestamp;
-  subP->lastNotificationTime  = timestamp;
-  subP->consecutiveErrors     = 0;
-  subP->count                += 1;
-  subP->dirty                += 1;
+  //
+  // The counters are updated without any lock - several threads may account notifications for the same
+  // subscription at the same time (notification workers, the request threads and the sub-cache refresh)
+  //
+  __atomic_store(&subP->lastSuccess,          &timestamp, __ATOMIC_RELAXED);
+  __atomic_store(&subP->lastNotificationTime, &timestamp, __ATOMIC_RELAXED);
+  __atomic_store_n(&subP->consecutiveErrors, 0, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&subP->count, 1, __ATOMIC_RELAXED);
+
+  uint32_t dirty = __atomic_add_fetch(&subP->dirty, 1, __ATOMIC_RELAXED);
 
   promCounterIncrease(promNotifications);
 
@@ -55,22 +62,13 @@ void notificationSuccess(CachedSubscription* subP, const double timestamp)
   // - If subP->dirty (number of counter updates since last flush) >= cSubCounters
   //   - AND cSubCounters != 0
   //
-  LM_T(LmtNotificationStats, ("%s: dirty: %d AND cSubCounters=%d", subP->subscriptionId, subP->dirty, cSubCounters));
-
-  if ((cSubCounters != 0) && (subP->dirty >= cSubCounters))
-  {
-    LM_T(LmtNotificationStats, ("%s: Calling mongocSubCountersUpdate", subP->subscriptionId));
+  LM_T(LmtNotificationStats, ("%s: dirty: %d AND cSubCounters=%d", subP->subscriptionId, dirty, cSubCounters));
 
-    mongocSubCountersUpdate(subP->tenantP, subP->subscriptionId, (subP->ldContext != ""), subP->count, subP->failures, 0, subP->lastNotificationTime, subP->lastSuccess, subP->lastFailure, false);
-    subP->dirty       = 0;
-    subP->dbCount    += subP->count;
-    subP->count       = 0;
-    subP->dbFailures += subP->failures;
-    subP->failures    = 0;
-  }
+  if ((cSubCounters != 0) && (dirty >= (uint32_t) cSubCounters))
+    notificationCountersFlush(subP, false);
   else
     LM_T(LmtNotificationStats, ("%s: Not calling mongocSubCountersUpdate (cSubCounters: %d, dirty: %d)",
                                 subP->subscriptionId,
                                 cSubCounters,
-                                subP->dirty));
+                                dirty));
 }
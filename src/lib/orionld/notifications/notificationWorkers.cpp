@@ -0,0 +1,169 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc, free
+#include <pthread.h>                                             // pthread_create, pthread_join
+
+extern "C"
+{
+#include "kalloc/kaBufferReset.h"                                // kaBufferReset
+#include "kjson/kjBufferCreate.h"                                // kjBufferCreate
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+#include "orionld/common/orionldState.h"                         // orionldState, orionldStateInit
+#include "orionld/notifications/notificationQueue.h"             // notificationQueue*
+#include "orionld/notifications/notificationJobSend.h"           // notificationJobSend, notificationJobAccount
+#include "orionld/notifications/notificationRetry.h"             // notificationRetryEnqueue
+#include "orionld/notifications/notificationWorkers.h"           // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationWorkers -
+//
+int                   notificationWorkers = 0;
+static pthread_t*     workerV             = NULL;
+static volatile bool  workersStop         = false;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationWorker -
+//
+static void* notificationWorker(void* vP)
+{
+  //
+  // orionldState is thread-local - its kalloc buffer is owned by the worker.
+  // All allocations of the job (rendering, reading the response, ...) are done with orionldState.kalloc/kjsonP,
+  // and the buffer is reset after each job
+  //
+  orionldStateInit(NULL);
+
+  LM_T(LmtNotificationSend, ("Notification worker %d is running", (int) (long) vP));
+
+  while (workersStop == false)
+  {
+    notificationQueueWait();
+
+    NotificationJob* jobP;
+    while ((jobP = notificationQueuePop()) != NULL)
+    {
+      char  errorString[256];
+      bool  ok;
+
+      errorString[0] = 0;
+
+      ok = notificationJobSend(jobP, errorString, sizeof(errorString));
+      notificationJobAccount(jobP, ok, errorString);
+
+      if ((ok == false) && (notificationRetryEnqueue(jobP) == true))
+        jobP = NULL;  // The retry queue owns the job now
+
+      free(jobP);
+
+      kaBufferReset(&orionldState.kalloc, true);
+      orionldState.kjsonP = kjBufferCreate(&orionldState.kjson, &orionldState.kalloc);
+    }
+  }
+
+  LM_T(LmtNotificationSend, ("Notification worker %d is exiting", (int) (long) vP));
+  orionldStateRelease();
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationWorkersStart -
+//
+bool notificationWorkersStart(int queueSize, int workers)
+{
+  if (notificationQueueInit(queueSize) == false)
+    return false;
+
+  workerV = (pthread_t*) malloc(workers * sizeof(pthread_t));
+  if (workerV == NULL)
+  {
+    LM_E(("Out of memory allocating %d notification worker threads", workers));
+    return false;
+  }
+
+  for (long ix = 0; ix < workers; ix++)
+  {
+    int s = pthread_create(&workerV[ix], NULL, notificationWorker, (void*) ix);
+
+    if (s != 0)
+    {
+      LM_E(("Runtime Error (error creating notification worker thread: %d)", s));
+      return false;
+    }
+
+    ++notificationWorkers;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// notificationWorkersStop -
+//
+// Jobs that are in the queue and not yet picked up by any worker are lost
+//
+void notificationWorkersStop(void)
+{
+  NotificationQueueStats stats;
+
+  if (workerV == NULL)
+    return;
+
+  workersStop = true;
+
+  for (int ix = 0; ix < notificationWorkers; ix++)
+  {
+    notificationQueueWakeup();
+  }
+
+  for (int ix = 0; ix < notificationWorkers; ix++)
+  {
+    pthread_join(workerV[ix], NULL);
+  }
+
+  notificationQueueStatsGet(&stats);
+  LM_T(LmtNotificationSend, ("Notification queue: %d in, %d out, %d dropped", (int) stats.in, (int) stats.out, (int) stats.drops));
+
+  notificationWorkers = 0;
+  notificationQueueRelease();
+  free(workerV);
+  workerV = NULL;
+}
@@ -22,10 +22,11 @@
 *
 * Author: Ken Zangelin
 */
+#include <vector>                                              // std::vector
+
 extern "C"
 {
 #include "kbase/kMacros.h"                                     // K_FT
-#include "kalloc/kaStrdup.h"                                   // kaStrdup
 #include "kjson/KjNode.h"                                      // KjNode
 #include "kjson/kjLookup.h"                                    // kjLookup
 }
@@ -33,18 +34,26 @@ extern "C"
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // LmtWatchedAttributes
 
-#include "common/sem.h"                                        // cacheSemTake, cacheSemGive
 #include "cache/subCache.h"                                    // CachedSubscription, subCacheMatch, tenantMatch
+#include "cache/subCacheIndex.h"                               // subCacheIndexCandidates
+#include "epoch/epoch.h"                                       // epochEnter, epochLeave
 
 #include "orionld/types/QNode.h"                               // QNode, qNodeType
+#include "orionld/types/QCompiled.h"                           // QCompiled
+#include "orionld/types/GeoCompiled.h"                         // GeoCompiled
 #include "orionld/types/OrionldAlteration.h"                   // OrionldAlteration, OrionldAlterationMatch, orionldAlterationType
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/common/dotForEq.h"                           // dotForEq
-#include "orionld/common/pathComponentsSplit.h"                // pathComponentsSplit
-#include "orionld/common/eqForDot.h"                           // eqForDot
-#include "orionld/common/dateTime.h"                           // dateTimeFromString
 #include "orionld/q/qBuild.h"                                  // qBuild
+#include "orionld/q/qRelease.h"                                // qRelease
+#include "orionld/q/qCompile.h"                                // qCompile
+#include "orionld/q/qCompiledMatch.h"                          // qCompiledMatch
+#include "orionld/q/qCompiledRelease.h"                        // qCompiledRelease
 #include "orionld/q/qPresent.h"                                // qPresent
+#include "orionld/dbModel/dbModelToApiCoordinates.h"           // dbModelToApiCoordinates
+#include "orionld/geo/geoCompile.h"                            // geoCompile
+#include "orionld/geo/geoCompiledMatch.h"                      // geoCompiledMatch
+#include "orionld/geo/geoCompiledRelease.h"                    // geoCompiledRelease
 #include "orionld/notifications/subCacheAlterationMatch.h"     // Own interface
 
 
@@ -441,668 +450,85 @@ static OrionldAlterationMatch* attributeMatch(OrionldAlterationMatch* matchList,
 
 // -----------------------------------------------------------------------------
 //
-// dotCount - count number of dots in a string (no of components in a path)
-//
-static int dotCount(char* s)
-{
-  int dots = 0;
-
-  while (*s != 0)
-  {
-    if (*s == '.')
-      ++dots;
-    ++s;
-  }
-
-  return dots;
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// kjNavigate - true Kj-Tree navigation
+// subQTreeBuild - build the q-tree of a cached subscription and publish it in the subscription
 //
-static KjNode* kjNavigate(KjNode* treeP, char** compV)
+static QNode* subQTreeBuild(CachedSubscription* subP)
 {
-  KjNode* hitP = kjLookup(treeP, compV[0]);
+  QNode* qP       = qBuild(subP->qText, NULL, NULL, NULL, false, false);
+  QNode* expected = NULL;
 
-  if (hitP == NULL)
+  if (qP == NULL)
     return NULL;
 
-  if (compV[1] == NULL)
-    return hitP;
-
-  return kjNavigate(hitP, &compV[1]);
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// kjNavigate2 - prepared for db-model, but also OK without
-//
-static KjNode* kjNavigate2(KjNode* treeP, char* path, bool* isTimestampP)
-{
-  int components = dotCount(path) + 1;
-  if (components > 20)
-    LM_X(1, ("The current implementation of Orion-LD can only handle 20 levels of tree navigation"));
-
-  char* compV[20];
-
-  // pathComponentsSplit destroys the path, I need to work on a copy
-  char* pathCopy = kaStrdup(&orionldState.kalloc, path);
-  components = pathComponentsSplit(pathCopy, compV);
-
-  //
-  // - the first component is always the longName of the ATTRIBUTE
-  // - the second is either "value", "object", "languageMap", or the longName of the SUB-ATTRIBUTE
-  //
-  // 'attrs' and 'md' don't exist in an API entity and must be nulled out here.
-  //
-
-  //
-  // Is it a timestamp?   (if so, an ISO8601 string must be turned into a float/integer to be compared
-  //
-  char* lastComponent = compV[components - 1];
-  if ((strcmp(lastComponent, "observedAt") == 0) || (strcmp(lastComponent, "modifiedAt") == 0) || (strcmp(lastComponent, "createdAt") == 0))
-    *isTimestampP = true;
-  else
-    *isTimestampP = false;
-
-  compV[components] = NULL;
-
-  KjNode* result = kjNavigate(treeP, compV);
-  if (result != NULL)
-    return result;
-
-  //
-  // Nothing found
-  //
-  //   What if it's due to '.' vs '=' ...
-  //   Yes, I know, this is messy, some order is needed
-  //
-  // FIXME: Fix this!
-  //
-  eqForDot(compV[0]);  // As it IS an Attribute
-  eqForDot(compV[1]);  // As it MIGHT be a Sub-Attribute (and if not, it has no '=')
-
-  result = kjNavigate(treeP, compV);
-  if (result != NULL)
-    return result;
-
-  //
-  // Could be a Relationship ...
-  // Perhaps I should "bake in" the value|object|languageMap inside kjNavigate ...
-  //
-  if ((components == 2) && (strcmp(compV[1], "value") == 0))
-  {
-    compV[1] = (char*) "object";
-    result = kjNavigate(treeP, compV);
-    if (result != NULL)
-      return result;
-
-    // FIXME: Here I put the '=' back ... Even messier now :(
-    dotForEq(compV[0]);
-    result = kjNavigate(treeP, compV);
-    if (result != NULL)
-      return result;
-  }
-
-  return NULL;
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// qRangeCompare -
-//
-static bool qRangeCompare(KjNode* lhsNode, QNode* rhs, bool isTimestamp)
-{
-  QNode* low  = rhs->value.children;
-
-  if (low == NULL)
-    return false;
-
-  QNode* high = low->next;
-
-  if (high == NULL)
-    return false;
-
-  if (isTimestamp)
-  {
-    char errorString[256];
-
-    double lhsTimestamp  = dateTimeFromString(lhsNode->value.s, errorString, sizeof(errorString));
-    double lowTimestamp  = (low->type == QNodeFloatValue)? low->value.f :  dateTimeFromString(low->value.s, errorString, sizeof(errorString));
-    double highTimestamp = dateTimeFromString(high->value.s, errorString, sizeof(errorString));
-
-    if ((lhsTimestamp < 0) || (lowTimestamp < 0) || (highTimestamp < 0))
-      LM_RE(false, ("Invalid ISO8601 timestamp: %s", errorString));
-
-    if ((lhsTimestamp >= lowTimestamp) && (lhsTimestamp <= highTimestamp))
-      return true;
-
-    return false;
-  }
-
-  if (lhsNode->type == KjInt)
-  {
-    if (low->type == QNodeIntegerValue)
-    {
-      if (lhsNode->value.i < low->value.i)
-        return false;
-    }
-    else if (low->type == QNodeFloatValue)
-    {
-      if ((double) lhsNode->value.i < low->value.f)
-        return false;
-    }
-    else
-      return false;  // type mismatch
-
-    if (high->type == QNodeIntegerValue)
-    {
-      if (lhsNode->value.i > high->value.i)
-        return false;
-    }
-    else if (high->type == QNodeFloatValue)
-    {
-      if ((double) lhsNode->value.i > high->value.f)
-        return false;
-    }
-    else
-      return false;  // type mismatch
-
-    return true;
-  }
-
-  if (lhsNode->type == KjFloat)
-  {
-    if (low->type == QNodeFloatValue)
-    {
-      if (lhsNode->value.f < low->value.f)
-        return false;
-    }
-    else if (low->type == QNodeIntegerValue)
-    {
-      if (lhsNode->value.f < (double) low->value.i)
-        return false;
-    }
-    else
-      return false;  // type mismatch
-
-    if (high->type == QNodeFloatValue)
-    {
-      if (lhsNode->value.f > high->value.f)
-        return false;
-    }
-    else if (high->type == QNodeIntegerValue)
-    {
-      if (lhsNode->value.f > (double) high->value.i)
-        return false;
-    }
-    else
-      return false;  // type mismatch
-
-    return true;
-  }
-
-  if (lhsNode->type == KjString)
-  {
-    if (low->type == QNodeStringValue)
-    {
-      if (strcmp(lhsNode->value.s, low->value.s)  < 0)
-        return false;
-      if (strcmp(lhsNode->value.s, high->value.s) > 0)
-        return false;
-
-      return true;
-    }
-
-    return false;  // type mismatch
-  }
-
-  // Timestamp!
-
-  return false;  // RANGES operate only on Numbers, Strings and Timestamps
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// intComparison
-//
-bool intComparison(long long lhs, QNode* rhs)
-{
-  if      (rhs->type == QNodeIntegerValue)  return lhs == rhs->value.i;
-  else if (rhs->type == QNodeFloatValue)    return ((double) lhs) == rhs->value.f;
-
-  return false;
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// floatComparison
-//
-bool floatComparison(KjNode* lhsP, QNode* rhs, bool isTimestamp)
-{
-  if (isTimestamp == false)
-  {
-    double lhs = lhsP->value.f;
-
-    if      (rhs->type == QNodeFloatValue)    return lhs == rhs->value.f;  // precision for float comparison??
-    else if (rhs->type == QNodeIntegerValue)  return lhs == (double) rhs->value.i;
-    else                                      return false;
-  }
-
-  if (rhs->type == QNodeStringValue)
-  {
-    char   errorString[256];
-    double rhsTimestamp = dateTimeFromString(rhs->value.s, errorString, sizeof(errorString));
-
-    if (lhsP->value.f == rhsTimestamp)
-      return true;
-  }
-
-  return false;
-}
-
-
-// -----------------------------------------------------------------------------
-//
-// boolComparison
-//
-bool boolComparison(bool lhs, QNode* rhs)
-{
-  if ((lhs == true) && (rhs->type == QNodeTrueValue))
-    return true;
-
-  if ((lhs == false) && (rhs->type == QNodeFalseValue))
-    return true;
-
-  return false;
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// stringComparison
-//
-bool stringComparison(KjNode* lhsP, QNode* rhs, bool isTimestamp)
-{
-  if (rhs->type != QNodeStringValue)
-    return false;
-
-  if (isTimestamp)  // Then LHS is a Float?
-  {
-    char   errorString[256];
-    double rhsTimestamp = dateTimeFromString(rhs->value.s, errorString, sizeof(errorString));
-
-    return (lhsP->value.f == rhsTimestamp);
-  }
-
-  if (rhs->type != QNodeStringValue)
-    return false;
-
-  return (strcmp(lhsP->value.s, rhs->value.s) == 0);
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// qCommaListCompare -
-//
-bool qCommaListCompare(KjNode* lhsNode, QNode* rhs, bool isTimestamp)
-{
-  if (isTimestamp == true)  // The first in the list id a FLOAT, the rest need to be converted to float
+  if (__atomic_compare_exchange_n(&subP->qP, &expected, qP, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) == false)
   {
-    double timestamp;
-    char   errorString[256];
-
-    if (lhsNode->type == KjFloat)
-      timestamp = lhsNode->value.f;
-    else if (lhsNode->type == KjString)
-      timestamp = dateTimeFromString(lhsNode->value.s, errorString, sizeof(errorString));
-    else
-      return false;
-
-    QNode* child1 = rhs->value.children;
-
-    if (child1->type != QNodeFloatValue)
-      LM_E(("CLIST: Internal Error (LHS is a timestamp but the first in the RHS list is not a FLOAT ..."));
-    else if (child1->value.f == timestamp)
-      return true;
-
-    // Compare the rest of the children in the comma list (converting them to FLOAT)
-    for (QNode* rhP = child1->next; rhP != NULL; rhP = rhP->next)
-    {
-      if (rhP->type == QNodeFloatValue)
-      {
-        if (rhP->value.f == timestamp)
-          return true;
-      }
-      else if (rhP->type == QNodeStringValue)
-      {
-        char   errorString[256];
-        double rhsTimestamp = dateTimeFromString(rhP->value.s, errorString, sizeof(errorString));
-
-        if (rhsTimestamp == timestamp)
-          return true;
-      }
-    }
-
-    return false;
+    // Another thread was faster - use its q-tree
+    qRelease(qP);
+    return expected;
   }
 
-  for (QNode* rhP = rhs->value.children; rhP != NULL; rhP = rhP->next)
-  {
-    switch (lhsNode->type)
-    {
-    case KjInt:     if (intComparison(lhsNode->value.i,    rhP)              == true) return true; break;
-    case KjFloat:   if (floatComparison(lhsNode,           rhP, isTimestamp) == true) return true; break;  // isTimestamp - then LHS is turned into a Float ... Right?
-    case KjString:  if (stringComparison(lhsNode,          rhP, isTimestamp) == true) return true; break;  //               Can't be both - need to test empirically
-    case KjBoolean: if (boolComparison(lhsNode->value.b,   rhP)              == true) return true; break;
-    default:
-      break;
-    }
-  }
-
-  return false;
+  return qP;
 }
 
 
 
 // -----------------------------------------------------------------------------
 //
-// qEqCompare -
+// subQCompiledBuild - compile the q-tree of a cached subscription and publish it in the subscription
 //
-bool qEqCompare(KjNode* lhsNode, QNode* rhs, bool isTimestamp)
+static QCompiled* subQCompiledBuild(CachedSubscription* subP)
 {
-  //
-  // Might be a timestamp ... (observedAt, modifiedAt, or createdAt)
-  //
-  if (isTimestamp == true)
-  {
-    // lhsNode must be a string, and a valid ISO8601 at that
-    if (lhsNode->type != KjString)
-      return false;
+  QNode* qP = __atomic_load_n(&subP->qP, __ATOMIC_ACQUIRE);
 
-    char   errorString[256];
-    double timestamp = dateTimeFromString(lhsNode->value.s, errorString, sizeof(errorString));
+  if (qP == NULL)
+    qP = subQTreeBuild(subP);
 
-    if (rhs->type == QNodeIntegerValue)
-    {
-      long long ts = (long long) timestamp;
-      if (rhs->value.i == ts)
-        return true;
-
-      return false;
-    }
-    else if (rhs->type == QNodeFloatValue)
-    {
-      if (rhs->value.f == timestamp)
-        return true;
+  if (qP == NULL)
+    return NULL;
 
-      return false;
-    }
-  }
+  QCompiled* qcP      = qCompile(qP);
+  QCompiled* expected = NULL;
 
-  if (lhsNode->type == KjInt)
+  if (__atomic_compare_exchange_n(&subP->qcP, &expected, qcP, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) == false)
   {
-    if      (rhs->type == QNodeIntegerValue) return (lhsNode->value.i == rhs->value.i);
-    else if (rhs->type == QNodeFloatValue)   return (lhsNode->value.i == rhs->value.f);
+    // Another thread was faster - use its compiled q-filter
+    qCompiledRelease(qcP);
+    return expected;
   }
-  else if (lhsNode->type == KjFloat)
-  {
-    double margin = 0.000001;  // What margin should I use?
 
-    if (rhs->type == QNodeIntegerValue)
-    {
-      if ((lhsNode->value.f - margin < rhs->value.i) && (lhsNode->value.f + margin > rhs->value.i))
-        return true;
-    }
-    else if (rhs->type == QNodeFloatValue)
-    {
-      if ((lhsNode->value.f - margin < rhs->value.f) && (lhsNode->value.f + margin > rhs->value.f))
-        return true;
-    }
-  }
-  else if (lhsNode->type == KjString)
-  {
-    if (rhs->type == QNodeStringValue)
-      return (strcmp(lhsNode->value.s, rhs->value.s) == 0);
-  }
-  else if (lhsNode->type == KjBoolean)
-  {
-    if (rhs->type == QNodeTrueValue)       return (lhsNode->value.b == true);
-    if (rhs->type == QNodeFalseValue)      return (lhsNode->value.b == false);
-  }
-
-  return false;
+  return qcP;
 }
 
 
 
 // -----------------------------------------------------------------------------
 //
-// qGtCompare -
+// subGeoCompiledBuild - compile the geoQ of a cached subscription and publish it in the subscription
 //
-bool qGtCompare(KjNode* lhsNode, QNode* rhs, bool isTimestamp)
-{
-  //
-  // Might be a timestamp ... (observedAt, modifiedAt, or createdAt)
-  //
-  if (isTimestamp == true)
-  {
-    // lhsNode must be a string, and a valid ISO8601 at that
-    if (lhsNode->type != KjString)
-      return false;
-
-    char   errorString[256];
-    double timestamp = dateTimeFromString(lhsNode->value.s, errorString, sizeof(errorString));
-
-    if (rhs->type == QNodeIntegerValue)
-    {
-      long long ts = (long long) timestamp;
-      if (rhs->value.i < ts)
-        return true;
-
-      return false;
-    }
-    else if (rhs->type == QNodeFloatValue)
-    {
-      if (rhs->value.f < timestamp)
-        return true;
-
-      return false;
-    }
-  }
-
-  if (lhsNode->type == KjInt)
-  {
-    if      (rhs->type == QNodeIntegerValue) return (lhsNode->value.i > rhs->value.i);
-    else if (rhs->type == QNodeFloatValue)   return (lhsNode->value.i > rhs->value.f);
-  }
-  else if (lhsNode->type == KjFloat)
-  {
-    if      (rhs->type == QNodeIntegerValue) return (lhsNode->value.f > rhs->value.i);
-    else if (rhs->type == QNodeFloatValue)   return (lhsNode->value.f > rhs->value.f);
-  }
-  else if (lhsNode->type == KjString)
-  {
-    if (rhs->type == QNodeStringValue)
-      return (strcmp(lhsNode->value.s, rhs->value.s) > 0);  // "> 0" means first arg > second arg to strcmp
-  }
-  else if (lhsNode->type == KjBoolean)  // true > false ... ?
-  {
-    if (rhs->type == QNodeTrueValue)       return false;
-    if (rhs->type == QNodeFalseValue)      return (lhsNode->value.b == true);
-  }
-
-  return false;
-}
-
-
-
-// -----------------------------------------------------------------------------
+// Subscriptions that come from the legacy sub-cache-refresh have only the 'expression' (coords as a string, as in the DB)
 //
-// qLtCompare -
-//
-bool qLtCompare(KjNode* lhsNode, QNode* rhs, bool isTimestamp)
+static GeoCompiled* subGeoCompiledBuild(CachedSubscription* subP)
 {
-  //
-  // Might be a timestamp ... (observedAt, modifiedAt, or createdAt)
-  //
-  if (isTimestamp == true)
-  {
-    // lhsNode must be a string, and a valid ISO8601 at that
-    if (lhsNode->type != KjString)
-      return false;
-
-    char   errorString[256];
-    double timestamp = dateTimeFromString(lhsNode->value.s, errorString, sizeof(errorString));
-
-    if (rhs->type == QNodeIntegerValue)
-    {
-      long long ts = (long long) timestamp;
-      if (rhs->value.i > ts)
-        return true;
-
-      return false;
-    }
-    else if (rhs->type == QNodeFloatValue)
-    {
-      if (rhs->value.f > timestamp)
-        return true;
-
-      return false;
-    }
-  }
-
-  bool r = false;
-  if (lhsNode->type == KjInt)
-  {
-    if      (rhs->type == QNodeIntegerValue) r = (lhsNode->value.i < rhs->value.i);
-    else if (rhs->type == QNodeFloatValue)   r = (lhsNode->value.i < rhs->value.f);
-  }
-  else if (lhsNode->type == KjFloat)
-  {
-    if      (rhs->type == QNodeIntegerValue) r = (lhsNode->value.f < rhs->value.i);
-    else if (rhs->type == QNodeFloatValue)   r = (lhsNode->value.f < rhs->value.f);
-  }
-  else if (lhsNode->type == KjString)
-  {
-    if (rhs->type == QNodeStringValue)
-      r = (strcmp(lhsNode->value.s, rhs->value.s) < 0);  // "< 0" means first arg < second arg to strcmp
-  }
-  else if (lhsNode->type == KjBoolean)  // true > false ... ?
-  {
-    if (rhs->type == QNodeTrueValue)       r = false;
-    if (rhs->type == QNodeFalseValue)      r = (lhsNode->value.b == true);
-  }
-
-  return r;
-}
+  KjNode* coordinatesP = subP->geoCoordinatesP;
 
+  if ((coordinatesP == NULL) && (subP->expression.coords != ""))
+    coordinatesP = dbModelToApiCoordinates(subP->expression.coords.c_str());
 
+  GeoCompiled* gcP = geoCompile(subP->expression.geometry.c_str(), subP->expression.georel.c_str(), subP->expression.geoproperty.c_str(), coordinatesP);
 
-// -----------------------------------------------------------------------------
-//
-// qMatchCompare -
-//
-bool qMatchCompare(KjNode* lhsNode, QNode* rhs)
-{
-  //
-  // Create the REGEX in subCache - QNode might need a new QNodeValue
-  // Here: Use regexec
-  //
-  LM_W(("Not Implemented"));
-  return false;
-}
-
-
+  if (gcP == NULL)
+    return NULL;
 
-// -----------------------------------------------------------------------------
-//
-// qMatch - move to orionld/q/qMatch.h/cpp
-//
-bool qMatch(QNode* qP, OrionldAlteration* altP)
-{
-  if (qP->type == QNodeOr)
-  {
-    // If any of the children is a match, then it's a match
-    int childNo = 0;
-    for (QNode* childP = qP->value.children; childP != NULL; childP = childP->next)
-    {
-      if (qMatch(childP, altP) == true)
-        return true;
-      ++childNo;
-    }
-  }
-  else if (qP->type == QNodeAnd)
-  {
-    // If ALL of the children are a match, then it's a match
-    for (QNode* childP = qP->value.children; childP != NULL; childP = childP->next)
-    {
-      if (qMatch(childP, altP) == false)
-        return false;
-    }
+  GeoCompiled* expected = NULL;
 
-    return true;
-  }
-  else
+  if (__atomic_compare_exchange_n(&subP->geoCompiledP, &expected, gcP, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) == false)
   {
-    QNode* lhs = qP->value.children;        // variable-path
-    QNode* rhs = qP->value.children->next;  // constant (MULL for QNodeExists & QNodeNotExists
-
-    //
-    // Not OR nor AND => LHS is an  attribute from the entity
-    //
-    // Well, or a sub-attribute, or a fragment of its value ...
-    // Anyway, the attribute/sub-attribute must exist.
-    // If it does not, then the result is always "false" (except for the case "q=!P1", of course :))
-    //
-    bool     isTimestamp = false;
-    KjNode*  lhsNode     = kjNavigate2(altP->finalApiEntityP, lhs->value.v, &isTimestamp);
-
-    //
-    // If Left-Hand-Side does not exist - MATCH for op "NotExist" and No Match for all other operations
-    //
-    if (lhsNode == NULL)
-      return (qP->type == QNodeNotExists)? true : false;
-
-    if      (qP->type == QNodeNotExists)  return false;
-    else if (qP->type == QNodeExists)     return true;
-    else if (qP->type == QNodeEQ)
-    {
-      if      (rhs->type == QNodeRange)   return  qRangeCompare(lhsNode, rhs, isTimestamp);
-      else if (rhs->type == QNodeComma)   return  qCommaListCompare(lhsNode, rhs, isTimestamp);
-      else                                return  qEqCompare(lhsNode, rhs, isTimestamp);
-    }
-    else if (qP->type == QNodeNE)
-    {
-      if      (rhs->type == QNodeRange)   return !qRangeCompare(lhsNode, rhs, isTimestamp);
-      else if (rhs->type == QNodeComma)   return !qCommaListCompare(lhsNode, rhs, isTimestamp);
-      else                                return !qEqCompare(lhsNode, rhs, isTimestamp);
-    }
-    else if (qP->type == QNodeGT)         return  qGtCompare(lhsNode, rhs, isTimestamp);
-    else if (qP->type == QNodeLT)         return  qLtCompare(lhsNode, rhs, isTimestamp);
-    else if (qP->type == QNodeGE)         return !qLtCompare(lhsNode, rhs, isTimestamp);
-    else if (qP->type == QNodeLE)         return !qGtCompare(lhsNode, rhs, isTimestamp);
-    else if (qP->type == QNodeMatch)      return qMatchCompare(lhsNode, rhs);
-    else if (qP->type == QNodeNoMatch)    return !qMatchCompare(lhsNode, rhs);
-    else if (qP->type == QNodeComma)      return false;
-    else if (qP->type == QNodeRange)      return false;
+    // Another thread was faster - use its compiled geoQ
+    geoCompiledRelease(gcP);
+    return expected;
   }
 
-  return false;
+  return gcP;
 }
 
 
@@ -1116,23 +542,38 @@ OrionldAlterationMatch* subCacheAlterationMatch(OrionldAlteration* alterationLis
   OrionldAlterationMatch*  matchList = NULL;
   int                      matches   = 0;
 
+  std::vector<CachedSubscription*> candidates;
+
   //
-  // Loop over each alteration, and check ALL SUBSCRIPTIONS in the cache for that alteration
+  // Loop over each alteration, and check all CANDIDATE SUBSCRIPTIONS in the cache for that alteration.
+  // The sub-cache index gives the candidates - subscriptions for the tenant of the request and for
+  // the entity id or entity type of the alteration, plus the ones that can't be indexed (e.g. type '*')
   // For each matching subscription, add the alterations into 'matchList'
   //
-  cacheSemTake(__FUNCTION__, "Looping over sub-cache");
+  // No lock is taken - the index and the cached subscriptions are read inside a sub-cache read section
+  // (the caller's, if any) and a cached subscription is never modified in place (see subCacheItemReplace).
+  // Only the notification counters are modified, and those are updated atomically.
+  //
+  epochEnter();
 
   for (OrionldAlteration* altP = alterationList; altP != NULL; altP = altP->next)
   {
-    for (CachedSubscription* subP = subCacheHeadGet(); subP != NULL; subP = subP->next)
+    candidates.clear();
+    subCacheIndexCandidates(orionldState.tenantName, altP->entityId, altP->entityType, &candidates);
+
+    LM_T(LmtSubCacheMatch, ("%d candidate subscriptions for entity '%s'", (int) candidates.size(), altP->entityId));
+
+    for (unsigned int cIx = 0; cIx < candidates.size(); ++cIx)
     {
+      CachedSubscription* subP = candidates[cIx];
+
       if ((multitenancy == true) && (tenantMatch(subP->tenant, orionldState.tenantName) == false))
       {
         LM_T(LmtSubCacheMatch, ("Sub '%s' - no match due to tenant", subP->subscriptionId));
         continue;
       }
 
-      if (subP->isActive == false)
+      if (__atomic_load_n(&subP->isActive, __ATOMIC_ACQUIRE) == false)
       {
         LM_T(LmtSubCacheMatch, ("Sub '%s' - no match due to isActive == false", subP->subscriptionId));
         continue;
@@ -1144,15 +585,17 @@ OrionldAlterationMatch* subCacheAlterationMatch(OrionldAlteration* alterationLis
         continue;
       }
 
+      // The status isn't changed to "expired" here - that's done when the subscription is rendered (kjTreeFromCachedSubscription)
       if ((subP->expirationTime > 0) && (subP->expirationTime < orionldState.requestTime))
       {
         LM_T(LmtSubCacheMatch, ("Sub '%s' - no match due to expiration (now:%f, expired:%f)", subP->subscriptionId, orionldState.requestTime, subP->expirationTime));
-        subP->status   = "expired";
-        subP->isActive = false;
         continue;
       }
 
-      if ((subP->throttling > 0) && ((orionldState.requestTime - subP->lastNotificationTime) < subP->throttling))
+      double lastNotificationTime;
+      __atomic_load(&subP->lastNotificationTime, &lastNotificationTime, __ATOMIC_RELAXED);
+
+      if ((subP->throttling > 0) && ((orionldState.requestTime - lastNotificationTime) < subP->throttling))
       {
         LM_T(LmtSubCacheMatch, ("Sub '%s' - no match due to throttling", subP->subscriptionId));
         continue;
@@ -1171,35 +614,56 @@ OrionldAlterationMatch* subCacheAlterationMatch(OrionldAlteration* alterationLis
       //
       // Might be we come from a sub-cache-refresh, and the subscription has a "q" but its "qP" hasn't been built
       // Only done if its an NGSI-LD operation AND if it's an NGSI-LD Subscription (ldContext has a value != "")
+      // The q-tree is then compiled (qCompile) - the compiled form is what's used for matching.
+      //
+      // Several threads may do this at the same time - only the first q-tree (and compiled q-filter) is kept
       //
-      if ((subP->qP == NULL) && (subP->ldContext != "") && (subP->qText != NULL))
-        subP->qP = qBuild(subP->qText, NULL, NULL, NULL, false, false);
+      QCompiled* qcP = __atomic_load_n(&subP->qcP, __ATOMIC_ACQUIRE);
+
+      if ((qcP == NULL) && (subP->ldContext != "") && ((subP->qText != NULL) || (subP->qP != NULL)))
+        qcP = subQCompiledBuild(subP);
 
       //
       // Check the "q" filter, BUT not if the verb is DELETE
       //
-      if ((subP->qP != NULL) && (orionldState.verb != HTTP_DELETE))
+      if ((qcP != NULL) && (orionldState.verb != HTTP_DELETE))
       {
-        if (qMatch(subP->qP, altP) == false)
+        if (qCompiledMatch(qcP, altP->finalApiEntityP) == false)
         {
           LM_T(LmtSubCacheMatch, ("Sub '%s' - no match due to ldq == '%s'", subP->subscriptionId, subP->qText));
           continue;
         }
       }
 
+      //
+      // Check the "geoQ", BUT not if the verb is DELETE (just like "q")
+      // The geoQ is evaluated in memory, against the geo-property of the altered entity (no database query).
+      // A subscription whose geoQ cannot be compiled matches no entity at all.
+      //
+      if ((subP->expression.georel != "") && (subP->ldContext != "") && (orionldState.verb != HTTP_DELETE))
+      {
+        GeoCompiled* gcP = __atomic_load_n(&subP->geoCompiledP, __ATOMIC_ACQUIRE);
+
+        if (gcP == NULL)
+          gcP = subGeoCompiledBuild(subP);
+
+        if ((gcP == NULL) || (geoCompiledMatch(gcP, altP->finalApiEntityP) == false))
+        {
+          LM_T(LmtSubCacheMatch, ("Sub '%s' - no match due to geoQ (georel == '%s')", subP->subscriptionId, subP->expression.georel.c_str()));
+          continue;
+        }
+      }
+
       //
       // attributeMatch is too complex ...
       // I'd need simply a list of the attribute names that have been modified
       //
       // Also, I'd prefer to check for attributes before I check for 'q'
       //
-      // 'geoQ' MUST come last as it requires a database query
-      // (OR: somehow use GEOS library and fix it that way ...)
-      //
       matchList = attributeMatch(matchList, subP, altP, &matches);  // Each call adds to matchList AND matches
     }
   }
-  cacheSemGive(__FUNCTION__, "Looping over sub-cache");
+  epochLeave();
 
   *matchesP = matches;
 
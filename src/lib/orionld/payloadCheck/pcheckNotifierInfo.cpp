@@ -31,6 +31,7 @@ extern "C"
 
 #include "logMsg/logMsg.h"                                      // LM_*
 
+#include "orionld/types/ContentEncoding.h"                      // ContentEncoding, contentEncodingFromString
 #include "orionld/common/CHECK.h"                               // OBJECT_CHECK, DUPLICATE_CHECK, STRING_CHECK, ...
 #include "orionld/common/orionldState.h"                        // orionldState
 #include "orionld/common/orionldError.h"                        // orionldError
@@ -83,10 +84,12 @@ bool pcheckNotifierInfo(KjNode* niP, bool* mqttChangeP)
     }
 
     //
-    // Only two "notifier infos" are supported at the moment:
+    // The "notifier infos" supported at the moment:
     // * MQTT-Version
     // * MQTT-QoS
-    // And these two support just a few values:
+    // * Prefer
+    // * Content-Encoding
+    // And these support just a few values:
     // * MQTT-Version:
     //   - mqtt5.0 (default)
     //   - mqtt3.1.1
@@ -96,6 +99,11 @@ bool pcheckNotifierInfo(KjNode* niP, bool* mqttChangeP)
     //   - 1
     //   - 2
     //
+    // * Content-Encoding (compression of HTTP and HTTPS notifications)
+    //   - gzip
+    //   - deflate
+    //   - identity (default)
+    //
     if (strcmp(keyP->value.s, "MQTT-Version") == 0)
     {
       if ((strcmp(valueP->value.s, "mqtt5.0") != 0) && (strcmp(valueP->value.s, "mqtt3.1.1") != 0))
@@ -128,6 +136,14 @@ bool pcheckNotifierInfo(KjNode* niP, bool* mqttChangeP)
     else if (strcmp(keyP->value.s, "Prefer") == 0)
     {
     }
+    else if (strcmp(keyP->value.s, "Content-Encoding") == 0)
+    {
+      if (contentEncodingFromString(valueP->value.s) == CE_INVALID)
+      {
+        orionldError(OrionldBadRequestData, "Invalid value for notifierInfo item /Content-Encoding/ - only gzip, deflate, and identity are allowed", valueP->value.s, 400);
+        return false;
+      }
+    }
     else
     {
       orionldError(OrionldBadRequestData, "Non-supported key in notifierInfo", keyP->value.s, 400);
@@ -223,11 +223,11 @@ bool pernotSend(PernotSubscription* subP, KjNode* entityArray)
   if (subP->protocol == HTTP)
   {
     LM_T(LmtPernot, ("Sending a Periodic Notification to %s:%d%s", subP->ip, subP->port, subP->rest));
-    return httpNotify(NULL, subP, subP->subscriptionId, subP->ip, subP->port, subP->rest, ioVec, ioVecLen, subP->lastNotificationTime);
+    return httpNotify(NULL, subP, subP->subscriptionId, subP->ip, subP->port, subP->rest, ioVec, ioVecLen, subP->lastNotificationTime, NULL);
   }
 #if 0
   else if (subP->protocol == HTTPS)   return httpsNotify(subP, ioVec, ioVecLen, now, curlHandlePP);
-  else if (subP->protocol == MQTT)    return mqttNotify(subP,  ioVec, ioVecLen, now);
+  else if (subP->protocol == MQTT)    return mqttNotify(subP,  ioVec, ioVecLen, now, NULL, NULL);
 #endif
 
   LM_W(("%s: Unsupported protocol for notifications: '%s'", subP->subscriptionId, subP->protocol));
@@ -1,9 +1,6 @@
-#ifndef SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTDOWNLOAD_H_
-#define SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTDOWNLOAD_H_
-
 /*
 *
-* Copyright 2019 FIWARE Foundation e.V.
+* Copyright 2024 FIWARE Foundation e.V.
 *
 * This file is part of Orion-LD Context Broker.
 *
@@ -27,15 +24,16 @@
 */
 extern "C"
 {
-#include "kjson/KjNode.h"                                        // KjNode
+#include "prometheus-client-c/prom/include/prom.h"          // Prometheus client lib
 }
 
 
 
 // -----------------------------------------------------------------------------
 //
-// orionldContextDownload -
+// promCounterAdd -
 //
-extern char* orionldContextDownload(const char* url);
-
-#endif  // SRC_LIB_ORIONLD_CONTEXT_ORIONLDCONTEXTDOWNLOAD_H_
+int promCounterAdd(prom_counter_t* counterP, double v)
+{
+  return prom_counter_add(counterP, v, NULL);
+}
@@ -38,6 +38,34 @@ prom_counter_t*     promNgsildRequests;
 prom_counter_t*     promNgsildRequestsFailed;
 prom_counter_t*     promNotifications;
 prom_counter_t*     promNotificationsFailed;
+prom_counter_t*     promNotificationsQueued;
+prom_counter_t*     promNotificationsDropped;
+prom_gauge_t*       promNotificationQueueDepth;
+prom_counter_t*     promNotificationConnectionsOpened;
+prom_counter_t*     promNotificationConnectionsReused;
+prom_counter_t*     promNotificationRenderHits;
+prom_counter_t*     promNotificationRenderMisses;
+prom_gauge_t*       promNotificationRetryQueued;
+prom_gauge_t*       promNotificationRetrySpilled;
+prom_counter_t*     promNotificationRetries;
+prom_counter_t*     promNotificationsRedelivered;
+prom_counter_t*     promNotificationRetryDropped;
+prom_histogram_t*   promNotificationRedeliveryLatency;
+prom_counter_t*     promCompressionBytesIn;
+prom_counter_t*     promCompressionBytesOut;
+prom_counter_t*     promCompressionCpuTime;
+prom_histogram_t*   promTroeBatchSize;
+prom_histogram_t*   promTroeWriteLag;
+prom_gauge_t*       promTroeQueueDepth;
+prom_counter_t*     promTroeBackpressure;
+prom_counter_t*     promTroeCommandsFailed;
+prom_histogram_t*   promPgPoolWaitTime;
+prom_counter_t*     promPgPoolSaturated;
+prom_counter_t*     promPgPoolReconnects;
+prom_gauge_t*       promPgPoolConnections;
+prom_histogram_t*   promRequestExecutorWait;
+prom_histogram_t*   promRequestExecutorResponseTime;
+prom_histogram_t*   promRequestExecutorPostResponseTime;
 prom_gauge_t*       promTestGauge;
 prom_histogram_t*   promTestHistogram;
 
@@ -55,6 +83,83 @@ int promInit(unsigned short promPort)
   promNgsildRequestsFailed = prom_collector_registry_must_register_metric(prom_counter_new("ngsildRequestsFailed", "# Failed NGSILD Requests", 0, NULL));
   promNotifications        = prom_collector_registry_must_register_metric(prom_counter_new("notifications",        "# Notifications",          0, NULL));
   promNotificationsFailed  = prom_collector_registry_must_register_metric(prom_counter_new("notificationsFailed",  "# Failed Notifications",   0, NULL));
+  promNotificationsQueued  = prom_collector_registry_must_register_metric(prom_counter_new("notificationsQueued",  "# Queued Notifications",   0, NULL));
+  promNotificationsDropped = prom_collector_registry_must_register_metric(prom_counter_new("notificationsDropped", "# Notifications dropped due to a full notification queue", 0, NULL));
+
+  promNotificationQueueDepth = prom_collector_registry_must_register_metric(prom_gauge_new("notificationQueueDepth", "# Notifications in queue", 0, NULL));
+
+  promNotificationConnectionsOpened = prom_collector_registry_must_register_metric(prom_counter_new("notificationConnectionsOpened", "# Connections opened to notification endpoints", 0, NULL));
+  promNotificationConnectionsReused = prom_collector_registry_must_register_metric(prom_counter_new("notificationConnectionsReused", "# Notifications sent over a kept-alive connection", 0, NULL));
+
+  promNotificationRenderHits   = prom_collector_registry_must_register_metric(prom_counter_new("notificationRenderHits",   "# Notification bodies reused from an identical notification", 0, NULL));
+  promNotificationRenderMisses = prom_collector_registry_must_register_metric(prom_counter_new("notificationRenderMisses", "# Notification bodies rendered", 0, NULL));
+
+  promNotificationRetryQueued  = prom_collector_registry_must_register_metric(prom_gauge_new("notificationRetryQueued",  "# Failed notifications in memory, awaiting a retry", 0, NULL));
+  promNotificationRetrySpilled = prom_collector_registry_must_register_metric(prom_gauge_new("notificationRetrySpilled", "# Failed notifications in the spill file, awaiting a retry", 0, NULL));
+  promNotificationRetries      = prom_collector_registry_must_register_metric(prom_counter_new("notificationRetries",      "# Retries of failed notifications", 0, NULL));
+  promNotificationsRedelivered = prom_collector_registry_must_register_metric(prom_counter_new("notificationsRedelivered", "# Failed notifications delivered by a retry", 0, NULL));
+  promNotificationRetryDropped = prom_collector_registry_must_register_metric(prom_counter_new("notificationRetryDropped", "# Failed notifications given up on", 0, NULL));
+
+  promNotificationRedeliveryLatency = prom_collector_registry_must_register_metric(prom_histogram_new(
+                                                                                     "notificationRedeliveryLatency",
+                                                                                     "seconds from the first failure to the delivery of a notification",
+                                                                                     prom_histogram_buckets_exponential(0.5, 2, 12),
+                                                                                     0,
+                                                                                     NULL));
+
+  promCompressionBytesIn  = prom_collector_registry_must_register_metric(prom_counter_new("compressionBytesIn",  "# Bytes of payload bodies before compression", 0, NULL));
+  promCompressionBytesOut = prom_collector_registry_must_register_metric(prom_counter_new("compressionBytesOut", "# Bytes of payload bodies after compression", 0, NULL));
+  promCompressionCpuTime  = prom_collector_registry_must_register_metric(prom_counter_new("compressionCpuTime",  "seconds of CPU spent compressing payload bodies", 0, NULL));
+
+  promTroeBatchSize = prom_collector_registry_must_register_metric(prom_histogram_new(
+                                                                     "troeBatchSize",
+                                                                     "TRoE commands per group commit",
+                                                                     prom_histogram_buckets_exponential(1, 2, 12),
+                                                                     0,
+                                                                     NULL));
+
+  promTroeWriteLag = prom_collector_registry_must_register_metric(prom_histogram_new(
+                                                                    "troeWriteLag",
+                                                                    "seconds from the end of a request to the commit of its TRoE commands",
+                                                                    prom_histogram_buckets_exponential(0.001, 2, 14),
+                                                                    0,
+                                                                    NULL));
+
+  promTroeQueueDepth     = prom_collector_registry_must_register_metric(prom_gauge_new("troeQueueDepth", "# TRoE commands awaiting their group commit", 0, NULL));
+  promTroeBackpressure   = prom_collector_registry_must_register_metric(prom_counter_new("troeBackpressure",   "# Requests that waited for room in the TRoE writer queue", 0, NULL));
+  promTroeCommandsFailed = prom_collector_registry_must_register_metric(prom_counter_new("troeCommandsFailed", "# TRoE commands that could not be committed", 0, NULL));
+
+  promPgPoolWaitTime = prom_collector_registry_must_register_metric(prom_histogram_new(
+                                                                      "pgPoolWaitTime",
+                                                                      "seconds waited for a postgres connection of a saturated pool",
+                                                                      prom_histogram_buckets_exponential(0.0001, 2, 16),
+                                                                      0,
+                                                                      NULL));
+
+  promPgPoolSaturated   = prom_collector_registry_must_register_metric(prom_counter_new("pgPoolSaturated", "# Postgres connections requested from a pool without free connections", 0, NULL));
+  promPgPoolReconnects  = prom_collector_registry_must_register_metric(prom_counter_new("pgPoolReconnects", "# Lost postgres connections that were re-established", 0, NULL));
+  promPgPoolConnections = prom_collector_registry_must_register_metric(prom_gauge_new("pgPoolConnections", "# Open postgres connections, all pools", 0, NULL));
+
+  promRequestExecutorWait = prom_collector_registry_must_register_metric(prom_histogram_new(
+                                                                           "requestExecutorWait",
+                                                                           "seconds a request waited for a request executor",
+                                                                           prom_histogram_buckets_exponential(0.0001, 2, 16),
+                                                                           0,
+                                                                           NULL));
+
+  promRequestExecutorResponseTime = prom_collector_registry_must_register_metric(prom_histogram_new(
+                                                                                   "requestExecutorResponseTime",
+                                                                                   "seconds from a request handed over to the executors to its response being queued",
+                                                                                   prom_histogram_buckets_exponential(0.0001, 2, 16),
+                                                                                   0,
+                                                                                   NULL));
+
+  promRequestExecutorPostResponseTime = prom_collector_registry_must_register_metric(prom_histogram_new(
+                                                                                       "requestExecutorPostResponseTime",
+                                                                                       "seconds of work after the response of a request (notifications, ...), no longer delaying the response",
+                                                                                       prom_histogram_buckets_exponential(0.0001, 2, 16),
+                                                                                       0,
+                                                                                       NULL));
 
   promTestHistogram = prom_collector_registry_must_register_metric(prom_histogram_new(
                                                                      "promTestHistogram",
@@ -46,6 +46,7 @@ QNode* qClone(QNode* original)
   {
     if      (original->type == QNodeVariable)      cloneP->value.v = strdup(original->value.v);
     else if (original->type == QNodeStringValue)   cloneP->value.s = strdup(original->value.s);
+    else if (original->type == QNodeRegexpValue)   cloneP->value.re = strdup(original->value.re);  // qLex points into the q-string
     else                                           cloneP->value   = original->value;
   }
   else
@@ -0,0 +1,330 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp, strdup
+#include <stdlib.h>                                              // malloc, calloc, free
+#include <regex.h>                                               // regex_t
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/QNode.h"                                 // QNode
+#include "orionld/types/QCompiled.h"                             // QCompiled, QcInstruction, QcValue
+#include "orionld/common/dotForEq.h"                             // dotForEq
+#include "orionld/common/eqForDot.h"                             // eqForDot
+#include "orionld/common/pathComponentsSplit.h"                  // pathComponentsSplit
+#include "orionld/common/dateTime.h"                             // dateTimeFromString
+#include "orionld/q/qRegexCompile.h"                             // qRegexCompile
+#include "orionld/q/qCompile.h"                                  // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// QC_MAX_COMPONENTS - max number of components of a variable path (same limit as the tree walk)
+//
+#define QC_MAX_COMPONENTS  20
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcInstructions - number of instructions needed for a q-tree
+//
+static int qcInstructions(QNode* qP)
+{
+  if ((qP->type != QNodeAnd) && (qP->type != QNodeOr))
+    return 1;
+
+  int instructions = 1;
+  for (QNode* childP = qP->value.children; childP != NULL; childP = childP->next)
+  {
+    instructions += qcInstructions(childP);
+  }
+
+  return instructions;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcPathEqual -
+//
+static bool qcPathEqual(char** path1V, char** path2V)
+{
+  int ix = 0;
+
+  while ((path1V[ix] != NULL) && (path2V[ix] != NULL))
+  {
+    if (strcmp(path1V[ix], path2V[ix]) != 0)
+      return false;
+    ++ix;
+  }
+
+  return (path1V[ix] == NULL) && (path2V[ix] == NULL);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcPathAdd - add a path to the instruction (unless it's already there), copying all its components
+//
+static void qcPathAdd(QcInstruction* iP, char** compV, int components)
+{
+  for (int ix = 0; ix < iP->paths; ix++)
+  {
+    if (qcPathEqual(iP->pathV[ix], compV) == true)
+      return;
+  }
+
+  char** pathV = (char**) malloc((components + 1) * sizeof(char*));
+
+  for (int ix = 0; ix < components; ix++)
+  {
+    pathV[ix] = strdup(compV[ix]);
+  }
+  pathV[components] = NULL;
+
+  iP->pathV[iP->paths++] = pathV;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcPathsCompile - pre-split the variable path, and prepare all alternatives the tree walk would try
+//
+// The alternatives, in the same order as kjNavigate2 (qMatch.cpp) tries them:
+//   1. The path as is
+//   2. '=' turned into '.' for the attribute and the sub-attribute (the first two components)
+//   3. If "P.value": "P.object" (a Relationship), '=' turned into '.'
+//   4. If "P.value": "P.object", with '.' turned into '='
+//
+static bool qcPathsCompile(QcInstruction* iP, const char* path)
+{
+  char* compV[QC_MAX_COMPONENTS + 1];
+  char* pathCopy   = strdup(path);
+  int   components = pathComponentsSplit(pathCopy, compV);
+
+  if (components > QC_MAX_COMPONENTS)
+  {
+    free(pathCopy);
+    LM_RE(false, ("The current implementation of Orion-LD can only handle %d levels of tree navigation", QC_MAX_COMPONENTS));
+  }
+
+  compV[components] = NULL;
+
+  char* lastComponent = compV[components - 1];
+  if ((strcmp(lastComponent, "observedAt") == 0) || (strcmp(lastComponent, "modifiedAt") == 0) || (strcmp(lastComponent, "createdAt") == 0))
+    iP->isTimestamp = true;
+
+  qcPathAdd(iP, compV, components);
+
+  eqForDot(compV[0]);
+  if (compV[1] != NULL)
+    eqForDot(compV[1]);
+  qcPathAdd(iP, compV, components);
+
+  if ((components == 2) && (strcmp(compV[1], "value") == 0))
+  {
+    compV[1] = (char*) "object";
+    qcPathAdd(iP, compV, components);
+
+    dotForEq(compV[0]);
+    qcPathAdd(iP, compV, components);
+  }
+
+  free(pathCopy);
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcValueCompile - a constant of the right-hand side
+//
+// Strings are parsed as ISO8601 timestamps only if the left-hand side is a timestamp
+// (just like the tree walk does it, only, once and for all)
+//
+static void qcValueCompile(QcValue* valueP, QNode* qP, bool isTimestamp)
+{
+  valueP->type      = qP->type;
+  valueP->i         = 0;
+  valueP->f         = 0;
+  valueP->s         = NULL;
+  valueP->timestamp = -1;
+
+  if      (qP->type == QNodeIntegerValue)  valueP->i = qP->value.i;
+  else if (qP->type == QNodeFloatValue)    valueP->f = qP->value.f;
+  else if (qP->type == QNodeStringValue)
+  {
+    valueP->s = strdup(qP->value.s);
+
+    if (isTimestamp == true)
+    {
+      char errorString[256];
+      valueP->timestamp = dateTimeFromString(qP->value.s, errorString, sizeof(errorString));
+    }
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcRhsCompile - the right-hand side of a comparison
+//
+static bool qcRhsCompile(QcInstruction* iP, QNode* rhs)
+{
+  if ((iP->op == QNodeExists) || (iP->op == QNodeNotExists))
+    return true;
+
+  if (rhs == NULL)
+    return false;
+
+  iP->rhsType = rhs->type;
+
+  if ((iP->op == QNodeMatch) || (iP->op == QNodeNoMatch))
+  {
+    iP->rhsType = QNodeRegexpValue;
+    iP->regexP  = (regex_t*) malloc(sizeof(regex_t));
+
+    if (qRegexCompile(rhs, iP->regexP) == false)
+    {
+      free(iP->regexP);
+      iP->regexP = NULL;  // No regex - nothing matches
+    }
+
+    return true;
+  }
+
+  if ((rhs->type == QNodeRange) || (rhs->type == QNodeComma))
+  {
+    int values = 0;
+
+    for (QNode* childP = rhs->value.children; childP != NULL; childP = childP->next)
+    {
+      ++values;
+    }
+
+    if ((rhs->type == QNodeRange) && (values < 2))
+      return false;
+
+    iP->valueV = (QcValue*) calloc(values, sizeof(QcValue));
+    iP->values = values;
+
+    int ix = 0;
+    for (QNode* childP = rhs->value.children; childP != NULL; childP = childP->next)
+    {
+      qcValueCompile(&iP->valueV[ix++], childP, iP->isTimestamp);
+    }
+
+    return true;
+  }
+
+  iP->valueV = (QcValue*) calloc(1, sizeof(QcValue));
+  iP->values = 1;
+  qcValueCompile(&iP->valueV[0], rhs, iP->isTimestamp);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcCompile - compile a q-tree node (and its children) into instructionV, starting at index 'ix'
+//
+// Returns the index of the first instruction after the node
+//
+static int qcCompile(QNode* qP, QcInstruction* instructionV, int ix)
+{
+  QcInstruction* iP = &instructionV[ix];
+
+  iP->op = qP->type;
+
+  if ((qP->type == QNodeAnd) || (qP->type == QNodeOr))
+  {
+    int childIx = ix + 1;
+
+    for (QNode* childP = qP->value.children; childP != NULL; childP = childP->next)
+    {
+      childIx = qcCompile(childP, instructionV, childIx);
+    }
+
+    iP->end = childIx;
+    return iP->end;
+  }
+
+  iP->end = ix + 1;
+
+  switch (qP->type)
+  {
+  case QNodeExists:
+  case QNodeNotExists:
+  case QNodeEQ:
+  case QNodeNE:
+  case QNodeGE:
+  case QNodeGT:
+  case QNodeLE:
+  case QNodeLT:
+  case QNodeMatch:
+  case QNodeNoMatch:
+    break;
+
+  default:
+    iP->op = QNodeVoid;  // Never a match
+    return iP->end;
+  }
+
+  QNode* lhs = qP->value.children;
+
+  if ((lhs == NULL) || (lhs->type != QNodeVariable) || (qcPathsCompile(iP, lhs->value.v) == false) || (qcRhsCompile(iP, lhs->next) == false))
+    iP->op = QNodeVoid;
+
+  return iP->end;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qCompile -
+//
+QCompiled* qCompile(QNode* qP)
+{
+  if (qP == NULL)
+    return NULL;
+
+  QCompiled* qcP = (QCompiled*) malloc(sizeof(QCompiled));
+
+  qcP->instructions = qcInstructions(qP);
+  qcP->instructionV = (QcInstruction*) calloc(qcP->instructions, sizeof(QcInstruction));
+
+  qcCompile(qP, qcP->instructionV, 0);
+
+  return qcP;
+}
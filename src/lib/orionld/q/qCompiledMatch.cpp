@@ -0,0 +1,452 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+#include <regex.h>                                               // regexec
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjLookup.h"                                      // kjLookup
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/QNode.h"                                 // QNodeType
+#include "orionld/types/QCompiled.h"                             // QCompiled, QcInstruction, QcValue
+#include "orionld/common/dateTime.h"                             // dateTimeFromString
+#include "orionld/q/qCompiledMatch.h"                            // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcNavigate - find the left-hand side in the entity, trying the pre-split paths in order
+//
+static KjNode* qcNavigate(KjNode* entityP, QcInstruction* iP)
+{
+  for (int pIx = 0; pIx < iP->paths; pIx++)
+  {
+    KjNode* nodeP = entityP;
+
+    for (char** compP = iP->pathV[pIx]; (*compP != NULL) && (nodeP != NULL); ++compP)
+    {
+      nodeP = kjLookup(nodeP, *compP);
+    }
+
+    if (nodeP != NULL)
+      return nodeP;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// lhsTimestamp - the left-hand side (a timestamp) as a number
+//
+static double lhsTimestamp(KjNode* lhsNode)
+{
+  char errorString[256];
+
+  return dateTimeFromString(lhsNode->value.s, errorString, sizeof(errorString));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcRangeCompare -
+//
+static bool qcRangeCompare(KjNode* lhsNode, QcInstruction* iP)
+{
+  QcValue* low  = &iP->valueV[0];
+  QcValue* high = &iP->valueV[1];
+
+  if (iP->isTimestamp == true)
+  {
+    if (lhsNode->type != KjString)
+      return false;
+
+    double lhsTs  = lhsTimestamp(lhsNode);
+    double lowTs  = (low->type  == QNodeFloatValue)? low->f  : low->timestamp;
+    double highTs = (high->type == QNodeFloatValue)? high->f : high->timestamp;
+
+    if ((lhsTs < 0) || (lowTs < 0) || (highTs < 0))
+      LM_RE(false, ("Invalid ISO8601 timestamp in range (%s)", lhsNode->value.s));
+
+    return ((lhsTs >= lowTs) && (lhsTs <= highTs));
+  }
+
+  if ((lhsNode->type == KjInt) || (lhsNode->type == KjFloat))
+  {
+    double lhs = (lhsNode->type == KjInt)? (double) lhsNode->value.i : lhsNode->value.f;
+
+    if      (low->type == QNodeIntegerValue)  { if (lhs < (double) low->i) return false; }
+    else if (low->type == QNodeFloatValue)    { if (lhs < low->f)          return false; }
+    else                                      return false;  // type mismatch
+
+    if      (high->type == QNodeIntegerValue) { if (lhs > (double) high->i) return false; }
+    else if (high->type == QNodeFloatValue)   { if (lhs > high->f)          return false; }
+    else                                      return false;  // type mismatch
+
+    return true;
+  }
+
+  if (lhsNode->type == KjString)
+  {
+    if ((low->type != QNodeStringValue) || (high->type != QNodeStringValue))
+      return false;  // type mismatch
+
+    if (strcmp(lhsNode->value.s, low->s) < 0)
+      return false;
+    if (strcmp(lhsNode->value.s, high->s) > 0)
+      return false;
+
+    return true;
+  }
+
+  return false;  // RANGES operate only on Numbers, Strings and Timestamps
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcValueEqual - comparison of one item of a comma-list
+//
+static bool qcValueEqual(KjNode* lhsNode, QcValue* valueP)
+{
+  switch (lhsNode->type)
+  {
+  case KjInt:
+    if      (valueP->type == QNodeIntegerValue)  return lhsNode->value.i == valueP->i;
+    else if (valueP->type == QNodeFloatValue)    return ((double) lhsNode->value.i) == valueP->f;
+    break;
+
+  case KjFloat:
+    if      (valueP->type == QNodeFloatValue)    return lhsNode->value.f == valueP->f;
+    else if (valueP->type == QNodeIntegerValue)  return lhsNode->value.f == (double) valueP->i;
+    break;
+
+  case KjString:
+    if (valueP->type == QNodeStringValue)
+      return (strcmp(lhsNode->value.s, valueP->s) == 0);
+    break;
+
+  case KjBoolean:
+    if (valueP->type == QNodeTrueValue)   return (lhsNode->value.b == true);
+    if (valueP->type == QNodeFalseValue)  return (lhsNode->value.b == false);
+    break;
+
+  default:
+    break;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcCommaListCompare -
+//
+static bool qcCommaListCompare(KjNode* lhsNode, QcInstruction* iP)
+{
+  if (iP->isTimestamp == true)  // The first in the list is a FLOAT, the rest may be strings
+  {
+    double timestamp;
+
+    if      (lhsNode->type == KjFloat)   timestamp = lhsNode->value.f;
+    else if (lhsNode->type == KjString)  timestamp = lhsTimestamp(lhsNode);
+    else                                 return false;
+
+    if (iP->valueV[0].type != QNodeFloatValue)
+      LM_E(("CLIST: Internal Error (LHS is a timestamp but the first in the RHS list is not a FLOAT ..."));
+    else if (iP->valueV[0].f == timestamp)
+      return true;
+
+    for (int ix = 1; ix < iP->values; ix++)
+    {
+      QcValue* valueP = &iP->valueV[ix];
+
+      if ((valueP->type == QNodeFloatValue) && (valueP->f == timestamp))
+        return true;
+      else if ((valueP->type == QNodeStringValue) && (valueP->timestamp == timestamp))
+        return true;
+    }
+
+    return false;
+  }
+
+  for (int ix = 0; ix < iP->values; ix++)
+  {
+    if (qcValueEqual(lhsNode, &iP->valueV[ix]) == true)
+      return true;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcEqCompare -
+//
+static bool qcEqCompare(KjNode* lhsNode, QcInstruction* iP)
+{
+  QcValue* rhs = &iP->valueV[0];
+
+  if (iP->isTimestamp == true)
+  {
+    if (lhsNode->type != KjString)
+      return false;
+
+    double timestamp = lhsTimestamp(lhsNode);
+
+    if      (rhs->type == QNodeIntegerValue)  return (rhs->i == (long long) timestamp);
+    else if (rhs->type == QNodeFloatValue)    return (rhs->f == timestamp);
+  }
+
+  if (lhsNode->type == KjInt)
+  {
+    if      (rhs->type == QNodeIntegerValue)  return (lhsNode->value.i == rhs->i);
+    else if (rhs->type == QNodeFloatValue)    return (lhsNode->value.i == rhs->f);
+  }
+  else if (lhsNode->type == KjFloat)
+  {
+    double margin = 0.000001;
+
+    if      (rhs->type == QNodeIntegerValue)  return ((lhsNode->value.f - margin < rhs->i) && (lhsNode->value.f + margin > rhs->i));
+    else if (rhs->type == QNodeFloatValue)    return ((lhsNode->value.f - margin < rhs->f) && (lhsNode->value.f + margin > rhs->f));
+  }
+  else if (lhsNode->type == KjString)
+  {
+    if (rhs->type == QNodeStringValue)
+      return (strcmp(lhsNode->value.s, rhs->s) == 0);
+  }
+  else if (lhsNode->type == KjBoolean)
+  {
+    if (rhs->type == QNodeTrueValue)   return (lhsNode->value.b == true);
+    if (rhs->type == QNodeFalseValue)  return (lhsNode->value.b == false);
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcGtCompare -
+//
+static bool qcGtCompare(KjNode* lhsNode, QcInstruction* iP)
+{
+  QcValue* rhs = &iP->valueV[0];
+
+  if (iP->isTimestamp == true)
+  {
+    if (lhsNode->type != KjString)
+      return false;
+
+    double timestamp = lhsTimestamp(lhsNode);
+
+    if      (rhs->type == QNodeIntegerValue)  return (rhs->i < (long long) timestamp);
+    else if (rhs->type == QNodeFloatValue)    return (rhs->f < timestamp);
+  }
+
+  if (lhsNode->type == KjInt)
+  {
+    if      (rhs->type == QNodeIntegerValue)  return (lhsNode->value.i > rhs->i);
+    else if (rhs->type == QNodeFloatValue)    return (lhsNode->value.i > rhs->f);
+  }
+  else if (lhsNode->type == KjFloat)
+  {
+    if      (rhs->type == QNodeIntegerValue)  return (lhsNode->value.f > rhs->i);
+    else if (rhs->type == QNodeFloatValue)    return (lhsNode->value.f > rhs->f);
+  }
+  else if (lhsNode->type == KjString)
+  {
+    if (rhs->type == QNodeStringValue)
+      return (strcmp(lhsNode->value.s, rhs->s) > 0);
+  }
+  else if (lhsNode->type == KjBoolean)
+  {
+    if (rhs->type == QNodeFalseValue)
+      return (lhsNode->value.b == true);
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcLtCompare -
+//
+static bool qcLtCompare(KjNode* lhsNode, QcInstruction* iP)
+{
+  QcValue* rhs = &iP->valueV[0];
+
+  if (iP->isTimestamp == true)
+  {
+    if (lhsNode->type != KjString)
+      return false;
+
+    double timestamp = lhsTimestamp(lhsNode);
+
+    if      (rhs->type == QNodeIntegerValue)  return (rhs->i > (long long) timestamp);
+    else if (rhs->type == QNodeFloatValue)    return (rhs->f > timestamp);
+  }
+
+  if (lhsNode->type == KjInt)
+  {
+    if      (rhs->type == QNodeIntegerValue)  return (lhsNode->value.i < rhs->i);
+    else if (rhs->type == QNodeFloatValue)    return (lhsNode->value.i < rhs->f);
+  }
+  else if (lhsNode->type == KjFloat)
+  {
+    if      (rhs->type == QNodeIntegerValue)  return (lhsNode->value.f < rhs->i);
+    else if (rhs->type == QNodeFloatValue)    return (lhsNode->value.f < rhs->f);
+  }
+  else if (lhsNode->type == KjString)
+  {
+    if (rhs->type == QNodeStringValue)
+      return (strcmp(lhsNode->value.s, rhs->s) < 0);
+  }
+  else if (lhsNode->type == KjBoolean)
+  {
+    if (rhs->type == QNodeFalseValue)  // Same as the tree walk (qLtCompare)
+      return (lhsNode->value.b == true);
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcEqualCompare - '==' with a single value, a range, or a comma-list
+//
+static inline bool qcEqualCompare(KjNode* lhsNode, QcInstruction* iP)
+{
+  if      (iP->rhsType == QNodeRange)  return qcRangeCompare(lhsNode, iP);
+  else if (iP->rhsType == QNodeComma)  return qcCommaListCompare(lhsNode, iP);
+
+  return qcEqCompare(lhsNode, iP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcRegexCompare -
+//
+static bool qcRegexCompare(KjNode* lhsNode, QcInstruction* iP)
+{
+  if ((iP->regexP == NULL) || (lhsNode->type != KjString))
+    return false;
+
+  return (regexec(iP->regexP, lhsNode->value.s, 0, NULL, 0) == 0);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qcMatch - match the instruction 'ix' (and its children)
+//
+static bool qcMatch(QcInstruction* instructionV, int ix, KjNode* entityP)
+{
+  QcInstruction* iP = &instructionV[ix];
+
+  if (iP->op == QNodeOr)
+  {
+    for (int childIx = ix + 1; childIx < iP->end; childIx = instructionV[childIx].end)
+    {
+      if (qcMatch(instructionV, childIx, entityP) == true)
+        return true;
+    }
+
+    return false;
+  }
+  else if (iP->op == QNodeAnd)
+  {
+    for (int childIx = ix + 1; childIx < iP->end; childIx = instructionV[childIx].end)
+    {
+      if (qcMatch(instructionV, childIx, entityP) == false)
+        return false;
+    }
+
+    return true;
+  }
+  else if (iP->op == QNodeVoid)
+    return false;
+
+  KjNode* lhsNode = qcNavigate(entityP, iP);
+
+  //
+  // If Left-Hand-Side does not exist - MATCH for op "NotExist" and No Match for all other operations
+  //
+  if (lhsNode == NULL)
+    return (iP->op == QNodeNotExists);
+
+  switch (iP->op)
+  {
+  case QNodeNotExists:  return false;
+  case QNodeExists:     return true;
+  case QNodeEQ:         return  qcEqualCompare(lhsNode, iP);
+  case QNodeNE:         return !qcEqualCompare(lhsNode, iP);
+  case QNodeGT:         return  qcGtCompare(lhsNode, iP);
+  case QNodeLT:         return  qcLtCompare(lhsNode, iP);
+  case QNodeGE:         return !qcLtCompare(lhsNode, iP);
+  case QNodeLE:         return !qcGtCompare(lhsNode, iP);
+  case QNodeMatch:      return  qcRegexCompare(lhsNode, iP);
+  case QNodeNoMatch:    return !qcRegexCompare(lhsNode, iP);
+  default:
+    break;
+  }
+
+  return false;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qCompiledMatch -
+//
+bool qCompiledMatch(QCompiled* qcP, KjNode* entityP)
+{
+  if (qcP->instructions == 0)
+    return false;
+
+  return qcMatch(qcP->instructionV, 0, entityP);
+}
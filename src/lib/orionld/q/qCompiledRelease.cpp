@@ -0,0 +1,70 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // free
+#include <regex.h>                                               // regfree
+
+#include "orionld/types/QCompiled.h"                             // QCompiled, QcInstruction
+#include "orionld/q/qCompiledRelease.h"                          // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qCompiledRelease -
+//
+void qCompiledRelease(QCompiled* qcP)
+{
+  for (int ix = 0; ix < qcP->instructions; ix++)
+  {
+    QcInstruction* iP = &qcP->instructionV[ix];
+
+    for (int pIx = 0; pIx < iP->paths; pIx++)
+    {
+      for (char** compP = iP->pathV[pIx]; *compP != NULL; ++compP)
+      {
+        free(*compP);
+      }
+      free(iP->pathV[pIx]);
+    }
+
+    for (int vIx = 0; vIx < iP->values; vIx++)
+    {
+      if (iP->valueV[vIx].s != NULL)
+        free(iP->valueV[vIx].s);
+    }
+
+    if (iP->valueV != NULL)
+      free(iP->valueV);
+
+    if (iP->regexP != NULL)
+    {
+      regfree(iP->regexP);
+      free(iP->regexP);
+    }
+  }
+
+  free(qcP->instructionV);
+  free(qcP);
+}
@@ -239,7 +239,7 @@ static QNode* qTermPush(QNode* prev, char* term, bool* lastTermIsTimestampP, cha
     else if (type == QNodeVariable)
       qNodeP->value.v = term;
     else if (type == QNodeRegexpValue)
-      qNodeP->value.re = term;
+      qNodeP->value.re = (strncmp(term, "RE(", 3) == 0)? &term[3] : term;  // The closing ')' is already gone
     // else ERROR ?
 
     prev->next = qNodeP;
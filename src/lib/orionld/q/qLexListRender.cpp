@@ -113,7 +113,7 @@ char* qLexListRender(QNode* qListP, bool* validInV2P, bool* isMqP)
     case QNodeTrueValue:    bufP = (char*) "true";                       break;
     case QNodeFalseValue:   bufP = (char*) "false";                      break;
     case QNodeRegexpValue:
-      bufP = qItemP->value.s;
+      bufP = qItemP->value.re;
       *validInV2P = false;
       break;
     case QNodeVariable:
@@ -130,7 +130,8 @@ char* qLexListRender(QNode* qListP, bool* validInV2P, bool* isMqP)
       continue;
 
     // If it's a QNodeStringValue we need to add %22 before and after => 6 extra bytes
-    int extra = (qItemP->type == QNodeStringValue)? 6 : 0;
+    // If it's a QNodeRegexpValue we need to add RE( before and ) after => 4 extra bytes
+    int extra = (qItemP->type == QNodeStringValue)? 6 : (qItemP->type == QNodeRegexpValue)? 4 : 0;
     int len   = strlen(bufP);
     if (outIx + len + extra >= outSize)
     {
@@ -152,6 +153,12 @@ char* qLexListRender(QNode* qListP, bool* validInV2P, bool* isMqP)
       outP[outIx++] = '2';
       outP[outIx++] = '2';
     }
+    else if (qItemP->type == QNodeRegexpValue)
+    {
+      outP[outIx++] = 'R';
+      outP[outIx++] = 'E';
+      outP[outIx++] = '(';
+    }
 
     strncpy(&outP[outIx], bufP, len);
 
@@ -163,6 +170,8 @@ char* qLexListRender(QNode* qListP, bool* validInV2P, bool* isMqP)
       outP[outIx++] = '2';
       outP[outIx++] = '2';
     }
+    else if (qItemP->type == QNodeRegexpValue)
+      outP[outIx++] = ')';
 
     outP[outIx] = 0;
   }
@@ -0,0 +1,62 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <regex.h>                                               // regex_t, regcomp
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/QNode.h"                                 // QNode
+#include "orionld/q/qRegexCompile.h"                             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qRegexCompile -
+//
+bool qRegexCompile(QNode* rhs, regex_t* regexP)
+{
+  const char* pattern;
+
+  if (rhs == NULL)
+    return false;
+
+  if (rhs->type == QNodeRegexpValue)
+    pattern = rhs->value.re;
+  else if (rhs->type == QNodeStringValue)
+    pattern = rhs->value.s;
+  else
+    LM_RE(false, ("Invalid right-hand side for '~=' (node type %d)", rhs->type));
+
+  int status = regcomp(regexP, pattern, REG_EXTENDED | REG_NOSUB);
+  if (status != 0)
+  {
+    char errorString[256];
+
+    regerror(status, regexP, errorString, sizeof(errorString));
+    LM_RE(false, ("Invalid regular expression '%s': %s", pattern, errorString));
+  }
+
+  return true;
+}
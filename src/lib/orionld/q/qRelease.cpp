@@ -59,13 +59,14 @@ void qRelease(QNode* qP)
       qRelease(childP);
       childP = next;
     }
-    // if (QNodeNoMatch || QNodeMatch) regfree(qP->value.regex);
   }
 
   if ((qP->type == QNodeVariable) && (qP->value.v != NULL))
     free(qP->value.v);
   else if ((qP->type == QNodeStringValue) && (qP->value.s != NULL))
     free(qP->value.v);
+  else if ((qP->type == QNodeRegexpValue) && (qP->value.re != NULL))
+    free(qP->value.re);
 
   free(qP);
 }
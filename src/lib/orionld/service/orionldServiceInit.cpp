@@ -106,6 +106,7 @@
 #include "orionld/troe/troePostBatchUpdate.h"                        // troePostBatchUpdate
 #include "orionld/troe/troePostEntity.h"                             // troePostEntity
 #include "orionld/mqtt/mqttConnectionInit.h"                         // mqttConnectionInit
+#include "orionld/service/orionldServiceTrieBuild.h"                 // orionldServiceTrieBuild
 #include "orionld/service/orionldServiceInit.h"                      // Own Interface
 
 
@@ -461,9 +462,49 @@ static void restServicePrepare(OrionLdRestService* serviceP, OrionLdRestServiceS
     serviceP->options |= ORIONLD_SERVICE_OPTION_EXPAND_TYPE;
   }
   else if (serviceP->serviceRoutine == orionldGetTemporalEntities)
-    serviceP->mintaka = true;
+  {
+    if (troe == false)  // Without TRoE, the temporal queries are for Mintaka
+      serviceP->mintaka = true;
+
+    serviceP->options   |= ORIONLD_SERVICE_OPTION_CORE_CONTEXT_IN_RESPONSE;
+
+    serviceP->uriParams |= ORIONLD_URIPARAM_OPTIONS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_LIMIT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_OFFSET;
+    serviceP->uriParams |= ORIONLD_URIPARAM_IDLIST;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TYPELIST;
+    serviceP->uriParams |= ORIONLD_URIPARAM_IDPATTERN;
+    serviceP->uriParams |= ORIONLD_URIPARAM_ATTRS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_Q;
+    serviceP->uriParams |= ORIONLD_URIPARAM_GEOREL;
+    serviceP->uriParams |= ORIONLD_URIPARAM_GEOMETRY;
+    serviceP->uriParams |= ORIONLD_URIPARAM_COORDINATES;
+    serviceP->uriParams |= ORIONLD_URIPARAM_GEOPROPERTY;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEPROPERTY;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEREL;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEAT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_ENDTIMEAT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_LASTN;
+    serviceP->uriParams |= ORIONLD_URIPARAM_AGGRMETHODS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_AGGRPERIODDURATION;
+  }
   else if (serviceP->serviceRoutine == orionldGetTemporalEntity)
-    serviceP->mintaka = true;
+  {
+    if (troe == false)  // Without TRoE, the temporal queries are for Mintaka
+      serviceP->mintaka = true;
+
+    serviceP->options   |= ORIONLD_SERVICE_OPTION_CORE_CONTEXT_IN_RESPONSE;
+
+    serviceP->uriParams |= ORIONLD_URIPARAM_OPTIONS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_ATTRS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEPROPERTY;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEREL;
+    serviceP->uriParams |= ORIONLD_URIPARAM_TIMEAT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_ENDTIMEAT;
+    serviceP->uriParams |= ORIONLD_URIPARAM_LASTN;
+    serviceP->uriParams |= ORIONLD_URIPARAM_AGGRMETHODS;
+    serviceP->uriParams |= ORIONLD_URIPARAM_AGGRPERIODDURATION;
+  }
   else if (serviceP->serviceRoutine == orionldPostTemporalQuery)
     serviceP->mintaka = true;
   else if (serviceP->serviceRoutine == orionldDeleteTemporalAttribute)
@@ -609,6 +650,8 @@ void orionldServiceInit(OrionLdRestServiceSimplifiedVector* restServiceVV, int v
     {
       restServicePrepare(&orionldRestServiceV[svIx].serviceV[sIx], &restServiceVV[svIx].serviceV[sIx]);
     }
+
+    orionldServiceTrieBuild(&orionldRestServiceV[svIx]);
   }
 
   //
@@ -22,64 +22,20 @@
 *
 * Author: Ken Zangelin
 */
+#include <string.h>                                            // strlen
+
 extern "C"
 {
 #include "kalloc/kaStrdup.h"                                   // kaStrdup
 }
 
-#include "logMsg/logMsg.h"                                     // LM_*
-#include "logMsg/traceLevels.h"                                // Lmt*
-
-#include "orionld/types/OrionLdRestService.h"                  // OrionLdRestService, ORION_LD_SERVICE_PREFIX_LEN
+#include "orionld/types/OrionLdRestService.h"                  // OrionLdRestService
 #include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/service/orionldServiceTrieMatch.h"           // orionldServiceTrieMatch
 #include "orionld/service/orionldServiceLookup.h"              // Own interface
 
 
 
-// -----------------------------------------------------------------------------
-//
-// requestPrepare -
-//
-// The cSumV values are interesting only for URL paths without wildcard of just uptil the first wildcard
-// The longest URL path without/before first wildcard is "/ngsi-ld/v1/csourceRegistrations/".
-// The initial part ("/ngsi-ld/") doesn't count, so ... 34 chars is all we need for the cSumV.
-//
-// strlen("/ngsi-ld/v1/temporal/entityOperations/query") == 43
-// strlen("/ngsi-ld/")                                   == 9   (ORION_LD_SERVICE_PREFIX_LEN)
-//
-//   43 - 9 == 34
-//
-#define MAX_CHARS_BEFORE_WILDCARD 34
-static void requestPrepare(char* url, int* cSumV, int* cSumsP, int* sLenP)
-{
-  // First of all, skip the first 9 characters in the URL path ("/ngsi-ld/")
-  url = &url[ORION_LD_SERVICE_PREFIX_LEN];
-  *cSumsP = 0;
-
-  // Initialize counters with the first byte, then skip the first byte for the loop
-  cSumV[0] = url[0];
-
-  int sLen;
-  int ix   = 1;
-
-  while ((url[ix] != 0) && (ix < MAX_CHARS_BEFORE_WILDCARD))
-  {
-    cSumV[ix]  = cSumV[ix - 1] + url[ix];
-    ++ix;
-  }
-  *cSumsP = ix;
-
-  while (url[ix] != 0)
-  {
-    ++ix;
-  }
-
-  sLen   = ix;
-  *sLenP = sLen;
-}
-
-
-
 // -----------------------------------------------------------------------------
 //
 // orionldServiceLookup -
@@ -87,90 +43,40 @@ static void requestPrepare(char* url, int* cSumV, int* cSumsP, int* sLenP)
 // The Verb must be a valid verb before calling this function (GET | POST | DELETE).
 // This is assured by the function mhdConnectionTreat()
 //
+// The service is found by the router (orionldServiceTrieMatch), that doesn't touch the URL path.
+// If the service has wildcards, the part of the URL path from the first wildcard is copied (the URL path is
+// needed intact later on - forwarding, error messages) and the wildcards are NUL-terminated inside the copy.
+//
 OrionLdRestService* orionldServiceLookup(OrionLdRestServiceVector* serviceV)
 {
-  int serviceIx = 0;
-  int cSumV[MAX_CHARS_BEFORE_WILDCARD];
-  int cSums;
-  int sLen;
+  const char* rest  = NULL;
+  const char* match = NULL;
+  int         sIx   = orionldServiceTrieMatch(serviceV, orionldState.urlPath, &rest, &match);
 
-  requestPrepare(orionldState.urlPath, cSumV, &cSums, &sLen);
+  if (sIx == -1)
+    return NULL;
 
-  while (serviceIx < serviceV->services)
-  {
-    OrionLdRestService* serviceP = &serviceV->serviceV[serviceIx];
-
-    if (serviceP->wildcards == 0)
-    {
-      if (serviceP->charsBeforeFirstWildcard == sLen)
-      {
-        if (serviceP->charsBeforeFirstWildcardSum == cSumV[sLen - 1])
-        {
-          if (strcmp(&serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], &orionldState.urlPath[ORION_LD_SERVICE_PREFIX_LEN]) == 0)
-            return serviceP;
-        }
-      }
-    }
-    else if (serviceP->wildcards == 1)
-    {
-      char* url = kaStrdup(&orionldState.kalloc, orionldState.urlPath);
-
-      if (serviceP->charsBeforeFirstWildcard < sLen)
-      {
-        if (serviceP->charsBeforeFirstWildcardSum == cSumV[serviceP->charsBeforeFirstWildcard - 1])
-        {
-          if (strncmp(&serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], &url[ORION_LD_SERVICE_PREFIX_LEN], serviceP->charsBeforeFirstWildcard) == 0)
-          {
-            // Ending the same?
-            if (serviceP->matchForSecondWildcardLen != 0)  // An ending to match
-            {
-              int indexOfIncomingUrlPath = ORION_LD_SERVICE_PREFIX_LEN + sLen - serviceP->matchForSecondWildcardLen;
-
-              if (strncmp(&url[indexOfIncomingUrlPath], serviceP->matchForSecondWildcard, serviceP->matchForSecondWildcardLen) == 0)
-              {
-                orionldState.wildcard[0] = &url[serviceP->charsBeforeFirstWildcard + ORION_LD_SERVICE_PREFIX_LEN];
+  OrionLdRestService* serviceP = &serviceV->serviceV[sIx];
 
-                // NOT Destroying the incoming URL path, to extract the wildcard string - as 'url' is kaStrdupped from orionldState.urlPath
-                url[sLen - serviceP->matchForSecondWildcardLen + ORION_LD_SERVICE_PREFIX_LEN] = 0;
-                return serviceP;
-              }
-            }
-            else
-            {
-              orionldState.wildcard[0] = &url[serviceP->charsBeforeFirstWildcard + ORION_LD_SERVICE_PREFIX_LEN];
-              return serviceP;
-            }
-          }
-        }
-      }
-    }
-    else
-    {
-      char* url = kaStrdup(&orionldState.kalloc, orionldState.urlPath);
+  if (serviceP->wildcards == 0)
+    return serviceP;
 
-      if (serviceP->charsBeforeFirstWildcard < sLen)
-      {
-        if (serviceP->charsBeforeFirstWildcardSum == cSumV[serviceP->charsBeforeFirstWildcard - 1])
-        {
-          char* matchP;
-          if ((matchP = strstr(&url[ORION_LD_SERVICE_PREFIX_LEN], serviceP->matchForSecondWildcard)) != NULL)
-          {
-            {
-              orionldState.wildcard[0] = &url[serviceP->charsBeforeFirstWildcard + ORION_LD_SERVICE_PREFIX_LEN];
-              orionldState.wildcard[1] = &matchP[serviceP->matchForSecondWildcardLen];
+  char* wildcard = kaStrdup(&orionldState.kalloc, rest);
 
-              // Destroying the incoming URL path, to extract first wildcard string
-              *matchP = 0;
+  orionldState.wildcard[0] = wildcard;
 
-              return serviceP;
-            }
-          }
-        }
-      }
-    }
+  if (serviceP->wildcards == 1)
+  {
+    if (serviceP->matchForSecondWildcardLen != 0)  // An ending to remove
+      wildcard[strlen(wildcard) - serviceP->matchForSecondWildcardLen] = 0;
+  }
+  else
+  {
+    char* matchP = &wildcard[match - rest];
 
-    ++serviceIx;
+    orionldState.wildcard[1] = &matchP[serviceP->matchForSecondWildcardLen];
+    *matchP = 0;
   }
 
-  return NULL;
+  return serviceP;
 }
@@ -0,0 +1,158 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                            // calloc
+#include <string.h>                                            // strncmp
+
+#include "logMsg/logMsg.h"                                     // LM_*
+
+#include "orionld/types/OrionLdRestService.h"                  // OrionLdRestService, ORION_LD_SERVICE_PREFIX_LEN
+#include "orionld/types/OrionldServiceTrieNode.h"              // OrionldServiceTrieNode, ORIONLD_SERVICE_TRIE_WILDCARDS
+#include "orionld/service/orionldServiceTrieBuild.h"           // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// trieNodeCreate -
+//
+static OrionldServiceTrieNode* trieNodeCreate(const char* segment, int segmentLen)
+{
+  OrionldServiceTrieNode* nodeP = (OrionldServiceTrieNode*) calloc(1, sizeof(OrionldServiceTrieNode));
+
+  if (nodeP == NULL)
+    LM_X(1, ("Out of memory allocating a service router node"));
+
+  nodeP->segment    = segment;
+  nodeP->segmentLen = segmentLen;
+  nodeP->exactIx    = -1;
+  nodeP->minIx      = 0x7FFFFFFF;
+
+  return nodeP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// trieChildGet - find the child of a node, for a path segment - create it if not found
+//
+// The children are kept in insertion order, which is the order of the service vector.
+// That way, the children of the most used URL paths (the entities) are found first.
+//
+static OrionldServiceTrieNode* trieChildGet(OrionldServiceTrieNode* nodeP, const char* segment, int segmentLen)
+{
+  OrionldServiceTrieNode* lastP = NULL;
+
+  for (OrionldServiceTrieNode* childP = nodeP->children; childP != NULL; childP = childP->next)
+  {
+    if ((childP->segmentLen == segmentLen) && (strncmp(childP->segment, segment, segmentLen) == 0))
+      return childP;
+
+    lastP = childP;
+  }
+
+  OrionldServiceTrieNode* childP = trieNodeCreate(segment, segmentLen);
+
+  if (lastP == NULL)
+    nodeP->children = childP;
+  else
+    lastP->next = childP;
+
+  return childP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldServiceTrieBuild -
+//
+// Called by orionldServiceInit, once per service vector (verb), after the services have been prepared
+// (restServicePrepare has counted the wildcards and extracted the string to match after the first wildcard).
+//
+// The URL paths are walked from the '/' that ends the "/ngsi-ld" prefix, one path segment at a time.
+// A wildcard must be an entire path segment ("/ngsi-ld/v1/entities/*/attrs"), and only the part before the first
+// wildcard goes into the trie. What comes after the first wildcard is matched by orionldServiceTrieMatch, exactly
+// like before the router existed:
+//   - "/ngsi-ld/v1/entities/*":          anything non-empty
+//   - "/ngsi-ld/v1/entities/*/attrs":    anything non-empty ending in "/attrs"
+//   - "/ngsi-ld/v1/entities/*/attrs/*":  anything non-empty containing "/attrs/"
+//
+void orionldServiceTrieBuild(OrionLdRestServiceVector* serviceV)
+{
+  OrionldServiceTrieNode* rootP = trieNodeCreate(NULL, 0);
+
+  for (int sIx = 0; sIx < serviceV->services; sIx++)
+  {
+    OrionLdRestService*     serviceP = &serviceV->serviceV[sIx];
+    OrionldServiceTrieNode* nodeP    = rootP;
+    const char*             s        = &serviceP->url[ORION_LD_SERVICE_PREFIX_LEN - 1];
+
+    if (strncmp(serviceP->url, "/ngsi-ld/", ORION_LD_SERVICE_PREFIX_LEN) != 0)
+      LM_X(1, ("Invalid URL path for a service: '%s' - must start with '/ngsi-ld/'", serviceP->url));
+
+    if (nodeP->minIx > sIx)
+      nodeP->minIx = sIx;
+
+    while (1)
+    {
+      if (*s == 0)
+      {
+        // The first service in the vector wins - same as with the linear lookup
+        if (nodeP->exactIx == -1)
+          nodeP->exactIx = sIx;
+        break;
+      }
+
+      // *s == '/'
+      const char* segment = &s[1];
+
+      if (*segment == '*')
+      {
+        if (nodeP->wildcards >= ORIONLD_SERVICE_TRIE_WILDCARDS)
+          LM_X(1, ("Too many wildcard services after '%.*s' (max %d) - '%s'", nodeP->segmentLen, nodeP->segment, ORIONLD_SERVICE_TRIE_WILDCARDS, serviceP->url));
+
+        nodeP->wildcardIxV[nodeP->wildcards++] = sIx;
+        break;
+      }
+
+      const char* segmentEnd = segment;
+      while ((*segmentEnd != 0) && (*segmentEnd != '/'))
+      {
+        if (*segmentEnd == '*')
+          LM_X(1, ("Invalid URL path for a service: '%s' - a wildcard must be an entire path segment", serviceP->url));
+        ++segmentEnd;
+      }
+
+      nodeP = trieChildGet(nodeP, segment, segmentEnd - segment);
+      if (nodeP->minIx > sIx)
+        nodeP->minIx = sIx;
+
+      s = segmentEnd;
+    }
+  }
+
+  serviceV->trie = rootP;
+}
@@ -0,0 +1,138 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                            // strncmp, strstr, strlen
+
+#include "orionld/types/OrionLdRestService.h"                  // OrionLdRestService, ORION_LD_SERVICE_PREFIX_LEN
+#include "orionld/types/OrionldServiceTrieNode.h"              // OrionldServiceTrieNode
+#include "orionld/service/orionldServiceTrieMatch.h"           // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// wildcardMatch - does 'rest' (the URL path after the static part of a service) match the service?
+//
+// The end of the URL path is only needed for services like "/ngsi-ld/v1/entities/*/attrs" (an ending to match).
+// It is looked up the first time it is needed and then kept in *endP for the rest of the lookup.
+//
+static bool wildcardMatch(OrionLdRestService* serviceP, const char* rest, const char** endP, const char** matchP)
+{
+  if (serviceP->wildcards >= 2)
+  {
+    *matchP = strstr(rest, serviceP->matchForSecondWildcard);
+    return (*matchP != NULL);
+  }
+
+  if (serviceP->matchForSecondWildcardLen == 0)
+    return true;
+
+  if (*endP == NULL)
+    *endP = &rest[strlen(rest)];
+
+  if (*endP - rest < serviceP->matchForSecondWildcardLen)
+    return false;
+
+  return (strncmp(*endP - serviceP->matchForSecondWildcardLen, serviceP->matchForSecondWildcard, serviceP->matchForSecondWildcardLen) == 0);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// orionldServiceTrieMatch - find the service for a URL path
+//
+// RETURN VALUE
+//   The index of the service in serviceV->serviceV, or -1 if no service matches.
+//   As with a linear search, the service that comes first in the vector is chosen if more than one service matches.
+//
+// OUTPUT PARAMETERS
+//   *restP   The start of the first wildcard, inside 'urlPath' (for services with wildcards)
+//   *matchP  Where the string between the first and second wildcard was found (for services with two or more wildcards)
+//
+// The URL path is walked once, one path segment per trie node. At each node, the wildcard services of the node
+// are tried on what remains of the URL path, and where the URL path ends, the service that ends at the node (if any)
+// is considered.
+// Nothing is allocated and the URL path is not modified - it's up to the caller to extract the wildcards.
+//
+// The URL path must start with "/ngsi-ld/" - mhdConnectionTreat makes sure of that.
+//
+int orionldServiceTrieMatch(OrionLdRestServiceVector* serviceV, const char* urlPath, const char** restP, const char** matchP)
+{
+  OrionldServiceTrieNode* nodeP  = serviceV->trie;
+  const char*             s      = &urlPath[ORION_LD_SERVICE_PREFIX_LEN - 1];  // The '/' after "/ngsi-ld"
+  const char*             end    = NULL;
+  int                     bestIx = -1;
+
+  while (nodeP != NULL)
+  {
+    if (*s == 0)
+    {
+      if ((nodeP->exactIx != -1) && ((bestIx == -1) || (nodeP->exactIx < bestIx)))
+        bestIx = nodeP->exactIx;
+      break;
+    }
+
+    // *s == '/'
+    const char* rest = &s[1];
+
+    if ((nodeP->wildcards != 0) && (*rest != 0))
+    {
+      for (int ix = 0; ix < nodeP->wildcards; ix++)
+      {
+        int         sIx   = nodeP->wildcardIxV[ix];
+        const char* match = NULL;
+
+        if ((bestIx != -1) && (sIx > bestIx))
+          break;
+
+        if (wildcardMatch(&serviceV->serviceV[sIx], rest, &end, &match) == true)
+        {
+          bestIx  = sIx;
+          *restP  = rest;
+          *matchP = match;
+          break;
+        }
+      }
+    }
+
+    const char* segmentEnd = rest;
+    while ((*segmentEnd != 0) && (*segmentEnd != '/'))
+      ++segmentEnd;
+
+    int                     segmentLen = segmentEnd - rest;
+    OrionldServiceTrieNode* childP     = nodeP->children;
+
+    while ((childP != NULL) && ((childP->segmentLen != segmentLen) || (strncmp(childP->segment, rest, segmentLen) != 0)))
+      childP = childP->next;
+
+    if ((childP != NULL) && (bestIx != -1) && (childP->minIx > bestIx))
+      break;  // Nothing further down can beat the service already found
+
+    nodeP = childP;
+    s     = segmentEnd;
+  }
+
+  return bestIx;
+}
@@ -25,7 +25,6 @@
 extern "C"
 {
 #include "kjson/KjNode.h"                                        // KjNode
-#include "kjson/kjFree.h"                                        // kjFree
 }
 
 #include "logMsg/logMsg.h"                                       // LM_*
@@ -34,9 +33,9 @@ extern "C"
 #include "orionld/common/orionldError.h"                         // orionldError
 #include "orionld/context/orionldCoreContext.h"                  // orionldCoreContextP
 #include "orionld/context/orionldContextFromUrl.h"               // orionldContextFromUrl
-#include "orionld/contextCache/orionldContextCache.h"            // Context Cache Internals
 #include "orionld/contextCache/orionldContextCacheLookup.h"      // orionldContextCacheLookup
-#include "orionld/contextCache/orionldContextCacheDelete.h"      // orionldContextCacheDelete
+#include "orionld/contextCache/orionldContextCacheDelete.h"      // orionldContextCacheDelete, orionldContextCacheRetire
+#include "orionld/contextCache/orionldContextCacheRemove.h"      // orionldContextCacheRemove
 #include "orionld/contextCache/orionldContextCacheInsert.h"      // orionldContextCacheInsert
 #include "orionld/serviceRoutines/orionldDeleteContext.h"        // Own Interface
 
@@ -77,18 +76,7 @@ bool orionldDeleteContext(void)
     //
     // Remove old context from cache (and keep a pointer to) the old context
     //
-    bool done = false;
-    for (int ix = 0; ix < orionldContextCacheSlotIx; ix++)
-    {
-      if (orionldContextCache[ix] == oldContextP)
-      {
-        orionldContextCache[ix] = NULL;
-        done = true;
-        break;
-      }
-    }
-
-    if (done == false)
+    if (orionldContextCacheRemove(oldContextP) == false)
     {
       orionldError(OrionldInternalError, "Context Cache Error", "context to be reloaded not found in cache", 500);
       return false;
@@ -109,8 +97,8 @@ bool orionldDeleteContext(void)
     contextP->createdAt      = oldContextP->createdAt;
     contextP->usedAt         = orionldState.requestTime;
 
-    // Free the kj tree of the now obsolete old context
-    kjFree(oldContextP->tree);
+    // Free the kj tree of the now obsolete old context (once no lookup can be looking at it)
+    orionldContextCacheRetire(oldContextP);
   }
   else
   {
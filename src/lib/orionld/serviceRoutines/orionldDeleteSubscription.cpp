@@ -24,6 +24,7 @@
 */
 #include "logMsg/logMsg.h"                                       // LM_*
 
+#include "common/sem.h"                                          // cacheSemTake, cacheSemGive
 #include "cache/subCache.h"                                      // CachedSubscription, subCacheItemLookup, ...
 
 #include "orionld/common/orionldState.h"                         // orionldState
@@ -108,7 +109,10 @@ bool orionldDeleteSubscription(void)
       }
     }
 
+    // Writers of the sub-cache list are serialized by the cache semaphore (readers don't need it)
+    cacheSemTake(__FUNCTION__, "Removing subscription from cache");
     subCacheItemRemove(cSubP);
+    cacheSemGive(__FUNCTION__, "Removing subscription from cache");
   }
 
   orionldState.httpStatusCode = 204;
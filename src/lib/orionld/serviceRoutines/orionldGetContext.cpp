@@ -26,11 +26,13 @@ extern "C"
 {
 #include "kjson/KjNode.h"                                        // KjNode
 #include "kjson/kjBuilder.h"                                     // kjObject, kjString, kjBoolean, ...
+#include "kjson/kjClone.h"                                       // kjClone
 }
 
 #include "logMsg/logMsg.h"                                       // LM_*
 #include "logMsg/traceLevels.h"                                  // Lmt*
 
+#include "epoch/epoch.h"                                         // epochEnter, epochLeave
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/orionldError.h"                         // orionldError
 #include "orionld/contextCache/orionldContextCacheLookup.h"      // orionldContextCacheLookup
@@ -39,16 +41,15 @@ extern "C"
 
 
 extern KjNode* orionldContextWithDetails(OrionldContext* contextP);
+
+
+
 // ----------------------------------------------------------------------------
 //
-// orionldGetContext -
+// contextServe -
 //
-bool orionldGetContext(void)
+static bool contextServe(OrionldContext* contextP)
 {
-  OrionldContext* contextP    = orionldContextCacheLookup(orionldState.wildcard[0]);
-
-  orionldState.noLinkHeader = true;  // We don't want the Link header for context requests
-
   if (contextP == NULL)
   {
     orionldError(OrionldResourceNotFound, "Context Not Found", orionldState.wildcard[0], 404);
@@ -70,16 +71,46 @@ bool orionldGetContext(void)
     orionldState.responseTree = orionldContextWithDetails(contextP);
   else
   {
+    KjNode* treeP = __atomic_load_n(&contextP->tree, __ATOMIC_ACQUIRE);
+
+    if (treeP == NULL)  // Deleted meanwhile
+    {
+      orionldError(OrionldResourceNotFound, "Context Not Found", orionldState.wildcard[0], 404);
+      return false;
+    }
+
     orionldState.responseTree = kjObject(orionldState.kjsonP, NULL);
-    if (orionldState.responseTree == NULL)
+    treeP                     = kjClone(orionldState.kjsonP, treeP);  // The cached tree is shared - not to be modified
+
+    if ((orionldState.responseTree == NULL) || (treeP == NULL))
     {
       orionldError(OrionldBadRequestData, "kjObject failed", "out of memory?", 500);
       return false;
     }
 
-    contextP->tree->name = (char*) "@context";
-    kjChildAdd(orionldState.responseTree, contextP->tree);
+    treeP->name = (char*) "@context";
+    kjChildAdd(orionldState.responseTree, treeP);
   }
 
   return true;
 }
+
+
+
+// ----------------------------------------------------------------------------
+//
+// orionldGetContext -
+//
+// The tree of the context is cloned into the response inside a read section - a DELETE or a reload/revalidation
+// of the context retires the tree of the cached context, and the response is rendered after the read section has ended.
+//
+bool orionldGetContext(void)
+{
+  orionldState.noLinkHeader = true;  // We don't want the Link header for context requests
+
+  epochEnter();
+  bool ok = contextServe(orionldContextCacheLookup(orionldState.wildcard[0]));
+  epochLeave();
+
+  return ok;
+}
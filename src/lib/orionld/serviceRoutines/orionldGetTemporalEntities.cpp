@@ -22,11 +22,22 @@
 *
 * Author: Ken Zangelin
 */
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
 #include "logMsg/logMsg.h"
 
 #include "orionld/types/OrionLdRestService.h"                    // OrionLdRestService
+#include "orionld/types/OrionldGeoInfo.h"                        // OrionldGeoInfo
+#include "orionld/types/QNode.h"                                 // QNode
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/orionldError.h"                         // orionldError
+#include "orionld/payloadCheck/pCheckQueryParams.h"              // pCheckQueryParams
+#include "orionld/troe/troeQueryParams.h"                        // troeQueryParams
+#include "orionld/troe/pgTemporalQuery.h"                        // pgTemporalQuery
 #include "orionld/serviceRoutines/orionldGetTemporalEntities.h"  // Own Interface
 
 
@@ -35,9 +46,47 @@
 //
 // orionldGetTemporalEntities -
 //
+// Without TRoE (-troe), this service is for Mintaka (see orionldServiceInit), and this function isn't reached.
+// With TRoE, the temporal query is resolved by the broker itself, on the TRoE database of the tenant.
+//
 bool orionldGetTemporalEntities(void)
 {
-  orionldError(OrionldOperationNotSupported, "Not Implemented in Orion-LD, please use Mintaka for this operation", orionldState.serviceP->url, 501);
-  orionldState.noLinkHeader   = true;  // We don't want the Link header for non-implemented requests
-  return false;
+  char*          idPattern = orionldState.uriParams.idPattern;
+  QNode*         qNode     = NULL;
+  OrionldGeoInfo geoInfo;
+  TroeQuery      tq;
+
+  // According to the spec, id takes precedence over idPattern
+  if ((orionldState.in.idList.items > 0) && (idPattern != NULL))
+    idPattern = NULL;
+
+  if (pCheckQueryParams(orionldState.uriParams.id,
+                        orionldState.uriParams.type,
+                        idPattern,
+                        orionldState.uriParams.q,
+                        orionldState.uriParams.geometry,
+                        orionldState.uriParams.attrs,
+                        false,
+                        NULL,
+                        &qNode,
+                        &geoInfo) == false)
+    return false;
+
+  if (troeQueryParams(&tq) == false)
+    return false;
+
+  tq.idList    = &orionldState.in.idList;
+  tq.typeList  = &orionldState.in.typeList;
+  tq.idPattern = idPattern;
+  tq.qNode     = qNode;
+  tq.geoInfoP  = &geoInfo;
+
+  KjNode* entityArray = pgTemporalQuery(&tq);
+  if (entityArray == NULL)
+    return false;
+
+  orionldState.responseTree   = entityArray;
+  orionldState.httpStatusCode = 200;
+
+  return true;
 }
@@ -22,11 +22,21 @@
 *
 * Author: Ken Zangelin
 */
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
 #include "logMsg/logMsg.h"
 
 #include "orionld/types/OrionLdRestService.h"                    // OrionLdRestService
+#include "orionld/types/StringArray.h"                           // StringArray
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
 #include "orionld/common/orionldState.h"                         // orionldState
 #include "orionld/common/orionldError.h"                         // orionldError
+#include "orionld/payloadCheck/pCheckUri.h"                      // pCheckUri
+#include "orionld/troe/troeQueryParams.h"                        // troeQueryParams
+#include "orionld/troe/pgTemporalQuery.h"                        // pgTemporalQuery
 #include "orionld/serviceRoutines/orionldGetTemporalEntity.h"    // Own Interface
 
 
@@ -35,9 +45,37 @@
 //
 // orionldGetTemporalEntity -
 //
+// Without TRoE (-troe), this service is for Mintaka (see orionldServiceInit), and this function isn't reached.
+// With TRoE, the temporal query is resolved by the broker itself, on the TRoE database of the tenant.
+//
 bool orionldGetTemporalEntity(void)
 {
-  orionldError(OrionldOperationNotSupported, "Not Implemented in Orion-LD, please use Mintaka for this operation", orionldState.serviceP->url, 501);
-  orionldState.noLinkHeader   = true;  // We don't want the Link header for non-implemented requests
-  return false;
+  char*       entityId = orionldState.wildcard[0];
+  StringArray idList   = { 1, &entityId };
+  TroeQuery   tq;
+
+  if (pCheckUri(entityId, "Entity ID in URL PATH", true) == false)
+    return false;
+
+  if (troeQueryParams(&tq) == false)
+    return false;
+
+  tq.idList = &idList;
+  tq.offset = 0;
+  tq.limit  = 1;
+
+  KjNode* entityArray = pgTemporalQuery(&tq);
+  if (entityArray == NULL)
+    return false;
+
+  if (entityArray->value.firstChildP == NULL)
+  {
+    orionldError(OrionldResourceNotFound, "Entity Not Found", entityId, 404);
+    return false;
+  }
+
+  orionldState.responseTree   = entityArray->value.firstChildP;
+  orionldState.httpStatusCode = 200;
+
+  return true;
 }
@@ -22,39 +22,33 @@
 *
 * Author: Ken Zangelin
 */
-#include <string>                                              // std::string
 #include <vector>                                              // std::vector
 
 extern "C"
 {
-#include "kalloc/kaAlloc.h"                                    // kaAlloc
 #include "kalloc/kaStrdup.h"                                   // kaStrdup
 #include "kjson/kjLookup.h"                                    // kjLookup
 #include "kjson/kjBuilder.h"                                   // kjChildAdd, ...
-#include "kjson/kjClone.h"                                     // kjClone
-#include "kjson/kjFree.h"                                      // kjFree
-#include "kjson/kjRenderSize.h"                                // kjFastRenderSize
 #include "kjson/kjRender.h"                                    // kjFastRender
 }
 
 #include "logMsg/logMsg.h"                                     // LM_*
 
-#include "cache/subCache.h"                                    // CachedSubscription, subCacheItemLookup
+#include "common/sem.h"                                        // cacheSemTake, cacheSemGive
+#include "cache/subCache.h"                                    // CachedSubscription, subCacheItemLookup, subCacheState
 
-#include "orionld/types/OrionldMimeType.h"                     // mimeTypeFromString
-#include "orionld/types/KeyValue.h"                            // KeyValue, keyValueLookup, keyValueAdd
 #include "orionld/types/MqttInfo.h"                            // MqttInfo
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/common/orionldError.h"                       // orionldError
-#include "orionld/common/urlParse.h"                           // urlParse
-#include "orionld/common/dateTime.h"                           // dateTimeFromString
-#include "orionld/context/orionldAttributeExpand.h"            // orionldAttributeExpand
+#include "orionld/common/subCacheApiSubscriptionInsert.h"      // subCacheApiSubscriptionReplace
+#include "orionld/context/orionldContextFromUrl.h"             // orionldContextFromUrl
 #include "orionld/payloadCheck/PCHECK.h"                       // PCHECK_URI
 #include "orionld/payloadCheck/pCheckSubscription.h"           // pCheckSubscription
 #include "orionld/q/qRelease.h"                                // qRelease
 #include "orionld/mongoc/mongocSubscriptionLookup.h"           // mongocSubscriptionLookup
 #include "orionld/mongoc/mongocSubscriptionReplace.h"          // mongocSubscriptionReplace
 #include "orionld/dbModel/dbModelFromApiSubscription.h"        // dbModelFromApiSubscription
+#include "orionld/dbModel/dbModelToApiSubscription.h"          // dbModelToApiSubscription
 #include "orionld/mqtt/mqttConnectionEstablish.h"              // mqttConnectionEstablish
 #include "orionld/mqtt/mqttDisconnect.h"                       // mqttDisconnect
 #include "orionld/mqtt/mqttParse.h"                            // mqttParse
@@ -111,13 +105,11 @@ static bool okToRemove(const char* fieldName)
 // If "geoQ" replaces "expression", then we may need to maintain the "q" inside the old "expression".
 // OR, if "q" is also in the patch tree, then we'll simply move it inside "expression" (former "geoQ").
 //
-static bool ngsildSubscriptionPatch(KjNode* dbSubscriptionP, CachedSubscription* cSubP, KjNode* patchTree, KjNode* qP, KjNode* expressionP, char* qRenderedForDb)
+static bool ngsildSubscriptionPatch(KjNode* dbSubscriptionP, KjNode* patchTree, KjNode* qP, KjNode* expressionP, char* qRenderedForDb)
 {
   KjNode* fragmentP = patchTree->value.firstChildP;
   KjNode* next;
 
-  cSubP->modifiedAt = orionldState.requestTime;
-
   while (fragmentP != NULL)
   {
     next = fragmentP->next;
@@ -143,22 +135,6 @@ static bool ngsildSubscriptionPatch(KjNode* dbSubscriptionP, CachedSubscription*
     {
       if ((fragmentP != qP) && (fragmentP != expressionP))
         kjChildAddOrReplace(dbSubscriptionP, fragmentP->name, fragmentP);
-
-      if (strcmp(fragmentP->name, "status") == 0)
-      {
-        if (strcmp(fragmentP->value.s, "active") == 0)
-        {
-          LM_T(LmtSR, ("Setting subscription to ACTIVE in cache"));
-          cSubP->isActive = true;
-          cSubP->status   = "active";
-        }
-        else
-        {
-          LM_T(LmtSR, ("Setting subscription to INACTIVE/PAUSED in cache"));
-          cSubP->isActive = false;
-          cSubP->status   = "paused";
-        }
-      }
     }
 
     fragmentP = next;
@@ -318,409 +294,66 @@ static void fixDbSubscription(KjNode* dbSubscriptionP, char* qRenderedForDb)
 
 // -----------------------------------------------------------------------------
 //
-// subCacheItemUpdateEntities -
-//
-static bool subCacheItemUpdateEntities(CachedSubscription* cSubP, KjNode* entityArray)
-{
-  //
-  // To replace "entities", we first need to frre up the old "entities"
-  //
-  for (long unsigned int ix = 0; ix < cSubP->entityIdInfos.size(); ix++)
-  {
-    cSubP->entityIdInfos[ix]->release();
-    delete cSubP->entityIdInfos[ix];
-  }
-  cSubP->entityIdInfos.clear();
-
-  for (KjNode* entityP = entityArray->value.firstChildP; entityP != NULL; entityP = entityP->next)
-  {
-    KjNode*      idP          = kjLookup(entityP, "id");
-    KjNode*      idPatternP   = kjLookup(entityP, "idPattern");
-    KjNode*      typeP        = kjLookup(entityP, "type");
-    EntityInfo*  entityInfoP;
-
-    if ((idP == NULL) && (idPatternP == NULL))
-      entityInfoP = new EntityInfo(".*", std::string(typeP->value.s), "true", false);
-    else if (idP != NULL)
-      entityInfoP = new EntityInfo(std::string(idP->value.s), std::string(typeP->value.s), "false", false);
-    else
-      entityInfoP = new EntityInfo(std::string(idPatternP->value.s), std::string(typeP->value.s), "true", false);
-
-    cSubP->entityIdInfos.push_back(entityInfoP);
-  }
-
-  return true;
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// subCacheItemUpdateWatchedAttributes -
-//
-static bool subCacheItemUpdateWatchedAttributes(CachedSubscription* cSubP, KjNode* itemP)
-{
-  cSubP->notifyConditionV.clear();
-
-  int  attrs = 0;
-  for (KjNode* attrNodeP = itemP->value.firstChildP; attrNodeP != NULL; attrNodeP = attrNodeP->next)
-  {
-    char* longName = orionldAttributeExpand(orionldState.contextP, attrNodeP->value.s, true, NULL);
-
-    cSubP->notifyConditionV.push_back(longName);
-    ++attrs;
-  }
-
-  if ((int) cSubP->notifyConditionV.size() != attrs)
-    LM_RE(false, ("Expected %d items in watchedAttributes list - there are %d !!!", attrs, cSubP->notifyConditionV.size()));
-
-  return true;
-}
-
-
-
-// -----------------------------------------------------------------------------
-//
-// subCacheItemUpdateGeoQ -
-//
-static bool subCacheItemUpdateGeoQ(CachedSubscription* cSubP, KjNode* itemP)
-{
-  KjNode* geometryP     = kjLookup(itemP, "geometry");
-  KjNode* coordinatesP  = kjLookup(itemP, "coordinates");
-  KjNode* georelP       = kjLookup(itemP, "georel");
-  KjNode* geopropertyP  = kjLookup(itemP, "geoproperty");
-
-  if (geometryP    != NULL) cSubP->expression.geometry    = geometryP->value.s;
-  if (georelP      != NULL) cSubP->expression.georel      = georelP->value.s;
-  if (geopropertyP != NULL) cSubP->expression.geoproperty = geopropertyP->value.s;
-
-  if (coordinatesP != NULL)
-  {
-    int   coordsSize = kjFastRenderSize(coordinatesP) + 100;
-    char* coords     = kaAlloc(&orionldState.kalloc, coordsSize);
-
-    kjFastRender(coordinatesP, coords);
-    cSubP->expression.coords = coords;  // Not sure this is 100% correct format, but is it used? DB is used for Geo ...
-  }
-
-  return true;
-}
-
-
-
-// -----------------------------------------------------------------------------
+// subCacheItemUpdate -
 //
-// subCacheItemUpdateNotificationEndpoint -
+// The cached subscription isn't patched in place, as alteration matching reads it without any lock.
+// Instead, a new version of the cached subscription is created from the (already patched) DB subscription,
+// just like the sub-cache refresh does it, and the new version replaces the old one.
 //
-static bool subCacheItemUpdateNotificationEndpoint(CachedSubscription* cSubP, KjNode* endpointP)
-{
-  KjNode* uriP           = kjLookup(endpointP, "uri");
-  KjNode* acceptP        = kjLookup(endpointP, "accept");
-  KjNode* receiverInfoP  = kjLookup(endpointP, "receiverInfo");
-  KjNode* notifierInfoP  = kjLookup(endpointP, "notifierInfo");
-
-  if (uriP != NULL)
-  {
-    char*           protocol;
-    char*           ip;
-    unsigned short  port;
-    char*           rest;
-    char*           url = strdup(uriP->value.s);
-    char            urlCopy[1024];
-
-    strncpy(urlCopy, url, sizeof(urlCopy) - 1);
-
-    if (strncmp(uriP->value.s, "mqtt", 4) == 0)
-    {
-      char            mqttUrl[512];
-      bool            mqtts         = false;
-      char*           mqttUser      = NULL;
-      char*           mqttPassword  = NULL;
-      char*           mqttHost      = NULL;
-      unsigned short  mqttPort      = 0;
-      char*           mqttTopic     = NULL;
-      char*           detail        = NULL;
-
-      strncpy(mqttUrl, uriP->value.s, sizeof(mqttUrl) - 1);
-      if (mqttParse(mqttUrl, &mqtts, &mqttUser, &mqttPassword, &mqttHost, &mqttPort, &mqttTopic, &detail) == false)
-      {
-        free(url);
-        LM_E(("Internal Error (unable to parse mqtt URL)"));
-        return false;
-      }
-
-      if (mqttUser     != NULL) strncpy(cSubP->httpInfo.mqtt.username, mqttUser,     sizeof(cSubP->httpInfo.mqtt.username) - 1);
-      if (mqttPassword != NULL) strncpy(cSubP->httpInfo.mqtt.password, mqttPassword, sizeof(cSubP->httpInfo.mqtt.password) - 1);
-      if (mqttHost     != NULL) strncpy(cSubP->httpInfo.mqtt.host,     mqttHost,     sizeof(cSubP->httpInfo.mqtt.host) - 1);
-      if (mqttTopic    != NULL) strncpy(cSubP->httpInfo.mqtt.topic,    mqttTopic,    sizeof(cSubP->httpInfo.mqtt.topic) - 1);
-
-      cSubP->httpInfo.mqtt.mqtts = mqtts;
-      cSubP->httpInfo.mqtt.port  = mqttPort;
-    }
-
-    //
-    // FIXME: if mqtt, I parse the URL twice, and save IP, port + rest (topic) twice as well
-    //        I should remove the MQTT info from HttpInfo and save directly in CachedSubscription - next to protocol, ip, port, rest
-    //
-    if (urlParse(urlCopy, &protocol, &ip, &port, &rest) == true)
-    {
-      if (cSubP->url != NULL)
-        free(cSubP->url);
-      cSubP->url = url;
-      cSubP->httpInfo.url = url;
-
-      if (cSubP->protocolString != NULL)
-        free(cSubP->protocolString);
-      cSubP->protocolString = strdup(protocol);
-
-      if (cSubP->ip != NULL)
-        free(cSubP->ip);
-      cSubP->ip = strdup(ip);
-
-      if (cSubP->rest != NULL)
-        free(cSubP->rest);
-      cSubP->rest = strdup(rest);
-
-      cSubP->port           = port;
-      cSubP->protocol       = protocolFromString(cSubP->protocolString);
-    }
-    else
-    {
-      LM_W(("Invalid url '%s'", uriP->value.s));
-      free(url);
-      return false;
-    }
-  }
-
-  if (acceptP != NULL)
-  {
-    uint32_t acceptMask;
-    cSubP->httpInfo.mimeType = mimeTypeFromString(acceptP->value.s, NULL, true, false, &acceptMask);
-  }
-
-  if (receiverInfoP != NULL)
-  {
-    //
-    // receiverInfo is stored in cSubP->httpInfo.headers
-    // - just set it (in the std::map)
-    //
-    for (KjNode* riP = receiverInfoP->value.firstChildP; riP != NULL; riP = riP->next)
-    {
-      KjNode*   keyP   = kjLookup(riP, "key");
-      KjNode*   valueP = kjLookup(riP, "value");
-
-      cSubP->httpInfo.headers[keyP->value.s] = valueP->value.s;
-    }
-  }
-
-  if (notifierInfoP != NULL)
-  {
-    //
-    // For each key-value pair in "notifierInfo":
-    //   - lookup the key in cSubP->httpInfo.notifierInfo
-    //   - replace the value if present, add it if not
-    //
-    for (KjNode* riP = notifierInfoP->value.firstChildP; riP != NULL; riP = riP->next)
-    {
-      KjNode*   keyP   = kjLookup(riP, "key");
-      KjNode*   valueP = kjLookup(riP, "value");
-      KeyValue* kvP    = keyValueLookup(cSubP->httpInfo.notifierInfo, keyP->value.s);
-
-      if (kvP != NULL)
-        strncpy(kvP->value, valueP->value.s, sizeof(kvP->value) - 1);
-      else
-        keyValueAdd(&cSubP->httpInfo.notifierInfo, keyP->value.s, valueP->value.s);
-    }
-  }
-
-  return true;
-}
-
-
-
-// -----------------------------------------------------------------------------
+// The cached subscription is looked up with the cache semaphore taken - else a concurrent sub-cache refresh
+// (or another PATCH) could replace it, and retire it, between the lookup and the replacement.
 //
-// subCacheItemUpdateNotification -
+// NOTE: dbModelToApiSubscription modifies dbSubscriptionP - it must not be used after calling this function
 //
-static bool subCacheItemUpdateNotification(CachedSubscription* cSubP, KjNode* itemP, KjNode* showChangesP)
+static bool subCacheItemUpdate(OrionldTenant* tenantP, const char* subscriptionId, KjNode* dbSubscriptionP, QNode* qNodeP)
 {
-  KjNode* attributesP = kjLookup(itemP, "attributes");
-  KjNode* formatP     = kjLookup(itemP, "format");
-  KjNode* endpointP   = kjLookup(itemP, "endpoint");
-
-  if (attributesP != NULL)  // Those present in the notification
-  {
-    cSubP->attributes.clear();
-    for (KjNode* attrNodeP = attributesP->value.firstChildP; attrNodeP != NULL; attrNodeP = attrNodeP->next)
-    {
-      char* longName = orionldAttributeExpand(orionldState.contextP, attrNodeP->value.s, true, NULL);
-      cSubP->attributes.push_back(longName);
-    }
-  }
-
-  if (formatP != NULL)
-    cSubP->renderFormat = stringToRenderFormat(formatP->value.s);
-
-  if (endpointP != NULL)
-    return subCacheItemUpdateNotificationEndpoint(cSubP, endpointP);
-
-  if (showChangesP != NULL)
-    cSubP->showChanges = showChangesP->value.b;
-
-  return true;
-}
+  QNode*              qTree          = NULL;
+  KjNode*             coordinatesP   = NULL;
+  KjNode*             contextNodeP   = NULL;
+  KjNode*             showChangesP   = NULL;
+  KjNode*             sysAttrsP      = NULL;
+  OrionldRenderFormat renderFormat   = RF_NORMALIZED;
+  double              timeInterval   = 0;
+  KjNode*             apiSubP        = dbModelToApiSubscription(dbSubscriptionP,
+                                                                tenantP->tenant,
+                                                                true,
+                                                                &qTree,
+                                                                &coordinatesP,
+                                                                &contextNodeP,
+                                                                &showChangesP,
+                                                                &sysAttrsP,
+                                                                &renderFormat,
+                                                                &timeInterval);
+
+  if (apiSubP == NULL)
+    LM_RE(false, ("Internal Error (unable to convert the patched subscription '%s' from the DB model)", subscriptionId));
+
+  // The q-tree of the PATCH is already built - else, it is built from 'ldQ' on first use
+  if (qNodeP != NULL)
+    qTree = qNodeP;
 
+  OrionldContext* contextP = NULL;
+  if (contextNodeP != NULL)
+    contextP = orionldContextFromUrl(contextNodeP->value.s, NULL);
 
+  cacheSemTake(__FUNCTION__, "Updating a cached subscription");
 
-// -----------------------------------------------------------------------------
-//
-// subCacheItemUpdate -
-//
-static bool subCacheItemUpdate
-(
-  OrionldTenant* tenantP,
-  const char*    subscriptionId,
-  KjNode*        subscriptionTree,
-  KjNode*        geoCoordinatesP,
-  QNode*         qNodeP,
-  char*          qText,
-  KjNode*        showChangesP
-)
-{
   CachedSubscription* cSubP = subCacheItemLookup(tenantP->tenant, subscriptionId);
-  bool                r     = true;
 
   if (cSubP == NULL)
-    LM_RE(false, ("Internal Error (can't find the subscription '%s' in the subscription cache)", subscriptionId));
-
-  cacheSemTake(__FUNCTION__, "Updating a cached subscription");
-  subCacheState = ScsSynchronizing;
-
-  if (geoCoordinatesP != NULL)
-  {
-    if (cSubP->geoCoordinatesP != NULL)
-      kjFree(cSubP->geoCoordinatesP);
-    cSubP->geoCoordinatesP = kjClone(NULL, geoCoordinatesP);
-  }
-
-  if (qNodeP != NULL)
-  {
-    if (cSubP->qText != NULL)
-      free(cSubP->qText);
-
-    cSubP->qText = strdup(qText);
-  }
-
-  if (qNodeP != NULL)
   {
-    if (cSubP->qP != NULL)
-      qRelease(cSubP->qP);
-
-    cSubP->qP = qNodeP;
+    cacheSemGive(__FUNCTION__, "Cached subscription not found");
+    LM_RE(false, ("Internal Error (can't find the subscription '%s' in the subscription cache)", subscriptionId));
   }
 
-  for (KjNode* itemP = subscriptionTree->value.firstChildP; itemP != NULL; itemP = itemP->next)
-  {
-    LM_T(LmtSR, ("Patching subscription fragment '%s' for sub-cache", itemP->name));
-
-    if ((strcmp(itemP->name, "subscriptionName") == 0) || (strcmp(itemP->name, "name") == 0))
-      cSubP->name = itemP->value.s;
-    else if (strcmp(itemP->name, "description") == 0)
-    {
-      if (cSubP->description != NULL)
-        free(cSubP->description);
-      cSubP->description = strdup(itemP->value.s);
-    }
-    else if (strcmp(itemP->name, "entities") == 0)
-      subCacheItemUpdateEntities(cSubP, itemP);
-    else if (strcmp(itemP->name, "watchedAttributes") == 0)
-      subCacheItemUpdateWatchedAttributes(cSubP, itemP);
-    else if (strcmp(itemP->name, "timeInterval") == 0)
-    {
-      LM_W(("Not Implemented (Orion-LD doesn't implement periodical notifications"));
-    }
-    else if (strcmp(itemP->name, "lang") == 0)
-    {
-      cSubP->lang = itemP->value.s;
-    }
-    else if (strcmp(itemP->name, "q") == 0)
-    {
-      LM_T(LmtSR, ("Change in 'q' (%s)", itemP->value.s));
-      cSubP->expression.q = itemP->value.s;
-    }
-    else if (strcmp(itemP->name, "geoQ") == 0)
-    {
-      subCacheItemUpdateGeoQ(cSubP, itemP);
-    }
-    else if (strcmp(itemP->name, "csf") == 0)
-    {
-      //
-      // csf is not implemented (only used for Subscriptions on Context Source Registrations)
-      //
-      // cSubP->csf = itemP->value.s;
-    }
-    else if (strcmp(itemP->name, "isActive") == 0)
-    {
-      if (itemP->value.b == true)
-      {
-        LM_T(LmtSR, ("Setting subscription to ACTIVE in cache"));
-        cSubP->isActive = true;
-        cSubP->status   = "active";
-      }
-      else
-      {
-        LM_T(LmtSR, ("Setting subscription to INACTIVE/PAUSED in cache"));
-        cSubP->isActive = false;
-        cSubP->status   = "paused";
-      }
-    }
-    else if (strcmp(itemP->name, "notification") == 0)
-    {
-      subCacheItemUpdateNotification(cSubP, itemP, showChangesP);
-    }
-    else if ((strcmp(itemP->name, "expires") == 0) || (strcmp(itemP->name, "expiresAt") == 0))
-    {
-      char errorString[256];
+  subCacheState = ScsSynchronizing;
 
-      // Give error for expires/expiresAt and version of NGSI-LD ?
-      double expiresAt = dateTimeFromString(itemP->value.s, errorString, sizeof(errorString));
-
-      if (expiresAt > 0)
-        cSubP->expirationTime = expiresAt;
-      else
-      {
-        orionldError(OrionldBadRequestData, "Invalid ISO8601 for 'expiresAt'", errorString, 400);
-        r = false;
-      }
-    }
-    else if (strcmp(itemP->name, "throttling") == 0)
-    {
-      if (itemP->type == KjInt)
-        cSubP->throttling = (double) itemP->value.i;
-      else if (itemP->type == KjFloat)
-        cSubP->throttling = itemP->value.f;
-      else
-        LM_W(("Invalid type for 'throttling'"));
-    }
-    else if (strcmp(itemP->name, "scopeQ") == 0)
-    {
-      LM_W(("Not Implemented (Orion-LD doesn't support Multi-Type (yet)"));
-    }
-    else if (strcmp(itemP->name, "lang") == 0)
-    {
-      LM_W(("Not Implemented (Orion-LD doesn't support LanguageProperty just yet"));
-    }
-    else
-    {
-      orionldError(OrionldBadRequestData, "Invalid field for subscription patch", itemP->name, 400);
-      r = false;
-    }
-  }
+  subCacheApiSubscriptionReplace(cSubP, apiSubP, qTree, coordinatesP, contextP, tenantP->tenant, showChangesP, sysAttrsP, renderFormat);
 
   subCacheState = ScsIdle;
-
   cacheSemGive(__FUNCTION__, "Updated a cached subscription");
-  return r;
+
+  return true;
 }
 
 
@@ -959,7 +592,6 @@ bool orionldPatchSubscription(void)
   // FIXME: This is BAD ... shouldn't change the type of these fields
   //
   fixDbSubscription(dbSubscriptionP, qRenderedForDb);
-  KjNode* patchBody = kjClone(orionldState.kjsonP, orionldState.requestTree);
 
   dbModelFromApiSubscription(orionldState.requestTree, true);
 
@@ -969,12 +601,9 @@ bool orionldPatchSubscription(void)
   // modified.
   // ngsildSubscriptionPatch() performs that modification.
   //
-  CachedSubscription* cSubP = NULL;
-
   if (timeInterval == 0)
   {
-    cSubP = subCacheItemLookup(orionldState.tenantP->tenant, subscriptionId);
-    if (cSubP == NULL)
+    if (subCacheItemLookup(orionldState.tenantP->tenant, subscriptionId) == NULL)
     {
       orionldError(OrionldResourceNotFound, "Subscription not found", subscriptionId, 404);
       return false;
@@ -983,7 +612,7 @@ bool orionldPatchSubscription(void)
   else
     LM_X(131, ("Can't reach this point, right? ;-)"));
 
-  if (ngsildSubscriptionPatch(dbSubscriptionP, cSubP, orionldState.requestTree, qP, geoqP, qRenderedForDb) == false)
+  if (ngsildSubscriptionPatch(dbSubscriptionP, orionldState.requestTree, qP, geoqP, qRenderedForDb) == false)
   {
     if (qNodeP != NULL)
       qRelease(qNodeP);
@@ -1043,7 +672,7 @@ bool orionldPatchSubscription(void)
   // Modify the subscription in the subscription cache
   if (timeInterval == 0)
   {
-    if (subCacheItemUpdate(orionldState.tenantP, subscriptionId, patchBody, geoCoordinatesP, qNodeP, qRenderedForDb, showChangesP) == false)
+    if (subCacheItemUpdate(orionldState.tenantP, subscriptionId, dbSubscriptionP, qNodeP) == false)
       LM_E(("Internal Error (unable to update the cached subscription '%s' after a PATCH)", subscriptionId));
   }
   else
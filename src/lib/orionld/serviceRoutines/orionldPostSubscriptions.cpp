@@ -34,6 +34,7 @@ extern "C"
 
 #include "logMsg/logMsg.h"                                     // LM_*
 
+#include "common/sem.h"                                        // cacheSemTake, cacheSemGive
 #include "cache/subCache.h"                                    // subCacheItemLookup, CachedSubscription
 
 #include "orionld/types/QNode.h"                               // QNode
@@ -387,6 +388,8 @@ bool orionldPostSubscriptions(void)
 
   if (timeInterval == 0)
   {
+    // Writers of the sub-cache list are serialized by the cache semaphore (readers don't need it)
+    cacheSemTake(__FUNCTION__, "Inserting subscription in cache");
     cSubP = subCacheApiSubscriptionInsert(subP,
                                           qTree,
                                           geoCoordinatesP,
@@ -395,6 +398,7 @@ bool orionldPostSubscriptions(void)
                                           showChangesP,
                                           sysAttrsP,
                                           renderFormat);
+    cacheSemGive(__FUNCTION__, "Inserting subscription in cache");
   }
   else
   {
@@ -474,7 +478,11 @@ bool orionldPostSubscriptions(void)
       mqttDisconnect(mqttHost, mqttPort, mqttUser, mqttPassword, mqttVersion);
 
     if (cSubP != NULL)
+    {
+      cacheSemTake(__FUNCTION__, "Removing subscription from cache");
       subCacheItemRemove(cSubP);
+      cacheSemGive(__FUNCTION__, "Removing subscription from cache");
+    }
     else
       pernotItemRelease(pSubP);
 
@@ -22,7 +22,7 @@
 *
 * Author: Ken Zangelin
 */
-#include <string.h>                                            // strlen, strncpy
+#include <string.h>                                            // strlen, memcpy
 #include <stdlib.h>                                            // malloc
 
 #include "logMsg/logMsg.h"                                     // LM_*
@@ -50,10 +50,13 @@ void pgAppend(PgAppendBuffer* pgBufP, const char* tail, int tailLen)
 
     pgBufP->bufSize += 4 * 1024;  // Add 4k every time
 
+    if (pgBufP->bufSize <= pgBufP->currentIx + tailLen)  // 4k isn't enough for a big tail
+      pgBufP->bufSize = pgBufP->currentIx + tailLen + 4 * 1024;
+
     if (pgBufP->bufSize < 16 * 1024)  // Use kaAlloc for smaller buffers
     {
       pgBufP->buf = kaAlloc(&orionldState.kalloc, pgBufP->bufSize);
-      strncpy(pgBufP->buf, oldBuffer, pgBufP->currentIx + 1);
+      memcpy(pgBufP->buf, oldBuffer, pgBufP->currentIx + 1);
       oldBuffer = NULL;  // Must not be freed
     }
     else
@@ -67,14 +70,14 @@ void pgAppend(PgAppendBuffer* pgBufP, const char* tail, int tailLen)
       else
       {
         pgBufP->buf = (char*) malloc(pgBufP->bufSize);
-        strncpy(pgBufP->buf, oldBuffer, pgBufP->currentIx + 1);
+        memcpy(pgBufP->buf, oldBuffer, pgBufP->currentIx + 1);
       }
 
       pgBufP->allocated = true;
     }
   }
 
-  strncpy(&pgBufP->buf[pgBufP->currentIx], tail, tailLen);
+  memcpy(&pgBufP->buf[pgBufP->currentIx], tail, tailLen);  // memcpy, not strncpy - binary COPY tuples contain zeros
   pgBufP->currentIx += tailLen;
   pgBufP->buf[pgBufP->currentIx] = 0;
 }
@@ -28,7 +28,7 @@ extern "C"
 }
 
 #include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
-#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/common/orionldState.h"                       // orionldState, troeCopy
 #include "orionld/troe/pgAppendInit.h"                         // Own interface
 
 
@@ -45,4 +45,7 @@ void pgAppendInit(PgAppendBuffer* pgBufP, int initSize)
   pgBufP->allocated  = false;
   pgBufP->currentIx  = 0;
   pgBufP->values     = 0;
+  pgBufP->binary     = troeCopy;
+  pgBufP->copyStart  = 0;
+  pgBufP->pipeline   = false;
 }
@@ -45,6 +45,7 @@ extern "C"
 #include "orionld/troe/kjGeoMultiLineStringExtract.h"          // kjGeoMultiLineStringExtract
 #include "orionld/troe/kjGeoPolygonExtract.h"                  // kjGeoPolygonExtract
 #include "orionld/troe/kjGeoMultiPolygonExtract.h"             // kjGeoMultiPolygonExtract
+#include "orionld/troe/pgAttributeCopy.h"                      // pgAttributeCopy
 #include "orionld/troe/pgAttributeAppend.h"                    // Own interface
 
 
@@ -93,6 +94,12 @@ void pgAttributeAppend
   KjNode*          valueNodeP
 )
 {
+  if (attributesBufferP->binary == true)  // -troeCopy
+  {
+    pgAttributeCopy(attributesBufferP, instanceId, attributeName, opMode, entityId, type, observedAt, subProperties, unitCode, datasetId, valueNodeP);
+    return;
+  }
+
   char        localBuf[2 * 1024];
   int         bufSize = sizeof(localBuf);
   char*       buf     = localBuf;
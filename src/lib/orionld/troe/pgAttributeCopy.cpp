@@ -0,0 +1,125 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                            // strcmp
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                      // KjNode
+}
+
+#include "logMsg/logMsg.h"                                     // LM_*
+
+#include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
+#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/common/eqForDot.h"                           // eqForDot
+#include "orionld/troe/pgCopyAppend.h"                         // pgCopyTupleStart, pgCopyText, pgCopyBool, pgCopyNull, ...
+#include "orionld/troe/pgCopyValue.h"                          // pgCopyValueType, pgCopyValue, PG_VALUE_COLUMNS
+#include "orionld/troe/pgAttributeCopy.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgAttributeCopy -
+//
+// Tuple: instanceId, id, opMode, entityId, observedAt, subProperties, unitCode, datasetId, valueType,
+//        the PG_VALUE_COLUMNS value columns, ts
+//
+// Same rows as pgAttributeAppend, except that the values are binary - no SQL text to escape and for postgres to parse
+//
+void pgAttributeCopy
+(
+  PgAppendBuffer*  attributesBufferP,
+  const char*      instanceId,
+  char*            attributeName,
+  const char*      opMode,
+  const char*      entityId,
+  char*            type,
+  char*            observedAt,    // Can be NULL
+  bool             subProperties,
+  char*            unitCode,      // Can be NULL
+  char*            datasetId,     // Can be NULL
+  KjNode*          valueNodeP
+)
+{
+  const char* valueType = NULL;
+  int         column    = -1;
+  bool        deleted   = (strcmp(opMode, "Delete") == 0);
+
+  eqForDot(attributeName);
+
+  if (datasetId == NULL)
+    datasetId  = (char*) "None";
+
+  if (deleted == false)
+  {
+    if (type == NULL)
+      valueType = NULL;
+    else if ((strcmp(type, "Relationship") == 0) && ((valueNodeP == NULL) || (valueNodeP->type != KjString)))
+      valueType = NULL;  // Relationship arrays are not stored, see pgAttributeBuild
+    else if ((strcmp(type, "JsonProperty") == 0) && (valueNodeP != NULL) && ((valueNodeP->type == KjArray) || (valueNodeP->type == KjObject)))
+    {
+      LM_W(("TRoE for Compound JsonProperty still to be implemented"));
+      return;
+    }
+    else
+      valueType = pgCopyValueType(type, valueNodeP, &column);
+
+    if (valueType == NULL)
+    {
+      LM_W(("TROE: To Be Implemented"));
+      return;
+    }
+  }
+
+  pgCopyTupleStart(attributesBufferP, 9 + PG_VALUE_COLUMNS + 1);
+
+  pgCopyText(attributesBufferP, instanceId);
+  pgCopyText(attributesBufferP, attributeName);
+  pgCopyText(attributesBufferP, opMode);
+  pgCopyText(attributesBufferP, entityId);
+
+  if (deleted == true)
+  {
+    pgCopyNull(attributesBufferP);  // observedAt
+    pgCopyNull(attributesBufferP);  // subProperties
+    pgCopyNull(attributesBufferP);  // unitCode
+    pgCopyText(attributesBufferP, datasetId);
+    pgCopyNull(attributesBufferP);  // valueType
+  }
+  else
+  {
+    pgCopyDateTime(attributesBufferP, observedAt);
+    pgCopyBool(attributesBufferP, subProperties);
+    pgCopyText(attributesBufferP, unitCode);
+    pgCopyText(attributesBufferP, datasetId);
+    pgCopyText(attributesBufferP, valueType);
+  }
+
+  pgCopyValue(attributesBufferP, column, valueNodeP, NULL);
+  pgCopyTimestamp(attributesBufferP, orionldState.requestTime);
+
+  attributesBufferP->values += 1;
+}
@@ -0,0 +1,66 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
+#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgCopyCommands.h"                       // pgCopyCommands
+#include "orionld/troe/pgPipelineCommands.h"                   // pgPipelineCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgBuffersCommit -
+//
+void pgBuffersCommit(PgAppendBuffer* bufferV[], int buffers)
+{
+  PgAppendBuffer*  bufV[3];
+  char*            sqlV[3];
+  int              commands = 0;
+  bool             binary   = false;
+  bool             pipeline = false;
+
+  for (int ix = 0; (ix < buffers) && (commands < 3); ix++)
+  {
+    if (bufferV[ix]->values == 0)
+      continue;
+
+    binary          = bufferV[ix]->binary;
+    pipeline        = bufferV[ix]->pipeline;
+    sqlV[commands]  = bufferV[ix]->buf;
+    bufV[commands]  = bufferV[ix];
+    commands       += 1;
+  }
+
+  if (commands == 0)
+    return;
+
+  if (pipeline == true)
+    pgPipelineCommands(bufV, commands);
+  else if (binary == true)
+    pgCopyCommands(bufV, commands);
+  else
+    pgCommands(sqlV, commands);
+}
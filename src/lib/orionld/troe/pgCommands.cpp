@@ -33,6 +33,7 @@
 #include "orionld/troe/pgTransactionBegin.h"                   // pgTransactionBegin
 #include "orionld/troe/pgTransactionRollback.h"                // pgTransactionRollback
 #include "orionld/troe/pgTransactionCommit.h"                  // pgTransactionCommit
+#include "orionld/troe/troeWriter.h"                           // troeWriterEnqueue
 #include "orionld/troe/pgCommands.h"                           // Own interface
 
 
@@ -43,6 +44,12 @@
 //
 void pgCommands(char* sql[], int commands)
 {
+  //
+  // Group commit (-troeFlushInterval) - the TRoE writer takes over
+  //
+  if (troeWriterEnqueue(orionldState.tenantP->troeDbName, sql, commands) == true)
+    return;
+
   PgConnection* connectionP = pgConnectionGet(orionldState.tenantP->troeDbName);
 
   if ((connectionP == NULL) || (connectionP->connectionP == NULL))
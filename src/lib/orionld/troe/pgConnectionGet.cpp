@@ -22,14 +22,23 @@
 *
 * Author: Ken Zangelin
 */
+#include <pthread.h>                                           // pthread_mutex_lock, pthread_cond_timedwait
+#include <time.h>                                              // clock_gettime
+
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
 #include "orionld/types/PgConnectionPool.h"                    // PgConnectionPool
 #include "orionld/types/PgConnection.h"                        // PgConnection
-#include "orionld/common/orionldState.h"                       // troeHost, pgPortString, troeUser, troePwd
+#include "orionld/common/orionldState.h"                       // dbName, promPgPool*
+#include "orionld/prometheus/promCounterIncrease.h"            // promCounterIncrease
+#include "orionld/prometheus/promGaugeAdd.h"                   // promGaugeAdd
+#include "orionld/prometheus/promHistogramObserve.h"           // promHistogramObserve
 #include "orionld/troe/pgConnect.h"                            // pgConnect
 #include "orionld/troe/pgConnectionPoolGet.h"                  // pgConnectionPoolGet
+#include "orionld/troe/pgFreeListPop.h"                        // pgFreeListPop
+#include "orionld/troe/pgFreeListPush.h"                       // pgFreeListPush
+#include "orionld/troe/pgStatementsPrepare.h"                  // pgStatementsPrepare
 #include "orionld/troe/pgConnectionGet.h"                      // Own interface
 
 
@@ -57,10 +66,58 @@ static char* wsTrim(char* s)
 
 
 
+// -----------------------------------------------------------------------------
+//
+// connectionAwait - the pool is saturated - wait for a connection to be returned to it
+//
+static PgConnection* connectionAwait(PgConnectionPool* poolP)
+{
+  struct timespec  start;
+  struct timespec  now;
+  PgConnection*    cP;
+
+  promCounterIncrease(promPgPoolSaturated);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  pthread_mutex_lock(&poolP->waitMutex);
+  __atomic_add_fetch(&poolP->waiters, 1, __ATOMIC_SEQ_CST);
+
+  // After incrementing 'waiters', a connection returned to the pool is either seen here, or we're woken up by pgFreeListPush
+  while ((cP = pgFreeListPop(poolP)) == NULL)
+  {
+    struct timespec until;
+
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_nsec += 100000000;  // 100 ms - just in case
+    if (until.tv_nsec >= 1000000000)
+    {
+      until.tv_sec  += 1;
+      until.tv_nsec -= 1000000000;
+    }
+
+    pthread_cond_timedwait(&poolP->waitCond, &poolP->waitMutex, &until);
+  }
+
+  __atomic_sub_fetch(&poolP->waiters, 1, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&poolP->waitMutex);
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  promHistogramObserve(promPgPoolWaitTime, (now.tv_sec - start.tv_sec) + ((double) (now.tv_nsec - start.tv_nsec)) / 1000000000);
+
+  return cP;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // pgConnectionGet -
 //
+// The hot path is a single compare-and-swap on the free list of the pool.
+// Only a saturated pool makes the requester wait (on a condition variable), and only a connection that has never been
+// connected (or was closed for being idle, or was found to be broken) is connected here - the health checks of the
+// free connections are done by the pool monitor thread (pgPoolMonitor).
+//
 PgConnection* pgConnectionGet(const char* db)
 {
   char* _db = (char*)db;
@@ -77,145 +134,70 @@ PgConnection* pgConnectionGet(const char* db)
   if (_db != NULL)
     _db = wsTrim(_db);
 
-  // FIXME: Need a semaphore to protect the list of pools
   PgConnectionPool* poolP = pgConnectionPoolGet(_db);  // pgConnectionPoolGet creates the pool if it doesn't already exist
 
   if (poolP == NULL)
     LM_RE(NULL, ("unable to obtain a connection pool reference"));
 
-  // Await a free slot in the pool
-  sem_wait(&poolP->queueSem);
-
-  // Await the right to modify the pool
-  sem_wait(&poolP->poolSem);
+  PgConnection* cP = pgFreeListPop(poolP);
 
-  // Search for a free but already connected PgConnection in the pool
-  for (int ix = 0; ix < poolP->items; ix++)
-  {
-    PgConnection* cP = poolP->connectionV[ix];
-
-    if ((cP == NULL) || (cP->busy == true))
-      continue;
+  if (cP == NULL)
+    cP = connectionAwait(poolP);
 
-    if (cP->connectionP != NULL)
-    {
-      // check if we are still connected
-      ConnStatusType pgStatus = PQstatus(cP->connectionP);
-      if (pgStatus != CONNECTION_OK)
-      {
-        LM_W(("Connection of item %d is lost, trying to re-connect...", ix));
-        // try to re-connect
-        PQreset(cP->connectionP);
-        // get status again
-        pgStatus = PQstatus(cP->connectionP);
-
-        // if still no connection
-        if (pgStatus != CONNECTION_OK)
-        {
-          // we free this pointer that it can be used in the next call of pgConnectionGet
-          free(poolP->connectionV[ix]);
-          poolP->connectionV[ix] = NULL;
-          LM_W(("Connection failed, pointer of item %d was re-set to NULL (%p)", ix, poolP->connectionV[ix]));
-          // this time no success finding a connection that is working, try in the next loop
-          continue;
-        }
-      }
-
-      // Great - found a free and already connected item - let's use it !
-      cP->busy = true;
-
-      sem_post(&poolP->poolSem);
-      sem_post(&poolP->queueSem);
-
-      cP->uses += 1;
-      return cP;
-    }
-  }
+  cP->busy = true;
 
   //
-  // No already connected item was found - just look for an unused item and connect it to postgres
+  // A connection that broke since the last health check of the pool monitor
   //
-  PgConnection* cP = NULL;
-  for (int ix = 0; ix < poolP->items; ix++)
+  if ((cP->connectionP != NULL) && (PQstatus(cP->connectionP) != CONNECTION_OK))
   {
-    if (poolP->connectionV[ix] == NULL)
+    LM_W(("Connection %d of the pool of db '%s' is lost, re-connecting", cP->index, _db));
+    PQreset(cP->connectionP);
+
+    if (PQstatus(cP->connectionP) == CONNECTION_OK)
     {
-      //
-      // We found a completely unused slot - need to allocate
-      // Pity doing this with the semaphore taken ...
-      // But, there's no other choice as the slot must be marked as 'busy' before the sem can be released
-      //
-      poolP->connectionV[ix] = (PgConnection*)calloc(1, sizeof(PgConnection));
-      if (poolP->connectionV[ix] == NULL)
-      {
-        sem_post(&poolP->poolSem);
-        sem_post(&poolP->queueSem);
-        LM_RE(NULL, ("Out of memory (unable to allocate room for a Postgres Connection - %d bytes)", sizeof(PgConnection)));
-      }
-
-      cP = poolP->connectionV[ix];
-      break;
+      cP->prepared = 0;  // Prepared statements don't survive a reconnection
+      promCounterIncrease(promPgPoolReconnects);
     }
-    else if (poolP->connectionV[ix]->busy == false)
+    else
     {
-      cP = poolP->connectionV[ix];
-      break;
+      PQfinish(cP->connectionP);
+      cP->connectionP = NULL;
+      promGaugeAdd(promPgPoolConnections, -1, NULL);
     }
   }
 
+  if (cP->connectionP == NULL)  // Virgin connection
+  {
+    cP->connectionP = pgConnect(_db);
+    cP->prepared    = 0;
 
-  if (cP != NULL)
-    cP->busy = true;  // Now the pool item 'cP' is ours - after this we can let go of the semaphore
+    if ((cP->connectionP == NULL) || (PQstatus(cP->connectionP) != CONNECTION_OK))
+    {
+      // get PG error message for log file
+      char* errMsg = (cP->connectionP != NULL)? PQerrorMessage(cP->connectionP) : (char*) "out of memory";
 
-  sem_post(&poolP->poolSem);
-  sem_post(&poolP->queueSem);
+      LM_E(("Database Connection could not be established (%s): %s ", _db, errMsg));
 
-  if (cP == NULL)
-  {
-    LM_W(("Internal Error (bug in postgres connection pool logic?)"));
-    LM_W(("poolP at %p", poolP));
-    LM_W(("poolP->items: %d", poolP->items));
-    LM_W(("poolP->connectionV at %p", poolP->connectionV));
+      if (cP->connectionP != NULL)
+        PQfinish(cP->connectionP);
+      cP->connectionP = NULL;
 
-    return NULL;
-  }
+      // Back to the free list, so the slot can be used again
+      cP->busy = false;
+      pgFreeListPush(poolP, cP, cP);
 
-  if (cP->connectionP == NULL)  // Virgin connection
-  {
-    cP->connectionP = pgConnect(_db);
-    if (cP->connectionP == NULL)
-    {
-      char* errMsg = PQerrorMessage(cP->connectionP);
-      cP->busy = false;  // So the slot can be used again!
-      LM_RE(NULL, ("Database Error (unable to connect to postgres(%s)): %s", _db, errMsg));
-    }
-    else
-    {
-      // check if we are connected
-      ConnStatusType pgStatus = PQstatus(cP->connectionP);
-      if (pgStatus != CONNECTION_OK)
-      {
-        sem_wait(&poolP->poolSem);
-        sem_wait(&poolP->queueSem);
-
-        // find the connection pointer in the pool and free it
-        for (int ix = 0; ix < poolP->items; ix++)
-        {
-          if (poolP->connectionV[ix] == cP)
-          {
-            free(poolP->connectionV[ix]);
-            poolP->connectionV[ix] = NULL;
-            break;
-          }
-        }
-        sem_post(&poolP->poolSem);
-        sem_post(&poolP->queueSem);
-
-        // get PG error message for log file
-        char* errMsg = PQerrorMessage(cP->connectionP);
-        LM_RE(NULL, ("Database Connection could not be established (%s): %s ", _db, errMsg));
-      }
+      return NULL;
     }
+
+    promGaugeAdd(promPgPoolConnections, 1, NULL);
+
+    //
+    // The prepared statements of the TRoE inserts, for the databases of the tenants (not the "postgres" database)
+    // If the tables don't exist yet (brand new database), the statements are prepared later, when first needed
+    //
+    if (_db != NULL)
+      pgStatementsPrepare(cP);
   }
 
   cP->uses += 1;
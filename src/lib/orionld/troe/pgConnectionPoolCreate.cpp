@@ -24,7 +24,7 @@
 */
 #include <stdlib.h>                                            // malloc, free
 #include <string.h>                                            // strdup
-#include <semaphore.h>                                         // sem_init
+#include <pthread.h>                                           // pthread_mutex_init, pthread_cond_init
 
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
@@ -67,10 +67,39 @@ PgConnectionPool* pgConnectionPoolCreate(const char* db, int poolSize)
   else
     poolP->db = NULL;
 
-  sem_init(&poolP->queueSem, 0, poolSize);  // Counting semaphore - there's a free slot
-  sem_init(&poolP->poolSem,  0, 1);         // Binary semaphore - the pool is yours to modify
+  //
+  // All the PgConnection items are allocated here (they're small) - they're connected to postgres only when needed.
+  // Initially, they're all in the free list, in order.
+  //
+  for (int ix = 0; ix < poolSize; ix++)
+  {
+    PgConnection* cP = (PgConnection*) calloc(1, sizeof(PgConnection));
+
+    if (cP == NULL)
+    {
+      for (int cIx = 0; cIx < ix; cIx++)
+        free(poolP->connectionV[cIx]);
+      free(poolP->connectionV);
+      free(poolP->db);
+      free(poolP);
+      LM_E(("Out of memory (unable to allocate room for a Postgres Connection - %d bytes)", sizeof(PgConnection)));
+      return NULL;
+    }
+
+    cP->index    = ix;
+    cP->nextFree = (ix + 1 < poolSize)? ix + 2 : 0;  // index+1 of the next item
+    cP->poolP    = poolP;
+
+    poolP->connectionV[ix] = cP;
+  }
+
+  poolP->freeHead = (poolSize > 0)? 1 : 0;  // Tag 0, first free connection: index 0
+  poolP->waiters  = 0;
+  poolP->items    = poolSize;
+  poolP->next     = NULL;
 
-  poolP->items = poolSize;
+  pthread_mutex_init(&poolP->waitMutex, NULL);
+  pthread_cond_init(&poolP->waitCond, NULL);
 
   return poolP;
 }
@@ -23,12 +23,14 @@
 * Author: Ken Zangelin
 */
 #include <stdlib.h>                                            // free
-#include <semaphore.h>                                         // sem_destroy
+#include <pthread.h>                                           // pthread_mutex_destroy, pthread_cond_destroy
 
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
 
 #include "orionld/types/PgConnectionPool.h"                    // PgConnectionPool
+#include "orionld/common/orionldState.h"                       // promPgPoolConnections
+#include "orionld/prometheus/promGaugeAdd.h"                   // promGaugeAdd
 #include "orionld/troe/pgConnectionPoolFree.h"                 // Own interface
 
 
@@ -39,15 +41,18 @@
 //
 void pgConnectionPoolFree(PgConnectionPool* poolP)
 {
-  sem_destroy(&poolP->queueSem);
-  sem_destroy(&poolP->poolSem);
+  pthread_mutex_destroy(&poolP->waitMutex);
+  pthread_cond_destroy(&poolP->waitCond);
 
   for (int ix = 0; ix < poolP->items; ix++)
   {
     if (poolP->connectionV[ix] != NULL)
     {
       if (poolP->connectionV[ix]->connectionP != NULL)
+      {
         PQfinish(poolP->connectionV[ix]->connectionP);
+        promGaugeAdd(promPgPoolConnections, -1, NULL);
+      }
       free(poolP->connectionV[ix]);
     }
   }
@@ -23,6 +23,7 @@
 * Author: Ken Zangelin
 */
 #include <string.h>                                            // strcmp
+#include <pthread.h>                                           // pthread_mutex_t
 
 #include "logMsg/logMsg.h"                                     // LM_*
 #include "logMsg/traceLevels.h"                                // Lmt*
@@ -35,6 +36,35 @@
 
 
 
+// -----------------------------------------------------------------------------
+//
+// poolCreateMutex - serializes the creation of new pools (lookups are lock-free)
+//
+static pthread_mutex_t poolCreateMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// poolLookup -
+//
+static PgConnectionPool* poolLookup(const char* db)
+{
+  PgConnectionPool* poolP = __atomic_load_n(&pgPoolMaster->next, __ATOMIC_ACQUIRE);
+
+  while (poolP != NULL)
+  {
+    if (strcmp(poolP->db, db) == 0)
+      return poolP;
+
+    poolP = poolP->next;  // pools are never removed from the list while the broker runs
+  }
+
+  return NULL;
+}
+
+
+
 // -----------------------------------------------------------------------------
 //
 // pgConnectionPoolGet -
@@ -47,21 +77,29 @@ PgConnectionPool* pgConnectionPoolGet(char* db)
   if (db == NULL)
     return pgPoolMaster;
 
-  PgConnectionPool* poolP = pgPoolMaster->next;
+  PgConnectionPool* poolP = poolLookup(db);
 
-  while (poolP != NULL)
-  {
-    if (strcmp(poolP->db, db) == 0)
-      return poolP;
+  if (poolP != NULL)
+    return poolP;
+
+  //
+  // No pool found, will have to create a new one.
+  // Another thread may have been creating the very same pool while we waited for the mutex, so, look again
+  //
+  pthread_mutex_lock(&poolCreateMutex);
 
-    poolP = poolP->next;
+  poolP = poolLookup(db);
+  if (poolP == NULL)
+  {
+    poolP = pgConnectionPoolCreate(db, pgPoolMaster->items);
+    if (poolP != NULL)
+      pgConnectionPoolInsert(poolP);
   }
 
-  // No pool found, will have to create a new one
-  poolP = pgConnectionPoolCreate(db, pgPoolMaster->items);
+  pthread_mutex_unlock(&poolCreateMutex);
+
   if (poolP == NULL)
     LM_RE(NULL, ("Database Error (unable to create connection pool for db '%s')", db));
 
-  pgConnectionPoolInsert(poolP);
   return poolP;
 }
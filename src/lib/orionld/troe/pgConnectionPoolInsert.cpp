@@ -37,8 +37,11 @@
 // New pools are inserted in the beginning of the list, so we don't need to maintain a pointer
 // to the last item in the linked list.
 //
+// Insertions are serialized by pgConnectionPoolGet, while lookups are lock-free, so the new pool is
+// published with 'release' semantics - a reader that sees the pointer also sees the initialized pool.
+//
 void pgConnectionPoolInsert(PgConnectionPool* poolP)
 {
-  poolP->next        = pgPoolMaster->next;
-  pgPoolMaster->next = poolP;
+  poolP->next = pgPoolMaster->next;
+  __atomic_store_n(&pgPoolMaster->next, poolP, __ATOMIC_RELEASE);
 }
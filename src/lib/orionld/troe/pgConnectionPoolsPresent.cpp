@@ -57,6 +57,8 @@ static void pgConnectionPoolPresent(PgConnectionPool* poolP)
     LM_T(LmtPgPool, ("PGPOOL:    busy:       %s", K_FT(cP->busy)));
     LM_T(LmtPgPool, ("PGPOOL:    uses:       %d", cP->uses));
     LM_T(LmtPgPool, ("PGPOOL:    connection: %p", cP->connectionP));
+    LM_T(LmtPgPool, ("PGPOOL:    prepared:   0x%x", cP->prepared));
+    LM_T(LmtPgPool, ("PGPOOL:    lastUsed:   %d", (int) cP->lastUsed));
     LM_T(LmtPgPool, ("PGPOOL:"));
   }
 #endif
@@ -22,7 +22,12 @@
 *
 * Author: Ken Zangelin
 */
+#include <time.h>                                              // time
+
+#include "orionld/types/PgConnectionPool.h"                    // PgConnectionPool
 #include "orionld/types/PgConnection.h"                        // PgConnection
+#include "orionld/troe/pgFreeListPush.h"                       // pgFreeListPush
+#include "orionld/troe/pgConnectionRelease.h"                  // Own interface
 
 
 
@@ -33,5 +38,8 @@
 void pgConnectionRelease(PgConnection* connectionP)
 {
   // Return the connection to its pool
-  connectionP->busy = false;
+  connectionP->lastUsed = time(NULL);
+  connectionP->busy     = false;
+
+  pgFreeListPush(connectionP->poolP, connectionP, connectionP);
 }
@@ -0,0 +1,116 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                             // snprintf
+#include <string.h>                                            // strncmp
+#include <stdint.h>                                            // int16_t
+#include <arpa/inet.h>                                         // htons
+
+#include "logMsg/logMsg.h"                                     // LM_*
+#include "logMsg/traceLevels.h"                                // LmtSql
+
+#include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
+#include "orionld/common/pqHeader.h"                           // Postgres header
+#include "orionld/troe/pgCopy.h"                               // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// copyHeader - the header of the binary COPY format: signature, flags (32 bits) and header extension length (32 bits)
+//
+static const char copyHeader[19] = { 'P', 'G', 'C', 'O', 'P', 'Y', '\n', '\377', '\r', '\n', '\0', 0, 0, 0, 0, 0, 0, 0, 0 };
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyCommand -
+//
+bool pgCopyCommand(PgAppendBuffer* bufP, char* command, int commandSize)
+{
+  const char* insertInto = "INSERT INTO ";
+  const char* values     = " VALUES ";
+  int         prefixLen  = strlen(insertInto);
+  int         suffixLen  = strlen(values);
+  int         tableLen   = bufP->copyStart - prefixLen - suffixLen;
+
+  if ((tableLen <= 0) || (strncmp(bufP->buf, insertInto, prefixLen) != 0) || (strncmp(&bufP->buf[bufP->copyStart - suffixLen], values, suffixLen) != 0))
+    LM_RE(false, ("Internal Error (not an INSERT header in a TRoE buffer)"));
+
+  snprintf(command, commandSize, "COPY %.*s FROM STDIN (FORMAT binary)", tableLen, &bufP->buf[prefixLen]);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopy -
+//
+bool pgCopy(PGconn* connectionP, const char* command, char** chunkV, int* chunkLenV, int chunks)
+{
+  LM_T(LmtSql, ("SQL: %s (%d chunks of binary tuples)", command, chunks));
+
+  PGresult* res = PQexec(connectionP, command);
+
+  if ((res == NULL) || (PQresultStatus(res) != PGRES_COPY_IN))
+  {
+    LM_E(("Database Error (%s: %s)", command, PQerrorMessage(connectionP)));
+    PQclear(res);
+    return false;
+  }
+  PQclear(res);
+
+  int16_t trailer = htons(-1);
+  bool    ok      = (PQputCopyData(connectionP, copyHeader, sizeof(copyHeader)) == 1);
+
+  for (int ix = 0; (ix < chunks) && (ok == true); ix++)
+  {
+    ok = (PQputCopyData(connectionP, chunkV[ix], chunkLenV[ix]) == 1);
+  }
+
+  if (ok == true)
+    ok = (PQputCopyData(connectionP, (const char*) &trailer, 2) == 1);
+
+  if (PQputCopyEnd(connectionP, (ok == true)? NULL : "error sending the binary tuples") != 1)
+    ok = false;
+
+  //
+  // The result of the COPY - and then a NULL result to end it
+  //
+  while ((res = PQgetResult(connectionP)) != NULL)
+  {
+    if (PQresultStatus(res) != PGRES_COMMAND_OK)
+    {
+      LM_E(("Database Error (%s: %s)", command, PQresultErrorMessage(res)));
+      ok = false;
+    }
+
+    PQclear(res);
+  }
+
+  return ok;
+}
@@ -0,0 +1,422 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                            // strlen, strcmp, memcpy
+#include <stdint.h>                                            // int16_t, int32_t, int64_t, uint32_t, uint64_t
+#include <math.h>                                              // llround
+#include <arpa/inet.h>                                         // htons, htonl
+#include <endian.h>                                            // htobe64, htole32, htole64
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                    // kaAlloc
+#include "kjson/KjNode.h"                                      // KjNode
+#include "kjson/kjRenderSize.h"                                // kjFastRenderSize
+#include "kjson/kjRender.h"                                    // kjFastRender
+}
+
+#include "logMsg/logMsg.h"                                     // LM_*
+
+#include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
+#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/common/dateTime.h"                           // dateTimeFromString
+#include "orionld/troe/pgAppend.h"                             // pgAppend
+#include "orionld/troe/kjGeoPointExtract.h"                    // kjGeoPointExtract
+#include "orionld/troe/pgCopyAppend.h"                         // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PG_EPOCH - 2000-01-01T00:00:00Z, the epoch of the binary TIMESTAMP, in seconds since the unix epoch
+//
+#define PG_EPOCH  946684800.0
+
+
+
+// -----------------------------------------------------------------------------
+//
+// WKB geometry types and EWKB flags
+//
+#define WKB_POINT             1
+#define WKB_LINESTRING        2
+#define WKB_POLYGON           3
+#define WKB_MULTIPOINT        4
+#define WKB_MULTILINESTRING   5
+#define WKB_MULTIPOLYGON      6
+#define EWKB_Z                0x80000000
+#define EWKB_SRID             0x20000000
+
+
+
+// -----------------------------------------------------------------------------
+//
+// fieldLength - a field starts with its length
+//
+static void fieldLength(PgAppendBuffer* bufP, int len)
+{
+  int32_t n = htonl(len);
+
+  pgAppend(bufP, (const char*) &n, 4);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyTupleStart -
+//
+void pgCopyTupleStart(PgAppendBuffer* bufP, int fields)
+{
+  int16_t n = htons(fields);
+
+  if (bufP->values == 0)
+    bufP->copyStart = bufP->currentIx;
+
+  pgAppend(bufP, (const char*) &n, 2);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyNull -
+//
+void pgCopyNull(PgAppendBuffer* bufP)
+{
+  fieldLength(bufP, -1);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyText -
+//
+void pgCopyText(PgAppendBuffer* bufP, const char* s)
+{
+  if (s == NULL)
+  {
+    fieldLength(bufP, -1);
+    return;
+  }
+
+  int len = strlen(s);
+
+  fieldLength(bufP, len);
+  if (len > 0)
+    pgAppend(bufP, s, len);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyBool -
+//
+void pgCopyBool(PgAppendBuffer* bufP, bool b)
+{
+  char c = (b == true)? 1 : 0;
+
+  fieldLength(bufP, 1);
+  pgAppend(bufP, &c, 1);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyFloat8 -
+//
+void pgCopyFloat8(PgAppendBuffer* bufP, double d)
+{
+  uint64_t n;
+
+  memcpy(&n, &d, 8);
+  n = htobe64(n);
+
+  fieldLength(bufP, 8);
+  pgAppend(bufP, (const char*) &n, 8);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyTimestamp - microseconds since PG_EPOCH
+//
+// The TRoE timestamps are UTC, and the columns are TIMESTAMP (without time zone), so, no conversion
+//
+void pgCopyTimestamp(PgAppendBuffer* bufP, double timestamp)
+{
+  int64_t usecs = (int64_t) llround((timestamp - PG_EPOCH) * 1000000);
+  int64_t n     = htobe64(usecs);
+
+  fieldLength(bufP, 8);
+  pgAppend(bufP, (const char*) &n, 8);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyDateTime -
+//
+// NOTE: the INSERT path lets postgres parse the string, and postgres ignores any time zone for TIMESTAMP columns.
+//       Here the string is parsed by the broker, and a time zone other than 'Z' is taken into account - the
+//       column gets the UTC time.
+//
+void pgCopyDateTime(PgAppendBuffer* bufP, const char* iso8601)
+{
+  if (iso8601 == NULL)
+  {
+    fieldLength(bufP, -1);
+    return;
+  }
+
+  char   errorString[256];
+  double timestamp = dateTimeFromString(iso8601, errorString, sizeof(errorString));
+
+  if (timestamp < 0)
+  {
+    LM_W(("Invalid DateTime '%s' for TRoE (%s) - stored as null", iso8601, errorString));
+    fieldLength(bufP, -1);
+    return;
+  }
+
+  pgCopyTimestamp(bufP, timestamp);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyJsonb - version 1 of the binary JSONB is a version byte followed by the JSON text
+//
+void pgCopyJsonb(PgAppendBuffer* bufP, KjNode* valueP)
+{
+  // WARNING: If a value is HUGE, it may not have room enough in a buffer allocated by kaAlloc (there's a max-size)
+  int   renderedValueSize = kjFastRenderSize(valueP);
+  char* renderedValue     = kaAlloc(&orionldState.kalloc, renderedValueSize);
+  char  version           = 1;
+
+  kjFastRender(valueP, renderedValue);
+
+  int len = strlen(renderedValue);
+
+  fieldLength(bufP, len + 1);
+  pgAppend(bufP, &version, 1);
+  pgAppend(bufP, renderedValue, len);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// wkbType - byte order (little endian) and geometry type
+//
+static void wkbType(PgAppendBuffer* bufP, uint32_t type)
+{
+  char     byteOrder = 1;
+  uint32_t n         = htole32(type | EWKB_Z);
+
+  pgAppend(bufP, &byteOrder, 1);
+  pgAppend(bufP, (const char*) &n, 4);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// wkbCount - number of points, rings, or geometries
+//
+static void wkbCount(PgAppendBuffer* bufP, KjNode* arrayP)
+{
+  uint32_t count = 0;
+
+  for (KjNode* nodeP = arrayP->value.firstChildP; nodeP != NULL; nodeP = nodeP->next)
+  {
+    ++count;
+  }
+
+  count = htole32(count);
+  pgAppend(bufP, (const char*) &count, 4);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// wkbPoint - longitude, latitude, and altitude (0 if absent)
+//
+static bool wkbPoint(PgAppendBuffer* bufP, KjNode* pointP)
+{
+  double coordV[3] = { 0, 0, 0 };
+
+  if ((pointP->type != KjArray) || (kjGeoPointExtract(pointP, &coordV[0], &coordV[1], &coordV[2]) == false))
+    return false;
+
+  for (int ix = 0; ix < 3; ix++)
+  {
+    uint64_t n;
+
+    memcpy(&n, &coordV[ix], 8);
+    n = htole64(n);
+    pgAppend(bufP, (const char*) &n, 8);
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// wkbPoints - a LineString or a ring of a Polygon
+//
+static bool wkbPoints(PgAppendBuffer* bufP, KjNode* pointsP)
+{
+  if (pointsP->type != KjArray)
+    return false;
+
+  wkbCount(bufP, pointsP);
+
+  for (KjNode* pointP = pointsP->value.firstChildP; pointP != NULL; pointP = pointP->next)
+  {
+    if (wkbPoint(bufP, pointP) == false)
+      return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// wkbRings - the rings of a Polygon, or the LineStrings of a MultiLineString (without their WKB headers)
+//
+static bool wkbRings(PgAppendBuffer* bufP, KjNode* ringsP)
+{
+  if (ringsP->type != KjArray)
+    return false;
+
+  wkbCount(bufP, ringsP);
+
+  for (KjNode* ringP = ringsP->value.firstChildP; ringP != NULL; ringP = ringP->next)
+  {
+    if (wkbPoints(bufP, ringP) == false)
+      return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// wkbMulti - the members of a Multi-geometry, each with its own WKB header
+//
+static bool wkbMulti(PgAppendBuffer* bufP, uint32_t memberType, KjNode* membersP)
+{
+  if (membersP->type != KjArray)
+    return false;
+
+  wkbCount(bufP, membersP);
+
+  for (KjNode* memberP = membersP->value.firstChildP; memberP != NULL; memberP = memberP->next)
+  {
+    bool ok;
+
+    wkbType(bufP, memberType);
+
+    if      (memberType == WKB_POINT)       ok = wkbPoint(bufP, memberP);
+    else if (memberType == WKB_LINESTRING)  ok = wkbPoints(bufP, memberP);
+    else                                    ok = wkbRings(bufP, memberP);
+
+    if (ok == false)
+      return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyGeo -
+//
+// The length of the field isn't known until the geometry has been encoded - it's patched in afterwards
+//
+bool pgCopyGeo(PgAppendBuffer* bufP, const char* geoType, KjNode* coordinatesP)
+{
+  int       fieldStart = bufP->currentIx;
+  uint32_t  type;
+
+  if      (strcmp(geoType, "Point")           == 0)  type = WKB_POINT;
+  else if (strcmp(geoType, "LineString")      == 0)  type = WKB_LINESTRING;
+  else if (strcmp(geoType, "Polygon")         == 0)  type = WKB_POLYGON;
+  else if (strcmp(geoType, "MultiPoint")      == 0)  type = WKB_MULTIPOINT;
+  else if (strcmp(geoType, "MultiLineString") == 0)  type = WKB_MULTILINESTRING;
+  else if (strcmp(geoType, "MultiPolygon")    == 0)  type = WKB_MULTIPOLYGON;
+  else
+  {
+    LM_W(("Unsupported geometry type '%s' for TRoE - stored as null", geoType));
+    fieldLength(bufP, -1);
+    return false;
+  }
+
+  fieldLength(bufP, 0);  // Patched when the geometry is done
+
+  char      byteOrder    = 1;
+  uint32_t  typeAndFlags = htole32(type | EWKB_Z | EWKB_SRID);
+  uint32_t  srid         = htole32(4326);
+  bool      ok;
+
+  pgAppend(bufP, &byteOrder, 1);
+  pgAppend(bufP, (const char*) &typeAndFlags, 4);
+  pgAppend(bufP, (const char*) &srid, 4);
+
+  if      (type == WKB_POINT)            ok = wkbPoint(bufP, coordinatesP);
+  else if (type == WKB_LINESTRING)       ok = wkbPoints(bufP, coordinatesP);
+  else if (type == WKB_POLYGON)          ok = wkbRings(bufP, coordinatesP);
+  else if (type == WKB_MULTIPOINT)       ok = wkbMulti(bufP, WKB_POINT, coordinatesP);
+  else if (type == WKB_MULTILINESTRING)  ok = wkbMulti(bufP, WKB_LINESTRING, coordinatesP);
+  else                                   ok = wkbMulti(bufP, WKB_POLYGON, coordinatesP);
+
+  if (ok == false)
+  {
+    LM_W(("Invalid coordinates of a %s for TRoE - stored as null", geoType));
+    bufP->currentIx = fieldStart;
+    fieldLength(bufP, -1);
+    return false;
+  }
+
+  int32_t len = htonl(bufP->currentIx - fieldStart - 4);
+  memcpy(&bufP->buf[fieldStart], &len, 4);
+
+  return true;
+}
@@ -0,0 +1,121 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGCOPYAPPEND_H_
+#define SRC_LIB_ORIONLD_TROE_PGCOPYAPPEND_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+extern "C"
+{
+#include "kjson/KjNode.h"                                      // KjNode
+}
+
+#include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Encoding of the fields of a tuple for COPY ... FROM STDIN (FORMAT binary)
+//
+// A tuple is a 16 bit field count followed by the fields, each one a 32 bit length (-1 for null) and the
+// binary representation of the value - all integers in network byte order.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyTupleStart - start a new tuple of 'fields' fields
+//
+// The first tuple of the buffer also marks where the binary data starts (PgAppendBuffer::copyStart)
+//
+extern void pgCopyTupleStart(PgAppendBuffer* bufP, int fields);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyNull - a null field
+//
+extern void pgCopyNull(PgAppendBuffer* bufP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyText - a TEXT/VARCHAR/ENUM field (null if 's' is NULL)
+//
+extern void pgCopyText(PgAppendBuffer* bufP, const char* s);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyBool - a BOOL field
+//
+extern void pgCopyBool(PgAppendBuffer* bufP, bool b);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyFloat8 - a FLOAT8 field
+//
+extern void pgCopyFloat8(PgAppendBuffer* bufP, double d);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyTimestamp - a TIMESTAMP field, from seconds since the epoch
+//
+extern void pgCopyTimestamp(PgAppendBuffer* bufP, double timestamp);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyDateTime - a TIMESTAMP field, from an ISO8601 string (null if 'iso8601' is NULL)
+//
+extern void pgCopyDateTime(PgAppendBuffer* bufP, const char* iso8601);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyJsonb - a JSONB field - the value rendered as JSON
+//
+extern void pgCopyJsonb(PgAppendBuffer* bufP, KjNode* valueP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyGeo - a GEOGRAPHY field - the coordinates of a GeoJSON geometry as EWKB, with Z and SRID 4326
+//
+// Returns false (and nothing is added) if the geometry is invalid
+//
+extern bool pgCopyGeo(PgAppendBuffer* bufP, const char* geoType, KjNode* coordinatesP);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGCOPYAPPEND_H_
@@ -0,0 +1,137 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                            // strcmp
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                      // KjNode
+#include "kjson/kjLookup.h"                                    // kjLookup
+}
+
+#include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
+#include "orionld/troe/pgCopyAppend.h"                         // pgCopyNull, pgCopyText, pgCopyBool, pgCopyFloat8, pgCopyJsonb, pgCopyGeo
+#include "orionld/troe/pgCopyValue.h"                          // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Value columns, in table order
+//
+#define COL_TEXT                   0
+#define COL_BOOLEAN                1
+#define COL_NUMBER                 2
+#define COL_COMPOUND               4
+#define COL_GEO_POINT              5
+#define COL_GEO_MULTIPOINT         6
+#define COL_GEO_POLYGON            7
+#define COL_GEO_MULTIPOLYGON       8
+#define COL_GEO_LINESTRING         9
+#define COL_GEO_MULTILINESTRING   10
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyValueType -
+//
+const char* pgCopyValueType(const char* type, KjNode* valueNodeP, int* columnP)
+{
+  if (type == NULL)
+  {
+    *columnP = COL_TEXT;
+    return "UnchangedType";
+  }
+
+  if (strcmp(type, "Relationship") == 0)
+  {
+    *columnP = COL_TEXT;
+    return "Relationship";
+  }
+
+  if (valueNodeP == NULL)
+    return NULL;
+
+  if (strcmp(type, "GeoProperty") == 0)
+  {
+    KjNode* geoTypeNodeP = kjLookup(valueNodeP, "type");
+
+    if ((geoTypeNodeP == NULL) || (geoTypeNodeP->type != KjString))
+      return NULL;
+
+    const char* geoType = geoTypeNodeP->value.s;
+
+    if      (strcmp(geoType, "Point")           == 0) { *columnP = COL_GEO_POINT;           return "GeoPoint";           }
+    else if (strcmp(geoType, "MultiPoint")      == 0) { *columnP = COL_GEO_MULTIPOINT;      return "GeoMultiPoint";      }
+    else if (strcmp(geoType, "LineString")      == 0) { *columnP = COL_GEO_LINESTRING;      return "GeoLineString";      }
+    else if (strcmp(geoType, "MultiLineString") == 0) { *columnP = COL_GEO_MULTILINESTRING; return "GeoMultiLineString"; }
+    else if (strcmp(geoType, "Polygon")         == 0) { *columnP = COL_GEO_POLYGON;         return "GeoPolygon";         }
+    else if (strcmp(geoType, "MultiPolygon")    == 0) { *columnP = COL_GEO_MULTIPOLYGON;    return "GeoMultiPolygon";    }
+
+    return NULL;
+  }
+
+  if      (valueNodeP->type == KjString)   { *columnP = COL_TEXT;     return "String";   }
+  else if (valueNodeP->type == KjBoolean)  { *columnP = COL_BOOLEAN;  return "Boolean";  }
+  else if (valueNodeP->type == KjInt)      { *columnP = COL_NUMBER;   return "Number";   }
+  else if (valueNodeP->type == KjFloat)    { *columnP = COL_NUMBER;   return "Number";   }
+  else if (valueNodeP->type == KjArray)    { *columnP = COL_COMPOUND; return "Compound"; }
+  else if (valueNodeP->type == KjObject)   { *columnP = COL_COMPOUND; return "Compound"; }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyValue -
+//
+void pgCopyValue(PgAppendBuffer* bufP, int column, KjNode* valueNodeP, const char* text)
+{
+  for (int ix = 0; ix < PG_VALUE_COLUMNS; ix++)
+  {
+    if (ix != column)
+      pgCopyNull(bufP);
+    else if (column == COL_TEXT)
+      pgCopyText(bufP, (text != NULL)? text : valueNodeP->value.s);
+    else if (column == COL_BOOLEAN)
+      pgCopyBool(bufP, valueNodeP->value.b);
+    else if (column == COL_NUMBER)
+      pgCopyFloat8(bufP, (valueNodeP->type == KjInt)? (double) valueNodeP->value.i : valueNodeP->value.f);
+    else if (column == COL_COMPOUND)
+      pgCopyJsonb(bufP, valueNodeP);
+    else  // Geo
+    {
+      KjNode* geoTypeNodeP     = kjLookup(valueNodeP, "type");
+      KjNode* coordinatesNodeP = kjLookup(valueNodeP, "coordinates");
+
+      if (coordinatesNodeP == NULL)
+        pgCopyNull(bufP);
+      else
+        pgCopyGeo(bufP, geoTypeNodeP->value.s, coordinatesNodeP);
+    }
+  }
+}
@@ -0,0 +1,67 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGCOPYVALUE_H_
+#define SRC_LIB_ORIONLD_TROE_PGCOPYVALUE_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+extern "C"
+{
+#include "kjson/KjNode.h"                                      // KjNode
+}
+
+#include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PG_VALUE_COLUMNS - the value columns of the attributes and subAttributes tables
+//
+// text, boolean, number, datetime, compound, geoPoint, geoMultiPoint, geoPolygon, geoMultiPolygon, geoLineString, geoMultiLineString
+//
+#define PG_VALUE_COLUMNS  11
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyValueType - the valueType of an attribute/sub-attribute, and the value column where its value goes
+//
+// Returns NULL if the value can't be stored (the INSERT path doesn't store it either).
+// Relationships (and sub-attributes with unchanged type) have their value in the 'text' column.
+//
+extern const char* pgCopyValueType(const char* type, KjNode* valueNodeP, int* columnP);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgCopyValue - the PG_VALUE_COLUMNS value columns, all of them null except 'column'
+//
+// The 'text' column gets 'text' if non-NULL (the object of a Relationship), else the string value of valueNodeP.
+// A column of -1 means all value columns are null.
+//
+extern void pgCopyValue(PgAppendBuffer* bufP, int column, KjNode* valueNodeP, const char* text);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGCOPYVALUE_H_
@@ -27,6 +27,7 @@
 #include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/troe/pgAppend.h"                             // pgAppend
+#include "orionld/troe/pgEntityCopy.h"                         // pgEntityCopy
 #include "orionld/troe/pgEntityAppend.h"                       // pgEntityAppend
 
 
@@ -43,6 +44,12 @@
 //
 void pgEntityAppend(PgAppendBuffer* entitiesBufferP, const char* opMode, const char* entityId, const char* entityType, const char* instanceId)
 {
+  if (entitiesBufferP->binary == true)  // -troeCopy
+  {
+    pgEntityCopy(entitiesBufferP, opMode, entityId, entityType, instanceId);
+    return;
+  }
+
   char         buf[1024];
   const char*  comma = (entitiesBufferP->values != 0)? "," : "";
 
@@ -0,0 +1,55 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t, uint32_t
+
+#include "orionld/types/PgConnectionPool.h"                      // PgConnectionPool
+#include "orionld/types/PgConnection.h"                          // PgConnection
+#include "orionld/troe/pgFreeListPop.h"                          // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgFreeListPop -
+//
+// The tag of the head (high 32 bits) is incremented on every change, so a compare-and-swap with a head that
+// meanwhile has been popped and pushed back (ABA) fails and the loop simply tries again.
+//
+PgConnection* pgFreeListPop(PgConnectionPool* poolP)
+{
+  uint64_t head = __atomic_load_n(&poolP->freeHead, __ATOMIC_SEQ_CST);
+
+  while ((head & 0xFFFFFFFF) != 0)
+  {
+    PgConnection* cP      = poolP->connectionV[(head & 0xFFFFFFFF) - 1];
+    uint64_t      next    = __atomic_load_n(&cP->nextFree, __ATOMIC_RELAXED);
+    uint64_t      newHead = (((head >> 32) + 1) << 32) | next;
+
+    if (__atomic_compare_exchange_n(&poolP->freeHead, &head, newHead, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) == true)
+      return cP;
+  }
+
+  return NULL;
+}
@@ -0,0 +1,59 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t, uint32_t
+#include <pthread.h>                                             // pthread_mutex_lock, pthread_cond_signal
+
+#include "orionld/types/PgConnectionPool.h"                      // PgConnectionPool
+#include "orionld/types/PgConnection.h"                          // PgConnection
+#include "orionld/troe/pgFreeListPush.h"                         // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgFreeListPush -
+//
+void pgFreeListPush(PgConnectionPool* poolP, PgConnection* firstP, PgConnection* lastP)
+{
+  uint64_t head = __atomic_load_n(&poolP->freeHead, __ATOMIC_SEQ_CST);
+  uint64_t newHead;
+
+  do
+  {
+    __atomic_store_n(&lastP->nextFree, (uint32_t) (head & 0xFFFFFFFF), __ATOMIC_RELAXED);
+    newHead = (((head >> 32) + 1) << 32) | (uint64_t) (firstP->index + 1);
+  } while (__atomic_compare_exchange_n(&poolP->freeHead, &head, newHead, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) == false);
+
+  //
+  // A thread awaiting a connection increments 'waiters' before its last look in the free list, so,
+  // either it finds the connection just pushed, or we see it here and wake it up
+  //
+  if (__atomic_load_n(&poolP->waiters, __ATOMIC_SEQ_CST) > 0)
+  {
+    pthread_mutex_lock(&poolP->waitMutex);
+    pthread_cond_broadcast(&poolP->waitCond);
+    pthread_mutex_unlock(&poolP->waitMutex);
+  }
+}
@@ -33,6 +33,7 @@
 #include "orionld/troe/pgConnectionPoolInit.h"                 // pgConnectionPoolInit
 #include "orionld/troe/pgDatabasePrepare.h"                    // pgDatabasePrepare
 #include "orionld/troe/pgConnectionPoolsPresent.h"             // pgConnectionPoolsPresent
+#include "orionld/troe/pgPoolMonitor.h"                        // pgPoolMonitorStart
 #include "orionld/troe/pgInit.h"                               // Own interface
 
 
@@ -48,6 +49,9 @@ bool pgInit(const char* dbPrefix)
   if (pgConnectionPoolInit(troePoolSize) == false)
     LM_RE(false, ("error initializing the postgres connection pools"));
 
+  if (pgPoolMonitorStart() == false)
+    LM_RE(false, ("error starting the postgres connection pool monitor"));
+
   bool b = pgDatabasePrepare(dbPrefix);
   pgConnectionPoolsPresent();
   return b;
@@ -0,0 +1,77 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strlen
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+}
+
+#include "orionld/types/PgParams.h"                              // PgParams
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/troe/pgParamAdd.h"                             // pgParamAdd
+#include "orionld/troe/pgParamArrayAdd.h"                        // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgParamArrayAdd -
+//
+// Every item is double-quoted, and any '"' or '\' inside an item is escaped with a '\'
+//
+int pgParamArrayAdd(PgParams* paramsP, char** array, int items, bool eqForDot)
+{
+  int size = 3;  // '{', '}' and the zero-termination
+
+  for (int ix = 0; ix < items; ix++)
+  {
+    size += 2 * strlen(array[ix]) + 3;  // Worst case: every char escaped, plus quotes and comma
+  }
+
+  char* literal = kaAlloc(&orionldState.kalloc, size);
+  char* outP    = literal;
+
+  *outP++ = '{';
+  for (int ix = 0; ix < items; ix++)
+  {
+    if (ix != 0)
+      *outP++ = ',';
+
+    *outP++ = '"';
+    for (char* inP = array[ix]; *inP != 0; ++inP)
+    {
+      if ((*inP == '"') || (*inP == '\\'))
+        *outP++ = '\\';
+
+      *outP++ = ((eqForDot == true) && (*inP == '.'))? '=' : *inP;
+    }
+    *outP++ = '"';
+  }
+  *outP++ = '}';
+  *outP   = 0;
+
+  return pgParamAdd(paramsP, literal);
+}
@@ -0,0 +1,280 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strlen, strncmp, memcpy
+#include <stdint.h>                                              // int16_t, int32_t
+#include <arpa/inet.h>                                           // ntohs, ntohl
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // LmtSql
+
+#include "orionld/types/PgAppendBuffer.h"                        // PgAppendBuffer
+#include "orionld/types/PgTableDefinitions.h"                    // PG_*_INSERT_START
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/troe/pgStatementsPrepare.h"                    // PG_STMT_*
+#include "orionld/troe/pgPipeline.h"                             // Own interface
+
+
+
+#ifdef LIBPQ_HAS_PIPELINING
+// -----------------------------------------------------------------------------
+//
+// statementLookup - the prepared INSERT for the table of a buffer (from its INSERT header)
+//
+static const char* statementLookup(PgAppendBuffer* bufP, int* paramsP)
+{
+  if (strncmp(bufP->buf, PG_ENTITY_INSERT_START, strlen(PG_ENTITY_INSERT_START)) == 0)
+  {
+    *paramsP = PG_STMT_ENTITY_INSERT_PARAMS;
+    return PG_STMT_ENTITY_INSERT_NAME;
+  }
+  else if (strncmp(bufP->buf, PG_ATTRIBUTE_INSERT_START, strlen(PG_ATTRIBUTE_INSERT_START)) == 0)
+  {
+    *paramsP = PG_STMT_ATTRIBUTE_INSERT_PARAMS;
+    return PG_STMT_ATTRIBUTE_INSERT_NAME;
+  }
+  else if (strncmp(bufP->buf, PG_SUB_ATTRIBUTE_INSERT_START, strlen(PG_SUB_ATTRIBUTE_INSERT_START)) == 0)
+  {
+    *paramsP = PG_STMT_SUB_ATTRIBUTE_INSERT_PARAMS;
+    return PG_STMT_SUB_ATTRIBUTE_INSERT_NAME;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// resultsRead - read the results of 'queries' queries of the pipeline
+//
+// After an error, the rest of the queries up to the sync are not executed - their result is PGRES_PIPELINE_ABORTED
+//
+static bool resultsRead(PGconn* connectionP, int queries)
+{
+  bool ok = true;
+
+  for (int ix = 0; ix < queries; ix++)
+  {
+    PGresult* res;
+
+    while ((res = PQgetResult(connectionP)) != NULL)  // NULL ends the results of a query
+    {
+      ExecStatusType status = PQresultStatus(res);
+
+      if (status == PGRES_PIPELINE_ABORTED)
+        ok = false;
+      else if (status != PGRES_COMMAND_OK)
+      {
+        LM_E(("Database Error (pipelined INSERT: %s)", PQresultErrorMessage(res)));
+        ok = false;
+      }
+
+      PQclear(res);
+    }
+  }
+
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// commandSend - queue a command without parameters (BEGIN, COMMIT, ROLLBACK) in the pipeline
+//
+// The simple query protocol (PQsendQuery) isn't allowed in pipeline mode
+//
+static bool commandSend(PGconn* connectionP, const char* command)
+{
+  if (PQsendQueryParams(connectionP, command, 0, NULL, NULL, NULL, NULL, 0) != 1)
+    LM_RE(false, ("Database Error (unable to send %s in the pipeline: %s)", command, PQerrorMessage(connectionP)));
+
+  return true;
+}
+#endif
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgPipeline -
+//
+// The tuples are in the format of binary COPY: the number of fields (int16), and for each field its length (int32, -1 for NULL)
+// followed by the field in the binary format of its column - which is exactly what a binary parameter looks like.
+// The parameters point straight into the buffers - nothing is copied.
+//
+bool pgPipeline(PGconn* connectionP, PgAppendBuffer* bufferV[], int buffers)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+  const char*  paramV[PG_STMT_ATTRIBUTE_INSERT_PARAMS];   // The attributes table has the most columns
+  int          lengthV[PG_STMT_ATTRIBUTE_INSERT_PARAMS];
+  int          formatV[PG_STMT_ATTRIBUTE_INSERT_PARAMS];
+  int          sent     = 0;
+  int          pending  = 0;  // Queries whose results haven't been read
+  bool         ok       = true;
+
+  for (int ix = 0; ix < PG_STMT_ATTRIBUTE_INSERT_PARAMS; ix++)
+  {
+    formatV[ix] = 1;  // binary
+  }
+
+  if (PQenterPipelineMode(connectionP) != 1)
+    LM_RE(false, ("Database Error (unable to enter pipeline mode: %s)", PQerrorMessage(connectionP)));
+
+  //
+  // An explicit transaction - the sync alone would commit whatever has been queued before a client side error
+  //
+  if (commandSend(connectionP, "BEGIN") == false)
+    ok = false;
+  else
+    pending += 1;
+
+  for (int bIx = 0; (bIx < buffers) && (ok == true); bIx++)
+  {
+    PgAppendBuffer*  bufP   = bufferV[bIx];
+    int              params = 0;
+    const char*      stmt   = statementLookup(bufP, &params);
+
+    if (stmt == NULL)
+    {
+      LM_E(("Internal Error (not a TRoE INSERT header in a pipeline buffer)"));
+      ok = false;
+      break;
+    }
+
+    char* tupleP = &bufP->buf[bufP->copyStart];
+    char* endP   = &bufP->buf[bufP->currentIx];
+
+    while ((tupleP < endP) && (ok == true))
+    {
+      int16_t fields;
+
+      memcpy(&fields, tupleP, 2);
+      fields  = ntohs(fields);
+      tupleP += 2;
+
+      if (fields != params)
+      {
+        LM_E(("Internal Error (tuple of %d fields for the prepared statement %s, of %d parameters)", fields, stmt, params));
+        ok = false;
+        break;
+      }
+
+      for (int fIx = 0; fIx < fields; fIx++)
+      {
+        int32_t len;
+
+        memcpy(&len, tupleP, 4);
+        len     = ntohl(len);
+        tupleP += 4;
+
+        if (len == -1)
+        {
+          paramV[fIx]  = NULL;
+          lengthV[fIx] = 0;
+        }
+        else
+        {
+          paramV[fIx]  = tupleP;
+          lengthV[fIx] = len;
+          tupleP      += len;
+        }
+      }
+
+      if (PQsendQueryPrepared(connectionP, stmt, fields, paramV, lengthV, formatV, 0) != 1)
+      {
+        LM_E(("Database Error (unable to send the prepared statement %s: %s)", stmt, PQerrorMessage(connectionP)));
+        ok = false;
+        break;
+      }
+
+      sent    += 1;
+      pending += 1;
+
+      if (pending == PG_PIPELINE_FLUSH)
+      {
+        if ((PQsendFlushRequest(connectionP) != 1) || (PQflush(connectionP) != 0))
+          LM_E(("Database Error (unable to flush the pipeline: %s)", PQerrorMessage(connectionP)));
+
+        ok      = resultsRead(connectionP, pending);
+        pending = 0;
+      }
+    }
+  }
+
+  //
+  // COMMIT if all went well, ROLLBACK if not.
+  // After a server side error, the ROLLBACK isn't executed (the rest of the pipeline is aborted), and the
+  // transaction is still open (aborted) after the sync - it is rolled back once out of pipeline mode.
+  //
+  if ((ok == true) && (commandSend(connectionP, "COMMIT") == true))
+    pending += 1;
+  else if (commandSend(connectionP, "ROLLBACK") == true)
+  {
+    ok       = false;
+    pending += 1;
+  }
+  else
+    ok = false;
+
+  if (PQpipelineSync(connectionP) != 1)
+  {
+    LM_E(("Database Error (unable to sync the pipeline: %s)", PQerrorMessage(connectionP)));
+    return false;
+  }
+
+  if (resultsRead(connectionP, pending) == false)
+    ok = false;
+
+  PGresult* res = PQgetResult(connectionP);
+
+  if ((res == NULL) || (PQresultStatus(res) != PGRES_PIPELINE_SYNC))
+  {
+    LM_E(("Database Error (no sync at the end of the pipeline: %s)", PQerrorMessage(connectionP)));
+    ok = false;
+  }
+  PQclear(res);
+
+  if (PQexitPipelineMode(connectionP) != 1)
+    LM_E(("Database Error (unable to exit pipeline mode: %s)", PQerrorMessage(connectionP)));
+  else if (PQtransactionStatus(connectionP) != PQTRANS_IDLE)
+  {
+    PGresult* rollbackP = PQexec(connectionP, "ROLLBACK");
+
+    if (PQresultStatus(rollbackP) != PGRES_COMMAND_OK)
+      LM_E(("Database Error (ROLLBACK after a failed pipeline: %s)", PQresultErrorMessage(rollbackP)));
+    PQclear(rollbackP);
+
+    ok = false;
+  }
+
+  LM_T(LmtSql, ("SQL: pipeline of %d prepared INSERTs: %s", sent, (ok == true)? "committed" : "rolled back"));
+
+  return ok;
+#else
+  LM_E(("Internal Error (the postgres client library has no pipeline mode)"));
+  return false;
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGPIPELINE_H_
+#define SRC_LIB_ORIONLD_TROE_PGPIPELINE_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/PgAppendBuffer.h"                        // PgAppendBuffer
+#include "orionld/common/pqHeader.h"                             // Postgres header
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PG_PIPELINE_FLUSH - number of queries in the pipeline before the server is asked to flush the results so far
+//
+// The results are read after every PG_PIPELINE_FLUSH queries, so that neither side blocks on a full socket buffer.
+//
+#define PG_PIPELINE_FLUSH 1000
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgPipeline - execute the binary tuples of TRoE buffers as prepared INSERTs, in pipeline mode
+//
+// Every tuple is sent as the (binary) parameters of the prepared INSERT of the table of its buffer (pgStatementsPrepare).
+// The entire pipeline is one single explicit transaction (BEGIN ... COMMIT) - if any of the INSERTs fails, on the
+// client side (bad tuple, send error) or in postgres, the transaction is rolled back and nothing is committed.
+//
+// A pipeline of N INSERTs costs 1 + N / PG_PIPELINE_FLUSH round trips to postgres.
+//
+extern bool pgPipeline(PGconn* connectionP, PgAppendBuffer* bufferV[], int buffers);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGPIPELINE_H_
@@ -0,0 +1,44 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGPIPELINEBUFFER_H_
+#define SRC_LIB_ORIONLD_TROE_PGPIPELINEBUFFER_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/PgAppendBuffer.h"                        // PgAppendBuffer
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgPipelineBuffer - make the buffer of a batch request a pipeline buffer
+//
+// The rows are then appended as binary tuples (same as for -troeCopy), later sent as the parameters of the prepared
+// INSERTs of pgStatementsPrepare, all of them in one single pipeline (pgPipelineCommands).
+// Nothing is changed with -troeCopy (the COPY is kept), nor if the postgres client library lacks pipeline mode.
+//
+// Must be called right after pgAppendInit.
+//
+extern void pgPipelineBuffer(PgAppendBuffer* bufP);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGPIPELINEBUFFER_H_
@@ -0,0 +1,77 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/types/PgAppendBuffer.h"                        // PgAppendBuffer
+#include "orionld/types/PgConnection.h"                          // PgConnection
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/troe/pgConnectionGet.h"                        // pgConnectionGet
+#include "orionld/troe/pgConnectionRelease.h"                    // pgConnectionRelease
+#include "orionld/troe/pgStatementsPrepare.h"                    // pgStatementsPrepare
+#include "orionld/troe/pgPipeline.h"                             // pgPipeline
+#include "orionld/troe/pgCopyCommands.h"                         // pgCopyCommands
+#include "orionld/troe/troeWriter.h"                             // troeWriterCopyEnqueue
+#include "orionld/troe/pgPipelineCommands.h"                     // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgPipelineCommands -
+//
+// The tuples of pipeline buffers are binary COPY tuples, so, if the prepared statements aren't available,
+// the buffers are COPIED instead - and the same goes for the group commit of the TRoE writer.
+//
+void pgPipelineCommands(PgAppendBuffer* bufferV[], int buffers)
+{
+  //
+  // Group commit (-troeFlushInterval) - the TRoE writer takes over
+  //
+  if (troeWriterCopyEnqueue(orionldState.tenantP->troeDbName, bufferV, buffers) == true)
+    return;
+
+  PgConnection* connectionP = pgConnectionGet(orionldState.tenantP->troeDbName);
+
+  if ((connectionP == NULL) || (connectionP->connectionP == NULL))
+    LM_RVE(("no connection to postgres"));
+
+  //
+  // The statements are prepared when the connection is established - unless the TRoE tables didn't exist at that time
+  //
+  if (pgStatementsPrepare(connectionP) == false)
+  {
+    pgConnectionRelease(connectionP);
+    LM_W(("Unable to prepare the TRoE INSERT statements - using COPY instead of pipeline mode"));
+    pgCopyCommands(bufferV, buffers);
+    return;
+  }
+
+  if (pgPipeline(connectionP->connectionP, bufferV, buffers) == false)
+    LM_E(("Database Error (pipeline of TRoE INSERTs failed - the transaction was rolled back)"));
+
+  pgConnectionRelease(connectionP);
+}
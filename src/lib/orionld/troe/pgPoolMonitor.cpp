@@ -0,0 +1,242 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <time.h>                                                // time, clock_gettime
+#include <pthread.h>                                             // pthread_*
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // LmtPgPool
+
+#include "orionld/types/PgConnectionPool.h"                      // PgConnectionPool
+#include "orionld/types/PgConnection.h"                          // PgConnection
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/common/orionldState.h"                         // troePoolIdleTime, promPgPool*
+#include "orionld/prometheus/promCounterIncrease.h"              // promCounterIncrease
+#include "orionld/prometheus/promGaugeAdd.h"                     // promGaugeAdd
+#include "orionld/troe/pgConnectionPools.h"                      // pgPoolMaster
+#include "orionld/troe/pgFreeListDetach.h"                       // pgFreeListDetach
+#include "orionld/troe/pgFreeListPush.h"                         // pgFreeListPush
+#include "orionld/troe/pgStatementsPrepare.h"                    // pgStatementsPrepare
+#include "orionld/troe/pgPoolMonitor.h"                          // Own interface
+
+
+
+static pthread_mutex_t  monitorMutex    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   monitorCond     = PTHREAD_COND_INITIALIZER;
+static bool             monitorRunning  = false;
+static bool             monitorStop     = false;
+static pthread_t        monitorThread;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// listAppend - append a connection to a chain of free connections
+//
+static void listAppend(PgConnection** firstPP, PgConnection** lastPP, PgConnection* cP)
+{
+  cP->nextFree = 0;
+
+  if (*lastPP == NULL)
+    *firstPP = cP;
+  else
+    (*lastPP)->nextFree = cP->index + 1;
+
+  *lastPP = cP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// connectionAlive - is the connection still up?
+//
+// PQstatus only tells the state as of the last operation on the connection, and a connection that the server
+// (or a firewall) has closed while idle is still CONNECTION_OK.
+// The socket of a libpq connection is always non-blocking, so PQconsumeInput doesn't wait - it reads whatever
+// has arrived (nothing, on an idle connection) and fails if the peer has closed the connection.
+//
+static bool connectionAlive(PGconn* connectionP)
+{
+  if (PQstatus(connectionP) != CONNECTION_OK)
+    return false;
+
+  if (PQconsumeInput(connectionP) == 0)
+    return false;
+
+  return PQstatus(connectionP) == CONNECTION_OK;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// poolCheck - check the free connections of a pool
+//
+// The free list is detached, so the connections are ours while they're checked.
+// Broken connections are reset and idle connections are closed, and then the connections go back to the free list:
+// first the unconnected ones and then the live ones, so that pgConnectionGet pops the live connections first.
+//
+static void poolCheck(PgConnectionPool* poolP, time_t now)
+{
+  PgConnection* cP = pgFreeListDetach(poolP);
+
+  if (cP == NULL)
+    return;
+
+  PgConnection* liveFirst = NULL;
+  PgConnection* liveLast  = NULL;
+  PgConnection* deadFirst = NULL;
+  PgConnection* deadLast  = NULL;
+
+  while (cP != NULL)
+  {
+    PgConnection* next = (cP->nextFree == 0)? NULL : poolP->connectionV[cP->nextFree - 1];
+
+    if (cP->connectionP == NULL)                                                                // Not connected
+      listAppend(&deadFirst, &deadLast, cP);
+    else if (connectionAlive(cP->connectionP) == false)                                         // Broken
+    {
+      LM_W(("Connection %d of the pool of db '%s' is lost, re-connecting", cP->index, poolP->db));
+      PQreset(cP->connectionP);
+
+      if (PQstatus(cP->connectionP) == CONNECTION_OK)
+      {
+        promCounterIncrease(promPgPoolReconnects);
+        cP->prepared = 0;  // Prepared statements don't survive a reconnection
+
+        if (poolP->db != NULL)
+          pgStatementsPrepare(cP);
+
+        listAppend(&liveFirst, &liveLast, cP);
+      }
+      else
+      {
+        PQfinish(cP->connectionP);
+        cP->connectionP = NULL;
+        cP->prepared    = 0;
+        promGaugeAdd(promPgPoolConnections, -1, NULL);
+        listAppend(&deadFirst, &deadLast, cP);
+      }
+    }
+    else if ((troePoolIdleTime > 0) && (now - cP->lastUsed > troePoolIdleTime))                 // Idle
+    {
+      LM_T(LmtPgPool, ("PGPOOL: closing connection %d of the pool of db '%s' (idle for %d seconds)", cP->index, poolP->db, (int) (now - cP->lastUsed)));
+      PQfinish(cP->connectionP);
+      cP->connectionP = NULL;
+      cP->prepared    = 0;
+      promGaugeAdd(promPgPoolConnections, -1, NULL);
+      listAppend(&deadFirst, &deadLast, cP);
+    }
+    else
+      listAppend(&liveFirst, &liveLast, cP);
+
+    cP = next;
+  }
+
+  // The free list is a stack - what is pushed last is popped first
+  if (deadFirst != NULL)
+    pgFreeListPush(poolP, deadFirst, deadLast);
+
+  if (liveFirst != NULL)
+    pgFreeListPush(poolP, liveFirst, liveLast);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgPoolMonitor - the pool monitor thread
+//
+static void* pgPoolMonitor(void* vP)
+{
+  pthread_mutex_lock(&monitorMutex);
+
+  while (monitorStop == false)
+  {
+    struct timespec until;
+
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += 1;
+
+    pthread_cond_timedwait(&monitorCond, &monitorMutex, &until);
+    if (monitorStop == true)
+      break;
+
+    pthread_mutex_unlock(&monitorMutex);
+
+    time_t now = time(NULL);
+    for (PgConnectionPool* poolP = pgPoolMaster; poolP != NULL; poolP = __atomic_load_n(&poolP->next, __ATOMIC_ACQUIRE))
+    {
+      poolCheck(poolP, now);
+    }
+
+    pthread_mutex_lock(&monitorMutex);
+  }
+
+  pthread_mutex_unlock(&monitorMutex);
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgPoolMonitorStart -
+//
+bool pgPoolMonitorStart(void)
+{
+  int s = pthread_create(&monitorThread, NULL, pgPoolMonitor, NULL);
+
+  if (s != 0)
+  {
+    LM_E(("Runtime Error (error creating the postgres pool monitor thread: %d)", s));
+    return false;
+  }
+
+  monitorRunning = true;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgPoolMonitorStop -
+//
+void pgPoolMonitorStop(void)
+{
+  if (monitorRunning == false)
+    return;
+
+  pthread_mutex_lock(&monitorMutex);
+  monitorStop = true;
+  pthread_cond_signal(&monitorCond);
+  pthread_mutex_unlock(&monitorMutex);
+
+  pthread_join(monitorThread, NULL);
+  monitorRunning = false;
+}
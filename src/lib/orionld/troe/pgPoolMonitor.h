@@ -0,0 +1,50 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGPOOLMONITOR_H_
+#define SRC_LIB_ORIONLD_TROE_PGPOOLMONITOR_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgPoolMonitorStart - start the thread that checks the free connections of the postgres connection pools
+//
+// Once a second, the free connections of every pool are checked:
+// - broken connections (also those closed by the server while idle) are reset (PQreset), so that no request has to reconnect
+// - connections that haven't been used for -troePoolIdleTime seconds are closed (the slot stays in the pool)
+// - the live connections are put back on top of the free list, the unconnected slots underneath
+//
+extern bool pgPoolMonitorStart(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgPoolMonitorStop -
+//
+extern void pgPoolMonitorStop(void);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGPOOLMONITOR_H_
@@ -0,0 +1,108 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/types/PgConnection.h"                          // PgConnection
+#include "orionld/troe/pgStatementsPrepare.h"                    // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PgStatement -
+//
+typedef struct PgStatement
+{
+  int          bit;
+  const char*  name;
+  int          params;
+  const char*  sql;
+} PgStatement;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// statementV -
+//
+static PgStatement statementV[] =
+{
+  {
+    PG_STMT_ENTITY_INSERT,
+    PG_STMT_ENTITY_INSERT_NAME,
+    PG_STMT_ENTITY_INSERT_PARAMS,
+    "INSERT INTO entities(instanceId, ts, opMode, id, type) VALUES ($1, $2, $3, $4, $5)"
+  },
+  {
+    PG_STMT_ATTRIBUTE_INSERT,
+    PG_STMT_ATTRIBUTE_INSERT_NAME,
+    PG_STMT_ATTRIBUTE_INSERT_PARAMS,
+    "INSERT INTO attributes(instanceId, id, opMode, entityId, observedAt, subProperties, unitCode, datasetId, valueType, "
+    "text, boolean, number, datetime, compound, geoPoint, geoMultiPoint, geoPolygon, geoMultiPolygon, geoLineString, geoMultiLineString, ts) "
+    "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16, $17, $18, $19, $20, $21)"
+  },
+  {
+    PG_STMT_SUB_ATTRIBUTE_INSERT,
+    PG_STMT_SUB_ATTRIBUTE_INSERT_NAME,
+    PG_STMT_SUB_ATTRIBUTE_INSERT_PARAMS,
+    "INSERT INTO subAttributes(instanceId, id, entityId, attrInstanceId, attrDatasetId, observedAt, unitCode, valueType, "
+    "text, boolean, number, datetime, compound, geoPoint, geoMultiPoint, geoPolygon, geoMultiPolygon, geoLineString, geoMultiLineString, ts) "
+    "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16, $17, $18, $19, $20)"
+  }
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgStatementsPrepare -
+//
+bool pgStatementsPrepare(PgConnection* cP)
+{
+  if ((cP->prepared & PG_STMT_ALL) == PG_STMT_ALL)
+    return true;
+
+  for (unsigned int ix = 0; ix < sizeof(statementV) / sizeof(statementV[0]); ix++)
+  {
+    PgStatement* stmtP = &statementV[ix];
+
+    if ((cP->prepared & stmtP->bit) != 0)
+      continue;
+
+    PGresult* res = PQprepare(cP->connectionP, stmtP->name, stmtP->sql, stmtP->params, NULL);
+
+    if ((res != NULL) && (PQresultStatus(res) == PGRES_COMMAND_OK))
+      cP->prepared |= stmtP->bit;
+    else
+      LM_T(LmtSql, ("Unable to prepare '%s' (%s)", stmtP->name, (res != NULL)? PQresultErrorMessage(res) : "no result"));
+
+    if (res != NULL)
+      PQclear(res);
+  }
+
+  return ((cP->prepared & PG_STMT_ALL) == PG_STMT_ALL);
+}
@@ -0,0 +1,69 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGSTATEMENTSPREPARE_H_
+#define SRC_LIB_ORIONLD_TROE_PGSTATEMENTSPREPARE_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/PgConnection.h"                          // PgConnection
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Prepared statements of the TRoE inserts - one per table - one row per execution
+//
+// The parameters are in the order of the columns of the INSERT (NULL for SQL NULL) - the order of the columns of
+// PgTableDefinitions.h, and so, of the binary COPY tuples - which is how pgPipeline executes them (binary parameters).
+// As text, the geo columns accept (E)WKT, e.g. 'SRID=4326;POINT(1 2 3)'.
+//
+#define PG_STMT_ENTITY_INSERT               (1 << 0)
+#define PG_STMT_ATTRIBUTE_INSERT            (1 << 1)
+#define PG_STMT_SUB_ATTRIBUTE_INSERT        (1 << 2)
+
+#define PG_STMT_ALL                         (PG_STMT_ENTITY_INSERT | PG_STMT_ATTRIBUTE_INSERT | PG_STMT_SUB_ATTRIBUTE_INSERT)
+
+#define PG_STMT_ENTITY_INSERT_NAME          "troeEntityInsert"
+#define PG_STMT_ATTRIBUTE_INSERT_NAME       "troeAttributeInsert"
+#define PG_STMT_SUB_ATTRIBUTE_INSERT_NAME   "troeSubAttributeInsert"
+
+#define PG_STMT_ENTITY_INSERT_PARAMS         5   // instanceId, ts, opMode, id, type
+#define PG_STMT_ATTRIBUTE_INSERT_PARAMS     21   // instanceId, id, opMode, entityId, observedAt, subProperties, unitCode, datasetId, valueType,
+                                                 // text, boolean, number, datetime, compound, geoPoint, geoMultiPoint, geoPolygon,
+                                                 // geoMultiPolygon, geoLineString, geoMultiLineString, ts
+#define PG_STMT_SUB_ATTRIBUTE_INSERT_PARAMS 19   // instanceId, id, entityId, attrInstanceId, attrDatasetId, observedAt, unitCode, valueType,
+                                                 // text, boolean, number, datetime, compound, geoPoint, geoMultiPoint, geoPolygon,
+                                                 // geoMultiPolygon, geoLineString, geoMultiLineString, ts
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgStatementsPrepare - create the prepared statements of the TRoE inserts in a connection, the ones not already there
+//
+// Returns true if all of them are in place.
+// Preparing fails if the tables don't exist (yet) - the missing statements are then prepared in a later call.
+//
+extern bool pgStatementsPrepare(PgConnection* cP);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGSTATEMENTSPREPARE_H_
@@ -44,6 +44,7 @@ extern "C"
 #include "orionld/troe/kjGeoMultiLineStringExtract.h"          // kjGeoMultiLineStringExtract
 #include "orionld/troe/kjGeoPolygonExtract.h"                  // kjGeoPolygonExtract
 #include "orionld/troe/kjGeoMultiPolygonExtract.h"             // kjGeoMultiPolygonExtract
+#include "orionld/troe/pgSubAttributeCopy.h"                   // pgSubAttributeCopy
 #include "orionld/troe/pgSubAttributeAppend.h"                 // Own interface
 
 
@@ -91,6 +92,12 @@ void pgSubAttributeAppend
   const char*      object
 )
 {
+  if (subAttributesBufferP->binary == true)  // -troeCopy
+  {
+    pgSubAttributeCopy(subAttributesBufferP, instanceId, subAttributeName, entityId, attrInstanceId, attrDatasetId, type, observedAt, unitCode, valueNodeP, object);
+    return;
+  }
+
   int         bufSize = 20480;
   char*       buf     = kaAlloc(&orionldState.kalloc, bufSize);
   const char* comma   = (subAttributesBufferP->values != 0)? "," : "";
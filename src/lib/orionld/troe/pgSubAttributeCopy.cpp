@@ -0,0 +1,84 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                            // strcmp
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                      // KjNode
+}
+
+#include "orionld/types/PgAppendBuffer.h"                      // PgAppendBuffer
+#include "orionld/common/orionldState.h"                       // orionldState
+#include "orionld/common/eqForDot.h"                           // eqForDot
+#include "orionld/troe/pgCopyAppend.h"                         // pgCopyTupleStart, pgCopyText, pgCopyDateTime, pgCopyTimestamp
+#include "orionld/troe/pgCopyValue.h"                          // pgCopyValueType, pgCopyValue, PG_VALUE_COLUMNS
+#include "orionld/troe/pgSubAttributeCopy.h"                   // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgSubAttributeCopy -
+//
+// Tuple: instanceId, id, entityId, attrInstanceId, attrDatasetId, observedAt, unitCode, valueType,
+//        the PG_VALUE_COLUMNS value columns, ts
+//
+void pgSubAttributeCopy
+(
+  PgAppendBuffer*  subAttributesBufferP,
+  const char*      instanceId,
+  char*            subAttributeName,
+  const char*      entityId,
+  const char*      attrInstanceId,
+  char*            attrDatasetId,  // might be NULL, but can't be in the DB
+  const char*      type,
+  char*            observedAt,     // Can be NULL
+  char*            unitCode,       // Can be NULL
+  KjNode*          valueNodeP,
+  const char*      object
+)
+{
+  int         column    = -1;
+  const char* valueType = pgCopyValueType(type, valueNodeP, &column);
+  bool        useObject = ((type == NULL) || (strcmp(type, "Relationship") == 0));
+
+  eqForDot(subAttributeName);
+
+  pgCopyTupleStart(subAttributesBufferP, 8 + PG_VALUE_COLUMNS + 1);
+
+  pgCopyText(subAttributesBufferP, instanceId);
+  pgCopyText(subAttributesBufferP, subAttributeName);
+  pgCopyText(subAttributesBufferP, entityId);
+  pgCopyText(subAttributesBufferP, attrInstanceId);
+  pgCopyText(subAttributesBufferP, (attrDatasetId == NULL)? "None" : attrDatasetId);
+  pgCopyDateTime(subAttributesBufferP, observedAt);
+  pgCopyText(subAttributesBufferP, unitCode);
+  pgCopyText(subAttributesBufferP, valueType);
+
+  pgCopyValue(subAttributesBufferP, column, valueNodeP, (useObject == true)? object : NULL);
+  pgCopyTimestamp(subAttributesBufferP, orionldState.requestTime);
+
+  subAttributesBufferP->values += 1;
+}
@@ -0,0 +1,56 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGSUBATTRIBUTECOPY_H_
+#define SRC_LIB_ORIONLD_TROE_PGSUBATTRIBUTECOPY_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+extern "C"
+{
+#include "kjson/KjNode.h"                                           // KjNode
+}
+
+#include "orionld/types/PgAppendBuffer.h"                           // PgAppendBuffer
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgSubAttributeCopy - pgSubAttributeAppend for COPY subAttributes FROM STDIN (FORMAT binary)
+//
+extern void pgSubAttributeCopy
+(
+  PgAppendBuffer*  subAttributesBufferP,
+  const char*      instanceId,
+  char*            subAttributeName,
+  const char*      entityId,
+  const char*      attrInstanceId,
+  char*            attrDatasetId,  // might be NULL, but can't be in the DB
+  const char*      type,
+  char*            observedAt,     // Can be NULL
+  char*            unitCode,       // Can be NULL
+  KjNode*          valueNodeP,
+  const char*      object
+);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGSUBATTRIBUTECOPY_H_
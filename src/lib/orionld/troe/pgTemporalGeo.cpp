@@ -0,0 +1,118 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // snprintf
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjRenderSize.h"                                  // kjFastRenderSize
+#include "kjson/kjRender.h"                                      // kjFastRender
+}
+
+#include "orionld/types/OrionldGeoInfo.h"                        // OrionldGeoInfo
+#include "orionld/types/OrionldGeometry.h"                       // orionldGeometryToString
+#include "orionld/types/OrionldGeorel.h"                         // orionldGeorelToString
+#include "orionld/types/TroeSql.h"                               // TroeSql, PG_GEO_VALUE
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/orionldError.h"                         // orionldError
+#include "orionld/common/eqForDot.h"                             // eqForDot
+#include "orionld/troe/pgAppend.h"                               // pgAppend
+#include "orionld/troe/pgParamAdd.h"                             // pgParamAdd
+#include "orionld/troe/pgTemporalWindow.h"                       // pgTemporalWindow
+#include "orionld/troe/pgTemporalGeo.h"                          // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalGeo -
+//
+// The geometry of the query is given to postgres as GeoJSON, and compared to the value of the geo-property as 'geography',
+// so that distances are in meters:
+//
+//   near;maxDistance==D   ST_DWithin(value, geometry, D)
+//   near;minDistance==D   NOT ST_DWithin(value, geometry, D)
+//   within                ST_Covers(geometry, value)
+//   contains              ST_Covers(value, geometry)
+//   intersects            ST_Intersects(value, geometry)
+//   disjoint              NOT ST_Intersects(value, geometry)
+//   equals                ST_Equals(value, geometry)      - as 'geometry'
+//   overlaps              ST_Overlaps(value, geometry)    - as 'geometry'
+//
+bool pgTemporalGeo(TroeSql* sqlP, TroeQuery* tqP)
+{
+  OrionldGeoInfo* geoInfoP        = tqP->geoInfoP;
+  int             coordinatesSize = kjFastRenderSize(geoInfoP->coordinates);
+  char*           coordinates     = kaAlloc(&orionldState.kalloc, coordinatesSize);
+  int             geoJsonSize     = coordinatesSize + 64;
+  char*           geoJson         = kaAlloc(&orionldState.kalloc, geoJsonSize);
+  char*           geoProperty     = kaStrdup(&orionldState.kalloc, geoInfoP->geoProperty);
+
+  kjFastRender(geoInfoP->coordinates, coordinates);
+  snprintf(geoJson, geoJsonSize, "{\"type\":\"%s\",\"coordinates\":%s}", orionldGeometryToString(geoInfoP->geometry), coordinates);
+  eqForDot(geoProperty);
+
+  int  geoPropertyNo = pgParamAdd(&sqlP->params, geoProperty);
+  int  geometryNo    = pgParamAdd(&sqlP->params, geoJson);
+  char geometry[64];
+  char condition[512];
+
+  snprintf(geometry, sizeof(geometry), "ST_GeomFromGeoJSON($%d)::geography", geometryNo);
+
+  switch (geoInfoP->georel)
+  {
+  case GeorelNear:
+    if (geoInfoP->maxDistance > 0)
+      snprintf(condition, sizeof(condition), "ST_DWithin(" PG_GEO_VALUE("ga") ", %s, %d)", geometry, geoInfoP->maxDistance);
+    else
+      snprintf(condition, sizeof(condition), "NOT ST_DWithin(" PG_GEO_VALUE("ga") ", %s, %d)", geometry, geoInfoP->minDistance);
+    break;
+
+  case GeorelWithin:     snprintf(condition, sizeof(condition), "ST_Covers(%s, " PG_GEO_VALUE("ga") ")", geometry);                        break;
+  case GeorelContains:   snprintf(condition, sizeof(condition), "ST_Covers(" PG_GEO_VALUE("ga") ", %s)", geometry);                        break;
+  case GeorelIntersects: snprintf(condition, sizeof(condition), "ST_Intersects(" PG_GEO_VALUE("ga") ", %s)", geometry);                    break;
+  case GeorelDisjoint:   snprintf(condition, sizeof(condition), "NOT ST_Intersects(" PG_GEO_VALUE("ga") ", %s)", geometry);                break;
+  case GeorelEquals:     snprintf(condition, sizeof(condition), "ST_Equals(" PG_GEO_VALUE("ga") "::geometry, %s::geometry)", geometry);    break;
+  case GeorelOverlaps:   snprintf(condition, sizeof(condition), "ST_Overlaps(" PG_GEO_VALUE("ga") "::geometry, %s::geometry)", geometry);  break;
+
+  default:
+    orionldError(OrionldBadRequestData, "Invalid georel for a temporal query", orionldGeorelToString(geoInfoP->georel), 400);
+    return false;
+  }
+
+  char buf[128];
+
+  snprintf(buf, sizeof(buf), "EXISTS (SELECT 1 FROM attributes ga WHERE ga.entityId = le.id AND ga.id = $%d AND ga.opMode != 'Delete'", geoPropertyNo);
+  pgAppend(&sqlP->sql, buf, 0);
+  pgTemporalWindow(sqlP, tqP, "ga");
+  pgAppend(&sqlP->sql, " AND ", 5);
+  pgAppend(&sqlP->sql, condition, 0);
+  pgAppend(&sqlP->sql, ")", 1);
+
+  return true;
+}
@@ -0,0 +1,392 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // snprintf
+#include <string.h>                                              // strncmp, strcmp, strchr
+
+extern "C"
+{
+#include "kalloc/kaAlloc.h"                                      // kaAlloc
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+}
+
+#include "logMsg/logMsg.h"                                       // LM_*
+
+#include "orionld/types/QNode.h"                                 // QNode
+#include "orionld/types/TroeSql.h"                               // TroeSql, PG_TIMESTAMP_PARAM
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/orionldError.h"                         // orionldError
+#include "orionld/common/dateTime.h"                             // dateTimeFromString
+#include "orionld/q/qNodeType.h"                                 // qNodeType
+#include "orionld/troe/pgAppend.h"                               // pgAppend
+#include "orionld/troe/pgParamAdd.h"                             // pgParamAdd
+#include "orionld/troe/pgParamNumberAdd.h"                       // pgParamNumberAdd
+#include "orionld/troe/pgTemporalWindow.h"                       // pgTemporalWindow
+#include "orionld/troe/pgTemporalQ.h"                            // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// QVariable - what a q variable refers to, in terms of the TRoE tables
+//
+typedef struct QVariable
+{
+  char*        attrName;      // As in the TRoE tables (eq-for-dot)
+  char*        subAttrName;   // NULL unless the variable is about a sub-attribute
+  char*        jsonPath;      // '{a,b,c}' - for a path inside a compound value - else NULL
+  const char*  column;        // "observedAt", "unitCode" or "ts" - NULL for the value
+} QVariable;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qVariableSplit - split a variable for the DB into attribute, sub-attribute, path inside a compound value, and column
+//
+// As made by qVariableFix (forDb == true):
+//   attrs.A.value                 A
+//   attrs.A.value.P.Q             A[P.Q]
+//   attrs.A.md.B.value            A.B
+//   attrs.A.md.B.value.P          A.B.P
+//   attrs.A.md.observedAt.value   A.observedAt
+//   attrs.A.creDate|modDate       A.createdAt, A.modifiedAt
+//   creDate|modDate               createdAt, modifiedAt - of the entity - not in the TRoE tables
+//
+static bool qVariableSplit(const char* variable, QVariable* varP)
+{
+  varP->attrName    = NULL;
+  varP->subAttrName = NULL;
+  varP->jsonPath    = NULL;
+  varP->column      = NULL;
+
+  if (strncmp(variable, "attrs.", 6) != 0)
+    return false;
+
+  char* attrName = kaStrdup(&orionldState.kalloc, &variable[6]);
+  char* rest     = strchr(attrName, '.');
+
+  if (rest == NULL)
+    return false;
+
+  *rest++        = 0;
+  varP->attrName = attrName;
+
+  if ((strcmp(rest, "creDate") == 0) || (strcmp(rest, "modDate") == 0))
+  {
+    varP->column = "ts";
+    return true;
+  }
+
+  if (strncmp(rest, "md.", 3) == 0)
+  {
+    char* subAttrName = &rest[3];
+
+    rest = strchr(subAttrName, '.');
+    if (rest == NULL)
+      return false;
+    *rest++ = 0;
+
+    if (strcmp(subAttrName, "observedAt") == 0)
+      varP->column = "observedAt";
+    else if ((strcmp(subAttrName, "unitCode") == 0) || (strcmp(subAttrName, "https://uri=etsi=org/ngsi-ld/unitCode") == 0))
+      varP->column = "unitCode";
+    else
+      varP->subAttrName = subAttrName;
+  }
+
+  if (strncmp(rest, "value", 5) != 0)
+    return false;
+
+  if (rest[5] == '.')  // Path inside a compound value: 'a.b.c' => '{a,b,c}'
+  {
+    char* path = &rest[6];
+    int   len  = strlen(path);
+    char* json = (char*) kaAlloc(&orionldState.kalloc, len + 3);
+
+    json[0] = '{';
+    for (int ix = 0; ix < len; ix++)
+    {
+      json[ix + 1] = (path[ix] == '.')? ',' : path[ix];
+    }
+    json[len + 1] = '}';
+    json[len + 2] = 0;
+
+    varP->jsonPath = json;
+  }
+  else if (rest[5] != 0)
+    return false;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qOperator - the SQL operator of a q comparison
+//
+static const char* qOperator(QNodeType type)
+{
+  switch (type)
+  {
+  case QNodeEQ:       return "=";
+  case QNodeNE:       return "<>";
+  case QNodeGT:       return ">";
+  case QNodeGE:       return ">=";
+  case QNodeLT:       return "<";
+  case QNodeLE:       return "<=";
+  case QNodeMatch:    return "~";
+  case QNodeNoMatch:  return "!~";
+  default:            break;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qOperand - the SQL of the left (column) and right (parameter) hand sides of a comparison with the value 'valueP'
+//
+static bool qOperand(TroeSql* sqlP, QVariable* varP, const char* alias, QNode* valueP, char* lhs, int lhsSize, char* rhs, int rhsSize)
+{
+  int paramNo;
+
+  if (varP->column != NULL)  // observedAt, unitCode, ts - all strings in the q-filter
+  {
+    if ((valueP->type != QNodeStringValue) && (valueP->type != QNodeRegexpValue))
+    {
+      orionldError(OrionldBadRequestData, "Invalid Q-Filter", "timestamps and unitCode are compared to strings", 400);
+      return false;
+    }
+
+    snprintf(lhs, lhsSize, "%s.%s", alias, varP->column);
+
+    if ((strcmp(varP->column, "unitCode") == 0) || (valueP->type == QNodeRegexpValue))
+    {
+      paramNo = pgParamAdd(&sqlP->params, valueP->value.s);
+      snprintf(rhs, rhsSize, "$%d", paramNo);
+      return true;
+    }
+
+    char   errorString[256];
+    double timestamp = dateTimeFromString(valueP->value.s, errorString, sizeof(errorString));
+
+    if (timestamp < 0)
+    {
+      orionldError(OrionldBadRequestData, "Invalid Q-Filter - not a valid DateTime", valueP->value.s, 400);
+      return false;
+    }
+
+    paramNo = pgParamNumberAdd(&sqlP->params, timestamp);
+    snprintf(rhs, rhsSize, PG_TIMESTAMP_PARAM, paramNo);
+    return true;
+  }
+
+  if (varP->jsonPath != NULL)  // Inside a compound value - jsonb comparison
+  {
+    int pathNo = pgParamAdd(&sqlP->params, varP->jsonPath);
+
+    if (valueP->type == QNodeRegexpValue)
+    {
+      snprintf(lhs, lhsSize, "(%s.compound #>> $%d::text[])", alias, pathNo);
+      paramNo = pgParamAdd(&sqlP->params, valueP->value.re);
+      snprintf(rhs, rhsSize, "$%d", paramNo);
+      return true;
+    }
+
+    snprintf(lhs, lhsSize, "(%s.compound #> $%d::text[])", alias, pathNo);
+
+    if      (valueP->type == QNodeStringValue)  snprintf(rhs, rhsSize, "to_jsonb($%d::text)",   pgParamAdd(&sqlP->params, valueP->value.s));
+    else if (valueP->type == QNodeIntegerValue) snprintf(rhs, rhsSize, "to_jsonb($%d::float8)", pgParamNumberAdd(&sqlP->params, valueP->value.i));
+    else if (valueP->type == QNodeFloatValue)   snprintf(rhs, rhsSize, "to_jsonb($%d::float8)", pgParamNumberAdd(&sqlP->params, valueP->value.f));
+    else if (valueP->type == QNodeTrueValue)    snprintf(rhs, rhsSize, "'true'::jsonb");
+    else if (valueP->type == QNodeFalseValue)   snprintf(rhs, rhsSize, "'false'::jsonb");
+    else
+    {
+      orionldError(OrionldBadRequestData, "Invalid Q-Filter - invalid value", qNodeType(valueP->type), 400);
+      return false;
+    }
+
+    return true;
+  }
+
+  if ((valueP->type == QNodeStringValue) || (valueP->type == QNodeRegexpValue))
+  {
+    snprintf(lhs, lhsSize, "%s.text", alias);
+    snprintf(rhs, rhsSize, "$%d", pgParamAdd(&sqlP->params, (valueP->type == QNodeStringValue)? valueP->value.s : valueP->value.re));
+  }
+  else if ((valueP->type == QNodeIntegerValue) || (valueP->type == QNodeFloatValue))
+  {
+    double number = (valueP->type == QNodeIntegerValue)? valueP->value.i : valueP->value.f;
+
+    snprintf(lhs, lhsSize, "%s.number", alias);
+    snprintf(rhs, rhsSize, "$%d::float8", pgParamNumberAdd(&sqlP->params, number));
+  }
+  else if ((valueP->type == QNodeTrueValue) || (valueP->type == QNodeFalseValue))
+  {
+    snprintf(lhs, lhsSize, "%s.boolean", alias);
+    snprintf(rhs, rhsSize, "%s", (valueP->type == QNodeTrueValue)? "true" : "false");
+  }
+  else
+  {
+    orionldError(OrionldBadRequestData, "Invalid Q-Filter - invalid value", qNodeType(valueP->type), 400);
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// qComparison - the SQL condition of a comparison, on the row 'alias' - appended to the SQL command
+//
+static bool qComparison(TroeSql* sqlP, QVariable* varP, const char* alias, QNodeType op, QNode* rightP)
+{
+  char lhs[256];
+  char rhs[256];
+  char buf[600];
+
+  if (rightP->type == QNodeRange)  // A==1..5 / A!=1..5
+  {
+    QNode* lowerP = rightP->value.children;
+    QNode* upperP = lowerP->next;
+    char   upper[256];
+
+    if ((qOperand(sqlP, varP, alias, lowerP, lhs, sizeof(lhs), rhs,   sizeof(rhs))   == false) ||
+        (qOperand(sqlP, varP, alias, upperP, lhs, sizeof(lhs), upper, sizeof(upper)) == false))
+      return false;
+
+    snprintf(buf, sizeof(buf), "%s %sBETWEEN %s AND %s", lhs, (op == QNodeNE)? "NOT " : "", rhs, upper);
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+  else if (rightP->type == QNodeComma)  // A==1,2,3 / A!=1,2,3
+  {
+    pgAppend(&sqlP->sql, (op == QNodeNE)? "NOT (" : "(", 0);
+
+    for (QNode* valueP = rightP->value.children; valueP != NULL; valueP = valueP->next)
+    {
+      if (qOperand(sqlP, varP, alias, valueP, lhs, sizeof(lhs), rhs, sizeof(rhs)) == false)
+        return false;
+
+      snprintf(buf, sizeof(buf), "%s%s = %s", (valueP == rightP->value.children)? "" : " OR ", lhs, rhs);
+      pgAppend(&sqlP->sql, buf, 0);
+    }
+
+    pgAppend(&sqlP->sql, ")", 1);
+  }
+  else
+  {
+    const char* sqlOp = qOperator(op);
+
+    if ((sqlOp == NULL) || (qOperand(sqlP, varP, alias, rightP, lhs, sizeof(lhs), rhs, sizeof(rhs)) == false))
+    {
+      if (sqlOp == NULL)
+        orionldError(OrionldBadRequestData, "Invalid Q-Filter - unsupported operator", qNodeType(op), 400);
+      return false;
+    }
+
+    snprintf(buf, sizeof(buf), "%s %s %s", lhs, sqlOp, rhs);
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalQ -
+//
+bool pgTemporalQ(TroeSql* sqlP, TroeQuery* tqP, QNode* qNodeP)
+{
+  if ((qNodeP->type == QNodeAnd) || (qNodeP->type == QNodeOr))
+  {
+    const char* op = (qNodeP->type == QNodeAnd)? " AND " : " OR ";
+
+    pgAppend(&sqlP->sql, "(", 1);
+    for (QNode* childP = qNodeP->value.children; childP != NULL; childP = childP->next)
+    {
+      if (childP != qNodeP->value.children)
+        pgAppend(&sqlP->sql, op, 0);
+
+      if (pgTemporalQ(sqlP, tqP, childP) == false)
+        return false;
+    }
+    pgAppend(&sqlP->sql, ")", 1);
+
+    return true;
+  }
+
+  QNode*    variableP = qNodeP->value.children;  // Also for Exists/NotExists
+  QVariable var;
+
+  if ((variableP == NULL) || (variableP->type != QNodeVariable) || (qVariableSplit(variableP->value.v, &var) == false))
+  {
+    orionldError(OrionldBadRequestData,
+                 "Invalid Q-Filter for a temporal query",
+                 ((variableP != NULL) && (variableP->type == QNodeVariable))? variableP->value.v : qNodeType(qNodeP->type),
+                 400);
+    return false;
+  }
+
+  //
+  // EXISTS (SELECT 1 FROM attributes qa [JOIN subAttributes qs ON ...] WHERE qa.entityId = le.id AND qa.id = $A AND ... AND <comparison>)
+  //
+  char        buf[512];
+  const char* alias  = (var.subAttrName != NULL)? "qs" : "qa";
+  int         attrNo = pgParamAdd(&sqlP->params, var.attrName);
+
+  snprintf(buf, sizeof(buf), "%sEXISTS (SELECT 1 FROM attributes qa%s WHERE qa.entityId = le.id AND qa.id = $%d AND qa.opMode != 'Delete'",
+           (qNodeP->type == QNodeNotExists)? "NOT " : "",
+           (var.subAttrName != NULL)? " JOIN subAttributes qs ON qs.attrInstanceId = qa.instanceId" : "",
+           attrNo);
+  pgAppend(&sqlP->sql, buf, 0);
+
+  if (var.subAttrName != NULL)
+  {
+    snprintf(buf, sizeof(buf), " AND qs.id = $%d", pgParamAdd(&sqlP->params, var.subAttrName));
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+
+  pgTemporalWindow(sqlP, tqP, "qa");
+
+  if ((qNodeP->type != QNodeExists) && (qNodeP->type != QNodeNotExists))
+  {
+    pgAppend(&sqlP->sql, " AND ", 5);
+
+    if (qComparison(sqlP, &var, alias, qNodeP->type, variableP->next) == false)
+      return false;
+  }
+
+  pgAppend(&sqlP->sql, ")", 1);
+
+  return true;
+}
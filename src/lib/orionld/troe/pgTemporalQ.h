@@ -0,0 +1,45 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGTEMPORALQ_H_
+#define SRC_LIB_ORIONLD_TROE_PGTEMPORALQ_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/QNode.h"                                 // QNode
+#include "orionld/types/TroeSql.h"                               // TroeSql
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalQ - append the SQL condition of a q-filter (parsed for the DB, 'forDb' == true) on the entities of a temporal query
+//
+// An entity matches a comparison if any of the instances of the attribute, inside the time window, matches.
+// The entity id must be available as 'le.id' in the SQL command.
+//
+// On error, orionldError is called and false is returned.
+//
+extern bool pgTemporalQ(TroeSql* sqlP, TroeQuery* tqP, QNode* qNodeP);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGTEMPORALQ_H_
@@ -0,0 +1,149 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // free
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // Lmt*
+
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBuilder.h"                                     // kjArray
+}
+
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/orionldError.h"                         // orionldError
+#include "orionld/types/PgConnection.h"                          // PgConnection
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
+#include "orionld/types/TroeSql.h"                               // TroeSql
+#include "orionld/types/TroeResult.h"                            // TroeResult
+#include "orionld/troe/pgAppendInit.h"                           // pgAppendInit
+#include "orionld/troe/pgConnectionGet.h"                        // pgConnectionGet
+#include "orionld/troe/pgConnectionRelease.h"                    // pgConnectionRelease
+#include "orionld/troe/pgTemporalSelect.h"                       // pgTemporalSelect
+#include "orionld/troe/pgTemporalRowAdd.h"                       // pgTemporalRowAdd
+#include "orionld/troe/pgTemporalQuery.h"                        // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalQuery -
+//
+// The rows are streamed from postgres in single-row mode (PQsetSingleRowMode), each row added to the response as it
+// arrives, so the complete result set is never materialized in the broker - only the response tree itself.
+//
+KjNode* pgTemporalQuery(TroeQuery* tqP)
+{
+  TroeSql sql;
+
+  pgAppendInit(&sql.sql, 4 * 1024);
+  sql.sql.binary      = false;  // SQL text, whatever -troeCopy says
+  sql.params.items    = 0;
+  sql.timeAtParam     = 0;
+  sql.endTimeAtParam  = 0;
+
+  bool           ok          = pgTemporalSelect(&sql, tqP);
+  PgConnection*  connectionP = NULL;
+
+  if ((ok == true) && (sql.params.items > PG_PARAMS_MAX))
+  {
+    orionldError(OrionldBadRequestData, "Temporal query too complex", "too many parameters for the SQL command", 400);
+    ok = false;
+  }
+
+  if (ok == true)
+  {
+    connectionP = pgConnectionGet(orionldState.tenantP->troeDbName);
+
+    if ((connectionP == NULL) || (connectionP->connectionP == NULL))
+    {
+      if (connectionP != NULL)
+        pgConnectionRelease(connectionP);
+      orionldError(OrionldInternalError, "Database Error", "no connection to postgres", 500);
+      ok = false;
+    }
+  }
+
+  if (ok == false)
+  {
+    if (sql.sql.allocated == true)
+      free(sql.sql.buf);
+    return NULL;
+  }
+
+  LM_T(LmtSql, ("SQL: %s;", sql.sql.buf));
+
+  if (PQsendQueryParams(connectionP->connectionP, sql.sql.buf, sql.params.items, NULL, sql.params.valueV, NULL, NULL, 0) == 0)
+  {
+    LM_E(("Database Error (%s)", PQerrorMessage(connectionP->connectionP)));
+    pgConnectionRelease(connectionP);
+    if (sql.sql.allocated == true)
+      free(sql.sql.buf);
+    orionldError(OrionldInternalError, "Database Error", "unable to send the temporal query", 500);
+    return NULL;
+  }
+
+  if (PQsetSingleRowMode(connectionP->connectionP) == 0)
+    LM_W(("Unable to set single-row mode - the result set is received all at once"));
+
+  TroeResult result = { kjArray(orionldState.kjsonP, NULL), NULL, NULL, NULL, NULL, NULL, NULL, 0 };
+  PGresult*  res;
+
+  // All results must be consumed before the connection can be reused
+  while ((res = PQgetResult(connectionP->connectionP)) != NULL)
+  {
+    ExecStatusType status = PQresultStatus(res);
+
+    if ((ok == true) && ((status == PGRES_SINGLE_TUPLE) || (status == PGRES_TUPLES_OK)))
+    {
+      int rows = PQntuples(res);
+
+      for (int row = 0; row < rows; row++)
+        pgTemporalRowAdd(&result, tqP, res, row);
+    }
+    else if (ok == true)
+    {
+      LM_E(("Database Error (%s: %s)", PQresStatus(status), PQresultErrorMessage(res)));
+      ok = false;
+    }
+
+    PQclear(res);
+  }
+
+  pgConnectionRelease(connectionP);
+
+  if (sql.sql.allocated == true)
+    free(sql.sql.buf);
+
+  if (ok == false)
+  {
+    orionldError(OrionldInternalError, "Database Error", "the temporal query failed", 500);
+    return NULL;
+  }
+
+  return result.entityArray;
+}
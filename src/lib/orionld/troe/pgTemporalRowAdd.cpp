@@ -0,0 +1,384 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+#include <stdlib.h>                                              // strtod
+
+extern "C"
+{
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBuilder.h"                                     // kjObject, kjArray, kjString, kjFloat, kjChildAdd
+#include "kjson/kjParse.h"                                       // kjParse
+}
+
+#include "orionld/common/pqHeader.h"                             // PGresult, PQgetvalue, PQgetisnull
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/dotForEq.h"                             // dotForEq
+#include "orionld/context/orionldContextItemAliasLookup.h"       // orionldContextItemAliasLookup
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
+#include "orionld/types/TroeResult.h"                            // TroeResult
+#include "orionld/troe/pgTemporalSelect.h"                       // TROE_COL_*
+#include "orionld/troe/pgTemporalValue.h"                        // pgTemporalValue, TROE_VALUE_*
+#include "orionld/troe/troeAggrMethodsParse.h"                   // troeAggrMethodV
+#include "orionld/troe/pgTemporalRowAdd.h"                       // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// COLUMN - a column of the current row, NULL if null in the DB
+//
+#define COLUMN(col)  ((PQgetisnull(res, row, col) != 0)? NULL : PQgetvalue(res, row, col))
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nameCompact - the compacted name of an attribute, as it's stored in the TRoE tables (eq-for-dot)
+//
+static char* nameCompact(const char* dbName)
+{
+  char* longName = kaStrdup(&orionldState.kalloc, dbName);
+
+  dotForEq(longName);
+  return orionldContextItemAliasLookup(orionldState.contextP, longName, NULL, NULL);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// stringAdd - add a string member to an object, copying the string (the PGresult is cleared after each row)
+//
+static void stringAdd(KjNode* containerP, const char* name, const char* value)
+{
+  if (value == NULL)
+    return;
+
+  kjChildAdd(containerP, kjString(orionldState.kjsonP, name, kaStrdup(&orionldState.kalloc, value)));
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entityStart - a new entity in the response
+//
+static void entityStart(TroeResult* resultP, PGresult* res, int row)
+{
+  char* entityId   = PQgetvalue(res, row, TROE_COL_ENTITY_ID);
+  char* entityType = PQgetvalue(res, row, TROE_COL_ENTITY_TYPE);
+
+  resultP->entityP   = kjObject(orionldState.kjsonP, NULL);
+  resultP->entityId  = kaStrdup(&orionldState.kalloc, entityId);
+  resultP->attrP     = NULL;
+  resultP->attrName  = NULL;
+  resultP->datasetP  = NULL;
+  resultP->datasetId = NULL;
+  resultP->entities += 1;
+
+  kjChildAdd(resultP->entityP, kjString(orionldState.kjsonP, "id", resultP->entityId));
+  kjChildAdd(resultP->entityP, kjString(orionldState.kjsonP, "type", orionldContextItemAliasLookup(orionldState.contextP, kaStrdup(&orionldState.kalloc, entityType), NULL, NULL)));
+  kjChildAdd(resultP->entityArray, resultP->entityP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// subAttributesAdd - add the sub-attributes of an attribute instance, given as a JSON array of arrays of strings
+//
+// Each sub-attribute: [ id, valueType, text, boolean, number, datetime, compound, geo, observedAt, unitCode ]
+//
+static void subAttributesAdd(KjNode* instanceP, const char* subAttributes)
+{
+  KjNode* subAttrArray = kjParse(orionldState.kjsonP, kaStrdup(&orionldState.kalloc, subAttributes));
+
+  if ((subAttrArray == NULL) || (subAttrArray->type != KjArray))
+    return;
+
+  for (KjNode* subAttrP = subAttrArray->value.firstChildP; subAttrP != NULL; subAttrP = subAttrP->next)
+  {
+    char* itemV[10] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+    int   items     = 0;
+
+    for (KjNode* itemP = subAttrP->value.firstChildP; (itemP != NULL) && (items < 10); itemP = itemP->next)
+    {
+      itemV[items] = (itemP->type == KjString)? itemP->value.s : NULL;
+      ++items;
+    }
+
+    if ((items != 10) || (itemV[0] == NULL))
+      continue;
+
+    const char* attrType;
+    const char* valueField;
+    KjNode*     valueP    = pgTemporalValue(itemV[1], &itemV[2], &attrType, &valueField);
+    KjNode*     subAttrNP = kjObject(orionldState.kjsonP, nameCompact(itemV[0]));
+
+    valueP->name = (char*) valueField;
+    kjChildAdd(subAttrNP, kjString(orionldState.kjsonP, "type", attrType));
+    kjChildAdd(subAttrNP, valueP);
+    stringAdd(subAttrNP, "observedAt", itemV[8]);
+    stringAdd(subAttrNP, "unitCode",   itemV[9]);
+    kjChildAdd(instanceP, subAttrNP);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// instanceAdd - normalized: an attribute instance, added to the array of instances of the attribute
+//
+static void instanceAdd(TroeResult* resultP, TroeQuery* tqP, PGresult* res, int row)
+{
+  char*        valueV[TROE_VALUES];
+  const char*  attrType;
+  const char*  valueField;
+  char*        datasetId = PQgetvalue(res, row, TROE_COL_DATASET_ID);
+  KjNode*      instanceP = kjObject(orionldState.kjsonP, NULL);
+
+  for (int ix = 0; ix < TROE_VALUES; ix++)
+    valueV[ix] = COLUMN(TROE_COL_TEXT + ix);
+
+  KjNode* valueP = pgTemporalValue(COLUMN(TROE_COL_VALUE_TYPE), valueV, &attrType, &valueField);
+
+  valueP->name = (char*) valueField;
+  kjChildAdd(instanceP, kjString(orionldState.kjsonP, "type", attrType));
+  kjChildAdd(instanceP, valueP);
+  stringAdd(instanceP, "observedAt", COLUMN(TROE_COL_OBSERVED_AT));
+  stringAdd(instanceP, "unitCode",   COLUMN(TROE_COL_UNIT_CODE));
+
+  if (strcmp(datasetId, "None") != 0)
+    stringAdd(instanceP, "datasetId", datasetId);
+
+  stringAdd(instanceP, "instanceId", COLUMN(TROE_COL_INSTANCE_ID));
+
+  if (tqP->sysAttrs == true)
+    stringAdd(instanceP, "modifiedAt", COLUMN(TROE_COL_TS));
+
+  char* subAttributes = COLUMN(TROE_COL_SUB_ATTRIBUTES);
+  if (subAttributes != NULL)
+    subAttributesAdd(instanceP, subAttributes);
+
+  kjChildAdd(resultP->attrP, instanceP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// datasetStart - temporalValues/aggregatedValues: a new datasetId of the current attribute
+//
+// The first datasetId is the attribute itself (an object).
+// If a second one comes, the attribute is turned into an array of objects, one per datasetId.
+//
+static void datasetStart(TroeResult* resultP, TroeQuery* tqP, PGresult* res, int row, char* datasetId)
+{
+  KjNode*     datasetP = kjObject(orionldState.kjsonP, NULL);
+  const char* attrType;
+  const char* valueField;
+  const char* valueType = COLUMN(TROE_COL_VALUE_TYPE);
+
+  if (resultP->datasetP == NULL)
+  {
+    datasetP->name = resultP->attrP->name;
+    kjChildAdd(resultP->entityP, datasetP);
+    resultP->attrP = datasetP;
+  }
+  else
+  {
+    if (resultP->attrP->type == KjObject)
+    {
+      KjNode* firstP = kjObject(orionldState.kjsonP, NULL);
+
+      firstP->value.firstChildP = resultP->attrP->value.firstChildP;
+      firstP->lastChild         = resultP->attrP->lastChild;
+
+      resultP->attrP->type              = KjArray;
+      resultP->attrP->value.firstChildP = NULL;
+      resultP->attrP->lastChild         = NULL;
+      kjChildAdd(resultP->attrP, firstP);
+    }
+
+    kjChildAdd(resultP->attrP, datasetP);
+  }
+
+  //
+  // The attribute type - the value is not used, only the type of the attribute
+  //
+  if ((valueType != NULL) && (strcmp(valueType, "Relationship") == 0))
+    attrType = "Relationship";
+  else if ((valueType != NULL) && (strcmp(valueType, "LanguageMap") == 0))
+    attrType = "LanguageProperty";
+  else if ((valueType != NULL) && (strncmp(valueType, "Geo", 3) == 0))
+    attrType = "GeoProperty";
+  else
+    attrType = "Property";
+
+  kjChildAdd(datasetP, kjString(orionldState.kjsonP, "type", attrType));
+
+  if (tqP->format == TroeFormatTemporalValues)
+  {
+    if (strcmp(attrType, "Relationship") == 0)
+      valueField = "objects";
+    else if (strcmp(attrType, "LanguageProperty") == 0)
+      valueField = "languageMaps";
+    else
+      valueField = "values";
+
+    kjChildAdd(datasetP, kjArray(orionldState.kjsonP, valueField));
+  }
+  else
+  {
+    for (int ix = 0; ix < TROE_AGGR_METHODS; ix++)
+    {
+      if ((tqP->aggrMethods & (1 << ix)) != 0)
+        kjChildAdd(datasetP, kjArray(orionldState.kjsonP, troeAggrMethodV[ix]));
+    }
+  }
+
+  if (strcmp(datasetId, "None") != 0)
+    stringAdd(datasetP, "datasetId", datasetId);
+
+  resultP->datasetP  = datasetP;
+  resultP->datasetId = kaStrdup(&orionldState.kalloc, datasetId);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// temporalValueAdd - temporalValues: [ value, time ] added to the "values" (or "objects", or "languageMaps") of the datasetId
+//
+static void temporalValueAdd(TroeResult* resultP, PGresult* res, int row)
+{
+  char*        valueV[TROE_VALUES];
+  const char*  attrType;
+  const char*  valueField;
+  KjNode*      pairP = kjArray(orionldState.kjsonP, NULL);
+  char*        time  = COLUMN(TROE_COL_TIME);
+
+  for (int ix = 0; ix < TROE_VALUES; ix++)
+    valueV[ix] = COLUMN(TROE_COL_TEXT + ix);
+
+  kjChildAdd(pairP, pgTemporalValue(COLUMN(TROE_COL_VALUE_TYPE), valueV, &attrType, &valueField));
+
+  if (time != NULL)
+    kjChildAdd(pairP, kjString(orionldState.kjsonP, NULL, kaStrdup(&orionldState.kalloc, time)));
+  else
+    kjChildAdd(pairP, kjNull(orionldState.kjsonP, NULL));
+
+  // The array of values is the second member of the datasetId object - after "type"
+  kjChildAdd(resultP->datasetP->value.firstChildP->next, pairP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// aggregatedValueAdd - aggregatedValues: [ value, startAt, endAt ] added to the array of each aggregation method
+//
+static void aggregatedValueAdd(TroeResult* resultP, TroeQuery* tqP, PGresult* res, int row)
+{
+  char*   startAt = COLUMN(TROE_COL_PERIOD_START);
+  char*   endAt   = COLUMN(TROE_COL_PERIOD_END);
+  KjNode* methodP = resultP->datasetP->value.firstChildP->next;  // After "type", the arrays of the methods, in order
+
+  for (int ix = 0; ix < TROE_AGGR_METHODS; ix++)
+  {
+    if ((tqP->aggrMethods & (1 << ix)) == 0)
+      continue;
+
+    char*   value   = COLUMN(TROE_COL_AGGR_FIRST + ix);
+    KjNode* tripleP = kjArray(orionldState.kjsonP, NULL);
+
+    if (value == NULL)
+      kjChildAdd(tripleP, kjNull(orionldState.kjsonP, NULL));
+    else if (ix <= 1)  // totalCount, distinctCount
+      kjChildAdd(tripleP, kjInteger(orionldState.kjsonP, NULL, strtoll(value, NULL, 10)));
+    else
+      kjChildAdd(tripleP, kjFloat(orionldState.kjsonP, NULL, strtod(value, NULL)));
+
+    kjChildAdd(tripleP, (startAt != NULL)? kjString(orionldState.kjsonP, NULL, kaStrdup(&orionldState.kalloc, startAt)) : kjNull(orionldState.kjsonP, NULL));
+    kjChildAdd(tripleP, (endAt   != NULL)? kjString(orionldState.kjsonP, NULL, kaStrdup(&orionldState.kalloc, endAt))   : kjNull(orionldState.kjsonP, NULL));
+
+    kjChildAdd(methodP, tripleP);
+    methodP = methodP->next;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalRowAdd -
+//
+// The rows come ordered by entity id, attribute name and datasetId, so a change in any of them starts a new
+// entity/attribute/datasetId in the response.
+//
+void pgTemporalRowAdd(TroeResult* resultP, TroeQuery* tqP, PGresult* res, int row)
+{
+  char* entityId = PQgetvalue(res, row, TROE_COL_ENTITY_ID);
+
+  if ((resultP->entityId == NULL) || (strcmp(entityId, resultP->entityId) != 0))
+    entityStart(resultP, res, row);
+
+  if (PQgetisnull(res, row, TROE_COL_ATTR_ID) != 0)  // An entity without attribute instances (in the time window)
+    return;
+
+  char* attrName  = PQgetvalue(res, row, TROE_COL_ATTR_ID);
+  char* datasetId = PQgetvalue(res, row, TROE_COL_DATASET_ID);
+
+  if ((resultP->attrName == NULL) || (strcmp(attrName, resultP->attrName) != 0))
+  {
+    resultP->attrName  = kaStrdup(&orionldState.kalloc, attrName);
+    resultP->datasetP  = NULL;
+    resultP->datasetId = NULL;
+
+    if (tqP->format == TroeFormatNormalized)
+    {
+      resultP->attrP = kjArray(orionldState.kjsonP, nameCompact(attrName));
+      kjChildAdd(resultP->entityP, resultP->attrP);
+    }
+    else
+      resultP->attrP = kjObject(orionldState.kjsonP, nameCompact(attrName));  // Not added - just keeps the name until datasetStart
+  }
+
+  if (tqP->format == TroeFormatNormalized)
+  {
+    instanceAdd(resultP, tqP, res, row);
+    return;
+  }
+
+  if ((resultP->datasetId == NULL) || (strcmp(datasetId, resultP->datasetId) != 0))
+    datasetStart(resultP, tqP, res, row, datasetId);
+
+  if (tqP->format == TroeFormatTemporalValues)
+    temporalValueAdd(resultP, res, row);
+  else
+    aggregatedValueAdd(resultP, tqP, res, row);
+}
@@ -0,0 +1,259 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // snprintf
+#include <string.h>                                              // strchr
+
+#include "orionld/types/TroeSql.h"                               // TroeSql, PG_ISO8601, PG_GEO_VALUE, PG_TIMESTAMP_PARAM
+#include "orionld/types/TroeQuery.h"                             // TroeQuery, TROE_AGGR_*
+#include "orionld/types/OrionldGeometry.h"                       // GeoNoGeometry
+#include "orionld/common/orionldError.h"                         // orionldError
+#include "orionld/troe/pgAppend.h"                               // pgAppend
+#include "orionld/troe/pgParamAdd.h"                             // pgParamAdd
+#include "orionld/troe/pgParamArrayAdd.h"                        // pgParamArrayAdd
+#include "orionld/troe/pgParamNumberAdd.h"                       // pgParamNumberAdd
+#include "orionld/troe/pgTemporalWindow.h"                       // pgTemporalWindow
+#include "orionld/troe/pgTemporalQ.h"                            // pgTemporalQ
+#include "orionld/troe/pgTemporalGeo.h"                          // pgTemporalGeo
+#include "orionld/troe/pgTemporalSelect.h"                       // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// aggrColumnV - the SQL of the aggregation methods, in the order of the TROE_AGGR_* bits
+//
+static const char* aggrColumnV[TROE_AGGR_METHODS] =
+{
+  "count(a.instanceId)",
+  "count(DISTINCT COALESCE(a.text, a.number::text, a.boolean::text, a.compound::text))",
+  "sum(a.number)",
+  "avg(a.number)",
+  "min(a.number)",
+  "max(a.number)",
+  "stddev_pop(a.number)",
+  "sum(a.number * a.number)"
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entitiesSelect - the common table expression 'e' with the matching entities (current state), paginated
+//
+static bool entitiesSelect(TroeSql* sqlP, TroeQuery* tqP)
+{
+  char buf[256];
+
+  pgAppend(&sqlP->sql, "WITH e AS (SELECT le.id, le.type FROM (SELECT DISTINCT ON (id) id, type, opMode FROM entities", 0);
+
+  if ((tqP->idList != NULL) && (tqP->idList->items > 0))
+  {
+    snprintf(buf, sizeof(buf), " WHERE id = ANY($%d::text[])", pgParamArrayAdd(&sqlP->params, tqP->idList->array, tqP->idList->items, false));
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+  else if (tqP->idPattern != NULL)
+  {
+    snprintf(buf, sizeof(buf), " WHERE id ~ $%d", pgParamAdd(&sqlP->params, tqP->idPattern));
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+
+  pgAppend(&sqlP->sql, " ORDER BY id, ts DESC) le WHERE le.opMode != 'Delete'", 0);
+
+  if ((tqP->typeList != NULL) && (tqP->typeList->items > 0))
+  {
+    snprintf(buf, sizeof(buf), " AND le.type = ANY($%d::text[])", pgParamArrayAdd(&sqlP->params, tqP->typeList->array, tqP->typeList->items, false));
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+
+  if (tqP->qNode != NULL)
+  {
+    pgAppend(&sqlP->sql, " AND ", 5);
+    if (pgTemporalQ(sqlP, tqP, tqP->qNode) == false)
+      return false;
+  }
+
+  if ((tqP->geoInfoP != NULL) && (tqP->geoInfoP->geometry != GeoNoGeometry))
+  {
+    pgAppend(&sqlP->sql, " AND ", 5);
+    if (pgTemporalGeo(sqlP, tqP) == false)
+      return false;
+  }
+
+  snprintf(buf, sizeof(buf), " ORDER BY le.id OFFSET %d LIMIT %d)", tqP->offset, tqP->limit);
+  pgAppend(&sqlP->sql, buf, 0);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// attributesWhere - the WHERE clause of the attribute instances of an entity 'e'
+//
+static void attributesWhere(TroeSql* sqlP, TroeQuery* tqP)
+{
+  pgAppend(&sqlP->sql, " FROM attributes a WHERE a.entityId = e.id AND a.opMode != 'Delete'", 0);
+
+  if ((tqP->attrList != NULL) && (tqP->attrList->items > 0))
+  {
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), " AND a.id = ANY($%d::text[])", pgParamArrayAdd(&sqlP->params, tqP->attrList->array, tqP->attrList->items, true));
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+
+  pgTemporalWindow(sqlP, tqP, "a");
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// instancesSelect - one row per attribute instance - the 'lastN' instances of each attribute, if lastN is given
+//
+static void instancesSelect(TroeSql* sqlP, TroeQuery* tqP)
+{
+  const char* tcol = tqP->timeColumn;
+  char        buf[512];
+
+  pgAppend(&sqlP->sql,
+           " SELECT e.id, e.type, a.id, a.datasetId, a.valueType, a.text, a.boolean, a.number, " PG_ISO8601("a.datetime") ", a.compound::text, "
+           "ST_AsGeoJSON(" PG_GEO_VALUE("a") "), " PG_ISO8601("a.observedAt") ", a.unitCode, a.instanceId, " PG_ISO8601("a.ts") ", ", 0);
+
+  snprintf(buf, sizeof(buf), PG_ISO8601("a.%s") ", ", tcol);
+  pgAppend(&sqlP->sql, buf, 0);
+
+  pgAppend(&sqlP->sql,
+           "CASE WHEN a.subProperties THEN (SELECT json_agg(json_build_array(s.id, s.valueType, s.text, s.boolean::text, s.number::text, "
+           PG_ISO8601("s.datetime") ", s.compound::text, ST_AsGeoJSON(" PG_GEO_VALUE("s") "), " PG_ISO8601("s.observedAt") ", s.unitCode))::text "
+           "FROM subAttributes s WHERE s.attrInstanceId = a.instanceId AND s.attrDatasetId = a.datasetId) END", 0);
+
+  snprintf(buf, sizeof(buf), " FROM e LEFT JOIN LATERAL (SELECT * FROM (SELECT a.*, row_number() OVER (PARTITION BY a.id, a.datasetId ORDER BY a.%s DESC NULLS LAST) AS rn", tcol);
+  pgAppend(&sqlP->sql, buf, 0);
+
+  attributesWhere(sqlP, tqP);
+
+  pgAppend(&sqlP->sql, ") w", 2);
+  if (tqP->lastN > 0)
+  {
+    snprintf(buf, sizeof(buf), " WHERE w.rn <= %d", tqP->lastN);
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+
+  snprintf(buf, sizeof(buf), ") a ON true ORDER BY e.id, a.id, a.datasetId, a.%s%s", tcol, (tqP->lastN > 0)? " DESC NULLS LAST" : "");
+  pgAppend(&sqlP->sql, buf, 0);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// aggregatedSelect - one row per attribute and period, with the aggregation methods computed by postgres
+//
+// Without aggrPeriodDuration, the whole time range of the instances of an attribute is one single period.
+// With it, the periods are the bins of 'date_bin', with the origin at 'timeAt' (or at the epoch, if no timeAt).
+//
+static bool aggregatedSelect(TroeSql* sqlP, TroeQuery* tqP)
+{
+  const char* tcol = tqP->timeColumn;
+  char        buf[512];
+  int         durationNo = 0;
+
+  if (tqP->aggrPeriodDuration != NULL)
+  {
+    // date_bin can't handle months nor years
+    char* tP = strchr(tqP->aggrPeriodDuration, 'T');
+    char* yP = strchr(tqP->aggrPeriodDuration, 'Y');
+    char* mP = strchr(tqP->aggrPeriodDuration, 'M');
+
+    if ((yP != NULL) || ((mP != NULL) && ((tP == NULL) || (mP < tP))))
+    {
+      orionldError(OrionldBadRequestData, "Unsupported aggrPeriodDuration (years and months are not supported)", tqP->aggrPeriodDuration, 400);
+      return false;
+    }
+
+    durationNo = pgParamAdd(&sqlP->params, tqP->aggrPeriodDuration);
+  }
+
+  pgAppend(&sqlP->sql, " SELECT e.id, e.type, a.id, a.datasetId, max(a.valueType::text), ", 0);
+
+  if (durationNo != 0)
+    snprintf(buf, sizeof(buf), PG_ISO8601("a.period") ", " PG_ISO8601("(a.period + $%d::interval)"), durationNo);
+  else
+    snprintf(buf, sizeof(buf), PG_ISO8601("min(a.%s)") ", " PG_ISO8601("max(a.%s)"), tcol, tcol);
+  pgAppend(&sqlP->sql, buf, 0);
+
+  for (int ix = 0; ix < TROE_AGGR_METHODS; ix++)
+  {
+    pgAppend(&sqlP->sql, ", ", 2);
+    pgAppend(&sqlP->sql, ((tqP->aggrMethods & (1 << ix)) != 0)? aggrColumnV[ix] : "NULL", 0);
+  }
+
+  if (durationNo == 0)
+    pgAppend(&sqlP->sql, " FROM e LEFT JOIN LATERAL (SELECT a.*, NULL::timestamp AS period", 0);
+  else if (sqlP->timeAtParam != 0)
+  {
+    snprintf(buf, sizeof(buf), " FROM e LEFT JOIN LATERAL (SELECT a.*, date_bin($%d::interval, a.%s, " PG_TIMESTAMP_PARAM ") AS period", durationNo, tcol, sqlP->timeAtParam);
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+  else
+  {
+    snprintf(buf, sizeof(buf), " FROM e LEFT JOIN LATERAL (SELECT a.*, date_bin($%d::interval, a.%s, TIMESTAMP '1970-01-01') AS period", durationNo, tcol);
+    pgAppend(&sqlP->sql, buf, 0);
+  }
+
+  attributesWhere(sqlP, tqP);
+
+  pgAppend(&sqlP->sql, ") a ON true GROUP BY e.id, e.type, a.id, a.datasetId, a.period ORDER BY e.id, a.id, a.datasetId, a.period", 0);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalSelect -
+//
+// The parameters timeAt and endTimeAt are added first, as they're used all over the command (once per time window).
+//
+bool pgTemporalSelect(TroeSql* sqlP, TroeQuery* tqP)
+{
+  if (tqP->timerel != TroeTimerelNone)
+    sqlP->timeAtParam = pgParamNumberAdd(&sqlP->params, tqP->timeAt);
+
+  if (tqP->timerel == TroeTimerelBetween)
+    sqlP->endTimeAtParam = pgParamNumberAdd(&sqlP->params, tqP->endTimeAt);
+
+  if (entitiesSelect(sqlP, tqP) == false)
+    return false;
+
+  if (tqP->format == TroeFormatAggregatedValues)
+    return aggregatedSelect(sqlP, tqP);
+
+  instancesSelect(sqlP, tqP);
+  return true;
+}
@@ -0,0 +1,85 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGTEMPORALSELECT_H_
+#define SRC_LIB_ORIONLD_TROE_PGTEMPORALSELECT_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/TroeSql.h"                               // TroeSql
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Columns of the rows of a temporal query - common to all formats
+//
+#define TROE_COL_ENTITY_ID          0
+#define TROE_COL_ENTITY_TYPE        1
+#define TROE_COL_ATTR_ID            2   // NULL if the entity has no attribute instances (inside the time window)
+#define TROE_COL_DATASET_ID         3
+#define TROE_COL_VALUE_TYPE         4
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Columns of the rows of a temporal query - one row per attribute instance (normalized and temporalValues)
+//
+#define TROE_COL_TEXT               5
+#define TROE_COL_BOOLEAN            6
+#define TROE_COL_NUMBER             7
+#define TROE_COL_DATETIME           8
+#define TROE_COL_COMPOUND           9
+#define TROE_COL_GEO                10
+#define TROE_COL_OBSERVED_AT        11
+#define TROE_COL_UNIT_CODE          12
+#define TROE_COL_INSTANCE_ID        13
+#define TROE_COL_TS                 14
+#define TROE_COL_TIME               15  // The 'timeproperty' of the query
+#define TROE_COL_SUB_ATTRIBUTES     16  // JSON array of [ id, valueType, text, boolean, number, datetime, compound, geo, observedAt, unitCode ] - all strings
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Columns of the rows of a temporal query - one row per attribute and period (aggregatedValues)
+//
+#define TROE_COL_PERIOD_START       5
+#define TROE_COL_PERIOD_END         6
+#define TROE_COL_AGGR_FIRST         7   // One column per aggregation method, in the order of the TROE_AGGR_* bits - NULL if not asked for
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalSelect - compose the SQL command of a temporal query
+//
+// The rows come ordered by entity id, attribute name, datasetId and time, so that the response can be built
+// while the rows are streamed from postgres.
+//
+// On error, orionldError is called and false is returned.
+//
+extern bool pgTemporalSelect(TroeSql* sqlP, TroeQuery* tqP);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGTEMPORALSELECT_H_
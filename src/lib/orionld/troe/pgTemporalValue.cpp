@@ -0,0 +1,120 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp
+#include <stdlib.h>                                              // strtod
+
+extern "C"
+{
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBuilder.h"                                     // kjString, kjInteger, kjFloat, kjBoolean, kjNull
+#include "kjson/kjParse.h"                                       // kjParse
+}
+
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/troe/pgTemporalValue.h"                        // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// jsonValue - parse a JSON value (compound or GeoJSON) - as a string if it can't be parsed
+//
+static KjNode* jsonValue(const char* json)
+{
+  char*   copy   = kaStrdup(&orionldState.kalloc, json);
+  KjNode* valueP = kjParse(orionldState.kjsonP, copy);
+
+  if (valueP == NULL)
+    valueP = kjString(orionldState.kjsonP, NULL, kaStrdup(&orionldState.kalloc, json));
+
+  return valueP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// numberValue - integral numbers are given back as integers, like they were most probably created
+//
+static KjNode* numberValue(const char* number)
+{
+  double d = strtod(number, NULL);
+
+  if ((d == (double) (long long) d) && (d < 9007199254740992.0) && (d > -9007199254740992.0))
+    return kjInteger(orionldState.kjsonP, NULL, (long long) d);
+
+  return kjFloat(orionldState.kjsonP, NULL, d);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalValue -
+//
+KjNode* pgTemporalValue(const char* valueType, char** valueV, const char** attrTypeP, const char** valueFieldP)
+{
+  const char* text = valueV[TROE_VALUE_TEXT];
+
+  *attrTypeP   = "Property";
+  *valueFieldP = "value";
+
+  if (valueType == NULL)
+    return kjNull(orionldState.kjsonP, NULL);
+
+  if (strcmp(valueType, "Relationship") == 0)
+  {
+    *attrTypeP   = "Relationship";
+    *valueFieldP = "object";
+  }
+  else if (strcmp(valueType, "LanguageMap") == 0)
+  {
+    *attrTypeP   = "LanguageProperty";
+    *valueFieldP = "languageMap";
+    text         = valueV[TROE_VALUE_COMPOUND];
+  }
+  else if (strncmp(valueType, "Geo", 3) == 0)
+  {
+    *attrTypeP = "GeoProperty";
+    text       = valueV[TROE_VALUE_GEO];
+  }
+  else if (strcmp(valueType, "Compound") == 0)
+    text = valueV[TROE_VALUE_COMPOUND];
+  else if (strcmp(valueType, "Number") == 0)
+    return (valueV[TROE_VALUE_NUMBER] != NULL)? numberValue(valueV[TROE_VALUE_NUMBER]) : kjNull(orionldState.kjsonP, NULL);
+  else if (strcmp(valueType, "Boolean") == 0)
+    return (valueV[TROE_VALUE_BOOLEAN] != NULL)? kjBoolean(orionldState.kjsonP, NULL, valueV[TROE_VALUE_BOOLEAN][0] == 't') : kjNull(orionldState.kjsonP, NULL);
+  else if (strcmp(valueType, "DateTime") == 0)
+    return (valueV[TROE_VALUE_DATETIME] != NULL)? kjString(orionldState.kjsonP, NULL, kaStrdup(&orionldState.kalloc, valueV[TROE_VALUE_DATETIME])) : kjNull(orionldState.kjsonP, NULL);
+
+  if (text == NULL)
+    return kjNull(orionldState.kjsonP, NULL);
+
+  if (text != valueV[TROE_VALUE_TEXT])  // Compound, LanguageMap, and GeoJSON
+    return jsonValue(text);
+
+  return kjString(orionldState.kjsonP, NULL, kaStrdup(&orionldState.kalloc, text));
+}
@@ -0,0 +1,59 @@
+#ifndef SRC_LIB_ORIONLD_TROE_PGTEMPORALVALUE_H_
+#define SRC_LIB_ORIONLD_TROE_PGTEMPORALVALUE_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Value columns of the TRoE tables, in the order they come in the rows of a temporal query (and in the sub-attribute arrays)
+//
+#define TROE_VALUE_TEXT       0
+#define TROE_VALUE_BOOLEAN    1
+#define TROE_VALUE_NUMBER     2
+#define TROE_VALUE_DATETIME   3
+#define TROE_VALUE_COMPOUND   4
+#define TROE_VALUE_GEO        5   // GeoJSON
+
+#define TROE_VALUES           6
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalValue - the value of an attribute instance, out of the value columns (as text - NULL if null) of the TRoE tables
+//
+// Also gives the NGSI-LD type of the attribute and the name of the field of the value ("value", "object", or "languageMap").
+// The value node has no name - that's up to the caller.
+//
+extern KjNode* pgTemporalValue(const char* valueType, char** valueV, const char** attrTypeP, const char** valueFieldP);
+
+#endif  // SRC_LIB_ORIONLD_TROE_PGTEMPORALVALUE_H_
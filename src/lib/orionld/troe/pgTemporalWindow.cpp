@@ -0,0 +1,58 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // snprintf
+
+#include "orionld/types/TroeSql.h"                               // TroeSql, PG_TIMESTAMP_PARAM
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
+#include "orionld/troe/pgAppend.h"                               // pgAppend
+#include "orionld/troe/pgTemporalWindow.h"                       // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// pgTemporalWindow -
+//
+// NGSI-LD:
+//   before:   time <  timeAt
+//   after:    time >  timeAt
+//   between:  timeAt <= time < endTimeAt
+//
+void pgTemporalWindow(TroeSql* sqlP, TroeQuery* tqP, const char* alias)
+{
+  char buf[256];
+
+  if (tqP->timerel == TroeTimerelBefore)
+    snprintf(buf, sizeof(buf), " AND %s.%s < " PG_TIMESTAMP_PARAM, alias, tqP->timeColumn, sqlP->timeAtParam);
+  else if (tqP->timerel == TroeTimerelAfter)
+    snprintf(buf, sizeof(buf), " AND %s.%s > " PG_TIMESTAMP_PARAM, alias, tqP->timeColumn, sqlP->timeAtParam);
+  else if (tqP->timerel == TroeTimerelBetween)
+    snprintf(buf, sizeof(buf), " AND %s.%s >= " PG_TIMESTAMP_PARAM " AND %s.%s < " PG_TIMESTAMP_PARAM,
+             alias, tqP->timeColumn, sqlP->timeAtParam, alias, tqP->timeColumn, sqlP->endTimeAtParam);
+  else
+    return;
+
+  pgAppend(&sqlP->sql, buf, 0);
+}
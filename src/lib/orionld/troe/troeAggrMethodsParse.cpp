@@ -0,0 +1,87 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp, strchr
+
+#include "orionld/types/TroeQuery.h"                             // TROE_AGGR_METHODS
+#include "orionld/common/orionldError.h"                         // orionldError
+#include "orionld/troe/troeAggrMethodsParse.h"                   // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeAggrMethodV -
+//
+const char* troeAggrMethodV[TROE_AGGR_METHODS] =
+{
+  "totalCount",
+  "distinctCount",
+  "sum",
+  "avg",
+  "min",
+  "max",
+  "stddev",
+  "sumsq"
+};
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeAggrMethodsParse -
+//
+// NOTE: the list is destroyed (the commas are nulled out)
+//
+int troeAggrMethodsParse(char* aggrMethods)
+{
+  int   methods = 0;
+  char* method  = aggrMethods;
+
+  while (method != NULL)
+  {
+    char* comma = strchr(method, ',');
+    int   ix;
+
+    if (comma != NULL)
+      *comma = 0;
+
+    for (ix = 0; ix < TROE_AGGR_METHODS; ix++)
+    {
+      if (strcmp(method, troeAggrMethodV[ix]) == 0)
+        break;
+    }
+
+    if (ix == TROE_AGGR_METHODS)
+    {
+      orionldError(OrionldBadRequestData, "Invalid value for URI parameter 'aggrMethods'", method, 400);
+      return -1;
+    }
+
+    methods |= (1 << ix);
+    method   = (comma != NULL)? &comma[1] : NULL;
+  }
+
+  return methods;
+}
@@ -0,0 +1,48 @@
+#ifndef SRC_LIB_ORIONLD_TROE_TROEAGGRMETHODSPARSE_H_
+#define SRC_LIB_ORIONLD_TROE_TROEAGGRMETHODSPARSE_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/TroeQuery.h"                             // TROE_AGGR_METHODS
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeAggrMethodV - the names of the aggregation methods, in the order of the TROE_AGGR_* bits
+//
+extern const char* troeAggrMethodV[TROE_AGGR_METHODS];
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeAggrMethodsParse - parse the comma-separated list of the URI param 'aggrMethods' into TROE_AGGR_* bits
+//
+// On error, orionldError is called and -1 is returned.
+//
+extern int troeAggrMethodsParse(char* aggrMethods);
+
+#endif  // SRC_LIB_ORIONLD_TROE_TROEAGGRMETHODSPARSE_H_
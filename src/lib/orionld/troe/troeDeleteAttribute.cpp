@@ -39,7 +39,7 @@ extern "C"
 #include "orionld/troe/pgAppendInit.h"                         // pgAppendInit
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgAttributeAppend.h"                    // pgAttributeAppend
-#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // pgBuffersCommit
 #include "orionld/troe/troeDeleteAttribute.h"                  // Own interface
 
 
@@ -106,12 +106,9 @@ bool troeDeleteAttribute(void)
   else
     pgAttributeAppend(&attributesBuffer, instanceId, attributeName, "Delete", entityId, (char*) "NULL", NULL, false, NULL, NULL, NULL);
 
-  if (attributesBuffer.values > 0)
-  {
-    char* sqlV[1] = { attributesBuffer.buf };
+  PgAppendBuffer* bufferV[1] = { &attributesBuffer };
 
-    pgCommands(sqlV, 1);
-  }
+  pgBuffersCommit(bufferV, 1);
 
   return true;
 }
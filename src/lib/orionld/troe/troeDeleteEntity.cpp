@@ -32,7 +32,7 @@
 #include "orionld/troe/pgAppendInit.h"                         // pgAppendInit
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgEntityAppend.h"                       // pgEntityAppend
-#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // pgBuffersCommit
 #include "orionld/troe/troeDeleteEntity.h"                     // Own interface
 
 
@@ -54,12 +54,9 @@ bool troeDeleteEntity(void)
 
   pgEntityAppend(&entitiesBuffer, "Delete", entityId, "NULL", instanceId);
 
-  if (entitiesBuffer.values > 0)
-  {
-    char* sqlV[1]  = { entitiesBuffer.buf };
+  PgAppendBuffer* bufferV[1] = { &entitiesBuffer };
 
-    pgCommands(sqlV, 1);
-  }
+  pgBuffersCommit(bufferV, 1);
 
   return true;
 }
@@ -41,7 +41,7 @@ extern "C"
 #include "orionld/troe/pgAttributesBuild.h"                    // pgAttributesBuild
 #include "orionld/troe/pgAttributeAppend.h"                    // pgAttributeAppend
 #include "orionld/troe/pgSubAttributeAppend.h"                 // pgSubAttributeAppend
-#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // pgBuffersCommit
 #include "orionld/troe/troePatchEntity.h"                      // Own interface
 
 
@@ -105,14 +105,9 @@ bool troePatchEntity(void)
     }
   }
 
-  char* sqlV[2];
-  int   sqlIx = 0;
+  PgAppendBuffer* bufferV[2] = { &attributesBuffer, &subAttributesBuffer };
 
-  if (attributesBuffer.values    > 0) sqlV[sqlIx++] = attributesBuffer.buf;
-  if (subAttributesBuffer.values > 0) sqlV[sqlIx++] = subAttributesBuffer.buf;
-
-  if (sqlIx > 0)
-    pgCommands(sqlV, sqlIx);
+  pgBuffersCommit(bufferV, 2);
 
   return true;
 }
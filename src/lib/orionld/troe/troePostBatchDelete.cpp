@@ -30,9 +30,10 @@
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/common/uuidGenerate.h"                       // uuidGenerate
 #include "orionld/troe/pgAppendInit.h"                         // pgAppendInit
+#include "orionld/troe/pgPipelineBuffer.h"                     // pgPipelineBuffer
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgEntityAppend.h"                       // pgEntityAppend
-#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // pgBuffersCommit
 #include "orionld/troe/troePostBatchDelete.h"                  // Own interface
 
 
@@ -46,6 +47,7 @@ bool troePostBatchDelete(void)
   PgAppendBuffer  entitiesBuffer;
 
   pgAppendInit(&entitiesBuffer, 2*1024);       // 2k - will be reallocated if necessary
+  pgPipelineBuffer(&entitiesBuffer);
   pgAppend(&entitiesBuffer, PG_ENTITY_INSERT_START, 0);
 
   for (KjNode* entityIdP = orionldState.requestTree->value.firstChildP; entityIdP != NULL; entityIdP = entityIdP->next)
@@ -58,11 +60,9 @@ bool troePostBatchDelete(void)
     pgEntityAppend(&entitiesBuffer, "Delete", entityId, "NULL", instanceId);
   }
 
-  if (entitiesBuffer.values > 0)
-  {
-    char* sqlV[1]  = { entitiesBuffer.buf };
-    pgCommands(sqlV, 1);
-  }
+  PgAppendBuffer* bufferV[1] = { &entitiesBuffer };
+
+  pgBuffersCommit(bufferV, 1);
 
   return true;
 }
@@ -37,9 +37,10 @@ extern "C"
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/common/troeIgnored.h"                        // troeIgnored
 #include "orionld/troe/pgAppendInit.h"                         // pgAppendInit
+#include "orionld/troe/pgPipelineBuffer.h"                     // pgPipelineBuffer
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgAttributesBuild.h"                    // pgAttributesBuild
-#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // pgBuffersCommit
 #include "orionld/troe/troePostBatchUpdate.h"                  // Own interface
 
 
@@ -57,6 +58,9 @@ bool troePostBatchUpdate(void)
   pgAppendInit(&attributes, 8*1024);     // 8k - will be reallocated if necessary
   pgAppendInit(&subAttributes, 8*1024);  // ditto
 
+  pgPipelineBuffer(&attributes);
+  pgPipelineBuffer(&subAttributes);
+
   pgAppend(&attributes,    PG_ATTRIBUTE_INSERT_START,     0);
   pgAppend(&subAttributes, PG_SUB_ATTRIBUTE_INSERT_START, 0);
 
@@ -76,14 +80,9 @@ bool troePostBatchUpdate(void)
     pgAttributesBuild(&attributes, entityP, NULL, attributeTroeMode, &subAttributes);
   }
 
-  char* sqlV[2];
-  int   sqlIx = 0;
-
-  if (attributes.values    > 0) sqlV[sqlIx++] = attributes.buf;
-  if (subAttributes.values > 0) sqlV[sqlIx++] = subAttributes.buf;
+  PgAppendBuffer* bufferV[2] = { &attributes, &subAttributes };
 
-  if (sqlIx > 0)
-    pgCommands(sqlV, sqlIx);
+  pgBuffersCommit(bufferV, 2);
 
   return true;
 }
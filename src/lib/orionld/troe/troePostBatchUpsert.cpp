@@ -37,10 +37,11 @@ extern "C"
 #include "orionld/common/orionldState.h"                       // orionldState
 #include "orionld/common/troeIgnored.h"                        // troeIgnored
 #include "orionld/troe/pgAppendInit.h"                         // pgAppendInit
+#include "orionld/troe/pgPipelineBuffer.h"                     // pgPipelineBuffer
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgAttributesBuild.h"                    // pgAttributesBuild
 #include "orionld/troe/pgEntityBuild.h"                        // pgEntityBuild
-#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // pgBuffersCommit
 #include "orionld/troe/troePostBatchUpsert.h"                  // Own interface
 
 
@@ -83,6 +84,10 @@ bool troePostBatchUpsert(void)
   pgAppendInit(&attributes, 8*1024);     // 8k - will be reallocated if necessary
   pgAppendInit(&subAttributes, 8*1024);  // ditto
 
+  pgPipelineBuffer(&entities);
+  pgPipelineBuffer(&attributes);
+  pgPipelineBuffer(&subAttributes);
+
   pgAppend(&entities,      PG_ENTITY_INSERT_START,        0);
   pgAppend(&attributes,    PG_ATTRIBUTE_INSERT_START,     0);
   pgAppend(&subAttributes, PG_SUB_ATTRIBUTE_INSERT_START, 0);
@@ -141,15 +146,9 @@ bool troePostBatchUpsert(void)
   }
 
 
-  char* sqlV[3];
-  int   sqlIx = 0;
-
-  if (entities.values      > 0) sqlV[sqlIx++] = entities.buf;
-  if (attributes.values    > 0) sqlV[sqlIx++] = attributes.buf;
-  if (subAttributes.values > 0) sqlV[sqlIx++] = subAttributes.buf;
+  PgAppendBuffer* bufferV[3] = { &entities, &attributes, &subAttributes };
 
-  if (sqlIx > 0)
-    pgCommands(sqlV, sqlIx);
+  pgBuffersCommit(bufferV, 3);
 
   return true;
 }
@@ -37,7 +37,7 @@ extern "C"
 #include "orionld/troe/pgAppendInit.h"                         // pgAppendInit
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgEntityBuild.h"                        // pgEntityBuild
-#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // pgBuffersCommit
 #include "orionld/troe/troePostEntities.h"                     // Own interface
 
 
@@ -80,15 +80,9 @@ bool troePostEntities(void)
 
   pgEntityBuild(&entities, opModeString, entityP, entityId, entityType, &attributes, &subAttributes);
 
-  char* sqlV[3];
-  int   sqlIx = 0;
+  PgAppendBuffer* bufferV[3] = { &entities, &attributes, &subAttributes };
 
-  if (entities.values      > 0) sqlV[sqlIx++] = entities.buf;
-  if (attributes.values    > 0) sqlV[sqlIx++] = attributes.buf;
-  if (subAttributes.values > 0) sqlV[sqlIx++] = subAttributes.buf;
-
-  if (sqlIx > 0)
-    pgCommands(sqlV, sqlIx);
+  pgBuffersCommit(bufferV, 3);
 
   return true;
 }
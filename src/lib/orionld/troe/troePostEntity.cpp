@@ -37,7 +37,7 @@ extern "C"
 #include "orionld/troe/pgAppendInit.h"                         // pgAppendInit
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgAttributesBuild.h"                    // pgAttributesBuild
-#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // pgBuffersCommit
 #include "orionld/troe/troePostEntity.h"                       // Own interface
 
 
@@ -64,14 +64,9 @@ bool troePostEntity(void)
 
   pgAttributesBuild(&attributesBuffer, orionldState.requestTree, entityId, opMode, &subAttributesBuffer);
 
-  char* sqlV[2];
-  int   sqlIx = 0;
+  PgAppendBuffer* bufferV[2] = { &attributesBuffer, &subAttributesBuffer };
 
-  if (attributesBuffer.values    > 0) sqlV[sqlIx++] = attributesBuffer.buf;
-  if (subAttributesBuffer.values > 0) sqlV[sqlIx++] = subAttributesBuffer.buf;
-
-  if (sqlIx > 0)
-    pgCommands(sqlV, sqlIx);
+  pgBuffersCommit(bufferV, 2);
 
   return true;
 }
@@ -37,7 +37,7 @@ extern "C"
 #include "orionld/troe/pgAppendInit.h"                         // pgAppendInit
 #include "orionld/troe/pgAppend.h"                             // pgAppend
 #include "orionld/troe/pgAttributeBuild.h"                     // pgAttributeBuild
-#include "orionld/troe/pgCommands.h"                           // pgCommands
+#include "orionld/troe/pgBuffersCommit.h"                      // pgBuffersCommit
 #include "orionld/troe/troePutAttribute.h"                   // Own interface
 
 
@@ -64,14 +64,9 @@ bool troePutAttribute(void)
 
   pgAttributeBuild(&attributes, "Replace", entityId, orionldState.requestTree, &subAttributes);
 
-  char* sqlV[2];
-  int   sqlIx = 0;
+  PgAppendBuffer* bufferV[2] = { &attributes, &subAttributes };
 
-  if (attributes.values    > 0) sqlV[sqlIx++] = attributes.buf;
-  if (subAttributes.values > 0) sqlV[sqlIx++] = subAttributes.buf;
-
-  if (sqlIx > 0)
-    pgCommands(sqlV, sqlIx);
+  pgBuffersCommit(bufferV, 2);
 
   return true;
 }
@@ -0,0 +1,172 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <string.h>                                              // strcmp, bzero
+
+#include "orionld/types/TroeQuery.h"                             // TroeQuery
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/orionldError.h"                         // orionldError
+#include "orionld/common/dateTime.h"                             // dateTimeFromString
+#include "orionld/troe/troeAggrMethodsParse.h"                   // troeAggrMethodsParse
+#include "orionld/troe/troeQueryParams.h"                        // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timeParam - parse a DateTime URI param into seconds since the epoch
+//
+static bool timeParam(const char* paramName, const char* value, double* timeP)
+{
+  char errorString[256];
+
+  *timeP = dateTimeFromString(value, errorString, sizeof(errorString));
+  if (*timeP < 0)
+  {
+    orionldError(OrionldBadRequestData, "Invalid DateTime value for URI parameter", paramName, 400);
+    return false;
+  }
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeQueryParams -
+//
+bool troeQueryParams(TroeQuery* tqP)
+{
+  OrionldUriParams* uriParamsP = &orionldState.uriParams;
+
+  bzero(tqP, sizeof(TroeQuery));
+
+  //
+  // timeproperty - createdAt and modifiedAt are both the time the instance was stored (each instance is created, never modified)
+  //
+  if ((uriParamsP->timeproperty == NULL) || (strcmp(uriParamsP->timeproperty, "observedAt") == 0))
+    tqP->timeColumn = "observedAt";
+  else if ((strcmp(uriParamsP->timeproperty, "createdAt") == 0) || (strcmp(uriParamsP->timeproperty, "modifiedAt") == 0))
+    tqP->timeColumn = "ts";
+  else
+  {
+    orionldError(OrionldBadRequestData, "Invalid value for URI parameter /timeproperty/", uriParamsP->timeproperty, 400);
+    return false;
+  }
+
+  //
+  // timerel, timeAt, endTimeAt
+  //
+  if (uriParamsP->timerel != NULL)
+  {
+    if      (strcmp(uriParamsP->timerel, "before")  == 0) tqP->timerel = TroeTimerelBefore;
+    else if (strcmp(uriParamsP->timerel, "after")   == 0) tqP->timerel = TroeTimerelAfter;
+    else if (strcmp(uriParamsP->timerel, "between") == 0) tqP->timerel = TroeTimerelBetween;
+    else
+    {
+      orionldError(OrionldBadRequestData, "Invalid value for URI parameter /timerel/", uriParamsP->timerel, 400);
+      return false;
+    }
+
+    if (uriParamsP->timeAt == NULL)
+    {
+      orionldError(OrionldBadRequestData, "Missing URI parameter", "timeAt (mandatory with timerel)", 400);
+      return false;
+    }
+
+    if (timeParam("timeAt", uriParamsP->timeAt, &tqP->timeAt) == false)
+      return false;
+
+    if (tqP->timerel == TroeTimerelBetween)
+    {
+      if (uriParamsP->endTimeAt == NULL)
+      {
+        orionldError(OrionldBadRequestData, "Missing URI parameter", "endTimeAt (mandatory with timerel=between)", 400);
+        return false;
+      }
+
+      if (timeParam("endTimeAt", uriParamsP->endTimeAt, &tqP->endTimeAt) == false)
+        return false;
+
+      if (tqP->endTimeAt <= tqP->timeAt)
+      {
+        orionldError(OrionldBadRequestData, "Invalid time interval", "endTimeAt must be after timeAt", 400);
+        return false;
+      }
+    }
+  }
+  else if ((uriParamsP->timeAt != NULL) || (uriParamsP->endTimeAt != NULL))
+  {
+    orionldError(OrionldBadRequestData, "Missing URI parameter", "timerel (mandatory with timeAt/endTimeAt)", 400);
+    return false;
+  }
+
+  //
+  // options - the temporal representation
+  //
+  if ((orionldState.uriParamOptions.temporalValues == true) && (orionldState.uriParamOptions.aggregatedValues == true))
+  {
+    orionldError(OrionldBadRequestData, "Incoherent value for /options/ URI param", "Both /temporalValues/ and /aggregatedValues/ are set", 400);
+    return false;
+  }
+
+  if (orionldState.uriParamOptions.temporalValues == true)
+    tqP->format = TroeFormatTemporalValues;
+  else if (orionldState.uriParamOptions.aggregatedValues == true)
+    tqP->format = TroeFormatAggregatedValues;
+  else
+    tqP->format = TroeFormatNormalized;
+
+  //
+  // aggrMethods, aggrPeriodDuration
+  //
+  if (tqP->format == TroeFormatAggregatedValues)
+  {
+    if (uriParamsP->aggrMethods == NULL)
+    {
+      orionldError(OrionldBadRequestData, "Missing URI parameter", "aggrMethods (mandatory with options=aggregatedValues)", 400);
+      return false;
+    }
+
+    tqP->aggrMethods = troeAggrMethodsParse(uriParamsP->aggrMethods);
+    if (tqP->aggrMethods == -1)
+      return false;
+
+    tqP->aggrPeriodDuration = uriParamsP->aggrPeriodDuration;
+  }
+  else if ((uriParamsP->aggrMethods != NULL) || (uriParamsP->aggrPeriodDuration != NULL))
+  {
+    orionldError(OrionldBadRequestData, "Invalid URI parameter", "aggrMethods/aggrPeriodDuration need options=aggregatedValues", 400);
+    return false;
+  }
+
+  tqP->lastN    = uriParamsP->lastN;
+  tqP->offset   = uriParamsP->offset;
+  tqP->limit    = uriParamsP->limit;
+  tqP->sysAttrs = orionldState.uriParamOptions.sysAttrs;
+  tqP->attrList = &orionldState.in.attrList;
+
+  return true;
+}
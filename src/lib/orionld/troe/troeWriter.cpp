@@ -0,0 +1,676 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdlib.h>                                              // malloc, free
+#include <string.h>                                              // strlen, strcmp, memcpy
+#include <time.h>                                                // clock_gettime
+#include <pthread.h>                                             // pthread_*
+
+#include "logMsg/logMsg.h"                                       // LM_*
+#include "logMsg/traceLevels.h"                                  // LmtSql
+
+#include "orionld/types/PgConnection.h"                          // PgConnection
+#include "orionld/types/PgAppendBuffer.h"                        // PgAppendBuffer
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/common/orionldState.h"                         // troeFlush*, troeQueueMem, promTroe*
+#include "orionld/prometheus/promCounterAdd.h"                   // promCounterAdd
+#include "orionld/prometheus/promCounterIncrease.h"              // promCounterIncrease
+#include "orionld/prometheus/promGaugeAdd.h"                     // promGaugeAdd
+#include "orionld/prometheus/promHistogramObserve.h"             // promHistogramObserve
+#include "orionld/troe/pgConnectionGet.h"                        // pgConnectionGet
+#include "orionld/troe/pgConnectionRelease.h"                    // pgConnectionRelease
+#include "orionld/troe/pgTransactionBegin.h"                     // pgTransactionBegin
+#include "orionld/troe/pgTransactionCommit.h"                    // pgTransactionCommit
+#include "orionld/troe/pgTransactionRollback.h"                  // pgTransactionRollback
+#include "orionld/troe/pgCopy.h"                                 // pgCopyCommand, pgCopy
+#include "orionld/troe/troeWriter.h"                             // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TroeJob - the SQL commands of one request, awaiting a group commit
+//
+// The job, the database name and the commands are a single allocation.
+// The commands are separated by ';', so that a job (and a group of jobs) is sent to postgres as a single
+// multi-command string - postgres executes such a string as one transaction.
+//
+// A COPY job (-troeCopy) has no SQL text but sections of binary tuples, one per buffer of the request:
+//   [COPY command][\0][length of the tuples (int)][the tuples]
+// A group of COPY jobs is committed with one COPY per table, inside BEGIN/COMMIT.
+//
+typedef struct TroeJob
+{
+  char*            db;             // "" for the default tenant
+  char*            sql;            // The commands, separated by ';' - or the COPY sections
+  bool             copy;
+  int              commands;       // For COPY jobs: sections
+  size_t           size;           // Bytes of the allocation
+  double           enqueued;       // For the write lag
+  struct TroeJob*  next;
+} TroeJob;
+
+
+
+static pthread_mutex_t  writerMutex     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   writerCond      = PTHREAD_COND_INITIALIZER;   // Jobs to commit, or stop
+static pthread_cond_t   spaceCond       = PTHREAD_COND_INITIALIZER;   // Room in the queue
+static TroeJob*         queueHead       = NULL;
+static TroeJob*         queueTail       = NULL;
+static size_t           memUsed         = 0;       // Bytes of the jobs in the queue
+static int              commandsQueued  = 0;
+static bool             writerRunning   = false;
+static bool             writerStop      = false;
+static pthread_t        writerThread;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timeNow -
+//
+static double timeNow(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  return now.tv_sec + ((double) now.tv_nsec) / 1000000000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// copySection - the command and the tuples of a section of a COPY job - returns the next section
+//
+static char* copySection(char* sectionP, char** commandP, char** tuplesP, int* lenP)
+{
+  *commandP = sectionP;
+  sectionP += strlen(sectionP) + 1;
+
+  memcpy(lenP, sectionP, sizeof(int));
+  sectionP += sizeof(int);
+
+  *tuplesP  = sectionP;
+
+  return &sectionP[*lenP];
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// copyCommit - commit a list of COPY jobs in a single transaction, with one COPY per table
+//
+// The tuples of all the jobs for a table are streamed in one and the same COPY, in the order of the jobs.
+// The tables are copied in order of appearance, so entities go before their attributes and sub-attributes.
+//
+static bool copyCommit(PGconn* connectionP, TroeJob* jobList, int sections)
+{
+  char**  commandV = (char**) malloc(sections * sizeof(char*));
+  char**  chunkV   = (char**) malloc(sections * sizeof(char*));
+  int*    lenV     = (int*)   malloc(sections * sizeof(int));
+  int     tables   = 0;
+  bool    ok       = false;
+
+  if ((commandV == NULL) || (chunkV == NULL) || (lenV == NULL))
+  {
+    LM_E(("Out of memory (allocating the chunk vector for %d COPY sections)", sections));
+    free(commandV);
+    free(chunkV);
+    free(lenV);
+    return false;
+  }
+
+  //
+  // The different COPY commands (tables)
+  //
+  for (TroeJob* jobP = jobList; jobP != NULL; jobP = jobP->next)
+  {
+    char* sectionP = jobP->sql;
+
+    for (int ix = 0; ix < jobP->commands; ix++)
+    {
+      char* command;
+      char* tuples;
+      int   len;
+      int   tIx;
+
+      sectionP = copySection(sectionP, &command, &tuples, &len);
+
+      for (tIx = 0; tIx < tables; tIx++)
+      {
+        if (strcmp(commandV[tIx], command) == 0)
+          break;
+      }
+
+      if (tIx == tables)
+        commandV[tables++] = command;
+    }
+  }
+
+  if (pgTransactionBegin(connectionP) == true)
+  {
+    ok = true;
+
+    for (int tIx = 0; (tIx < tables) && (ok == true); tIx++)
+    {
+      int chunks = 0;
+
+      for (TroeJob* jobP = jobList; jobP != NULL; jobP = jobP->next)
+      {
+        char* sectionP = jobP->sql;
+
+        for (int ix = 0; ix < jobP->commands; ix++)
+        {
+          char* command;
+
+          sectionP = copySection(sectionP, &command, &chunkV[chunks], &lenV[chunks]);
+          if (strcmp(command, commandV[tIx]) == 0)
+            ++chunks;
+        }
+      }
+
+      ok = pgCopy(connectionP, commandV[tIx], chunkV, lenV, chunks);
+    }
+
+    if (ok == true)
+      ok = pgTransactionCommit(connectionP);
+    else if (pgTransactionRollback(connectionP) == false)
+      LM_E(("Database Error (pgTransactionRollback failed)"));
+  }
+
+  free(commandV);
+  free(chunkV);
+  free(lenV);
+
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// groupCommit - commit the jobs of one and the same database in a single transaction
+//
+// If the transaction fails, none of the commands are committed, and the jobs are committed one by one instead,
+// so that a faulty request doesn't cost the TRoE records of all the other requests of the group.
+//
+static void groupCommit(const char* db, TroeJob* jobList, int jobs, int commands)
+{
+  PgConnection* connectionP = pgConnectionGet(db);
+
+  if ((connectionP == NULL) || (connectionP->connectionP == NULL))
+  {
+    LM_E(("Database Error (no connection to postgres - %d TRoE commands lost)", commands));
+    promCounterAdd(promTroeCommandsFailed, commands);
+    return;
+  }
+
+  bool ok = false;
+
+  if (jobList->copy == true)
+  {
+    LM_T(LmtSql, ("SQL: group commit of %d COPY sections of %d requests", commands, jobs));
+
+    ok = copyCommit(connectionP->connectionP, jobList, commands);
+    if (ok == false)
+      LM_W(("Database Error (group commit of %d TRoE COPY sections failed) - committing request by request", commands));
+  }
+  else
+  {
+    size_t size = 0;
+    for (TroeJob* jobP = jobList; jobP != NULL; jobP = jobP->next)
+    {
+      size += strlen(jobP->sql) + 1;
+    }
+
+    char* sql = (char*) malloc(size);
+
+    if (sql != NULL)
+    {
+      char* sqlP = sql;
+
+      for (TroeJob* jobP = jobList; jobP != NULL; jobP = jobP->next)
+      {
+        size_t len = strlen(jobP->sql);
+
+        if (sqlP != sql)
+          *sqlP++ = ';';
+
+        memcpy(sqlP, jobP->sql, len);
+        sqlP += len;
+      }
+      *sqlP = 0;
+
+      LM_T(LmtSql, ("SQL: group commit of %d commands of %d requests (%d bytes)", commands, jobs, (int) size));
+
+      PGresult* res = PQexec(connectionP->connectionP, sql);
+
+      ok = ((res != NULL) && (PQresultStatus(res) == PGRES_COMMAND_OK));
+      if (ok == false)
+        LM_W(("Database Error (group commit of %d TRoE commands failed: %s) - committing request by request", commands, PQerrorMessage(connectionP->connectionP)));
+
+      PQclear(res);
+      free(sql);
+    }
+  }
+
+  if (ok == false)
+  {
+    for (TroeJob* jobP = jobList; jobP != NULL; jobP = jobP->next)
+    {
+      if (jobP->copy == true)
+      {
+        TroeJob* next = jobP->next;
+
+        jobP->next = NULL;  // A list of one single job
+        ok         = copyCommit(connectionP->connectionP, jobP, jobP->commands);
+        jobP->next = next;
+
+        if (ok == false)
+        {
+          LM_E(("Database Error (%d TRoE COPY sections lost)", jobP->commands));
+          promCounterAdd(promTroeCommandsFailed, jobP->commands);
+        }
+
+        continue;
+      }
+
+      LM_T(LmtSql, ("SQL: %s;", jobP->sql));
+
+      PGresult* res = PQexec(connectionP->connectionP, jobP->sql);
+
+      if ((res == NULL) || (PQresultStatus(res) != PGRES_COMMAND_OK))
+      {
+        LM_E(("Database Error (%d TRoE commands lost: %s)", jobP->commands, PQerrorMessage(connectionP->connectionP)));
+        promCounterAdd(promTroeCommandsFailed, jobP->commands);
+      }
+
+      PQclear(res);
+    }
+  }
+
+  pgConnectionRelease(connectionP);
+
+  double now = timeNow();
+  for (TroeJob* jobP = jobList; jobP != NULL; jobP = jobP->next)
+  {
+    promHistogramObserve(promTroeWriteLag, now - jobP->enqueued);
+  }
+
+  promHistogramObserve(promTroeBatchSize, commands);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// batchCommit - commit a batch of jobs, one transaction per database (tenant) - and kind of job (SQL or COPY)
+//
+// The order of the jobs of each database is kept.
+//
+static void batchCommit(TroeJob* batch)
+{
+  while (batch != NULL)
+  {
+    const char*  db        = batch->db;
+    bool         copy      = batch->copy;
+    TroeJob*     group     = NULL;
+    TroeJob*     groupLast = NULL;
+    TroeJob*     rest      = NULL;
+    TroeJob*     restLast  = NULL;
+    int          jobs      = 0;
+    int          commands  = 0;
+
+    for (TroeJob* jobP = batch; jobP != NULL; )
+    {
+      TroeJob* next = jobP->next;
+
+      jobP->next = NULL;
+
+      if ((strcmp(jobP->db, db) == 0) && (jobP->copy == copy))
+      {
+        if (groupLast == NULL)
+          group = jobP;
+        else
+          groupLast->next = jobP;
+
+        groupLast  = jobP;
+        jobs      += 1;
+        commands  += jobP->commands;
+      }
+      else
+      {
+        if (restLast == NULL)
+          rest = jobP;
+        else
+          restLast->next = jobP;
+
+        restLast = jobP;
+      }
+
+      jobP = next;
+    }
+
+    groupCommit(db, group, jobs, commands);
+
+    while (group != NULL)
+    {
+      TroeJob* next = group->next;
+
+      free(group);
+      group = next;
+    }
+
+    batch = rest;
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriter - the TRoE writer thread
+//
+// A batch is committed when the oldest job of the queue has waited -troeFlushInterval milliseconds,
+// or when -troeFlushRows commands are queued, whichever comes first. At stop, all that's left is committed.
+//
+static void* troeWriter(void* vP)
+{
+  pthread_mutex_lock(&writerMutex);
+
+  while (true)
+  {
+    if (queueHead == NULL)
+    {
+      if (writerStop == true)
+        break;
+
+      pthread_cond_wait(&writerCond, &writerMutex);
+      continue;
+    }
+
+    double flushAt = queueHead->enqueued + ((double) troeFlushInterval) / 1000;
+
+    if ((writerStop == false) && (commandsQueued < troeFlushRows) && (timeNow() < flushAt))
+    {
+      struct timespec until;
+
+      until.tv_sec  = (time_t) flushAt;
+      until.tv_nsec = (long) ((flushAt - until.tv_sec) * 1000000000);
+
+      pthread_cond_timedwait(&writerCond, &writerMutex, &until);
+      continue;
+    }
+
+    //
+    // Take out a batch of at most -troeFlushRows commands (but always at least one job)
+    //
+    TroeJob*  batch    = queueHead;
+    TroeJob*  last     = queueHead;
+    int       commands = last->commands;
+    size_t    size     = last->size;
+
+    while ((last->next != NULL) && (commands + last->next->commands <= troeFlushRows))
+    {
+      last      = last->next;
+      commands += last->commands;
+      size     += last->size;
+    }
+
+    queueHead = last->next;
+    if (queueHead == NULL)
+      queueTail = NULL;
+    last->next = NULL;
+
+    commandsQueued -= commands;
+    memUsed        -= size;
+    promGaugeAdd(promTroeQueueDepth, -commands, NULL);
+
+    pthread_cond_broadcast(&spaceCond);
+    pthread_mutex_unlock(&writerMutex);
+
+    batchCommit(batch);
+
+    pthread_mutex_lock(&writerMutex);
+  }
+
+  pthread_mutex_unlock(&writerMutex);
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterStart -
+//
+bool troeWriterStart(void)
+{
+  if ((troe == false) || (troeFlushInterval == 0))
+    return true;
+
+  int s = pthread_create(&writerThread, NULL, troeWriter, NULL);
+  if (s != 0)
+  {
+    LM_E(("Runtime Error (error creating the TRoE writer thread: %d)", s));
+    return false;
+  }
+
+  writerRunning = true;
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// jobQueue - put a job in the queue of the writer - false if the writer is stopping (the job is then freed)
+//
+static bool jobQueue(TroeJob* jobP)
+{
+  pthread_mutex_lock(&writerMutex);
+
+  //
+  // Backpressure - the request waits until the writer has made room for its commands
+  // A job that is bigger than the entire queue is accepted when the queue is empty
+  //
+  if ((queueHead != NULL) && (memUsed + jobP->size > (size_t) troeQueueMem * 1024 * 1024))
+  {
+    promCounterIncrease(promTroeBackpressure);
+
+    while ((queueHead != NULL) && (memUsed + jobP->size > (size_t) troeQueueMem * 1024 * 1024) && (writerStop == false))
+    {
+      pthread_cond_wait(&spaceCond, &writerMutex);
+    }
+  }
+
+  if (writerStop == true)  // Stopping - the writer may already be gone
+  {
+    pthread_mutex_unlock(&writerMutex);
+    free(jobP);
+    return false;
+  }
+
+  bool wakeup = (queueHead == NULL);
+
+  jobP->enqueued = timeNow();
+
+  if (queueTail == NULL)
+    queueHead = jobP;
+  else
+    queueTail->next = jobP;
+  queueTail = jobP;
+
+  memUsed        += jobP->size;
+  commandsQueued += jobP->commands;
+  promGaugeAdd(promTroeQueueDepth, jobP->commands, NULL);
+
+  //
+  // The writer needs to know when the queue gets its first job (to start the clock), and when there's enough for a batch
+  //
+  if ((wakeup == true) || (commandsQueued >= troeFlushRows))
+    pthread_cond_signal(&writerCond);
+
+  pthread_mutex_unlock(&writerMutex);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// jobAlloc - allocate a job with room for the database name and 'dataSize' bytes of commands
+//
+static TroeJob* jobAlloc(const char* db, size_t dataSize, int commands, bool copy)
+{
+  size_t   dbLen = strlen(db) + 1;
+  size_t   size  = sizeof(TroeJob) + dbLen + dataSize;
+  TroeJob* jobP  = (TroeJob*) malloc(size);
+
+  if (jobP == NULL)
+    LM_RE(NULL, ("Out of memory (allocating %d bytes for a TRoE job) - no group commit", (int) size));
+
+  jobP->db       = (char*) &jobP[1];
+  jobP->sql      = &jobP->db[dbLen];
+  jobP->copy     = copy;
+  jobP->commands = commands;
+  jobP->size     = size;
+  jobP->next     = NULL;
+
+  memcpy(jobP->db, db, dbLen);
+
+  return jobP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterEnqueue -
+//
+bool troeWriterEnqueue(const char* db, char* sql[], int commands)
+{
+  if (writerRunning == false)
+    return false;
+
+  size_t dataSize = 0;
+
+  for (int ix = 0; ix < commands; ix++)
+  {
+    dataSize += strlen(sql[ix]) + 1;
+  }
+
+  TroeJob* jobP = jobAlloc(db, dataSize, commands, false);
+  if (jobP == NULL)
+    return false;
+
+  char* sqlP = jobP->sql;
+  for (int ix = 0; ix < commands; ix++)
+  {
+    size_t len = strlen(sql[ix]);
+
+    if (ix != 0)
+      *sqlP++ = ';';
+
+    memcpy(sqlP, sql[ix], len);
+    sqlP += len;
+  }
+  *sqlP = 0;
+
+  return jobQueue(jobP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterCopyEnqueue -
+//
+bool troeWriterCopyEnqueue(const char* db, PgAppendBuffer* bufferV[], int buffers)
+{
+  if (writerRunning == false)
+    return false;
+
+  char   commandV[3][1024];
+  size_t dataSize = 0;
+
+  if (buffers > 3)
+    LM_RE(false, ("Internal Error (%d TRoE buffers - max is 3)", buffers));
+
+  for (int ix = 0; ix < buffers; ix++)
+  {
+    if (pgCopyCommand(bufferV[ix], commandV[ix], sizeof(commandV[ix])) == false)
+      return false;
+
+    dataSize += strlen(commandV[ix]) + 1 + sizeof(int) + (bufferV[ix]->currentIx - bufferV[ix]->copyStart);
+  }
+
+  TroeJob* jobP = jobAlloc(db, dataSize, buffers, true);
+  if (jobP == NULL)
+    return false;
+
+  char* sectionP = jobP->sql;
+  for (int ix = 0; ix < buffers; ix++)
+  {
+    size_t commandLen = strlen(commandV[ix]) + 1;
+    int    len        = bufferV[ix]->currentIx - bufferV[ix]->copyStart;
+
+    memcpy(sectionP, commandV[ix], commandLen);
+    sectionP += commandLen;
+
+    memcpy(sectionP, &len, sizeof(int));
+    sectionP += sizeof(int);
+
+    memcpy(sectionP, &bufferV[ix]->buf[bufferV[ix]->copyStart], len);
+    sectionP += len;
+  }
+
+  return jobQueue(jobP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterStop -
+//
+void troeWriterStop(void)
+{
+  if (writerRunning == false)
+    return;
+
+  pthread_mutex_lock(&writerMutex);
+  writerStop = true;
+  pthread_cond_signal(&writerCond);
+  pthread_cond_broadcast(&spaceCond);
+  pthread_mutex_unlock(&writerMutex);
+
+  pthread_join(writerThread, NULL);
+  writerRunning = false;
+}
@@ -0,0 +1,69 @@
+#ifndef SRC_LIB_ORIONLD_TROE_TROEWRITER_H_
+#define SRC_LIB_ORIONLD_TROE_TROEWRITER_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+
+
+
+#include "orionld/types/PgAppendBuffer.h"                        // PgAppendBuffer
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterStart - start the TRoE writer thread - if -troeFlushInterval > 0
+//
+extern bool troeWriterStart(void);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterEnqueue - hand over the SQL commands of a request to the TRoE writer, for a group commit
+//
+// The SQL commands are copied - the caller keeps them.
+// Returns false if the TRoE writer isn't running (-troeFlushInterval 0) - the caller executes the commands itself.
+// If the writer queue is full (-troeQueueMem), the caller waits until the writer has made room for the commands.
+//
+extern bool troeWriterEnqueue(const char* db, char* sql[], int commands);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterCopyEnqueue - troeWriterEnqueue for the binary buffers of -troeCopy - one COPY section per buffer
+//
+extern bool troeWriterCopyEnqueue(const char* db, PgAppendBuffer* bufferV[], int buffers);
+
+
+
+// -----------------------------------------------------------------------------
+//
+// troeWriterStop - commit all that's left in the writer queue and stop the TRoE writer thread
+//
+extern void troeWriterStop(void);
+
+#endif  // SRC_LIB_ORIONLD_TROE_TROEWRITER_H_
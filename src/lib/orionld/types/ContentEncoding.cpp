@@ -0,0 +1,65 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <strings.h>                                           // strcasecmp
+
+#include "logMsg/logMsg.h"                                     // LM_*
+
+#include "orionld/types/ContentEncoding.h"                     // Own interface
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contentEncodingToString -
+//
+const char* contentEncodingToString(ContentEncoding encoding)
+{
+  switch (encoding)
+  {
+  case CE_IDENTITY:  return "identity";
+  case CE_GZIP:      return "gzip";
+  case CE_DEFLATE:   return "deflate";
+  case CE_INVALID:   return "invalid";
+  }
+
+  LM_E(("Invalid Content Encoding: %d", encoding));
+  return "INVALID";
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contentEncodingFromString -
+//
+ContentEncoding contentEncodingFromString(const char* encoding)
+{
+  if      (strcasecmp(encoding, "gzip")     == 0)  return CE_GZIP;
+  else if (strcasecmp(encoding, "x-gzip")   == 0)  return CE_GZIP;
+  else if (strcasecmp(encoding, "deflate")  == 0)  return CE_DEFLATE;
+  else if (strcasecmp(encoding, "identity") == 0)  return CE_IDENTITY;
+
+  return CE_INVALID;
+}
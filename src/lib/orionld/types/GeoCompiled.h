@@ -0,0 +1,111 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_GEOCOMPILED_H_
+#define SRC_LIB_ORIONLD_TYPES_GEOCOMPILED_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/OrionldGeometry.h"                       // OrionldGeometry
+#include "orionld/types/OrionldGeorel.h"                         // OrionldGeorel
+
+
+
+// -----------------------------------------------------------------------------
+//
+// GcBox - bounding box, in degrees
+//
+typedef struct GcBox
+{
+  double  minLon;
+  double  minLat;
+  double  maxLon;
+  double  maxLat;
+} GcBox;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// GcPath - a sequence of positions: a single point, a LineString or a ring of a Polygon
+//
+typedef struct GcPath
+{
+  double*  coordV;   // lon,lat pairs - any altitude is dropped
+  int      points;
+  bool     ring;     // Ring of a polygon - implicitly closed
+} GcPath;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// GcPolygon - a Polygon, as a reference to its rings in GcShape::pathV
+//
+// The first ring is the exterior ring, the rest of them are holes.
+//
+typedef struct GcPolygon
+{
+  int    firstPath;
+  int    rings;
+  GcBox  box;
+} GcPolygon;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// GcShape - a GeoJSON geometry (Point, MultiPoint, LineString, MultiLineString, Polygon or MultiPolygon), flattened
+//
+// All geometries are kept as a list of paths:
+//   - Point/MultiPoint:            one path of one single position per point
+//   - LineString/MultiLineString:  one path per line
+//   - Polygon/MultiPolygon:        one path per ring, and the polygons in polygonV
+//
+typedef struct GcShape
+{
+  OrionldGeometry  geometry;
+  GcPath*          pathV;
+  int              paths;
+  GcPolygon*       polygonV;
+  int              polygons;
+  GcBox            box;
+} GcShape;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// GeoCompiled - the compiled form of the geoQ of a subscription, as used for subscription matching
+//
+typedef struct GeoCompiled
+{
+  OrionldGeorel  georel;
+  int            minDistance;   // meters, for 'near'
+  int            maxDistance;   // meters, for 'near'
+  char*          geoProperty;   // Expanded, with '=' turned back into '.' - as found in the entity
+  GcShape        shape;
+  GcBox          box;           // Any entity geometry not intersecting this box can be rejected without further ado
+  bool           boxReject;     // 'box' is useless for disjoint and for near;minDistance
+} GeoCompiled;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_GEOCOMPILED_H_
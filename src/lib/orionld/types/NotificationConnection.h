@@ -0,0 +1,56 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_NOTIFICATIONCONNECTION_H_
+#define SRC_LIB_ORIONLD_TYPES_NOTIFICATIONCONNECTION_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+
+
+
+// -----------------------------------------------------------------------------
+//
+// NotificationConnectionHost - forward declaration, the per host:port connection pool is private to httpConnectionPool.cpp
+//
+struct NotificationConnectionHost;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// NotificationConnection - a (possibly persistent) connection to an HTTP notification endpoint
+//
+typedef struct NotificationConnection
+{
+  int                                 fd;
+  struct NotificationConnectionHost*  hostP;         // NULL if the connection is not pooled (closed after use)
+  bool                                reused;        // The connection was taken from the pool of idle connections
+  bool                                keepAlive;     // Set by the response reader - the connection can be reused
+  bool                                gotResponse;   // At least one byte of a response has been received
+  double                              lastUsed;      // For idle eviction
+  char*                               pending;       // Bytes read beyond the end of the last response (pipelining) - malloc'd
+  int                                 pendingLen;
+  struct NotificationConnection*      next;          // Next idle connection to the same host
+} NotificationConnection;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_NOTIFICATIONCONNECTION_H_
@@ -0,0 +1,62 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_NOTIFICATIONJOB_H_
+#define SRC_LIB_ORIONLD_TYPES_NOTIFICATIONJOB_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stddef.h>                                              // size_t
+#include <sys/uio.h>                                             // iovec
+
+#include "orionld/types/Protocol.h"                              // Protocol
+
+
+
+// -----------------------------------------------------------------------------
+//
+// NotificationJob - a notification, ready to be sent, handed over to the notification workers
+//
+// The request thread renders the notification (it needs the request's orionldState for that) and
+// copies the result into a NotificationJob. Everything a NotificationJob references lives in the same
+// malloc'd chunk of memory as the job itself, so one single call to free() releases it all.
+//
+// The CachedSubscription is NOT referenced - the sub-cache may be refreshed before the worker gets to
+// the job. Instead, tenant and subscriptionId are kept, and the subscription is looked up again when
+// the counters are to be updated.
+//
+typedef struct NotificationJob
+{
+  char*           tenant;            // NULL for the default tenant
+  char*           subscriptionId;
+  char*           protocolString;
+  Protocol        protocol;
+  char*           ip;
+  unsigned short  port;
+  char*           rest;
+  double          notificationTime;
+  struct iovec*   ioVec;             // Start-Line, HTTP headers, empty line and payload body
+  int             ioVecLen;
+  size_t          size;              // Of the malloc'd chunk - for the memory accounting of the retry queue
+} NotificationJob;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_NOTIFICATIONJOB_H_
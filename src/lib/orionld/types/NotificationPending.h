@@ -0,0 +1,63 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_NOTIFICATIONPENDING_H_
+#define SRC_LIB_ORIONLD_TYPES_NOTIFICATIONPENDING_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <curl/curl.h>                                           // CURL
+#include <MQTTClient.h>                                          // MQTTClient_deliveryToken
+
+#include "orionld/types/NotificationConnection.h"                // NotificationConnection
+#include "orionld/types/MqttConnection.h"                        // MqttConnection
+#include "orionld/types/NotificationJob.h"                       // NotificationJob
+
+
+
+// -----------------------------------------------------------------------------
+//
+// NotificationPending - a notification that has been sent and whose response (or completion) is awaited
+//
+// Filled in by notificationSend and taken care of by notificationResponsesAwait.
+// The responses are awaited outside the sub-cache read section, so, instead of a pointer to the cached subscription,
+// tenant and subscriptionId are kept, and the subscription is looked up again when the notification is accounted.
+//
+typedef struct NotificationPending
+{
+  char*                        tenant;            // NULL for the default tenant
+  char*                        subscriptionId;
+  int                          fd;                // HTTP only - -1 once the response has been taken care of
+  NotificationConnection*      connP;             // HTTP only
+  CURL*                        curlHandleP;       // HTTPS only
+  MqttConnection*              mqttConnectionP;   // MQTT only (QoS > 0)
+  MQTTClient_deliveryToken     mqttToken;         // MQTT only (QoS > 0)
+  double                       deadline;          // Time (kTimeGet) after which the notification is considered failed
+  bool                         used;              // The response has been taken care of (success or failure)
+  bool                         ok;                // The notification was delivered
+  NotificationJob*             retryJobP;         // Copy of the notification, for a retry if it fails (-notifRetries)
+  struct NotificationPending*  next;
+  struct NotificationPending*  awaitPrev;         // HTTP responses still awaited, in deadline order
+  struct NotificationPending*  awaitNext;
+} NotificationPending;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_NOTIFICATIONPENDING_H_
@@ -0,0 +1,51 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_NOTIFICATIONRENDER_H_
+#define SRC_LIB_ORIONLD_TYPES_NOTIFICATIONRENDER_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdint.h>                                              // uint64_t
+
+#include "orionld/types/OrionldAlteration.h"                     // OrionldAlterationMatch
+
+
+
+// -----------------------------------------------------------------------------
+//
+// NotificationRender - a rendered notification body, shared by all subscriptions with the same notification shape
+//
+// The shape is what decides the body, except for the per-subscription fields (id, type, subscriptionId):
+// the alterations, format, attribute projection, lang, @context, sysAttrs, showChanges and mime type.
+// The render cache lives as long as the request (orionldState.notificationRenderList, kalloc).
+//
+typedef struct NotificationRender
+{
+  uint64_t                    shapeHash;
+  OrionldAlterationMatch*     matchList;   // The matches the body was rendered from - its subscription has the shape
+  char*                       body;        // The body after the per-subscription fields: "notifiedAt": ... }
+  int                         bodyLen;
+  struct NotificationRender*  next;
+} NotificationRender;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_NOTIFICATIONRENDER_H_
@@ -27,6 +27,8 @@
 */
 #include <stdint.h>                     // types: uint32_t, ...
 
+#include "orionld/types/OrionldServiceTrieNode.h"   // OrionldServiceTrieNode
+
 
 
 // -----------------------------------------------------------------------------
@@ -157,6 +159,9 @@ typedef struct OrionLdRestServiceSimplifiedVector
 #define ORIONLD_URIPARAM_FORMAT               (UINT64_C(1) << 40)
 #define ORIONLD_URIPARAM_EXPAND_VALUES        (UINT64_C(1) << 41)
 #define ORIONLD_URIPARAM_KIND                 (UINT64_C(1) << 42)
+#define ORIONLD_URIPARAM_LASTN                (UINT64_C(1) << 43)
+#define ORIONLD_URIPARAM_AGGRMETHODS          (UINT64_C(1) << 44)
+#define ORIONLD_URIPARAM_AGGRPERIODDURATION   (UINT64_C(1) << 45)
 
 
 
@@ -196,8 +201,9 @@ typedef struct OrionLdRestService
 //
 typedef struct OrionLdRestServiceVector
 {
-  OrionLdRestService*  serviceV;
-  int                  services;
+  OrionLdRestService*      serviceV;
+  int                      services;
+  OrionldServiceTrieNode*  trie;      // Router - built by orionldServiceTrieBuild, used by orionldServiceLookup
 } OrionLdRestServiceVector;
 
 #endif  // SRC_LIB_ORIONLD_TYPES_ORIONLDRESTSERVICE_H_
@@ -50,6 +50,8 @@ typedef struct OrionldContextArray
 {
   int                     items;
   struct OrionldContext** vector;
+  KHashTable*             nameHashTable;   // All the terms of the array, merged - NULL if not built (see orionldContextArrayMerge)
+  KHashTable*             valueHashTable;  // Reverse of nameHashTable
 } OrionldContextArray;
 
 
@@ -130,6 +132,10 @@ extern const char* orionldKindToString(OrionldContextKind kind);
 
 
 
+struct OrionldContextExpandMemo;  // Opaque - see orionldContextExpandMemo.cpp
+
+
+
 // ----------------------------------------------------------------------------
 //
 // OrionldContext -
@@ -146,9 +152,8 @@ typedef struct OrionldContext
   bool                  coreContext;
   double                createdAt;
   double                usedAt;
-  int                   compactions;     // Number of compactions done with this @context
-  int                   expansions;      // Number of expansions done with this @context
-  int                   lookups;         // Number of NGSI-LD requests done using this @context
+  int                   counterIx;       // Lookups, expansions and compactions - see orionldContextCounters.h
+  struct OrionldContextExpandMemo*  expandMemoP;  // @vocab and prefix expansions - see orionldContextExpandMemo.h
   bool                  keyValues;
   OrionldContextInfo    context;
   OrionldContextOrigin  origin;
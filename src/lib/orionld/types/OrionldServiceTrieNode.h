@@ -0,0 +1,73 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_ORIONLDSERVICETRIENODE_H_
+#define SRC_LIB_ORIONLD_TYPES_ORIONLDSERVICETRIENODE_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ORIONLD_SERVICE_TRIE_WILDCARDS - max number of wildcard services hanging off one node
+//
+// The busiest node is ".../entities" for OPTIONS, with three services ("/entities/*/attrs/*",
+// "/entities/*/attrs", and "/entities/*").
+//
+#define ORIONLD_SERVICE_TRIE_WILDCARDS  8
+
+
+
+// -----------------------------------------------------------------------------
+//
+// OrionldServiceTrieNode - one URL path segment in the service router
+//
+// The static part of the URL paths of a service vector (everything up to the first wildcard)
+// is split in path segments and stored in a trie, one node per segment.
+// The root node is "/ngsi-ld" - the prefix that all URL paths of orionld start with.
+//
+// A service whose URL path ends at a node is referenced by 'exactIx'.
+// Services with a wildcard right after the node (".../entities/*...") are referenced by
+// 'wildcardIxV', in table order.
+//
+// As the service vectors are ordered (the first service in the vector that matches is the one
+// that is chosen), 'minIx' keeps the lowest service index of the entire sub-tree, so that the
+// lookup can stop descending as soon as no better match can be found further down.
+//
+// The nodes are allocated on startup and never freed, the segments point into the URL paths of
+// the OrionLdRestServiceSimplified vectors, that stay intact during the entire lifetime of the broker.
+//
+typedef struct OrionldServiceTrieNode
+{
+  const char*                     segment;                                     // Not NUL-terminated
+  int                             segmentLen;                                  // strlen of the segment
+  int                             exactIx;                                     // Service whose URL path ends here, -1 if none
+  int                             wildcardIxV[ORIONLD_SERVICE_TRIE_WILDCARDS];  // Services with a wildcard after this node
+  int                             wildcards;                                   // Number of items in wildcardIxV
+  int                             minIx;                                       // Lowest service index in the sub-tree
+  struct OrionldServiceTrieNode*  children;                                    // First child
+  struct OrionldServiceTrieNode*  next;                                        // Next sibling
+} OrionldServiceTrieNode;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_ORIONLDSERVICETRIENODE_H_
@@ -39,6 +39,9 @@ typedef struct PgAppendBuffer
   bool   allocated;  // if true: PgAppendBuffer::buf needs to be freed when reallocating
   int    currentIx;  // Current index in the buffer
   int    values;
+  bool   binary;     // The values are tuples for COPY (FORMAT binary), not SQL text (-troeCopy)
+  int    copyStart;  // Binary: index of the first tuple - before it there's only the INSERT header
+  bool   pipeline;   // Binary: the tuples are the parameters of the prepared INSERTs, sent in pipeline mode (batch requests)
 } PgAppendBuffer;
 
 #endif  // SRC_LIB_ORIONLD_TYPES_PGAPPENDBUFFER_H_
@@ -25,19 +25,31 @@
 *
 * Author: Ken Zangelin
 */
+#include <stdint.h>                                            // uint32_t
+#include <time.h>                                              // time_t
+
 #include "orionld/common/pqHeader.h"                           // PGconn
 
 
 
+struct PgConnectionPool;
+
+
+
 // -----------------------------------------------------------------------------
 //
 // PgConnection -
 //
 typedef struct PgConnection
 {
-  bool    busy;          // In use or free
-  PGconn* connectionP;   // the postgres connection
-  int     uses;          // Number of times the connection has been used
+  bool                      busy;          // In use or free
+  PGconn*                   connectionP;   // the postgres connection - NULL until connected (and after being closed for being idle)
+  int                       uses;          // Number of times the connection has been used
+  int                       index;         // Index in the connection vector of the pool
+  uint32_t                  nextFree;      // Free list: index+1 of the next free connection (0: end of the list)
+  time_t                    lastUsed;      // When the connection was last released - for the closing of idle connections
+  int                       prepared;      // PG_STMT_* bits - the prepared statements that are created in this connection
+  struct PgConnectionPool*  poolP;         // The pool the connection belongs to
 } PgConnection;
 
 #endif  // SRC_LIB_ORIONLD_TYPES_PGCONNECTION_H_
@@ -25,7 +25,8 @@
 *
 * Author: Ken Zangelin
 */
-#include <semaphore.h>                                         // sem_t
+#include <stdint.h>                                            // uint64_t
+#include <pthread.h>                                           // pthread_mutex_t, pthread_cond_t
 
 #include "orionld/types/PgConnection.h"                        // PgConnection
 
@@ -35,13 +36,23 @@
 //
 // PgConnectionPool -
 //
+// The free connections of the pool are kept in a lock-free list (a stack), linked by PgConnection::nextFree.
+// To avoid the ABA problem, the head of the list is tagged with a counter that is incremented on every change:
+//   high 32 bits:  tag
+//   low 32 bits:   index+1 of the first free connection (0: no free connection)
+//
+// Only when the pool is saturated (no free connection) are the mutex and the condition variable used,
+// for the requester to await a connection.
+//
 typedef struct PgConnectionPool
 {
   char*                     db;           // Name of the database
-  sem_t                     queueSem;     // Counting semaphore - size same as number of connections in the pool
-  sem_t                     poolSem;      // Binary semaphore - grants rights to modify the pool
+  uint64_t                  freeHead;     // Head of the free list: tag | index+1
+  int                       waiters;      // Number of threads awaiting a free connection
+  pthread_mutex_t           waitMutex;    // Only for the waiters
+  pthread_cond_t            waitCond;     // Signaled when a connection is returned and there are waiters
   int                       items;        // Number of connections in the pool
-  PgConnection**            connectionV;  // Allocated array of PgConnection pointers
+  PgConnection**            connectionV;  // Allocated array of PgConnection pointers (all allocated at pool creation, connected lazily)
   struct PgConnectionPool*  next;         // Connection Pools are stored in a linked list
 } PgConnectionPool;
 
@@ -0,0 +1,97 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_QCOMPILED_H_
+#define SRC_LIB_ORIONLD_TYPES_QCOMPILED_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <regex.h>                                               // regex_t
+
+#include "orionld/types/QNode.h"                                 // QNodeType
+
+
+
+// -----------------------------------------------------------------------------
+//
+// QC_PATHS - max number of alternative paths for the left-hand side of a comparison
+//
+// The variable of a q-filter may be found in the entity as is, with '=' turned back into '.',
+// and, for "P.value", as "P.object" (a Relationship) - see qCompile for the details.
+//
+#define QC_PATHS  4
+
+
+
+// -----------------------------------------------------------------------------
+//
+// QcValue - a constant of the right-hand side of a comparison
+//
+// Strings that are ISO8601 timestamps are parsed already when the q-filter is compiled ('timestamp' -1 if not a timestamp)
+//
+typedef struct QcValue
+{
+  QNodeType  type;        // QNodeIntegerValue, QNodeFloatValue, QNodeStringValue, QNodeTrueValue, QNodeFalseValue
+  long long  i;
+  double     f;
+  char*      s;
+  double     timestamp;
+} QcValue;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// QcInstruction - one node of a compiled q-filter
+//
+// The instructions are stored in prefix order - the children of an AND/OR are the instructions
+// [ix + 1, end), and the next sibling of any instruction starts at its 'end'.
+// So, skipping a subtree (short-circuit) is a simple jump.
+//
+typedef struct QcInstruction
+{
+  QNodeType  op;                   // QNodeAnd, QNodeOr, QNodeExists, QNodeNotExists, QNodeEQ, ..., QNodeNoMatch, QNodeVoid (always false)
+  int        end;                  // Index of the first instruction after this one (and its children)
+
+  char**     pathV[QC_PATHS];      // Left-hand side: NULL terminated, pre-split attribute paths, tried in order
+  int        paths;
+  bool       isTimestamp;          // The last component of the path is observedAt, modifiedAt, or createdAt
+
+  QNodeType  rhsType;              // QNodeRange, QNodeComma, QNodeRegexpValue, or the type of the single value
+  QcValue*   valueV;               // Range: low + high, Comma: all values of the list, else: one single value
+  int        values;
+  regex_t*   regexP;               // For QNodeMatch and QNodeNoMatch - compiled once
+} QcInstruction;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// QCompiled - the compiled form of a q-filter (QNode tree), as used for subscription matching
+//
+typedef struct QCompiled
+{
+  QcInstruction*  instructionV;
+  int             instructions;
+} QCompiled;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_QCOMPILED_H_
@@ -0,0 +1,73 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_REQUESTJOB_H_
+#define SRC_LIB_ORIONLD_TYPES_REQUESTJOB_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stddef.h>                                              // size_t
+#include <microhttpd.h>                                          // MHD_Connection
+
+
+
+// -----------------------------------------------------------------------------
+//
+// REQUEST_JOB_MAGIC - first field of every RequestJob
+//
+// The per-request pointer of MHD (con_cls) is a RequestJob for NGSI-LD requests that are handed over to the
+// request executors, and a ConnectionInfo for NGSIv2 requests. requestCompleted tells them apart by the magic
+// number (odd, so, never the first field of a ConnectionInfo - a small integer).
+//
+#define REQUEST_JOB_MAGIC  0x52514A4F
+
+
+
+// -----------------------------------------------------------------------------
+//
+// RequestJob - an incoming request, read by an I/O thread, to be executed by a request executor (-reqExecutors)
+//
+// The I/O thread (MHD) reads the request (URL, HTTP headers and payload body), suspends the connection and hands
+// the job over to the executors.
+// The executor treats the request just like the thread of the connection would have done it (with its own
+// orionldState), queues the response and resumes the connection, for MHD to send the response while the executor
+// does what's left after the response (notifications, etc).
+//
+// url, method and version point into the memory of the connection in MHD - valid until the request is completed.
+// The payload body is accumulated in an allocated buffer, as the I/O thread serves many connections at a time.
+//
+typedef struct RequestJob
+{
+  unsigned int        magic;               // REQUEST_JOB_MAGIC
+  MHD_Connection*     connection;
+  const char*         url;
+  const char*         method;
+  const char*         version;
+  char*               payload;
+  size_t              payloadSize;
+  size_t              payloadAllocated;
+  bool                executed;            // The executor is done with the request and has resumed the connection
+  double              enqueued;            // When the job was handed over to the executors - for the executor metrics
+  struct RequestJob*  next;                // Next job in the queue of the executor
+} RequestJob;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_REQUESTJOB_H_
@@ -0,0 +1,103 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_TROEQUERY_H_
+#define SRC_LIB_ORIONLD_TYPES_TROEQUERY_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/StringArray.h"                           // StringArray
+#include "orionld/types/QNode.h"                                 // QNode
+#include "orionld/types/OrionldGeoInfo.h"                        // OrionldGeoInfo
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TroeTimerel - the temporal relation of a temporal query (URI param 'timerel')
+//
+typedef enum TroeTimerel
+{
+  TroeTimerelNone,
+  TroeTimerelBefore,
+  TroeTimerelAfter,
+  TroeTimerelBetween
+} TroeTimerel;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TroeFormat - the temporal representation of the response
+//
+typedef enum TroeFormat
+{
+  TroeFormatNormalized,         // Arrays of attribute instances
+  TroeFormatTemporalValues,     // options=temporalValues  - "values": [ [ value, time ], ... ]
+  TroeFormatAggregatedValues    // options=aggregatedValues - "avg": [ [ value, startAt, endAt ], ... ], ...
+} TroeFormat;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Aggregation methods (URI param 'aggrMethods')
+//
+#define TROE_AGGR_TOTAL_COUNT      (1 << 0)
+#define TROE_AGGR_DISTINCT_COUNT   (1 << 1)
+#define TROE_AGGR_SUM              (1 << 2)
+#define TROE_AGGR_AVG              (1 << 3)
+#define TROE_AGGR_MIN              (1 << 4)
+#define TROE_AGGR_MAX              (1 << 5)
+#define TROE_AGGR_STDDEV           (1 << 6)
+#define TROE_AGGR_SUMSQ            (1 << 7)
+
+#define TROE_AGGR_METHODS          8
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TroeQuery - a temporal query over the TRoE tables
+//
+typedef struct TroeQuery
+{
+  StringArray*     idList;              // Entity ids - no items: any entity id
+  StringArray*     typeList;            // Expanded entity types - no items: any entity type
+  char*            idPattern;
+  StringArray*     attrList;            // Expanded attribute names - no items: all attributes
+  QNode*           qNode;               // NULL: no q-filter
+  OrionldGeoInfo*  geoInfoP;            // geometry == GeoNoGeometry: no geo-filter
+  const char*      timeColumn;          // The column of 'timeproperty' - "observedAt" or "ts" (createdAt/modifiedAt)
+  TroeTimerel      timerel;
+  double           timeAt;
+  double           endTimeAt;
+  int              lastN;               // 0: all instances
+  TroeFormat       format;
+  int              aggrMethods;         // TROE_AGGR_* bits
+  char*            aggrPeriodDuration;  // ISO 8601 duration - NULL: the whole time range is one period
+  int              offset;
+  int              limit;
+  bool             sysAttrs;
+} TroeQuery;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_TROEQUERY_H_
@@ -0,0 +1,54 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_TROERESULT_H_
+#define SRC_LIB_ORIONLD_TYPES_TROERESULT_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+extern "C"
+{
+#include "kjson/KjNode.h"                                        // KjNode
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TroeResult - the temporal representation of the entities, built row by row from the result of a temporal query
+//
+// The rows come ordered by entity id, attribute name and datasetId, so, only the current entity/attribute/datasetId
+// need to be remembered.
+//
+typedef struct TroeResult
+{
+  KjNode*  entityArray;   // The response - an array of entities
+  KjNode*  entityP;       // The current entity
+  char*    entityId;      // The id of the current entity
+  KjNode*  attrP;         // The member of the current entity for the current attribute - NULL if none yet
+  char*    attrName;      // The name of the current attribute, as in the TRoE tables (eq-for-dot)
+  KjNode*  datasetP;      // temporalValues/aggregatedValues: the object of the current datasetId
+  char*    datasetId;     // The current datasetId ("None" for the default instance)
+  int      entities;
+} TroeResult;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_TROERESULT_H_
@@ -0,0 +1,75 @@
+#ifndef SRC_LIB_ORIONLD_TYPES_TROESQL_H_
+#define SRC_LIB_ORIONLD_TYPES_TROESQL_H_
+
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include "orionld/types/PgAppendBuffer.h"                        // PgAppendBuffer
+#include "orionld/types/PgParams.h"                              // PgParams
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PG_ISO8601 - SQL for the ISO 8601 string of a TIMESTAMP column (the TRoE timestamps are all UTC)
+//
+#define PG_ISO8601(column)  "to_char(" column ", 'YYYY-MM-DD\"T\"HH24:MI:SS.MS\"Z\"')"
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PG_TIMESTAMP_PARAM - SQL for a TIMESTAMP parameter, given in seconds since the epoch - has a '%d' for the parameter number
+//
+#define PG_TIMESTAMP_PARAM  "(to_timestamp($%d::float8) AT TIME ZONE 'UTC')"
+
+
+
+// -----------------------------------------------------------------------------
+//
+// PG_GEO_VALUE - SQL for the geo value of a row of the attributes (or subAttributes) table, whatever its geometry
+//
+#define PG_GEO_VALUE(alias)                      \
+  "COALESCE(" alias ".geoPoint::geography, "     \
+  alias ".geoMultiPoint::geography, "            \
+  alias ".geoPolygon::geography, "               \
+  alias ".geoMultiPolygon::geography, "          \
+  alias ".geoLineString::geography, "            \
+  alias ".geoMultiLineString::geography)"
+
+
+
+// -----------------------------------------------------------------------------
+//
+// TroeSql - an SQL command under construction, for a temporal query
+//
+typedef struct TroeSql
+{
+  PgAppendBuffer  sql;
+  PgParams        params;
+  int             timeAtParam;      // Parameter number of 'timeAt'    - 0 if no timerel
+  int             endTimeAtParam;   // Parameter number of 'endTimeAt' - 0 unless timerel=between
+} TroeSql;
+
+#endif  // SRC_LIB_ORIONLD_TYPES_TROESQL_H_
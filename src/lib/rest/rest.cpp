@@ -71,6 +71,8 @@ extern "C"
 #include "orionld/mhd/mhdConnectionInit.h"                       // mhdConnectionInit
 #include "orionld/mhd/mhdConnectionPayloadRead.h"                // mhdConnectionPayloadRead
 #include "orionld/mhd/mhdConnectionTreat.h"                      // mhdConnectionTreat
+#include "orionld/mhd/mhdRequestDispatch.h"                      // mhdRequestDispatch, mhdRequestJobRelease
+#include "orionld/mhd/mhdRequestExecutors.h"                     // requestExecutors
 #include "orionld/distOp/distOpListRelease.h"                    // distOpListRelease
 
 #include "rest/HttpHeaders.h"                                    // HTTP_* defines
@@ -357,19 +359,15 @@ static MHD_Result httpHeaderGet(void* cbDataP, MHD_ValueKind kind, const char* k
 
 /* ****************************************************************************
 *
-* requestCompleted -
+* requestCompletedTreat - what's left to do for a request once its response has been queued
+*
+* Called by requestCompleted, and, for requests executed by the request executors (-reqExecutors),
+* by the executor itself, once it has resumed the connection (ciP is NULL - NGSI-LD requests only).
 */
-static void requestCompleted
-(
-  void*                       cls,
-  MHD_Connection*             connection,
-  void**                      con_cls,
-  MHD_RequestTerminationCode  toe
-)
+void requestCompletedTreat(ConnectionInfo* ciP)
 {
   PERFORMANCE(requestCompletedStart);
 
-  ConnectionInfo*  ciP      = (ConnectionInfo*) *con_cls;
   const char*      spath    = ((orionldState.apiVersion != API_VERSION_NGSILD_V1) && (ciP->servicePathV.size() > 0))? ciP->servicePathV[0].c_str() : "";
   struct timespec  reqEndTime;
 
@@ -452,6 +450,9 @@ static void requestCompleted
   if (orionldState.distOpList != NULL)
     distOpListRelease(orionldState.distOpList);
 
+  if (orionldState.responseStreamed == true)  // Streamed responses: mhdConnectionTreat leaves the release of the state to us
+    orionldStateRelease();
+
   lmTransactionEnd();  // Incoming REST request ends
 
   if (timingStatistics)
@@ -534,8 +535,6 @@ static void requestCompleted
   if ((orionldState.responseTree != NULL) && (orionldState.kjsonP == NULL))
     kjFree(orionldState.responseTree);
 
-  *con_cls = NULL;
-
 #ifdef REQUEST_PERFORMANCE
   // if (requestNo % 100 == 0)
   {
@@ -582,6 +581,32 @@ static void requestCompleted
 
 
 
+/* ****************************************************************************
+*
+* requestCompleted -
+*
+* Requests executed by the request executors have been completed by the executor already - only the job is left to free.
+*/
+static void requestCompleted
+(
+  void*                       cls,
+  MHD_Connection*             connection,
+  void**                      con_cls,
+  MHD_RequestTerminationCode  toe
+)
+{
+  if ((requestExecutors > 0) && (mhdRequestJobRelease(*con_cls) == true))
+  {
+    *con_cls = NULL;
+    return;
+  }
+
+  requestCompletedTreat((ConnectionInfo*) *con_cls);
+  *con_cls = NULL;
+}
+
+
+
 /* ****************************************************************************
 *
 * servicePathCheck - check vector of service paths
@@ -1319,6 +1344,12 @@ static MHD_Result connectionTreat
   //
   if (strncmp(url, "/ngsi-ld/", 9) == 0)
   {
+    //
+    // With request executors, the thread of MHD only reads the request - an executor treats it
+    //
+    if (requestExecutors > 0)
+      return mhdRequestDispatch(connection, url, method, version, upload_data, upload_data_size, con_cls);
+
     if (*con_cls == NULL)
     {
       *con_cls = &cls;  // to "acknowledge" the first call
@@ -1632,6 +1663,13 @@ static int restStart(IpVersion ipVersion, const char* httpsKey = NULL, const cha
 #else
     serverMode = MHD_USE_SELECT_INTERNALLY | MHD_USE_EPOLL_LINUX_ONLY;
 #endif
+
+    //
+    // With request executors (-reqExecutors), the threads of the pool are I/O threads only - the connection of an
+    // NGSI-LD request is suspended while an executor treats the request (see mhdRequestDispatch)
+    //
+    if (requestExecutors > 0)
+      serverMode |= MHD_USE_SUSPEND_RESUME;
   }
 
   //
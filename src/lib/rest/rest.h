@@ -85,6 +85,14 @@ typedef std::string (*RestServeFunction)(ConnectionInfo* ciP);
 
 
 
+/* ****************************************************************************
+*
+* requestCompletedTreat - what's left to do for a request once its response has been queued
+*/
+extern void requestCompletedTreat(ConnectionInfo* ciP);
+
+
+
 /* ****************************************************************************
 *
 * restPortGet -
@@ -0,0 +1,303 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // printf, snprintf
+#include <stdlib.h>                                              // atoi, calloc, malloc
+#include <string.h>                                              // strdup
+#include <ctype.h>                                               // toupper
+#include <time.h>                                                // clock_gettime
+
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                       // KAlloc
+#include "kalloc/kaBufferInit.h"                                 // kaBufferInit
+#include "khash/khash.h"                                         // KHashTable, khashTableCreate, khashItemAdd
+}
+
+#include "orionld/types/OrionldContext.h"                        // OrionldContext
+#include "orionld/types/OrionldContextItem.h"                    // OrionldContextItem
+#include "orionld/contextCache/orionldContextCache.h"            // ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE
+#include "orionld/context/orionldContextItemLookup.h"            // orionldContextItemLookup
+#include "orionld/context/orionldContextItemValueLookup.h"       // orionldContextItemValueLookup
+#include "orionld/context/orionldContextArrayMerge.h"            // orionldContextArrayMerge
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Microbenchmark: term expansion and compaction with an array @context - recursive vs merged (orionldContextArrayMerge)
+//
+// The array context is built by hand, the way orionldContextFromTree leaves it for a downloaded context like
+//   [ "common.jsonld", "Building.jsonld", "Device.jsonld", "WeatherObserved.jsonld", "tenant.jsonld" ]
+// (the core context is removed from arrays by orionldContextSimplify and is looked up first, separately).
+// The tenant context redefines a few terms of the Building context.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Stand-ins for what the benchmark doesn't link with
+//
+OrionldContext* orionldCoreContextP = NULL;
+
+unsigned int hashCode(const char* name)   // Same as orionldContextFromObject.cpp
+{
+  unsigned int code = 0;
+
+  while (*name != 0)
+  {
+    code += (unsigned char) *name;
+    ++name;
+  }
+
+  return code;
+}
+
+
+
+static KAlloc kalloc;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Words to make up realistic (camelCase) attribute names
+//
+static const char* wordV[] =
+{
+  "air", "quality", "temperature", "pressure", "humidity", "wind", "speed", "direction", "level", "status",
+  "battery", "signal", "strength", "floor", "area", "occupancy", "opening", "hours", "owner", "category",
+  "date", "observed", "modified", "created", "source", "provider", "value", "max", "min", "average",
+  "power", "consumption", "energy", "water", "flow", "noise", "light", "dew", "point", "precipitation"
+};
+
+#define WORDS  ((int) (sizeof(wordV) / sizeof(wordV[0])))
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nameCompare, valueCompare -
+//
+static int nameCompare(const char* name, void* itemP)      { return strcmp(name, ((OrionldContextItem*) itemP)->name); }
+static int valueCompare(const char* longname, void* itemP) { return strcmp(longname, ((OrionldContextItem*) itemP)->id); }
+
+
+
+// -----------------------------------------------------------------------------
+//
+// termName - word 'w1' followed by word 'w2', camelCased
+//
+static char* termName(int w1, int w2)
+{
+  char  name[64];
+  int   len = strlen(wordV[w1 % WORDS]);
+
+  snprintf(name, sizeof(name), "%s%s", wordV[w1 % WORDS], wordV[w2 % WORDS]);
+  name[len] = toupper(name[len]);
+
+  return strdup(name);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// contextCreate - a key-values context with 'terms' terms, starting at word pair 'first'
+//
+static OrionldContext* contextCreate(const char* base, int first, int terms)
+{
+  OrionldContext* contextP = (OrionldContext*) calloc(1, sizeof(OrionldContext));
+
+  contextP->keyValues                   = true;
+  contextP->context.hash.nameHashTable  = khashTableCreate(&kalloc, hashCode, nameCompare,  ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
+  contextP->context.hash.valueHashTable = khashTableCreate(&kalloc, hashCode, valueCompare, ORIONLD_CONTEXT_CACHE_HASH_ARRAY_SIZE);
+
+  for (int ix = first; ix < first + terms; ix++)
+  {
+    OrionldContextItem* itemP = (OrionldContextItem*) calloc(1, sizeof(OrionldContextItem));
+    char                iri[256];
+
+    itemP->name = termName(ix / WORDS, ix % WORDS);
+    snprintf(iri, sizeof(iri), "%s%s", base, itemP->name);
+    itemP->id   = strdup(iri);
+
+    khashItemAdd(contextP->context.hash.nameHashTable,  itemP->name, itemP);
+    khashItemAdd(contextP->context.hash.valueHashTable, itemP->id,   itemP);
+  }
+
+  return contextP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nowNs -
+//
+static double nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000.0 + ts.tv_nsec;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entityRun - expand all attribute names of an entity, then compact them back
+//
+static int entityRun(OrionldContext* contextP, char** names, int nameCount, int loops)
+{
+  int found = 0;
+
+  for (int loop = 0; loop < loops; loop++)
+  {
+    for (int ix = 0; ix < nameCount; ix++)
+    {
+      OrionldContextItem* itemP = orionldContextItemLookup(contextP, names[ix], NULL);
+
+      if (itemP != NULL)
+      {
+        if (orionldContextItemValueLookup(contextP, itemP->id) != NULL)
+          ++found;
+      }
+    }
+  }
+
+  return found;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// main -
+//
+int main(int argC, char* argV[])
+{
+  int    loops        = (argC > 1)? atoi(argV[1]) : 100000;
+  int    bufSize      = 64 * 1024 * 1024;
+  char*  kallocBuffer = (char*) malloc(bufSize);
+
+  kaBufferInit(&kalloc, kallocBuffer, bufSize, 1024 * 1024, NULL, "benchmark kalloc buffer");
+
+  //
+  // The array context: five contexts, 800 terms
+  //
+  OrionldContext* vector[5];
+
+  vector[0] = contextCreate("https://smartdatamodels.org/",                          0,   100);  // common
+  vector[1] = contextCreate("https://smartdatamodels.org/dataModel.Building/",       100, 200);
+  vector[2] = contextCreate("https://smartdatamodels.org/dataModel.Device/",         300, 200);
+  vector[3] = contextCreate("https://smartdatamodels.org/dataModel.Weather/",        500, 250);
+  vector[4] = contextCreate("https://tenant.example.org/ld/",                        120, 50);   // Overrides 50 Building terms
+
+  OrionldContext arrayContext;
+
+  bzero(&arrayContext, sizeof(arrayContext));
+  arrayContext.keyValues            = false;
+  arrayContext.context.array.items  = 5;
+  arrayContext.context.array.vector = vector;
+
+  //
+  // A WeatherObserved-like entity: 24 attributes from all five contexts, and 3 that aren't defined (default URL)
+  //
+  int    termIx[] = { 5, 12, 40, 77, 99, 130, 150, 180, 210, 290, 310, 350, 420, 499, 510, 530, 560, 600, 650, 700, 740, 745, 749, 125 };
+  int    termN    = sizeof(termIx) / sizeof(termIx[0]);
+  char*  names[32];
+  int    nameCount = 0;
+
+  for (int ix = 0; ix < termN; ix++)
+    names[nameCount++] = termName(termIx[ix] / WORDS, termIx[ix] % WORDS);
+
+  names[nameCount++] = strdup("refDeviceXyz");
+  names[nameCount++] = strdup("notInAnyContext");
+  names[nameCount++] = strdup("vendorSpecificExtra");
+
+  //
+  // Terms that resolve differently: the recursive lookup stops at the first context that defines the term,
+  // the merged table honours JSON-LD override order (the last definition wins)
+  //
+  if (orionldContextArrayMerge(&arrayContext, &kalloc) == false)
+  {
+    printf("orionldContextArrayMerge failed\n");
+    return 1;
+  }
+
+  KHashTable* nameTableP  = arrayContext.context.array.nameHashTable;
+  KHashTable* valueTableP = arrayContext.context.array.valueHashTable;
+  int         overridden  = 0;
+
+  for (int ix = 0; ix < nameCount; ix++)
+  {
+    OrionldContextItem* mergedP = orionldContextItemLookup(&arrayContext, names[ix], NULL);
+
+    arrayContext.context.array.nameHashTable = NULL;
+    OrionldContextItem* recursiveP = orionldContextItemLookup(&arrayContext, names[ix], NULL);
+    arrayContext.context.array.nameHashTable = nameTableP;
+
+    if (mergedP != recursiveP)
+    {
+      printf("  %-28s  recursive: %s\n  %-28s  merged:    %s\n", names[ix], recursiveP->id, "", mergedP->id);
+      ++overridden;
+    }
+  }
+  printf("%d of %d attribute names resolve differently (overridden by a later context)\n\n", overridden, nameCount);
+
+  //
+  // Merge cost, then throughput
+  //
+  double start = nowNs();
+  for (int ix = 0; ix < 100; ix++)
+    orionldContextArrayMerge(&arrayContext, &kalloc);
+  double mergeNs = (nowNs() - start) / 100;
+
+  arrayContext.context.array.nameHashTable  = NULL;
+  arrayContext.context.array.valueHashTable = NULL;
+
+  start = nowNs();
+  int recursiveFound = entityRun(&arrayContext, names, nameCount, loops);
+  double recursiveNs = (nowNs() - start) / loops;
+
+  arrayContext.context.array.nameHashTable  = nameTableP;
+  arrayContext.context.array.valueHashTable = valueTableP;
+
+  start = nowNs();
+  int mergedFound = entityRun(&arrayContext, names, nameCount, loops);
+  double mergedNs = (nowNs() - start) / loops;
+
+  printf("%-12s %14s %14s %12s\n", "lookups", "ns/entity", "ns/term", "entities/s");
+  printf("%-12s %14.1f %14.1f %12.0f\n", "recursive", recursiveNs, recursiveNs / (nameCount * 2), 1000000000.0 / recursiveNs);
+  printf("%-12s %14.1f %14.1f %12.0f\n", "merged",    mergedNs,    mergedNs / (nameCount * 2),    1000000000.0 / mergedNs);
+  printf("\nspeedup: %.1fx, merge of the array context: %.1f us (once, when cached)\n", recursiveNs / mergedNs, mergeNs / 1000);
+
+  if (recursiveFound != mergedFound)
+    printf("WARNING: %d terms compacted back by the recursive lookup, %d by the merged tables\n", recursiveFound / loops, mergedFound / loops);
+
+  return 0;
+}
@@ -0,0 +1,381 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // printf, fprintf
+#include <stdlib.h>                                              // atoi, malloc, free, exit
+#include <string.h>                                              // strstr, strncasecmp, strerror
+#include <errno.h>                                               // errno, EAGAIN
+#include <unistd.h>                                              // close, read, write, sleep
+#include <fcntl.h>                                               // fcntl, O_NONBLOCK
+#include <time.h>                                                // clock_gettime
+#include <pthread.h>                                             // pthread_create, pthread_join
+#include <netinet/in.h>                                          // sockaddr_in
+#include <netinet/tcp.h>                                         // TCP_NODELAY
+#include <arpa/inet.h>                                           // inet_pton
+#include <sys/socket.h>                                          // socket, connect
+#include <sys/epoll.h>                                           // epoll_*
+#include <sys/resource.h>                                        // setrlimit
+
+#include <vector>                                                // std::vector
+#include <algorithm>                                             // std::sort
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Load test: latency percentiles of the broker with many concurrent keep-alive clients
+//
+// Every connection sends a request, waits for the response, and sends the next request on the same connection,
+// for as long as the test runs (closed loop). The connections are spread over a few client threads, each with
+// an epoll set of its own, so, ten thousand connections need no more than a handful of threads.
+//
+// Responses are read until the end of the body: Content-Length, or the last chunk of a chunked response.
+//
+// With a method and a payload file, the requests are e.g. PATCHes of an entity with a subscription, i.e. requests
+// that have notifications to send after the response.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Connection -
+//
+typedef struct Connection
+{
+  int              fd;
+  struct timespec  sent;
+  char*            buf;
+  int              bufLen;
+  int              bufSize;
+} Connection;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ClientThread -
+//
+typedef struct ClientThread
+{
+  pthread_t              tid;
+  int                    connections;
+  std::vector<unsigned>  latencyV;       // Microseconds
+  unsigned long          errors;
+} ClientThread;
+
+
+
+static struct sockaddr_in  brokerAddress;
+static char                request[8192];
+static int                 requestLen;
+static volatile bool       stop = false;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// usecSince -
+//
+static unsigned usecSince(struct timespec* startP)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - startP->tv_sec) * 1000000 + (now.tv_nsec - startP->tv_nsec) / 1000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// responseComplete - true if the buffer holds an entire response
+//
+static bool responseComplete(Connection* cP)
+{
+  cP->buf[cP->bufLen] = 0;
+
+  char* endOfHeaders = strstr(cP->buf, "\r\n\r\n");
+  if (endOfHeaders == NULL)
+    return false;
+
+  char* body = endOfHeaders + 4;
+
+  for (char* lineP = cP->buf; lineP < endOfHeaders; lineP = strstr(lineP, "\r\n") + 2)
+  {
+    if (strncasecmp(lineP, "Content-Length:", 15) == 0)
+      return (cP->bufLen - (body - cP->buf)) >= atoi(&lineP[15]);
+
+    if (strncasecmp(lineP, "Transfer-Encoding: chunked", 26) == 0)
+      return (cP->bufLen >= 5) && (strcmp(&cP->buf[cP->bufLen - 5], "0\r\n\r\n") == 0);
+  }
+
+  return true;  // No body
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// requestSend -
+//
+static bool requestSend(Connection* cP)
+{
+  cP->bufLen = 0;
+  clock_gettime(CLOCK_MONOTONIC, &cP->sent);
+
+  return write(cP->fd, request, requestLen) == requestLen;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// connectionOpen -
+//
+static bool connectionOpen(Connection* cP)
+{
+  int one = 1;
+
+  cP->fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (cP->fd == -1)
+    return false;
+
+  setsockopt(cP->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  if (connect(cP->fd, (struct sockaddr*) &brokerAddress, sizeof(brokerAddress)) == -1)
+  {
+    close(cP->fd);
+    return false;
+  }
+
+  fcntl(cP->fd, F_SETFL, fcntl(cP->fd, F_GETFL) | O_NONBLOCK);
+
+  return true;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// clientThread -
+//
+static void* clientThread(void* vP)
+{
+  ClientThread*       ctP     = (ClientThread*) vP;
+  int                 epollFd = epoll_create1(0);
+  Connection*         connV   = (Connection*) calloc(ctP->connections, sizeof(Connection));
+  struct epoll_event  eventV[256];
+
+  for (int ix = 0; ix < ctP->connections; ix++)
+  {
+    Connection* cP = &connV[ix];
+
+    cP->bufSize = 64 * 1024;
+    cP->buf     = (char*) malloc(cP->bufSize + 1);
+
+    if (connectionOpen(cP) == false)
+    {
+      fprintf(stderr, "unable to connect (connection %d): %s\n", ix, strerror(errno));
+      exit(1);
+    }
+
+    struct epoll_event event = { EPOLLIN, { cP } };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, cP->fd, &event);
+
+    requestSend(cP);
+  }
+
+  while (stop == false)
+  {
+    int events = epoll_wait(epollFd, eventV, 256, 100);
+
+    for (int ix = 0; ix < events; ix++)
+    {
+      Connection* cP = (Connection*) eventV[ix].data.ptr;
+      int         nb = read(cP->fd, &cP->buf[cP->bufLen], cP->bufSize - cP->bufLen);
+
+      if ((nb == -1) && (errno == EAGAIN))
+        continue;
+
+      if (nb <= 0)  // Closed by the broker - reconnect and start over
+      {
+        ++ctP->errors;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, cP->fd, NULL);
+        close(cP->fd);
+
+        if (connectionOpen(cP) == false)
+          continue;
+
+        struct epoll_event event = { EPOLLIN, { cP } };
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, cP->fd, &event);
+        requestSend(cP);
+        continue;
+      }
+
+      cP->bufLen += nb;
+
+      if (cP->bufLen >= cP->bufSize)  // Response too big for the buffer - only the latency matters, so, drop what's been read
+        cP->bufLen = 0;
+
+      if (responseComplete(cP) == false)
+        continue;
+
+      if (strncmp(cP->buf, "HTTP/1.1 2", 10) != 0)
+        ++ctP->errors;
+
+      ctP->latencyV.push_back(usecSince(&cP->sent));
+
+      if (requestSend(cP) == false)
+        ++ctP->errors;
+    }
+  }
+
+  for (int ix = 0; ix < ctP->connections; ix++)
+  {
+    close(connV[ix].fd);
+    free(connV[ix].buf);
+  }
+
+  free(connV);
+  close(epollFd);
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// percentile -
+//
+static unsigned percentile(std::vector<unsigned>& latencyV, double p)
+{
+  size_t ix = (size_t) (p / 100 * (latencyV.size() - 1));
+
+  return latencyV[ix];
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// main -
+//
+// Usage: keepAliveLatencyBenchmark [host] [port] [connections] [seconds] [threads] [url path] [method] [payload file]
+//
+int main(int argC, char* argV[])
+{
+  const char*  host        = (argC > 1)? argV[1]       : "127.0.0.1";
+  int          port        = (argC > 2)? atoi(argV[2]) : 1026;
+  int          connections = (argC > 3)? atoi(argV[3]) : 10000;
+  int          seconds     = (argC > 4)? atoi(argV[4]) : 30;
+  int          threads     = (argC > 5)? atoi(argV[5]) : 8;
+  const char*  urlPath     = (argC > 6)? argV[6]       : "/ngsi-ld/v1/entities?type=T&limit=1";
+  const char*  method      = (argC > 7)? argV[7]       : "GET";
+  const char*  payloadFile = (argC > 8)? argV[8]       : NULL;
+  char         payload[4096];
+  int          payloadLen  = 0;
+
+  if (payloadFile != NULL)
+  {
+    FILE* fP = fopen(payloadFile, "r");
+
+    if (fP == NULL)
+    {
+      fprintf(stderr, "unable to open the payload file %s: %s\n", payloadFile, strerror(errno));
+      return 1;
+    }
+
+    payloadLen = fread(payload, 1, sizeof(payload) - 1, fP);
+    fclose(fP);
+
+    if (payloadLen == sizeof(payload) - 1)
+    {
+      fprintf(stderr, "the payload file %s is too big (max %d bytes)\n", payloadFile, (int) sizeof(payload) - 2);
+      return 1;
+    }
+  }
+  payload[payloadLen] = 0;
+
+  struct rlimit rl = { (rlim_t) connections + 100, (rlim_t) connections + 100 };
+  if (setrlimit(RLIMIT_NOFILE, &rl) == -1)
+    fprintf(stderr, "warning: unable to raise the limit of open files to %d: %s\n", connections + 100, strerror(errno));
+
+  brokerAddress.sin_family = AF_INET;
+  brokerAddress.sin_port   = htons(port);
+  if (inet_pton(AF_INET, host, &brokerAddress.sin_addr) != 1)
+  {
+    fprintf(stderr, "invalid IPv4 address: %s\n", host);
+    return 1;
+  }
+
+  if (payloadLen == 0)
+    requestLen = snprintf(request, sizeof(request), "%s %s HTTP/1.1\r\nHost: %s:%d\r\nAccept: application/json\r\nConnection: keep-alive\r\n\r\n", method, urlPath, host, port);
+  else
+    requestLen = snprintf(request, sizeof(request), "%s %s HTTP/1.1\r\nHost: %s:%d\r\nAccept: application/json\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: keep-alive\r\n\r\n%s",
+                          method, urlPath, host, port, payloadLen, payload);
+
+  ClientThread* threadV = new ClientThread[threads];
+
+  for (int ix = 0; ix < threads; ix++)
+  {
+    threadV[ix].connections = connections / threads + ((ix < connections % threads)? 1 : 0);
+    threadV[ix].errors      = 0;
+    pthread_create(&threadV[ix].tid, NULL, clientThread, &threadV[ix]);
+  }
+
+  sleep(seconds);
+  stop = true;
+
+  std::vector<unsigned>  latencyV;
+  unsigned long          errors = 0;
+
+  for (int ix = 0; ix < threads; ix++)
+  {
+    pthread_join(threadV[ix].tid, NULL);
+    latencyV.insert(latencyV.end(), threadV[ix].latencyV.begin(), threadV[ix].latencyV.end());
+    errors += threadV[ix].errors;
+  }
+
+  delete[] threadV;
+
+  if (latencyV.size() == 0)
+  {
+    printf("no responses\n");
+    return 1;
+  }
+
+  std::sort(latencyV.begin(), latencyV.end());
+
+  printf("%d connections, %d seconds, %s %s\n", connections, seconds, method, urlPath);
+  printf("  requests:    %lu (%.0f/s), %lu errors\n", (unsigned long) latencyV.size(), (double) latencyV.size() / seconds, errors);
+  printf("  latency p50:   %8.3f ms\n", percentile(latencyV, 50)   / 1000.0);
+  printf("  latency p90:   %8.3f ms\n", percentile(latencyV, 90)   / 1000.0);
+  printf("  latency p99:   %8.3f ms\n", percentile(latencyV, 99)   / 1000.0);
+  printf("  latency p99.9: %8.3f ms\n", percentile(latencyV, 99.9) / 1000.0);
+  printf("  latency max:   %8.3f ms\n", latencyV.back()              / 1000.0);
+
+  return 0;
+}
@@ -0,0 +1,246 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // printf
+#include <stdlib.h>                                              // atoi, calloc
+#include <string.h>                                              // strdup
+#include <time.h>                                                // clock_gettime
+
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                       // KAlloc
+#include "kalloc/kaBufferInit.h"                                 // kaBufferInit
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBufferCreate.h"                                // kjBufferCreate
+#include "kjson/kjBuilder.h"                                     // kjObject, kjString, kjInteger, kjFloat, kjBoolean, kjChildAdd
+}
+
+#include "orionld/types/QNode.h"                                 // QNode
+#include "orionld/types/QCompiled.h"                             // QCompiled
+#include "orionld/q/qRelease.h"                                  // qRelease
+#include "orionld/q/qMatch.h"                                    // qMatch
+#include "orionld/q/qCompile.h"                                  // qCompile
+#include "orionld/q/qCompiledMatch.h"                            // qCompiledMatch
+#include "orionld/q/qCompiledRelease.h"                          // qCompiledRelease
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Microbenchmark: the q-filter tree walk (qMatch) vs the compiled q-filter (qCompiledMatch)
+//
+// The q-trees are built by hand, the way qBuild leaves them for subscription matching
+// (expanded attribute names, '.' turned into '=', ".value" appended).
+//
+#define CORE  "https://uri=etsi=org/ngsi-ld/default-context/"
+#define LONG  "https://uri.etsi.org/ngsi-ld/default-context/"
+
+
+
+// -----------------------------------------------------------------------------
+//
+// QNode builders
+//
+static QNode* qn(QNodeType type)
+{
+  QNode* qP = (QNode*) calloc(1, sizeof(QNode));
+
+  qP->type = type;
+  return qP;
+}
+
+static QNode* qVar(const char* path)        { QNode* qP = qn(QNodeVariable);     qP->value.v  = strdup(path);  return qP; }
+static QNode* qInt(long long i)             { QNode* qP = qn(QNodeIntegerValue); qP->value.i  = i;             return qP; }
+static QNode* qFloat(double f)              { QNode* qP = qn(QNodeFloatValue);   qP->value.f  = f;             return qP; }
+static QNode* qStr(const char* s)           { QNode* qP = qn(QNodeStringValue);  qP->value.s  = strdup(s);     return qP; }
+static QNode* qRe(const char* re)           { QNode* qP = qn(QNodeRegexpValue);  qP->value.re = strdup(re);    return qP; }
+static QNode* qTrue(void)                   { return qn(QNodeTrueValue); }
+
+static QNode* qList(QNodeType type, QNode* first, QNode* second, QNode* third = NULL)
+{
+  QNode* qP = qn(type);
+
+  qP->value.children = first;
+  first->next        = second;
+  second->next       = third;
+
+  return qP;
+}
+
+static QNode* qCmp(QNodeType type, const char* path, QNode* rhs)
+{
+  return qList(type, qVar(path), rhs);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entityCreate - a normalized API entity, like the ones subscriptions are matched against
+//
+static KjNode* entityCreate(Kjson* kjsonP)
+{
+  KjNode* entityP = kjObject(kjsonP, NULL);
+  KjNode* attrP;
+
+  kjChildAdd(entityP, kjString(kjsonP, "id",   "urn:ngsi-ld:Room:101"));
+  kjChildAdd(entityP, kjString(kjsonP, "type", LONG "Room"));
+
+  attrP = kjObject(kjsonP, LONG "temperature");
+  kjChildAdd(attrP, kjString(kjsonP, "type", "Property"));
+  kjChildAdd(attrP, kjFloat(kjsonP, "value", 23.5));
+  kjChildAdd(attrP, kjString(kjsonP, "observedAt", "2024-05-01T10:00:00.000Z"));
+  kjChildAdd(entityP, attrP);
+
+  attrP = kjObject(kjsonP, LONG "humidity");
+  kjChildAdd(attrP, kjString(kjsonP, "type", "Property"));
+  kjChildAdd(attrP, kjInteger(kjsonP, "value", 60));
+  kjChildAdd(entityP, attrP);
+
+  attrP = kjObject(kjsonP, LONG "name");
+  kjChildAdd(attrP, kjString(kjsonP, "type", "Property"));
+  kjChildAdd(attrP, kjString(kjsonP, "value", "room-101-north"));
+  kjChildAdd(entityP, attrP);
+
+  attrP = kjObject(kjsonP, LONG "status");
+  kjChildAdd(attrP, kjString(kjsonP, "type", "Property"));
+  kjChildAdd(attrP, kjString(kjsonP, "value", "alarm"));
+  kjChildAdd(entityP, attrP);
+
+  attrP = kjObject(kjsonP, LONG "isOpen");
+  kjChildAdd(attrP, kjString(kjsonP, "type", "Property"));
+  kjChildAdd(attrP, kjBoolean(kjsonP, "value", true));
+  kjChildAdd(entityP, attrP);
+
+  attrP = kjObject(kjsonP, LONG "locatedIn");
+  kjChildAdd(attrP, kjString(kjsonP, "type", "Relationship"));
+  kjChildAdd(attrP, kjString(kjsonP, "object", "urn:ngsi-ld:Building:B1"));
+  kjChildAdd(entityP, attrP);
+
+  return entityP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nowNs -
+//
+static double nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000.0 + ts.tv_nsec;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Expression -
+//
+typedef struct Expression
+{
+  const char* q;
+  QNode*      qP;
+} Expression;
+
+
+
+// -----------------------------------------------------------------------------
+//
+// main -
+//
+int main(int argC, char* argV[])
+{
+  int      loops = (argC > 1)? atoi(argV[1]) : 1000000;
+  char     kallocBuffer[32 * 1024];
+  KAlloc   kalloc;
+  Kjson    kjson;
+  Kjson*   kjsonP;
+
+  kaBufferInit(&kalloc, kallocBuffer, sizeof(kallocBuffer), 8 * 1024, NULL, "qMatch benchmark");
+  kjsonP = kjBufferCreate(&kjson, &kalloc);
+
+  KjNode* entityP = entityCreate(kjsonP);
+
+  Expression expressionV[] =
+  {
+    { "temperature>20",                                qCmp(QNodeGT, CORE "temperature.value", qInt(20))                                                  },
+    { "temperature>20;humidity<80",                    qList(QNodeAnd, qCmp(QNodeGT, CORE "temperature.value", qInt(20)),
+                                                                       qCmp(QNodeLT, CORE "humidity.value",    qInt(80)))                              },
+    { "status==\"ok\",\"warning\",\"alarm\"",          qCmp(QNodeEQ, CORE "status.value", qList(QNodeComma, qStr("ok"), qStr("warning"), qStr("alarm")))  },
+    { "humidity==50..70",                              qCmp(QNodeEQ, CORE "humidity.value", qList(QNodeRange, qInt(50), qInt(70)))                        },
+    { "(temperature>30|humidity>90);isOpen==true",     qList(QNodeAnd, qList(QNodeOr, qCmp(QNodeGT, CORE "temperature.value", qInt(30)),
+                                                                                      qCmp(QNodeGT, CORE "humidity.value",    qInt(90))),
+                                                                       qCmp(QNodeEQ, CORE "isOpen.value", qTrue()))                              },
+    { "temperature.observedAt>=2024-01-01T00:00:00Z",  qCmp(QNodeGE, CORE "temperature.observedAt", qFloat(1704067200))                                    },
+    { "locatedIn==\"urn:ngsi-ld:Building:B1\"",        qCmp(QNodeEQ, CORE "locatedIn.value", qStr("urn:ngsi-ld:Building:B1"))                            },
+    { "name~=RE(^room-[0-9]+-(north|south)$)",         qCmp(QNodeMatch, CORE "name.value", qRe("^room-[0-9]+-(north|south)$"))                            }
+  };
+  int expressions = sizeof(expressionV) / sizeof(expressionV[0]);
+
+  printf("%-48s %8s %12s %12s %8s\n", "q", "result", "tree ns/op", "compiled", "speedup");
+
+  for (int eIx = 0; eIx < expressions; eIx++)
+  {
+    QNode*     qP    = expressionV[eIx].qP;
+    QCompiled* qcP   = qCompile(qP);
+    bool       tree  = qMatch(qP, entityP);
+    bool       comp  = qCompiledMatch(qcP, entityP);
+    int        hits  = 0;
+    double     start;
+
+    start = nowNs();
+    for (int loop = 0; loop < loops; loop++)
+    {
+      hits += qMatch(qP, entityP);
+    }
+    double treeNs = (nowNs() - start) / loops;
+
+    start = nowNs();
+    for (int loop = 0; loop < loops; loop++)
+    {
+      hits += qCompiledMatch(qcP, entityP);
+    }
+    double compiledNs = (nowNs() - start) / loops;
+
+    printf("%-48s %8s %12.1f %12.1f %7.1fx%s\n",
+           expressionV[eIx].q,
+           (comp == true)? "match" : "no match",
+           treeNs,
+           compiledNs,
+           treeNs / compiledNs,
+           (tree != comp)? "   (tree walk differs)" : "");
+
+    if (hits == -1)  // Just so the loops can't be optimized away
+      printf("\n");
+
+    qCompiledRelease(qcP);
+    qRelease(qP);
+  }
+
+  return 0;
+}
@@ -0,0 +1,606 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // printf, snprintf
+#include <stdlib.h>                                              // atoi, calloc, malloc
+#include <string.h>                                              // strcmp, strncmp, strstr, strncpy, strlen, strdup
+#include <time.h>                                                // clock_gettime
+
+extern "C"
+{
+#include "kalloc/KAlloc.h"                                       // KAlloc
+#include "kalloc/kaBufferInit.h"                                 // kaBufferInit
+#include "kalloc/kaBufferReset.h"                                // kaBufferReset
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+}
+
+#include "orionld/types/OrionLdRestService.h"                    // OrionLdRestService, ORION_LD_SERVICE_PREFIX_LEN
+#include "orionld/service/orionldServiceTrieBuild.h"             // orionldServiceTrieBuild
+#include "orionld/service/orionldServiceTrieMatch.h"             // orionldServiceTrieMatch
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Microbenchmark: service lookup - the linear checksum scan vs the trie router (orionldServiceTrieMatch)
+//
+// All NGSI-LD routes of orionld (the URL paths of app/orionld/orionldRestServices.cpp), for all verbs, are
+// looked up with the wildcards filled in with realistic values, plus a few URL paths that don't match any service.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Service vectors - same URL paths, in the same order, as in app/orionld/orionldRestServices.cpp
+//
+static const char* getUrlV[] =
+{
+  "/ngsi-ld/ex/v1/ping",
+  "/ngsi-ld/v1/entities/*",
+  "/ngsi-ld/v1/entities",
+  "/ngsi-ld/v1/entityMaps/*",
+  "/ngsi-ld/v1/types/*",
+  "/ngsi-ld/v1/types",
+  "/ngsi-ld/v1/attributes/*",
+  "/ngsi-ld/v1/attributes",
+  "/ngsi-ld/v1/subscriptions/*",
+  "/ngsi-ld/v1/subscriptions",
+  "/ngsi-ld/v1/csourceRegistrations/*",
+  "/ngsi-ld/v1/csourceRegistrations",
+  "/ngsi-ld/v1/jsonldContexts/*",
+  "/ngsi-ld/v1/jsonldContexts",
+  "/ngsi-ld/v1/temporal/entities/*",
+  "/ngsi-ld/v1/temporal/entities",
+  "/ngsi-ld/ex/v1/version",
+  "/ngsi-ld/ex/v1/tenants",
+  "/ngsi-ld/ex/v1/dbIndexes",
+  NULL
+};
+
+static const char* postUrlV[] =
+{
+  "/ngsi-ld/v1/entities/*/attrs",
+  "/ngsi-ld/v1/entities",
+  "/ngsi-ld/ex/v1/notify",
+  "/ngsi-ld/ex/v1/notifications/*",
+  "/ngsi-ld/v1/entityOperations/create",
+  "/ngsi-ld/v1/entityOperations/upsert",
+  "/ngsi-ld/v1/entityOperations/update",
+  "/ngsi-ld/v1/entityOperations/delete",
+  "/ngsi-ld/v1/entityOperations/query",
+  "/ngsi-ld/v1/subscriptions",
+  "/ngsi-ld/v1/csourceRegistrations",
+  "/ngsi-ld/v1/temporal/entities/*/attrs",
+  "/ngsi-ld/v1/temporal/entities",
+  "/ngsi-ld/v1/temporal/entityOperations/query",
+  "/ngsi-ld/v1/jsonldContexts",
+  NULL
+};
+
+static const char* patchUrlV[] =
+{
+  "/ngsi-ld/v1/entities/*/attrs/*",
+  "/ngsi-ld/v1/entities/*/attrs",
+  "/ngsi-ld/v1/entities/*",
+  "/ngsi-ld/v1/subscriptions/*",
+  "/ngsi-ld/v1/csourceRegistrations/*",
+  "/ngsi-ld/v1/temporal/entities/*/attrs/*/*",
+  NULL
+};
+
+static const char* putUrlV[] =
+{
+  "/ngsi-ld/v1/entities/*/attrs/*",
+  "/ngsi-ld/v1/entities/*",
+  NULL
+};
+
+static const char* deleteUrlV[] =
+{
+  "/ngsi-ld/v1/entities/*/attrs/*",
+  "/ngsi-ld/v1/entities/*",
+  "/ngsi-ld/v1/entities",
+  "/ngsi-ld/v1/entityMaps/*",
+  "/ngsi-ld/v1/subscriptions/*",
+  "/ngsi-ld/v1/csourceRegistrations/*",
+  "/ngsi-ld/v1/jsonldContexts/*",
+  "/ngsi-ld/v1/temporal/entities/*/attrs/*",
+  "/ngsi-ld/v1/temporal/entities/*",
+  NULL
+};
+
+static const char* optionsUrlV[] =
+{
+  "/ngsi-ld/v1/entities/*/attrs/*",
+  "/ngsi-ld/v1/entities/*/attrs",
+  "/ngsi-ld/v1/entities/*",
+  "/ngsi-ld/v1/entities",
+  "/ngsi-ld/v1/entityOperations/create",
+  "/ngsi-ld/v1/entityOperations/upsert",
+  "/ngsi-ld/v1/entityOperations/update",
+  "/ngsi-ld/v1/entityOperations/delete",
+  "/ngsi-ld/v1/entityOperations/query",
+  "/ngsi-ld/v1/types/*",
+  "/ngsi-ld/v1/types",
+  "/ngsi-ld/v1/attributes/*",
+  "/ngsi-ld/v1/attributes",
+  "/ngsi-ld/v1/subscriptions/*",
+  "/ngsi-ld/v1/subscriptions",
+  "/ngsi-ld/v1/csourceRegistrations/*",
+  "/ngsi-ld/v1/csourceRegistrations",
+  "/ngsi-ld/v1/jsonldContexts/*",
+  "/ngsi-ld/v1/jsonldContexts",
+  "/ngsi-ld/v1/temporal/entities/*/attrs/*",
+  "/ngsi-ld/v1/temporal/entities/*/attrs",
+  "/ngsi-ld/v1/temporal/entities/*",
+  "/ngsi-ld/v1/temporal/entities",
+  "/ngsi-ld/v1/temporal/entityOperations/query",
+  NULL
+};
+
+static const char*  verbNameV[] = { "GET",   "POST",   "PATCH",   "PUT",   "DELETE",   "OPTIONS"   };
+static const char** urlVV[]     = { getUrlV, postUrlV, patchUrlV, putUrlV, deleteUrlV, optionsUrlV };
+
+#define VERBS  ((int) (sizeof(urlVV) / sizeof(urlVV[0])))
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Values for the wildcards - an entity id with slashes is included, as URIs are valid entity ids
+//
+static const char* wildcardValueV[][3] =
+{
+  { "urn:ngsi-ld:Vehicle:V1234",                "speed",                                  "urn:ngsi-ld:instance:7c7c1a1e" },
+  { "http://a.b.c/entity/E1",                   "https://uri.etsi.org/ngsi-ld/location",  "I1"                            }
+};
+
+#define WILDCARD_VALUES  ((int) (sizeof(wildcardValueV) / sizeof(wildcardValueV[0])))
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Requests that match no service
+//
+static const char* noMatchUrlV[] =
+{
+  "/ngsi-ld/v1/entities/",
+  "/ngsi-ld/v1/entitiesX",
+  "/ngsi-ld/v1/entityOperations/merge",
+  "/ngsi-ld/v2/entities",
+  "/ngsi-ld/ex/v1/unknown"
+};
+
+#define NO_MATCH_URLS  ((int) (sizeof(noMatchUrlV) / sizeof(noMatchUrlV[0])))
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Request -
+//
+typedef struct Request
+{
+  int    verbIx;
+  char*  urlPath;
+  int    expectedIx;   // -1 for the URL paths that match no service
+} Request;
+
+
+
+static KAlloc  kalloc;
+static char*   wildcard[2];
+
+
+
+// -----------------------------------------------------------------------------
+//
+// servicePrepare - the URL path analysis of restServicePrepare (orionldServiceInit.cpp)
+//
+static void servicePrepare(OrionLdRestService* serviceP, const char* url)
+{
+  serviceP->url = (char*) url;
+
+  int          ix            = ORION_LD_SERVICE_PREFIX_LEN - 1;
+  const char*  wildCardStart = NULL;
+  const char*  wildCardEnd   = NULL;
+
+  while (url[++ix] != 0)
+  {
+    char c = url[ix];
+
+    if (c == '*')
+    {
+      if (serviceP->wildcards == 0)
+        wildCardStart = &url[ix + 1];
+      else if (serviceP->wildcards == 1)
+        wildCardEnd = &url[ix];
+
+      serviceP->wildcards += 1;
+      continue;
+    }
+
+    if (serviceP->wildcards == 0)
+    {
+      ++serviceP->charsBeforeFirstWildcard;
+      serviceP->charsBeforeFirstWildcardSum += c;
+    }
+    else if (serviceP->wildcards == 1)
+    {
+      ++serviceP->charsBeforeSecondWildcard;
+      serviceP->charsBeforeSecondWildcardSum += c;
+    }
+  }
+
+  if (serviceP->wildcards != 0)
+  {
+    if (wildCardEnd == NULL)
+      wildCardEnd = &url[ix];
+
+    serviceP->matchForSecondWildcardLen = wildCardEnd - wildCardStart;
+
+    if (serviceP->matchForSecondWildcardLen != 0)
+      strncpy(serviceP->matchForSecondWildcard, wildCardStart, wildCardEnd - wildCardStart);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// linearLookup - the service lookup before the trie router (orionldServiceLookup.cpp), for comparison
+//
+#define MAX_CHARS_BEFORE_WILDCARD 34
+static void requestPrepare(char* url, int* cSumV, int* cSumsP, int* sLenP)
+{
+  url = &url[ORION_LD_SERVICE_PREFIX_LEN];
+  *cSumsP = 0;
+
+  cSumV[0] = url[0];
+
+  int ix = 1;
+
+  while ((url[ix] != 0) && (ix < MAX_CHARS_BEFORE_WILDCARD))
+  {
+    cSumV[ix]  = cSumV[ix - 1] + url[ix];
+    ++ix;
+  }
+  *cSumsP = ix;
+
+  while (url[ix] != 0)
+  {
+    ++ix;
+  }
+
+  *sLenP = ix;
+}
+
+static OrionLdRestService* linearLookup(OrionLdRestServiceVector* serviceV, char* urlPath)
+{
+  int serviceIx = 0;
+  int cSumV[MAX_CHARS_BEFORE_WILDCARD];
+  int cSums;
+  int sLen;
+
+  requestPrepare(urlPath, cSumV, &cSums, &sLen);
+
+  while (serviceIx < serviceV->services)
+  {
+    OrionLdRestService* serviceP = &serviceV->serviceV[serviceIx];
+
+    if (serviceP->wildcards == 0)
+    {
+      if ((serviceP->charsBeforeFirstWildcard == sLen) && (serviceP->charsBeforeFirstWildcardSum == cSumV[sLen - 1]))
+      {
+        if (strcmp(&serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], &urlPath[ORION_LD_SERVICE_PREFIX_LEN]) == 0)
+          return serviceP;
+      }
+    }
+    else if (serviceP->wildcards == 1)
+    {
+      char* url = kaStrdup(&kalloc, urlPath);
+
+      if ((serviceP->charsBeforeFirstWildcard < sLen) && (serviceP->charsBeforeFirstWildcardSum == cSumV[serviceP->charsBeforeFirstWildcard - 1]))
+      {
+        if (strncmp(&serviceP->url[ORION_LD_SERVICE_PREFIX_LEN], &url[ORION_LD_SERVICE_PREFIX_LEN], serviceP->charsBeforeFirstWildcard) == 0)
+        {
+          if (serviceP->matchForSecondWildcardLen != 0)
+          {
+            int indexOfIncomingUrlPath = ORION_LD_SERVICE_PREFIX_LEN + sLen - serviceP->matchForSecondWildcardLen;
+
+            if (strncmp(&url[indexOfIncomingUrlPath], serviceP->matchForSecondWildcard, serviceP->matchForSecondWildcardLen) == 0)
+            {
+              wildcard[0] = &url[serviceP->charsBeforeFirstWildcard + ORION_LD_SERVICE_PREFIX_LEN];
+              url[sLen - serviceP->matchForSecondWildcardLen + ORION_LD_SERVICE_PREFIX_LEN] = 0;
+              return serviceP;
+            }
+          }
+          else
+          {
+            wildcard[0] = &url[serviceP->charsBeforeFirstWildcard + ORION_LD_SERVICE_PREFIX_LEN];
+            return serviceP;
+          }
+        }
+      }
+    }
+    else
+    {
+      char* url = kaStrdup(&kalloc, urlPath);
+
+      if ((serviceP->charsBeforeFirstWildcard < sLen) && (serviceP->charsBeforeFirstWildcardSum == cSumV[serviceP->charsBeforeFirstWildcard - 1]))
+      {
+        char* matchP;
+        if ((matchP = strstr(&url[ORION_LD_SERVICE_PREFIX_LEN], serviceP->matchForSecondWildcard)) != NULL)
+        {
+          wildcard[0] = &url[serviceP->charsBeforeFirstWildcard + ORION_LD_SERVICE_PREFIX_LEN];
+          wildcard[1] = &matchP[serviceP->matchForSecondWildcardLen];
+          *matchP = 0;
+
+          return serviceP;
+        }
+      }
+    }
+
+    ++serviceIx;
+  }
+
+  return NULL;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// trieLookup - same as orionldServiceLookup, but without orionldState
+//
+static OrionLdRestService* trieLookup(OrionLdRestServiceVector* serviceV, char* urlPath)
+{
+  const char* rest  = NULL;
+  const char* match = NULL;
+  int         sIx   = orionldServiceTrieMatch(serviceV, urlPath, &rest, &match);
+
+  if (sIx == -1)
+    return NULL;
+
+  OrionLdRestService* serviceP = &serviceV->serviceV[sIx];
+
+  if (serviceP->wildcards == 0)
+    return serviceP;
+
+  char* wc = kaStrdup(&kalloc, rest);
+
+  wildcard[0] = wc;
+
+  if (serviceP->wildcards == 1)
+  {
+    if (serviceP->matchForSecondWildcardLen != 0)
+      wc[strlen(wc) - serviceP->matchForSecondWildcardLen] = 0;
+  }
+  else
+  {
+    char* matchP = &wc[match - rest];
+
+    wildcard[1] = &matchP[serviceP->matchForSecondWildcardLen];
+    *matchP = 0;
+  }
+
+  return serviceP;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// urlPathFill - replace the wildcards of a service URL path with values
+//
+static char* urlPathFill(const char* url, int valueIx)
+{
+  char  path[512];
+  int   pIx  = 0;
+  int   wIx  = 0;
+
+  for (const char* s = url; *s != 0; s++)
+  {
+    if (*s == '*')
+      pIx += snprintf(&path[pIx], sizeof(path) - pIx, "%s", wildcardValueV[valueIx][wIx++]);
+    else
+      path[pIx++] = *s;
+  }
+  path[pIx] = 0;
+
+  return strdup(path);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// nowNs -
+//
+static double nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000.0 + ts.tv_nsec;
+}
+
+
+
+typedef OrionLdRestService* (*LookupFunction)(OrionLdRestServiceVector* serviceV, char* urlPath);
+
+// -----------------------------------------------------------------------------
+//
+// requestsRun - look up all requests, 'loops' times
+//
+static int requestsRun(LookupFunction lookup, OrionLdRestServiceVector* serviceVV, Request* requestV, int requests, int loops)
+{
+  int found = 0;
+
+  for (int loop = 0; loop < loops; loop++)
+  {
+    for (int ix = 0; ix < requests; ix++)
+    {
+      if (lookup(&serviceVV[requestV[ix].verbIx], requestV[ix].urlPath) != NULL)
+        ++found;
+    }
+
+    kaBufferReset(&kalloc, false);  // Once per "request" in the broker
+  }
+
+  return found;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// main -
+//
+int main(int argC, char* argV[])
+{
+  int    loops        = (argC > 1)? atoi(argV[1]) : 100000;
+  int    bufSize      = 1024 * 1024;
+  char*  kallocBuffer = (char*) malloc(bufSize);
+
+  kaBufferInit(&kalloc, kallocBuffer, bufSize, 64 * 1024, NULL, "benchmark kalloc buffer");
+
+  //
+  // Service vectors and their tries
+  //
+  OrionLdRestServiceVector serviceVV[VERBS];
+  int                      routes = 0;
+
+  for (int vIx = 0; vIx < VERBS; vIx++)
+  {
+    int services = 0;
+
+    while (urlVV[vIx][services] != NULL)
+      ++services;
+
+    serviceVV[vIx].serviceV = (OrionLdRestService*) calloc(services, sizeof(OrionLdRestService));
+    serviceVV[vIx].services = services;
+
+    for (int sIx = 0; sIx < services; sIx++)
+      servicePrepare(&serviceVV[vIx].serviceV[sIx], urlVV[vIx][sIx]);
+
+    orionldServiceTrieBuild(&serviceVV[vIx]);
+    routes += services;
+  }
+
+  //
+  // Requests: every route of every verb, once per set of wildcard values, plus the ones that don't match
+  //
+  int       maxRequests = routes * WILDCARD_VALUES + NO_MATCH_URLS * VERBS;
+  Request*  requestV    = (Request*) calloc(maxRequests, sizeof(Request));
+  int       requests    = 0;
+
+  for (int vIx = 0; vIx < VERBS; vIx++)
+  {
+    for (int sIx = 0; sIx < serviceVV[vIx].services; sIx++)
+    {
+      int values = (serviceVV[vIx].serviceV[sIx].wildcards == 0)? 1 : WILDCARD_VALUES;
+
+      for (int valueIx = 0; valueIx < values; valueIx++)
+      {
+        requestV[requests].verbIx     = vIx;
+        requestV[requests].urlPath    = urlPathFill(urlVV[vIx][sIx], valueIx);
+        requestV[requests].expectedIx = sIx;
+        ++requests;
+      }
+    }
+
+    for (int ix = 0; ix < NO_MATCH_URLS; ix++)
+    {
+      requestV[requests].verbIx     = vIx;
+      requestV[requests].urlPath    = strdup(noMatchUrlV[ix]);
+      requestV[requests].expectedIx = -1;
+      ++requests;
+    }
+  }
+
+  //
+  // Both lookups must find the same service, with the same wildcards
+  //
+  int mismatches = 0;
+
+  for (int ix = 0; ix < requests; ix++)
+  {
+    OrionLdRestServiceVector* serviceV = &serviceVV[requestV[ix].verbIx];
+    char                      linearWildcard[2][512];
+    OrionLdRestService*       linearP;
+    OrionLdRestService*       trieP;
+
+    wildcard[0] = NULL;
+    wildcard[1] = NULL;
+    linearP = linearLookup(serviceV, requestV[ix].urlPath);
+    snprintf(linearWildcard[0], sizeof(linearWildcard[0]), "%s", (wildcard[0] != NULL)? wildcard[0] : "");
+    snprintf(linearWildcard[1], sizeof(linearWildcard[1]), "%s", (wildcard[1] != NULL)? wildcard[1] : "");
+
+    wildcard[0] = NULL;
+    wildcard[1] = NULL;
+    trieP = trieLookup(serviceV, requestV[ix].urlPath);
+
+    int linearIx = (linearP != NULL)? linearP - serviceV->serviceV : -1;
+    int trieIx   = (trieP   != NULL)? trieP   - serviceV->serviceV : -1;
+
+    if ((linearIx != trieIx)                                                       ||
+        (strcmp(linearWildcard[0], (wildcard[0] != NULL)? wildcard[0] : "") != 0) ||
+        (strcmp(linearWildcard[1], (wildcard[1] != NULL)? wildcard[1] : "") != 0))
+    {
+      printf("MISMATCH: %-7s %s\n", verbNameV[requestV[ix].verbIx], requestV[ix].urlPath);
+      printf("  linear: %d ('%s', '%s')\n", linearIx, linearWildcard[0], linearWildcard[1]);
+      printf("  trie:   %d ('%s', '%s')\n", trieIx, (wildcard[0] != NULL)? wildcard[0] : "", (wildcard[1] != NULL)? wildcard[1] : "");
+      ++mismatches;
+    }
+    else if (trieIx != requestV[ix].expectedIx)
+      printf("  %-7s %-72s  -> %s (first match in the vector)\n", verbNameV[requestV[ix].verbIx], requestV[ix].urlPath, (trieIx == -1)? "no service" : serviceV->serviceV[trieIx].url);
+  }
+
+  kaBufferReset(&kalloc, false);
+  printf("%d routes, %d requests, %d mismatches\n\n", routes, requests, mismatches);
+
+  //
+  // Throughput
+  //
+  double start = nowNs();
+  int linearFound = requestsRun(linearLookup, serviceVV, requestV, requests, loops);
+  double linearNs = (nowNs() - start) / loops;
+
+  start = nowNs();
+  int trieFound = requestsRun(trieLookup, serviceVV, requestV, requests, loops);
+  double trieNs = (nowNs() - start) / loops;
+
+  printf("%-12s %14s %14s %14s\n", "lookup", "ns/all routes", "ns/request", "requests/s");
+  printf("%-12s %14.1f %14.1f %14.0f\n", "linear", linearNs, linearNs / requests, 1000000000.0 * requests / linearNs);
+  printf("%-12s %14.1f %14.1f %14.0f\n", "trie",   trieNs,   trieNs / requests,   1000000000.0 * requests / trieNs);
+  printf("\nspeedup: %.1fx\n", linearNs / trieNs);
+
+  if (linearFound != trieFound)
+    printf("WARNING: %d requests found a service with the linear lookup, %d with the trie\n", linearFound / loops, trieFound / loops);
+
+  return (mismatches == 0)? 0 : 1;
+}
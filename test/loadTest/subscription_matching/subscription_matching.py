@@ -0,0 +1,125 @@
+# -*- coding: utf-8 -*-
+"""
+ Copyright 2024 FIWARE Foundation e.V.
+
+ This file is part of Orion-LD Context Broker.
+
+ Orion-LD Context Broker is free software: you can redistribute it and/or
+ modify it under the terms of the GNU Affero General Public License as
+ published by the Free Software Foundation, either version 3 of the
+ License, or (at your option) any later version.
+
+ Orion-LD Context Broker is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+ General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+
+ For those usages not covered by this license please contact with
+ orionld at fiware dot org
+"""
+
+#
+# Subscription matching benchmark
+#
+# Measures the cost of an entity update (and its subscription matching) as the number of
+# subscriptions in the sub-cache grows. Only ONE of the subscriptions matches the updated entity,
+# all the others are for other entity types or other entity ids.
+# With the sub-cache index, the time per update should stay (about) flat as the number of subscriptions grows.
+#
+# With --same-type, all the non-matching subscriptions are on one single entity type, so they all end up in the
+# same bucket of the index. The time per subscription creation should stay (about) flat as well.
+#
+# Usage:
+#   python3 subscription_matching.py [--host localhost] [--port 1026] [--steps 100,1000,10000,50000] [--updates 1000] [--same-type]
+#
+# The broker must be started with a clean database, e.g.:
+#   orionld -fg -db benchmark -experimental
+#
+
+import argparse
+import time
+import requests
+
+NGSILD = '/ngsi-ld/v1'
+HEADERS = {'Content-Type': 'application/json'}
+
+
+def subscription_create(session, base, sub_no, notify_url, same_type):
+    # Every fourth subscription is on an entity id, the rest on an entity type (no match for any of them).
+    # With same_type, they're all on the entity type 'Other'
+    if same_type is True:
+        entities = [{'type': 'Other'}]
+    elif sub_no % 4 == 0:
+        entities = [{'id': 'urn:ngsi-ld:Other:E%d' % sub_no, 'type': 'Other'}]
+    else:
+        entities = [{'type': 'Type%d' % sub_no}]
+
+    payload = {
+        'id': 'urn:ngsi-ld:Subscription:S%d' % sub_no,
+        'type': 'Subscription',
+        'entities': entities,
+        'notification': {'endpoint': {'uri': notify_url}}
+    }
+
+    r = session.post(base + NGSILD + '/subscriptions', json=payload, headers=HEADERS)
+    if r.status_code != 201:
+        raise Exception('Unable to create subscription %d: %d %s' % (sub_no, r.status_code, r.text))
+
+
+def updates_measure(session, base, updates):
+    url = base + NGSILD + '/entities/urn:ngsi-ld:Bench:E1/attrs/P'
+    start = time.time()
+
+    for ix in range(updates):
+        r = session.patch(url, json={'value': ix}, headers=HEADERS)
+        if r.status_code != 204:
+            raise Exception('Unable to update the entity: %d %s' % (r.status_code, r.text))
+
+    return (time.time() - start) * 1000000.0 / updates
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Subscription matching benchmark')
+    parser.add_argument('--host', default='localhost')
+    parser.add_argument('--port', default='1026')
+    parser.add_argument('--steps', default='100,1000,10000,50000', help='comma separated numbers of subscriptions')
+    parser.add_argument('--updates', type=int, default=1000, help='number of entity updates measured per step')
+    parser.add_argument('--notify', default='http://localhost:9997/notify', help='endpoint of the non-matching subscriptions')
+    parser.add_argument('--same-type', action='store_true', help='all non-matching subscriptions on the same entity type')
+    args = parser.parse_args()
+
+    base = 'http://%s:%s' % (args.host, args.port)
+    session = requests.Session()
+
+    # The entity that is updated, and the one subscription that matches it
+    r = session.post(base + NGSILD + '/entities', json={'id': 'urn:ngsi-ld:Bench:E1', 'type': 'Bench', 'P': 0}, headers=HEADERS)
+    if r.status_code != 201:
+        raise Exception('Unable to create the entity: %d %s' % (r.status_code, r.text))
+
+    subscription_create(session, base, 1, args.notify, args.same_type)  # Type1/Other - no match
+    r = session.post(base + NGSILD + '/subscriptions',
+                     json={'id': 'urn:ngsi-ld:Subscription:Bench', 'type': 'Subscription', 'entities': [{'type': 'Bench'}],
+                           'notification': {'endpoint': {'uri': args.notify}}},
+                     headers=HEADERS)
+    if r.status_code != 201:
+        raise Exception('Unable to create the matching subscription: %d %s' % (r.status_code, r.text))
+
+    subs = 2
+    print('%15s %25s %25s' % ('Subscriptions', 'Microseconds per creation', 'Microseconds per update'))
+    for step in [int(s) for s in args.steps.split(',')]:
+        created = 0
+        start   = time.time()
+        while subs < step:
+            subscription_create(session, base, subs, args.notify, args.same_type)
+            subs    += 1
+            created += 1
+
+        creation = (time.time() - start) * 1000000.0 / created if created > 0 else 0.0
+        print('%15d %25.1f %25.1f' % (subs, creation, updates_measure(session, base, args.updates)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,247 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // printf, snprintf
+#include <stdlib.h>                                              // atoi, malloc
+#include <string.h>                                              // strcmp
+#include <time.h>                                                // clock_gettime, time, gmtime_r, strftime
+
+extern "C"
+{
+#include "kalloc/kaBufferInit.h"                                 // kaBufferInit
+#include "kalloc/kaBufferReset.h"                                // kaBufferReset
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBufferCreate.h"                                // kjBufferCreate
+#include "kjson/kjBuilder.h"                                     // kjFloat, kjString, kjObject, kjArray, kjChildAdd
+}
+
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/types/PgAppendBuffer.h"                        // PgAppendBuffer
+#include "orionld/types/PgTableDefinitions.h"                    // PG_ATTRIBUTE_INSERT_START
+#include "orionld/troe/pgAppendInit.h"                           // pgAppendInit
+#include "orionld/troe/pgAppend.h"                               // pgAppend
+#include "orionld/troe/pgAttributeAppend.h"                      // pgAttributeAppend
+#include "orionld/troe/pgCopy.h"                                 // pgCopyCommand, pgCopy
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Benchmark: TRoE attribute rows - INSERT ... VALUES (the SQL text of the TRoE buffers) vs COPY ... FROM STDIN (FORMAT binary) (-troeCopy)
+//
+// Both paths fill their buffers with pgAttributeAppend, exactly like the broker does for a request, and commit each
+// 'request' with one single command - PQexec of the INSERT, or pgCopy of the binary tuples.
+// The attributes are the mix of a typical sensor entity: numbers with observedAt and unitCode, strings, relationships and points.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Stand-ins for what the benchmark doesn't link with
+//
+__thread OrionldConnectionState orionldState;
+bool                            troeCopy = false;
+
+void orionldStateDelayedFreeEnqueue(void* allocatedBuffer)
+{
+  // Only for geometries other than Point - not part of the benchmark
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timeNow -
+//
+static double timeNow(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + ((double) now.tv_nsec) / 1000000000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// attributeAppend - append attribute number 'rowNo' to the buffer
+//
+static void attributeAppend(PgAppendBuffer* bufP, int rowNo)
+{
+  static const char* nameV[] = { "temperature", "humidity", "pressure", "windSpeed", "batteryLevel", "noise", "status", "category", "refBuilding", "location" };
+  char               instanceId[80];
+  char               entityId[64];
+  char               name[128];
+  char*              type       = (char*) "Property";
+  char*              observedAt = NULL;
+  char*              unitCode   = NULL;
+  KjNode*            valueNodeP;
+  int                kind       = rowNo % 10;
+
+  snprintf(instanceId, sizeof(instanceId), "urn:ngsi-ld:attribute:instance:%08d", rowNo);
+  snprintf(entityId,   sizeof(entityId),   "urn:ngsi-ld:Sensor:%06d", rowNo / 10);
+  snprintf(name,       sizeof(name),       "https://smartdatamodels.org/dataModel.Environment/%s", nameV[kind]);
+
+  if (kind < 6)
+  {
+    valueNodeP = kjFloat(orionldState.kjsonP, "value", 20.0 + (rowNo % 1000) / 7.0);
+    observedAt = (char*) "2024-06-01T12:00:00.123Z";
+    unitCode   = (char*) "CEL";
+  }
+  else if (kind < 8)
+    valueNodeP = kjString(orionldState.kjsonP, "value", "operational");
+  else if (kind == 8)
+  {
+    type       = (char*) "Relationship";
+    valueNodeP = kjString(orionldState.kjsonP, "object", "urn:ngsi-ld:Building:001");
+  }
+  else
+  {
+    KjNode* coordinatesP = kjArray(orionldState.kjsonP, "coordinates");
+
+    type       = (char*) "GeoProperty";
+    valueNodeP = kjObject(orionldState.kjsonP, "value");
+
+    kjChildAdd(coordinatesP, kjFloat(orionldState.kjsonP, NULL, -3.7 + (rowNo % 100) / 1000.0));
+    kjChildAdd(coordinatesP, kjFloat(orionldState.kjsonP, NULL, 40.4 + (rowNo % 100) / 1000.0));
+    kjChildAdd(valueNodeP, kjString(orionldState.kjsonP, "type", "Point"));
+    kjChildAdd(valueNodeP, coordinatesP);
+  }
+
+  pgAttributeAppend(bufP, instanceId, kaStrdup(&orionldState.kalloc, name), "Create", entityId, type, observedAt, false, unitCode, NULL, valueNodeP);
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// run - insert 'rows' attribute rows, 'rowsPerRequest' at a time - returns false if any command fails
+//
+static bool run(PGconn* connectionP, bool binary, int rows, int rowsPerRequest, double* buildTimeP, double* dbTimeP)
+{
+  PGresult* res = PQexec(connectionP, "TRUNCATE attributes");
+  PQclear(res);
+
+  troeCopy    = binary;
+  *buildTimeP = 0;
+  *dbTimeP    = 0;
+
+  for (int done = 0; done < rows; done += rowsPerRequest)
+  {
+    kaBufferReset(&orionldState.kalloc, false);
+    orionldState.kjsonP = kjBufferCreate(&orionldState.kjson, &orionldState.kalloc);
+
+    double          start = timeNow();
+    PgAppendBuffer  attributes;
+
+    pgAppendInit(&attributes, 8*1024);
+    pgAppend(&attributes, PG_ATTRIBUTE_INSERT_START, 0);
+
+    for (int rowNo = done; (rowNo < done + rowsPerRequest) && (rowNo < rows); rowNo++)
+    {
+      attributeAppend(&attributes, rowNo);
+    }
+
+    double built = timeNow();
+    bool   ok;
+
+    if (binary == true)
+    {
+      char  command[1024];
+      char* chunk    = &attributes.buf[attributes.copyStart];
+      int   chunkLen = attributes.currentIx - attributes.copyStart;
+
+      ok = pgCopyCommand(&attributes, command, sizeof(command)) && pgCopy(connectionP, command, &chunk, &chunkLen, 1);
+    }
+    else
+    {
+      res = PQexec(connectionP, attributes.buf);
+      ok  = ((res != NULL) && (PQresultStatus(res) == PGRES_COMMAND_OK));
+      PQclear(res);
+    }
+
+    if (ok == false)
+    {
+      printf("%s failed: %s\n", (binary == true)? "COPY" : "INSERT", PQerrorMessage(connectionP));
+      return false;
+    }
+
+    *buildTimeP += built - start;
+    *dbTimeP    += timeNow() - built;
+  }
+
+  return true;
+}
+
+
+
+int main(int argC, char* argV[])
+{
+  int          rows           = (argC > 1)? atoi(argV[1]) : 200000;
+  int          rowsPerRequest = (argC > 2)? atoi(argV[2]) : 100;
+  const char*  conninfo       = (argC > 3)? argV[3]       : "dbname=orionld_troecopy";
+  int          bufSize        = 64 * 1024 * 1024;
+  char*        kallocBuffer   = (char*) malloc(bufSize);
+
+  PGconn* connectionP = PQconnectdb(conninfo);
+  if (PQstatus(connectionP) != CONNECTION_OK)
+  {
+    printf("unable to connect to postgres (%s): %s\n", conninfo, PQerrorMessage(connectionP));
+    return 1;
+  }
+
+  kaBufferInit(&orionldState.kalloc, kallocBuffer, bufSize, 1024 * 1024, NULL, "benchmark kalloc buffer");
+
+  time_t    now = time(NULL);
+  struct tm tm;
+
+  gmtime_r(&now, &tm);
+  strftime(orionldState.requestTimeString, sizeof(orionldState.requestTimeString), "%Y-%m-%dT%H:%M:%S.000Z", &tm);
+  orionldState.requestTime = now;
+
+  double insertBuild;
+  double insertDb;
+  double copyBuild;
+  double copyDb;
+
+  if ((run(connectionP, false, rows, rowsPerRequest, &insertBuild, &insertDb) == false) ||
+      (run(connectionP, true,  rows, rowsPerRequest, &copyBuild,   &copyDb)   == false))
+  {
+    PQfinish(connectionP);
+    return 1;
+  }
+
+  printf("%d attribute rows, %d per request\n", rows, rowsPerRequest);
+  printf("INSERT: %10.0f rows/s  (building the buffers: %6.3f s, postgres: %6.3f s)\n", rows / (insertBuild + insertDb), insertBuild, insertDb);
+  printf("COPY:   %10.0f rows/s  (building the buffers: %6.3f s, postgres: %6.3f s)\n", rows / (copyBuild + copyDb),     copyBuild,   copyDb);
+  printf("COPY is %.2f times as fast as INSERT\n", (insertBuild + insertDb) / (copyBuild + copyDb));
+
+  PQfinish(connectionP);
+
+  return 0;
+}
@@ -0,0 +1,307 @@
+/*
+*
+* Copyright 2024 FIWARE Foundation e.V.
+*
+* This file is part of Orion-LD Context Broker.
+*
+* Orion-LD Context Broker is free software: you can redistribute it and/or
+* modify it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* Orion-LD Context Broker is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with Orion-LD Context Broker. If not, see http://www.gnu.org/licenses/.
+*
+* For those usages not covered by this license please contact with
+* orionld at fiware dot org
+*
+* Author: Ken Zangelin
+*/
+#include <stdio.h>                                               // printf, snprintf
+#include <stdlib.h>                                              // atoi, malloc
+#include <string.h>                                              // strcmp
+#include <time.h>                                                // clock_gettime, time, gmtime_r, strftime
+
+extern "C"
+{
+#include "kalloc/kaBufferInit.h"                                 // kaBufferInit
+#include "kalloc/kaBufferReset.h"                                // kaBufferReset
+#include "kalloc/kaStrdup.h"                                     // kaStrdup
+#include "kjson/KjNode.h"                                        // KjNode
+#include "kjson/kjBufferCreate.h"                                // kjBufferCreate
+#include "kjson/kjBuilder.h"                                     // kjFloat, kjString, kjObject, kjArray, kjChildAdd
+}
+
+#include "orionld/common/orionldState.h"                         // orionldState
+#include "orionld/common/pqHeader.h"                             // Postgres header
+#include "orionld/types/PgAppendBuffer.h"                        // PgAppendBuffer
+#include "orionld/types/PgConnection.h"                          // PgConnection
+#include "orionld/types/PgTableDefinitions.h"                    // PG_ENTITY_INSERT_START, PG_ATTRIBUTE_INSERT_START
+#include "orionld/troe/pgAppendInit.h"                           // pgAppendInit
+#include "orionld/troe/pgAppend.h"                               // pgAppend
+#include "orionld/troe/pgEntityAppend.h"                         // pgEntityAppend
+#include "orionld/troe/pgAttributeAppend.h"                      // pgAttributeAppend
+#include "orionld/troe/pgStatementsPrepare.h"                    // pgStatementsPrepare
+#include "orionld/troe/pgPipelineBuffer.h"                       // pgPipelineBuffer
+#include "orionld/troe/pgPipeline.h"                             // pgPipeline, PG_PIPELINE_FLUSH
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Benchmark: TRoE of batch upserts - the SQL text of the TRoE buffers, one PQexec per table inside BEGIN/COMMIT,
+// vs the prepared INSERTs of the binary tuples in pipeline mode (pgPipeline), the way batch requests are written now.
+//
+// Both paths fill their buffers with the very same functions as the broker (pgEntityAppend, pgAttributeAppend).
+// Every 'request' upserts a batch of entities (1000 by default), each with the attributes of a typical sensor:
+// numbers with observedAt and unitCode, a string, a relationship and a point.
+//
+
+
+
+// -----------------------------------------------------------------------------
+//
+// Stand-ins for what the benchmark doesn't link with
+//
+__thread OrionldConnectionState orionldState;
+bool                            troeCopy = false;
+
+void orionldStateDelayedFreeEnqueue(void* allocatedBuffer)
+{
+  // Only for geometries other than Point - not part of the benchmark
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// ATTRIBUTES - attributes per entity
+//
+#define ATTRIBUTES 6
+
+
+
+// -----------------------------------------------------------------------------
+//
+// timeNow -
+//
+static double timeNow(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + ((double) now.tv_nsec) / 1000000000;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// entityAppend - append entity number 'entityNo', with its attributes, to the buffers
+//
+static void entityAppend(PgAppendBuffer* entitiesP, PgAppendBuffer* attributesP, int entityNo)
+{
+  static const char* nameV[ATTRIBUTES] = { "temperature", "humidity", "batteryLevel", "status", "refBuilding", "location" };
+  char               instanceId[80];
+  char               entityId[64];
+
+  snprintf(instanceId, sizeof(instanceId), "urn:ngsi-ld:entity:instance:%08d", entityNo);
+  snprintf(entityId,   sizeof(entityId),   "urn:ngsi-ld:Sensor:%06d", entityNo);
+
+  pgEntityAppend(entitiesP, "Replace", entityId, "https://smartdatamodels.org/dataModel.Environment/Sensor", instanceId);
+
+  for (int kind = 0; kind < ATTRIBUTES; kind++)
+  {
+    char     name[128];
+    char*    type       = (char*) "Property";
+    char*    observedAt = NULL;
+    char*    unitCode   = NULL;
+    KjNode*  valueNodeP;
+
+    snprintf(instanceId, sizeof(instanceId), "urn:ngsi-ld:attribute:instance:%08d:%d", entityNo, kind);
+    snprintf(name,       sizeof(name),       "https://smartdatamodels.org/dataModel.Environment/%s", nameV[kind]);
+
+    if (kind < 3)
+    {
+      valueNodeP = kjFloat(orionldState.kjsonP, "value", 20.0 + (entityNo % 1000) / 7.0);
+      observedAt = (char*) "2024-06-01T12:00:00.123Z";
+      unitCode   = (char*) "CEL";
+    }
+    else if (kind == 3)
+      valueNodeP = kjString(orionldState.kjsonP, "value", "operational");
+    else if (kind == 4)
+    {
+      type       = (char*) "Relationship";
+      valueNodeP = kjString(orionldState.kjsonP, "object", "urn:ngsi-ld:Building:001");
+    }
+    else
+    {
+      KjNode* coordinatesP = kjArray(orionldState.kjsonP, "coordinates");
+
+      type       = (char*) "GeoProperty";
+      valueNodeP = kjObject(orionldState.kjsonP, "value");
+
+      kjChildAdd(coordinatesP, kjFloat(orionldState.kjsonP, NULL, -3.7 + (entityNo % 100) / 1000.0));
+      kjChildAdd(coordinatesP, kjFloat(orionldState.kjsonP, NULL, 40.4 + (entityNo % 100) / 1000.0));
+      kjChildAdd(valueNodeP, kjString(orionldState.kjsonP, "type", "Point"));
+      kjChildAdd(valueNodeP, coordinatesP);
+    }
+
+    pgAttributeAppend(attributesP, instanceId, kaStrdup(&orionldState.kalloc, name), "Replace", entityId, type, observedAt, false, unitCode, NULL, valueNodeP);
+  }
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// commandExec -
+//
+static bool commandExec(PGconn* connectionP, const char* command)
+{
+  PGresult* res = PQexec(connectionP, command);
+  bool      ok  = ((res != NULL) && (PQresultStatus(res) == PGRES_COMMAND_OK));
+
+  PQclear(res);
+  return ok;
+}
+
+
+
+// -----------------------------------------------------------------------------
+//
+// run - upsert 'batches' batches of 'entitiesPerBatch' entities - returns false if any command fails
+//
+static bool run(PGconn* connectionP, bool pipeline, int batches, int entitiesPerBatch, double* buildTimeP, double* dbTimeP, int* roundTripsP)
+{
+  commandExec(connectionP, "TRUNCATE entities");
+  commandExec(connectionP, "TRUNCATE attributes");
+
+  *buildTimeP  = 0;
+  *dbTimeP     = 0;
+  *roundTripsP = 0;
+
+  for (int batch = 0; batch < batches; batch++)
+  {
+    kaBufferReset(&orionldState.kalloc, false);
+    orionldState.kjsonP = kjBufferCreate(&orionldState.kjson, &orionldState.kalloc);
+
+    double          start = timeNow();
+    PgAppendBuffer  entities;
+    PgAppendBuffer  attributes;
+
+    pgAppendInit(&entities, 4*1024);
+    pgAppendInit(&attributes, 8*1024);
+
+    if (pipeline == true)
+    {
+      pgPipelineBuffer(&entities);
+      pgPipelineBuffer(&attributes);
+    }
+
+    pgAppend(&entities,   PG_ENTITY_INSERT_START,    0);
+    pgAppend(&attributes, PG_ATTRIBUTE_INSERT_START, 0);
+
+    for (int entityNo = batch * entitiesPerBatch; entityNo < (batch + 1) * entitiesPerBatch; entityNo++)
+    {
+      entityAppend(&entities, &attributes, entityNo);
+    }
+
+    double built = timeNow();
+    bool   ok;
+
+    if (pipeline == true)
+    {
+      PgAppendBuffer* bufferV[2] = { &entities, &attributes };
+      int             queries    = entities.values + attributes.values;
+
+      ok            = pgPipeline(connectionP, bufferV, 2);
+      *roundTripsP += 1 + queries / PG_PIPELINE_FLUSH;
+    }
+    else
+    {
+      ok = commandExec(connectionP, "BEGIN")               &&
+           commandExec(connectionP, entities.buf)          &&
+           commandExec(connectionP, attributes.buf)        &&
+           commandExec(connectionP, "COMMIT");
+      *roundTripsP += 4;
+    }
+
+    if (ok == false)
+    {
+      printf("%s failed: %s\n", (pipeline == true)? "pipeline" : "INSERT", PQerrorMessage(connectionP));
+      return false;
+    }
+
+    *buildTimeP += built - start;
+    *dbTimeP    += timeNow() - built;
+  }
+
+  return true;
+}
+
+
+
+int main(int argC, char* argV[])
+{
+  int          batches          = (argC > 1)? atoi(argV[1]) : 100;
+  int          entitiesPerBatch = (argC > 2)? atoi(argV[2]) : 1000;
+  const char*  conninfo         = (argC > 3)? argV[3]       : "dbname=orionld_troepipeline";
+  int          bufSize          = 64 * 1024 * 1024;
+  char*        kallocBuffer     = (char*) malloc(bufSize);
+  PgConnection connection;
+
+  memset(&connection, 0, sizeof(connection));
+  connection.connectionP = PQconnectdb(conninfo);
+  if (PQstatus(connection.connectionP) != CONNECTION_OK)
+  {
+    printf("unable to connect to postgres (%s): %s\n", conninfo, PQerrorMessage(connection.connectionP));
+    return 1;
+  }
+
+  if (pgStatementsPrepare(&connection) == false)
+  {
+    printf("unable to prepare the TRoE INSERT statements: %s\n", PQerrorMessage(connection.connectionP));
+    PQfinish(connection.connectionP);
+    return 1;
+  }
+
+  kaBufferInit(&orionldState.kalloc, kallocBuffer, bufSize, 1024 * 1024, NULL, "benchmark kalloc buffer");
+
+  time_t    now = time(NULL);
+  struct tm tm;
+
+  gmtime_r(&now, &tm);
+  strftime(orionldState.requestTimeString, sizeof(orionldState.requestTimeString), "%Y-%m-%dT%H:%M:%S.000Z", &tm);
+  orionldState.requestTime = now;
+
+  double insertBuild;
+  double insertDb;
+  int    insertRoundTrips;
+  double pipelineBuild;
+  double pipelineDb;
+  int    pipelineRoundTrips;
+
+  if ((run(connection.connectionP, false, batches, entitiesPerBatch, &insertBuild,   &insertDb,   &insertRoundTrips)   == false) ||
+      (run(connection.connectionP, true,  batches, entitiesPerBatch, &pipelineBuild, &pipelineDb, &pipelineRoundTrips) == false))
+  {
+    PQfinish(connection.connectionP);
+    return 1;
+  }
+
+  printf("%d batch upserts of %d entities (%d attributes each)\n", batches, entitiesPerBatch, ATTRIBUTES);
+  printf("INSERT:   %8.1f batches/s  %6.2f ms/batch  (building the buffers: %6.3f s, postgres: %6.3f s, round trips: %d)\n",
+         batches / (insertBuild + insertDb), 1000 * (insertBuild + insertDb) / batches, insertBuild, insertDb, insertRoundTrips);
+  printf("Pipeline: %8.1f batches/s  %6.2f ms/batch  (building the buffers: %6.3f s, postgres: %6.3f s, round trips: %d)\n",
+         batches / (pipelineBuild + pipelineDb), 1000 * (pipelineBuild + pipelineDb) / batches, pipelineBuild, pipelineDb, pipelineRoundTrips);
+  printf("Pipeline is %.2f times as fast as INSERT\n", (insertBuild + insertDb) / (pipelineBuild + pipelineDb));
+
+  PQfinish(connection.connectionP);
+
+  return 0;
+}